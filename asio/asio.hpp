@@ -5,9 +5,11 @@
 #include "src/errinfo.h"
 
 #include "src/details/service.hpp"
+#include "src/details/loop_monitor.h"
 #include "src/details/reactor_service.h"
 #include "src/details/timer_service.h"
 #include "src/details/bridge_service.hpp"
+#include "src/details/frame_service.h"
 
 #include "src/buffer.h"
 #include "src/dynamic_buffer.h"
@@ -15,9 +17,13 @@
 #include "src/steady_timer.h"
 #include "src/signal_set.h"
 #include "src/thread_pool.h"
+#include "src/strand.h"
+#include "src/watchdog.h"
 
 #include "src/ip/endpoint.h"
 #include "src/ip/tcp.h"
 #include "src/ip/udp.h"
 
+#include "src/coroutine.hpp"
+
 #endif	// __LCY_ASIO_HPP__
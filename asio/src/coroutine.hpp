@@ -0,0 +1,642 @@
+#ifndef __LCY_ASIO_COROUTINE_HPP__
+#define __LCY_ASIO_COROUTINE_HPP__
+
+/*
+* Optional C++20 layer : awaitable operations on top of the callback API.
+*
+* Only active when the translation unit is compiled with coroutine support,
+* C++11 users include this header for free and keep using the callbacks.
+*
+* example :
+*
+* lcy::asio::co::Task<void> echo(lcy::asio::ip::TCP::Socket& socket)
+* {
+*	char buf[4096];
+*	while ( true ) {
+*		auto r = co_await lcy::asio::co::read(socket, lcy::asio::buffer(buf, sizeof(buf)));
+*		if ( r.ec || r.nbytes == 0 ) {
+*			co_return;
+*		}
+*		co_await lcy::asio::co::write(socket, lcy::asio::buffer(buf, r.nbytes));
+*	}
+* }
+*
+* lcy::asio::co::spawn(ioc, echo(socket));
+*/
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+
+#define LCY_ASIO_HAS_COROUTINE 1
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <utility>
+
+#include "lcy/asio/src/errinfo.h"
+#include "lcy/asio/src/buffer.h"
+#include "lcy/asio/src/io_context.hpp"
+#include "lcy/asio/src/steady_timer.h"
+#include "lcy/asio/src/signal_set.h"
+#include "lcy/asio/src/details/frame_service.h"
+#include "lcy/asio/src/ip/endpoint.h"
+#include "lcy/asio/src/ip/tcp.h"
+#include "lcy/asio/src/ip/udp.h"
+
+namespace lcy {
+namespace asio {
+namespace co {
+
+template <typename T = void>
+class Task;
+
+namespace details {
+
+/*
+* notify :
+*	The frame allocator is picked from the coroutine parameters : the first
+*	IOContext&, or the first object with an `IOContext& context()` member
+*	( sockets, timers, signal sets ). A coroutine without either still works,
+*	its frame just comes from the global allocator.
+*/
+template <typename T, typename = void>
+struct has_context :
+	std::false_type
+{
+};
+
+template <typename T>
+struct has_context<T, std::void_t<decltype(std::declval<T&>().context())>> :
+	std::is_same<decltype(std::declval<T&>().context()), IOContext&>
+{
+};
+
+inline IOContext* find_context()
+{
+	return nullptr;
+}
+
+template <typename First, typename... Rest>
+inline IOContext* find_context(First& first, Rest&... rest)
+{
+	typedef typename std::remove_cv<First>::type first_type;
+
+	if constexpr ( std::is_same<first_type, IOContext>::value ) {
+		return &first;
+	} else if constexpr ( std::is_pointer<first_type>::value ) {
+		return find_context(rest...);
+	} else if constexpr ( has_context<first_type>::value ) {
+		return &first.context();
+	} else {
+		return find_context(rest...);
+	}
+}
+
+class PromiseBase {
+public:
+	/*
+	* notify :
+	*	Forced inline so that, even at -O0, the frame comes from FrameService::allocate()
+	*	as seen by GCC : a call to this template paired with the sized operator delete
+	*	below is otherwise reported as -Wmismatched-new-delete in every coroutine.
+	*/
+	template <typename... Args>
+	__attribute__((always_inline))
+	static void* operator new(size_t size, Args&... args)
+	{
+		IOContext* ioc = find_context(args...);
+		asio::details::FrameService* service = ioc ?
+			&use_service<asio::details::FrameService>(*ioc) : nullptr;
+
+		return asio::details::FrameService::allocate(service, size);
+	}
+
+	static void operator delete(void* ptr, size_t)
+	{
+		asio::details::FrameService::deallocate(ptr);
+	}
+
+	// Resumes whoever awaited us without growing the stack ( symmetric transfer )
+	class FinalAwaiter {
+	public:
+		bool await_ready() const noexcept { return false; }
+
+		template <typename Promise>
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+		{
+			std::coroutine_handle<> continuation = h.promise().continuation_;
+			return continuation ? continuation : std::noop_coroutine();
+		}
+
+		void await_resume() const noexcept {}
+	};
+
+	std::suspend_always initial_suspend() const noexcept { return {}; }
+	FinalAwaiter final_suspend() const noexcept { return {}; }
+
+	void unhandled_exception() { exception_ = std::current_exception(); }
+
+	void setContinuation(std::coroutine_handle<> continuation)
+	{
+		continuation_ = continuation;
+	}
+
+	void rethrowIfFailed()
+	{
+		if ( exception_ ) {
+			std::rethrow_exception(exception_);
+		}
+	}
+
+private:
+	std::coroutine_handle<> continuation_;
+	std::exception_ptr exception_;
+};
+
+template <typename T>
+class Promise :
+	public PromiseBase
+{
+public:
+	Task<T> get_return_object();
+
+	template <typename U>
+	void return_value(U&& value)
+	{
+		value_ = std::forward<U>(value);
+	}
+
+	T result()
+	{
+		rethrowIfFailed();
+		return std::move(value_);
+	}
+
+private:
+	T value_;
+};
+
+template <>
+class Promise<void> :
+	public PromiseBase
+{
+public:
+	Task<void> get_return_object();
+
+	void return_void() {}
+
+	void result()
+	{
+		rethrowIfFailed();
+	}
+};
+
+}	// namespace details
+
+/*
+* Lazily started coroutine, runs when awaited or spawned.
+*/
+template <typename T>
+class Task {
+public:
+	typedef details::Promise<T> promise_type;
+	typedef std::coroutine_handle<promise_type> handle_type;
+
+	Task() :
+		handle_(nullptr)
+	{
+	}
+
+	explicit Task(handle_type handle) :
+		handle_(handle)
+	{
+	}
+
+	Task(Task&& other) noexcept :
+		handle_(other.handle_)
+	{
+		other.handle_ = nullptr;
+	}
+
+	Task& operator=(Task&& other) noexcept
+	{
+		if ( this != &other ) {
+			if ( handle_ ) {
+				handle_.destroy();
+			}
+			handle_ = other.handle_;
+			other.handle_ = nullptr;
+		}
+		return *this;
+	}
+
+	~Task()
+	{
+		if ( handle_ ) {
+			handle_.destroy();
+		}
+	}
+
+	class Awaiter {
+	public:
+		explicit Awaiter(handle_type handle) :
+			handle_(handle)
+		{
+		}
+
+		bool await_ready() const noexcept
+		{
+			return !handle_ || handle_.done();
+		}
+
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+		{
+			handle_.promise().setContinuation(awaiting);
+			return handle_;
+		}
+
+		T await_resume()
+		{
+			return handle_.promise().result();
+		}
+
+	private:
+		handle_type handle_;
+	};
+
+	Awaiter operator co_await() const noexcept
+	{
+		return Awaiter(handle_);
+	}
+
+private:
+	Task(const Task&);
+	Task& operator=(const Task&);
+
+private:
+	handle_type handle_;
+};
+
+namespace details {
+
+template <typename T>
+inline Task<T> Promise<T>::get_return_object()
+{
+	return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+}
+
+inline Task<void> Promise<void>::get_return_object()
+{
+	return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+}
+
+/*
+* Fire and forget driver used by spawn(), destroys itself when the task is done.
+*/
+class Detached {
+public:
+	class promise_type :
+		public PromiseBase
+	{
+	public:
+		Detached get_return_object()
+		{
+			return Detached(std::coroutine_handle<promise_type>::from_promise(*this));
+		}
+
+		std::suspend_never final_suspend() const noexcept { return {}; }
+
+		void return_void() {}
+
+		// Same contract as std::thread, an escaping exception is fatal
+		void unhandled_exception() { std::terminate(); }
+	};
+
+	explicit Detached(std::coroutine_handle<promise_type> handle) :
+		handle_(handle)
+	{
+	}
+
+	std::coroutine_handle<promise_type> handle() const
+	{
+		return handle_;
+	}
+
+private:
+	std::coroutine_handle<promise_type> handle_;
+};
+
+// The IOContext parameter only selects the frame allocator
+inline Detached detach(IOContext&, Task<void> task)
+{
+	co_await task;
+}
+
+/*
+* Common part of the operation awaiters : the completion callback stores the
+* result and resumes the coroutine. It only captures two pointers, so it fits in
+* std::function's local storage.
+*/
+template <typename Result>
+class OperationAwaiter {
+public:
+	bool await_ready() const noexcept { return false; }
+	Result await_resume() const noexcept { return result_; }
+
+protected:
+	Result result_;
+};
+
+}	// namespace details
+
+/*
+* Runs `task` on `ioc`, inline when called from the loop thread of `ioc`.
+*/
+inline void spawn(IOContext& ioc, Task<void> task)
+{
+	std::coroutine_handle<> handle = details::detach(ioc, std::move(task)).handle();
+	asio::post(ioc, [handle](){ handle.resume(); });
+}
+
+/////////////////////////////////////////////////////////////
+
+struct IOResult {
+	errcode_type ec;
+	size_t nbytes;
+};
+
+struct WaitResult {
+	errcode_type ec;
+	SteadyTimer::timeout_type elapsed;
+};
+
+struct SignalResult {
+	errcode_type ec;
+	SignalSet::signal_type signum;
+};
+
+class ReadAwaiter :
+	public details::OperationAwaiter<IOResult>
+{
+public:
+	ReadAwaiter(ip::TCP::Socket& socket, MutableBuffer mbuf) :
+		socket_(socket),
+		mbuf_(mbuf)
+	{
+	}
+
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		socket_.async_read(mbuf_, [this, h](errcode_type ec, size_t nbytes){
+			result_ = { ec, nbytes };
+			h.resume();
+		});
+	}
+
+private:
+	ip::TCP::Socket& socket_;
+	MutableBuffer mbuf_;
+};
+
+class WriteAwaiter :
+	public details::OperationAwaiter<IOResult>
+{
+public:
+	WriteAwaiter(ip::TCP::Socket& socket, ConstBuffer cbuf) :
+		socket_(socket),
+		cbuf_(cbuf)
+	{
+	}
+
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		socket_.async_write(cbuf_, [this, h](errcode_type ec, size_t nbytes){
+			result_ = { ec, nbytes };
+			h.resume();
+		});
+	}
+
+private:
+	ip::TCP::Socket& socket_;
+	ConstBuffer cbuf_;
+};
+
+class ConnectAwaiter :
+	public details::OperationAwaiter<errcode_type>
+{
+public:
+	ConnectAwaiter(ip::TCP::Socket& socket, const ip::Endpoint& endpoint) :
+		socket_(socket),
+		endpoint_(endpoint)
+	{
+	}
+
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		socket_.async_connect(endpoint_, [this, h](errcode_type ec){
+			result_ = ec;
+			h.resume();
+		});
+	}
+
+private:
+	ip::TCP::Socket& socket_;
+	const ip::Endpoint& endpoint_;
+};
+
+template <typename Listener>
+class AcceptAwaiter :
+	public details::OperationAwaiter<errcode_type>
+{
+public:
+	AcceptAwaiter(Listener& listener, ip::TCP::Socket& peer) :
+		listener_(listener),
+		peer_(peer)
+	{
+	}
+
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		listener_.async_accept(peer_, [this, h](errcode_type ec){
+			result_ = ec;
+			h.resume();
+		});
+	}
+
+private:
+	Listener& listener_;
+	ip::TCP::Socket& peer_;
+};
+
+class ReceiveFromAwaiter :
+	public details::OperationAwaiter<IOResult>
+{
+public:
+	ReceiveFromAwaiter(ip::UDP::Socket& socket, ip::Endpoint& endpoint, MutableBuffer mbuf) :
+		socket_(socket),
+		endpoint_(endpoint),
+		mbuf_(mbuf)
+	{
+	}
+
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		socket_.async_read(endpoint_, mbuf_, [this, h](errcode_type ec, size_t nbytes){
+			result_ = { ec, nbytes };
+			h.resume();
+		});
+	}
+
+private:
+	ip::UDP::Socket& socket_;
+	ip::Endpoint& endpoint_;
+	MutableBuffer mbuf_;
+};
+
+class SendToAwaiter :
+	public details::OperationAwaiter<IOResult>
+{
+public:
+	SendToAwaiter(ip::UDP::Socket& socket, const ip::Endpoint& endpoint, ConstBuffer cbuf) :
+		socket_(socket),
+		endpoint_(endpoint),
+		cbuf_(cbuf)
+	{
+	}
+
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		socket_.async_write(endpoint_, cbuf_, [this, h](errcode_type ec, size_t nbytes){
+			result_ = { ec, nbytes };
+			h.resume();
+		});
+	}
+
+private:
+	ip::UDP::Socket& socket_;
+	const ip::Endpoint& endpoint_;
+	ConstBuffer cbuf_;
+};
+
+class TimerAwaiter :
+	public details::OperationAwaiter<WaitResult>
+{
+public:
+	explicit TimerAwaiter(SteadyTimer& timer) :
+		timer_(timer)
+	{
+	}
+
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		timer_.async_wait([this, h](errcode_type ec, SteadyTimer::timeout_type elapsed){
+			result_ = { ec, elapsed };
+			h.resume();
+		});
+	}
+
+private:
+	SteadyTimer& timer_;
+};
+
+class SignalAwaiter :
+	public details::OperationAwaiter<SignalResult>
+{
+public:
+	explicit SignalAwaiter(SignalSet& signal_set) :
+		signal_set_(signal_set)
+	{
+	}
+
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		signal_set_.async_wait([this, h](errcode_type ec, SignalSet::signal_type signum){
+			result_ = { ec, signum };
+			h.resume();
+		});
+	}
+
+private:
+	SignalSet& signal_set_;
+};
+
+// Continues the coroutine on the loop thread of another IOContext
+class PostAwaiter {
+public:
+	explicit PostAwaiter(IOContext& ioc) :
+		ioc_(ioc)
+	{
+	}
+
+	bool await_ready() const noexcept { return false; }
+
+	void await_suspend(std::coroutine_handle<> h)
+	{
+		asio::post(ioc_, [h](){ h.resume(); });
+	}
+
+	void await_resume() const noexcept {}
+
+private:
+	IOContext& ioc_;
+};
+
+/////////////////////////////////////////////////////////////
+
+inline ReadAwaiter read(ip::TCP::Socket& socket, MutableBuffer mbuf)
+{
+	return ReadAwaiter(socket, mbuf);
+}
+
+inline WriteAwaiter write(ip::TCP::Socket& socket, ConstBuffer cbuf)
+{
+	return WriteAwaiter(socket, cbuf);
+}
+
+inline ConnectAwaiter connect(ip::TCP::Socket& socket, const ip::Endpoint& endpoint)
+{
+	return ConnectAwaiter(socket, endpoint);
+}
+
+inline AcceptAwaiter<ip::TCP::Socket> accept(ip::TCP::Socket& listener, ip::TCP::Socket& peer)
+{
+	return AcceptAwaiter<ip::TCP::Socket>(listener, peer);
+}
+
+inline AcceptAwaiter<ip::TCP::Acceptor> accept(ip::TCP::Acceptor& acceptor, ip::TCP::Socket& peer)
+{
+	return AcceptAwaiter<ip::TCP::Acceptor>(acceptor, peer);
+}
+
+inline ReceiveFromAwaiter receive_from(ip::UDP::Socket& socket, ip::Endpoint& endpoint, MutableBuffer mbuf)
+{
+	return ReceiveFromAwaiter(socket, endpoint, mbuf);
+}
+
+inline SendToAwaiter send_to(ip::UDP::Socket& socket, const ip::Endpoint& endpoint, ConstBuffer cbuf)
+{
+	return SendToAwaiter(socket, endpoint, cbuf);
+}
+
+inline TimerAwaiter wait(SteadyTimer& timer)
+{
+	return TimerAwaiter(timer);
+}
+
+inline SignalAwaiter wait(SignalSet& signal_set)
+{
+	return SignalAwaiter(signal_set);
+}
+
+inline PostAwaiter post(IOContext& ioc)
+{
+	return PostAwaiter(ioc);
+}
+
+}	// namespace co
+}	// namespace asio
+}	// namespace lcy
+
+#endif	// __cpp_impl_coroutine
+
+#endif	// __LCY_ASIO_COROUTINE_HPP__
@@ -0,0 +1,121 @@
+#include "lcy/asio/src/details/frame_service.h"
+
+#include <new>
+#include <cstddef>
+
+namespace lcy {
+namespace asio {
+namespace details {
+
+LCY_ASIO_DETAILS_SERVICEID_REGISTER(FrameService)
+
+/*
+* Every frame is preceded by a header naming the service and size class it came
+* from, a null owner marks a frame that bypassed the cache.
+*/
+struct FrameHeader {
+	FrameService* owner;
+	size_t cls;
+};
+
+static_assert(sizeof(FrameHeader) % alignof(std::max_align_t) == 0,
+			  "frame header must keep the frame aligned");
+
+///////////////////////////////////////////////////////////////
+
+FrameService::FrameService(thread_id_type owner) :
+	owner_(owner),
+	reused_(0)
+{
+	for ( size_t i = 0; i < FRAME_CLASSES; ++i ) {
+		free_lists_[i] = nullptr;
+		free_counts_[i] = 0;
+	}
+}
+
+FrameService::~FrameService()
+{
+	for ( size_t i = 0; i < FRAME_CLASSES; ++i ) {
+		while ( free_lists_[i] ) {
+			FreeBlock* block = free_lists_[i];
+			free_lists_[i] = block->next;
+			::operator delete(block);
+		}
+	}
+}
+
+void* FrameService::allocate(FrameService* service, size_t size)
+{
+	size_t total = size + sizeof(FrameHeader);
+	size_t cls = (total + FRAME_ALIGN - 1) / FRAME_ALIGN - 1;
+
+	FrameHeader* header = nullptr;
+	if ( service && cls < FRAME_CLASSES && std::this_thread::get_id() == service->owner_ ) {
+		if ( service->free_lists_[cls] ) {
+			FreeBlock* block = service->free_lists_[cls];
+			service->free_lists_[cls] = block->next;
+			--service->free_counts_[cls];
+			++service->reused_;
+
+			header = reinterpret_cast<FrameHeader*>(block);
+		} else {
+			header = static_cast<FrameHeader*>(::operator new((cls + 1) * FRAME_ALIGN));
+		}
+
+		header->owner = service;
+		header->cls = cls;
+	} else {
+		header = static_cast<FrameHeader*>(::operator new(total));
+		header->owner = nullptr;
+		header->cls = 0;
+	}
+
+	return header + 1;
+}
+
+void FrameService::deallocate(void* ptr)
+{
+	if ( !ptr ) {
+		return;
+	}
+
+	FrameHeader* header = static_cast<FrameHeader*>(ptr) - 1;
+	FrameService* owner = header->owner;
+
+	if ( owner && std::this_thread::get_id() == owner->owner_ ) {
+		owner->recycle(header, header->cls);
+	} else {
+		::operator delete(header);
+	}
+}
+
+void FrameService::recycle(void* block, size_t cls)
+{
+	if ( free_counts_[cls] >= FRAME_CLASS_LIMIT ) {
+		::operator delete(block);
+		return;
+	}
+
+	FreeBlock* free_block = static_cast<FreeBlock*>(block);
+	free_block->next = free_lists_[cls];
+	free_lists_[cls] = free_block;
+	++free_counts_[cls];
+}
+
+size_t FrameService::cachedFrames() const
+{
+	size_t total = 0;
+	for ( size_t i = 0; i < FRAME_CLASSES; ++i ) {
+		total += free_counts_[i];
+	}
+	return total;
+}
+
+size_t FrameService::reusedFrames() const
+{
+	return reused_;
+}
+
+}	// namespace details
+}	// namespace asio
+}	// namespace lcy
@@ -0,0 +1,74 @@
+#ifndef __LCY_ASIO_DETAILS_FRAME_SERVICE_H__
+#define __LCY_ASIO_DETAILS_FRAME_SERVICE_H__
+
+#include <thread>
+#include <stddef.h>
+
+#include "lcy/asio/src/details/service.hpp"
+
+namespace lcy {
+namespace asio {
+namespace details {
+
+/*
+* Recycles coroutine frames of one IOContext.
+*
+* Frames are grouped in size classes of FRAME_ALIGN bytes, a freed frame goes onto
+* the free list of its class and is handed out again by the next allocation of
+* that class, so a steady state session does not hit the global allocator.
+*
+* notify :
+*	Only the loop thread of the owning IOContext touches the free lists, frames
+*	allocated or freed on any other thread ( e.g. a coroutine that moved to
+*	another context ) fall back to ::operator new / delete.
+*	All frames must be destroyed before the IOContext.
+*/
+class FrameService :
+	public Service
+{
+public:
+	typedef std::thread::id thread_id_type;
+
+	enum {
+		FRAME_ALIGN = 64,
+		FRAME_CLASSES = 32,			// frames up to 2 KiB are cached
+		FRAME_CLASS_LIMIT = 256,	// cached frames per class
+	};
+
+	FrameService(thread_id_type owner);
+	~FrameService();
+
+	/*
+	* `service` may be null, the frame then simply bypasses the cache.
+	* deallocate finds the owning service through the frame header.
+	*/
+	static void* allocate(FrameService* service, size_t size);
+	static void deallocate(void* ptr);
+
+	size_t cachedFrames() const;
+	size_t reusedFrames() const;
+
+private:
+	FrameService(const FrameService&);
+	FrameService& operator=(const FrameService&);
+
+	void recycle(void* block, size_t cls);
+
+private:
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	thread_id_type owner_;
+	FreeBlock* free_lists_[FRAME_CLASSES];
+	size_t free_counts_[FRAME_CLASSES];
+	size_t reused_;
+};
+
+LCY_ASIO_DETAILS_SERVICEID_REGISTER_EXTERN(FrameService)
+
+}	// namespace details
+}	// namespace asio
+}	// namespace lcy
+
+#endif	// __LCY_ASIO_DETAILS_FRAME_SERVICE_H__
@@ -0,0 +1,158 @@
+#ifndef __LCY_ASIO_DETAILS_LOOP_MONITOR_H__
+#define __LCY_ASIO_DETAILS_LOOP_MONITOR_H__
+
+#include <atomic>
+#include <stdint.h>
+#include <pthread.h>
+#include <execinfo.h>
+
+namespace lcy {
+namespace asio {
+namespace details {
+
+/*
+* LoopMonitor is embedded in every ReactorService and written only by the loop thread.
+* The hot path is a handful of relaxed stores per wakeup, so it is always enabled;
+* a Watchdog reads it from another thread to detect stalled iterations.
+*
+*	sequence : odd while the loop is dispatching events, even while it waits in epoll
+*	fd       : descriptor whose handler is currently running
+*	tag      : optional handler tag set by LCY_ASIO_WATCHDOG_TAG
+*/
+class LoopMonitor {
+public:
+	typedef uint64_t sequence_type;
+	enum { MAX_FRAMES = 64 };
+
+	LoopMonitor() :
+		sequence_(0),
+		fd_(-1),
+		tag_(nullptr),
+		thread_(0),
+		attached_(false),
+		frame_count_(0),
+		captured_(false)
+	{
+	}
+
+	void attach()
+	{
+		thread_ = ::pthread_self();
+		attached_.store(true, std::memory_order_release);
+		current() = this;
+	}
+
+	void detach()
+	{
+		current() = nullptr;
+		attached_.store(false, std::memory_order_release);
+	}
+
+	void begin()
+	{
+		sequence_.store(sequence_.load(std::memory_order_relaxed) + 1,
+						std::memory_order_release);
+	}
+
+	void dispatch(int fd)
+	{
+		fd_.store(fd, std::memory_order_relaxed);
+		tag_.store(nullptr, std::memory_order_relaxed);
+	}
+
+	void end()
+	{
+		fd_.store(-1, std::memory_order_relaxed);
+		sequence_.store(sequence_.load(std::memory_order_relaxed) + 1,
+						std::memory_order_release);
+	}
+
+	sequence_type sequence() const { return sequence_.load(std::memory_order_acquire); }
+	int fd() const { return fd_.load(std::memory_order_relaxed); }
+	const char* tag() const { return tag_.load(std::memory_order_relaxed); }
+	pthread_t thread() const { return thread_; }
+	bool attached() const { return attached_.load(std::memory_order_acquire); }
+
+	/*
+	* Backtrace capture handshake : the watchdog calls resetCapture() and signals
+	* the loop thread, whose signal handler calls capture() on its own stack.
+	*/
+	void resetCapture()
+	{
+		captured_.store(false, std::memory_order_release);
+	}
+
+	void capture()
+	{
+		frame_count_ = ::backtrace(frames_, MAX_FRAMES);
+		captured_.store(true, std::memory_order_release);
+	}
+
+	bool captured() const { return captured_.load(std::memory_order_acquire); }
+	void* const* frames() const { return frames_; }
+	int frameCount() const { return frame_count_; }
+
+	static LoopMonitor*& current()
+	{
+		static thread_local LoopMonitor* monitor = nullptr;
+		return monitor;
+	}
+
+	/*
+	* RAII handler tag, restores the enclosing tag on exit so nested scopes work.
+	*/
+	class Scope {
+	public:
+		Scope(const char* tag) :
+			monitor_(current()),
+			prev_(nullptr)
+		{
+			if ( monitor_ ) {
+				prev_ = monitor_->tag_.load(std::memory_order_relaxed);
+				monitor_->tag_.store(tag, std::memory_order_relaxed);
+			}
+		}
+
+		~Scope()
+		{
+			if ( monitor_ ) {
+				monitor_->tag_.store(prev_, std::memory_order_relaxed);
+			}
+		}
+
+	private:
+		Scope(const Scope&);
+		Scope& operator=(const Scope&);
+
+	private:
+		LoopMonitor* monitor_;
+		const char* prev_;
+	};
+
+private:
+	LoopMonitor(const LoopMonitor&);
+	LoopMonitor& operator=(const LoopMonitor&);
+
+private:
+	std::atomic<sequence_type> sequence_;
+	std::atomic<int> fd_;
+	std::atomic<const char*> tag_;
+	pthread_t thread_;
+	std::atomic<bool> attached_;
+
+	// Filled by the watchdog signal handler on the monitored thread
+	void* frames_[MAX_FRAMES];
+	int frame_count_;
+	std::atomic<bool> captured_;
+};
+
+#define LCY_ASIO_DETAILS_STRINGIZE_IMPL(x) #x
+#define LCY_ASIO_DETAILS_STRINGIZE(x) LCY_ASIO_DETAILS_STRINGIZE_IMPL(x)
+#define LCY_ASIO_DETAILS_CONCAT_IMPL(a, b) a##b
+#define LCY_ASIO_DETAILS_CONCAT(a, b) LCY_ASIO_DETAILS_CONCAT_IMPL(a, b)
+
+}	// namespace details
+}	// namespace asio
+}	// namespace lcy
+
+#endif	// __LCY_ASIO_DETAILS_LOOP_MONITOR_H__
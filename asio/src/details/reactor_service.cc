@@ -94,10 +94,13 @@ static int epoll_modify(int epollfd, int fd, int events, void* udata)
 class ReactorService::OperationInfo {
 public:
 	typedef ReactorService::operation_type operation_type;
+	typedef ReactorService::file_descriptor_type file_descriptor_type;
 
-	OperationInfo();
+	OperationInfo(file_descriptor_type fd);
 	~OperationInfo();
 
+	file_descriptor_type fd() const;
+
 	void setReadOperation(operation_type read_op);
 	void removeReadOperation();
 	void cancelReadOperation();
@@ -115,14 +118,22 @@ public:
 	bool hasWriteOperation() const;
 	bool hasOperation() const;
 
+	// bumped whenever the descriptor is given up, its number may come back as another one
+	uint64_t generation() const;
+	void nextGeneration();
+
 private:
+	file_descriptor_type fd_;
+	uint64_t generation_;
 	operation_type read_op_;
 	operation_type write_op_;
 };
 
 ///////////////////////////////////////////////////////////
 
-ReactorService::OperationInfo::OperationInfo()
+ReactorService::OperationInfo::OperationInfo(file_descriptor_type fd) :
+	fd_(fd),
+	generation_(0)
 {
 }
 
@@ -130,6 +141,11 @@ ReactorService::OperationInfo::~OperationInfo()
 {
 }
 
+ReactorService::OperationInfo::file_descriptor_type ReactorService::OperationInfo::fd() const
+{
+	return fd_;
+}
+
 void ReactorService::OperationInfo::setReadOperation(operation_type read_op)
 {
 	read_op_ = std::move(read_op);
@@ -235,6 +251,16 @@ bool ReactorService::OperationInfo::hasOperation() const
 	return hasReadOperation() || hasWriteOperation();
 }
 
+uint64_t ReactorService::OperationInfo::generation() const
+{
+	return generation_;
+}
+
+void ReactorService::OperationInfo::nextGeneration()
+{
+	++generation_;
+}
+
 ////////////////////////////////////////////////////////////
 
 ReactorService::ReactorService() :
@@ -266,20 +292,27 @@ void ReactorService::quit()
 errcode_type ReactorService::loop_wait()
 {
 	quit_ = false;
+	monitor_.attach();
 
 	while ( !quit_ ) {
 		int nevents = ::epoll_wait(epoll_fd_, 
 			&event_array_[0], event_array_.size(), -1);
 		if ( nevents < 0 ) {
 			if ( errno == EINTR ) continue;
-			else return errno;
+			
+			monitor_.detach();
+			return errno;
 		}
 		
+		monitor_.begin();
+
 		for ( int i = 0; i < nevents; ++i ) {
 			
 			OperationInfo* opinfo = (OperationInfo*)event_array_[i].data.ptr;
 			int events = event_array_[i].events;
 
+			monitor_.dispatch(opinfo->fd());
+
 			/*
  			*notify : 
  			* Multiple events may be triggered simultaneously,
@@ -288,9 +321,18 @@ errcode_type ReactorService::loop_wait()
  			* We have made this check in OpInfo.
  			*/
 
+			/*
+			*notify :
+			*	A read operation may close the descriptor and a new one may get the same
+			*	number within it : the rest of these events are not for that one.
+			*/
+			uint64_t generation = opinfo->generation();
+
 			if ( events & (EPOLLERR | EPOLLHUP) ) {
 				opinfo->doReadOperation(err::EFDHUP);
-				opinfo->doWriteOperation(err::EFDHUP);
+				if ( opinfo->generation() == generation ) {
+					opinfo->doWriteOperation(err::EFDHUP);
+				}
 				continue;
 			}
 
@@ -298,16 +340,19 @@ errcode_type ReactorService::loop_wait()
 				opinfo->doReadOperation(err::SUCCESS);
 			}
 		
-			if ( events & (EPOLLOUT) ) {
+			if ( (events & (EPOLLOUT)) && opinfo->generation() == generation ) {
 				opinfo->doWriteOperation(err::SUCCESS);
 			}
 		}
 
+		monitor_.end();
+
 		if ( nevents >= event_array_.size() ) {
 			event_array_.resize(nevents * 2);
 		}
 	}
 
+	monitor_.detach();
 	return 0;
 }
 
@@ -317,7 +362,7 @@ void ReactorService::registerReadOperation(file_descriptor_type fd, operation_ty
 	if ( fd_opinfo_umap_[fd] ) {
 		opinfo = fd_opinfo_umap_[fd];
 	} else {
-		opinfo = new OperationInfo();
+		opinfo = new OperationInfo(fd);
 		fd_opinfo_umap_[fd] = opinfo;
 	}
 
@@ -392,7 +437,7 @@ void ReactorService::registerWriteOperation(file_descriptor_type fd, operation_t
 	if ( fd_opinfo_umap_[fd] ) {
 		opinfo = fd_opinfo_umap_[fd];
 	} else {
-		opinfo = new OperationInfo();
+		opinfo = new OperationInfo(fd);
 		fd_opinfo_umap_[fd] = opinfo;
 	}
 
@@ -483,12 +528,18 @@ void ReactorService::cancelAllOperations(file_descriptor_type fd)
 	}
 
 	int errcode = err::SUCCESS;
+	kv_iter->second->nextGeneration();
 	if ( kv_iter->second->hasOperation() ) {
 		errcode = epoll_remove(epoll_fd_, fd);
 		kv_iter->second->cancelAllOperations();
 	}	// FIXME : check errcode
 }
 
+LoopMonitor& ReactorService::monitor()
+{
+	return monitor_;
+}
+
 }	// namespace details
 }	// namespace asio
 }	// namespace lcy
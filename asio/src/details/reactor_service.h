@@ -8,6 +8,7 @@
 
 #include "lcy/asio/src/errinfo.h"
 #include "lcy/asio/src/details/service.hpp"
+#include "lcy/asio/src/details/loop_monitor.h"
 
 namespace lcy {
 namespace asio {
@@ -37,6 +38,8 @@ public:
 	void removeAllOperations(file_descriptor_type fd);
 	void cancelAllOperations(file_descriptor_type fd);
 
+	LoopMonitor& monitor();
+
 private:	
 	ReactorService(const ReactorService&);
 	ReactorService& operator=(const ReactorService&);
@@ -54,6 +57,7 @@ private:
 	epollfd_type epoll_fd_;
 	event_array_type event_array_;
 	fd_opinfo_umap_type fd_opinfo_umap_;
+	LoopMonitor monitor_;
 };
 
 LCY_ASIO_DETAILS_SERVICEID_REGISTER_EXTERN(ReactorService)
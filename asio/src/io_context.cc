@@ -37,9 +37,14 @@ errcode_type IOContext::loop_wait()
 	return use_service<details::ReactorService>(*this).loop_wait();
 }
 
+bool IOContext::running_in_this_thread() const
+{
+	return thread_id_ == std::this_thread::get_id();
+}
+
 void post(IOContext& ioc, task_op_type task_op)
 {
-	if ( ioc.thread_id_ == std::this_thread::get_id() ) {
+	if ( ioc.running_in_this_thread() ) {
 		task_op();
 		return;
 	}
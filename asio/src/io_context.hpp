@@ -12,6 +12,7 @@
 #include "lcy/asio/src/details/reactor_service.h"
 #include "lcy/asio/src/details/timer_service.h"
 #include "lcy/asio/src/details/bridge_service.hpp"
+#include "lcy/asio/src/details/frame_service.h"
 
 namespace lcy {
 namespace asio {
@@ -33,6 +34,9 @@ public:
 	void quit();
 	errcode_type loop_wait();
 
+	// true on the thread that owns the loop ( the thread that constructed the context )
+	bool running_in_this_thread() const;
+
 private:
 	IOContext(const IOContext&);
 	IOContext& operator=(const IOContext&);
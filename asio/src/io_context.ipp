@@ -56,6 +56,21 @@ inline details::BridgeService& use_service<details::BridgeService>(IOContext& io
 		   >(*(ioc.id_service_umap_[id]));
 }
 
+template <>
+inline details::FrameService& use_service<details::FrameService>(IOContext& ioc)
+{
+	std::lock_guard<std::mutex> locker(ioc.mutex_);
+
+	uintptr_t id = (uintptr_t)&details::ServiceId<details::FrameService>::id;
+	if ( ioc.id_service_umap_.find(id) == ioc.id_service_umap_.end() ) {
+		ioc.id_service_umap_[id] = new details::FrameService(ioc.thread_id_);
+	}
+
+	return static_cast<
+		   		details::FrameService&
+		   >(*(ioc.id_service_umap_[id]));
+}
+
 template <typename Iterator>
 inline void batch(IOContext& ioc, Iterator beg, Iterator end)
 {
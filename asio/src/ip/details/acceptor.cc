@@ -58,6 +58,11 @@ void Acceptor::cancel()
 	acceptor_.cancel();
 }
 
+errcode_type Acceptor::localAddr(Endpoint& endpoint)
+{
+	return acceptor_.localAddr(endpoint);
+}
+
 }	// namespace details
 }	// namespace ip
 }	// namespace asio
@@ -26,6 +26,9 @@ public:
 	void async_accept(TCPSocket& socket, accept_op_type accept_op);
 	void cancel();
 
+	// the bound address, e.g. the port picked for port 0
+	errcode_type localAddr(Endpoint& endpoint);
+
 private:
 	Acceptor(const Acceptor&);
 	Acceptor& operator=(const Acceptor&);
@@ -4,6 +4,7 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/sendfile.h>
 #include <cstring>
 
 namespace lcy {
@@ -97,8 +98,11 @@ static void write_op_wrap(errcode_type ec,
 								MSG_NOSIGNAL);
 
 		if ( nwrite < 0 ) {
-			write_op(errno, send_bytes);
-			return;
+			if ( errno != EAGAIN && errno != EINTR ) {
+				write_op(errno, send_bytes);
+				return;
+			}
+			nwrite = 0;		// woken up for nothing, wait for the next readiness
 		}
 
 		send_bytes += nwrite;
@@ -135,6 +139,46 @@ static void write_op_wrap(errcode_type ec,
 *
 */
 
+static void sendfile_op_wrap(errcode_type ec,
+							 int sockfd,
+							 asio::details::ReactorService& reactor,
+							 int in_fd,
+							 off_t offset,
+							 size_t count,
+							 size_t send_bytes,
+							 TCPSocket::write_op_type write_op)
+{
+	if ( !ec ) {
+		reactor.removeWriteOperation(sockfd);
+
+		ssize_t nwrite = ::sendfile(sockfd, in_fd, &offset, count);
+		if ( nwrite < 0 && errno != EAGAIN && errno != EINTR ) {
+			write_op(errno, send_bytes);
+			return;
+		}
+		if ( nwrite == 0 ) {		// the file is shorter than announced
+			write_op(EIO, send_bytes);
+			return;
+		}
+
+		if ( nwrite > 0 ) {
+			send_bytes += nwrite;
+			count -= nwrite;
+		}
+
+		if ( count != 0 ) {
+			reactor.registerWriteOperation(sockfd, std::bind(
+				sendfile_op_wrap, std::placeholders::_1, sockfd, std::ref(reactor),
+					in_fd, offset, count, send_bytes, std::move(write_op)));
+			return;
+		}
+
+		write_op(ec, send_bytes);
+	} else {
+		write_op(ec, send_bytes);
+	}
+}
+
 static void accept_op_wrap(errcode_type ec,
 						   int sockfd,
 						   int& accept_sockfd,
@@ -144,7 +188,8 @@ static void accept_op_wrap(errcode_type ec,
 	if ( !ec ) {
 		reactor.removeReadOperation(sockfd);
 
-		accept_sockfd = ::accept(sockfd, nullptr, nullptr);
+		// non blocking as the sockets of open(), a partial send must not stall the loop
+		accept_sockfd = ::accept4(sockfd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
 		if ( accept_sockfd == -1 ) {
 			accept_op(errno);
 			return;
@@ -240,6 +285,55 @@ void TCPSocket::async_write(ConstBuffer cbuf, write_op_type write_op)
 			std::ref(reactor_), cbuf, 0, std::move(write_op)));
 }
 
+size_t TCPSocket::write_some(ConstBuffer cbuf, errcode_type& ec)
+{
+	ec = err::SUCCESS;
+
+	ssize_t nwrite = ::send(sockfd_,
+							cbuf.data(),
+							cbuf.length(),
+							MSG_NOSIGNAL | MSG_DONTWAIT);
+	if ( nwrite < 0 ) {
+		if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) {
+			ec = errno;
+		}
+		return 0;
+	}
+	return nwrite;
+}
+
+void TCPSocket::async_sendfile(int in_fd, off_t offset, size_t count, write_op_type write_op)
+{
+	if ( count == 0 ) {
+		write_op(err::SUCCESS, 0);
+		return;
+	}
+
+	reactor_.registerWriteOperation(sockfd_, std::bind(
+		sendfile_op_wrap, std::placeholders::_1, sockfd_, std::ref(reactor_),
+			in_fd, offset, count, 0, std::move(write_op)));
+}
+
+size_t TCPSocket::sendfile_some(int in_fd, off_t& offset, size_t count, errcode_type& ec)
+{
+	ec = err::SUCCESS;
+	if ( count == 0 ) {
+		return 0;
+	}
+
+	ssize_t nwrite = ::sendfile(sockfd_, in_fd, &offset, count);
+	if ( nwrite < 0 ) {
+		if ( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR ) {
+			ec = errno;
+		}
+		return 0;
+	}
+	if ( nwrite == 0 ) {
+		ec = EIO;		// the file is shorter than announced
+	}
+	return nwrite;
+}
+
 void TCPSocket::async_accept(TCPSocket& tcp_socket, accept_op_type accept_op)
 {
 	reactor_.registerReadOperation(sockfd_, std::bind(
@@ -390,6 +484,16 @@ errcode_type TCPSocket::localAddr(Endpoint& endpoint)
 	return 0;
 }
 
+errcode_type TCPSocket::error()
+{
+	int errcode = 0;
+	socklen_t len = sizeof(int);
+	if ( ::getsockopt(sockfd_, SOL_SOCKET, SO_ERROR, &errcode, &len) ) {
+		return errno;
+	}
+	return errcode;
+}
+
 std::string TCPSocket::tcpInfo()
 {
 	struct tcp_info tcpi;
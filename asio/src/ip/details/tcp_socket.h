@@ -3,6 +3,7 @@
 
 #include <string>
 #include <functional>
+#include <sys/types.h>
 
 #include "lcy/asio/src/buffer.h"
 #include "lcy/asio/src/errinfo.h"
@@ -30,6 +31,23 @@ public:
 	void async_accept(TCPSocket& tcp_socket, accept_op_type accept_op);
 	void async_connect(const Endpoint& endpoint, connect_op_type connect_op);
 
+	/*
+	* notify :
+	*	Sends what the socket buffer takes right now without waiting for the reactor,
+	*	returns the bytes sent ( 0 when it is full, ec stays SUCCESS ). The rest is
+	*	left to async_write. Must not race a pending async_write.
+	*/
+	size_t write_some(ConstBuffer cbuf, errcode_type& ec);
+
+	/*
+	* notify :
+	*	sendfile(2) of `count` bytes of `in_fd` from `offset`, the file data never
+	*	passes through user space. The caller keeps `in_fd` open until the operation
+	*	completes. sendfile_some is the write_some of files, it advances `offset`.
+	*/
+	void async_sendfile(int in_fd, off_t offset, size_t count, write_op_type write_op);
+	size_t sendfile_some(int in_fd, off_t& offset, size_t count, errcode_type& ec);
+
 	void cancel();
 
 	errcode_type open(const TCP& tcp);
@@ -47,6 +65,8 @@ public:
 	errcode_type peerAddr(Endpoint& endpoint);
 	errcode_type localAddr(Endpoint& endpoint);
 	std::string tcpInfo();
+	// pending error of the socket ( SO_ERROR ), what an EFDHUP stands for
+	errcode_type error();
 
 	IOContext& context();
 
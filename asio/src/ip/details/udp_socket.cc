@@ -232,6 +232,11 @@ std::string UDPSocket::udpInfo()
     return std::string(buff);
 }
 
+IOContext& UDPSocket::context()
+{
+	return ioc_;
+}
+
 }	// namespace details
 }	// namespace ip
 }	// namespace asio
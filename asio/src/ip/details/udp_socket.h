@@ -43,6 +43,8 @@ public:
 
 	std::string udpInfo();
 
+	IOContext& context();
+
 private:
 	UDPSocket(const UDPSocket&);
 	UDPSocket& operator=(const UDPSocket&);
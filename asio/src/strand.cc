@@ -0,0 +1,177 @@
+#include "lcy/asio/src/strand.h"
+#include "lcy/asio/src/io_context.hpp"
+
+#include <atomic>
+#include <thread>
+
+namespace lcy {
+namespace asio {
+
+/*
+* Intrusive multi producer / single consumer queue ( Vyukov ).
+* Producers exchange the head and link the previous node, the loop thread is the
+* only consumer and owns tail_. `pending_` counts queued handlers, the push that
+* moves it from 0 to 1 is the one that schedules a drain. Once `closed_` is set
+* by ~Strand the drains still unlink and destroy the queued handlers, unrun.
+*/
+class Strand::Impl :
+	public std::enable_shared_from_this<Strand::Impl>
+{
+public:
+	enum {
+		DRAIN_BUDGET = 64,	// handlers per drain before yielding to the loop
+	};
+
+	Impl(IOContext& ioc);
+	~Impl();
+
+	void push(task_op_type task_op);
+	void close();
+	IOContext& context();
+
+private:
+	void schedule();
+	void drain();
+
+private:
+	struct Node {
+		std::atomic<Node*> next;
+		task_op_type task_op;
+
+		Node() : next(nullptr) {}
+	};
+
+	IOContext& ioc_;
+	details::BridgeService& bridge_service_;
+
+	std::atomic<Node*> head_;
+	Node* tail_;
+	std::atomic<size_t> pending_;
+	std::atomic<bool> closed_;
+};
+
+///////////////////////////////////////////////////////////////
+
+Strand::Impl::Impl(IOContext& ioc) :
+	ioc_(ioc),
+	bridge_service_(use_service<details::BridgeService>(ioc)),
+	head_(nullptr),
+	tail_(new Node()),
+	pending_(0),
+	closed_(false)
+{
+	head_.store(tail_, std::memory_order_relaxed);
+}
+
+Strand::Impl::~Impl()
+{
+	while ( tail_ ) {
+		Node* next = tail_->next.load(std::memory_order_relaxed);
+		delete tail_;
+		tail_ = next;
+	}
+}
+
+void Strand::Impl::push(task_op_type task_op)
+{
+	Node* node = new Node();
+	node->task_op = std::move(task_op);
+
+	Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+	prev->next.store(node, std::memory_order_release);
+
+	if ( pending_.fetch_add(1, std::memory_order_acq_rel) == 0 ) {
+		schedule();
+	}
+}
+
+void Strand::Impl::close()
+{
+	closed_.store(true, std::memory_order_release);
+}
+
+IOContext& Strand::Impl::context()
+{
+	return ioc_;
+}
+
+void Strand::Impl::schedule()
+{
+	std::shared_ptr<Impl> self = shared_from_this();
+	bridge_service_.push([self](){ self->drain(); });
+}
+
+void Strand::Impl::drain()
+{
+	size_t budget = DRAIN_BUDGET;
+
+	while ( true ) {
+		Node* next = tail_->next.load(std::memory_order_acquire);
+		if ( !next ) {
+			/*
+			* notify :
+			*	pending_ says a handler is queued but its producer has not linked
+			*	the node yet, that window is a couple of instructions wide.
+			*/
+			std::this_thread::yield();
+			continue;
+		}
+
+		task_op_type task_op = std::move(next->task_op);
+		delete tail_;
+		tail_ = next;
+
+		if ( !closed_.load(std::memory_order_acquire) ) {
+			task_op();
+		}
+
+		if ( pending_.fetch_sub(1, std::memory_order_acq_rel) == 1 ) {
+			return;
+		}
+
+		if ( --budget == 0 ) {
+			schedule();
+			return;
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////
+
+Strand::Strand(IOContext& ioc) :
+	pImpl_(std::make_shared<Impl>(ioc))
+{
+}
+
+Strand::~Strand()
+{
+	pImpl_->close();
+}
+
+void Strand::dispatch(task_op_type task_op)
+{
+	if ( running_in_this_thread() ) {
+		task_op();
+		return;
+	}
+
+	pImpl_->push(std::move(task_op));
+}
+
+void Strand::post(task_op_type task_op)
+{
+	pImpl_->push(std::move(task_op));
+}
+
+bool Strand::running_in_this_thread() const
+{
+	return pImpl_->context().running_in_this_thread();
+}
+
+IOContext& Strand::context()
+{
+	return pImpl_->context();
+}
+
+}	// namespace asio
+}	// namespace lcy
@@ -0,0 +1,52 @@
+#ifndef __LCY_ASIO_STRAND_H__
+#define __LCY_ASIO_STRAND_H__
+
+#include <memory>
+#include <functional>
+
+namespace lcy {
+namespace asio {
+
+class IOContext;
+
+/*
+* Serializes handlers onto the loop thread of one IOContext.
+*
+* Any thread may submit, handlers run one at a time and in submission order per
+* submitting thread. Submitting is a lock free push, only the submission that
+* finds the strand idle schedules a drain on the loop ( one BridgeService push
+* per burst instead of one per handler ).
+*
+* notify :
+*	dispatch() runs the handler inline when the caller already is the loop thread,
+*	post() always defers it to the next drain.
+*	The strand may be destroyed with a drain pending, the handlers still queued are
+*	then destroyed without being run. One already running when ~Strand() returns
+*	still runs to its end, owners it touches need a lifetime of their own.
+*/
+class Strand {
+public:
+	typedef std::function<void ()> task_op_type;
+
+	Strand(IOContext& ioc);
+	~Strand();
+
+	void dispatch(task_op_type task_op);
+	void post(task_op_type task_op);
+
+	bool running_in_this_thread() const;
+	IOContext& context();
+
+private:
+	Strand(const Strand&);
+	Strand& operator=(const Strand&);
+
+private:
+	class Impl;
+	std::shared_ptr<Impl> pImpl_;
+};
+
+}	// namespace asio
+}	// namespace lcy
+
+#endif	// __LCY_ASIO_STRAND_H__
@@ -1,6 +1,7 @@
 #include "lcy/asio/src/thread_pool.h"
 #include "lcy/asio/src/io_context.hpp"
 #include "lcy/asio/src/exception.h"
+#include "lcy/asio/src/watchdog.h"
 
 #include <thread>
 #include <pthread.h>
@@ -14,7 +15,7 @@ public:
 	Thread();
 	~Thread();
 
-	void start();
+	void start(Watchdog* watchdog);
 	void stop();
 	
 	IOContext& context();
@@ -38,15 +39,23 @@ ThreadPool::Thread::~Thread()
 	::sem_destroy(&sem_);
 }
 
-void ThreadPool::Thread::start()
+void ThreadPool::Thread::start(Watchdog* watchdog)
 {
-	th_ = std::thread([this](){ 
+	th_ = std::thread([this, watchdog](){ 
 		IOContext ioc;
+		if ( watchdog ) {
+			watchdog->watch(ioc);
+		}
+
 		ioc_ = &ioc;
 		::sem_post(&sem_);
 
 		ioc.loop_wait(); 
 		ioc_ = nullptr;
+
+		if ( watchdog ) {
+			watchdog->unwatch(ioc);
+		}
 	});
 	
 	::sem_wait(&sem_);
@@ -67,6 +76,7 @@ IOContext& ThreadPool::Thread::context()
 
 ThreadPool::ThreadPool(size_t thread_num) :
 	is_start_(false),
+	watchdog_(nullptr),
 	next_(0)
 {
 	if ( thread_num < 0 ) {
@@ -99,7 +109,7 @@ void ThreadPool::start()
 	size_t size = threads_.size();
 
 	for ( size_t i = 0; i < size; ++i ) {
-		threads_[i]->start();
+		threads_[i]->start(watchdog_);
 	}
 
 	is_start_ = true;
@@ -120,6 +130,15 @@ void ThreadPool::stop()
 	is_start_ = false;
 }
 
+void ThreadPool::setWatchdog(Watchdog* watchdog)
+{
+	if ( is_start_ ) {
+		throw LcyAsioException("The watchdog must be set before the thread pool starts");
+	}
+
+	watchdog_ = watchdog;
+}
+
 IOContext& ThreadPool::nextContext()
 {
 	if ( !is_start_ ) {
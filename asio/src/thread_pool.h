@@ -9,6 +9,7 @@ namespace lcy {
 namespace asio {
 
 class IOContext;
+class Watchdog;
 
 class ThreadPool {
 public:
@@ -18,6 +19,7 @@ public:
 	void start();
 	void stop();
 
+	void setWatchdog(Watchdog* watchdog);
 	IOContext& nextContext();
 
 private:
@@ -30,6 +32,7 @@ private:
 	typedef std::vector<Thread*> thread_array_type;
 	
 	bool is_start_;
+	Watchdog* watchdog_;
 	atomic_size_type next_;
 	thread_array_type threads_;
 };
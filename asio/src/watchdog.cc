@@ -0,0 +1,267 @@
+#include "lcy/asio/src/watchdog.h"
+#include "lcy/asio/src/io_context.hpp"
+#include "lcy/asio/src/exception.h"
+
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <execinfo.h>
+
+#include <iostream>
+
+namespace lcy {
+namespace asio {
+
+#define CAPTURE_WAIT_MS 50
+
+static void capture_signal_handler(int signum)
+{
+	(void)signum;
+
+	int saved_errno = errno;
+
+	details::LoopMonitor* monitor = details::LoopMonitor::current();
+	if ( monitor ) {
+		monitor->capture();
+	}
+
+	errno = saved_errno;
+}
+
+static void install_capture_handler(int signum)
+{
+ /*
+ * notify :
+ *	backtrace() loads libgcc lazily on first use, which is not safe inside a
+ *	signal handler. Call it once here so the handler only walks the stack.
+ */
+	void* frames[1];
+	::backtrace(frames, 1);
+
+	struct sigaction act;
+	::memset(&act, 0x00, sizeof(act));
+	act.sa_handler = capture_signal_handler;
+	act.sa_flags = SA_RESTART;
+	::sigemptyset(&act.sa_mask);
+
+	::sigaction(signum, &act, nullptr);
+}
+
+static void default_stall_op(const Watchdog::StallInfo& info)
+{
+	std::cerr << "[lcy::asio::Watchdog] event loop stalled for "
+			  << info.elapsed_ms << " ms, fd = " << info.fd
+			  << ", handler = " << (info.tag.empty() ? "<untagged>" : info.tag)
+			  << std::endl;
+
+	for ( auto& frame : info.backtrace ) {
+		std::cerr << "    " << frame << std::endl;
+	}
+}
+
+////////////////////////////////////////////////////////////
+
+Watchdog::Watchdog(timeout_type threshold, stall_op_type stall_op) :
+	threshold_(threshold),
+	stall_op_(std::move(stall_op)),
+	backtrace_(true),
+	signum_(SIGURG),
+	running_(false),
+	stall_count_(0)
+{
+	if ( threshold_ <= 0 ) {
+		throw LcyAsioException("The watchdog threshold must be greater than 0");
+	}
+
+	if ( !stall_op_ ) {
+		stall_op_ = default_stall_op;
+	}
+}
+
+Watchdog::~Watchdog()
+{
+	stop();
+}
+
+void Watchdog::start()
+{
+	std::lock_guard<mutex_type> locker(mutex_);
+	if ( running_ ) {
+		return;
+	}
+
+	if ( backtrace_ ) {
+		install_capture_handler(signum_);
+	}
+
+	running_ = true;
+	th_ = std::thread(&Watchdog::run, this);
+}
+
+void Watchdog::stop()
+{
+	{
+		std::lock_guard<mutex_type> locker(mutex_);
+		if ( !running_ ) {
+			return;
+		}
+		running_ = false;
+	}
+
+	cond_.notify_all();
+	th_.join();
+}
+
+void Watchdog::watch(IOContext& ioc)
+{
+	details::LoopMonitor& monitor =
+		use_service<details::ReactorService>(ioc).monitor();
+
+	std::lock_guard<mutex_type> locker(mutex_);
+	for ( auto& watched : watched_ ) {
+		if ( watched.monitor == &monitor ) {
+			return;
+		}
+	}
+
+	Watched watched = { &monitor, monitor.sequence(), details::now_ms(), false };
+	watched_.push_back(watched);
+}
+
+void Watchdog::unwatch(IOContext& ioc)
+{
+	details::LoopMonitor& monitor =
+		use_service<details::ReactorService>(ioc).monitor();
+
+	std::lock_guard<mutex_type> locker(mutex_);
+	for ( auto iter = watched_.begin(); iter != watched_.end(); ++iter ) {
+		if ( iter->monitor == &monitor ) {
+			watched_.erase(iter);
+			return;
+		}
+	}
+}
+
+void Watchdog::setBacktrace(bool enable, int signum)
+{
+	std::lock_guard<mutex_type> locker(mutex_);
+	backtrace_ = enable;
+	signum_ = signum;
+
+	if ( running_ && backtrace_ ) {
+		install_capture_handler(signum_);
+	}
+}
+
+size_t Watchdog::stallCount() const
+{
+	return stall_count_.load(std::memory_order_relaxed);
+}
+
+void Watchdog::run()
+{
+	// Sample several times per threshold so a stall is reported close to it
+	timeout_type interval = threshold_ / 4;
+	if ( interval <= 0 ) {
+		interval = 1;
+	}
+
+	std::unique_lock<mutex_type> locker(mutex_);
+	while ( running_ ) {
+		cond_.wait_for(locker, std::chrono::milliseconds(interval));
+		if ( !running_ ) {
+			break;
+		}
+
+		locker.unlock();
+		check(details::now_ms());
+		locker.lock();
+	}
+}
+
+void Watchdog::check(time_t now)
+{
+	std::vector<StallInfo> stalls;
+
+	{
+		std::lock_guard<mutex_type> locker(mutex_);
+
+		for ( auto& watched : watched_ ) {
+			details::LoopMonitor::sequence_type sequence = watched.monitor->sequence();
+
+			if ( sequence != watched.sequence ) {		// The loop made progress
+				watched.sequence = sequence;
+				watched.since = now;
+				watched.reported = false;
+				continue;
+			}
+
+			bool dispatching = (sequence & 1) && watched.monitor->attached();
+			if ( !dispatching || watched.reported ) {
+				continue;
+			}
+
+			if ( now - watched.since >= threshold_ ) {
+				watched.reported = true;
+
+				stalls.push_back(StallInfo());
+				report(*watched.monitor, now - watched.since, stalls.back());
+			}
+		}
+	}
+
+	// Report outside of the lock, the callback may watch or unwatch contexts
+	for ( auto& info : stalls ) {
+		stall_count_.fetch_add(1, std::memory_order_relaxed);
+		stall_op_(info);
+	}
+}
+
+void Watchdog::report(details::LoopMonitor& monitor, time_t elapsed, StallInfo& info)
+{
+	info.thread = monitor.thread();
+	info.elapsed_ms = elapsed;
+	info.fd = monitor.fd();
+
+	const char* tag = monitor.tag();
+	if ( tag ) {
+		info.tag = tag;
+	}
+
+	if ( !backtrace_ ) {
+		return;
+	}
+
+	monitor.resetCapture();
+	if ( ::pthread_kill(monitor.thread(), signum_) ) {
+		return;
+	}
+
+	time_t deadline = details::now_ms() + CAPTURE_WAIT_MS;
+	while ( !monitor.captured() && details::now_ms() < deadline ) {
+		std::this_thread::yield();
+	}
+
+	if ( !monitor.captured() ) {
+		return;
+	}
+
+	int nframes = monitor.frameCount();
+	char** symbols = ::backtrace_symbols(monitor.frames(), nframes);
+	if ( !symbols ) {
+		return;
+	}
+
+	// Frame 0 is the capture itself and frame 1 the signal handler, skip both
+	for ( int i = 2; i < nframes; ++i ) {
+		info.backtrace.push_back(symbols[i]);
+	}
+
+	::free(symbols);
+}
+
+#undef CAPTURE_WAIT_MS
+
+}	// namespace asio
+}	// namespace lcy
@@ -0,0 +1,112 @@
+#ifndef __LCY_ASIO_WATCHDOG_H__
+#define __LCY_ASIO_WATCHDOG_H__
+
+#include <time.h>
+#include <mutex>
+#include <signal.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+
+#include "lcy/asio/src/details/loop_monitor.h"
+
+namespace lcy {
+namespace asio {
+
+class IOContext;
+
+/*
+* Watchdog detects event loops that have not finished an iteration within a threshold.
+*
+* Every ReactorService keeps a LoopMonitor up to date (a few relaxed stores per wakeup),
+* the watchdog thread samples the monitors of the watched contexts and, when one stays
+* inside the same iteration for longer than the threshold, reports the running handler
+* (descriptor and optional tag) together with a backtrace captured on the stalled thread.
+*
+* example :
+*
+*	lcy::asio::Watchdog watchdog(100, [](const lcy::asio::Watchdog::StallInfo& info){
+*		log(info.tag, info.elapsed_ms, info.backtrace);
+*	});
+*	watchdog.start();
+*
+*	lcy::asio::ThreadPool pool(4);
+*	pool.setWatchdog(&watchdog);
+*	pool.start();
+*
+*	// inside a handler
+*	LCY_ASIO_WATCHDOG_TAG("login handler");
+*/
+class Watchdog {
+public:
+	typedef time_t timeout_type;		// millisecond
+
+	struct StallInfo {
+		pthread_t thread;
+		timeout_type elapsed_ms;
+		int fd;
+		std::string tag;
+		std::vector<std::string> backtrace;
+	};
+
+	typedef std::function<void (const StallInfo&)> stall_op_type;
+
+	Watchdog(timeout_type threshold, stall_op_type stall_op = {});
+	~Watchdog();
+
+	void start();
+	void stop();
+
+	void watch(IOContext& ioc);
+	void unwatch(IOContext& ioc);
+
+	void setBacktrace(bool enable, int signum = SIGURG);
+	size_t stallCount() const;
+
+private:
+	Watchdog(const Watchdog&);
+	Watchdog& operator=(const Watchdog&);
+
+	void run();
+	void check(time_t now);
+	void report(details::LoopMonitor& monitor, time_t elapsed, StallInfo& info);
+
+private:
+	struct Watched {
+		details::LoopMonitor* monitor;
+		details::LoopMonitor::sequence_type sequence;
+		time_t since;
+		bool reported;
+	};
+
+	typedef std::mutex mutex_type;
+	typedef std::vector<Watched> watched_array_type;
+
+	timeout_type threshold_;
+	stall_op_type stall_op_;
+	bool backtrace_;
+	int signum_;
+
+	bool running_;
+	mutex_type mutex_;
+	std::condition_variable cond_;
+	std::thread th_;
+	watched_array_type watched_;
+	std::atomic<size_t> stall_count_;
+};
+
+}	// namespace asio
+}	// namespace lcy
+
+/*
+* Tags the enclosing handler scope, the watchdog reports it as "tag (file:line)".
+*/
+#define LCY_ASIO_WATCHDOG_TAG(tag)											\
+	::lcy::asio::details::LoopMonitor::Scope								\
+		LCY_ASIO_DETAILS_CONCAT(lcy_asio_watchdog_scope_, __LINE__)			\
+			(tag " (" __FILE__ ":" LCY_ASIO_DETAILS_STRINGIZE(__LINE__) ")")
+
+#endif	// __LCY_ASIO_WATCHDOG_H__
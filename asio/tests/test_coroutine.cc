@@ -0,0 +1,175 @@
+#include "../asio.hpp"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <signal.h>
+
+#ifndef LCY_ASIO_HAS_COROUTINE
+#error "test_coroutine must be built with C++20 coroutine support"
+#endif
+
+using namespace lcy;
+using asio::ip::TCP;
+using asio::ip::UDP;
+using asio::ip::Endpoint;
+
+static int failures = 0;
+
+#define CHECK(expr)															\
+	do {																	\
+		if ( !(expr) ) {													\
+			std::cout << "check failed : " #expr " ( line " << __LINE__ << " )" << std::endl;	\
+			++failures;														\
+		}																	\
+	} while ( 0 )
+
+asio::co::Task<void> echo_session(TCP::Socket& socket)
+{
+	char buf[1024];
+	while ( true ) {
+		asio::co::IOResult r = co_await asio::co::read(socket, asio::buffer(buf, sizeof(buf)));
+		if ( r.ec || r.nbytes == 0 ) {
+			co_return;
+		}
+
+		co_await asio::co::write(socket, asio::buffer(buf, r.nbytes));
+	}
+}
+
+asio::co::Task<void> echo_server(TCP::Socket& listener, TCP::Socket& peer)
+{
+	asio::errcode_type ec = co_await asio::co::accept(listener, peer);
+	CHECK(!ec);
+
+	peer.setDelay();
+	co_await echo_session(peer);
+}
+
+// One request / response, a fresh frame per call so the frame cache gets exercised
+asio::co::Task<size_t> roundtrip(TCP::Socket& socket, const std::string& msg)
+{
+	co_await asio::co::write(socket, asio::buffer(msg));
+
+	char buf[1024];
+	size_t received = 0;
+	while ( received < msg.size() ) {
+		asio::co::IOResult r = co_await asio::co::read(socket, asio::buffer(buf + received, sizeof(buf) - received));
+		if ( r.ec || r.nbytes == 0 ) {
+			break;
+		}
+		received += r.nbytes;
+	}
+
+	co_return received;
+}
+
+asio::co::Task<void> client(asio::IOContext& ioc, TCP::Socket& socket, const Endpoint& endpoint,
+							asio::IOContext& other, bool& done)
+{
+	socket.open(TCP::v4());
+	asio::errcode_type ec = co_await asio::co::connect(socket, endpoint);
+	CHECK(!ec);
+	socket.setDelay();
+
+	// tcp
+	std::string msg = "hello coroutine";
+	for ( int i = 0; i < 1000; ++i ) {
+		size_t n = co_await roundtrip(socket, msg);
+		CHECK(n == msg.size());
+	}
+	std::cout << "tcp echo : ok" << std::endl;
+
+	// timer
+	asio::SteadyTimer timer(ioc, 20);
+	asio::co::WaitResult w = co_await asio::co::wait(timer);
+	CHECK(!w.ec);
+	CHECK(w.elapsed >= 20);
+	std::cout << "timer : " << w.elapsed << " ms" << std::endl;
+
+	// signal
+	asio::SignalSet signal_set(ioc, SIGUSR1);
+	asio::SteadyTimer raise_timer(ioc, 1);
+	raise_timer.async_wait([](asio::errcode_type, asio::SteadyTimer::timeout_type){
+		::raise(SIGUSR1);
+	});
+	asio::co::SignalResult s = co_await asio::co::wait(signal_set);
+	CHECK(!s.ec);
+	CHECK(s.signum == SIGUSR1);
+	std::cout << "signal : " << s.signum << std::endl;
+
+	// cross context
+	std::thread::id home = std::this_thread::get_id();
+	co_await asio::co::post(other);
+	CHECK(std::this_thread::get_id() != home);
+	co_await asio::co::post(ioc);
+	CHECK(std::this_thread::get_id() == home);
+	std::cout << "post : ok" << std::endl;
+
+	done = true;
+	socket.shutdown();
+}
+
+asio::co::Task<void> udp_pingpong(UDP::Socket& server, UDP::Socket& client,
+								  const Endpoint& server_endpoint, bool& done)
+{
+	std::string msg = "datagram";
+	asio::co::IOResult r = co_await asio::co::send_to(client, server_endpoint, asio::buffer(msg));
+	CHECK(!r.ec && r.nbytes == msg.size());
+
+	char buf[64];
+	Endpoint from;
+	r = co_await asio::co::receive_from(server, from, asio::buffer(buf, sizeof(buf)));
+	CHECK(!r.ec && std::string(buf, r.nbytes) == msg);
+	std::cout << "udp : ok" << std::endl;
+
+	done = true;
+}
+
+int main() {
+	asio::IOContext ioc;
+
+	asio::ThreadPool pool(1);
+	pool.start();
+
+	TCP::Socket listener(ioc), peer(ioc), socket(ioc);
+	listener.open(TCP::v4());
+	listener.setReuseAddr();
+	listener.bind(Endpoint("127.0.0.1", 0));
+	listener.listen(16);
+
+	Endpoint endpoint;
+	listener.localAddr(endpoint);
+
+	UDP::Socket udp_server(ioc), udp_client(ioc);
+	udp_server.open(UDP::v4());
+	udp_server.bind(Endpoint("127.0.0.1", 40000 + (::getpid() % 20000)));
+	udp_client.open(UDP::v4());
+	Endpoint udp_endpoint("127.0.0.1", 40000 + (::getpid() % 20000));
+
+	bool tcp_done = false, udp_done = false;
+	asio::co::spawn(ioc, echo_server(listener, peer));
+	asio::co::spawn(ioc, client(ioc, socket, endpoint, pool.nextContext(), tcp_done));
+	asio::co::spawn(ioc, udp_pingpong(udp_server, udp_client, udp_endpoint, udp_done));
+
+	asio::SteadyTimer quit_timer(ioc, 10);
+	std::function<void (asio::errcode_type, asio::SteadyTimer::timeout_type)> poll;
+	poll = [&](asio::errcode_type, asio::SteadyTimer::timeout_type){
+		if ( tcp_done && udp_done ) {
+			ioc.quit();
+			return;
+		}
+		quit_timer.async_wait(poll);
+	};
+	quit_timer.async_wait(poll);
+
+	ioc.loop_wait();
+	pool.stop();
+
+	asio::details::FrameService& frames = asio::use_service<asio::details::FrameService>(ioc);
+	std::cout << "frames reused : " << frames.reusedFrames()
+			  << ", cached : " << frames.cachedFrames() << std::endl;
+	CHECK(frames.reusedFrames() >= 999);
+
+	return failures == 0 && tcp_done && udp_done ? 0 : 1;
+}
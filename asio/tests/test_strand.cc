@@ -0,0 +1,106 @@
+#include "../asio.hpp"
+
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <atomic>
+#include <memory>
+
+using namespace lcy;
+
+int main() {
+	const size_t producers = 4;
+	const size_t per_producer = 100000;
+
+	asio::ThreadPool pool(1);
+	pool.start();
+
+	asio::IOContext& ioc = pool.nextContext();
+	asio::Strand strand(ioc);
+
+	// Deliberately not atomic, the strand is the only synchronization
+	size_t counter = 0;
+	bool ordered = true;
+	bool on_loop = true;
+	std::vector<size_t> last(producers, 0);
+	std::atomic<size_t> finished(0);
+
+	std::vector<std::thread> threads;
+	for ( size_t p = 0; p < producers; ++p ) {
+		threads.push_back(std::thread([&, p](){
+			for ( size_t i = 1; i <= per_producer; ++i ) {
+				strand.dispatch([&, p, i](){
+					++counter;
+
+					// FIFO per producer
+					if ( last[p] + 1 != i ) {
+						ordered = false;
+					}
+					last[p] = i;
+
+					if ( !strand.running_in_this_thread() ) {
+						on_loop = false;
+					}
+
+					if ( i == per_producer ) {
+						++finished;
+					}
+				});
+			}
+		}));
+	}
+
+	for ( auto& th : threads ) {
+		th.join();
+	}
+
+	while ( finished.load() != producers ) {
+		std::this_thread::yield();
+	}
+
+	// dispatch from the loop thread runs inline, post is deferred
+	std::atomic<int> step(0);
+	int order = 0;
+	asio::post(ioc, [&](){
+		strand.post([&](){ order = order * 10 + 2; step = order; });
+		strand.dispatch([&](){ order = order * 10 + 1; });
+	});
+
+	while ( step.load() == 0 ) {
+		std::this_thread::yield();
+	}
+
+	// handlers still queued when the strand is destroyed are dropped
+	std::atomic<bool> running(false), release(false), dropped_ran(false), flushed(false);
+	std::unique_ptr<asio::Strand> doomed(new asio::Strand(ioc));
+	doomed->post([&](){
+		running = true;
+		while ( !release.load() ) {
+			std::this_thread::yield();
+		}
+	});
+	doomed->post([&](){ dropped_ran = true; });
+
+	while ( !running.load() ) {
+		std::this_thread::yield();
+	}
+	doomed.reset();
+	release = true;
+
+	asio::post(ioc, [&](){ flushed = true; });
+	while ( !flushed.load() ) {
+		std::this_thread::yield();
+	}
+
+	pool.stop();
+
+	std::cout << "counter : " << counter << std::endl;
+	std::cout << "ordered : " << ordered << std::endl;
+	std::cout << "on loop : " << on_loop << std::endl;
+	std::cout << "inline order : " << step.load() << std::endl;
+	std::cout << "dropped : " << !dropped_ran.load() << std::endl;
+
+	bool ok = counter == producers * per_producer && ordered && on_loop && step.load() == 12 &&
+			  !dropped_ran.load();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+#include "../asio.hpp"
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+
+using namespace lcy;
+
+void slow_handler()
+{
+	LCY_ASIO_WATCHDOG_TAG("slow handler");
+
+	// Blocks the IO thread well past the watchdog threshold
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+}
+
+int main() {
+	asio::Watchdog watchdog(100, [](const asio::Watchdog::StallInfo& info){
+		std::cout << "stall : " << info.elapsed_ms << " ms, "
+				  << "fd = " << info.fd << ", "
+				  << "tag = " << info.tag << std::endl;
+
+		for ( auto& frame : info.backtrace ) {
+			std::cout << "    " << frame << std::endl;
+		}
+	});
+	watchdog.start();
+
+	asio::ThreadPool pool(2);
+	pool.setWatchdog(&watchdog);
+	pool.start();
+
+	asio::post(pool.nextContext(), slow_handler);
+	asio::post(pool.nextContext(), [](){
+		std::cout << "fast handler" << std::endl;
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+	pool.stop();
+	watchdog.stop();
+
+	std::cout << "stall count : " << watchdog.stallCount() << std::endl;
+
+	return watchdog.stallCount() == 1 ? 0 : 1;
+}
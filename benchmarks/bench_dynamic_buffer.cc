@@ -0,0 +1,150 @@
+#include "harness.hpp"
+
+#include "lcy/asio/asio.hpp"
+
+#include <string.h>
+
+/*
+* DynamicBuffer integer codecs, one value per iteration.
+* Values are written and consumed in batches so the buffer never grows unbounded.
+*/
+
+#define BATCH 1024
+
+template <typename T, void (lcy::asio::DynamicBuffer::*Write)(T)>
+static void write_case(lcy::bench::State& state)
+{
+	lcy::asio::DynamicBuffer buffer;
+	buffer.reserve(BATCH * sizeof(T));
+
+	T value = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		(buffer.*Write)(value++);
+
+		if ( buffer.dataBytes() >= BATCH * sizeof(T) ) {
+			buffer.read(buffer.dataBytes());
+		}
+	}
+
+	lcy::bench::DoNotOptimize(buffer.dataBytes());
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * sizeof(T));
+}
+
+template <typename T, bool (lcy::asio::DynamicBuffer::*Read)(T*)>
+static void read_case(lcy::bench::State& state)
+{
+	lcy::asio::DynamicBuffer buffer;
+
+	T source[BATCH];
+	for ( size_t i = 0; i < BATCH; ++i ) {
+		source[i] = (T)i;
+	}
+
+	T value = 0, sum = 0;
+	size_t remaining = state.iterations();
+	while ( remaining > 0 ) {
+		size_t batch = remaining < BATCH ? remaining : BATCH;
+
+		buffer.reserve(batch * sizeof(T));
+		::memcpy(buffer.writeBegin(), source, batch * sizeof(T));
+		buffer.write(batch * sizeof(T));
+
+		for ( size_t i = 0; i < batch; ++i ) {
+			(buffer.*Read)(&value);
+			sum += value;
+		}
+
+		remaining -= batch;
+	}
+
+	lcy::bench::DoNotOptimize(sum);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * sizeof(T));
+}
+
+template <typename T, bool (lcy::asio::DynamicBuffer::*Peek)(T*, size_t)>
+static void peek_case(lcy::bench::State& state)
+{
+	lcy::asio::DynamicBuffer buffer;
+	buffer.reserve(BATCH * sizeof(T));
+	for ( size_t i = 0; i < BATCH; ++i ) {
+		T v = (T)i;
+		::memcpy(buffer.writeBegin() + i * sizeof(T), &v, sizeof(T));
+	}
+	buffer.write(BATCH * sizeof(T));
+
+	T value = 0, sum = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		(buffer.*Peek)(&value, (i % BATCH) * sizeof(T));
+		sum += value;
+	}
+
+	lcy::bench::DoNotOptimize(sum);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * sizeof(T));
+}
+
+using lcy::asio::DynamicBuffer;
+
+static void BM_dynamic_buffer_write_uint8(lcy::bench::State& state)
+{
+	write_case<uint8_t, &DynamicBuffer::writeUint8>(state);
+}
+LCY_BENCHMARK(BM_dynamic_buffer_write_uint8);
+
+static void BM_dynamic_buffer_write_uint16(lcy::bench::State& state)
+{
+	write_case<uint16_t, &DynamicBuffer::writeUint16>(state);
+}
+LCY_BENCHMARK(BM_dynamic_buffer_write_uint16);
+
+static void BM_dynamic_buffer_write_uint32(lcy::bench::State& state)
+{
+	write_case<uint32_t, &DynamicBuffer::writeUint32>(state);
+}
+LCY_BENCHMARK(BM_dynamic_buffer_write_uint32);
+
+static void BM_dynamic_buffer_write_uint64(lcy::bench::State& state)
+{
+	write_case<uint64_t, &DynamicBuffer::writeUint64>(state);
+}
+LCY_BENCHMARK(BM_dynamic_buffer_write_uint64);
+
+static void BM_dynamic_buffer_read_uint8(lcy::bench::State& state)
+{
+	read_case<uint8_t, &DynamicBuffer::readUint8>(state);
+}
+LCY_BENCHMARK(BM_dynamic_buffer_read_uint8);
+
+static void BM_dynamic_buffer_read_uint16(lcy::bench::State& state)
+{
+	read_case<uint16_t, &DynamicBuffer::readUint16>(state);
+}
+LCY_BENCHMARK(BM_dynamic_buffer_read_uint16);
+
+static void BM_dynamic_buffer_read_uint32(lcy::bench::State& state)
+{
+	read_case<uint32_t, &DynamicBuffer::readUint32>(state);
+}
+LCY_BENCHMARK(BM_dynamic_buffer_read_uint32);
+
+static void BM_dynamic_buffer_read_uint64(lcy::bench::State& state)
+{
+	read_case<uint64_t, &DynamicBuffer::readUint64>(state);
+}
+LCY_BENCHMARK(BM_dynamic_buffer_read_uint64);
+
+static void BM_dynamic_buffer_peek_uint32(lcy::bench::State& state)
+{
+	peek_case<uint32_t, &DynamicBuffer::peekUint32>(state);
+}
+LCY_BENCHMARK(BM_dynamic_buffer_peek_uint32);
+
+static void BM_dynamic_buffer_peek_uint64(lcy::bench::State& state)
+{
+	peek_case<uint64_t, &DynamicBuffer::peekUint64>(state);
+}
+LCY_BENCHMARK(BM_dynamic_buffer_peek_uint64);
+
+#undef BATCH
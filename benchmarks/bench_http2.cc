@@ -0,0 +1,159 @@
+#include "harness.hpp"
+
+#include "lcy/asio/asio.hpp"
+#include "lcy/protocol/protocol.hpp"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <string.h>
+
+/*
+* HTTP/2 : HPACK coding and one request through a ServerSession.
+*
+* The header blocks are those of a browser GET : the first one fills the dynamic
+* table, the repeats are mostly indexes.
+*/
+
+namespace {
+
+namespace http = lcy::protocol::http;
+namespace http2 = lcy::protocol::http2;
+using lcy::protocol::StringView;
+
+typedef std::vector<std::pair<std::string, std::string> > field_list;
+
+static const field_list kRequest = {
+	{ ":method", "GET" },
+	{ ":scheme", "https" },
+	{ ":path", "/api/v1/users/12345?fields=name,email" },
+	{ ":authority", "www.example.com" },
+	{ "user-agent", "Mozilla/5.0 (X11; Linux x86_64; rv:120.0) Gecko/20100101 Firefox/120.0" },
+	{ "accept", "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8" },
+	{ "accept-language", "en-US,en;q=0.5" },
+	{ "accept-encoding", "gzip, deflate, br" },
+	{ "cookie", "session=0123456789abcdef; theme=dark" },
+};
+
+static std::string encode_block(http2::HpackEncoder& encoder)
+{
+	std::string block;
+	for ( const auto& f : kRequest ) {
+		encoder.encode(f.first, f.second, block);
+	}
+	return block;
+}
+
+}	// namespace
+
+// arg(0) : 0 the first block, literals with Huffman strings, 1 a repeat, indexes
+static void BM_hpack_decode(lcy::bench::State& state)
+{
+	http2::HpackEncoder encoder;
+	std::string first = encode_block(encoder);
+	std::string repeat = encode_block(encoder);
+	const std::string& block = state.arg(0) == 0 ? first : repeat;
+
+	// a repeat adds nothing to the table : one decoder holding the first block does
+	http2::HpackDecoder primed;
+	primed.decode(first.data(), first.size(), [](StringView, StringView){ return true; });
+
+	size_t fields = 0;
+	auto count = [&fields](StringView name, StringView value){
+		fields += name.size() + value.size();
+		return true;
+	};
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		if ( state.arg(0) == 0 ) {
+			http2::HpackDecoder decoder;
+			decoder.decode(block.data(), block.size(), count);
+		} else {
+			primed.decode(block.data(), block.size(), count);
+		}
+	}
+
+	lcy::bench::DoNotOptimize(fields);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * block.size());
+	state.setCounter("block_bytes", (double)block.size());
+}
+LCY_BENCHMARK(BM_hpack_decode)->arg(0)->arg(1);
+
+// the block of a response head, the table already holds its fields
+static void BM_hpack_encode_response(lcy::bench::State& state)
+{
+	http2::HpackEncoder encoder;
+	std::string block;
+	size_t bytes = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		block.clear();
+		encoder.encode(":status", "200", block);
+		encoder.encode("content-type", "application/json", block);
+		encoder.encode("server", "lcy", block);
+		encoder.encode("date", "Mon, 16 Oct 2023 08:00:00 GMT", block);
+		encoder.encode("content-length", "1234", block);
+		bytes += block.size();
+	}
+
+	lcy::bench::DoNotOptimize(bytes);
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_hpack_encode_response);
+
+static void BM_huffman_decode(lcy::bench::State& state)
+{
+	std::string plain, coded, out;
+	for ( size_t i = 0; plain.size() < (size_t)state.arg(0); ++i ) {
+		plain += kRequest[i % kRequest.size()].second;
+	}
+	plain.resize((size_t)state.arg(0));
+	http2::HuffmanEncode(plain, coded);
+
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		out.clear();
+		http2::HuffmanDecode(coded, out);
+	}
+
+	lcy::bench::DoNotOptimize(out);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * plain.size());
+}
+LCY_BENCHMARK(BM_huffman_decode)->arg(64)->arg(1024);
+
+// HEADERS of a GET in, HEADERS and DATA of its response out, on one connection
+static void BM_http2_session_request(lcy::bench::State& state)
+{
+	std::string body((size_t)state.arg(0), 'b');
+	http2::ServerSession session([&body](const http::RequestView&, http::Response& response){
+		response.setBody(body);
+	});
+	http2::HpackEncoder encoder;
+	lcy::asio::DynamicBuffer in, out;
+
+	in.reserve(http2::CLIENT_PREFACE_BYTES);
+	::memcpy(in.writeBegin(), http2::CLIENT_PREFACE, http2::CLIENT_PREFACE_BYTES);
+	in.write(http2::CLIENT_PREFACE_BYTES);
+	http2::WriteSettings(in, nullptr, nullptr, 0);
+	session.start(out);
+
+	uint32_t id = 1;
+	size_t bytes = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i, id += 2 ) {
+		std::string block = encode_block(encoder);
+		http2::WriteHeaders(in, id, block, true);
+		if ( !body.empty() ) {
+			http2::WriteWindowUpdate(in, 0, (uint32_t)body.size());		// what the client got
+		}
+		in.read(session.receive(in.readBegin(), in.dataBytes(), out));
+		session.send(out, 1 << 20);
+		bytes += out.dataBytes();
+		out.read(out.dataBytes());
+		if ( id > 0x7FFFFFF0 || session.over() ) {
+			break;		// stream ids run out
+		}
+	}
+
+	lcy::bench::DoNotOptimize(bytes);
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_http2_session_request)->arg(0)->arg(1024);
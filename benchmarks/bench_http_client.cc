@@ -0,0 +1,96 @@
+#include "harness.hpp"
+
+#include "lcy/asio/asio.hpp"
+#include "lcy/protocol/protocol.hpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+
+/*
+* http::Client against http::Server over loopback, the server on one pool thread and
+* the client on the benchmark thread. One iteration is one request / response, 16 of
+* them in flight.
+*
+* The reference opens a connection per request ( Connection: close ), as the hand
+* rolled service-to-service clients did. The pooled cases keep the connections of
+* the host open, arg(0) is the pipelining depth on each of them.
+*/
+
+namespace {
+
+namespace http = lcy::protocol::http;
+
+using lcy::asio::ip::Endpoint;
+
+static const size_t kInFlight = 16;
+
+static double run_client(lcy::asio::IOContext& ioc, http::Client& client, const Endpoint& endpoint,
+						 size_t total, bool close)
+{
+	size_t issued = 0, done = 0;
+	std::function<void ()> issue = [&](){
+		http::Request request;
+		request.setMethod(http::method::GET);
+		request.setUri("/plaintext");
+		if ( close ) {
+			request.setHeader(http::field::CONNECTION, "close");
+		}
+
+		++issued;
+		client.request(endpoint, std::move(request), [&](lcy::asio::errcode_type, http::Response&){
+			if ( ++done == total ) {
+				ioc.quit();
+			} else if ( issued < total ) {
+				issue();
+			}
+		});
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	for ( size_t i = 0; i < kInFlight && i < total; ++i ) {
+		issue();
+	}
+	ioc.loop_wait();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static double run_case(size_t total, size_t depth, bool close)
+{
+	lcy::asio::IOContext ioc;
+	http::Server server(ioc, 1);
+	server.setHandler([](const http::RequestView&, http::Response& response){
+		response.setHeader(http::field::CONTENT_TYPE, "text/plain");
+		response.setBody("Hello, World!");
+	});
+	server.start(Endpoint("127.0.0.1", 0));
+
+	Endpoint endpoint;
+	server.localAddr(endpoint);
+
+	double elapsed = 0;
+	{
+		http::Client client(ioc);
+		client.setMaxConnectionsPerHost(close ? kInFlight : kInFlight / depth);
+		client.setPipelining(depth);
+		elapsed = run_client(ioc, client, endpoint, total, close);
+	}
+	server.stop();
+	return elapsed;
+}
+
+}	// namespace
+
+static void BM_http_client_connect_per_request_reference(lcy::bench::State& state)
+{
+	state.setIterationTime(run_case(state.iterations(), 1, true));
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_http_client_connect_per_request_reference);
+
+static void BM_http_client_pooled(lcy::bench::State& state)
+{
+	state.setIterationTime(run_case(state.iterations(), (size_t)state.arg(0), false));
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_http_client_pooled)->arg(1)->arg(16);
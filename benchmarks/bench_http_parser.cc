@@ -0,0 +1,302 @@
+#include "harness.hpp"
+
+#include "lcy/protocol/protocol.hpp"
+
+#include <string>
+#include <regex>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+* HTTP request parsing, one complete request per iteration.
+* arg(0) is the number of extra header fields on top of a browser like set.
+*
+* bytes_per_cycle uses the time stamp counter ( reference cycles, not core
+* cycles under frequency scaling ), it is 0 where no such counter exists.
+*/
+
+using namespace lcy::protocol;
+
+static std::string make_request(int64_t extra_headers)
+{
+	std::string data = "GET /static/js/app.3f2a9c.js?v=20240101 HTTP/1.1\r\n"
+					   "Host: 127.0.0.1:8080\r\n"
+					   "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+					   "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+					   "Accept-Encoding: gzip, deflate, br\r\n"
+					   "Accept-Language: en-US,en;q=0.9\r\n"
+					   "Connection: keep-alive\r\n"
+					   "Cookie: session=8c1d0e5a4b7f4e2a9d3c6b1a0f9e8d7c; theme=dark\r\n";
+
+	for ( int64_t i = 0; i < extra_headers; ++i ) {
+		data += "X-Custom-Header-" + std::to_string(i) + ": value-" + std::to_string(i) + "\r\n";
+	}
+	data += "\r\n";
+
+	return data;
+}
+
+static uint64_t cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+static void set_bytes_per_cycle(lcy::bench::State& state, size_t bytes, uint64_t cycles)
+{
+	state.setCounter("bytes_per_cycle", cycles ? (double)bytes / cycles : 0.0);
+}
+
+static void BM_http_parse_request(lcy::bench::State& state)
+{
+	std::string data = make_request(state.arg(0));
+
+	http::Parser parser;
+	http::Request request;
+	size_t ok = 0;
+	uint64_t start = cycles();
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		parser.reset();
+		request.clear();
+		ok += parser.parse(&data[0], data.length(), request) == http::Parser::RetCode::READY;
+	}
+	uint64_t used = cycles() - start;
+
+	lcy::bench::DoNotOptimize(ok);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * data.length());
+	set_bytes_per_cycle(state, state.iterations() * data.length(), used);
+}
+LCY_BENCHMARK(BM_http_parse_request)->arg(0)->arg(16);
+
+static void parse_view_case(lcy::bench::State& state, int64_t extra_headers)
+{
+	std::string data = make_request(extra_headers);
+
+	http::Parser parser;
+	http::RequestView view;
+	size_t ok = 0;
+	uint64_t start = cycles();
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		parser.reset();
+		ok += parser.parse(&data[0], data.length(), view) == http::Parser::RetCode::READY;
+	}
+	uint64_t used = cycles() - start;
+
+	lcy::bench::DoNotOptimize(ok);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * data.length());
+	set_bytes_per_cycle(state, state.iterations() * data.length(), used);
+}
+
+static void BM_http_parse_request_view(lcy::bench::State& state)
+{
+	parse_view_case(state, state.arg(0));
+}
+LCY_BENCHMARK(BM_http_parse_request_view)->arg(0)->arg(16);
+
+/*
+* Scan kernels, arg(0) is the scan_level ( 0 scalar, 1 sse2, 2 avx2 ).
+* Levels the CPU lacks run at the best supported one, see the "level" counter.
+*/
+template <typename Scan>
+static void scan_case(lcy::bench::State& state, Scan scan)
+{
+	http::scan_level_type saved = http::ScanLevel();
+	http::scan_level_type level = http::SetScanLevel((http::scan_level_type)state.arg(0));
+
+	std::string data = make_request(16);
+	const char* begin = data.data();
+	const char* end = begin + data.length();
+
+	size_t hits = 0;
+	uint64_t start = cycles();
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		hits += scan(begin, end);
+	}
+	uint64_t used = cycles() - start;
+
+	http::SetScanLevel(saved);
+
+	lcy::bench::DoNotOptimize(hits);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * data.length());
+	state.setCounter("level", (double)(uint8_t)level);
+	set_bytes_per_cycle(state, state.iterations() * data.length(), used);
+}
+
+// walk every line of the header block
+static void BM_http_scan_crlf(lcy::bench::State& state)
+{
+	scan_case(state, [](const char* begin, const char* end){
+		size_t lines = 0;
+		for ( const char* p = begin; (p = http::FindCRLF(p, end)); p += 2 ) {
+			++lines;
+		}
+		return lines;
+	});
+}
+LCY_BENCHMARK(BM_http_scan_crlf)->arg(0)->arg(1)->arg(2);
+
+// colon of every header field, as headerSplit does after the line is known
+static void BM_http_scan_colon(lcy::bench::State& state)
+{
+	scan_case(state, [](const char* begin, const char* end){
+		size_t colons = 0;
+		for ( const char* p = begin; (p = http::FindChar(p, end, ':')); ++p ) {
+			++colons;
+		}
+		return colons;
+	});
+}
+LCY_BENCHMARK(BM_http_scan_colon)->arg(0)->arg(1)->arg(2);
+
+// whole zero copy parse on top of each kernel set
+static void BM_http_parse_request_view_scan(lcy::bench::State& state)
+{
+	http::scan_level_type saved = http::ScanLevel();
+	http::scan_level_type level = http::SetScanLevel((http::scan_level_type)state.arg(0));
+
+	parse_view_case(state, 16);
+	state.setCounter("level", (double)(uint8_t)level);
+
+	http::SetScanLevel(saved);
+}
+LCY_BENCHMARK(BM_http_parse_request_view_scan)->arg(0)->arg(1)->arg(2);
+
+/*
+* What every request line used to cost before validation became table driven :
+* the two std::regex_match calls of the old parser, on their own.
+*/
+static void BM_http_validate_regex_reference(lcy::bench::State& state)
+{
+	static std::regex uri_regex(R"(^/\S*$)");
+	static std::regex version_regex(R"(^HTTP/\d+\.\d+$)");
+
+	std::string uri = "/static/js/app.3f2a9c.js?v=20240101";
+	std::string version = "HTTP/1.1";
+
+	size_t ok = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		ok += std::regex_match(uri, uri_regex) && std::regex_match(version, version_regex);
+	}
+
+	lcy::bench::DoNotOptimize(ok);
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_http_validate_regex_reference);
+
+/*
+* A header block arriving arg(0) bytes at a time, the buffer always restarts at
+* the first byte of the message as the parser expects. Time per byte stays flat
+* when nothing is rescanned.
+*/
+static void BM_http_parse_trickle(lcy::bench::State& state)
+{
+	std::string data = "GET / HTTP/1.1\r\nCookie: " + std::string(16 * 1024, 'x') + "\r\n\r\n";
+	size_t step = (size_t)state.arg(0);
+
+	http::Parser parser;
+	http::Request request;
+	size_t ok = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		parser.reset();
+		request.clear();
+
+		http::Parser::RetCode retcode = http::Parser::RetCode::WAITING_DATA;
+		for ( size_t len = step; retcode == http::Parser::RetCode::WAITING_DATA; len += step ) {
+			retcode = parser.parse(&data[0], std::min(len, data.length()), request);
+		}
+		ok += retcode == http::Parser::RetCode::READY;
+	}
+
+	lcy::bench::DoNotOptimize(ok);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * data.length());
+}
+LCY_BENCHMARK(BM_http_parse_trickle)->arg(16)->arg(256)->arg(4096);
+
+/*
+* A 1 MiB chunked upload in 16 KiB chunks, arriving in 16 KiB reads. The collecting
+* parse copies every chunk into the body it builds and keeps the whole message
+* buffered, parseBody() hands each chunk out in place and the buffer drains as it goes.
+*/
+static std::string make_chunked_upload()
+{
+	std::string data = "PUT /upload HTTP/1.1\r\nHost: 127.0.0.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+	std::string chunk(16 * 1024, 'u');
+	for ( int i = 0; i < 64; ++i ) {
+		data += "4000\r\n" + chunk + "\r\n";
+	}
+	data += "0\r\n\r\n";
+	return data;
+}
+
+static const size_t kUploadRead = 16 * 1024;
+
+static void BM_http_parse_chunked_collect(lcy::bench::State& state)
+{
+	std::string data = make_chunked_upload();
+
+	http::Parser parser;
+	http::RequestView view;
+	size_t ok = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		parser.reset();
+		// the buffer grows by one read at a time and always starts at the message
+		for ( size_t len = kUploadRead; ; len += kUploadRead ) {
+			len = std::min(len, data.length());
+			http::Parser::RetCode retcode = parser.parse(&data[0], len, view);
+			if ( retcode != http::Parser::RetCode::WAITING_DATA ) {
+				ok += retcode == http::Parser::RetCode::READY;
+				break;
+			}
+		}
+	}
+
+	lcy::bench::DoNotOptimize(ok);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * data.length());
+}
+LCY_BENCHMARK(BM_http_parse_chunked_collect);
+
+static void BM_http_parse_chunked_stream(lcy::bench::State& state)
+{
+	std::string data = make_chunked_upload();
+
+	http::Parser parser;
+	http::RequestView view;
+	size_t received = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		parser.reset();
+		parser.parseHead(&data[0], data.length(), view);
+		size_t pos = parser.nparse();
+
+		// only the bytes not consumed yet are passed, never more than one read ahead
+		size_t end = std::min(pos + kUploadRead, data.length());
+		while ( true ) {
+			lcy::protocol::StringView piece;
+			size_t nparse = 0;
+			http::Parser::RetCode retcode = parser.parseBody(&data[pos], end - pos, piece, nparse);
+			received += piece.size();
+			pos += nparse;
+			if ( retcode != http::Parser::RetCode::WAITING_DATA ) {
+				break;
+			}
+			if ( piece.empty() ) {
+				end = std::min(end + kUploadRead, data.length());
+			}
+		}
+	}
+
+	lcy::bench::DoNotOptimize(received);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * data.length());
+}
+LCY_BENCHMARK(BM_http_parse_chunked_stream);
@@ -0,0 +1,90 @@
+#include "harness.hpp"
+
+#include "lcy/protocol/protocol.hpp"
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+/*
+* Route lookup over a REST like table of about fifty routes, one lookup per
+* iteration. The reference is the exact match map Servlet used before the router :
+* a std::string key built from the URI and a copy of the std::function.
+*/
+
+using namespace lcy::protocol;
+
+namespace {
+
+static const char* kResources[] = {
+	"users", "posts", "comments", "orders", "products", "carts", "invoices",
+	"payments", "shipments", "reviews",
+};
+
+static void for_each_route(const std::function<void (http::method_type, const std::string&)>& func)
+{
+	for ( const char* resource : kResources ) {
+		std::string base = std::string("/api/v1/") + resource;
+		func(http::method::GET, base);
+		func(http::method::POST, base);
+		func(http::method::GET, base + "/:id");
+		func(http::method::PUT, base + "/:id");
+		func(http::method::GET, base + "/:id/history");
+	}
+}
+
+}	// namespace
+
+static void BM_http_route_unordered_map_reference(lcy::bench::State& state)
+{
+	typedef std::function<void (const http::Request&, http::Response&)> function_type;
+	std::unordered_map<std::string, function_type> routes;
+	for_each_route([&](http::method_type, const std::string& pattern){
+		routes[pattern] = [](const http::Request&, http::Response&){};
+	});
+
+	// the map only knows exact paths, the query has to go first
+	const char uri[] = "/api/v1/shipments?page=2";
+	size_t found = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		lcy::protocol::StringView path = http::Router::Path(uri);
+		std::string key(path.data(), path.size());
+		auto iter = routes.find(key);
+		function_type func = iter != routes.end() ? iter->second : function_type();
+		found += (bool)func;
+	}
+
+	lcy::bench::DoNotOptimize(found);
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_http_route_unordered_map_reference);
+
+static void router_case(lcy::bench::State& state, const char* uri)
+{
+	http::Servlet servlet;
+	for_each_route([&](http::method_type method, const std::string& pattern){
+		servlet.setFunction(method, pattern, [](const http::Request&, http::Response&){});
+	});
+
+	http::RouteParams params;
+	size_t found = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		found += servlet.findFunction(http::method::GET, uri, params) != nullptr;
+	}
+
+	lcy::bench::DoNotOptimize(found);
+	state.setItemsProcessed(state.iterations());
+}
+
+static void BM_http_route_static(lcy::bench::State& state)
+{
+	router_case(state, "/api/v1/shipments?page=2");
+}
+LCY_BENCHMARK(BM_http_route_static);
+
+// the map above has no equivalent : it would need one key per id
+static void BM_http_route_params(lcy::bench::State& state)
+{
+	router_case(state, "/api/v1/shipments/1234567/history");
+}
+LCY_BENCHMARK(BM_http_route_params);
@@ -0,0 +1,408 @@
+#include "harness.hpp"
+
+#include "lcy/asio/asio.hpp"
+#include "lcy/protocol/protocol.hpp"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+* Loopback HTTP/1.1 keep-alive load against a server on one pool thread, the
+* clients run on the benchmark thread. One iteration is one request / response.
+*
+* The reference case is the connection the HTTP example used before http::Server
+* ( one request per read, Response::dump() into a string, one write per response ),
+* it can only be driven with one request in flight : the requests it leaves in its
+* buffer wait for a readiness event that never comes.
+*/
+
+namespace {
+
+namespace http = lcy::protocol::http;
+
+using lcy::asio::ip::TCP;
+using lcy::asio::ip::Endpoint;
+
+static const char kRequest[] =
+	"GET /plaintext HTTP/1.1\r\n"
+	"Host: 127.0.0.1\r\n"
+	"User-Agent: lcy-bench\r\n"
+	"Accept: */*\r\n"
+	"\r\n";
+
+static void fill_response(http::Response& response)
+{
+	response.setHeader(http::field::SERVER, "lcy");
+	response.setHeader(http::field::CONTENT_TYPE, "text/plain");
+	response.setBody("Hello, World!");
+}
+
+// The former example connection, kept as it was apart from the logging
+class ExampleConnection :
+	public std::enable_shared_from_this<ExampleConnection>
+{
+public:
+	ExampleConnection(lcy::asio::IOContext& ioc, std::atomic<size_t>& alive) :
+		socket_(ioc),
+		alive_(alive)
+	{
+		++alive_;
+	}
+
+	~ExampleConnection()
+	{
+		--alive_;
+	}
+
+	TCP::Socket& socket() { return socket_; }
+
+	void start_read()
+	{
+		buffer_.reserve(4096 * 2);
+		auto buf = lcy::asio::buffer(buffer_.writeBegin(), buffer_.availableBytes());
+
+		auto self = shared_from_this();
+		socket_.async_read(buf, [this, self](lcy::asio::errcode_type ec, size_t nread){
+			if ( ec || nread == 0 ) {
+				socket_.shutdown();
+				return;
+			}
+
+			buffer_.write(nread);
+			auto retcode = parser_.parse(buffer_.readBegin(), buffer_.dataBytes(), request_);
+			if ( retcode == http::Parser::RetCode::ERROR ) {
+				socket_.shutdown();
+				return;
+			} else if ( retcode == http::Parser::RetCode::READY ) {
+				http::Response response;
+				response.setVersion(request_.version());
+				response.setState(http::state::OK);
+				fill_response(response);
+				// dump() writes the headers as they are, the handler has to add the length
+				response.setHeader(http::field::CONTENT_LENGTH, std::to_string(response.body().size()));
+				start_send(response.dump());
+
+				buffer_.read(parser_.nparse());
+				request_.clear();
+				parser_.reset();
+			}
+
+			start_read();
+		});
+	}
+
+private:
+	void start_send(std::string msg)
+	{
+		bool empty = queue_.empty();
+		queue_.push_back(std::move(msg));
+		if ( empty ) {
+			start_send_impl();
+		}
+	}
+
+	void start_send_impl()
+	{
+		auto buf = lcy::asio::buffer(queue_.front().c_str(), queue_.front().length());
+		auto self = shared_from_this();
+		socket_.async_write(buf, [this, self](lcy::asio::errcode_type ec, size_t){
+			if ( ec ) {
+				socket_.shutdown();
+				return;
+			}
+			queue_.pop_front();
+			if ( !queue_.empty() ) {
+				start_send_impl();
+			}
+		});
+	}
+
+private:
+	TCP::Socket socket_;
+	lcy::asio::DynamicBuffer buffer_;
+	http::Parser parser_;
+	http::Request request_;
+	std::deque<std::string> queue_;
+	std::atomic<size_t>& alive_;
+};
+
+// TCPServer<ExampleConnection> of examples/tcp_server.hpp
+class ExampleServer {
+public:
+	ExampleServer(lcy::asio::IOContext& ioc) :
+		acceptor_(ioc),
+		pool_(1),
+		pending_ioc_(nullptr),
+		alive_(0)
+	{
+	}
+
+	~ExampleServer()
+	{
+		acceptor_.cancel();
+		// the socket of the pending connection belongs to the pool loop, release it there
+		lcy::asio::post(*pending_ioc_, std::bind([](std::shared_ptr<ExampleConnection>&){},
+												 std::move(pending_)));
+		// the clients are gone, every connection sees EOF and releases itself
+		while ( alive_.load() != 0 ) {
+			std::this_thread::yield();
+		}
+		pool_.stop();
+	}
+
+	void start(Endpoint& endpoint)
+	{
+		pool_.start();
+		acceptor_.setup(Endpoint("127.0.0.1", 0));
+		acceptor_.localAddr(endpoint);
+		accept();
+	}
+
+private:
+	void accept()
+	{
+		lcy::asio::IOContext& ioc = pool_.nextContext();
+		pending_ = std::make_shared<ExampleConnection>(ioc, alive_);
+		pending_ioc_ = &ioc;
+		acceptor_.async_accept(pending_->socket(), [this, &ioc](lcy::asio::errcode_type ec){
+			if ( ec ) {
+				return;
+			}
+			std::shared_ptr<ExampleConnection> conn = std::move(pending_);
+			lcy::asio::post(ioc, [conn](){ conn->start_read(); });
+			accept();
+		});
+	}
+
+private:
+	TCP::Acceptor acceptor_;
+	lcy::asio::ThreadPool pool_;
+	std::shared_ptr<ExampleConnection> pending_;
+	lcy::asio::IOContext* pending_ioc_;
+	std::atomic<size_t> alive_;
+};
+
+/*
+* Keeps `depth` requests in flight until the shared budget is spent, the requests
+* released by one read go out in one write.
+*/
+class Client {
+public:
+	Client(lcy::asio::IOContext& ioc, size_t depth, size_t& budget, size_t& done) :
+		socket_(ioc),
+		depth_(depth),
+		inflight_(0),
+		budget_(budget),
+		done_(done),
+		writing_(false)
+	{
+	}
+
+	TCP::Socket& socket() { return socket_; }
+
+	void run()
+	{
+		issue();
+		read();
+	}
+
+private:
+	void issue()
+	{
+		while ( inflight_ < depth_ && budget_ > 0 ) {
+			pending_.append(kRequest, sizeof(kRequest) - 1);
+			++inflight_;
+			--budget_;
+		}
+		write();
+	}
+
+	void write()
+	{
+		if ( writing_ || pending_.empty() ) {
+			return;
+		}
+		writing_ = true;
+		sending_.swap(pending_);
+		pending_.clear();
+
+		socket_.async_write(lcy::asio::buffer(sending_.data(), sending_.size()),
+				[this](lcy::asio::errcode_type ec, size_t){
+			writing_ = false;
+			if ( !ec ) {
+				write();
+			}
+		});
+	}
+
+	void read()
+	{
+		in_.reserve(16 * 1024);
+		socket_.async_read(lcy::asio::buffer(in_.writeBegin(), in_.availableBytes()),
+				[this](lcy::asio::errcode_type ec, size_t nread){
+			if ( ec || nread == 0 ) {
+				return;
+			}
+			in_.write(nread);
+
+			while ( in_.dataBytes() > 0 ) {
+				http::Parser::RetCode retcode = parser_.parse(in_.readBegin(), in_.dataBytes(), response_);
+				if ( retcode != http::Parser::RetCode::READY ) {
+					break;
+				}
+				in_.read(parser_.nparse());
+				parser_.reset();
+				response_.clear();
+
+				--inflight_;
+				++done_;
+			}
+
+			issue();
+			if ( inflight_ > 0 || budget_ > 0 ) {
+				read();
+			} else {
+				socket_.context().quit();
+			}
+		});
+	}
+
+private:
+	TCP::Socket socket_;
+	size_t depth_;
+	size_t inflight_;
+	size_t& budget_;
+	size_t& done_;
+	bool writing_;
+	std::string pending_;
+	std::string sending_;
+	lcy::asio::DynamicBuffer in_;
+	http::Parser parser_;
+	http::Response response_;
+};
+
+typedef std::unique_ptr<Client> client_ptr;
+
+// Connects `conns` clients, then runs `requests` requests through them
+static double run_clients(lcy::asio::IOContext& ioc, const Endpoint& endpoint,
+						  size_t conns, size_t depth, size_t requests)
+{
+	size_t budget = requests, done = 0, connected = 0;
+	std::vector<client_ptr> clients;
+	for ( size_t i = 0; i < conns; ++i ) {
+		clients.push_back(client_ptr(new Client(ioc, depth, budget, done)));
+	}
+
+	for ( auto& client : clients ) {
+		client->socket().open(TCP::v4());
+		client->socket().async_connect(endpoint, [&, conns](lcy::asio::errcode_type ec){
+			if ( !ec ) {
+				client->socket().setDelay();
+			}
+			if ( ++connected == conns ) {
+				ioc.quit();
+			}
+		});
+	}
+	ioc.loop_wait();
+
+	lcy::bench::clock_type::time_point start = lcy::bench::clock_type::now();
+	for ( auto& client : clients ) {
+		client->run();
+	}
+	// the last client to finish its share quits, the others may still wait
+	while ( done < requests ) {
+		ioc.loop_wait();
+	}
+	double elapsed = lcy::bench::ElapsedSeconds(start);
+
+	clients.clear();
+	return elapsed;
+}
+
+}	// namespace
+
+static void BM_http_server_example_reference(lcy::bench::State& state)
+{
+	size_t conns = (size_t)state.arg(0);
+
+	lcy::asio::IOContext ioc;
+	Endpoint endpoint;
+	double elapsed = 0;
+	{
+		ExampleServer server(ioc);
+		server.start(endpoint);
+		elapsed = run_clients(ioc, endpoint, conns, 1, state.iterations());
+	}
+
+	state.setIterationTime(elapsed);
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_http_server_example_reference)->arg(64);
+
+/*
+* arg(0) connections, arg(1) requests in flight on each.
+*/
+static void BM_http_server(lcy::bench::State& state)
+{
+	size_t conns = (size_t)state.arg(0);
+	size_t depth = (size_t)state.arg(1);
+
+	lcy::asio::IOContext ioc;
+	http::Server server(ioc, 1);
+	server.setHandler([](const http::RequestView&, http::Response& response){
+		fill_response(response);
+	});
+	server.start(Endpoint("127.0.0.1", 0));
+
+	Endpoint endpoint;
+	server.localAddr(endpoint);
+	double elapsed = run_clients(ioc, endpoint, conns, depth, state.iterations());
+	server.stop();
+
+	state.setIterationTime(elapsed);
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_http_server)->args({ 64, 1 })->args({ 64, 16 })->args({ 1, 64 });
+
+/*
+* A handler rendering a ~4 KiB JSON document per request, arg(0) 1 answers the
+* repeats from the response cache of the server. 64 connections, 16 requests in
+* flight on each.
+*/
+static void BM_http_server_cache(lcy::bench::State& state)
+{
+	bool cached = state.arg(0) != 0;
+
+	lcy::asio::IOContext ioc;
+	http::Server server(ioc, 1);
+	if ( cached ) {
+		server.setCache(16 * 1024 * 1024);
+	}
+	server.setHandler([](const http::RequestView&, http::Response& response){
+		std::string body = "{\"items\":[";
+		for ( int i = 0; i < 128; ++i ) {
+			body += (i ? ",{\"id\":" : "{\"id\":") + std::to_string(i * 7919) +
+					",\"name\":\"item-" + std::to_string(i) + "\"}";
+		}
+		body += "]}";
+		response.setHeader(http::field::CONTENT_TYPE, "application/json");
+		response.setHeader(http::field::CACHE_CONTROL, "max-age=5, stale-while-revalidate=30");
+		response.setBody(std::move(body));
+	});
+	server.start(Endpoint("127.0.0.1", 0));
+
+	Endpoint endpoint;
+	server.localAddr(endpoint);
+	double elapsed = run_clients(ioc, endpoint, 64, 16, state.iterations());
+	server.stop();
+
+	state.setIterationTime(elapsed);
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_http_server_cache)->arg(0)->arg(1);
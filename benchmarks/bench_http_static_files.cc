@@ -0,0 +1,205 @@
+#include "harness.hpp"
+
+#include "lcy/asio/asio.hpp"
+#include "lcy/protocol/protocol.hpp"
+
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <fstream>
+#include <sstream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/*
+* One keep-alive loopback connection fetching one file, the server runs on one
+* pool thread, the client blocks on a thread of its own. One iteration is one
+* request / whole response.
+*
+* The reference handler is what serving a file took before StaticFiles : open and
+* read it into Response::body() on every request, the serializer then copies the
+* body into the output buffer.
+*/
+
+namespace {
+
+namespace http = lcy::protocol::http;
+
+class FileFixture {
+public:
+	FileFixture(size_t size)
+	{
+		char dir[] = "/tmp/lcy_bench_static_XXXXXX";
+		if ( ::mkdtemp(dir) ) {
+			dir_ = dir;
+		}
+		path_ = dir_ + "/file.bin";
+
+		std::string data(size, 'x');
+		FILE* f = ::fopen(path_.c_str(), "wb");
+		if ( f ) {
+			::fwrite(data.data(), 1, data.size(), f);
+			::fclose(f);
+		}
+	}
+
+	~FileFixture()
+	{
+		::unlink(path_.c_str());
+		::rmdir(dir_.c_str());
+	}
+
+	const std::string& dir() const { return dir_; }
+	const std::string& path() const { return path_; }
+
+private:
+	std::string dir_;
+	std::string path_;
+};
+
+static int connect_to(uint16_t port)
+{
+	int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+	struct sockaddr_in addr;
+	::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ( ::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) ) {
+		::close(fd);
+		return -1;
+	}
+
+	int one = 1;
+	::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return fd;
+}
+
+static const char kRequest[] =
+	"GET /file.bin HTTP/1.1\r\n"
+	"Host: 127.0.0.1\r\n"
+	"\r\n";
+
+/*
+* Sends `count` requests one after the other, each response is read whole and
+* its body thrown away. Returns false on a short or malformed response.
+*/
+static bool fetch(int fd, size_t count, size_t& bytes)
+{
+	static char buf[256 * 1024];
+
+	for ( size_t i = 0; i < count; ++i ) {
+		if ( ::send(fd, kRequest, sizeof(kRequest) - 1, MSG_NOSIGNAL) != (ssize_t)(sizeof(kRequest) - 1) ) {
+			return false;
+		}
+
+		std::string head;
+		size_t body_left = 0;
+		bool in_body = false;
+		while ( !in_body || body_left > 0 ) {
+			ssize_t n = ::recv(fd, buf, in_body ? std::min(sizeof(buf), body_left) : sizeof(buf), 0);
+			if ( n <= 0 ) {
+				return false;
+			}
+			bytes += n;
+			if ( in_body ) {
+				body_left -= n;
+				continue;
+			}
+
+			head.append(buf, n);
+			size_t end = head.find("\r\n\r\n");
+			if ( end == std::string::npos ) {
+				continue;
+			}
+			size_t length = head.find("Content-Length: ");
+			if ( length == std::string::npos || length > end ) {
+				return false;
+			}
+			size_t total = ::strtoul(head.c_str() + length + 16, nullptr, 10);
+			size_t got = head.size() - end - 4;
+			if ( got > total ) {
+				return false;		// one request in flight, nothing may follow
+			}
+			body_left = total - got;
+			in_body = true;
+		}
+	}
+	return true;
+}
+
+static void run(lcy::bench::State& state, http::Server::handler_type handler)
+{
+	lcy::asio::IOContext ioc;
+	http::Server server(ioc, 1);
+	server.setHandler(std::move(handler));
+	server.start(lcy::asio::ip::Endpoint("127.0.0.1", 0));
+
+	lcy::asio::ip::Endpoint endpoint;
+	server.localAddr(endpoint);
+
+	// the acceptor needs the loop of `ioc`, the client blocks on its own thread
+	size_t bytes = 0;
+	double elapsed = 0;
+	bool ok = false;
+	std::thread client([&](){
+		int fd = connect_to(endpoint.port());
+		fetch(fd, 1, bytes);		// warm : connection, page cache, fd cache
+		bytes = 0;
+
+		lcy::bench::clock_type::time_point start = lcy::bench::clock_type::now();
+		ok = fetch(fd, state.iterations(), bytes);
+		elapsed = lcy::bench::ElapsedSeconds(start);
+
+		::close(fd);
+		lcy::asio::post(ioc, [&ioc](){ ioc.quit(); });
+	});
+
+	ioc.loop_wait();
+	client.join();
+	server.stop();
+
+	state.setIterationTime(elapsed);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(bytes);
+	state.setCounter("ok", ok ? 1 : 0);
+}
+
+}	// namespace
+
+static void BM_http_static_read_reference(lcy::bench::State& state)
+{
+	FileFixture fixture((size_t)state.arg(0));
+	std::string path = fixture.path();
+
+	run(state, [path](const http::RequestView&, http::Response& response){
+		std::ifstream in(path, std::ios::binary);
+		if ( !in ) {
+			response.setState(http::state::NOT_FOUND);
+			return;
+		}
+		std::ostringstream body;
+		body << in.rdbuf();
+		response.setHeader(http::field::CONTENT_TYPE, "application/octet-stream");
+		response.setBody(body.str());
+	});
+}
+LCY_BENCHMARK(BM_http_static_read_reference)->arg(4 * 1024)->arg(64 * 1024)->arg(1024 * 1024);
+
+static void BM_http_static_sendfile(lcy::bench::State& state)
+{
+	FileFixture fixture((size_t)state.arg(0));
+	http::StaticFiles files(fixture.dir());
+
+	run(state, [&files](const http::RequestView& request, http::Response& response){
+		files.serve(request, http::Router::Path(request.uri()), response);
+	});
+}
+LCY_BENCHMARK(BM_http_static_sendfile)->arg(4 * 1024)->arg(64 * 1024)->arg(1024 * 1024);
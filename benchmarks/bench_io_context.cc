@@ -0,0 +1,196 @@
+#include "harness.hpp"
+
+#include "lcy/asio/asio.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/*
+* post throughput : arg(0) producer threads post state.iterations() tasks in total
+* into one IOContext whose loop runs on the benchmark thread.
+*/
+static void BM_post_throughput(lcy::bench::State& state)
+{
+	size_t producers = (size_t)state.arg(0);
+	size_t total = state.iterations() < producers ? producers : state.iterations();
+	size_t per_producer = total / producers;
+	total = per_producer * producers;
+
+	lcy::asio::IOContext ioc;
+	size_t executed = 0;
+
+	// Make sure the bridge service exists before producers race to create it
+	lcy::asio::use_service<lcy::asio::details::BridgeService>(ioc);
+
+	lcy::bench::clock_type::time_point start = lcy::bench::clock_type::now();
+
+	std::vector<std::thread> threads;
+	for ( size_t p = 0; p < producers; ++p ) {
+		threads.push_back(std::thread([&ioc, &executed, per_producer, total](){
+			for ( size_t i = 0; i < per_producer; ++i ) {
+				lcy::asio::post(ioc, [&ioc, &executed, total](){
+					if ( ++executed == total ) {
+						ioc.quit();
+					}
+				});
+			}
+		}));
+	}
+
+	ioc.loop_wait();
+	state.setIterationTime(lcy::bench::ElapsedSeconds(start));
+
+	for ( auto& th : threads ) {
+		th.join();
+	}
+
+	state.setItemsProcessed(total);
+}
+LCY_BENCHMARK(BM_post_throughput)->range(1, 8);
+
+/*
+* Same shape as BM_post_throughput but through a Strand : producers push lock free
+* and only the push that finds the strand idle goes through the bridge.
+*/
+static void BM_strand_throughput(lcy::bench::State& state)
+{
+	size_t producers = (size_t)state.arg(0);
+	size_t total = state.iterations() < producers ? producers : state.iterations();
+	size_t per_producer = total / producers;
+	total = per_producer * producers;
+
+	lcy::asio::IOContext ioc;
+	lcy::asio::Strand strand(ioc);
+	size_t executed = 0;
+
+	lcy::bench::clock_type::time_point start = lcy::bench::clock_type::now();
+
+	std::vector<std::thread> threads;
+	for ( size_t p = 0; p < producers; ++p ) {
+		threads.push_back(std::thread([&ioc, &strand, &executed, per_producer, total](){
+			for ( size_t i = 0; i < per_producer; ++i ) {
+				strand.dispatch([&ioc, &executed, total](){
+					if ( ++executed == total ) {
+						ioc.quit();
+					}
+				});
+			}
+		}));
+	}
+
+	ioc.loop_wait();
+	state.setIterationTime(lcy::bench::ElapsedSeconds(start));
+
+	for ( auto& th : threads ) {
+		th.join();
+	}
+
+	state.setItemsProcessed(total);
+}
+LCY_BENCHMARK(BM_strand_throughput)->range(1, 8);
+
+/*
+* post from the loop thread itself runs inline, this is the lower bound.
+*/
+static void BM_post_inline(lcy::bench::State& state)
+{
+	lcy::asio::IOContext ioc;
+	size_t executed = 0;
+
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		lcy::asio::post(ioc, [&executed](){ ++executed; });
+	}
+
+	lcy::bench::DoNotOptimize(executed);
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_post_inline);
+
+/*
+* timer insert immediately followed by cancel, arg(0) timers stay armed in the
+* background so the ordered set has a realistic depth.
+*/
+static void BM_timer_insert_cancel(lcy::bench::State& state)
+{
+	lcy::asio::IOContext ioc;
+	lcy::asio::details::TimerService& timer_service =
+		lcy::asio::use_service<lcy::asio::details::TimerService>(ioc);
+
+	std::vector<int64_t> background((size_t)state.arg(0), -1);
+	for ( size_t i = 0; i < background.size(); ++i ) {
+		timer_service.registerTimer(background[i], [](lcy::asio::errcode_type){},
+			{ (time_t)(60 + i % 60), (long)((i * 7919) % 1000000000) });
+	}
+
+	lcy::bench::clock_type::time_point start = lcy::bench::clock_type::now();
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		int64_t timer_id = -1;
+		timer_service.registerTimer(timer_id, [](lcy::asio::errcode_type){},
+			{ 30, (long)((i * 104729) % 1000000000) });
+		timer_service.cancelTimer(timer_id);
+	}
+	state.setIterationTime(lcy::bench::ElapsedSeconds(start));
+
+	for ( auto timer_id : background ) {
+		timer_service.cancelTimer(timer_id);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_timer_insert_cancel)->arg(0)->arg(1024)->arg(65536);
+
+/*
+* timer insert only, the timers are cancelled outside of the measured interval.
+*/
+static void BM_timer_insert(lcy::bench::State& state)
+{
+	lcy::asio::IOContext ioc;
+	lcy::asio::details::TimerService& timer_service =
+		lcy::asio::use_service<lcy::asio::details::TimerService>(ioc);
+
+	std::vector<int64_t> timer_ids(state.iterations(), -1);
+
+	lcy::bench::clock_type::time_point start = lcy::bench::clock_type::now();
+	for ( size_t i = 0; i < timer_ids.size(); ++i ) {
+		timer_service.registerTimer(timer_ids[i], [](lcy::asio::errcode_type){},
+			{ (time_t)(60 + i % 60), (long)((i * 7919) % 1000000000) });
+	}
+	state.setIterationTime(lcy::bench::ElapsedSeconds(start));
+
+	for ( auto timer_id : timer_ids ) {
+		timer_service.cancelTimer(timer_id);
+	}
+
+	state.setItemsProcessed(state.iterations());
+}
+LCY_BENCHMARK(BM_timer_insert);
+
+/*
+* timer fire rate : all timers expire immediately, measured until the last one ran.
+*/
+static void BM_timer_fire(lcy::bench::State& state)
+{
+	lcy::asio::IOContext ioc;
+	lcy::asio::details::TimerService& timer_service =
+		lcy::asio::use_service<lcy::asio::details::TimerService>(ioc);
+
+	size_t fired = 0;
+	size_t total = state.iterations();
+
+	lcy::bench::clock_type::time_point start = lcy::bench::clock_type::now();
+	for ( size_t i = 0; i < total; ++i ) {
+		int64_t timer_id = -1;
+		timer_service.registerTimer(timer_id, [&ioc, &fired, total](lcy::asio::errcode_type){
+			if ( ++fired == total ) {
+				ioc.quit();
+			}
+		}, { 0, 0 });
+	}
+
+	ioc.loop_wait();
+	state.setIterationTime(lcy::bench::ElapsedSeconds(start));
+
+	state.setItemsProcessed(total);
+}
+LCY_BENCHMARK(BM_timer_fire);
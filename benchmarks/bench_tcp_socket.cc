@@ -0,0 +1,312 @@
+#include "harness.hpp"
+
+#include "lcy/asio/asio.hpp"
+
+#include <memory>
+#include <thread>
+#include <vector>
+#include <atomic>
+
+/*
+* Loopback TCP cases. Both ends of every connection live on the same IOContext,
+* so one loop thread drives client and server and the numbers include the full
+* reactor cost on both sides.
+*/
+
+namespace {
+
+using lcy::asio::ip::TCP;
+using lcy::asio::ip::Endpoint;
+
+// Opens a listener on 127.0.0.1 with an ephemeral port
+class Listener {
+public:
+	Listener(lcy::asio::IOContext& ioc) :
+		socket_(ioc)
+	{
+		socket_.open(TCP::v4());
+		socket_.setReuseAddr();
+		socket_.bind(Endpoint("127.0.0.1", 0));
+		socket_.listen(1024);
+		socket_.localAddr(endpoint_);
+	}
+
+	TCP::Socket& socket() { return socket_; }
+	const Endpoint& endpoint() const { return endpoint_; }
+
+private:
+	TCP::Socket socket_;
+	Endpoint endpoint_;
+};
+
+// Echoes everything it receives back to the peer
+class EchoSession {
+public:
+	EchoSession(lcy::asio::IOContext& ioc, size_t buf_size) :
+		socket_(ioc),
+		buf_(buf_size)
+	{
+	}
+
+	TCP::Socket& socket() { return socket_; }
+
+	void start()
+	{
+		socket_.setDelay();
+		read();
+	}
+
+private:
+	void read()
+	{
+		socket_.async_read(lcy::asio::buffer(&buf_[0], buf_.size()),
+				[this](lcy::asio::errcode_type ec, size_t nread){
+			if ( ec || nread == 0 ) {
+				return;
+			}
+
+			socket_.async_write(lcy::asio::buffer(&buf_[0], nread),
+					[this](lcy::asio::errcode_type ec, size_t){
+				if ( !ec ) {
+					read();
+				}
+			});
+		});
+	}
+
+private:
+	TCP::Socket socket_;
+	std::vector<char> buf_;
+};
+
+// Sends a message, waits for the full echo, repeats `rounds` times
+class Client {
+public:
+	typedef std::function<void (Client&)> done_op_type;
+
+	Client(lcy::asio::IOContext& ioc, size_t msg_size) :
+		socket_(ioc),
+		msg_(msg_size, 'x'),
+		recv_(msg_size),
+		received_(0),
+		rounds_(0),
+		record_(false)
+	{
+	}
+
+	TCP::Socket& socket() { return socket_; }
+	std::vector<double>& samples() { return samples_; }
+
+	void run(size_t rounds, bool record, done_op_type done_op)
+	{
+		rounds_ = rounds;
+		record_ = record;
+		done_op_ = std::move(done_op);
+		if ( record_ ) {
+			samples_.reserve(rounds);
+		}
+		send();
+	}
+
+private:
+	void send()
+	{
+		received_ = 0;
+		if ( record_ ) {
+			sent_at_ = lcy::bench::clock_type::now();
+		}
+
+		socket_.async_write(lcy::asio::buffer(msg_), [](lcy::asio::errcode_type, size_t){});
+		read();
+	}
+
+	void read()
+	{
+		socket_.async_read(lcy::asio::buffer(&recv_[received_], recv_.size() - received_),
+				[this](lcy::asio::errcode_type ec, size_t nread){
+			if ( ec || nread == 0 ) {
+				return;
+			}
+
+			received_ += nread;
+			if ( received_ < recv_.size() ) {
+				read();
+				return;
+			}
+
+			if ( record_ ) {
+				samples_.push_back(lcy::bench::ElapsedSeconds(sent_at_) * 1e9);
+			}
+
+			if ( --rounds_ == 0 ) {
+				done_op_(*this);
+			} else {
+				send();
+			}
+		});
+	}
+
+private:
+	TCP::Socket socket_;
+	std::string msg_;
+	std::vector<char> recv_;
+	size_t received_;
+	size_t rounds_;
+	bool record_;
+	lcy::bench::clock_type::time_point sent_at_;
+	std::vector<double> samples_;
+	done_op_type done_op_;
+};
+
+typedef std::unique_ptr<EchoSession> session_ptr;
+typedef std::unique_ptr<Client> client_ptr;
+
+// Connects `count` client/server pairs on one context, runs the loop until done
+static void connect_pairs(lcy::asio::IOContext& ioc,
+						  Listener& listener,
+						  size_t count,
+						  size_t msg_size,
+						  std::vector<session_ptr>& sessions,
+						  std::vector<client_ptr>& clients)
+{
+	size_t connected = 0, accepted = 0;
+
+	for ( size_t i = 0; i < count; ++i ) {
+		clients.push_back(client_ptr(new Client(ioc, msg_size)));
+		sessions.push_back(session_ptr(new EchoSession(ioc, msg_size)));
+	}
+
+	std::function<void ()> accept_next;
+	accept_next = [&](){
+		listener.socket().async_accept(sessions[accepted]->socket(),
+				[&](lcy::asio::errcode_type ec){
+			if ( ec ) {
+				return;
+			}
+
+			sessions[accepted]->start();
+			if ( ++accepted < count ) {
+				accept_next();
+			} else if ( connected == count ) {
+				ioc.quit();
+			}
+		});
+	};
+	accept_next();
+
+	for ( auto& client : clients ) {
+		client->socket().open(TCP::v4());
+		client->socket().async_connect(listener.endpoint(),
+				[&, count](lcy::asio::errcode_type ec){
+			if ( ec ) {
+				return;
+			}
+
+			client->socket().setDelay();
+			if ( ++connected == count && accepted == count ) {
+				ioc.quit();
+			}
+		});
+	}
+
+	ioc.loop_wait();
+}
+
+}	// namespace
+
+/*
+* Round trip latency of arg(0) bytes over one loopback connection.
+*/
+static void BM_tcp_pingpong_latency(lcy::bench::State& state)
+{
+	size_t msg_size = (size_t)state.arg(0);
+
+	lcy::asio::IOContext ioc;
+	Listener listener(ioc);
+	std::vector<session_ptr> sessions;
+	std::vector<client_ptr> clients;
+	connect_pairs(ioc, listener, 1, msg_size, sessions, clients);
+
+	lcy::bench::clock_type::time_point start = lcy::bench::clock_type::now();
+	clients[0]->run(state.iterations(), true, [&ioc](Client&){ ioc.quit(); });
+	ioc.loop_wait();
+	state.setIterationTime(lcy::bench::ElapsedSeconds(start));
+
+	std::vector<double>& samples = clients[0]->samples();
+	state.setCounter("p50_ns", lcy::bench::Percentile(samples, 50));
+	state.setCounter("p99_ns", lcy::bench::Percentile(samples, 99));
+	state.setCounter("p999_ns", lcy::bench::Percentile(samples, 99.9));
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * msg_size * 2);
+}
+LCY_BENCHMARK(BM_tcp_pingpong_latency)->arg(64)->arg(1024)->arg(16384);
+
+/*
+* Echo throughput with arg(0) connections per thread on arg(1) threads,
+* each connection keeps one 4 KiB message in flight. One iteration is one echoed message.
+*/
+static void BM_tcp_throughput(lcy::bench::State& state)
+{
+	const size_t msg_size = 4096;
+	size_t conns = (size_t)state.arg(0);
+	size_t nthreads = (size_t)state.arg(1);
+
+	size_t rounds = state.iterations() / (conns * nthreads);
+	if ( rounds == 0 ) {
+		rounds = 1;
+	}
+
+	std::atomic<size_t> ready(0);
+	std::atomic<bool> go(false);
+	std::vector<double> elapsed(nthreads, 0);
+	std::vector<std::thread> threads;
+
+	for ( size_t t = 0; t < nthreads; ++t ) {
+		threads.push_back(std::thread([&, t](){
+			lcy::asio::IOContext ioc;
+			Listener listener(ioc);
+			std::vector<session_ptr> sessions;
+			std::vector<client_ptr> clients;
+			connect_pairs(ioc, listener, conns, msg_size, sessions, clients);
+
+			++ready;
+			while ( !go.load() ) {
+				std::this_thread::yield();
+			}
+
+			size_t done = 0;
+			lcy::bench::clock_type::time_point start = lcy::bench::clock_type::now();
+			for ( auto& client : clients ) {
+				client->run(rounds, false, [&ioc, &done, conns](Client&){
+					if ( ++done == conns ) {
+						ioc.quit();
+					}
+				});
+			}
+			ioc.loop_wait();
+			elapsed[t] = lcy::bench::ElapsedSeconds(start);
+		}));
+	}
+
+	while ( ready.load() != nthreads ) {
+		std::this_thread::yield();
+	}
+	go.store(true);
+
+	for ( auto& th : threads ) {
+		th.join();
+	}
+
+	double slowest = 0;
+	for ( auto e : elapsed ) {
+		slowest = e > slowest ? e : slowest;
+	}
+	state.setIterationTime(slowest);
+
+	size_t messages = rounds * conns * nthreads;
+	state.setItemsProcessed(messages);
+	state.setBytesProcessed(messages * msg_size * 2);
+}
+LCY_BENCHMARK(BM_tcp_throughput)
+	->args({ 1, 1 })->args({ 16, 1 })->args({ 64, 1 })
+	->args({ 16, 2 })->args({ 16, 4 });
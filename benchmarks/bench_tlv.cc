@@ -0,0 +1,161 @@
+#include "harness.hpp"
+
+#include "lcy/asio/asio.hpp"
+#include "lcy/protocol/protocol.hpp"
+
+#include <string>
+#include <vector>
+#include <string.h>
+
+/*
+* TLV message bus : a buffer of small frames decoded, and frames encoded.
+*
+* The *_message cases go through tlv::Message, a std::string per value and per
+* dump(), the others through MessageView and the Serialize writers, or DecodeFrames()
+* for the whole buffer at once. arg(0) is the value size, arg(1) when present the
+* framing ( 0 fixed, 1 compact ), every case handles 256 frames per iteration.
+*/
+
+namespace {
+
+namespace tlv = lcy::protocol::tlv;
+using lcy::protocol::StringView;
+
+enum {
+	FRAMES = 256,
+};
+
+static std::string make_value(size_t size)
+{
+	std::string value(size, 0);
+	for ( size_t i = 0; i < size; ++i ) {
+		value[i] = (char)('a' + i % 26);
+	}
+	return value;
+}
+
+static std::string make_wire(size_t value_bytes, tlv::framing_type f = tlv::framing::FIXED)
+{
+	lcy::asio::DynamicBuffer buffer;
+	std::string value = make_value(value_bytes);
+	for ( size_t i = 0; i < FRAMES; ++i ) {
+		tlv::SerializeMessage((uint16_t)(i % 100), value, buffer, f);
+	}
+	return std::string(buffer.readBegin(), buffer.dataBytes());
+}
+
+}	// namespace
+
+static void BM_tlv_parse_message(lcy::bench::State& state)
+{
+	std::string wire = make_wire((size_t)state.arg(0));
+	tlv::Parser parser;
+	tlv::Message msg;
+
+	size_t sum = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t at = 0; at < wire.size(); ) {
+			parser.parse(wire.data() + at, wire.size() - at, msg);
+			sum += msg.value().size();
+			at += parser.nparse();
+			parser.reset();
+		}
+	}
+
+	lcy::bench::DoNotOptimize(sum);
+	state.setItemsProcessed(state.iterations() * FRAMES);
+	state.setBytesProcessed(state.iterations() * wire.size());
+}
+LCY_BENCHMARK(BM_tlv_parse_message)->arg(16)->arg(100)->arg(1024);
+
+static void BM_tlv_parse_view(lcy::bench::State& state)
+{
+	std::string wire = make_wire((size_t)state.arg(0));
+	tlv::Parser parser;
+	tlv::MessageView view;
+
+	size_t sum = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t at = 0; at < wire.size(); ) {
+			parser.parse(wire.data() + at, wire.size() - at, view);
+			sum += view.value().size();
+			at += parser.nparse();
+			parser.reset();
+		}
+	}
+
+	lcy::bench::DoNotOptimize(sum);
+	state.setItemsProcessed(state.iterations() * FRAMES);
+	state.setBytesProcessed(state.iterations() * wire.size());
+}
+LCY_BENCHMARK(BM_tlv_parse_view)->arg(16)->arg(100)->arg(1024);
+
+static void BM_tlv_decode_batch(lcy::bench::State& state)
+{
+	tlv::framing_type f = (tlv::framing_type)state.arg(1);
+	std::string wire = make_wire((size_t)state.arg(0), f);
+	tlv::FrameDesc frames[FRAMES];
+
+	size_t sum = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		tlv::DecodeResult result = tlv::DecodeFrames(wire.data(), wire.size(), frames, FRAMES, f);
+		for ( size_t f = 0; f < result.frames; ++f ) {
+			sum += frames[f].length;
+		}
+	}
+
+	lcy::bench::DoNotOptimize(sum);
+	state.setItemsProcessed(state.iterations() * FRAMES);
+	state.setBytesProcessed(state.iterations() * wire.size());
+	state.setCounter("wire_bytes", (double)wire.size());
+}
+LCY_BENCHMARK(BM_tlv_decode_batch)
+	->args({16, 0})->args({16, 1})
+	->args({100, 0})->args({100, 1})
+	->args({1024, 0})->args({1024, 1});
+
+static void BM_tlv_encode_dump(lcy::bench::State& state)
+{
+	tlv::Message msg;
+	std::string value = make_value((size_t)state.arg(0));
+	msg.setLength((uint32_t)value.size());
+	msg.setValue(value);
+	lcy::asio::DynamicBuffer buffer;
+
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t f = 0; f < FRAMES; ++f ) {
+			msg.setType((uint16_t)f);
+			std::string wire = msg.dump();
+			buffer.reserve(wire.size());
+			::memcpy(buffer.writeBegin(), wire.data(), wire.size());
+			buffer.write(wire.size());
+		}
+		buffer.read(buffer.dataBytes());
+	}
+
+	state.setItemsProcessed(state.iterations() * FRAMES);
+	state.setBytesProcessed(state.iterations() * FRAMES * (tlv::HEAD_BYTES + value.size()));
+}
+LCY_BENCHMARK(BM_tlv_encode_dump)->arg(16)->arg(100)->arg(1024);
+
+static void BM_tlv_encode_serialize(lcy::bench::State& state)
+{
+	tlv::framing_type framing = (tlv::framing_type)state.arg(1);
+	std::string value = make_value((size_t)state.arg(0));
+	lcy::asio::DynamicBuffer buffer;
+
+	size_t bytes = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t f = 0; f < FRAMES; ++f ) {
+			bytes += tlv::SerializeMessage((uint16_t)(f % 100), value, buffer, framing);
+		}
+		buffer.read(buffer.dataBytes());
+	}
+
+	state.setItemsProcessed(state.iterations() * FRAMES);
+	state.setBytesProcessed(bytes);
+}
+LCY_BENCHMARK(BM_tlv_encode_serialize)
+	->args({16, 0})->args({16, 1})
+	->args({100, 0})->args({100, 1})
+	->args({1024, 0})->args({1024, 1});
@@ -0,0 +1,288 @@
+#include "harness.hpp"
+
+#include "lcy/asio/asio.hpp"
+#include "lcy/protocol/protocol.hpp"
+
+#include <array>
+#include <string>
+#include <string.h>
+#include <arpa/inet.h>
+
+/*
+* Typed TLV records against the same message written and read by hand.
+*
+* The *_hand cases do what consumers did before record.hpp : a SerializeMessage()
+* per field from a host value turned to network order, the nested record through a
+* buffer of its own, and a Parser loop with a switch on the type to read it back.
+* The *_record cases take arg(0) as the framing ( 0 fixed, 1 compact ).
+*/
+
+namespace {
+
+namespace tlv = lcy::protocol::tlv;
+using lcy::protocol::StringView;
+
+struct Point {
+	int32_t x;
+	int32_t y;
+
+	typedef tlv::Schema<
+		LCY_TLV_FIELD(1, Point, x),
+		LCY_TLV_FIELD(2, Point, y)
+	> schema_type;
+};
+
+struct Tick {
+	uint64_t id;
+	uint32_t seq;
+	double price;
+	StringView symbol;
+	Point at;
+	std::array<uint32_t, 16> depth;
+
+	typedef tlv::Schema<
+		LCY_TLV_FIELD(1, Tick, id),
+		LCY_TLV_FIELD(2, Tick, seq),
+		LCY_TLV_FIELD(3, Tick, price),
+		LCY_TLV_FIELD(4, Tick, symbol),
+		LCY_TLV_FIELD(5, Tick, at),
+		LCY_TLV_FIELD(6, Tick, depth)
+	> schema_type;
+};
+
+enum {
+	TICKS = 64,
+};
+
+static Tick make_tick(size_t i)
+{
+	Tick tick;
+	tick.id = 1000000 + i;
+	tick.seq = (uint32_t)i;
+	tick.price = 100.0 + (double)i / 8;
+	tick.symbol = "LCY.SH";
+	tick.at.x = (int32_t)i;
+	tick.at.y = -(int32_t)i;
+	for ( size_t d = 0; d < tick.depth.size(); ++d ) {
+		tick.depth[d] = (uint32_t)(i * 100 + d);
+	}
+	return tick;
+}
+
+static uint64_t swap64(uint64_t v)
+{
+	return ((uint64_t)htonl((uint32_t)v) << 32) | htonl((uint32_t)(v >> 32));
+}
+
+static StringView net32(uint32_t v, char* out)
+{
+	v = htonl(v);
+	::memcpy(out, &v, 4);
+	return StringView(out, 4);
+}
+
+static StringView net64(uint64_t v, char* out)
+{
+	v = swap64(v);
+	::memcpy(out, &v, 8);
+	return StringView(out, 8);
+}
+
+static uint32_t host32(const char* p)
+{
+	uint32_t v;
+	::memcpy(&v, p, 4);
+	return ntohl(v);
+}
+
+static uint64_t host64(const char* p)
+{
+	uint64_t v;
+	::memcpy(&v, p, 8);
+	return swap64(v);
+}
+
+static void encode_hand(const Tick& tick, lcy::asio::DynamicBuffer& buffer, lcy::asio::DynamicBuffer& nested)
+{
+	char tmp[8];
+	char depth[sizeof(tick.depth)];
+	uint64_t price;
+	::memcpy(&price, &tick.price, 8);
+	lcy::asio::DynamicBuffer value;
+
+	tlv::SerializeMessage(1, net64(tick.id, tmp), value);
+	tlv::SerializeMessage(2, net32(tick.seq, tmp), value);
+	tlv::SerializeMessage(3, net64(price, tmp), value);
+	tlv::SerializeMessage(4, tick.symbol, value);
+
+	tlv::SerializeMessage(1, net32((uint32_t)tick.at.x, tmp), nested);
+	tlv::SerializeMessage(2, net32((uint32_t)tick.at.y, tmp), nested);
+	tlv::SerializeMessage(5, StringView(nested.readBegin(), nested.dataBytes()), value);
+	nested.read(nested.dataBytes());
+
+	for ( size_t d = 0; d < tick.depth.size(); ++d ) {
+		net32(tick.depth[d], depth + d * 4);
+	}
+	tlv::SerializeMessage(6, StringView(depth, sizeof(depth)), value);
+
+	tlv::SerializeMessage(7, StringView(value.readBegin(), value.dataBytes()), buffer);
+}
+
+static bool decode_point_hand(StringView value, Point& at)
+{
+	tlv::Parser parser;
+	tlv::MessageView field;
+	for ( size_t pos = 0; pos < value.size(); ) {
+		if ( parser.parse(value.data() + pos, value.size() - pos, field) != tlv::Parser::READY ||
+			 field.length() != 4 ) {
+			return false;
+		}
+		if ( field.type() == 1 ) {
+			at.x = (int32_t)host32(field.value().data());
+		} else if ( field.type() == 2 ) {
+			at.y = (int32_t)host32(field.value().data());
+		}
+		pos += parser.nparse();
+		parser.reset();
+	}
+	return true;
+}
+
+static bool decode_hand(StringView value, Tick& tick)
+{
+	tlv::Parser parser;
+	tlv::MessageView field;
+	for ( size_t pos = 0; pos < value.size(); ) {
+		if ( parser.parse(value.data() + pos, value.size() - pos, field) != tlv::Parser::READY ) {
+			return false;
+		}
+		StringView v = field.value();
+		switch ( field.type() ) {
+		case 1:
+			tick.id = host64(v.data());
+			break;
+		case 2:
+			tick.seq = host32(v.data());
+			break;
+		case 3: {
+			uint64_t price = host64(v.data());
+			::memcpy(&tick.price, &price, 8);
+			break;
+		}
+		case 4:
+			tick.symbol = v;
+			break;
+		case 5:
+			if ( !decode_point_hand(v, tick.at) ) {
+				return false;
+			}
+			break;
+		case 6:
+			for ( size_t d = 0; d < tick.depth.size(); ++d ) {
+				tick.depth[d] = host32(v.data() + d * 4);
+			}
+			break;
+		}
+		pos += parser.nparse();
+		parser.reset();
+	}
+	return true;
+}
+
+}	// namespace
+
+static void BM_tlv_record_encode_hand(lcy::bench::State& state)
+{
+	Tick ticks[TICKS];
+	for ( size_t i = 0; i < TICKS; ++i ) {
+		ticks[i] = make_tick(i);
+	}
+	lcy::asio::DynamicBuffer buffer, nested;
+
+	size_t bytes = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t t = 0; t < TICKS; ++t ) {
+			encode_hand(ticks[t], buffer, nested);
+		}
+		bytes += buffer.dataBytes();
+		buffer.read(buffer.dataBytes());
+	}
+
+	state.setItemsProcessed(state.iterations() * TICKS);
+	state.setBytesProcessed(bytes);
+}
+LCY_BENCHMARK(BM_tlv_record_encode_hand);
+
+static void BM_tlv_record_encode(lcy::bench::State& state)
+{
+	tlv::framing_type f = (tlv::framing_type)state.arg(0);
+	Tick ticks[TICKS];
+	for ( size_t i = 0; i < TICKS; ++i ) {
+		ticks[i] = make_tick(i);
+	}
+	lcy::asio::DynamicBuffer buffer;
+
+	size_t bytes = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t t = 0; t < TICKS; ++t ) {
+			tlv::SerializeRecord(7, ticks[t], buffer, f);
+		}
+		bytes += buffer.dataBytes();
+		buffer.read(buffer.dataBytes());
+	}
+
+	state.setItemsProcessed(state.iterations() * TICKS);
+	state.setBytesProcessed(bytes);
+}
+LCY_BENCHMARK(BM_tlv_record_encode)->arg(0)->arg(1);
+
+static void BM_tlv_record_decode_hand(lcy::bench::State& state)
+{
+	lcy::asio::DynamicBuffer buffer;
+	for ( size_t t = 0; t < TICKS; ++t ) {
+		tlv::SerializeRecord(7, make_tick(t), buffer);
+	}
+	tlv::FrameDesc frames[TICKS];
+	tlv::DecodeFrames(buffer.readBegin(), buffer.dataBytes(), frames, TICKS);
+
+	uint64_t sum = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t t = 0; t < TICKS; ++t ) {
+			Tick tick;
+			decode_hand(tlv::FrameValue(buffer.readBegin(), frames[t]), tick);
+			lcy::bench::DoNotOptimize(tick);
+			sum += tick.id;
+		}
+	}
+
+	lcy::bench::DoNotOptimize(sum);
+	state.setItemsProcessed(state.iterations() * TICKS);
+	state.setBytesProcessed(state.iterations() * buffer.dataBytes());
+}
+LCY_BENCHMARK(BM_tlv_record_decode_hand);
+
+static void BM_tlv_record_decode(lcy::bench::State& state)
+{
+	tlv::framing_type f = (tlv::framing_type)state.arg(0);
+	lcy::asio::DynamicBuffer buffer;
+	for ( size_t t = 0; t < TICKS; ++t ) {
+		tlv::SerializeRecord(7, make_tick(t), buffer, f);
+	}
+	tlv::FrameDesc frames[TICKS];
+	tlv::DecodeFrames(buffer.readBegin(), buffer.dataBytes(), frames, TICKS, f);
+
+	uint64_t sum = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t t = 0; t < TICKS; ++t ) {
+			Tick tick;
+			tlv::DecodeRecord(tlv::FrameValue(buffer.readBegin(), frames[t]), tick, f);
+			lcy::bench::DoNotOptimize(tick);
+			sum += tick.id;
+		}
+	}
+
+	lcy::bench::DoNotOptimize(sum);
+	state.setItemsProcessed(state.iterations() * TICKS);
+	state.setBytesProcessed(state.iterations() * buffer.dataBytes());
+}
+LCY_BENCHMARK(BM_tlv_record_decode)->arg(0)->arg(1);
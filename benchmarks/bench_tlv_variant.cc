@@ -0,0 +1,163 @@
+#include "harness.hpp"
+
+#include "lcy/protocol/protocol.hpp"
+
+#include <random>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+/*
+* Varints : the macro based VariantEncode/Decode against the kernels.
+*
+* arg(0) is the distribution of 4096 values : 0 all below 128, 1 one in sixteen
+* above, 2 mixed ( random bit widths ). The *_stream cases take arg(1) as the
+* level ( 0 scalar, 1 SSE2, 2 AVX2 ), clamped to what the CPU has.
+*/
+
+namespace {
+
+namespace tlv = lcy::protocol::tlv;
+namespace http = lcy::protocol::http;
+
+enum {
+	VALUES = 4096,
+};
+
+static std::vector<uint32_t> make_values(int64_t shape)
+{
+	std::mt19937 rng(49);
+	std::vector<uint32_t> values(VALUES);
+	for ( size_t i = 0; i < values.size(); ++i ) {
+		uint32_t r = rng();
+		if ( shape == 0 || (shape == 1 && r % 16 != 0) ) {
+			values[i] = r % 128;
+		} else {
+			values[i] = r >> (r % 32);
+		}
+	}
+	return values;
+}
+
+static std::string make_wire(const std::vector<uint32_t>& values)
+{
+	std::string wire(values.size() * tlv::BUFLEN_UINT32, 0);
+	size_t at = 0;
+	for ( uint32_t v : values ) {
+		at += tlv::VariantEncodeUint32(v, &wire[at], wire.size() - at);
+	}
+	wire.resize(at);
+	return wire;
+}
+
+}	// namespace
+
+static void BM_varint_encode_macro(lcy::bench::State& state)
+{
+	std::vector<uint32_t> values = make_values(state.arg(0));
+	std::string out(values.size() * tlv::BUFLEN_UINT32, 0);
+
+	size_t bytes = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		size_t at = 0;
+		for ( uint32_t v : values ) {
+			at += tlv::VariantEncodeUint32(v, &out[at], out.size() - at);
+		}
+		bytes += at;
+	}
+
+	lcy::bench::DoNotOptimize(out);
+	state.setItemsProcessed(state.iterations() * VALUES);
+	state.setBytesProcessed(bytes);
+}
+LCY_BENCHMARK(BM_varint_encode_macro)->arg(0)->arg(1)->arg(2);
+
+static void BM_varint_encode_kernel(lcy::bench::State& state)
+{
+	std::vector<uint32_t> values = make_values(state.arg(0));
+	std::string out(values.size() * tlv::BUFLEN_UINT32, 0);
+
+	size_t bytes = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		size_t at = 0;
+		for ( uint32_t v : values ) {
+			at += tlv::VariantWriteUint32(v, &out[at], out.size() - at);
+		}
+		bytes += at;
+	}
+
+	lcy::bench::DoNotOptimize(out);
+	state.setItemsProcessed(state.iterations() * VALUES);
+	state.setBytesProcessed(bytes);
+}
+LCY_BENCHMARK(BM_varint_encode_kernel)->arg(0)->arg(1)->arg(2);
+
+// VariantDecodeUint32 is given the length : the caller scans for the end byte first
+static void BM_varint_decode_macro(lcy::bench::State& state)
+{
+	std::string wire = make_wire(make_values(state.arg(0)));
+	const uint8_t* p = (const uint8_t*)wire.data();
+
+	uint64_t sum = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t at = 0; at < wire.size(); ) {
+			size_t n = 1;
+			while ( p[at + n - 1] & 0x80 ) {
+				++n;
+			}
+			uint32_t v = 0;
+			tlv::VariantDecodeUint32(v, p + at, n);
+			sum += v;
+			at += n;
+		}
+	}
+
+	lcy::bench::DoNotOptimize(sum);
+	state.setItemsProcessed(state.iterations() * VALUES);
+	state.setBytesProcessed(state.iterations() * wire.size());
+}
+LCY_BENCHMARK(BM_varint_decode_macro)->arg(0)->arg(1)->arg(2);
+
+static void BM_varint_decode_kernel(lcy::bench::State& state)
+{
+	std::string wire = make_wire(make_values(state.arg(0)));
+
+	uint64_t sum = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t at = 0; at < wire.size(); ) {
+			uint32_t v = 0;
+			at += tlv::VariantReadUint32(wire.data() + at, wire.size() - at, v);
+			sum += v;
+		}
+	}
+
+	lcy::bench::DoNotOptimize(sum);
+	state.setItemsProcessed(state.iterations() * VALUES);
+	state.setBytesProcessed(state.iterations() * wire.size());
+}
+LCY_BENCHMARK(BM_varint_decode_kernel)->arg(0)->arg(1)->arg(2);
+
+static void BM_varint_decode_stream(lcy::bench::State& state)
+{
+	std::string wire = make_wire(make_values(state.arg(0)));
+	std::vector<uint32_t> out(VALUES);
+	http::scan_level_type detected = tlv::VariantLevel();
+	http::scan_level_type level = tlv::SetVariantLevel((http::scan_level_type)state.arg(1));
+
+	size_t values = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		size_t nread = 0;
+		values += tlv::VariantDecodeStreamUint32(wire.data(), wire.size(), out.data(), out.size(), nread);
+	}
+
+	tlv::SetVariantLevel(detected);
+	lcy::bench::DoNotOptimize(out);
+	lcy::bench::DoNotOptimize(values);
+	state.setItemsProcessed(state.iterations() * VALUES);
+	state.setBytesProcessed(state.iterations() * wire.size());
+	state.setCounter("level", (double)level);
+}
+LCY_BENCHMARK(BM_varint_decode_stream)
+	->args({0, 0})->args({0, 1})->args({0, 2})
+	->args({1, 0})->args({1, 1})->args({1, 2})
+	->args({2, 0})->args({2, 1})->args({2, 2});
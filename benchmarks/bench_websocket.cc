@@ -0,0 +1,96 @@
+#include "harness.hpp"
+
+#include "lcy/asio/asio.hpp"
+#include "lcy/protocol/protocol.hpp"
+
+#include <string>
+
+/*
+* WebSocket frame layer : payload unmasking and frame serialization.
+*
+* The reference unmasks a byte at a time with the key index taken modulo 4, as the
+* hand written loops did. The kernels run at arg(1) ( 0 scalar words, 1 sse2,
+* 2 avx2 ), arg(0) is the payload size.
+*/
+
+namespace {
+
+namespace http = lcy::protocol::http;
+namespace websocket = lcy::protocol::websocket;
+
+static const uint8_t kKey[4] = { 0x37, 0xFA, 0x21, 0x3D };
+
+static std::string make_payload(size_t size)
+{
+	std::string payload(size, 0);
+	for ( size_t i = 0; i < size; ++i ) {
+		payload[i] = (char)('a' + i % 26);
+	}
+	return payload;
+}
+
+}	// namespace
+
+static void BM_websocket_unmask_reference(lcy::bench::State& state)
+{
+	std::string payload = make_payload((size_t)state.arg(0));
+	char* data = &payload[0];
+	size_t len = payload.size();
+
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		for ( size_t j = 0; j < len; ++j ) {
+			data[j] ^= (char)kKey[j % 4];
+		}
+		lcy::bench::ClobberMemory();
+	}
+
+	lcy::bench::DoNotOptimize(payload);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * len);
+}
+LCY_BENCHMARK(BM_websocket_unmask_reference)->arg(125)->arg(4096)->arg(65536);
+
+static void BM_websocket_unmask(lcy::bench::State& state)
+{
+	http::scan_level_type saved = websocket::MaskLevel();
+	http::scan_level_type level = websocket::SetMaskLevel((http::scan_level_type)state.arg(1));
+
+	std::string payload = make_payload((size_t)state.arg(0));
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		websocket::Mask(&payload[0], payload.size(), kKey);
+		lcy::bench::ClobberMemory();
+	}
+
+	websocket::SetMaskLevel(saved);
+
+	lcy::bench::DoNotOptimize(payload);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * payload.size());
+	state.setCounter("level", (double)(uint8_t)level);
+}
+LCY_BENCHMARK(BM_websocket_unmask)
+	->args({125, 0})->args({125, 2})
+	->args({4096, 0})->args({4096, 1})->args({4096, 2})
+	->args({65536, 0})->args({65536, 1})->args({65536, 2});
+
+// a masked frame parsed out of a buffer and a reply serialized into another
+static void BM_websocket_frame_round_trip(lcy::bench::State& state)
+{
+	std::string payload = make_payload((size_t)state.arg(0));
+	lcy::asio::DynamicBuffer in, out;
+	websocket::FrameParser parser;
+	websocket::Frame frame;
+
+	size_t bytes = 0;
+	for ( size_t i = 0; i < state.iterations(); ++i ) {
+		websocket::SerializeFrame(in, websocket::opcode::TEXT, payload, true, false, kKey);
+		parser.parse(in, frame);
+		bytes += websocket::SerializeFrame(out, websocket::opcode::TEXT, frame.payload);
+		out.read(out.dataBytes());
+	}
+
+	lcy::bench::DoNotOptimize(bytes);
+	state.setItemsProcessed(state.iterations());
+	state.setBytesProcessed(state.iterations() * payload.size());
+}
+LCY_BENCHMARK(BM_websocket_frame_round_trip)->arg(125)->arg(4096);
@@ -0,0 +1,413 @@
+#include "harness.hpp"
+
+#include <time.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+
+namespace lcy {
+namespace bench {
+
+State::State(size_t iterations, const std::vector<int64_t>& args) :
+	iterations_(iterations),
+	args_(args),
+	items_(0),
+	bytes_(0),
+	iteration_time_(-1)
+{
+}
+
+State::~State()
+{
+}
+
+size_t State::iterations() const
+{
+	return iterations_;
+}
+
+int64_t State::arg(size_t index) const
+{
+	return index < args_.size() ? args_[index] : 0;
+}
+
+void State::setItemsProcessed(size_t items)
+{
+	items_ = items;
+}
+
+void State::setBytesProcessed(size_t bytes)
+{
+	bytes_ = bytes;
+}
+
+void State::setCounter(const std::string& name, double value)
+{
+	counters_[name] = value;
+}
+
+void State::setIterationTime(double seconds)
+{
+	iteration_time_ = seconds;
+}
+
+size_t State::itemsProcessed() const
+{
+	return items_;
+}
+
+size_t State::bytesProcessed() const
+{
+	return bytes_;
+}
+
+double State::iterationTime() const
+{
+	return iteration_time_;
+}
+
+const State::counter_map_type& State::counters() const
+{
+	return counters_;
+}
+
+///////////////////////////////////////////////////////////
+
+Benchmark::Benchmark(std::string name, function_type func) :
+	name_(std::move(name)),
+	func_(std::move(func)),
+	fixed_iterations_(0)
+{
+}
+
+Benchmark::~Benchmark()
+{
+}
+
+Benchmark* Benchmark::arg(int64_t value)
+{
+	args_list_.push_back({ value });
+	return this;
+}
+
+Benchmark* Benchmark::args(const std::vector<int64_t>& values)
+{
+	args_list_.push_back(values);
+	return this;
+}
+
+Benchmark* Benchmark::range(int64_t start, int64_t limit, int64_t multiplier)
+{
+	for ( int64_t v = start; v <= limit; v *= multiplier ) {
+		arg(v);
+	}
+	return this;
+}
+
+Benchmark* Benchmark::iterations(size_t fixed)
+{
+	fixed_iterations_ = fixed;
+	return this;
+}
+
+const std::string& Benchmark::name() const
+{
+	return name_;
+}
+
+const Benchmark::function_type& Benchmark::function() const
+{
+	return func_;
+}
+
+const std::vector<std::vector<int64_t> >& Benchmark::argsList() const
+{
+	return args_list_;
+}
+
+size_t Benchmark::fixedIterations() const
+{
+	return fixed_iterations_;
+}
+
+///////////////////////////////////////////////////////////
+
+static std::vector<Benchmark*>& registry()
+{
+	static std::vector<Benchmark*> benchmarks;
+	return benchmarks;
+}
+
+Benchmark* RegisterBenchmark(const char* name, Benchmark::function_type func)
+{
+	Benchmark* benchmark = new Benchmark(name, std::move(func));
+	registry().push_back(benchmark);
+	return benchmark;
+}
+
+double Percentile(std::vector<double>& samples, double p)
+{
+	if ( samples.empty() ) {
+		return 0;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	size_t index = (size_t)(p / 100.0 * (samples.size() - 1) + 0.5);
+	return samples[std::min(index, samples.size() - 1)];
+}
+
+///////////////////////////////////////////////////////////
+
+struct Options {
+	double min_time;
+	std::string filter;
+	bool json;
+	std::string out;
+};
+
+struct Result {
+	std::string name;
+	size_t iterations;
+	double real_time;		// ns per iteration
+	double cpu_time;		// ns per iteration
+	double items_per_second;
+	double bytes_per_second;
+	State::counter_map_type counters;
+};
+
+static double cpu_seconds()
+{
+	struct timespec ts;
+	::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static std::string full_name(const Benchmark& benchmark, const std::vector<int64_t>& args)
+{
+	std::string name = benchmark.name();
+	for ( auto arg : args ) {
+		name += "/" + std::to_string(arg);
+	}
+	return name;
+}
+
+static Result run_one(const Benchmark& benchmark,
+					  const std::vector<int64_t>& args,
+					  const Options& opts)
+{
+	size_t iterations = benchmark.fixedIterations() ? benchmark.fixedIterations() : 1;
+
+	while ( true ) {
+		State state(iterations, args);
+
+		double cpu_start = cpu_seconds();
+		clock_type::time_point start = clock_type::now();
+		benchmark.function()(state);
+		double real = ElapsedSeconds(start);
+		double cpu = cpu_seconds() - cpu_start;
+
+		if ( state.iterationTime() >= 0 ) {
+			real = state.iterationTime();
+		}
+
+		bool done = benchmark.fixedIterations() ||
+					real >= opts.min_time ||
+					iterations >= 1000000000;
+
+		if ( done ) {
+			Result result;
+			result.name = full_name(benchmark, args);
+			result.iterations = iterations;
+			result.real_time = real * 1e9 / iterations;
+			result.cpu_time = cpu * 1e9 / iterations;
+			result.items_per_second = real > 0 ? state.itemsProcessed() / real : 0;
+			result.bytes_per_second = real > 0 ? state.bytesProcessed() / real : 0;
+			result.counters = state.counters();
+			return result;
+		}
+
+		// Predict the iteration count needed to reach min_time, like Google Benchmark does
+		double multiplier = real > 0 ? opts.min_time * 1.4 / real : 10;
+		multiplier = std::max(std::min(multiplier, 10.0), 2.0);
+		iterations = (size_t)(iterations * multiplier);
+	}
+}
+
+static std::string json_escape(const std::string& str)
+{
+	std::string out;
+	for ( char c : str ) {
+		if ( c == '"' || c == '\\' ) {
+			out += '\\';
+		}
+		out += c;
+	}
+	return out;
+}
+
+static void report_json(std::ostream& os, const std::vector<Result>& results)
+{
+	char host[256] = { 0 };
+	::gethostname(host, sizeof(host) - 1);
+
+	char date[64] = { 0 };
+	time_t now = ::time(nullptr);
+	::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", ::localtime(&now));
+
+	os << std::setprecision(10);
+	os << "{\n"
+	   << "  \"context\": {\n"
+	   << "    \"date\": \"" << date << "\",\n"
+	   << "    \"host_name\": \"" << json_escape(host) << "\",\n"
+	   << "    \"executable\": \"lcy_benchmarks\",\n"
+	   << "    \"num_cpus\": " << ::sysconf(_SC_NPROCESSORS_ONLN) << ",\n"
+#ifdef NDEBUG
+	   << "    \"library_build_type\": \"release\"\n"
+#else
+	   << "    \"library_build_type\": \"debug\"\n"
+#endif
+	   << "  },\n"
+	   << "  \"benchmarks\": [\n";
+
+	for ( size_t i = 0; i < results.size(); ++i ) {
+		const Result& r = results[i];
+		os << "    {\n"
+		   << "      \"name\": \"" << json_escape(r.name) << "\",\n"
+		   << "      \"run_name\": \"" << json_escape(r.name) << "\",\n"
+		   << "      \"run_type\": \"iteration\",\n"
+		   << "      \"iterations\": " << r.iterations << ",\n"
+		   << "      \"real_time\": " << r.real_time << ",\n"
+		   << "      \"cpu_time\": " << r.cpu_time << ",\n"
+		   << "      \"time_unit\": \"ns\"";
+
+		if ( r.items_per_second > 0 ) {
+			os << ",\n      \"items_per_second\": " << r.items_per_second;
+		}
+		if ( r.bytes_per_second > 0 ) {
+			os << ",\n      \"bytes_per_second\": " << r.bytes_per_second;
+		}
+		for ( auto& kv : r.counters ) {
+			os << ",\n      \"" << json_escape(kv.first) << "\": " << kv.second;
+		}
+
+		os << "\n    }" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+
+	os << "  ]\n}\n";
+}
+
+static void report_console_line(const Result& r)
+{
+	std::ostringstream oss;
+	oss << std::left << std::setw(48) << r.name
+		<< std::right << std::setw(14) << std::fixed << std::setprecision(1) << r.real_time << " ns"
+		<< std::setw(14) << r.cpu_time << " ns"
+		<< std::setw(12) << r.iterations;
+
+	if ( r.items_per_second > 0 ) {
+		oss << "  items/s=" << std::setprecision(0) << r.items_per_second;
+	}
+	if ( r.bytes_per_second > 0 ) {
+		oss << "  MB/s=" << std::setprecision(1) << r.bytes_per_second / 1e6;
+	}
+	for ( auto& kv : r.counters ) {
+		oss << "  " << kv.first << "=" << std::setprecision(1) << kv.second;
+	}
+
+	std::cerr << oss.str() << std::endl;
+}
+
+static void usage(const char* argv0)
+{
+	std::cerr << "usage : " << argv0 << " [options]\n"
+			  << "  --filter=<substring>   only run cases whose name contains substring\n"
+			  << "  --min_time=<seconds>   minimum measured time per case ( default 0.5 )\n"
+			  << "  --format=json|console  output format on stdout ( default json )\n"
+			  << "  --out=<file>           also write the json report to file\n"
+			  << "  --list                 list the cases and exit\n";
+}
+
+int RunBenchmarks(int argc, char** argv)
+{
+	Options opts = { 0.5, "", true, "" };
+	bool list = false;
+
+	for ( int i = 1; i < argc; ++i ) {
+		std::string arg = argv[i];
+		if ( arg.compare(0, 9, "--filter=") == 0 ) {
+			opts.filter = arg.substr(9);
+		} else if ( arg.compare(0, 11, "--min_time=") == 0 ) {
+			opts.min_time = ::atof(arg.c_str() + 11);
+		} else if ( arg == "--format=console" ) {
+			opts.json = false;
+		} else if ( arg == "--format=json" ) {
+			opts.json = true;
+		} else if ( arg.compare(0, 6, "--out=") == 0 ) {
+			opts.out = arg.substr(6);
+		} else if ( arg == "--list" ) {
+			list = true;
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	std::vector<Result> results;
+	for ( Benchmark* benchmark : registry() ) {
+		std::vector<std::vector<int64_t> > args_list = benchmark->argsList();
+		if ( args_list.empty() ) {
+			args_list.push_back({});
+		}
+
+		for ( auto& args : args_list ) {
+			std::string name = full_name(*benchmark, args);
+			if ( !opts.filter.empty() && name.find(opts.filter) == std::string::npos ) {
+				continue;
+			}
+
+			if ( list ) {
+				std::cout << name << std::endl;
+				continue;
+			}
+
+			results.push_back(run_one(*benchmark, args, opts));
+			report_console_line(results.back());
+		}
+	}
+
+	if ( list ) {
+		return 0;
+	}
+
+	if ( opts.json ) {
+		report_json(std::cout, results);
+	}
+
+	if ( !opts.out.empty() ) {
+		FILE* fp = ::fopen(opts.out.c_str(), "w");
+		if ( !fp ) {
+			std::cerr << "cannot open " << opts.out << std::endl;
+			return 1;
+		}
+
+		std::ostringstream oss;
+		report_json(oss, results);
+		::fputs(oss.str().c_str(), fp);
+		::fclose(fp);
+	}
+
+	return 0;
+}
+
+}	// namespace bench
+}	// namespace lcy
+
+int main(int argc, char** argv) {
+	return lcy::bench::RunBenchmarks(argc, argv);
+}
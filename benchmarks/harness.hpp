@@ -0,0 +1,129 @@
+#ifndef __LCY_BENCHMARKS_HARNESS_HPP__
+#define __LCY_BENCHMARKS_HARNESS_HPP__
+
+#include <map>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace lcy {
+namespace bench {
+
+/*
+* A minimal self-contained benchmark harness.
+*
+* Each case is a function taking a State, it must perform state.iterations()
+* operations. The runner grows the iteration count until a case runs for at
+* least --min_time seconds and reports the last run.
+*
+* The JSON output follows the layout of Google Benchmark's --benchmark_format=json
+* ( "context" + "benchmarks" array ), so existing comparison tooling can be used
+* to track regressions between builds.
+*
+* example :
+*
+*	static void BM_write(lcy::bench::State& state) {
+*		for ( size_t i = 0; i < state.iterations(); ++i ) { ... }
+*		state.setItemsProcessed(state.iterations());
+*	}
+*	LCY_BENCHMARK(BM_write)->arg(64)->arg(4096);
+*/
+
+class State {
+public:
+	typedef std::map<std::string, double> counter_map_type;
+
+	State(size_t iterations, const std::vector<int64_t>& args);
+	~State();
+
+	size_t iterations() const;
+	int64_t arg(size_t index) const;
+
+	void setItemsProcessed(size_t items);
+	void setBytesProcessed(size_t bytes);
+	void setCounter(const std::string& name, double value);
+
+	/*
+	* Cases that measure their own interval ( e.g. after an expensive setup )
+	* report it here in seconds, otherwise the whole call is timed.
+	*/
+	void setIterationTime(double seconds);
+
+	size_t itemsProcessed() const;
+	size_t bytesProcessed() const;
+	double iterationTime() const;
+	const counter_map_type& counters() const;
+
+private:
+	size_t iterations_;
+	std::vector<int64_t> args_;
+	size_t items_;
+	size_t bytes_;
+	double iteration_time_;
+	counter_map_type counters_;
+};
+
+class Benchmark {
+public:
+	typedef std::function<void (State&)> function_type;
+
+	Benchmark(std::string name, function_type func);
+	~Benchmark();
+
+	Benchmark* arg(int64_t value);
+	Benchmark* args(const std::vector<int64_t>& values);
+	Benchmark* range(int64_t start, int64_t limit, int64_t multiplier = 2);
+	Benchmark* iterations(size_t fixed);
+
+	const std::string& name() const;
+	const function_type& function() const;
+	const std::vector<std::vector<int64_t> >& argsList() const;
+	size_t fixedIterations() const;
+
+private:
+	std::string name_;
+	function_type func_;
+	size_t fixed_iterations_;
+	std::vector<std::vector<int64_t> > args_list_;
+};
+
+Benchmark* RegisterBenchmark(const char* name, Benchmark::function_type func);
+int RunBenchmarks(int argc, char** argv);
+
+/*
+* Small helpers shared by the cases
+*/
+typedef std::chrono::steady_clock clock_type;
+
+inline double ElapsedSeconds(clock_type::time_point start)
+{
+	return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+double Percentile(std::vector<double>& samples, double p);	// samples are sorted in place
+
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void ClobberMemory()
+{
+	asm volatile("" : : : "memory");
+}
+
+}	// namespace bench
+}	// namespace lcy
+
+#define LCY_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define LCY_BENCHMARK_CONCAT(a, b) LCY_BENCHMARK_CONCAT_IMPL(a, b)
+
+#define LCY_BENCHMARK(func)												\
+	static ::lcy::bench::Benchmark* LCY_BENCHMARK_CONCAT(lcy_bench_, __LINE__) = \
+		::lcy::bench::RegisterBenchmark(#func, func)
+
+#endif	// __LCY_BENCHMARKS_HARNESS_HPP__
@@ -0,0 +1,151 @@
+#include "histogram.h"
+
+#include <limits>
+
+namespace lcy {
+namespace bench {
+
+#define SUB_BUCKETS ((uint64_t)1 << SUB_BUCKET_BITS)
+#define HALF_SUB_BUCKETS (SUB_BUCKETS / 2)
+
+/*
+* Layout : values below SUB_BUCKETS are stored exactly ( bucket 0 ), every
+* following power of two is split into HALF_SUB_BUCKETS linear slots.
+*/
+
+Histogram::Histogram() :
+	counts_(SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * HALF_SUB_BUCKETS, 0),
+	total_(0),
+	min_(std::numeric_limits<uint64_t>::max()),
+	max_(0),
+	sum_(0)
+{
+}
+
+Histogram::~Histogram()
+{
+}
+
+size_t Histogram::index(uint64_t value) const
+{
+	if ( value < SUB_BUCKETS ) {
+		return (size_t)value;
+	}
+
+	int msb = 63 - __builtin_clzll(value);				// >= SUB_BUCKET_BITS
+	int shift = msb - (SUB_BUCKET_BITS - 1);
+	uint64_t sub = (value >> shift) - HALF_SUB_BUCKETS;	// [0, HALF_SUB_BUCKETS)
+
+	return (size_t)(SUB_BUCKETS + (shift - 1) * HALF_SUB_BUCKETS + sub);
+}
+
+uint64_t Histogram::valueAt(size_t idx) const
+{
+	if ( idx < SUB_BUCKETS ) {
+		return idx;
+	}
+
+	size_t offset = idx - SUB_BUCKETS;
+	int shift = (int)(offset / HALF_SUB_BUCKETS) + 1;
+	uint64_t sub = offset % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+
+	// Report the highest value of the slot, like HdrHistogram's "highest equivalent value"
+	return ((sub + 1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value, uint64_t count)
+{
+	counts_[index(value)] += count;
+	total_ += count;
+	sum_ += (double)value * count;
+
+	if ( value < min_ ) min_ = value;
+	if ( value > max_ ) max_ = value;
+}
+
+void Histogram::recordCorrected(uint64_t value, uint64_t expected_interval)
+{
+	record(value);
+
+	if ( expected_interval == 0 || value <= expected_interval ) {
+		return;
+	}
+
+	for ( uint64_t missing = value - expected_interval;
+		  missing >= expected_interval;
+		  missing -= expected_interval ) {
+		record(missing);
+	}
+}
+
+void Histogram::merge(const Histogram& other)
+{
+	for ( size_t i = 0; i < counts_.size(); ++i ) {
+		counts_[i] += other.counts_[i];
+	}
+
+	total_ += other.total_;
+	sum_ += other.sum_;
+
+	if ( other.total_ ) {
+		if ( other.min_ < min_ ) min_ = other.min_;
+		if ( other.max_ > max_ ) max_ = other.max_;
+	}
+}
+
+void Histogram::reset()
+{
+	counts_.assign(counts_.size(), 0);
+	total_ = 0;
+	min_ = std::numeric_limits<uint64_t>::max();
+	max_ = 0;
+	sum_ = 0;
+}
+
+uint64_t Histogram::count() const
+{
+	return total_;
+}
+
+uint64_t Histogram::min() const
+{
+	return total_ ? min_ : 0;
+}
+
+uint64_t Histogram::max() const
+{
+	return max_;
+}
+
+double Histogram::mean() const
+{
+	return total_ ? sum_ / total_ : 0;
+}
+
+uint64_t Histogram::percentile(double p) const
+{
+	if ( total_ == 0 ) {
+		return 0;
+	}
+
+	uint64_t target = (uint64_t)(p / 100.0 * total_ + 0.5);
+	if ( target == 0 ) target = 1;
+	if ( target > total_ ) target = total_;
+
+	uint64_t seen = 0;
+	for ( size_t i = 0; i < counts_.size(); ++i ) {
+		seen += counts_[i];
+		if ( seen >= target ) {
+			uint64_t value = valueAt(i);
+			return value > max_ ? max_ : value;
+		}
+	}
+
+	return max_;
+}
+
+#undef HALF_SUB_BUCKETS
+#undef SUB_BUCKETS
+
+}	// namespace bench
+}	// namespace lcy
@@ -0,0 +1,59 @@
+#ifndef __LCY_BENCHMARKS_HISTOGRAM_H__
+#define __LCY_BENCHMARKS_HISTOGRAM_H__
+
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace lcy {
+namespace bench {
+
+/*
+* Log-linear latency histogram in the spirit of HdrHistogram.
+*
+* Values ( nanoseconds ) are kept with SUB_BUCKET_BITS bits of precision, that is a
+* relative error below 0.1% across the whole 64-bit range, in a fixed array so
+* recording is a clz, two shifts and an increment.
+*/
+class Histogram {
+public:
+	enum { SUB_BUCKET_BITS = 11 };
+
+	Histogram();
+	~Histogram();
+
+	void record(uint64_t value, uint64_t count = 1);
+
+	/*
+	* Coordinated omission correction for closed-loop measurements:
+	* when a sample is larger than the expected interval between requests, the
+	* requests that would have been issued meanwhile are back-filled with
+	* linearly decreasing latencies.
+	*/
+	void recordCorrected(uint64_t value, uint64_t expected_interval);
+
+	void merge(const Histogram& other);
+	void reset();
+
+	uint64_t count() const;
+	uint64_t min() const;
+	uint64_t max() const;
+	double mean() const;
+	uint64_t percentile(double p) const;
+
+private:
+	size_t index(uint64_t value) const;
+	uint64_t valueAt(size_t index) const;
+
+private:
+	std::vector<uint64_t> counts_;
+	uint64_t total_;
+	uint64_t min_;
+	uint64_t max_;
+	double sum_;
+};
+
+}	// namespace bench
+}	// namespace lcy
+
+#endif	// __LCY_BENCHMARKS_HISTOGRAM_H__
@@ -0,0 +1,837 @@
+#include "histogram.h"
+
+#include "lcy/asio/asio.hpp"
+#include "lcy/protocol/protocol.hpp"
+#include "lcy/rpc/src/rpc.pb.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+/*
+* lcy_loadgen : HTTP/1.1 and lcy::rpc load generator, loopback only.
+*
+*   closed loop ( --rate=0 ) : every connection keeps --pipeline requests in flight
+*                              and issues the next one as soon as a response arrives.
+*   open loop ( --rate=R )   : R requests per second in total are scheduled on a
+*                              fixed timetable; latency is measured from the intended
+*                              send time, so a stalled server is not hidden by the
+*                              generator backing off ( coordinated omission ).
+*
+* example :
+*   ./bin/lcy_loadgen --proto=http --port=8080 --connections=64 --threads=4 \
+*                     --pipeline=8 --duration=10 --mix=GET:/:3,POST:/echo:1
+*   ./bin/lcy_loadgen --proto=rpc --port=9999 --rate=50000 --mix=LoginService.Login
+*/
+
+namespace {
+
+namespace http = lcy::protocol::http;
+
+using lcy::asio::ip::TCP;
+using lcy::asio::ip::Endpoint;
+
+typedef std::chrono::steady_clock clock_type;
+
+static uint64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		clock_type::now().time_since_epoch()).count();
+}
+
+struct Options {
+	std::string proto = "http";
+	std::string host = "127.0.0.1";
+	uint16_t port = 8080;
+	size_t connections = 16;
+	size_t threads = 1;
+	size_t pipeline = 1;
+	double rate = 0;				// requests per second, 0 means closed loop
+	double duration = 10;			// seconds
+	double warmup = 1;				// seconds
+	uint64_t expected_interval_us = 0;	// closed loop coordinated omission correction
+	size_t body_size = 0;
+	std::string mix;
+	std::string format = "console";
+};
+
+// One entry of the request mix, `wire` is ready to send for HTTP
+struct RequestTemplate {
+	std::string name;
+	size_t weight;
+	std::string wire;
+	lcy::rpc::Message rpc;
+};
+
+struct Shared {
+	Options opts;
+	Endpoint endpoint;
+	std::vector<RequestTemplate> templates;
+	std::vector<size_t> schedule;	// template indices expanded by weight
+	std::atomic<uint64_t> measure_begin_ns;
+	std::atomic<uint64_t> measure_end_ns;
+	std::atomic<bool> stopping;
+};
+
+struct Stats {
+	lcy::bench::Histogram latency;
+	uint64_t completed = 0;
+	uint64_t failed = 0;			// non 2xx status or rpc errcode != SUCCESS
+	uint64_t socket_errors = 0;
+	uint64_t connect_errors = 0;
+	uint64_t bytes_sent = 0;
+	uint64_t bytes_received = 0;
+
+	void merge(const Stats& other)
+	{
+		latency.merge(other.latency);
+		completed += other.completed;
+		failed += other.failed;
+		socket_errors += other.socket_errors;
+		connect_errors += other.connect_errors;
+		bytes_sent += other.bytes_sent;
+		bytes_received += other.bytes_received;
+	}
+};
+
+/////////////////////////////////////////////////////////////
+
+class Connection {
+public:
+	Connection(lcy::asio::IOContext& ioc, Shared& shared, Stats& stats, size_t index) :
+		socket_(ioc),
+		shared_(shared),
+		stats_(stats),
+		alive_(false),
+		closed_(false),
+		writing_(false),
+		next_id_(0),
+		mix_cursor_(index),
+		interval_ns_(0),
+		next_intended_ns_(0)
+	{
+		const Options& opts = shared_.opts;
+		if ( opts.rate > 0 ) {
+			interval_ns_ = (uint64_t)(1e9 * opts.connections / opts.rate);
+			if ( interval_ns_ == 0 ) {
+				interval_ns_ = 1;
+			}
+		}
+	}
+
+	virtual ~Connection()
+	{
+	}
+
+	void connect(uint64_t start_ns)
+	{
+		if ( shared_.endpoint.isV4() ) {
+			socket_.open(TCP::v4());
+		} else {
+			socket_.open(TCP::v6());
+		}
+
+		// Spread the timetables so connections do not fire in lockstep
+		next_intended_ns_ = start_ns + interval_ns_ * (mix_cursor_ % shared_.opts.connections)
+				/ shared_.opts.connections;
+
+		socket_.async_connect(shared_.endpoint, [this](lcy::asio::errcode_type ec){
+			if ( ec ) {
+				++stats_.connect_errors;
+				return;
+			}
+
+			socket_.setDelay();
+			alive_ = true;
+			read();
+			pump();
+		});
+	}
+
+	void close()
+	{
+		alive_ = false;
+		if ( !closed_ ) {
+			closed_ = true;
+			socket_.shutdown();		// cancels pending operations synchronously
+		}
+	}
+
+	/*
+	* Issues as many requests as the mode allows:
+	*  closed loop : fill the pipeline
+	*  open loop   : send every request whose intended time has come,
+	*                as long as the pipeline has room
+	*/
+	void pump()
+	{
+		if ( !alive_ || shared_.stopping.load(std::memory_order_relaxed) ) {
+			return;
+		}
+
+		size_t depth = shared_.opts.pipeline;
+		if ( interval_ns_ == 0 ) {
+			while ( inflight_.size() < depth ) {
+				enqueue(now_ns());
+			}
+		} else {
+			uint64_t now = now_ns();
+			while ( inflight_.size() < depth && next_intended_ns_ <= now ) {
+				enqueue(next_intended_ns_);
+				next_intended_ns_ += interval_ns_;
+			}
+		}
+
+		flush();
+	}
+
+protected:
+	struct Inflight {
+		uint64_t id;
+		uint64_t start_ns;
+	};
+
+	// Appends the encoded request to `out`
+	virtual void encode(const RequestTemplate& tpl, uint64_t id, std::string& out) = 0;
+
+	/*
+	* Consumes complete responses from the read buffer.
+	* return false on a protocol error.
+	*/
+	virtual bool decode(lcy::asio::DynamicBuffer& in) = 0;
+
+	// Called by decode for every response, `id` is ignored for in-order protocols
+	void complete(uint64_t id, bool ok, bool in_order)
+	{
+		if ( inflight_.empty() ) {
+			return;
+		}
+
+		std::deque<Inflight>::iterator iter = inflight_.begin();
+		if ( !in_order ) {
+			for ( ; iter != inflight_.end(); ++iter ) {
+				if ( iter->id == id ) {
+					break;
+				}
+			}
+			if ( iter == inflight_.end() ) {
+				return;
+			}
+		}
+
+		uint64_t start_ns = iter->start_ns;
+		inflight_.erase(iter);
+
+		uint64_t end_ns = now_ns();
+		if ( end_ns >= shared_.measure_begin_ns.load(std::memory_order_relaxed) &&
+			 end_ns < shared_.measure_end_ns.load(std::memory_order_relaxed) ) {
+			uint64_t latency = end_ns > start_ns ? end_ns - start_ns : 0;
+			if ( interval_ns_ == 0 && shared_.opts.expected_interval_us ) {
+				stats_.latency.recordCorrected(latency, shared_.opts.expected_interval_us * 1000);
+			} else {
+				stats_.latency.record(latency);
+			}
+
+			++stats_.completed;
+			if ( !ok ) {
+				++stats_.failed;
+			}
+		}
+	}
+
+private:
+	void enqueue(uint64_t start_ns)
+	{
+		const std::vector<size_t>& schedule = shared_.schedule;
+		const RequestTemplate& tpl = shared_.templates[schedule[mix_cursor_++ % schedule.size()]];
+
+		Inflight inflight = { next_id_++, start_ns };
+		inflight_.push_back(inflight);
+
+		encode(tpl, inflight.id, pending_);
+	}
+
+	void flush()
+	{
+		if ( writing_ || pending_.empty() ) {
+			return;
+		}
+
+		// Everything queued since the last write goes out in one send
+		writing_ = true;
+		sending_.swap(pending_);
+		pending_.clear();
+
+		socket_.async_write(lcy::asio::buffer(sending_), [this](lcy::asio::errcode_type ec, size_t nbytes){
+			writing_ = false;
+			stats_.bytes_sent += nbytes;
+
+			if ( ec ) {
+				fail();
+				return;
+			}
+
+			flush();
+		});
+	}
+
+	void read()
+	{
+		in_.reserve(16384);
+		socket_.async_read(lcy::asio::buffer(in_.writeBegin(), in_.availableBytes()),
+				[this](lcy::asio::errcode_type ec, size_t nread){
+			if ( ec || nread == 0 ) {
+				fail();
+				return;
+			}
+
+			in_.write(nread);
+			stats_.bytes_received += nread;
+
+			if ( !decode(in_) ) {
+				fail();
+				return;
+			}
+
+			read();
+			pump();
+		});
+	}
+
+	void fail()
+	{
+		if ( alive_ && !shared_.stopping.load(std::memory_order_relaxed) ) {
+			++stats_.socket_errors;
+		}
+		close();
+	}
+
+private:
+	TCP::Socket socket_;
+	Shared& shared_;
+	Stats& stats_;
+
+	bool alive_;
+	bool closed_;
+	bool writing_;
+	uint64_t next_id_;
+	size_t mix_cursor_;
+	uint64_t interval_ns_;
+	uint64_t next_intended_ns_;
+
+	std::deque<Inflight> inflight_;
+	std::string pending_;
+	std::string sending_;
+	lcy::asio::DynamicBuffer in_;
+};
+
+// HTTP/1.1 keep-alive, responses arrive in request order
+class HttpConnection :
+	public Connection
+{
+public:
+	HttpConnection(lcy::asio::IOContext& ioc, Shared& shared, Stats& stats, size_t index) :
+		Connection(ioc, shared, stats, index)
+	{
+	}
+
+protected:
+	void encode(const RequestTemplate& tpl, uint64_t, std::string& out) override
+	{
+		out.append(tpl.wire);
+	}
+
+	bool decode(lcy::asio::DynamicBuffer& in) override
+	{
+		while ( in.dataBytes() > 0 ) {
+			http::Parser::RetCode retcode = parser_.parse(in.readBegin(), in.dataBytes(), response_);
+			if ( retcode == http::Parser::RetCode::ERROR ) {
+				return false;
+			}
+			if ( retcode == http::Parser::RetCode::WAITING_DATA ) {
+				return true;
+			}
+
+			int status = (int)response_.state();
+			complete(0, status >= 200 && status < 300, true);
+
+			in.read(parser_.nparse());
+			parser_.reset();
+			response_.clear();
+		}
+
+		return true;
+	}
+
+private:
+	http::Parser parser_;
+	http::Response response_;
+};
+
+// lcy::rpc framing : 4 byte big endian length + lcy::rpc::Message
+class RpcConnection :
+	public Connection
+{
+public:
+	RpcConnection(lcy::asio::IOContext& ioc, Shared& shared, Stats& stats, size_t index) :
+		Connection(ioc, shared, stats, index)
+	{
+	}
+
+protected:
+	void encode(const RequestTemplate& tpl, uint64_t id, std::string& out) override
+	{
+		request_.CopyFrom(tpl.rpc);
+		request_.set_id(id);
+
+		size_t offset = out.size();
+		out.resize(offset + sizeof(uint32_t));
+		request_.AppendToString(&out);
+
+		uint32_t len = htonl((uint32_t)(out.size() - offset - sizeof(uint32_t)));
+		::memcpy(&out[offset], &len, sizeof(uint32_t));
+	}
+
+	bool decode(lcy::asio::DynamicBuffer& in) override
+	{
+		while ( in.dataBytes() >= sizeof(uint32_t) ) {
+			uint32_t len = 0;
+			::memcpy(&len, in.readBegin(), sizeof(uint32_t));
+			len = ntohl(len);
+
+			if ( in.dataBytes() < len + sizeof(uint32_t) ) {
+				break;
+			}
+
+			if ( !response_.ParseFromArray(in.readBegin() + sizeof(uint32_t), (int)len) ||
+				 response_.tp() != lcy::rpc::type::response ) {
+				return false;
+			}
+
+			complete(response_.id(), response_.response().errcode() == lcy::rpc::err::SUCCESS, false);
+			in.read(len + sizeof(uint32_t));
+		}
+
+		return true;
+	}
+
+private:
+	lcy::rpc::Message request_;
+	lcy::rpc::Message response_;
+};
+
+/////////////////////////////////////////////////////////////
+
+/*
+* All connections of one pool thread. Created, driven and destroyed on that
+* thread only, the main thread merely reads `stats` after finish().
+*/
+class Worker {
+public:
+	Worker(Shared& shared) :
+		shared_(shared)
+	{
+	}
+
+	void start(lcy::asio::IOContext& ioc, size_t first, size_t count, uint64_t start_ns)
+	{
+		for ( size_t i = 0; i < count; ++i ) {
+			Connection* conn = nullptr;
+			if ( shared_.opts.proto == "rpc" ) {
+				conn = new RpcConnection(ioc, shared_, stats, first + i);
+			} else {
+				conn = new HttpConnection(ioc, shared_, stats, first + i);
+			}
+
+			connections_.push_back(std::unique_ptr<Connection>(conn));
+			conn->connect(start_ns);
+		}
+
+		if ( shared_.opts.rate > 0 ) {
+			ticker_.reset(new lcy::asio::SteadyTimer(ioc, 1));
+			tick();
+		}
+	}
+
+	void finish()
+	{
+		ticker_.reset();
+
+		for ( auto& conn : connections_ ) {
+			conn->close();
+		}
+		connections_.clear();
+	}
+
+	Stats stats;
+
+private:
+	// The open loop timetable is checked every millisecond
+	void tick()
+	{
+		ticker_->async_wait([this](lcy::asio::errcode_type ec, lcy::asio::SteadyTimer::timeout_type){
+			if ( ec || !ticker_ ) {
+				return;
+			}
+
+			for ( auto& conn : connections_ ) {
+				conn->pump();
+			}
+			tick();
+		});
+	}
+
+private:
+	Shared& shared_;
+	std::unique_ptr<lcy::asio::SteadyTimer> ticker_;
+	std::vector<std::unique_ptr<Connection>> connections_;
+};
+
+/////////////////////////////////////////////////////////////
+
+static void usage()
+{
+	std::cerr <<
+		"usage : lcy_loadgen [options]\n"
+		"  --proto=http|rpc        protocol ( default http )\n"
+		"  --host=ADDR             loopback address ( default 127.0.0.1 )\n"
+		"  --port=N                target port ( default 8080 )\n"
+		"  --connections=N         total connections ( default 16 )\n"
+		"  --threads=N             IOContext threads ( default 1 )\n"
+		"  --pipeline=N            max requests in flight per connection ( default 1 )\n"
+		"  --rate=N                open loop requests per second, 0 = closed loop\n"
+		"  --duration=S            measured seconds ( default 10 )\n"
+		"  --warmup=S              unmeasured seconds before ( default 1 )\n"
+		"  --expected_interval=US  closed loop coordinated omission correction\n"
+		"  --body_size=N           request body / rpc arguments bytes\n"
+		"  --mix=LIST              http : METHOD:PATH[:WEIGHT],...  ( default GET:/ )\n"
+		"                          rpc  : Service.Method[:WEIGHT],...\n"
+		"  --format=console|json\n";
+}
+
+static bool parse_flag(const char* arg, const char* name, std::string& value)
+{
+	size_t len = ::strlen(name);
+	if ( ::strncmp(arg, name, len) != 0 || arg[len] != '=' ) {
+		return false;
+	}
+
+	value = arg + len + 1;
+	return true;
+}
+
+static bool parse_options(int argc, char* argv[], Options& opts)
+{
+	for ( int i = 1; i < argc; ++i ) {
+		std::string v;
+		const char* arg = argv[i];
+
+		if ( parse_flag(arg, "--proto", v) ) opts.proto = v;
+		else if ( parse_flag(arg, "--host", v) ) opts.host = v;
+		else if ( parse_flag(arg, "--port", v) ) opts.port = (uint16_t)::atoi(v.c_str());
+		else if ( parse_flag(arg, "--connections", v) ) opts.connections = ::strtoul(v.c_str(), nullptr, 10);
+		else if ( parse_flag(arg, "--threads", v) ) opts.threads = ::strtoul(v.c_str(), nullptr, 10);
+		else if ( parse_flag(arg, "--pipeline", v) ) opts.pipeline = ::strtoul(v.c_str(), nullptr, 10);
+		else if ( parse_flag(arg, "--rate", v) ) opts.rate = ::atof(v.c_str());
+		else if ( parse_flag(arg, "--duration", v) ) opts.duration = ::atof(v.c_str());
+		else if ( parse_flag(arg, "--warmup", v) ) opts.warmup = ::atof(v.c_str());
+		else if ( parse_flag(arg, "--expected_interval", v) ) opts.expected_interval_us = ::strtoull(v.c_str(), nullptr, 10);
+		else if ( parse_flag(arg, "--body_size", v) ) opts.body_size = ::strtoul(v.c_str(), nullptr, 10);
+		else if ( parse_flag(arg, "--mix", v) ) opts.mix = v;
+		else if ( parse_flag(arg, "--format", v) ) opts.format = v;
+		else {
+			std::cerr << "unknown option : " << arg << std::endl;
+			return false;
+		}
+	}
+
+	if ( opts.proto != "http" && opts.proto != "rpc" ) {
+		std::cerr << "--proto must be http or rpc" << std::endl;
+		return false;
+	}
+	if ( opts.connections == 0 || opts.threads == 0 || opts.pipeline == 0 || opts.duration <= 0 ) {
+		std::cerr << "--connections, --threads, --pipeline and --duration must be positive" << std::endl;
+		return false;
+	}
+	if ( opts.threads > opts.connections ) {
+		opts.threads = opts.connections;
+	}
+
+	return true;
+}
+
+/*
+* The generator must never be pointed at another machine,
+* only IPv4 127.0.0.0/8 and IPv6 ::1 are accepted.
+*/
+static bool is_loopback(std::string& host)
+{
+	if ( host == "localhost" ) {
+		host = "127.0.0.1";
+	}
+
+	unsigned char addr[16];
+	if ( ::inet_pton(AF_INET, host.c_str(), addr) == 1 ) {
+		return addr[0] == 127;
+	}
+	if ( ::inet_pton(AF_INET6, host.c_str(), addr) == 1 ) {
+		static const unsigned char loopback[16] = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+		return ::memcmp(addr, loopback, sizeof(addr)) == 0;
+	}
+
+	return false;
+}
+
+static std::vector<std::string> split(const std::string& str, char sep)
+{
+	std::vector<std::string> parts;
+	std::string part;
+	std::istringstream iss(str);
+	while ( std::getline(iss, part, sep) ) {
+		if ( !part.empty() ) {
+			parts.push_back(part);
+		}
+	}
+	return parts;
+}
+
+// Splits an optional trailing ":WEIGHT" off `entry`
+static size_t take_weight(std::string& entry)
+{
+	size_t colon = entry.rfind(':');
+	if ( colon == std::string::npos || colon + 1 == entry.size() ) {
+		return 1;
+	}
+
+	for ( size_t i = colon + 1; i < entry.size(); ++i ) {
+		if ( entry[i] < '0' || entry[i] > '9' ) {
+			return 1;
+		}
+	}
+
+	size_t weight = ::strtoul(entry.c_str() + colon + 1, nullptr, 10);
+	entry.resize(colon);
+	return weight;
+}
+
+static bool build_templates(Shared& shared)
+{
+	const Options& opts = shared.opts;
+	std::string mix = opts.mix;
+	if ( mix.empty() ) {
+		mix = opts.proto == "http" ? "GET:/" : "";
+	}
+
+	std::vector<std::string> entries = split(mix, ',');
+	if ( entries.empty() ) {
+		std::cerr << "--mix is required for rpc" << std::endl;
+		return false;
+	}
+
+	std::ostringstream host;
+	host << opts.host << ":" << opts.port;
+	std::string body(opts.body_size, 'x');
+
+	for ( auto& entry : entries ) {
+		RequestTemplate tpl;
+		tpl.weight = take_weight(entry);
+		tpl.name = entry;
+
+		if ( opts.proto == "http" ) {
+			size_t colon = entry.find(':');
+			if ( colon == std::string::npos ) {
+				std::cerr << "bad http mix entry : " << entry << std::endl;
+				return false;
+			}
+
+			http::Request request;
+			request.setMethod(http::StringToMethod(entry.substr(0, colon)));
+			if ( request.method() == http::method::INVALID ) {
+				std::cerr << "bad http method : " << entry << std::endl;
+				return false;
+			}
+			request.setUri(entry.substr(colon + 1));
+			request.setVersion(http::version::HTTP_1_1);
+			request.setHeader("Host", host.str());
+			request.setHeader("User-Agent", "lcy_loadgen");
+			if ( request.method() == http::method::POST || request.method() == http::method::PUT ) {
+				request.setHeader("Content-Length", std::to_string(body.size()));
+				request.setBody(body);
+			}
+			tpl.wire = request.dump();
+		} else {
+			size_t dot = entry.rfind('.');
+			if ( dot == std::string::npos ) {
+				std::cerr << "bad rpc mix entry : " << entry << std::endl;
+				return false;
+			}
+
+			tpl.rpc.set_tp(lcy::rpc::type::request);
+			tpl.rpc.mutable_request()->set_service_name(entry.substr(0, dot));
+			tpl.rpc.mutable_request()->set_service_method(entry.substr(dot + 1));
+			tpl.rpc.mutable_request()->set_arguments(body);
+		}
+
+		for ( size_t w = 0; w < tpl.weight; ++w ) {
+			shared.schedule.push_back(shared.templates.size());
+		}
+		shared.templates.push_back(std::move(tpl));
+	}
+
+	if ( shared.schedule.empty() ) {
+		std::cerr << "--mix has no positive weight" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+static void report(const Shared& shared, const Stats& stats)
+{
+	const Options& opts = shared.opts;
+	const lcy::bench::Histogram& h = stats.latency;
+	double seconds = opts.duration;
+	static const double percentiles[] = { 50, 75, 90, 99, 99.9, 99.99 };
+
+	if ( opts.format == "json" ) {
+		std::cout << "{\n"
+				  << "  \"proto\": \"" << opts.proto << "\",\n"
+				  << "  \"mode\": \"" << (opts.rate > 0 ? "open" : "closed") << "\",\n"
+				  << "  \"connections\": " << opts.connections << ",\n"
+				  << "  \"threads\": " << opts.threads << ",\n"
+				  << "  \"pipeline\": " << opts.pipeline << ",\n"
+				  << "  \"target_rate\": " << opts.rate << ",\n"
+				  << "  \"duration_s\": " << seconds << ",\n"
+				  << "  \"requests\": " << stats.completed << ",\n"
+				  << "  \"requests_per_second\": " << stats.completed / seconds << ",\n"
+				  << "  \"failed\": " << stats.failed << ",\n"
+				  << "  \"socket_errors\": " << stats.socket_errors << ",\n"
+				  << "  \"connect_errors\": " << stats.connect_errors << ",\n"
+				  << "  \"bytes_sent\": " << stats.bytes_sent << ",\n"
+				  << "  \"bytes_received\": " << stats.bytes_received << ",\n"
+				  << "  \"latency_ns\": {\n"
+				  << "    \"samples\": " << h.count() << ",\n"
+				  << "    \"min\": " << h.min() << ",\n"
+				  << "    \"mean\": " << (uint64_t)h.mean() << ",\n"
+				  << "    \"max\": " << h.max();
+		for ( double p : percentiles ) {
+			std::cout << ",\n    \"p" << p << "\": " << h.percentile(p);
+		}
+		std::cout << "\n  }\n}" << std::endl;
+		return;
+	}
+
+	char line[128];
+	std::cout << opts.proto << " " << (opts.rate > 0 ? "open" : "closed") << " loop, "
+			  << opts.connections << " connections, " << opts.threads << " threads, pipeline "
+			  << opts.pipeline << std::endl;
+	::snprintf(line, sizeof(line), "  requests      %12llu  ( %.1f/s )",
+			   (unsigned long long)stats.completed, stats.completed / seconds);
+	std::cout << line << std::endl;
+	::snprintf(line, sizeof(line), "  failed        %12llu", (unsigned long long)stats.failed);
+	std::cout << line << std::endl;
+	::snprintf(line, sizeof(line), "  socket errors %12llu  connect errors %llu",
+			   (unsigned long long)stats.socket_errors, (unsigned long long)stats.connect_errors);
+	std::cout << line << std::endl;
+	::snprintf(line, sizeof(line), "  transfer      %12.2f MiB/s out, %.2f MiB/s in",
+			   stats.bytes_sent / seconds / 1048576, stats.bytes_received / seconds / 1048576);
+	std::cout << line << std::endl;
+
+	std::cout << "  latency ( us )" << std::endl;
+	::snprintf(line, sizeof(line), "    min %10.1f  mean %10.1f  max %10.1f",
+			   h.min() / 1e3, h.mean() / 1e3, h.max() / 1e3);
+	std::cout << line << std::endl;
+	for ( double p : percentiles ) {
+		::snprintf(line, sizeof(line), "    p%-7g %10.1f", p, h.percentile(p) / 1e3);
+		std::cout << line << std::endl;
+	}
+}
+
+}	// namespace
+
+int main(int argc, char* argv[])
+{
+	Shared shared;
+	for ( int i = 1; i < argc; ++i ) {
+		if ( ::strcmp(argv[i], "--help") == 0 ) {
+			usage();
+			return 0;
+		}
+	}
+
+	if ( !parse_options(argc, argv, shared.opts) ) {
+		usage();
+		return 2;
+	}
+
+	const Options& opts = shared.opts;
+	if ( !is_loopback(shared.opts.host) ) {
+		std::cerr << "refusing non loopback target " << opts.host << std::endl;
+		return 2;
+	}
+	if ( !build_templates(shared) ) {
+		return 2;
+	}
+
+	shared.endpoint = Endpoint(opts.host, opts.port);
+	shared.stopping.store(false);
+
+	uint64_t start_ns = now_ns();
+	shared.measure_begin_ns.store(start_ns + (uint64_t)(opts.warmup * 1e9));
+	shared.measure_end_ns.store(shared.measure_begin_ns.load() + (uint64_t)(opts.duration * 1e9));
+
+	lcy::asio::ThreadPool pool(opts.threads);
+	pool.start();
+
+	std::vector<std::unique_ptr<Worker>> workers;
+	std::vector<lcy::asio::IOContext*> contexts;
+	size_t first = 0;
+	for ( size_t t = 0; t < opts.threads; ++t ) {
+		size_t count = opts.connections / opts.threads + (t < opts.connections % opts.threads ? 1 : 0);
+
+		lcy::asio::IOContext& ioc = pool.nextContext();
+		Worker* worker = new Worker(shared);
+		workers.push_back(std::unique_ptr<Worker>(worker));
+		contexts.push_back(&ioc);
+
+		lcy::asio::post(ioc, [worker, &ioc, first, count, start_ns](){
+			worker->start(ioc, first, count, start_ns);
+		});
+		first += count;
+	}
+
+	std::this_thread::sleep_for(std::chrono::duration<double>(opts.warmup + opts.duration));
+	shared.stopping.store(true);
+
+	// Sockets have to be torn down on their own loop before the pool goes away
+	std::atomic<size_t> finished(0);
+	for ( size_t t = 0; t < workers.size(); ++t ) {
+		Worker* worker = workers[t].get();
+		lcy::asio::post(*contexts[t], [worker, &finished](){
+			worker->finish();
+			++finished;
+		});
+	}
+	while ( finished.load() != workers.size() ) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	pool.stop();
+
+	Stats total;
+	for ( auto& worker : workers ) {
+		total.merge(worker->stats);
+	}
+	report(shared, total);
+
+	return total.completed > 0 ? 0 : 1;
+}
@@ -1,34 +1,28 @@
 #include <lcy/asio/asio.hpp>
-#include "../../tcp_server.hpp"
-#include "http_connection.h"
+#include <lcy/protocol/protocol.hpp>
 
 #include <iostream>
 #include <signal.h>
 
-typedef TCPServer<HttpConnection> HttpServer;
 
-
-void http_op(const lcy::protocol::http::Request& request,
+void http_op(const lcy::protocol::http::RequestView& request,
 			 lcy::protocol::http::Response& response)
 {
-//	std::cout << "request:\n" << request.dump() << std::endl;
+//	std::cout << "request:\n" << request.toRequest().dump() << std::endl;
 	
-	response.setVersion(request.version());	
 	response.setState(lcy::protocol::http::state::OK);
 }
 
-void initOp(HttpConnection& conn)
-{
-	conn.setHttpOperation(http_op);
-}
-
 int main() {
 	lcy::asio::IOContext ioc;
 	lcy::asio::SignalSet sigset(ioc, SIGINT);
 	lcy::asio::ip::Endpoint endpoint("0.0.0.0", 9950);
 
-	sigset.async_wait([&ioc](lcy::asio::errcode_type ec, int signum){
+	lcy::protocol::http::Server server(ioc, 6);
+
+	sigset.async_wait([&ioc, &server](lcy::asio::errcode_type ec, int signum){
 		if ( !ec ) {
+			server.stop();
 			ioc.quit();
 		} else {
 			std::cout << "sigset async_wait : " 
@@ -42,10 +36,12 @@ int main() {
 			  << endpoint.port() 
 			  << std::endl;
 
-	HttpServer server(ioc, 6);
-	
-	server.setConnInitOp(initOp);
-	server.start(endpoint);
+	server.setHandler(http_op);
+	lcy::asio::errcode_type ec = server.start(endpoint);
+	if ( ec ) {
+		std::cout << "server start : " << lcy::asio::errinfo(ec) << std::endl;
+		return 1;
+	}
 
 	ioc.loop_wait();
 
@@ -1,14 +1,41 @@
 #ifndef __LCY_PROTOCOL_HPP__
 #define __LCY_PROTOCOL_HPP__
 
+#include "src/string_view.h"
+
 #include "src/http/message.h"
 #include "src/http/request.h"
 #include "src/http/response.h"
 #include "src/http/parser.h"
 #include "src/http/servlet.h"
+#include "src/http/request_view.h"
+#include "src/http/scan.h"
+#include "src/http/date_clock.h"
+#include "src/http/serializer.h"
+#include "src/http/server.h"
+#include "src/http/router.h"
+#include "src/http/open_file.h"
+#include "src/http/file_cache.h"
+#include "src/http/static_files.h"
+#include "src/http/response_cache.h"
+#include "src/http/compression.h"
+#include "src/http/client.h"
+
+#include "src/websocket/frame.h"
+#include "src/websocket/deflate.h"
+#include "src/websocket/handshake.h"
+#include "src/websocket/connection.h"
+
+#include "src/http2/frame.h"
+#include "src/http2/hpack.h"
+#include "src/http2/session.h"
 
 #include "src/tlv/variant_encode.h"
 #include "src/tlv/message.h"
 #include "src/tlv/parser.h"
+#include "src/tlv/message_view.h"
+#include "src/tlv/serializer.h"
+#include "src/tlv/batch_decoder.h"
+#include "src/tlv/record.hpp"
 
 #endif // __LCY_PROTOCOL_HPP__
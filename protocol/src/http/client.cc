@@ -0,0 +1,1036 @@
+#include "lcy/protocol/src/http/client.h"
+#include "lcy/protocol/src/http/parser.h"
+#include "lcy/protocol/src/http/request.h"
+#include "lcy/protocol/src/http/response.h"
+#include "lcy/protocol/src/http/serializer.h"
+#include "lcy/protocol/src/http/compression.h"
+#include "lcy/protocol/src/http/details/util.h"
+
+#include "lcy/asio/src/io_context.hpp"
+#include "lcy/asio/src/steady_timer.h"
+#include "lcy/asio/src/dynamic_buffer.h"
+#include "lcy/asio/src/ip/tcp.h"
+#include "lcy/asio/src/details/timer_service.h"
+
+#include <list>
+#include <deque>
+#include <vector>
+#include <iterator>
+#include <initializer_list>
+#include <algorithm>
+#include <unordered_map>
+#include <errno.h>
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+static const StringView kChunked("chunked", 7);
+
+// RFC 9110 9.2.2, safe to send twice
+static bool Idempotent(method_type m)
+{
+	switch ( m ) {
+	case method::GET:
+	case method::HEAD:
+	case method::PUT:
+	case method::DELETE:
+	case method::OPTIONS:
+	case method::TRACE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Decodes a gzip or deflate body in place, any other coding is left as it is
+static asio::errcode_type Decode(Response& response, size_t max_bytes)
+{
+	StringView encoding(response.getHeader(field::CONTENT_ENCODING));
+	coding_type c = coding::IDENTITY;
+	if ( encoding.iequals("gzip") || encoding.iequals("x-gzip") ) {
+		c = coding::GZIP;
+	} else if ( encoding.iequals("deflate") ) {
+		c = coding::DEFLATE;
+	}
+	if ( c == coding::IDENTITY || response.body().empty() ) {
+		return asio::err::SUCCESS;
+	}
+
+	std::string body;
+	if ( !Decompress(c, StringView(response.body()), body, max_bytes) ) {
+		return EPROTO;
+	}
+
+	response.removeHeader(field::CONTENT_ENCODING);
+	if ( response.hasHeader(field::CONTENT_LENGTH) ) {
+		response.setHeader(field::CONTENT_LENGTH, std::to_string(body.size()));
+	}
+	response.setBody(std::move(body));
+	return asio::err::SUCCESS;
+}
+
+// the earlier of two deadlines, 0 : none
+static time_t Earliest(time_t lhs, time_t rhs)
+{
+	if ( lhs == 0 || (rhs != 0 && rhs < lhs) ) {
+		return rhs;
+	}
+	return lhs;
+}
+
+///////////////////////////////////////////////////////////////
+
+struct ClientConfig {
+	time_t connect_timeout;
+	time_t request_timeout;
+	time_t idle_timeout;
+	size_t max_connections;
+	size_t max_in_flight;
+	size_t max_queued;
+	size_t pipelining;
+	size_t max_body_bytes;
+	bool decompression;
+};
+
+// One request, from request() until its handler is called
+struct ClientExchange {
+	std::string wire;		// serialized once, sent again as it is on a retry
+	bool head;				// the response has no body whatever its head says
+	bool idempotent;
+	bool close;				// the request ends its connection
+	bool retried;
+	time_t deadline;		// 0 : none, set when handed to a connection
+	Client::data_handler_type on_data;
+	Client::response_handler_type handler;
+};
+
+typedef std::unique_ptr<ClientExchange> exchange_ptr;
+typedef std::deque<exchange_ptr> exchange_queue_type;
+
+class ClientConnection;
+typedef std::shared_ptr<ClientConnection> connection_ptr;
+typedef std::list<connection_ptr> connection_list_type;
+
+struct ClientHost {
+	asio::ip::Endpoint endpoint;
+	std::string host;		// Host field of its requests
+	connection_list_type connections;		// the most recently idle first
+	exchange_queue_type queue;
+	size_t in_flight;
+};
+
+///////////////////////////////////////////////////////////////
+
+/*
+* notify :
+*	Requests are appended to out_[filling_] while out_[filling_ ^ 1] is being
+*	written, as in ServerConnection. sent_ holds the requests of the connection in
+*	order, the first one is the response being read.
+*/
+class ClientConnection :
+	public std::enable_shared_from_this<ClientConnection>
+{
+public:
+	ClientConnection(Client::Impl& client, ClientHost& host);
+	~ClientConnection();
+
+	void start(connection_list_type::iterator self);
+	void send(exchange_ptr exchange);
+	// fails or requeues the requests left, see Client for which are sent again
+	void close(asio::errcode_type ec);
+
+	bool idle() const;
+	bool accepts(size_t depth) const;		// a pipelined request behind the others
+	size_t outstanding() const;
+	bool expired(time_t now) const;
+
+private:
+	ClientConnection(const ClientConnection&);
+	ClientConnection& operator=(const ClientConnection&);
+
+	void connect();
+	void onConnect(asio::errcode_type ec);
+	void startRead();
+	void onRead(asio::errcode_type ec, size_t nread);
+	void onWrite(asio::errcode_type ec, size_t nwrite);
+	void flush();
+
+	void process();
+	bool deliver(StringView piece);
+	void complete();
+	void refresh(time_t now);
+
+private:
+	Client::Impl& client_;
+	ClientHost& host_;
+	asio::ip::TCP::Socket socket_;
+	asio::DynamicBuffer in_;
+	asio::DynamicBuffer out_[2];
+	size_t filling_;
+
+	Parser parser_;
+	Response response_;
+	std::string body_;		// collected body of response_
+
+	exchange_queue_type sent_;
+	connection_list_type::iterator self_;
+	time_t connect_deadline_;	// 0 : none
+	time_t deadline_;			// 0 : none
+
+	bool started_;
+	bool connecting_;
+	bool reading_;
+	bool writing_;
+	bool head_done_;		// the head of the first response of sent_ is parsed
+	bool until_close_;		// its body ends with the connection
+	bool received_;			// a byte of it has arrived
+	bool reused_;			// a response was read before, the peer may have dropped us since
+	bool reusable_;			// nothing said close yet
+	bool closed_;
+};
+
+///////////////////////////////////////////////////////////////
+
+class Client::Impl {
+public:
+	Impl(asio::IOContext& ioc);
+	~Impl();
+
+	asio::IOContext& context();
+	ClientConfig& config();
+
+	void request(const asio::ip::Endpoint& endpoint, Request& request,
+				 data_handler_type on_data, response_handler_type handler);
+	void close();
+
+	size_t connections() const;
+	size_t idleConnections() const;
+	size_t inFlight() const;
+	size_t queued() const;
+
+	// ClientConnection
+	void dispatch(ClientHost& host);
+	void idle(ClientHost& host, connection_list_type::iterator iter);
+	void remove(ClientHost& host, connection_list_type::iterator iter);
+
+private:
+	Impl(const Impl&);
+	Impl& operator=(const Impl&);
+
+	ClientHost& hostOf(const asio::ip::Endpoint& endpoint);
+	connection_ptr pick(ClientHost& host, const ClientExchange& exchange);
+	void fail(response_handler_type handler, asio::errcode_type ec);
+	void startSweep();
+	void sweep();
+
+private:
+	typedef std::unordered_map<
+				std::string,
+				std::unique_ptr<ClientHost>
+			> host_umap_type;
+
+	asio::IOContext& ioc_;
+	ClientConfig config_;
+	host_umap_type hosts_;
+	asio::DynamicBuffer scratch_;		// requests are serialized here first
+	size_t connections_;
+	bool closing_;
+	bool sweeping_;
+	std::unique_ptr<asio::SteadyTimer> sweep_timer_;		// made once the settings are final
+};
+
+///////////////////////////////////////////////////////////////
+
+ClientConnection::ClientConnection(Client::Impl& client, ClientHost& host) :
+	client_(client),
+	host_(host),
+	socket_(client.context()),
+	in_(Client::READ_BUFFER_BYTES),
+	filling_(0),
+	connect_deadline_(0),
+	deadline_(0),
+	started_(false),
+	connecting_(false),
+	reading_(false),
+	writing_(false),
+	head_done_(false),
+	until_close_(false),
+	received_(false),
+	reused_(false),
+	reusable_(true),
+	closed_(false)
+{
+}
+
+ClientConnection::~ClientConnection()
+{
+}
+
+void ClientConnection::start(connection_list_type::iterator self)
+{
+	self_ = self;
+}
+
+void ClientConnection::send(exchange_ptr exchange)
+{
+	auto self = shared_from_this();
+	time_t now = asio::details::now_ms();
+
+	const ClientConfig& config = client_.config();
+	exchange->deadline = config.request_timeout > 0 ? now + config.request_timeout : 0;
+	if ( exchange->close ) {
+		reusable_ = false;
+	}
+
+	details::Append(out_[filling_], StringView(exchange->wire));
+	sent_.push_back(std::move(exchange));
+	if ( sent_.size() == 1 ) {
+		refresh(now);
+	}
+
+	if ( !started_ ) {
+		started_ = true;
+		connect();
+	} else {
+		flush();
+	}
+}
+
+void ClientConnection::close(asio::errcode_type ec)
+{
+	if ( closed_ ) {
+		return;
+	}
+	closed_ = true;
+
+	if ( ec == asio::err::EFDHUP ) {
+		ec = socket_.error();		// a reset, or a refused connect
+	}
+
+	// remove() drops the pool's reference : `self` keeps this alive to the end, while
+	// the reads and writes canceled by shutdown() hold theirs until they complete
+	auto self = shared_from_this();
+	socket_.shutdown();
+	client_.remove(host_, self_);
+
+	exchange_queue_type left;
+	left.swap(sent_);
+	host_.in_flight -= left.size();
+
+	/*
+	* The first request may have met a keep-alive connection the peer closed meanwhile,
+	* the ones behind it were never answered : idempotent ones go back to the queue.
+	*/
+	bool retry_first = reused_ && !received_ && ec != ETIMEDOUT;
+	std::vector<exchange_ptr> failed;
+	exchange_queue_type retries;
+	for ( size_t i = 0; i < left.size(); ++i ) {
+		exchange_ptr& exchange = left[i];
+		if ( ec != ECANCELED && exchange->idempotent && !exchange->retried && (i > 0 || retry_first) ) {
+			exchange->retried = true;
+			retries.push_back(std::move(exchange));
+		} else {
+			failed.push_back(std::move(exchange));
+		}
+	}
+	host_.queue.insert(host_.queue.begin(),
+					   std::make_move_iterator(retries.begin()),
+					   std::make_move_iterator(retries.end()));
+
+	if ( ec == asio::err::SUCCESS ) {
+		ec = ECONNRESET;
+	}
+	for ( exchange_ptr& exchange : failed ) {
+		Response response;
+		Client::response_handler_type handler = std::move(exchange->handler);
+		exchange.reset();
+		handler(ec, response);
+	}
+
+	client_.dispatch(host_);
+}
+
+bool ClientConnection::idle() const
+{
+	return !closed_ && started_ && !connecting_ && reusable_ && sent_.empty();
+}
+
+bool ClientConnection::accepts(size_t depth) const
+{
+	return !closed_ && reusable_ && !sent_.empty() && sent_.size() < depth && sent_.back()->idempotent;
+}
+
+size_t ClientConnection::outstanding() const
+{
+	return sent_.size();
+}
+
+bool ClientConnection::expired(time_t now) const
+{
+	return deadline_ != 0 && deadline_ <= now;
+}
+
+void ClientConnection::connect()
+{
+	const ClientConfig& config = client_.config();
+	time_t now = asio::details::now_ms();
+
+	connecting_ = true;
+	connect_deadline_ = config.connect_timeout > 0 ? now + config.connect_timeout : 0;
+	refresh(now);
+
+	asio::errcode_type ec = socket_.open(host_.endpoint.isV6() ? asio::ip::TCP::v6() : asio::ip::TCP::v4());
+	if ( ec ) {
+		close(ec);
+		return;
+	}
+	socket_.setDelay();
+
+	// may complete at once on loopback
+	auto self = shared_from_this();
+	socket_.async_connect(host_.endpoint, [this, self](asio::errcode_type ec){
+		onConnect(ec);
+	});
+}
+
+void ClientConnection::onConnect(asio::errcode_type ec)
+{
+	if ( closed_ ) {
+		return;
+	}
+
+	if ( ec ) {
+		close(ec);
+		return;
+	}
+
+	connecting_ = false;
+	connect_deadline_ = 0;
+	refresh(asio::details::now_ms());
+
+	startRead();
+	flush();
+}
+
+/*
+* A read is pending whenever the connection is up, so an idle connection the peer
+* closes leaves the pool at once.
+*/
+void ClientConnection::startRead()
+{
+	if ( reading_ || connecting_ || closed_ ) {
+		return;
+	}
+
+	in_.reserve(Client::READ_BUFFER_BYTES);
+	reading_ = true;
+
+	auto self = shared_from_this();
+	socket_.async_read(asio::buffer(in_.writeBegin(), in_.availableBytes()),
+			[this, self](asio::errcode_type ec, size_t nread){
+		onRead(ec, nread);
+	});
+}
+
+void ClientConnection::onRead(asio::errcode_type ec, size_t nread)
+{
+	reading_ = false;
+	if ( closed_ ) {
+		return;
+	}
+
+	if ( ec || nread == 0 ) {		// error or peer closed
+		if ( until_close_ && head_done_ && !ec ) {
+			complete();			// the close ends the body, and the connection with it
+			return;
+		}
+		close(ec ? ec : ECONNRESET);
+		return;
+	}
+
+	in_.write(nread);
+	process();
+	startRead();
+}
+
+void ClientConnection::onWrite(asio::errcode_type ec, size_t)
+{
+	writing_ = false;
+	if ( closed_ ) {
+		return;
+	}
+
+	if ( ec ) {
+		close(ec);
+		return;
+	}
+
+	asio::DynamicBuffer& sent = out_[filling_ ^ 1];
+	sent.read(sent.dataBytes());
+
+	// requests appended meanwhile
+	flush();
+}
+
+void ClientConnection::flush()
+{
+	if ( writing_ || connecting_ || closed_ ) {
+		return;
+	}
+
+	asio::DynamicBuffer& out = out_[filling_];
+	if ( out.dataBytes() == 0 ) {
+		return;
+	}
+
+	// a request usually fits the socket buffer, the reactor only waits for the rest
+	asio::errcode_type ec = asio::err::SUCCESS;
+	out.read(socket_.write_some(asio::buffer(out.readBegin(), out.dataBytes()), ec));
+	if ( ec ) {
+		close(ec);
+		return;
+	}
+	if ( out.dataBytes() == 0 ) {
+		return;
+	}
+
+	writing_ = true;
+	filling_ ^= 1;
+
+	auto self = shared_from_this();
+	socket_.async_write(asio::buffer(out.readBegin(), out.dataBytes()),
+			[this, self](asio::errcode_type ec, size_t nwrite){
+		onWrite(ec, nwrite);
+	});
+}
+
+/*
+* Every response complete in the buffer is handed out, a handler may send the next
+* request or close the client meanwhile.
+*/
+void ClientConnection::process()
+{
+	auto self = shared_from_this();
+
+	while ( !closed_ ) {
+		if ( sent_.empty() ) {
+			if ( in_.dataBytes() > 0 ) {
+				close(EPROTO);		// nothing was asked
+			}
+			return;
+		}
+
+		if ( !head_done_ ) {
+			if ( in_.dataBytes() == 0 ) {
+				return;
+			}
+			received_ = true;
+
+			Parser::RetCode retcode = parser_.parseHead(in_.readBegin(), in_.dataBytes(), response_);
+			if ( retcode == Parser::RetCode::WAITING_DATA ) {
+				return;
+			}
+			if ( retcode == Parser::RetCode::ERROR ) {
+				close(EPROTO);
+				return;
+			}
+			in_.read(parser_.nparse());
+
+			int code = (int)response_.state();
+			if ( code < 200 && code != (int)state::SWITCHING_PROTOCOLS ) {
+				parser_.reset();		// interim response, the final one follows
+				response_.clear();
+				continue;
+			}
+			head_done_ = true;
+
+			if ( code == (int)state::SWITCHING_PROTOCOLS ) {
+				reusable_ = false;		// no longer HTTP
+			}
+			if ( sent_.front()->head || code < 200 || code == (int)state::NO_CONTENT ||
+				 code == (int)state::NOT_MODIFIED ) {
+				complete();
+				continue;
+			}
+			if ( !response_.hasHeader(field::CONTENT_LENGTH) &&
+				 !details::HasToken(StringView(response_.getHeader(field::TRANSFER_ENCODING)), kChunked) ) {
+				until_close_ = true;
+				reusable_ = false;
+			}
+			continue;
+		}
+
+		StringView piece;
+		size_t nparse = 0;
+		Parser::RetCode retcode = Parser::RetCode::WAITING_DATA;
+		if ( until_close_ ) {
+			piece = StringView(in_.readBegin(), in_.dataBytes());
+			nparse = piece.size();
+		} else {
+			retcode = parser_.parseBody(in_.readBegin(), in_.dataBytes(), piece, nparse);
+			if ( retcode == Parser::RetCode::ERROR ) {
+				close(EPROTO);
+				return;
+			}
+		}
+
+		if ( !piece.empty() && !deliver(piece) ) {
+			return;
+		}
+		in_.read(nparse);
+
+		if ( retcode == Parser::RetCode::READY ) {
+			complete();
+		} else if ( nparse == 0 ) {
+			return;
+		}
+	}
+}
+
+// false when the connection is gone after it
+bool ClientConnection::deliver(StringView piece)
+{
+	ClientExchange& exchange = *sent_.front();
+	if ( !exchange.on_data ) {
+		size_t max_bytes = client_.config().max_body_bytes;
+		if ( max_bytes != 0 && body_.size() + piece.size() > max_bytes ) {
+			close(EMSGSIZE);
+			return false;
+		}
+		body_.append(piece.data(), piece.size());
+		return true;
+	}
+
+	// held here : the handler may close the connection, and the exchange with it
+	Client::data_handler_type on_data = std::move(exchange.on_data);
+	on_data(piece);
+	if ( closed_ ) {
+		return false;
+	}
+	sent_.front()->on_data = std::move(on_data);
+	return true;
+}
+
+void ClientConnection::complete()
+{
+	exchange_ptr exchange = std::move(sent_.front());
+	sent_.pop_front();
+	--host_.in_flight;
+
+	bool keep_alive = reusable_ && details::KeepAlive(response_);
+	head_done_ = false;
+	until_close_ = false;
+	received_ = false;
+	reused_ = true;
+	parser_.reset();
+
+	asio::errcode_type ec = asio::err::SUCCESS;
+	if ( !exchange->on_data ) {
+		response_.setBody(std::move(body_));
+		body_ = std::string();
+		if ( client_.config().decompression ) {
+			ec = Decode(response_, client_.config().max_body_bytes);
+		}
+	}
+
+	// the connection is settled before the handler can send again
+	if ( !keep_alive ) {
+		reusable_ = false;
+		close(asio::err::SUCCESS);
+	} else {
+		refresh(asio::details::now_ms());
+		if ( sent_.empty() ) {
+			client_.idle(host_, self_);
+		}
+	}
+
+	Client::response_handler_type handler = std::move(exchange->handler);
+	exchange.reset();
+	handler(ec, response_);
+	response_.clear();
+
+	client_.dispatch(host_);
+}
+
+// The first request bounds the connection, or the connect, or the idle timeout
+void ClientConnection::refresh(time_t now)
+{
+	const ClientConfig& config = client_.config();
+
+	if ( sent_.empty() ) {
+		deadline_ = config.idle_timeout > 0 ? now + config.idle_timeout : 0;
+		return;
+	}
+
+	deadline_ = sent_.front()->deadline;
+	if ( connecting_ ) {
+		deadline_ = Earliest(deadline_, connect_deadline_);
+	}
+}
+
+///////////////////////////////////////////////////////////////
+
+Client::Impl::Impl(asio::IOContext& ioc) :
+	ioc_(ioc),
+	connections_(0),
+	closing_(false),
+	sweeping_(false)
+{
+	config_.connect_timeout = DEFAULT_CONNECT_TIMEOUT_MS;
+	config_.request_timeout = DEFAULT_REQUEST_TIMEOUT_MS;
+	config_.idle_timeout = DEFAULT_IDLE_TIMEOUT_MS;
+	config_.max_connections = DEFAULT_MAX_CONNECTIONS_PER_HOST;
+	config_.max_in_flight = DEFAULT_MAX_IN_FLIGHT_PER_HOST;
+	config_.max_queued = 0;
+	config_.pipelining = 1;
+	config_.max_body_bytes = DEFAULT_MAX_BODY_BYTES;
+	config_.decompression = false;
+}
+
+Client::Impl::~Impl()
+{
+	close();
+	closing_ = true;		// requests from the handlers above only get ECANCELED
+	sweep_timer_.reset();
+}
+
+asio::IOContext& Client::Impl::context()
+{
+	return ioc_;
+}
+
+ClientConfig& Client::Impl::config()
+{
+	return config_;
+}
+
+void Client::Impl::request(const asio::ip::Endpoint& endpoint, Request& request,
+						   data_handler_type on_data, response_handler_type handler)
+{
+	if ( closing_ ) {
+		fail(std::move(handler), ECANCELED);
+		return;
+	}
+
+	ClientHost& host = hostOf(endpoint);
+	if ( config_.max_queued != 0 && host.queue.size() >= config_.max_queued ) {
+		fail(std::move(handler), EAGAIN);
+		return;
+	}
+
+	if ( !request.hasHeader(field::HOST) ) {
+		request.setHeader(field::HOST, host.host);
+	}
+	if ( request.version() == version::HTTP_ERR ) {
+		request.setVersion(version::HTTP_1_1);
+	}
+	if ( config_.decompression && !request.hasHeader(field::ACCEPT_ENCODING) ) {
+		request.setHeader(field::ACCEPT_ENCODING, "gzip, deflate");
+	}
+
+	exchange_ptr exchange(new ClientExchange());
+	exchange->head = request.method() == method::HEAD;
+	exchange->idempotent = Idempotent(request.method());
+	exchange->close = !details::KeepAlive(request);
+	exchange->retried = false;
+	exchange->deadline = 0;
+	exchange->on_data = std::move(on_data);
+	exchange->handler = std::move(handler);
+
+	size_t size = SerializeRequest(request, scratch_);
+	exchange->wire.assign(scratch_.readBegin(), size);
+	scratch_.read(size);
+
+	host.queue.push_back(std::move(exchange));
+	dispatch(host);
+}
+
+void Client::Impl::close()
+{
+	closing_ = true;
+
+	for ( auto& kv : hosts_ ) {
+		ClientHost& host = *kv.second;
+
+		connection_list_type connections = host.connections;		// close() erases from the list
+		for ( const connection_ptr& conn : connections ) {
+			conn->close(ECANCELED);
+		}
+
+		exchange_queue_type queue;
+		queue.swap(host.queue);
+		for ( exchange_ptr& exchange : queue ) {
+			Response response;
+			response_handler_type handler = std::move(exchange->handler);
+			exchange.reset();
+			handler(ECANCELED, response);
+		}
+	}
+
+	closing_ = false;
+}
+
+size_t Client::Impl::connections() const
+{
+	return connections_;
+}
+
+size_t Client::Impl::idleConnections() const
+{
+	size_t count = 0;
+	for ( const auto& kv : hosts_ ) {
+		for ( const connection_ptr& conn : kv.second->connections ) {
+			count += conn->idle() ? 1 : 0;
+		}
+	}
+	return count;
+}
+
+size_t Client::Impl::inFlight() const
+{
+	size_t count = 0;
+	for ( const auto& kv : hosts_ ) {
+		count += kv.second->in_flight;
+	}
+	return count;
+}
+
+size_t Client::Impl::queued() const
+{
+	size_t count = 0;
+	for ( const auto& kv : hosts_ ) {
+		count += kv.second->queue.size();
+	}
+	return count;
+}
+
+/*
+* Hands queued requests to connections while the host has room : called after
+* anything that may free a connection or a slot.
+*/
+void Client::Impl::dispatch(ClientHost& host)
+{
+	if ( closing_ ) {
+		return;
+	}
+
+	while ( !host.queue.empty() ) {
+		if ( config_.max_in_flight != 0 && host.in_flight >= config_.max_in_flight ) {
+			return;
+		}
+
+		connection_ptr conn = pick(host, *host.queue.front());
+		if ( !conn ) {
+			return;
+		}
+
+		exchange_ptr exchange = std::move(host.queue.front());
+		host.queue.pop_front();
+		++host.in_flight;
+		conn->send(std::move(exchange));
+	}
+}
+
+void Client::Impl::idle(ClientHost& host, connection_list_type::iterator iter)
+{
+	host.connections.splice(host.connections.begin(), host.connections, iter);
+}
+
+void Client::Impl::remove(ClientHost& host, connection_list_type::iterator iter)
+{
+	host.connections.erase(iter);
+	--connections_;
+}
+
+ClientHost& Client::Impl::hostOf(const asio::ip::Endpoint& endpoint)
+{
+	std::string host = endpoint.isV6() ? "[" + endpoint.ip() + "]" : endpoint.ip();
+	host += ':';
+	host += std::to_string(endpoint.port());
+
+	std::unique_ptr<ClientHost>& slot = hosts_[host];
+	if ( !slot ) {
+		slot.reset(new ClientHost());
+		slot->endpoint = endpoint;
+		slot->host = std::move(host);
+		slot->in_flight = 0;
+	}
+	return *slot;
+}
+
+// An idle connection, else a new one, else the least busy one that pipelines
+connection_ptr Client::Impl::pick(ClientHost& host, const ClientExchange& exchange)
+{
+	for ( const connection_ptr& conn : host.connections ) {
+		if ( conn->idle() ) {
+			return conn;
+		}
+	}
+
+	if ( host.connections.size() < config_.max_connections ) {
+		connection_ptr conn = std::make_shared<ClientConnection>(*this, host);
+		conn->start(host.connections.insert(host.connections.end(), conn));
+		++connections_;
+		startSweep();
+		return conn;
+	}
+
+	connection_ptr best;
+	if ( config_.pipelining > 1 && exchange.idempotent && !exchange.close ) {
+		for ( const connection_ptr& conn : host.connections ) {
+			if ( conn->accepts(config_.pipelining) && (!best || conn->outstanding() < best->outstanding()) ) {
+				best = conn;
+			}
+		}
+	}
+	return best;
+}
+
+/*
+* Never from within request() : the answer comes from the next round of the loop
+* ( asio::post() would run it at once on the loop thread ).
+*/
+void Client::Impl::fail(response_handler_type handler, asio::errcode_type ec)
+{
+	asio::use_service<asio::details::BridgeService>(ioc_).push([handler, ec](){
+		Response response;
+		handler(ec, response);
+	});
+}
+
+void Client::Impl::startSweep()
+{
+	if ( sweeping_ ) {
+		return;
+	}
+	if ( !sweep_timer_ ) {
+		sweep_timer_.reset(new asio::SteadyTimer(ioc_, details::SweepInterval({
+				config_.connect_timeout, config_.request_timeout, config_.idle_timeout })));
+	}
+	sweeping_ = true;
+	sweep();
+}
+
+// Runs while there are connections, stops with the last one
+void Client::Impl::sweep()
+{
+	sweep_timer_->async_wait([this](asio::errcode_type ec, asio::SteadyTimer::timeout_type){
+		if ( ec ) {
+			return;		// canceled by the destructor
+		}
+
+		time_t now = asio::details::now_ms();
+		for ( auto& kv : hosts_ ) {
+			connection_list_type connections = kv.second->connections;		// close() erases from the list
+			for ( const connection_ptr& conn : connections ) {
+				if ( conn->expired(now) ) {
+					conn->close(conn->outstanding() ? ETIMEDOUT : asio::err::SUCCESS);
+				}
+			}
+		}
+
+		if ( connections_ == 0 ) {
+			sweeping_ = false;
+			return;
+		}
+		sweep();
+	});
+}
+
+///////////////////////////////////////////////////////////////
+
+Client::Client(asio::IOContext& ioc) :
+	pImpl_(new Impl(ioc))
+{
+}
+
+Client::~Client()
+{
+}
+
+void Client::setConnectTimeout(time_t ms)
+{
+	pImpl_->config().connect_timeout = ms;
+}
+
+void Client::setRequestTimeout(time_t ms)
+{
+	pImpl_->config().request_timeout = ms;
+}
+
+void Client::setIdleTimeout(time_t ms)
+{
+	pImpl_->config().idle_timeout = ms;
+}
+
+void Client::setMaxConnectionsPerHost(size_t count)
+{
+	pImpl_->config().max_connections = std::max<size_t>(count, 1);
+}
+
+void Client::setMaxInFlightPerHost(size_t count)
+{
+	pImpl_->config().max_in_flight = count;
+}
+
+void Client::setMaxQueuedPerHost(size_t count)
+{
+	pImpl_->config().max_queued = count;
+}
+
+void Client::setPipelining(size_t depth)
+{
+	pImpl_->config().pipelining = std::max<size_t>(depth, 1);
+}
+
+void Client::setMaxBodyBytes(size_t bytes)
+{
+	pImpl_->config().max_body_bytes = bytes;
+}
+
+void Client::setDecompression(bool on)
+{
+	pImpl_->config().decompression = on;
+}
+
+void Client::request(const asio::ip::Endpoint& endpoint, Request request, response_handler_type handler)
+{
+	pImpl_->request(endpoint, request, data_handler_type(), std::move(handler));
+}
+
+void Client::request(const asio::ip::Endpoint& endpoint, Request request,
+					 data_handler_type on_data, response_handler_type handler)
+{
+	pImpl_->request(endpoint, request, std::move(on_data), std::move(handler));
+}
+
+void Client::close()
+{
+	pImpl_->close();
+}
+
+size_t Client::connections() const
+{
+	return pImpl_->connections();
+}
+
+size_t Client::idleConnections() const
+{
+	return pImpl_->idleConnections();
+}
+
+size_t Client::inFlight() const
+{
+	return pImpl_->inFlight();
+}
+
+size_t Client::queued() const
+{
+	return pImpl_->queued();
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
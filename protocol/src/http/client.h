@@ -0,0 +1,130 @@
+#ifndef __LCY_PROTOCOL_HTTP_CLIENT_H__
+#define __LCY_PROTOCOL_HTTP_CLIENT_H__
+
+#include <time.h>
+#include <stddef.h>
+#include <memory>
+#include <functional>
+
+#include "lcy/asio/src/errinfo.h"
+#include "lcy/asio/src/ip/endpoint.h"
+#include "lcy/protocol/src/string_view.h"
+
+namespace lcy {
+namespace asio {
+class IOContext;
+}	// namespace asio
+
+namespace protocol {
+namespace http {
+
+class Request;
+class Response;
+
+/*
+* HTTP/1.1 client : a keep-alive connection pool per host, optional pipelining,
+* connect and request timeouts and a bound on the requests in flight per host.
+*
+* A request goes to an idle connection of its host, or to a new one while the host
+* has less than setMaxConnectionsPerHost(), or behind the requests of a busy one
+* when pipelining allows it. Otherwise it waits in the queue of the host, as it does
+* once setMaxInFlightPerHost() requests are on the wire.
+*
+* example :
+*
+*	http::Client client(ioc);
+*	http::Request request;
+*	request.setMethod(http::method::GET);
+*	request.setUri("/status");
+*	client.request(asio::ip::Endpoint("127.0.0.1", 8080), std::move(request),
+*			[](asio::errcode_type ec, http::Response& response){
+*		if ( !ec ) {
+*			... response.state(), response.body() ...
+*		}
+*	});
+*	ioc.loop_wait();
+*
+* notify :
+*	The client lives on the IOContext passed to the constructor : every member is
+*	called, and every handler runs, on its loop thread. Never destroy the client
+*	from one of its handlers.
+*	Errors are errno values : ETIMEDOUT for a timeout, ECONNRESET for a connection
+*	closed before its response, EPROTO for a malformed response, EMSGSIZE for a body
+*	above setMaxBodyBytes(), EAGAIN when the queue of the host is full and ECANCELED
+*	for requests left by close().
+*	Host is set to the endpoint unless the request has one, a request without a
+*	version is sent as HTTP/1.1.
+*	A GET, HEAD, PUT, DELETE, OPTIONS or TRACE request that meets a keep-alive
+*	connection the server has just closed is sent again, once, on another one.
+*	Only those methods are pipelined, any other waits for a connection of its own.
+*	Timeouts are in milliseconds, 0 disables one. A request timeout runs from the
+*	moment the request is handed to a connection until the end of its response.
+*	Settings must be made before the first request.
+*/
+class Client {
+public:
+	// `response` is only valid during the call, its body may be moved out
+	typedef std::function<void (asio::errcode_type, Response&)> response_handler_type;
+	// a piece of a streamed body, only valid during the call
+	typedef std::function<void (StringView)> data_handler_type;
+
+	enum {
+		DEFAULT_CONNECT_TIMEOUT_MS = 5 * 1000,
+		DEFAULT_REQUEST_TIMEOUT_MS = 30 * 1000,
+		DEFAULT_IDLE_TIMEOUT_MS = 60 * 1000,			// an unused pooled connection is closed after it
+		DEFAULT_MAX_CONNECTIONS_PER_HOST = 8,
+		DEFAULT_MAX_IN_FLIGHT_PER_HOST = 64,
+		DEFAULT_MAX_BODY_BYTES = 64 * 1024 * 1024,		// collected bodies only
+		READ_BUFFER_BYTES = 16 * 1024,
+	};
+
+	explicit Client(asio::IOContext& ioc);
+	~Client();		// fails every request left with ECANCELED
+
+	void setConnectTimeout(time_t ms);
+	void setRequestTimeout(time_t ms);
+	void setIdleTimeout(time_t ms);
+	void setMaxConnectionsPerHost(size_t count);
+	void setMaxInFlightPerHost(size_t count);		// 0 : no limit
+	void setMaxQueuedPerHost(size_t count);		// 0 ( the default ) : no limit
+	// requests on the wire per connection, 1 ( the default ) : no pipelining
+	void setPipelining(size_t depth);
+	void setMaxBodyBytes(size_t bytes);			// 0 : no limit
+	/*
+	* Asks for gzip and deflate unless the request says otherwise, and decodes a
+	* collected body of such a Content-Encoding ( the field is then removed ).
+	* A streamed body is handed over as it comes.
+	*/
+	void setDecompression(bool on);
+
+	void request(const asio::ip::Endpoint& endpoint, Request request, response_handler_type handler);
+	/*
+	* Streams the response body : `on_data` gets every piece as it is read, the handler
+	* then gets the response without a body. setMaxBodyBytes() does not apply.
+	*/
+	void request(const asio::ip::Endpoint& endpoint, Request request,
+				 data_handler_type on_data, response_handler_type handler);
+
+	void close();		// every connection, the requests left fail with ECANCELED
+
+	size_t connections() const;		// open or being opened, of every host
+	size_t idleConnections() const;
+	size_t inFlight() const;		// handed to a connection, of every host
+	size_t queued() const;			// waiting for one
+
+private:
+	Client(const Client&);
+	Client& operator=(const Client&);
+
+private:
+	friend class ClientConnection;
+
+	class Impl;
+	std::unique_ptr<Impl> pImpl_;
+};
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_CLIENT_H__
@@ -0,0 +1,428 @@
+#include "lcy/protocol/src/http/compression.h"
+#include "lcy/protocol/src/http/response.h"
+
+#include <zlib.h>
+#include <limits.h>
+#include <string.h>
+#include <algorithm>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+enum {
+	WINDOW_BITS = 15,
+	GZIP_WRAPPER = 16,		// added to the window bits : gzip header and trailer
+	AUTO_WRAPPER = 32,		// inflate : gzip or zlib, from the header
+	MEM_LEVEL = 8,
+	STREAM_CHUNK = 16 * 1024,
+};
+
+static const StringView kAcceptEncoding("Accept-Encoding", 15);
+
+static StringView Trim(StringView s)
+{
+	size_t begin = 0, end = s.size();
+	while ( begin < end && (s[begin] == ' ' || s[begin] == '\t') ) ++begin;
+	while ( end > begin && (s[end - 1] == ' ' || s[end - 1] == '\t') ) --end;
+	return s.substr(begin, end - begin);
+}
+
+static bool EndsWith(StringView s, StringView suffix)
+{
+	return s.size() >= suffix.size() && s.substr(s.size() - suffix.size()).iequals(suffix);
+}
+
+static int WindowBits(coding_type c)
+{
+	return c == coding::GZIP ? WINDOW_BITS + GZIP_WRAPPER : WINDOW_BITS;
+}
+
+static int Level(int level)
+{
+	return std::min(std::max(level, 1), 9);
+}
+
+/*
+* "q=0.5" among the parameters of a list item, in thousandths : 1000 when absent,
+* 0 when malformed.
+*/
+static int QValue(StringView params)
+{
+	size_t pos = 0;
+	while ( pos < params.size() ) {
+		size_t semi = params.find(';', pos);
+		if ( semi == StringView::npos ) {
+			semi = params.size();
+		}
+
+		StringView param = Trim(params.substr(pos, semi - pos));
+		if ( param.size() >= 2 && (param[0] == 'q' || param[0] == 'Q') && param[1] == '=' ) {
+			StringView value = param.substr(2);
+			if ( value.empty() || (value[0] != '0' && value[0] != '1') ) {
+				return 0;
+			}
+			int q = (value[0] - '0') * 1000;
+			if ( value.size() > 1 ) {
+				if ( value[1] != '.' || value.size() > 5 ) {
+					return 0;
+				}
+				int scale = 100;
+				for ( size_t i = 2; i < value.size(); ++i, scale /= 10 ) {
+					if ( value[i] < '0' || value[i] > '9' ) {
+						return 0;
+					}
+					q += (value[i] - '0') * scale;
+				}
+			}
+			return std::min(q, 1000);
+		}
+		pos = semi + 1;
+	}
+	return 1000;
+}
+
+// q-value of `coding` in an Accept-Encoding, "*" standing for the codings it does not list
+static int Weight(StringView accept_encoding, StringView coding)
+{
+	int named = -1, any = -1;
+
+	size_t pos = 0;
+	while ( pos < accept_encoding.size() ) {
+		size_t comma = accept_encoding.find(',', pos);
+		if ( comma == StringView::npos ) {
+			comma = accept_encoding.size();
+		}
+
+		StringView item = accept_encoding.substr(pos, comma - pos);
+		size_t semi = item.find(';');
+		StringView name = Trim(item.substr(0, semi));
+		StringView params = semi == StringView::npos ? StringView() : item.substr(semi + 1);
+
+		if ( name.iequals(coding) || (coding == StringView("gzip", 4) && name.iequals("x-gzip")) ) {
+			named = std::max(named, QValue(params));
+		} else if ( name == StringView("*", 1) ) {
+			any = QValue(params);
+		}
+		pos = comma + 1;
+	}
+
+	if ( named >= 0 ) {
+		return named;
+	}
+	return any > 0 ? any : 0;
+}
+
+const char* CodingToString(coding_type c)
+{
+	switch ( c ) {
+	case coding::GZIP:		return "gzip";
+	case coding::DEFLATE:	return "deflate";
+	default:				return "identity";
+	}
+}
+
+coding_type NegotiateCoding(StringView accept_encoding)
+{
+	if ( Trim(accept_encoding).empty() ) {
+		return coding::IDENTITY;
+	}
+
+	int gzip = Weight(accept_encoding, StringView("gzip", 4));
+	int deflate = Weight(accept_encoding, StringView("deflate", 7));
+	if ( gzip > 0 && gzip >= deflate ) {
+		return coding::GZIP;
+	}
+	return deflate > 0 ? coding::DEFLATE : coding::IDENTITY;
+}
+
+bool AcceptsCoding(StringView accept_encoding, StringView coding)
+{
+	return Weight(accept_encoding, coding) > 0;
+}
+
+bool Compressible(StringView content_type)
+{
+	static const char* const kTypes[] = {
+		"application/json",
+		"application/javascript",
+		"application/x-javascript",
+		"application/xml",
+		"application/wasm",
+		"image/svg+xml",
+	};
+
+	StringView type = Trim(content_type.substr(0, content_type.find(';')));
+	if ( type.size() > 5 && type.substr(0, 5).iequals(StringView("text/", 5)) ) {
+		return true;
+	}
+	if ( EndsWith(type, StringView("+json", 5)) || EndsWith(type, StringView("+xml", 4)) ) {
+		return true;
+	}
+	for ( size_t i = 0; i < sizeof(kTypes) / sizeof(kTypes[0]); ++i ) {
+		if ( type.iequals(StringView(kTypes[i])) ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////
+
+/*
+* One deflate stream per coding and thread for the one shot Compress(), reset
+* between calls : setting one up allocates about 256 KiB.
+*/
+struct Deflater {
+	z_stream zs;
+	bool init;
+	int level;
+
+	Deflater() : init(false), level(0) {}
+	~Deflater()
+	{
+		if ( init ) {
+			::deflateEnd(&zs);
+		}
+	}
+};
+
+static z_stream* AcquireDeflater(coding_type c, int level)
+{
+	static thread_local Deflater deflaters[2];
+
+	Deflater& d = deflaters[c == coding::GZIP ? 0 : 1];
+	if ( !d.init ) {
+		::memset(&d.zs, 0, sizeof(d.zs));
+		if ( ::deflateInit2(&d.zs, level, Z_DEFLATED, WindowBits(c), MEM_LEVEL, Z_DEFAULT_STRATEGY) != Z_OK ) {
+			return nullptr;
+		}
+		d.init = true;
+		d.level = level;
+		return &d.zs;
+	}
+
+	::deflateReset(&d.zs);
+	if ( d.level != level ) {
+		if ( ::deflateParams(&d.zs, level, Z_DEFAULT_STRATEGY) != Z_OK ) {
+			return nullptr;
+		}
+		d.level = level;
+	}
+	return &d.zs;
+}
+
+bool Compress(coding_type c, StringView data, int level, std::string& out)
+{
+	if ( c == coding::IDENTITY || data.size() > UINT_MAX ) {
+		return false;
+	}
+
+	z_stream* zs = AcquireDeflater(c, Level(level));
+	if ( !zs ) {
+		return false;
+	}
+
+	size_t base = out.size();
+	size_t bound = ::deflateBound(zs, (uLong)data.size());
+	out.resize(base + bound);
+
+	zs->next_in = (Bytef*)data.data();
+	zs->avail_in = (uInt)data.size();
+	zs->next_out = (Bytef*)&out[base];
+	zs->avail_out = (uInt)bound;
+	if ( ::deflate(zs, Z_FINISH) != Z_STREAM_END ) {
+		out.resize(base);
+		return false;
+	}
+
+	out.resize(base + bound - zs->avail_out);
+	return true;
+}
+
+bool Decompress(coding_type c, StringView data, std::string& out, size_t max_bytes)
+{
+	if ( c == coding::IDENTITY || data.size() > UINT_MAX ) {
+		return false;
+	}
+
+	// "deflate" is meant as zlib, some peers send raw deflate : retried as such
+	int bits[2] = { WINDOW_BITS + AUTO_WRAPPER, -WINDOW_BITS };
+	size_t base = out.size();
+	for ( int attempt = 0; attempt < (c == coding::DEFLATE ? 2 : 1); ++attempt ) {
+		z_stream zs;
+		::memset(&zs, 0, sizeof(zs));
+		if ( ::inflateInit2(&zs, bits[attempt]) != Z_OK ) {
+			return false;
+		}
+
+		zs.next_in = (Bytef*)data.data();
+		zs.avail_in = (uInt)data.size();
+		int ret = Z_OK;
+		while ( ret == Z_OK ) {
+			size_t at = out.size();
+			out.resize(at + STREAM_CHUNK);
+			zs.next_out = (Bytef*)&out[at];
+			zs.avail_out = STREAM_CHUNK;
+			ret = ::inflate(&zs, Z_NO_FLUSH);
+			out.resize(at + STREAM_CHUNK - zs.avail_out);
+			if ( max_bytes && out.size() - base > max_bytes ) {
+				ret = Z_BUF_ERROR;
+			}
+		}
+		::inflateEnd(&zs);
+
+		if ( ret == Z_STREAM_END && zs.avail_in == 0 ) {
+			return true;
+		}
+		out.resize(base);
+		if ( ret != Z_DATA_ERROR ) {
+			break;
+		}
+	}
+	return false;
+}
+
+bool CompressResponse(Response& response, coding_type c, int level, size_t min_bytes)
+{
+	int code = (int)response.state();
+	if ( level <= 0 || response.file() || response.hasHeader(field::CONTENT_ENCODING) ||
+		 code < 200 || code == 204 || code == 206 || code == 304 ) {
+		return false;
+	}
+	if ( response.body().empty() || response.body().size() < min_bytes ||
+		 !Compressible(StringView(response.getHeader(field::CONTENT_TYPE))) ) {
+		return false;
+	}
+
+	// the representation depends on Accept-Encoding from now on, whatever this client gets
+	VaryOnAcceptEncoding(response);
+
+	if ( c == coding::IDENTITY ) {
+		return false;
+	}
+
+	std::string compressed;
+	if ( !Compress(c, StringView(response.body()), level, compressed) ||
+		 compressed.size() >= response.body().size() ) {
+		return false;
+	}
+
+	response.setBody(std::move(compressed));
+	response.setHeader(field::CONTENT_ENCODING, CodingToString(c));
+	response.removeHeader(field::CONTENT_LENGTH);
+
+	const std::string& etag = response.getHeader(field::ETAG);
+	if ( !etag.empty() && etag[0] == '"' ) {
+		response.setHeader(field::ETAG, "W/" + etag);
+	}
+	return true;
+}
+
+void VaryOnAcceptEncoding(Response& response)
+{
+	const std::string& vary = response.getHeader(field::VARY);
+	if ( vary.empty() ) {
+		response.setHeader(field::VARY, kAcceptEncoding.toString());
+		return;
+	}
+
+	StringView list(vary);
+	size_t pos = 0;
+	while ( pos < list.size() ) {
+		size_t comma = list.find(',', pos);
+		if ( comma == StringView::npos ) {
+			comma = list.size();
+		}
+		StringView name = Trim(list.substr(pos, comma - pos));
+		if ( name.iequals(kAcceptEncoding) || name == StringView("*", 1) ) {
+			return;
+		}
+		pos = comma + 1;
+	}
+	response.setHeader(field::VARY, vary + ", " + kAcceptEncoding.toString());
+}
+
+///////////////////////////////////////////////////////////////
+
+class Compressor::Impl {
+public:
+	z_stream zs;
+	bool init;
+	bool finished;
+
+	Impl() : init(false), finished(false)
+	{
+		::memset(&zs, 0, sizeof(zs));
+	}
+
+	~Impl()
+	{
+		if ( init ) {
+			::deflateEnd(&zs);
+		}
+	}
+
+	// runs deflate over `data` until zlib has nothing more to hand back for `flush`
+	bool run(StringView data, int flush, std::string& out)
+	{
+		if ( !init || finished || data.size() > UINT_MAX ) {
+			return false;
+		}
+
+		zs.next_in = (Bytef*)data.data();
+		zs.avail_in = (uInt)data.size();
+		int ret = Z_OK;
+		do {
+			size_t at = out.size();
+			out.resize(at + STREAM_CHUNK);
+			zs.next_out = (Bytef*)&out[at];
+			zs.avail_out = STREAM_CHUNK;
+			ret = ::deflate(&zs, flush);
+			out.resize(at + STREAM_CHUNK - zs.avail_out);
+			if ( ret == Z_STREAM_ERROR ) {
+				return false;
+			}
+		} while ( zs.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END) );
+
+		if ( flush == Z_FINISH ) {
+			finished = true;
+		}
+		return true;
+	}
+};
+
+Compressor::Compressor(coding_type c, int level) :
+	pImpl_(new Impl())
+{
+	if ( c != coding::IDENTITY ) {
+		pImpl_->init = ::deflateInit2(&pImpl_->zs, Level(level), Z_DEFLATED,
+									  WindowBits(c), MEM_LEVEL, Z_DEFAULT_STRATEGY) == Z_OK;
+	}
+}
+
+Compressor::~Compressor()
+{
+}
+
+bool Compressor::ok() const
+{
+	return pImpl_->init;
+}
+
+bool Compressor::write(StringView data, std::string& out, bool flush)
+{
+	if ( data.empty() && !flush ) {
+		return pImpl_->init && !pImpl_->finished;
+	}
+	return pImpl_->run(data, flush ? Z_SYNC_FLUSH : Z_NO_FLUSH, out);
+}
+
+bool Compressor::finish(std::string& out)
+{
+	return pImpl_->run(StringView(), Z_FINISH, out);
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
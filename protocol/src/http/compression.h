@@ -0,0 +1,102 @@
+#ifndef __LCY_PROTOCOL_HTTP_COMPRESSION_H__
+#define __LCY_PROTOCOL_HTTP_COMPRESSION_H__
+
+#include <string>
+#include <memory>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "lcy/protocol/src/string_view.h"
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+class Response;
+
+/*
+* Content codings of zlib : "gzip" ( RFC 1952 ) and "deflate", which HTTP means as
+* the zlib format ( RFC 1950 ).
+*/
+typedef
+enum class coding :
+	uint8_t
+{
+	IDENTITY,
+	GZIP,
+	DEFLATE,
+}
+coding_type;
+
+// "gzip", "deflate", "identity"
+const char* CodingToString(coding_type c);
+
+/*
+* The coding to answer an Accept-Encoding with : the acceptable one of highest
+* q-value, gzip on a tie, IDENTITY when the field is empty or accepts neither.
+*/
+coding_type NegotiateCoding(StringView accept_encoding);
+// true when `coding` is acceptable ( q > 0, directly or through "*" )
+bool AcceptsCoding(StringView accept_encoding, StringView coding);
+
+// text, JSON, JavaScript, XML, SVG and WebAssembly : what compresses well
+bool Compressible(StringView content_type);
+
+// one shot, appends to `out`. `level` 1 ( fast ) to 9 ( small ), as zlib
+bool Compress(coding_type c, StringView data, int level, std::string& out);
+// appends at most `max_bytes` ( 0 : no limit ), false on corrupt or larger data
+bool Decompress(coding_type c, StringView data, std::string& out, size_t max_bytes = 0);
+
+/*
+* The body of `response` compressed in place when it is worth it : not empty of
+* `min_bytes`, a Compressible() type, no Content-Encoding or file body yet, a status
+* with a body ( not 204, 206, 304 ). Content-Encoding is set, Content-Length dropped,
+* a strong ETag made weak. Vary gets Accept-Encoding whenever the response could be
+* compressed, even for a client that gets it as it is.
+* Returns whether the body was replaced.
+*/
+bool CompressResponse(Response& response, coding_type c, int level, size_t min_bytes);
+// adds Accept-Encoding to the Vary of `response` unless it is there ( or "*" )
+void VaryOnAcceptEncoding(Response& response);
+
+/*
+* Streaming deflate for a body of unknown length, as it is produced.
+*
+* example :
+*
+*	http::Compressor compressor(http::coding::GZIP, 6);
+*	compressor.write(piece, out, true);		// out can be sent as a chunk now
+*	...
+*	compressor.finish(out);
+*
+* notify :
+*	Each instance holds a zlib stream ( about 256 KiB at level 6 ).
+*	A flushed write() ends on a byte boundary the peer can decode up to, at some
+*	cost in ratio : flush once per piece worth sending, not per small append.
+*/
+class Compressor {
+public:
+	Compressor(coding_type c, int level);
+	~Compressor();
+
+	bool ok() const;		// false when zlib could not be set up
+
+	// compresses `data` and appends what zlib hands back
+	bool write(StringView data, std::string& out, bool flush = false);
+	// the rest and the trailer, the stream can not be written after it
+	bool finish(std::string& out);
+
+private:
+	Compressor(const Compressor&);
+	Compressor& operator=(const Compressor&);
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> pImpl_;
+};
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_COMPRESSION_H__
@@ -0,0 +1,133 @@
+#include "lcy/protocol/src/http/date_clock.h"
+
+#include "lcy/asio/src/io_context.hpp"
+
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+static void put2(char* out, int v)
+{
+	out[0] = (char)('0' + v / 10);
+	out[1] = (char)('0' + v % 10);
+}
+
+void DateClock::format(time_t t, char* out)
+{
+	static const char days[] = "SunMonTueWedThuFriSat";
+	static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+	struct tm tm;
+	::gmtime_r(&t, &tm);
+
+	// "Sun, 06 Nov 1994 08:49:37 GMT"
+	::memcpy(out, days + tm.tm_wday * 3, 3);
+	out[3] = ',';
+	out[4] = ' ';
+	put2(out + 5, tm.tm_mday);
+	out[7] = ' ';
+	::memcpy(out + 8, months + tm.tm_mon * 3, 3);
+	out[11] = ' ';
+	int year = tm.tm_year + 1900;
+	put2(out + 12, year / 100 % 100);
+	put2(out + 14, year % 100);
+	out[16] = ' ';
+	put2(out + 17, tm.tm_hour);
+	out[19] = ':';
+	put2(out + 20, tm.tm_min);
+	out[22] = ':';
+	put2(out + 23, tm.tm_sec);
+	::memcpy(out + 25, " GMT", 4);
+}
+
+static bool get2(const char* in, int& v)
+{
+	if ( in[0] < '0' || in[0] > '9' || in[1] < '0' || in[1] > '9' ) {
+		return false;
+	}
+	v = (in[0] - '0') * 10 + (in[1] - '0');
+	return true;
+}
+
+bool DateClock::parse(StringView date, time_t& t)
+{
+	static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+	if ( date.size() != DATE_LENGTH || date[3] != ',' || date[4] != ' ' || date[7] != ' ' ||
+		 date[11] != ' ' || date[16] != ' ' || date[19] != ':' || date[22] != ':' ||
+		 date.substr(25) != StringView(" GMT", 4) ) {
+		return false;
+	}
+
+	const char* in = date.data();
+	int century = 0, year = 0;
+	struct tm tm;
+	::memset(&tm, 0, sizeof(tm));
+	if ( !get2(in + 5, tm.tm_mday) || !get2(in + 12, century) || !get2(in + 14, year) ||
+		 !get2(in + 17, tm.tm_hour) || !get2(in + 20, tm.tm_min) || !get2(in + 23, tm.tm_sec) ) {
+		return false;
+	}
+
+	tm.tm_mon = -1;
+	for ( int m = 0; m < 12; ++m ) {
+		if ( ::memcmp(in + 8, months + m * 3, 3) == 0 ) {
+			tm.tm_mon = m;
+			break;
+		}
+	}
+	if ( tm.tm_mon < 0 || tm.tm_mday < 1 || tm.tm_mday > 31 ||
+		 tm.tm_hour > 23 || tm.tm_min > 59 || tm.tm_sec > 60 ) {
+		return false;
+	}
+
+	tm.tm_year = century * 100 + year - 1900;
+	t = ::timegm(&tm);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////
+
+DateClock::DateClock(asio::IOContext& ioc) :
+	timer_(ioc, REFRESH_MS),
+	now_(0)
+{
+	refresh();
+	schedule();
+}
+
+DateClock::~DateClock()
+{
+	timer_.cancel();
+}
+
+StringView DateClock::date() const
+{
+	return StringView(date_, DATE_LENGTH);
+}
+
+void DateClock::refresh()
+{
+	time_t now = ::time(nullptr);
+	if ( now != now_ ) {
+		now_ = now;
+		format(now, date_);
+	}
+}
+
+void DateClock::schedule()
+{
+	timer_.async_wait([this](asio::errcode_type ec, asio::SteadyTimer::timeout_type){
+		if ( ec ) {
+			return;		// canceled by the destructor
+		}
+
+		refresh();
+		schedule();
+	});
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
@@ -0,0 +1,60 @@
+#ifndef __LCY_PROTOCOL_HTTP_DATE_CLOCK_H__
+#define __LCY_PROTOCOL_HTTP_DATE_CLOCK_H__
+
+#include <time.h>
+
+#include "lcy/asio/src/steady_timer.h"
+#include "lcy/protocol/src/string_view.h"
+
+namespace lcy {
+namespace asio {
+class IOContext;
+}	// namespace asio
+
+namespace protocol {
+namespace http {
+
+/*
+* IMF-fixdate ( "Sun, 06 Nov 1994 08:49:37 GMT" ) of the current second, for the
+* Date header. Formatting happens once per second on the loop thread of the
+* IOContext instead of once per response.
+*
+* notify :
+*	One clock per IOContext, only its loop thread may read date().
+*	The clock must be destroyed on that thread, before the IOContext.
+*/
+class DateClock {
+public:
+	enum {
+		DATE_LENGTH = 29,
+		REFRESH_MS = 1000,
+	};
+
+	DateClock(asio::IOContext& ioc);
+	~DateClock();
+
+	StringView date() const;
+	void refresh();
+
+	// writes DATE_LENGTH bytes, no terminator
+	static void format(time_t t, char* out);
+	// IMF-fixdate only, the obsolete RFC 850 and asctime forms are refused
+	static bool parse(StringView date, time_t& t);
+
+private:
+	DateClock(const DateClock&);
+	DateClock& operator=(const DateClock&);
+
+	void schedule();
+
+private:
+	asio::SteadyTimer timer_;
+	time_t now_;
+	char date_[DATE_LENGTH];
+};
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_DATE_CLOCK_H__
@@ -0,0 +1,80 @@
+#ifndef __LCY_PROTOCOL_HTTP_DETAILS_UTIL_H__
+#define __LCY_PROTOCOL_HTTP_DETAILS_UTIL_H__
+
+#include <time.h>
+#include <string.h>
+#include <algorithm>
+#include <initializer_list>
+
+#include "lcy/asio/src/dynamic_buffer.h"
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/http/message.h"
+
+namespace lcy {
+namespace protocol {
+namespace http {
+namespace details {
+
+/*
+* Helpers shared by the server, the client and the websocket handshake, not part
+* of the interface.
+*/
+
+// true when the comma separated list `value` holds `token`, case insensitive
+inline bool HasToken(StringView value, StringView token)
+{
+	size_t pos = 0;
+	while ( pos < value.size() ) {
+		size_t comma = value.find(',', pos);
+		if ( comma == StringView::npos ) {
+			comma = value.size();
+		}
+
+		size_t begin = pos, end = comma;
+		while ( begin < end && (value[begin] == ' ' || value[begin] == '\t') ) ++begin;
+		while ( end > begin && (value[end - 1] == ' ' || value[end - 1] == '\t') ) --end;
+
+		if ( value.substr(begin, end - begin).iequals(token) ) {
+			return true;
+		}
+		pos = comma + 1;
+	}
+	return false;
+}
+
+// HTTP/1.1 is persistent unless closed, HTTP/1.0 only when asked for : a Message or a RequestView
+template <typename Head>
+inline bool KeepAlive(const Head& head)
+{
+	StringView connection(head.getHeader(field::CONNECTION));
+	if ( head.version() == version::HTTP_1_0 ) {
+		return HasToken(connection, StringView("keep-alive", 10));
+	}
+	return !HasToken(connection, StringView("close", 5));
+}
+
+inline void Append(asio::DynamicBuffer& buffer, StringView data)
+{
+	buffer.reserve(data.size());
+	::memcpy(buffer.writeBegin(), data.data(), data.size());
+	buffer.write(data.size());
+}
+
+// Sweep often enough for the shortest timeout to be honoured within a quarter of it, 0 : none
+inline time_t SweepInterval(std::initializer_list<time_t> timeouts)
+{
+	time_t shortest = 1000 * 4;
+	for ( time_t timeout : timeouts ) {
+		if ( timeout > 0 ) {
+			shortest = std::min(shortest, timeout);
+		}
+	}
+	return std::max<time_t>(10, shortest / 4);
+}
+
+}	// namespace details
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
+
+#endif	// __LCY_PROTOCOL_HTTP_DETAILS_UTIL_H__
@@ -0,0 +1,149 @@
+#include "lcy/protocol/src/http/file_cache.h"
+
+#include "lcy/asio/src/details/timer_service.h"
+
+#include <errno.h>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+FileCache::FileCache(size_t capacity, time_t revalidate_ms) :
+	capacity_(capacity),
+	revalidate_ms_(revalidate_ms),
+	hits_(0),
+	misses_(0)
+{
+}
+
+FileCache::~FileCache()
+{
+}
+
+/*
+* notify :
+*	The system calls run outside the lock, two threads missing the same path both
+*	open it and the last one stays.
+*/
+open_file_ptr FileCache::open(const std::string& path, asio::errcode_type& ec)
+{
+	ec = asio::err::SUCCESS;
+	time_t now = asio::details::now_ms();
+
+	open_file_ptr cached;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto iter = index_.find(path);
+		if ( iter != index_.end() ) {
+			entry_list_type::iterator entry = iter->second;
+			entries_.splice(entries_.begin(), entries_, entry);
+			if ( now - entry->checked < revalidate_ms_ ) {
+				++hits_;
+				return entry->file;
+			}
+			cached = entry->file;
+		}
+	}
+
+	if ( cached ) {
+		struct stat st;
+		if ( ::stat(path.c_str(), &st) == 0 && cached->same(st) ) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto iter = index_.find(path);
+			if ( iter != index_.end() && iter->second->file == cached ) {
+				iter->second->checked = now;
+			}
+			++hits_;
+			return cached;
+		}
+	}
+
+	open_file_ptr file = OpenFile::Open(path, ec);
+
+	std::lock_guard<std::mutex> lock(mutex_);
+	++misses_;
+	if ( !file ) {
+		auto iter = index_.find(path);
+		if ( iter != index_.end() ) {
+			entries_.erase(iter->second);
+			index_.erase(iter);
+		}
+		return nullptr;
+	}
+
+	insert(path, file, now);
+	return file;
+}
+
+void FileCache::erase(const std::string& path)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto iter = index_.find(path);
+	if ( iter != index_.end() ) {
+		entries_.erase(iter->second);
+		index_.erase(iter);
+	}
+}
+
+void FileCache::clear()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	index_.clear();
+	entries_.clear();
+}
+
+size_t FileCache::size() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return entries_.size();
+}
+
+size_t FileCache::capacity() const
+{
+	return capacity_;
+}
+
+size_t FileCache::hits() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return hits_;
+}
+
+size_t FileCache::misses() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return misses_;
+}
+
+// called with the lock held
+void FileCache::insert(const std::string& path, const open_file_ptr& file, time_t now)
+{
+	if ( capacity_ == 0 ) {
+		return;
+	}
+
+	auto iter = index_.find(path);
+	if ( iter != index_.end() ) {
+		entry_list_type::iterator entry = iter->second;
+		entry->file = file;
+		entry->checked = now;
+		entries_.splice(entries_.begin(), entries_, entry);
+		return;
+	}
+
+	entries_.push_front(Entry());
+	Entry& entry = entries_.front();
+	entry.path = path;
+	entry.file = file;
+	entry.checked = now;
+	index_.emplace(path, entries_.begin());
+
+	while ( entries_.size() > capacity_ ) {
+		index_.erase(entries_.back().path);
+		entries_.pop_back();
+	}
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
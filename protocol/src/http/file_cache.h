@@ -0,0 +1,80 @@
+#ifndef __LCY_PROTOCOL_HTTP_FILE_CACHE_H__
+#define __LCY_PROTOCOL_HTTP_FILE_CACHE_H__
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <time.h>
+
+#include "lcy/asio/src/errinfo.h"
+#include "lcy/protocol/src/http/open_file.h"
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+/*
+* LRU cache of open files by path : a hot file costs neither an open(2) nor an
+* fstat(2) per request.
+*
+* An entry is trusted for `revalidate_ms` after it was opened or last checked,
+* then the next lookup stat(2)s the path and reopens the file when it was replaced
+* or modified. Failures ( missing file, directory ) are not cached.
+*
+* notify :
+*	Thread safe, the workers of a server share one cache. Evicted files stay open
+*	until the responses sending them are done.
+*/
+class FileCache {
+public:
+	enum {
+		DEFAULT_CAPACITY = 1024,
+		DEFAULT_REVALIDATE_MS = 1000,
+	};
+
+	FileCache(size_t capacity = DEFAULT_CAPACITY,
+			  time_t revalidate_ms = DEFAULT_REVALIDATE_MS);
+	~FileCache();
+
+	open_file_ptr open(const std::string& path, asio::errcode_type& ec);
+	void erase(const std::string& path);
+	void clear();
+
+	size_t size() const;
+	size_t capacity() const;
+	// lookups answered without opening the file
+	size_t hits() const;
+	size_t misses() const;
+
+private:
+	FileCache(const FileCache&);
+	FileCache& operator=(const FileCache&);
+
+	struct Entry {
+		std::string path;
+		open_file_ptr file;
+		time_t checked;		// ms, steady clock
+	};
+
+	typedef std::list<Entry> entry_list_type;
+	typedef std::unordered_map<std::string, entry_list_type::iterator> entry_map_type;
+
+	void insert(const std::string& path, const open_file_ptr& file, time_t now);
+
+private:
+	size_t capacity_;
+	time_t revalidate_ms_;
+
+	mutable std::mutex mutex_;
+	entry_list_type entries_;	// most recently used first
+	entry_map_type index_;
+	size_t hits_;
+	size_t misses_;
+};
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_FILE_CACHE_H__
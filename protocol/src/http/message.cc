@@ -1,4 +1,5 @@
 #include "lcy/protocol/src/http/message.h"
+#include <string.h>
 
 namespace lcy {
 namespace protocol {
@@ -10,6 +11,8 @@ std::string VersionToString(version_type v)
 		return "HTTP/1.0";
 	} else if ( v == version::HTTP_1_1 ) {
 		return "HTTP/1.1";
+	} else if ( v == version::HTTP_2 ) {
+		return "HTTP/2";
 	}
 //	return "";
 	return "HTTP/1.1";				// Default version 1.1
@@ -21,16 +24,86 @@ version_type StringToVersion(const std::string& v_str)
 		return version::HTTP_1_0;
 	} else if ( v_str == "HTTP/1.1" ) {
 		return version::HTTP_1_1;
+	} else if ( v_str == "HTTP/2" ) {
+		return version::HTTP_2;
 	}
 //	return version::HTTP_ERR;
 	return version::HTTP_1_1;		// Default version 1.1
 }
 
+const char* FieldToString(field_type f)
+{
+	switch ( f ) {
+#define XX(_code, _field, _name)	\
+		case field::_field : return #_name;
+		HTTP_FIELD_MAP(XX)
+#undef XX
+		default : return "";
+	}
+}
+
+/*
+* Fields bucketed by ( length, lower cased first letter ). A bucket holds the few
+* names sharing both and is resolved with a case insensitive compare, so a lookup
+* is two array indexes and at most a couple of short compares.
+*/
+struct FieldTable {
+	enum {
+		MAX_LEN = 24,
+		BUCKET = 4,
+	};
+
+	int8_t buckets[MAX_LEN][26][BUCKET];
+
+	FieldTable()
+	{
+		::memset(buckets, -1, sizeof(buckets));
+		for ( size_t i = 0; i < FIELD_COUNT; ++i ) {
+			const char* name = FieldToString((field_type)i);
+			int8_t* bucket = buckets[::strlen(name)][(name[0] | 0x20) - 'a'];
+
+			size_t n = 0;
+			while ( bucket[n] >= 0 ) {
+				++n;	// BUCKET is above the largest collision count of HTTP_FIELD_MAP
+			}
+			bucket[n] = (int8_t)i;
+		}
+	}
+};
+
+field_type StringToField(const char* data, size_t len)
+{
+	static const FieldTable table;
+
+	if ( len == 0 || len >= FieldTable::MAX_LEN ) {
+		return field::UNKNOWN;
+	}
+
+	unsigned letter = (unsigned)((data[0] | 0x20) - 'a');
+	if ( letter >= 26 ) {
+		return field::UNKNOWN;
+	}
+
+	const int8_t* bucket = table.buckets[len][letter];
+	for ( size_t n = 0; n < FieldTable::BUCKET && bucket[n] >= 0; ++n ) {
+		if ( StringView(data, len).iequals(FieldToString((field_type)bucket[n])) ) {
+			return (field_type)bucket[n];
+		}
+	}
+	return field::UNKNOWN;
+}
+
+field_type StringToField(const std::string& name)
+{
+	return StringToField(name.data(), name.size());
+}
+
 //////////////////////////////////////////////////
 
 Message::Message(proto_type type) :
     type_(type),
-	version_(version::HTTP_ERR)
+	version_(version::HTTP_ERR),
+	field_mask_(0)
 {
 }
 
@@ -86,6 +159,11 @@ const Message::header_map_type& Message::getHeadersRef() const
 const std::string& Message::getHeader(const std::string& key,
 							   		  const std::string& def) const
 {
+	field_type f = StringToField(key);
+	if ( f != field::UNKNOWN ) {
+		return getHeader(f, def);
+	}
+
 	auto kv_iter = headers_.find(key);
 	if ( kv_iter != headers_.end() ) {
 		return kv_iter->second;
@@ -95,19 +173,63 @@ const std::string& Message::getHeader(const std::string& key,
 
 void Message::removeHeader(const std::string& key)
 {
+	field_type f = StringToField(key);
+	if ( f != field::UNKNOWN ) {
+		removeHeader(f);
+		return;
+	}
+
 	headers_.erase(key);
 }
 
 void Message::setHeader(std::string key, std::string value)
 {
+	field_type f = StringToField(key);
+	if ( f != field::UNKNOWN ) {
+		setHeader(f, std::move(value));
+		return;
+	}
+
 	headers_[std::move(key)] = std::move(value);
 }
 
+bool Message::hasHeader(field_type f) const
+{
+	return f < field::UNKNOWN && (field_mask_ & ((uint64_t)1 << (size_t)f));
+}
+
+const std::string& Message::getHeader(field_type f, const std::string& def) const
+{
+	return hasHeader(f) ? fields_[(size_t)f] : def;
+}
+
+void Message::removeHeader(field_type f)
+{
+	if ( hasHeader(f) ) {
+		field_mask_ &= ~((uint64_t)1 << (size_t)f);
+		fields_[(size_t)f].clear();
+	}
+}
+
+void Message::setHeader(field_type f, std::string value)
+{
+	if ( f < field::UNKNOWN ) {
+		field_mask_ |= (uint64_t)1 << (size_t)f;
+		fields_[(size_t)f] = std::move(value);
+	}
+}
+
 void Message::clear()
 {
 	body_ = {};
 	version_ = version::HTTP_ERR;
 	headers_.clear();
+
+	// keep the slot capacity, messages are usually reused per connection
+	for ( size_t i = 0; i < FIELD_COUNT; ++i ) {
+		fields_[i].clear();
+	}
+	field_mask_ = 0;
 }
 
 }   // namespace http
@@ -3,6 +3,10 @@
 
 #include <string>
 #include <unordered_map>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "lcy/protocol/src/string_view.h"
 
 namespace lcy {
 namespace protocol {
@@ -15,12 +19,72 @@ enum class version :
 	HTTP_ERR = 0x00,
 	HTTP_1_0 = 0x10,
 	HTTP_1_1 = 0x11,
+	HTTP_2 = 0x20,
 } 
 version_type;
 
 std::string VersionToString(version_type v);
 version_type StringToVersion(const std::string& v_str);
 
+/* Well known header fields, kept in fixed slots of every Message */
+#define HTTP_FIELD_MAP(XX)                          \
+  XX(0,  HOST,              Host)                   \
+  XX(1,  CONNECTION,        Connection)             \
+  XX(2,  CONTENT_LENGTH,    Content-Length)         \
+  XX(3,  CONTENT_TYPE,      Content-Type)           \
+  XX(4,  TRANSFER_ENCODING, Transfer-Encoding)      \
+  XX(5,  CONTENT_ENCODING,  Content-Encoding)       \
+  XX(6,  ACCEPT,            Accept)                 \
+  XX(7,  ACCEPT_ENCODING,   Accept-Encoding)        \
+  XX(8,  ACCEPT_LANGUAGE,   Accept-Language)        \
+  XX(9,  USER_AGENT,        User-Agent)             \
+  XX(10, COOKIE,            Cookie)                 \
+  XX(11, SET_COOKIE,        Set-Cookie)             \
+  XX(12, AUTHORIZATION,     Authorization)          \
+  XX(13, CACHE_CONTROL,     Cache-Control)          \
+  XX(14, DATE,              Date)                   \
+  XX(15, SERVER,            Server)                 \
+  XX(16, LOCATION,          Location)               \
+  XX(17, UPGRADE,           Upgrade)                \
+  XX(18, EXPECT,            Expect)                 \
+  XX(19, KEEP_ALIVE,        Keep-Alive)             \
+  XX(20, ETAG,              ETag)                   \
+  XX(21, LAST_MODIFIED,     Last-Modified)          \
+  XX(22, IF_NONE_MATCH,     If-None-Match)          \
+  XX(23, IF_MODIFIED_SINCE, If-Modified-Since)      \
+  XX(24, RANGE,             Range)                  \
+  XX(25, VARY,              Vary)                   \
+  XX(26, ACCEPT_RANGES,     Accept-Ranges)          \
+  XX(27, CONTENT_RANGE,     Content-Range)          \
+  XX(28, IF_RANGE,          If-Range)               \
+
+typedef
+enum class field :
+	uint8_t
+{
+#define XX(_code, _field, _name) \
+	_field = _code,
+	HTTP_FIELD_MAP(XX)
+#undef XX
+	UNKNOWN,
+}
+field_type;
+
+enum {
+	FIELD_COUNT = (size_t)field::UNKNOWN,
+};
+
+const char* FieldToString(field_type f);
+// ASCII case insensitive, no hashing : see message.cc
+field_type StringToField(const char* data, size_t len);
+field_type StringToField(const std::string& name);
+
+/*
+* notify :
+*	Fields of HTTP_FIELD_MAP are matched case insensitively and live in fixed
+*	slots under their canonical name, getHeadersRef() only holds the others.
+*	visitHeaders() walks both.
+*/
 class Message {
 public:
     typedef std::unordered_map<
@@ -54,6 +118,26 @@ public:
 	void removeHeader(const std::string& key);
 	void setHeader(std::string key, std::string value);
 
+	bool hasHeader(field_type f) const;
+	const std::string& getHeader(field_type f,
+								 const std::string& def = "") const;
+	void removeHeader(field_type f);
+	void setHeader(field_type f, std::string value);
+
+	// func(StringView name, const std::string& value), well known fields first
+	template <typename Func>
+	void visitHeaders(Func func) const
+	{
+		for ( size_t i = 0; i < FIELD_COUNT; ++i ) {
+			if ( field_mask_ & ((uint64_t)1 << i) ) {
+				func(StringView(FieldToString((field_type)i)), fields_[i]);
+			}
+		}
+		for ( auto& kv : headers_ ) {
+			func(StringView(kv.first), kv.second);
+		}
+	}
+
 	virtual void clear();
     virtual std::string dump() const = 0;
 
@@ -62,6 +146,8 @@ private:
     std::string body_;
 	version_type version_;
     header_map_type headers_;
+	std::string fields_[FIELD_COUNT];
+	uint64_t field_mask_;
 };
 
 }   // namespace http
@@ -0,0 +1,120 @@
+#include "lcy/protocol/src/http/open_file.h"
+#include "lcy/protocol/src/http/date_clock.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+static_assert((int)OpenFile::DATE_LENGTH == (int)DateClock::DATE_LENGTH, "Last-Modified is a Date");
+
+open_file_ptr OpenFile::Open(const std::string& path, asio::errcode_type& ec)
+{
+	ec = asio::err::SUCCESS;
+
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if ( fd == -1 ) {
+		ec = errno;
+		return nullptr;
+	}
+
+	struct stat st;
+	if ( ::fstat(fd, &st) ) {
+		ec = errno;
+		::close(fd);
+		return nullptr;
+	}
+	if ( !S_ISREG(st.st_mode) ) {
+		ec = S_ISDIR(st.st_mode) ? EISDIR : EACCES;
+		::close(fd);
+		return nullptr;
+	}
+
+	return std::make_shared<OpenFile>(fd, st);
+}
+
+OpenFile::OpenFile(int fd, const struct stat& st) :
+	fd_(fd),
+	dev_(st.st_dev),
+	ino_(st.st_ino),
+	size_((size_t)st.st_size),
+	mtim_(st.st_mtim)
+{
+	char etag[64];
+	int n = ::snprintf(etag, sizeof(etag), "\"%lx-%lx\"",
+					   (unsigned long)mtim_.tv_sec, (unsigned long)size_);
+	etag_.assign(etag, n);
+
+	DateClock::format(mtim_.tv_sec, last_modified_);
+}
+
+OpenFile::~OpenFile()
+{
+	::close(fd_);
+}
+
+int OpenFile::fd() const
+{
+	return fd_;
+}
+
+size_t OpenFile::size() const
+{
+	return size_;
+}
+
+time_t OpenFile::mtime() const
+{
+	return mtim_.tv_sec;
+}
+
+StringView OpenFile::etag() const
+{
+	return StringView(etag_);
+}
+
+StringView OpenFile::lastModified() const
+{
+	return StringView(last_modified_, DATE_LENGTH);
+}
+
+bool OpenFile::same(const struct stat& st) const
+{
+	return st.st_dev == dev_ && st.st_ino == ino_ && (size_t)st.st_size == size_ &&
+		   st.st_mtim.tv_sec == mtim_.tv_sec && st.st_mtim.tv_nsec == mtim_.tv_nsec;
+}
+
+bool OpenFile::read(size_t offset, size_t length, char* out) const
+{
+	size_t done = 0;
+	while ( done < length ) {
+		ssize_t n = ::pread(fd_, out + done, length - done, (off_t)(offset + done));
+		if ( n < 0 && errno == EINTR ) {
+			continue;
+		}
+		if ( n <= 0 ) {
+			return false;
+		}
+		done += n;
+	}
+	return true;
+}
+
+bool OpenFile::read(size_t offset, size_t length, std::string& out) const
+{
+	size_t base = out.size();
+	out.resize(base + length);
+	if ( length > 0 && !read(offset, length, &out[base]) ) {
+		out.resize(base);
+		return false;
+	}
+	return true;
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
@@ -0,0 +1,76 @@
+#ifndef __LCY_PROTOCOL_HTTP_OPEN_FILE_H__
+#define __LCY_PROTOCOL_HTTP_OPEN_FILE_H__
+
+#include <string>
+#include <memory>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "lcy/asio/src/errinfo.h"
+#include "lcy/protocol/src/string_view.h"
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+class OpenFile;
+typedef std::shared_ptr<const OpenFile> open_file_ptr;
+
+/*
+* A regular file opened read only, with what its stat said when it was opened.
+* The validators ( ETag, Last-Modified ) are formatted once, here.
+*
+* notify :
+*	The descriptor is closed with the last reference : a response being sent
+*	keeps its file open even when the cache has let it go.
+*/
+class OpenFile {
+public:
+	enum {
+		DATE_LENGTH = 29,
+	};
+
+	// nullptr and ec set when `path` can not be opened or is not a regular file
+	static open_file_ptr Open(const std::string& path, asio::errcode_type& ec);
+
+	// takes `fd` over
+	OpenFile(int fd, const struct stat& st);
+	~OpenFile();
+
+	int fd() const;
+	size_t size() const;
+	time_t mtime() const;
+
+	// "\"<mtime hex>-<size hex>\"", strong
+	StringView etag() const;
+	// IMF-fixdate of mtime
+	StringView lastModified() const;
+
+	// true while `st` still describes the opened file
+	bool same(const struct stat& st) const;
+
+	// [offset, offset + length) with pread(2), false on an error or a short file
+	bool read(size_t offset, size_t length, char* out) const;
+	// appends, `out` is left as it was on failure
+	bool read(size_t offset, size_t length, std::string& out) const;
+
+private:
+	OpenFile(const OpenFile&);
+	OpenFile& operator=(const OpenFile&);
+
+private:
+	int fd_;
+	dev_t dev_;
+	ino_t ino_;
+	size_t size_;
+	struct timespec mtim_;
+	std::string etag_;
+	char last_modified_[DATE_LENGTH];
+};
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_OPEN_FILE_H__
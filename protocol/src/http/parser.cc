@@ -1,90 +1,178 @@
 #include "lcy/protocol/src/http/parser.h"
 #include "lcy/protocol/src/http/request.h"
 #include "lcy/protocol/src/http/response.h"
+#include "lcy/protocol/src/http/request_view.h"
+#include "lcy/protocol/src/http/scan.h"
 
 #include <sstream>
 #include <algorithm>
 #include <iostream>
 #include <cctype>
-#include <regex>
+#include <string.h>
+#include <stdint.h>
 
 namespace lcy {
 namespace protocol {
 namespace http {
 
-static bool isValidURI(const std::string& uri) {
-	static std::regex uri_regex(R"(^/\S*$)");
-    return std::regex_match(uri, uri_regex);
+/*
+* Characters allowed in a request target : visible ASCII and, leniently, bytes
+* of raw UTF-8 paths. Controls, space and DEL are rejected.
+*/
+static const uint8_t kTargetChar[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// 0x00
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,	// 0x10
+	0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0x20
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0x30
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0x40
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0x50
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0x60
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0,	// 0x70
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0x80
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0x90
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0xA0
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0xB0
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0xC0
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0xD0
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0xE0
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,	// 0xF0
+};
+
+static bool isValidURI(const char* begin, const char* end)
+{
+	if ( begin >= end || *begin != '/' ) {
+		return false;
+	}
+
+	for ( const char* ptr = begin + 1; ptr < end; ++ptr ) {
+		if ( !kTargetChar[(uint8_t)*ptr] ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool isValidURI(const std::string& uri)
+{
+	return isValidURI(uri.data(), uri.data() + uri.size());
 }
 
-static bool isValidHTTPVersion(const std::string& version) {
-    static std::regex version_regex(R"(^HTTP/\d+\.\d+$)");
-    return std::regex_match(version, version_regex);
+static const char* parseDigits(const char* ptr, const char* end, unsigned& value)
+{
+	const char* start = ptr;
+	value = 0;
+	for ( ; ptr < end && *ptr >= '0' && *ptr <= '9'; ++ptr ) {
+		if ( value < 1000 ) {
+			value = value * 10 + (*ptr - '0');
+		}
+	}
+	return ptr == start ? nullptr : ptr;
 }
 
+/*
+* "HTTP/" DIGIT+ "." DIGIT+
+* notify :
+*	Well formed versions other than 1.0 are treated as 1.1, as StringToVersion does.
+*/
+static bool parseHTTPVersion(const char* begin, const char* end, version_type& v)
+{
+	if ( end - begin < 8 || ::memcmp(begin, "HTTP/", 5) != 0 ) {
+		return false;
+	}
+
+	unsigned major = 0, minor = 0;
+	const char* ptr = parseDigits(begin + 5, end, major);
+	if ( !ptr || ptr >= end || *ptr != '.' ) {
+		return false;
+	}
+	ptr = parseDigits(ptr + 1, end, minor);
+	if ( !ptr || ptr != end ) {
+		return false;
+	}
+
+	v = (major == 1 && minor == 0) ? version::HTTP_1_0 : version::HTTP_1_1;
+	return true;
+}
+
+static bool parseHTTPVersion(const std::string& str, version_type& v)
+{
+	return parseHTTPVersion(str.data(), str.data() + str.size(), v);
+}
+
+/*
+* notify :
+*	The reason phrase of a status line may itself contain spaces ( "404 Not Found" ),
+*	so with `tail` set everything after the second space is the third field.
+*/
 static bool lineSplit(const char* data_ptr, 
 					  size_t len, 
 					  std::string& field1, 
 					  std::string& field2, 
-					  std::string& field3)
+					  std::string& field3,
+					  bool tail = false)
 {
-	int count = 0;
-	const char* start_ptr = data_ptr;
-	for ( size_t i = 0; i < len; ++i ) {
-		if ( data_ptr[i] == ' ' ) {
-			++count;
-
-			std::string tmp = std::string(start_ptr, data_ptr + i - start_ptr);
-			if ( count == 1 ) field1 = std::move(tmp);
-			else if ( count == 2 ) field2 = std::move(tmp);
-			else return false;
+	const char* end = data_ptr + len;
 
-			start_ptr = data_ptr + i + 1;
-		}
+	const char* sp1 = FindChar(data_ptr, end, ' ');
+	if ( !sp1 ) {
+		return false;
 	}
-	field3 = std::string(start_ptr, data_ptr + len - start_ptr);
-
-	if ( count != 2 || start_ptr >= data_ptr + len ) {
+	const char* sp2 = FindChar(sp1 + 1, end, ' ');
+	if ( !sp2 || sp2 + 1 >= end ) {
 		return false;
 	}
+	if ( !tail && FindChar(sp2 + 1, end, ' ') ) {
+		return false;
+	}
+
+	field1.assign(data_ptr, sp1);
+	field2.assign(sp1 + 1, sp2);
+	field3.assign(sp2 + 1, end);
+
 	return true;
 }
 
-static void trim(std::string& str)
+static bool isOWS(char c)
 {
-	size_t i = 0, j = 0;
-	for ( ; i < str.length(); ++i ) {
-		if ( str[i] != ' ' ) {
-			break;
-		}
-	}
+	return c == ' ' || c == '\t';
+}
 
-	for ( j = i; j < str.length(); ++j ) {
-		if ( str[j] == ' ' ) {
-			break;
-		}
+/*
+* notify :
+*	Only the surrounding whitespace is stripped, field values such as
+*	"Mozilla/5.0 (X11; Linux x86_64)" keep their inner spaces.
+*/
+static void trim(const char* data_ptr, size_t& begin, size_t& end)
+{
+	while ( begin < end && isOWS(data_ptr[begin]) ) {
+		++begin;
+	}
+	while ( end > begin && isOWS(data_ptr[end - 1]) ) {
+		--end;
 	}
-
-	str = str.substr(i, j - i);
 }
 
-static bool headerSplit(const char* data_ptr, size_t len, std::string& key, std::string& value)
+/*
+* Splits "key : value" into trimmed [begin, end) offsets of both parts.
+*/
+static bool headerSplit(const char* data_ptr,
+						size_t len,
+						size_t& key_begin,
+						size_t& key_end,
+						size_t& value_begin,
+						size_t& value_end)
 {
-	size_t colon = 0;
-	for ( ; colon < len; ++colon ) {
-		if ( data_ptr[colon] == ':' ) {
-			break;
-		}
-	}
-	if ( colon >= len ) {
+	const char* colon_ptr = FindChar(data_ptr, data_ptr + len, ':');
+	if ( !colon_ptr ) {
 		return false;
 	}
 
-	key = std::string(data_ptr, colon);
-	value = std::string(data_ptr + colon + 1, len - colon - 1);
-
-	trim(key);
-	trim(value);
+	key_begin = 0;
+	key_end = colon_ptr - data_ptr;
+	value_begin = key_end + 1;
+	value_end = len;
+	trim(data_ptr, key_begin, key_end);
+	trim(data_ptr, value_begin, value_end);
 
 	return true;
 }
@@ -96,7 +184,8 @@ static Parser::RetCode parseRequestLine(const char* data_ptr,
 	std::string method, uri, version;
 	
 	if ( lineSplit(data_ptr, len, method, uri, version) ) {
-		if ( !isValidURI(uri) || !isValidHTTPVersion(version) ) {
+		version_type version_tmp = version::HTTP_ERR;
+		if ( !isValidURI(uri) || !parseHTTPVersion(version, version_tmp) ) {
 			return Parser::RetCode::ERROR;
 		}
 
@@ -107,7 +196,7 @@ static Parser::RetCode parseRequestLine(const char* data_ptr,
 		
 		request.setMethod(method_tmp);
 		request.setUri(std::move(uri));
-		request.setVersion(StringToVersion(version));
+		request.setVersion(version_tmp);
 
 		return Parser::RetCode::READY;
 	}
@@ -121,8 +210,9 @@ static Parser::RetCode parseResponseLine(const char* data_ptr,
 {
 	std::string version, state, description;
 	
-	if ( lineSplit(data_ptr, len, version, state, description) ) {
-		if ( !isValidHTTPVersion(version) ) {
+	if ( lineSplit(data_ptr, len, version, state, description, true) ) {
+		version_type version_tmp = version::HTTP_ERR;
+		if ( !parseHTTPVersion(version, version_tmp) ) {
 			return Parser::RetCode::ERROR;
 		}
 
@@ -131,7 +221,7 @@ static Parser::RetCode parseResponseLine(const char* data_ptr,
 			return Parser::RetCode::ERROR;
 		}
 		
-		response.setVersion(StringToVersion(version));
+		response.setVersion(version_tmp);
 		response.setState(tmp_state);
 
 		return Parser::RetCode::READY;
@@ -142,18 +232,79 @@ static Parser::RetCode parseResponseLine(const char* data_ptr,
 
 static const char* CRLF(const char* data_ptr, size_t len)
 {
-	int i = 0, j = 1;
-	for ( ; j < len; ++i, ++j ) {
-		if ( data_ptr[i] == '\r' && data_ptr[j] == '\n' ) {
-			break;
+	return FindCRLF(data_ptr, data_ptr + len);
+}
+
+static const size_t kMaxChunkLine = 4096;		// chunk size line including extensions
+static const size_t kMaxTrailerBytes = 8192;
+static const size_t kMaxBodyReserve = 64 * 1024;	// a declared length is not trusted beyond this
+
+// Digits only, false on anything else or a value that does not fit
+static bool parseContentLength(StringView value, size_t& content_len)
+{
+	if ( value.empty() ) {
+		return false;
+	}
+
+	content_len = 0;
+	for ( char c : value ) {
+		if ( c < '0' || c > '9' ) {
+			return false;
+		}
+		size_t digit = c - '0';
+		if ( content_len > (SIZE_MAX - digit) / 10 ) {
+			return false;
 		}
+		content_len = content_len * 10 + digit;
 	}
-	
-	if ( j >= len ) {
-		return nullptr;
+	return true;
+}
+
+/*
+* <chunk-size>[;chunk-ext] without its CRLF.
+* A size above SIZE_MAX / 2 could never be in memory, it is rejected : sums of it with
+* the line lengths cannot wrap.
+*/
+static bool parseChunkSize(const char* ptr, size_t len, size_t& chunk_size)
+{
+	if ( len == 0 ) {
+		return false;
 	}
 
-	return data_ptr + i;
+	chunk_size = 0;
+	for ( size_t i = 0; i < len; ++i ) {
+		char c = ptr[i];
+		if ( c == ';' ) {
+			return i > 0;	// Ignore expansion
+		}
+
+		if ( chunk_size > (SIZE_MAX >> 5) ) {
+			return false;	// above SIZE_MAX / 2 once shifted
+		}
+
+		if ( c >= '0' && c <= '9' ) {
+			chunk_size = chunk_size * 16 + (c - '0');
+		} else if ( c >= 'a' && c <= 'f' ) {
+			chunk_size = chunk_size * 16 + (c - 'a' + 10);
+		} else if ( c >= 'A' && c <= 'F' ) {
+			chunk_size = chunk_size * 16 + (c - 'A' + 10);
+		} else {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+* notify :
+*	`scan_pos` ( relative to data_ptr ) is where the search for the CRLF that ends
+*	the current line resumes, bytes before it are known to hold none. A '\r' as the
+*	last byte may still pair with a '\n' that has not arrived, so an unsuccessful
+*	search stops one byte short of `len`.
+*/
+static size_t scanStop(size_t len)
+{
+	return len ? len - 1 : 0;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -161,13 +312,15 @@ static const char* CRLF(const char* data_ptr, size_t len)
 static Parser::RetCode parseLine(const char* data_ptr,
 								 size_t len, 
 								 Message& msg,
-								 size_t& nparse)
+								 size_t& nparse,
+								 size_t& scan_pos)
 {
 	nparse = 0;
 
-	const char* crlf = CRLF(data_ptr, len);
+	const char* crlf = CRLF(data_ptr + scan_pos, len - scan_pos);
 
 	if ( !crlf ) {
+		scan_pos = scanStop(len);
 		return Parser::RetCode::WAITING_DATA;
 	}
 
@@ -189,16 +342,20 @@ static Parser::RetCode parseLine(const char* data_ptr,
 static Parser::RetCode parseHeader(const char* data_ptr,
 								   size_t len, 
 								   Message& msg,
-								   size_t& nparse)
+								   size_t& nparse,
+								   size_t& scan_pos,
+								   size_t& header_count)
 {
 	nparse = 0;
 
 	while ( true ) {
 		const char* header_ptr = data_ptr + nparse;
 		size_t remaining_len = len - nparse;
+		size_t from = scan_pos > nparse ? scan_pos - nparse : 0;
 
-		const char* crlf = CRLF(header_ptr, remaining_len);
+		const char* crlf = CRLF(header_ptr + from, remaining_len - from);
 		if ( !crlf ) {
+			scan_pos = std::max(scanStop(len), nparse);
 			return Parser::RetCode::WAITING_DATA;
 		}
 
@@ -207,31 +364,47 @@ static Parser::RetCode parseHeader(const char* data_ptr,
 			return Parser::RetCode::READY;
 		}
 
-		std::string key, value;
 		size_t header_len = crlf - header_ptr;
-		if ( headerSplit(header_ptr, header_len, key, value) ) {
-			nparse += header_len + 2;
-			msg.setHeader(std::move(key), std::move(value));
-		} else {
+		size_t key_begin, key_end, value_begin, value_end;
+		if ( !headerSplit(header_ptr, header_len, key_begin, key_end, value_begin, value_end) ) {
 			return Parser::RetCode::ERROR;
 		}
+
+		nparse += header_len + 2;
+		++header_count;
+
+		std::string value(header_ptr + value_begin, value_end - value_begin);
+		field_type f = StringToField(header_ptr + key_begin, key_end - key_begin);
+		if ( f != field::UNKNOWN ) {
+			msg.setHeader(f, std::move(value));
+		} else {
+			msg.setHeader(std::string(header_ptr + key_begin, key_end - key_begin), std::move(value));
+		}
 	}
 }
 
 
+/*
+* notify :
+*	On READY the complete body is left in `body_buf`, the caller moves it
+*	to wherever it belongs ( Message or RequestView ).
+*	A chunk that would take `body_buf` beyond `max_body` ( 0 : no limit ) sets
+*	`too_large` and fails.
+*/
 static Parser::RetCode parseBody(const char* data_ptr,
                                  size_t len,
-                                 Message& msg,
                                  size_t& nparse,
                                  size_t content_len,
                                  bool is_chunk,
-                                 std::string& body_buf)
+                                 std::string& body_buf,
+                                 size_t max_body,
+                                 bool& too_large)
 {
     nparse = 0;
+    too_large = false;
     
     if ( !is_chunk ) {
         if ( content_len == 0 ) {
-            msg.setBody(std::move(body_buf));
             return Parser::RetCode::READY;
         }
         
@@ -247,7 +420,6 @@ static Parser::RetCode parseBody(const char* data_ptr,
             if ( body_buf.length() > content_len ) {
                 body_buf.resize(content_len);
             }
-            msg.setBody(std::move(body_buf));
             return Parser::RetCode::READY;
         }
         
@@ -270,37 +442,21 @@ static Parser::RetCode parseBody(const char* data_ptr,
     while ( remaining > 0 ) {
         const char* crlf = CRLF(ptr, remaining);
         if ( !crlf ) {
-            return Parser::RetCode::WAITING_DATA;
+            return remaining > kMaxChunkLine ? Parser::RetCode::ERROR : Parser::RetCode::WAITING_DATA;
         }
         
         size_t size_line_len = crlf - ptr;
-        if ( size_line_len == 0 ) {
+        size_t chunk_size = 0;
+        if ( size_line_len > kMaxChunkLine || !parseChunkSize(ptr, size_line_len, chunk_size) ) {
             return Parser::RetCode::ERROR;
         }
-        
-        size_t chunk_size = 0;
-        bool has_extension = false;
-        for ( size_t i = 0; i < size_line_len; ++i ) {
-            char c = ptr[i];
-            if ( c == ';' ) {
-                has_extension = true;
-                break;	// Ignore expansion
-            }
-            
-            if ( c >= '0' && c <= '9' ) {
-                chunk_size = chunk_size * 16 + (c - '0');
-            } else if ( c >= 'a' && c <= 'f' ) {
-                chunk_size = chunk_size * 16 + (c - 'a' + 10);
-            } else if ( c >= 'A' && c <= 'F' ) {
-                chunk_size = chunk_size * 16 + (c - 'A' + 10);
-            } else {
-                return Parser::RetCode::ERROR;
-            }
+        if ( max_body != 0 && chunk_size > max_body - std::min(max_body, body_buf.size()) ) {
+            too_large = true;
+            return Parser::RetCode::ERROR;
         }
         
         size_t size_line_total = size_line_len + 2;
-		size_t size_line_chunk_line_total_size = size_line_total + chunk_size + 2;
-        if ( size_line_chunk_line_total_size > remaining ) {
+        if ( remaining < size_line_total + 2 || chunk_size > remaining - size_line_total - 2 ) {
             return Parser::RetCode::WAITING_DATA;
         }
         
@@ -309,10 +465,18 @@ static Parser::RetCode parseBody(const char* data_ptr,
         nparse += size_line_total;		// nparse
         
         if ( chunk_size == 0 ) {
+            /*
+            * notify :
+            *	Until the final blank line arrives nothing of the last chunk is
+            *	consumed, the next call starts again at its "0" line.
+            */
+            const char* last_chunk = ptr - size_line_total;
+            size_t last_chunk_nparse = nparse - size_line_total;
+
             while ( remaining >= 2 ) {
                 const char* trailer_crlf = CRLF(ptr, remaining);
                 if ( !trailer_crlf ) {
-                    return Parser::RetCode::WAITING_DATA;
+                    break;
                 }
                 
                 size_t trailer_line_len = trailer_crlf - ptr;
@@ -321,12 +485,11 @@ static Parser::RetCode parseBody(const char* data_ptr,
                     remaining -= 2;
                     nparse += 2;
                     
-                    msg.setBody(std::move(body_buf));
                     return Parser::RetCode::READY;
                 }
                 
-                std::string trailer_key, trailer_value;
-                if ( headerSplit(ptr, trailer_line_len, trailer_key, trailer_value) ) {
+                size_t key_begin, key_end, value_begin, value_end;
+                if ( headerSplit(ptr, trailer_line_len, key_begin, key_end, value_begin, value_end) ) {
                     // You can handle the trailing fields here,
                     // but they are usually ignored
                 }
@@ -336,11 +499,16 @@ static Parser::RetCode parseBody(const char* data_ptr,
                 remaining -= trailer_line_total;
                 nparse += trailer_line_total;
             }
+
+            if ( (size_t)(ptr + remaining - last_chunk) > kMaxTrailerBytes ) {
+                return Parser::RetCode::ERROR;
+            }
             
+            nparse = last_chunk_nparse;
             return Parser::RetCode::WAITING_DATA;
         }
         
-        if ( remaining < chunk_size + 2 ) {
+        if ( remaining < 2 || chunk_size > remaining - 2 ) {
             return Parser::RetCode::WAITING_DATA;
         }
         
@@ -359,6 +527,102 @@ static Parser::RetCode parseBody(const char* data_ptr,
     return Parser::RetCode::WAITING_DATA;
 }
 
+/*
+* RequestView path : the whole header block is parsed in one pass once its
+* terminating blank line has arrived, every field becomes a slice relative to
+* the start of the message.
+*/
+static const char* headerEnd(const char* data_ptr, size_t len, size_t from)
+{
+	const char* end = data_ptr + len;
+	const char* ptr = data_ptr + from;
+
+	while ( (ptr = FindCRLF(ptr, end)) ) {
+		if ( end - ptr >= 4 && ptr[2] == '\r' && ptr[3] == '\n' ) {
+			return ptr + 4;
+		}
+		ptr += 2;
+	}
+
+	return nullptr;
+}
+
+static Parser::RetCode parseRequestLineView(const char* data_ptr,
+											size_t len,
+											RequestView& view)
+{
+	const char* end = data_ptr + len;
+
+	const char* sp1 = FindChar(data_ptr, end, ' ');
+	if ( !sp1 ) {
+		return Parser::RetCode::ERROR;
+	}
+	const char* sp2 = FindChar(sp1 + 1, end, ' ');
+	if ( !sp2 || sp2 + 1 >= end || FindChar(sp2 + 1, end, ' ') ) {
+		return Parser::RetCode::ERROR;
+	}
+
+	version_type version_tmp = version::HTTP_ERR;
+	if ( !isValidURI(sp1 + 1, sp2) || !parseHTTPVersion(sp2 + 1, end, version_tmp) ) {
+		return Parser::RetCode::ERROR;
+	}
+
+	method_type method_tmp = StringToMethod(data_ptr, sp1 - data_ptr);
+	if ( method_tmp == method::INVALID ) {
+		return Parser::RetCode::ERROR;
+	}
+
+	view.setMethod(method_tmp);
+	view.setUri(RequestView::slice_type(sp1 + 1 - data_ptr, sp2 - sp1 - 1));
+	view.setVersion(version_tmp);
+
+	return Parser::RetCode::READY;
+}
+
+static Parser::RetCode parseHeaderView(const char* data_ptr,
+									   size_t begin,
+									   size_t end,
+									   RequestView& view,
+									   size_t max_headers,
+									   size_t& content_len,
+									   bool& is_chunk)
+{
+	content_len = 0;
+	is_chunk = false;
+
+	while ( begin < end ) {
+		if ( view.headerCount() >= max_headers ) {
+			return Parser::RetCode::ERROR;
+		}
+
+		const char* crlf = CRLF(data_ptr + begin, end - begin);
+		size_t line_end = crlf - data_ptr;
+
+		size_t key_begin, key_end, value_begin, value_end;
+		if ( !headerSplit(data_ptr + begin, line_end - begin, key_begin, key_end, value_begin, value_end) ) {
+			return Parser::RetCode::ERROR;
+		}
+
+		RequestView::slice_type key(begin + key_begin, key_end - key_begin);
+		RequestView::slice_type value(begin + value_begin, value_end - value_begin);
+		field_type f = StringToField(data_ptr + key.offset, key.length);
+		view.addHeader(key, value, f);
+
+		StringView value_view(data_ptr + value.offset, value.length);
+		if ( f == field::CONTENT_LENGTH ) {
+			if ( !parseContentLength(value_view, content_len) ) {
+				return Parser::RetCode::ERROR;
+			}
+		} else if ( f == field::TRANSFER_ENCODING ) {
+			is_chunk = value_view.iequals("chunked");
+		}
+
+		begin = line_end + 2;
+	}
+
+	return Parser::RetCode::READY;
+}
+
 /////////////////////////////////////////////////////////////
 
 class Parser::Impl {
@@ -375,14 +639,55 @@ public:
 
     void reset();
 	size_t nparse() const;
+	ErrCode errcode() const;
+	bool headerComplete() const;
     RetCode parse(const void* data, size_t len, Message& msg);
+    RetCode parse(const void* data, size_t len, RequestView& view);
+    RetCode parseHead(const void* data, size_t len, Message& msg);
+    RetCode parseHead(const void* data, size_t len, RequestView& view);
+	RetCode parseBody(const void* data, size_t len, StringView& piece, size_t& nparse);
+
+	void setMaxHeaderBytes(size_t bytes);
+	size_t maxHeaderBytes() const;
+	void setMaxHeaders(size_t count);
+	size_t maxHeaders() const;
+	void setMaxBodyBytes(size_t bytes);
+	size_t maxBodyBytes() const;
+
+private:
+	// where parseBody() is within the body
+	enum class BodyState {
+		DATA,			// Content-Length body, body_left_ bytes to go
+		CHUNK_SIZE,
+		CHUNK_DATA,		// body_left_ bytes of the current chunk to go
+		CHUNK_END,		// the CRLF after the chunk data
+		TRAILER,		// body_left_ trailer bytes seen
+		DONE,
+	};
+
+	RetCode fail(ErrCode errcode);
+	RetCode failBody(StringView piece);
+	RetCode waitHeader(size_t len);
+	RetCode parseMessage(const void* data, size_t len, Message& msg, bool head_only);
+	RetCode parseView(const void* data, size_t len, RequestView& view, bool head_only);
+	RetCode collectBody(const char* data_ptr, size_t len);
+	void startBody();
 
 private:
     Tag tag_;
 	size_t already_parse_;
+	size_t scan_pos_;		// absolute offset where the current CRLF search resumes
+	size_t header_count_;
     size_t content_length_;
     bool chunked_transfer_;
 	std::string body_buf_;
+	ErrCode errcode_;
+	BodyState body_state_;
+	size_t body_left_;
+
+	size_t max_header_bytes_;
+	size_t max_headers_;
+	size_t max_body_bytes_;
 };
 
 ////////////////////////////////////////////////////////////
@@ -390,8 +695,16 @@ private:
 Parser::Impl::Impl() :
     tag_(Tag::LINE),
 	already_parse_(0),
+	scan_pos_(0),
+	header_count_(0),
     content_length_(0),
-    chunked_transfer_(false)
+    chunked_transfer_(false),
+	errcode_(ErrCode::NONE),
+	body_state_(BodyState::DONE),
+	body_left_(0),
+	max_header_bytes_(DEFAULT_MAX_HEADER_BYTES),
+	max_headers_(DEFAULT_MAX_HEADERS),
+	max_body_bytes_(DEFAULT_MAX_BODY_BYTES)
 {
 }
 
@@ -403,9 +716,14 @@ void Parser::Impl::reset()
 {
     tag_ = Tag::LINE;
 	already_parse_ = 0;
+	scan_pos_ = 0;
+	header_count_ = 0;
     content_length_ = 0;
     chunked_transfer_ = false;
 	body_buf_ = {};
+	errcode_ = ErrCode::NONE;
+	body_state_ = BodyState::DONE;
+	body_left_ = 0;
 }
 
 size_t Parser::Impl::nparse() const
@@ -413,71 +731,191 @@ size_t Parser::Impl::nparse() const
 	return already_parse_;
 }
 
+Parser::ErrCode Parser::Impl::errcode() const
+{
+	return errcode_;
+}
+
+bool Parser::Impl::headerComplete() const
+{
+	return tag_ == Tag::BODY || tag_ == Tag::READY;
+}
+
+void Parser::Impl::setMaxHeaderBytes(size_t bytes)
+{
+	max_header_bytes_ = bytes;
+}
+
+size_t Parser::Impl::maxHeaderBytes() const
+{
+	return max_header_bytes_;
+}
+
+void Parser::Impl::setMaxHeaders(size_t count)
+{
+	max_headers_ = count;
+}
+
+size_t Parser::Impl::maxHeaders() const
+{
+	return max_headers_;
+}
+
+void Parser::Impl::setMaxBodyBytes(size_t bytes)
+{
+	max_body_bytes_ = bytes;
+}
+
+size_t Parser::Impl::maxBodyBytes() const
+{
+	return max_body_bytes_;
+}
+
+Parser::RetCode Parser::Impl::fail(ErrCode errcode)
+{
+	errcode_ = errcode;
+	return Parser::RetCode::ERROR;
+}
+
+// A piece decoded before the error is still handed out, the next call fails
+Parser::RetCode Parser::Impl::failBody(StringView piece)
+{
+	return piece.empty() ? fail(ErrCode::BAD_MESSAGE) : Parser::RetCode::WAITING_DATA;
+}
+
+// Every byte before the body counts against the header limit, even unterminated ones
+Parser::RetCode Parser::Impl::waitHeader(size_t len)
+{
+	if ( len > max_header_bytes_ ) {
+		return fail(ErrCode::HEADER_TOO_LARGE);
+	}
+	return Parser::RetCode::WAITING_DATA;
+}
+
+// The head is complete, content_length_ and chunked_transfer_ are known
+void Parser::Impl::startBody()
+{
+	tag_ = Tag::BODY;
+	if ( chunked_transfer_ ) {
+		body_state_ = BodyState::CHUNK_SIZE;
+	} else {
+		body_state_ = content_length_ ? BodyState::DATA : BodyState::DONE;
+	}
+	body_left_ = content_length_;
+}
+
 Parser::RetCode Parser::Impl::parse(const void* data, size_t len, Message& msg)
+{
+	return parseMessage(data, len, msg, false);
+}
+
+Parser::RetCode Parser::Impl::parseHead(const void* data, size_t len, Message& msg)
+{
+	return parseMessage(data, len, msg, true);
+}
+
+Parser::RetCode Parser::Impl::parseMessage(const void* data, size_t len, Message& msg, bool head_only)
 {
 	const char* data_ptr = (const char*)data;
 
+	if ( tag_ != Tag::READY && errcode_ != ErrCode::NONE ) {
+		return Parser::RetCode::ERROR;
+	}
+	if ( scan_pos_ > len ) {
+		scan_pos_ = 0;		// caller restarted with a shorter buffer
+	}
+
 	while ( tag_ != Tag::READY ) {
+		if ( tag_ == Tag::BODY && head_only ) {
+			return Parser::RetCode::READY;		// the body is left to parseBody()
+		}
+
 		size_t nparse = 0;
 		Parser::RetCode retcode = Parser::RetCode::ERROR;
 
 		switch (tag_) {
 			case Tag::LINE : {
-				retcode = parseLine(data_ptr, len, msg, nparse);
+				retcode = parseLine(data_ptr, len, msg, nparse, scan_pos_);
 					
 				if ( retcode == Parser::RetCode::READY ) {
 					already_parse_ += nparse;
+					scan_pos_ = already_parse_;
 					tag_ = Tag::HEADER;
 
+				} else if ( retcode == Parser::RetCode::WAITING_DATA ) {
+					return waitHeader(len);
+
 				} else {
-					return retcode;
+					return fail(ErrCode::BAD_MESSAGE);
 				}
 					
 				break;
 			}
 		
 			case Tag::HEADER : {
+				size_t scan_pos = scan_pos_ > already_parse_ ? scan_pos_ - already_parse_ : 0;
 				retcode = parseHeader(data_ptr + already_parse_, 
-									  len - already_parse_, msg, nparse);
+									  len - already_parse_, msg, nparse,
+									  scan_pos, header_count_);
+				scan_pos_ = already_parse_ + scan_pos;
 				
+				if ( header_count_ > max_headers_ ) {
+					return fail(ErrCode::TOO_MANY_HEADERS);
+				}
+
 				if ( retcode == Parser::RetCode::READY ) {
 					already_parse_ += nparse;
-					tag_ = Tag::BODY;
+					if ( already_parse_ > max_header_bytes_ ) {
+						return fail(ErrCode::HEADER_TOO_LARGE);
+					}
 					
-					content_length_ = std::atoi(msg.getHeader("Content-Length", "0").c_str());
-					std::string def = "No Transfer-Encoding";
-					if ( msg.getHeader("Transfer-Encoding", def) == "chunked" )
+					content_length_ = 0;
+					if ( msg.hasHeader(field::CONTENT_LENGTH) &&
+						 !parseContentLength(StringView(msg.getHeader(field::CONTENT_LENGTH)), content_length_) ) {
+						return fail(ErrCode::BAD_MESSAGE);
+					}
+					if ( StringView(msg.getHeader(field::TRANSFER_ENCODING)).iequals("chunked") )
 						chunked_transfer_ = true;
 
-					body_buf_.reserve(content_length_);
+					if ( !chunked_transfer_ && max_body_bytes_ != 0 && content_length_ > max_body_bytes_ ) {
+						return fail(ErrCode::BODY_TOO_LARGE);
+					}
+					startBody();
+
+					if ( !head_only ) {
+						body_buf_.reserve(std::min(content_length_, kMaxBodyReserve));
+					}
 
 				} else if ( retcode == Parser::RetCode::WAITING_DATA ) {
 					already_parse_ += nparse;
-					return retcode;
+					return waitHeader(len);
 
 				} else {
-					return retcode;
+					return fail(ErrCode::BAD_MESSAGE);
 				}
 					
 				break;
 			}
 
 			case Tag::BODY : {
-				retcode = parseBody(data_ptr + already_parse_, 
-									len - already_parse_, 
-									msg, nparse, content_length_,
-									chunked_transfer_, body_buf_);
+				bool too_large = false;
+				retcode = http::parseBody(data_ptr + already_parse_, 
+										  len - already_parse_, 
+										  nparse, content_length_,
+										  chunked_transfer_, body_buf_,
+										  max_body_bytes_, too_large);
 
 				if ( retcode == Parser::RetCode::READY ) {
 					already_parse_ += nparse;
 					tag_ = Tag::READY;
+					msg.setBody(std::move(body_buf_));
 
 				} else if ( retcode == Parser::RetCode::WAITING_DATA ) {
 					already_parse_ += nparse;
 					return retcode;
 				
 				} else {
-					return retcode;
+					return fail(too_large ? ErrCode::BODY_TOO_LARGE : ErrCode::BAD_MESSAGE);
 				}
 
 				break;
@@ -495,6 +933,209 @@ Parser::RetCode Parser::Impl::parse(const void* data, size_t len, Message& msg)
 	return Parser::RetCode::READY;
 }
 
+Parser::RetCode Parser::Impl::parse(const void* data, size_t len, RequestView& view)
+{
+	return parseView(data, len, view, false);
+}
+
+Parser::RetCode Parser::Impl::parseHead(const void* data, size_t len, RequestView& view)
+{
+	return parseView(data, len, view, true);
+}
+
+Parser::RetCode Parser::Impl::parseView(const void* data, size_t len, RequestView& view, bool head_only)
+{
+	const char* data_ptr = (const char*)data;
+	view.bind(data_ptr);
+
+	if ( tag_ != Tag::READY && errcode_ != ErrCode::NONE ) {
+		return Parser::RetCode::ERROR;
+	}
+	if ( scan_pos_ > len ) {
+		scan_pos_ = 0;
+	}
+
+	if ( tag_ == Tag::LINE || tag_ == Tag::HEADER ) {
+		// a terminator cut by the previous read starts at most 3 bytes back
+		const char* header_end = headerEnd(data_ptr, len, scan_pos_ >= 3 ? scan_pos_ - 3 : 0);
+		if ( !header_end ) {
+			scan_pos_ = len;
+			return waitHeader(len);
+		}
+		if ( (size_t)(header_end - data_ptr) > max_header_bytes_ ) {
+			return fail(ErrCode::HEADER_TOO_LARGE);
+		}
+
+		view.clear();
+		view.bind(data_ptr);
+
+		const char* crlf = CRLF(data_ptr, len);
+		size_t line_len = crlf - data_ptr;
+		if ( parseRequestLineView(data_ptr, line_len, view) != Parser::RetCode::READY ) {
+			return fail(ErrCode::BAD_MESSAGE);
+		}
+
+		size_t headers_end = header_end - data_ptr - 2;
+		if ( parseHeaderView(data_ptr, line_len + 2, headers_end, view, max_headers_,
+							 content_length_, chunked_transfer_) != Parser::RetCode::READY ) {
+			return fail(view.headerCount() >= max_headers_ ? ErrCode::TOO_MANY_HEADERS
+														   : ErrCode::BAD_MESSAGE);
+		}
+
+		already_parse_ = header_end - data_ptr;
+		startBody();
+
+		if ( head_only ) {
+			return Parser::RetCode::READY;
+		}
+	}
+
+	if ( tag_ == Tag::BODY ) {
+		if ( head_only ) {
+			return Parser::RetCode::READY;		// asked again, the head is still where it was
+		}
+
+		if ( chunked_transfer_ ) {
+			Parser::RetCode retcode = collectBody(data_ptr, len);
+			if ( retcode != Parser::RetCode::READY ) {
+				return retcode;
+			}
+
+			view.setBody(std::move(body_buf_));
+			body_buf_ = {};
+
+		} else {
+			if ( max_body_bytes_ != 0 && content_length_ > max_body_bytes_ ) {
+				return fail(ErrCode::BODY_TOO_LARGE);
+			}
+			// The body stays in the buffer, only wait until all of it is there
+			if ( len - already_parse_ < content_length_ ) {
+				return Parser::RetCode::WAITING_DATA;
+			}
+
+			view.setBody(RequestView::slice_type(already_parse_, content_length_));
+			already_parse_ += content_length_;
+		}
+
+		tag_ = Tag::READY;
+	}
+
+	return Parser::RetCode::READY;
+}
+
+// Decodes the chunks of a RequestView body into body_buf_
+Parser::RetCode Parser::Impl::collectBody(const char* data_ptr, size_t len)
+{
+	size_t nparse = 0;
+	bool too_large = false;
+	Parser::RetCode retcode = http::parseBody(data_ptr + already_parse_,
+											  len - already_parse_,
+											  nparse, 0, true, body_buf_,
+											  max_body_bytes_, too_large);
+	already_parse_ += nparse;
+	if ( retcode == Parser::RetCode::ERROR ) {
+		return fail(too_large ? ErrCode::BODY_TOO_LARGE : ErrCode::BAD_MESSAGE);
+	}
+	return retcode;
+}
+
+/*
+* notify :
+*	Returns after one piece of data, so each piece is a single slice of `data`.
+*	Framing bytes before and after it are consumed in the same call, unless they
+*	are malformed : then the piece comes first and the next call fails.
+*/
+Parser::RetCode Parser::Impl::parseBody(const void* data, size_t len, StringView& piece, size_t& nparse)
+{
+	const char* ptr = (const char*)data;
+	const char* end = ptr + len;
+	piece = StringView();
+	nparse = 0;
+
+	if ( errcode_ != ErrCode::NONE ) {
+		return Parser::RetCode::ERROR;
+	}
+
+	while ( true ) {
+		switch ( body_state_ ) {
+			case BodyState::DATA :
+			case BodyState::CHUNK_DATA : {
+				if ( !piece.empty() || ptr == end ) {
+					return Parser::RetCode::WAITING_DATA;
+				}
+
+				size_t take = std::min(body_left_, (size_t)(end - ptr));
+				piece = StringView(ptr, take);
+				ptr += take;
+				body_left_ -= take;
+				if ( body_left_ == 0 ) {
+					body_state_ = body_state_ == BodyState::DATA ? BodyState::DONE : BodyState::CHUNK_END;
+				}
+				break;
+			}
+
+			case BodyState::CHUNK_SIZE : {
+				const char* crlf = CRLF(ptr, end - ptr);
+				if ( !crlf ) {
+					if ( (size_t)(end - ptr) > kMaxChunkLine ) {
+						return failBody(piece);
+					}
+					return Parser::RetCode::WAITING_DATA;
+				}
+
+				size_t chunk_size = 0;
+				if ( (size_t)(crlf - ptr) > kMaxChunkLine || !parseChunkSize(ptr, crlf - ptr, chunk_size) ) {
+					return failBody(piece);
+				}
+				ptr = crlf + 2;
+				body_left_ = chunk_size;
+				body_state_ = chunk_size ? BodyState::CHUNK_DATA : BodyState::TRAILER;
+				break;
+			}
+
+			case BodyState::CHUNK_END : {
+				if ( end - ptr < 2 ) {
+					return Parser::RetCode::WAITING_DATA;
+				}
+				if ( ptr[0] != '\r' || ptr[1] != '\n' ) {
+					return failBody(piece);
+				}
+				ptr += 2;
+				body_state_ = BodyState::CHUNK_SIZE;
+				break;
+			}
+
+			case BodyState::TRAILER : {
+				const char* crlf = CRLF(ptr, end - ptr);
+				if ( !crlf ) {
+					if ( body_left_ + (end - ptr) > kMaxTrailerBytes ) {
+						return failBody(piece);
+					}
+					return Parser::RetCode::WAITING_DATA;
+				}
+
+				// trailer fields are ignored, as in parse()
+				body_left_ += crlf - ptr + 2;
+				if ( body_left_ > kMaxTrailerBytes ) {
+					return failBody(piece);
+				}
+				if ( crlf == ptr ) {
+					body_state_ = BodyState::DONE;
+				}
+				ptr = crlf + 2;
+				break;
+			}
+
+			case BodyState::DONE : {
+				tag_ = Tag::READY;
+				return Parser::RetCode::READY;
+			}
+		}
+
+		nparse = ptr - (const char*)data;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////
 
 Parser::Parser() :
@@ -516,11 +1157,71 @@ size_t Parser::nparse() const
 	return pImpl_->nparse();
 }
 
+Parser::ErrCode Parser::errcode() const
+{
+	return pImpl_->errcode();
+}
+
+bool Parser::headerComplete() const
+{
+	return pImpl_->headerComplete();
+}
+
+void Parser::setMaxHeaderBytes(size_t bytes)
+{
+	pImpl_->setMaxHeaderBytes(bytes);
+}
+
+size_t Parser::maxHeaderBytes() const
+{
+	return pImpl_->maxHeaderBytes();
+}
+
+void Parser::setMaxHeaders(size_t count)
+{
+	pImpl_->setMaxHeaders(count);
+}
+
+size_t Parser::maxHeaders() const
+{
+	return pImpl_->maxHeaders();
+}
+
+void Parser::setMaxBodyBytes(size_t bytes)
+{
+	pImpl_->setMaxBodyBytes(bytes);
+}
+
+size_t Parser::maxBodyBytes() const
+{
+	return pImpl_->maxBodyBytes();
+}
+
 Parser::RetCode Parser::parse(const void* data, size_t len, Message& msg)
 {
 	return pImpl_->parse(data, len, msg);
 }
 
+Parser::RetCode Parser::parse(const void* data, size_t len, RequestView& view)
+{
+	return pImpl_->parse(data, len, view);
+}
+
+Parser::RetCode Parser::parseHead(const void* data, size_t len, Message& msg)
+{
+	return pImpl_->parseHead(data, len, msg);
+}
+
+Parser::RetCode Parser::parseHead(const void* data, size_t len, RequestView& view)
+{
+	return pImpl_->parseHead(data, len, view);
+}
+
+Parser::RetCode Parser::parseBody(const void* data, size_t len, StringView& piece, size_t& nparse)
+{
+	return pImpl_->parseBody(data, len, piece, nparse);
+}
+
 }	// namespace http
 }	// namespace protocol
 }	// namespace lcy
@@ -2,6 +2,9 @@
 #define __LCY_PROTOCOL_HTTP_PARSER_H__
 
 #include <memory>
+#include <stddef.h>
+
+#include "lcy/protocol/src/string_view.h"
 
 namespace lcy {
 namespace protocol {
@@ -10,6 +13,7 @@ namespace http {
 class Message;
 class Request;
 class Response;
+class RequestView;
 
 class Parser {
 public:
@@ -19,12 +23,77 @@ public:
         ERROR               // an error occurred
     };
 
+	enum class ErrCode {
+		NONE,
+		BAD_MESSAGE,		// malformed line, header or body
+		HEADER_TOO_LARGE,	// start line + headers exceed maxHeaderBytes()
+		TOO_MANY_HEADERS,	// more than maxHeaders() fields
+		BODY_TOO_LARGE,		// buffered body above maxBodyBytes()
+	};
+
+	enum {
+		DEFAULT_MAX_HEADER_BYTES = 32 * 1024,
+		DEFAULT_MAX_HEADERS = 100,
+		DEFAULT_MAX_BODY_BYTES = 0,			// no limit
+	};
+
     Parser();
     ~Parser();
 
+	/*
+	* notify :
+	*	A message arriving in pieces is resumed where the previous call stopped, each
+	*	byte before the body is scanned a bounded number of times however it is split.
+	*	The limits bound the work per message, they survive reset().
+	*/
+	void setMaxHeaderBytes(size_t bytes);
+	size_t maxHeaderBytes() const;
+	void setMaxHeaders(size_t count);
+	size_t maxHeaders() const;
+	// bodies parse() collects, a streamed body ( see parseBody() ) is not limited
+	void setMaxBodyBytes(size_t bytes);
+	size_t maxBodyBytes() const;
+
     void reset();
 	size_t nparse() const;
+	ErrCode errcode() const;	// why the last ERROR was returned
+	bool headerComplete() const;	// start line and headers of the current message are parsed
     RetCode parse(const void* data, size_t len, Message& msg);
+	/*
+	* Zero copy variant, `view` refers into `data` ( see RequestView ).
+	* Same contract as above : `data` always starts at the first byte of the message.
+	*/
+    RetCode parse(const void* data, size_t len, RequestView& view);
+
+	/*
+	* Body streaming, for bodies too large to wait for :
+	*
+	*	if ( parser.parseHead(in.readBegin(), in.dataBytes(), view) == Parser::READY ) {
+	*		... look at the head ...
+	*		in.read(parser.nparse());
+	*	}
+	*	...
+	*	StringView piece;
+	*	size_t nparse = 0;
+	*	Parser::RetCode retcode = parser.parseBody(in.readBegin(), in.dataBytes(), piece, nparse);
+	*	... use piece ...
+	*	in.read(nparse);
+	*
+	* parseHead() returns READY once the head is complete, nparse() is then its size
+	* and the body is left untouched : either parse() collects it as usual, or the head
+	* is dropped from the buffer and parseBody() decodes the body piece by piece.
+	* The Message variant is how a client reads a response : whether a body follows
+	* ( HEAD, 1xx, 204, 304, or up to the close ) is for the caller to decide.
+	*
+	* notify :
+	*	Unlike parse(), parseBody() starts at the first byte the previous call did not
+	*	consume. `piece` refers into `data`, chunked framing is removed. WAITING_DATA with
+	*	an empty piece asks for more data, READY ends the body ( `piece` may still hold
+	*	its last bytes ).
+	*/
+    RetCode parseHead(const void* data, size_t len, Message& msg);
+    RetCode parseHead(const void* data, size_t len, RequestView& view);
+	RetCode parseBody(const void* data, size_t len, StringView& piece, size_t& nparse);
 
 private:
 	Parser(const Parser&);
@@ -1,29 +1,82 @@
 #include "lcy/protocol/src/http/request.h"
 
-#include <sstream>
+#include <string.h>
 
 namespace lcy {
 namespace protocol {
 namespace http {
 
-std::string MethodToString(method_type method)
+static const char* MethodName(method_type method)
 {
+    switch ( method ) {
 #define XX(_code, _method, _desc)  \
-    if ( (int)method == _code ) { return #_method; }
-    HTTP_METHOD_MAP(XX);
+        case method::_method : return #_desc;
+        HTTP_METHOD_MAP(XX)
 #undef XX
-    return "";
+        default : return "";
+    }
 }
 
-method_type StringToMethod(const std::string& method_str)
+std::string MethodToString(method_type method)
 {
-#define XX(_code, _method, _desc)   \
-    if ( #_method == method_str ) { return method::_method; }
-    HTTP_METHOD_MAP(XX);
-#undef XX
+    return MethodName(method);
+}
+
+/*
+* Methods bucketed by ( length, first letter ), a bucket holds the few names
+* sharing both ( UNBIND / UNLINK / UNLOCK ) and is resolved with memcmp.
+*/
+struct MethodTable {
+    enum {
+        MAX_LEN = 16,
+        BUCKET = 4,
+    };
+
+    int8_t buckets[MAX_LEN][26][BUCKET];
+
+    MethodTable()
+    {
+        ::memset(buckets, -1, sizeof(buckets));
+        for ( int i = 0; i < (int)method::INVALID; ++i ) {
+            const char* name = MethodName((method_type)i);
+            int8_t* bucket = buckets[::strlen(name)][name[0] - 'A'];
+
+            size_t n = 0;
+            while ( bucket[n] >= 0 ) {
+                ++n;    // BUCKET is above the largest collision count of HTTP_METHOD_MAP
+            }
+            bucket[n] = (int8_t)i;
+        }
+    }
+};
+
+method_type StringToMethod(const char* data, size_t len)
+{
+    static const MethodTable table;
+
+    if ( len == 0 || len >= MethodTable::MAX_LEN ) {
+        return method::INVALID;
+    }
+
+    unsigned letter = (unsigned)(data[0] - 'A');
+    if ( letter >= 26 ) {
+        return method::INVALID;
+    }
+
+    const int8_t* bucket = table.buckets[len][letter];
+    for ( size_t n = 0; n < MethodTable::BUCKET && bucket[n] >= 0; ++n ) {
+        if ( ::memcmp(data, MethodName((method_type)bucket[n]), len) == 0 ) {
+            return (method_type)bucket[n];
+        }
+    }
     return method::INVALID;
 }
 
+method_type StringToMethod(const std::string& method_str)
+{
+    return StringToMethod(method_str.data(), method_str.size());
+}
+
 ///////////////////////////////////////////////////////
 
 Request::Request() :
@@ -65,20 +118,24 @@ void Request::clear()
 
 std::string Request::dump() const
 {
-	std::ostringstream oss;
-	oss << MethodToString(method_) << " "
-		<< uri_ << " "
-		<< VersionToString(version()) 
-		<< "\r\n";
-
-	for ( auto& kv : getHeadersRef() ) {
-		oss << kv.first << ": " << kv.second << "\r\n";
-	}
-
-	oss << "\r\n";
-	oss << body();
-
-	return oss.str();
+	std::string out = MethodName(method_);
+	out += ' ';
+	out += uri_;
+	out += ' ';
+	out += VersionToString(version());
+	out += "\r\n";
+
+	visitHeaders([&out](StringView key, const std::string& value){
+		out.append(key.data(), key.size());
+		out += ": ";
+		out += value;
+		out += "\r\n";
+	});
+
+	out += "\r\n";
+	out += body();
+
+	return out;
 }
 
 }   // namespace http
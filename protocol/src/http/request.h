@@ -69,6 +69,8 @@ method_type;
 
 std::string MethodToString(method_type method);
 method_type StringToMethod(const std::string& method_str);
+// case sensitive, matches the wire names ( "M-SEARCH" ), no string compares per method
+method_type StringToMethod(const char* data, size_t len);
 
 class Request : 
 	public Message
@@ -0,0 +1,165 @@
+#include "lcy/protocol/src/http/request_view.h"
+
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+RequestView::RequestView() :
+	base_(nullptr),
+	method_(method::INVALID),
+	version_(version::HTTP_ERR),
+	body_owned_(false)
+{
+	headers_.reserve(INIT_HEADERS);
+	::memset(fields_, 0, sizeof(fields_));
+}
+
+RequestView::~RequestView()
+{
+}
+
+method_type RequestView::method() const
+{
+	return method_;
+}
+
+StringView RequestView::uri() const
+{
+	return resolve(uri_);
+}
+
+version_type RequestView::version() const
+{
+	return version_;
+}
+
+StringView RequestView::body() const
+{
+	if ( body_owned_ ) {
+		return StringView(body_storage_);
+	}
+	return resolve(body_);
+}
+
+size_t RequestView::headerCount() const
+{
+	return headers_.size();
+}
+
+RequestView::header_type RequestView::header(size_t index) const
+{
+	return header_type(resolve(headers_[index].first),
+					   resolve(headers_[index].second));
+}
+
+StringView RequestView::getHeader(StringView key, StringView def) const
+{
+	field_type f = StringToField(key.data(), key.size());
+	if ( f != field::UNKNOWN ) {
+		return getHeader(f, def);
+	}
+
+	for ( auto& kv : headers_ ) {
+		if ( resolve(kv.first).iequals(key) ) {
+			return resolve(kv.second);
+		}
+	}
+	return def;
+}
+
+StringView RequestView::getHeader(field_type f, StringView def) const
+{
+	if ( f >= field::UNKNOWN || fields_[(size_t)f] == 0 ) {
+		return def;
+	}
+	return resolve(headers_[fields_[(size_t)f] - 1].second);
+}
+
+void RequestView::clear()
+{
+	base_ = nullptr;
+	method_ = method::INVALID;
+	version_ = version::HTTP_ERR;
+	uri_ = slice_type();
+	headers_.clear();
+	::memset(fields_, 0, sizeof(fields_));
+	body_ = slice_type();
+	body_owned_ = false;
+	body_storage_.clear();
+}
+
+void RequestView::toRequest(Request& request) const
+{
+	request.clear();
+	request.setMethod(method_);
+	request.setUri(uri().toString());
+	request.setVersion(version_);
+
+	for ( size_t i = 0; i < headers_.size(); ++i ) {
+		header_type kv = header(i);
+		request.setHeader(kv.first.toString(), kv.second.toString());
+	}
+
+	request.setBody(body().toString());
+}
+
+Request RequestView::toRequest() const
+{
+	Request request;
+	toRequest(request);
+	return request;
+}
+
+void RequestView::bind(const char* base)
+{
+	base_ = base;
+}
+
+void RequestView::setMethod(method_type method)
+{
+	method_ = method;
+}
+
+void RequestView::setUri(slice_type uri)
+{
+	uri_ = uri;
+}
+
+void RequestView::setVersion(version_type version)
+{
+	version_ = version;
+}
+
+void RequestView::addHeader(slice_type key, slice_type value, field_type f)
+{
+	headers_.push_back(std::make_pair(key, value));
+	if ( f < field::UNKNOWN && headers_.size() <= UINT16_MAX ) {
+		fields_[(size_t)f] = (uint16_t)headers_.size();
+	}
+}
+
+void RequestView::setBody(slice_type body)
+{
+	body_ = body;
+	body_owned_ = false;
+}
+
+void RequestView::setBody(std::string body)
+{
+	body_storage_ = std::move(body);
+	body_owned_ = true;
+}
+
+StringView RequestView::resolve(slice_type slice) const
+{
+	if ( !base_ ) {
+		return StringView();
+	}
+	return StringView(base_ + slice.offset, slice.length);
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
@@ -0,0 +1,97 @@
+#ifndef __LCY_PROTOCOL_HTTP_REQUEST_VIEW_H__
+#define __LCY_PROTOCOL_HTTP_REQUEST_VIEW_H__
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <stddef.h>
+
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/http/message.h"
+#include "lcy/protocol/src/http/request.h"
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+/*
+* Request whose fields are slices of the receive buffer instead of owned strings.
+*
+* The parser records every field as an ( offset, length ) pair relative to the start
+* of the message and binds them to the buffer passed to the call that returns READY,
+* so the buffer may be reallocated between partial reads. The views stay valid until
+* that buffer is consumed or modified, use toRequest() to keep anything longer.
+*
+* notify :
+*	A chunked body is not contiguous in the buffer, it is decoded into storage owned
+*	by the view. Any other body is a plain slice.
+*	clear() keeps the capacity of the header array, reusing one view across the
+*	requests of a connection does not allocate in the steady state.
+*/
+class RequestView {
+public:
+	typedef struct Slice {
+		size_t offset;
+		size_t length;
+
+		Slice() : offset(0), length(0) {}
+		Slice(size_t o, size_t l) : offset(o), length(l) {}
+	} slice_type;
+
+	typedef std::pair<StringView, StringView> header_type;
+	typedef std::vector<std::pair<slice_type, slice_type> > header_array_type;
+
+	enum {
+		INIT_HEADERS = 16,
+	};
+
+	RequestView();
+	~RequestView();
+
+	method_type method() const;
+	StringView uri() const;
+	version_type version() const;
+	StringView body() const;
+
+	size_t headerCount() const;
+	header_type header(size_t index) const;
+	// Case insensitive, well known fields are a slot lookup, others a linear scan
+	StringView getHeader(StringView key, StringView def = StringView()) const;
+	StringView getHeader(field_type f, StringView def = StringView()) const;
+
+	void clear();
+
+	void toRequest(Request& request) const;
+	Request toRequest() const;
+
+	/*
+	* Filled by the parser
+	*/
+	void bind(const char* base);
+	void setMethod(method_type method);
+	void setUri(slice_type uri);
+	void setVersion(version_type version);
+	void addHeader(slice_type key, slice_type value, field_type f = field::UNKNOWN);
+	void setBody(slice_type body);
+	void setBody(std::string body);
+
+private:
+	StringView resolve(slice_type slice) const;
+
+private:
+	const char* base_;
+	method_type method_;
+	version_type version_;
+	slice_type uri_;
+	header_array_type headers_;
+	uint16_t fields_[FIELD_COUNT];		// 1 + index in headers_ of the last occurrence, 0 if absent
+	slice_type body_;
+	bool body_owned_;
+	std::string body_storage_;
+};
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_REQUEST_VIEW_H__
@@ -1,6 +1,6 @@
 #include "lcy/protocol/src/http/response.h"
 
-#include <sstream>
+#include "lcy/protocol/src/http/serializer.h"
 
 namespace lcy {
 namespace protocol {
@@ -8,11 +8,13 @@ namespace http {
 
 std::string StateToString(state_type state)
 {
+    switch ( state ) {
 #define XX(_code, _state, _desc) \
-    if ( _code == (int)state ) { return #_state; }
-    HTTP_STATUS_MAP(XX)
+        case state::_state : return #_state;
+        HTTP_STATUS_MAP(XX)
 #undef XX
-    return "";
+        default : return "";
+    }
 }
 
 state_type StringToState(const std::string& state_str)
@@ -26,18 +28,21 @@ state_type StringToState(const std::string& state_str)
 
 std::string StateToDesc(state_type state)
 {
-#define XX(_code, _state, _desc)    \
-    if ( _code == (int)state ) {           \
-        return #_desc;  \
-    }
-    HTTP_STATUS_MAP(XX)
+    switch ( state ) {
+#define XX(_code, _state, _desc) \
+        case state::_state : return #_desc;
+        HTTP_STATUS_MAP(XX)
 #undef XX
-    return "";
+        default : return "";
+    }
 }
 
 Response::Response() :
     Message(Message::proto_type::RESPONSE),
-    state_(state::INVALID)
+    state_(state::INVALID),
+	file_offset_(0),
+	file_length_(0),
+	compression_(COMPRESSION_DEFAULT)
 {
 }
 
@@ -55,30 +60,74 @@ void Response::setState(state_type state)
 	state_ = state;
 }
 
+void Response::setFile(open_file_ptr file, size_t offset, size_t length)
+{
+	file_ = std::move(file);
+	file_offset_ = file_ ? offset : 0;
+	file_length_ = file_ ? length : 0;
+}
+
+const open_file_ptr& Response::file() const
+{
+	return file_;
+}
+
+size_t Response::fileOffset() const
+{
+	return file_offset_;
+}
+
+size_t Response::fileLength() const
+{
+	return file_length_;
+}
+
+void Response::setCompression(int level)
+{
+	compression_ = level;
+}
+
+int Response::compression() const
+{
+	return compression_;
+}
+
 void Response::clear()
 {
 	Message::clear();
 	
 	state_ = state::INVALID;
+	file_.reset();
+	file_offset_ = 0;
+	file_length_ = 0;
+	compression_ = COMPRESSION_DEFAULT;
 }
 
 std::string Response::dump() const
 {
-	std::ostringstream oss;
-
-	oss << VersionToString(version()) << " "
-		<< (int)state_ << " "
-		<< StateToDesc(state_)
-		<< "\r\n";
-
-	for ( auto& kv_iter : getHeadersRef() ) {
-		oss << kv_iter.first << ": " << kv_iter.second << "\r\n";
+	// the status line table only holds HTTP/1.0 and HTTP/1.1
+	std::string out;
+	if ( version() == version::HTTP_1_0 || version() == version::HTTP_1_1 ) {
+		out = StatusLine(state_, version()).toString();
+	}
+	if ( out.empty() ) {
+		out = VersionToString(version()) + " " + std::to_string((int)state_) + " " + StateToDesc(state_) + "\r\n";
 	}
 
-	oss << "\r\n";
-	oss << body();
+	visitHeaders([&out](StringView key, const std::string& value){
+		out.append(key.data(), key.size());
+		out += ": ";
+		out += value;
+		out += "\r\n";
+	});
+
+	out += "\r\n";
+	out += body();
+	if ( file_ ) {
+		file_->read(file_offset_, file_length_, out);
+	}
 
-	return oss.str();
+	return out;
 }
 
 }   // namespace http
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "lcy/protocol/src/http/message.h"
+#include "lcy/protocol/src/http/open_file.h"
 
 namespace lcy {
 namespace protocol {
@@ -91,17 +92,44 @@ class Response :
 	public Message 
 {
 public:
+	enum {
+		COMPRESSION_DEFAULT = -1,		// as http::Server::setCompression() says
+		COMPRESSION_OFF = 0,
+	};
+
     Response();
     ~Response();
 	
 	state_type state() const;
 	void setState(state_type state);
 
+	/*
+	* Body sent from [offset, offset + length) of an open file instead of body() :
+	* http::Server hands it to sendfile(2) and sets its Content-Length, dump()
+	* reads it in. The response holds the file open until it is cleared.
+	*/
+	void setFile(open_file_ptr file, size_t offset, size_t length);
+	const open_file_ptr& file() const;
+	size_t fileOffset() const;
+	size_t fileLength() const;
+
+	/*
+	* zlib level ( 1 to 9 ) http::Server compresses the body with when the client
+	* accepts gzip or deflate ( see CompressResponse() ), or COMPRESSION_OFF. Set by
+	* the handler of a route to override the level of the server for that route.
+	*/
+	void setCompression(int level);
+	int compression() const;
+
 	void clear() override;
     std::string dump() const override;
     
 private:
     state_type state_;
+	open_file_ptr file_;
+	size_t file_offset_;
+	size_t file_length_;
+	int compression_;
 };
 
 }   // namespace http
@@ -0,0 +1,391 @@
+#include "lcy/protocol/src/http/response_cache.h"
+#include "lcy/protocol/src/http/request_view.h"
+#include "lcy/protocol/src/http/response.h"
+#include "lcy/protocol/src/http/serializer.h"
+
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+static const StringView kCRLF("\r\n", 2);
+static const StringView kDate("Date: ", 6);
+static const StringView kAge("Age: ", 5);
+static const StringView kConnectionClose("Connection: close\r\n", 19);
+
+static char* put(char* out, StringView s)
+{
+	::memcpy(out, s.data(), s.size());
+	return out + s.size();
+}
+
+static StringView Trim(StringView s)
+{
+	size_t begin = 0, end = s.size();
+	while ( begin < end && (s[begin] == ' ' || s[begin] == '\t') ) ++begin;
+	while ( end > begin && (s[end - 1] == ' ' || s[end - 1] == '\t') ) --end;
+	return s.substr(begin, end - begin);
+}
+
+/*
+* func(StringView name, StringView value) for every "name[=value]" of a comma separated
+* list, quotes are dropped from the value and a comma between them does not split.
+*/
+template <typename Func>
+static void VisitDirectives(StringView list, Func func)
+{
+	size_t pos = 0;
+	while ( pos < list.size() ) {
+		size_t end = pos;
+		bool quoted = false;
+		while ( end < list.size() && (quoted || list[end] != ',') ) {
+			if ( list[end] == '"' ) {
+				quoted = !quoted;
+			}
+			++end;
+		}
+
+		StringView item = list.substr(pos, end - pos);
+		size_t eq = item.find('=');
+		StringView name = Trim(item.substr(0, eq));
+		StringView value;
+		if ( eq != StringView::npos ) {
+			value = Trim(item.substr(eq + 1));
+			if ( value.size() >= 2 && value[0] == '"' && value[value.size() - 1] == '"' ) {
+				value = value.substr(1, value.size() - 2);
+			}
+		}
+		if ( !name.empty() ) {
+			func(name, value);
+		}
+		pos = end + 1;
+	}
+}
+
+// delta-seconds into ms, false unless all digits ( capped at 2^31 seconds as RFC 9111 asks )
+static bool ParseSeconds(StringView value, time_t& ms)
+{
+	if ( value.empty() ) {
+		return false;
+	}
+
+	uint64_t seconds = 0;
+	for ( size_t i = 0; i < value.size(); ++i ) {
+		if ( value[i] < '0' || value[i] > '9' ) {
+			return false;
+		}
+		if ( seconds < ((uint64_t)1 << 31) ) {
+			seconds = seconds * 10 + (value[i] - '0');
+		}
+	}
+	if ( seconds > ((uint64_t)1 << 31) ) {
+		seconds = (uint64_t)1 << 31;
+	}
+	ms = (time_t)seconds * 1000;
+	return true;
+}
+
+// cacheable by default, RFC 9110 15.1 ( 206 left out : ranges are not stored )
+static bool CacheableState(state_type state)
+{
+	switch ( state ) {
+	case state::OK:
+	case state::NON_AUTHORITATIVE_INFORMATION:
+	case state::NO_CONTENT:
+	case state::MULTIPLE_CHOICES:
+	case state::MOVED_PERMANENTLY:
+	case state::PERMANENT_REDIRECT:
+	case state::NOT_FOUND:
+	case state::METHOD_NOT_ALLOWED:
+	case state::GONE:
+	case state::URI_TOO_LONG:
+	case state::NOT_IMPLEMENTED:
+		return true;
+	default:
+		return false;
+	}
+}
+
+///////////////////////////////////////////////////////////////
+
+ResponseCache::ResponseCache(size_t max_bytes, field_array_type fields) :
+	max_bytes_(max_bytes),
+	fields_(std::move(fields)),
+	bytes_(0),
+	hits_(0),
+	misses_(0)
+{
+}
+
+ResponseCache::~ResponseCache()
+{
+}
+
+bool ResponseCache::makeKey(const RequestView& request, std::string& key) const
+{
+	if ( request.method() != method::GET && request.method() != method::HEAD ) {
+		return false;
+	}
+	if ( !request.getHeader(field::AUTHORIZATION).empty() || !request.getHeader(field::RANGE).empty() ) {
+		return false;
+	}
+
+	bool bypass = false;
+	VisitDirectives(request.getHeader(field::CACHE_CONTROL), [&bypass](StringView name, StringView){
+		if ( name.iequals("no-cache") || name.iequals("no-store") ) {
+			bypass = true;
+		}
+	});
+	if ( bypass ) {
+		return false;
+	}
+
+	StringView host = request.getHeader(field::HOST);
+	StringView uri = request.uri();
+	key.assign(host.data(), host.size());
+	key.push_back('\0');
+	key.append(uri.data(), uri.size());
+	for ( field_type f : fields_ ) {
+		StringView value = request.getHeader(f);
+		key.push_back('\0');
+		key.append(value.data(), value.size());
+	}
+	return true;
+}
+
+ResponseCache::Lookup ResponseCache::find(const std::string& key, time_t now, const Entry*& entry)
+{
+	node_map_type::iterator iter = index_.find(key);
+	if ( iter == index_.end() ) {
+		++misses_;
+		return Lookup::MISS;
+	}
+
+	Node& node = *iter->second;
+	if ( now >= node.entry.expires && now >= node.entry.stale_until ) {
+		drop(iter);
+		++misses_;
+		return Lookup::MISS;
+	}
+
+	nodes_.splice(nodes_.begin(), nodes_, iter->second);
+	entry = &node.entry;
+	++hits_;
+
+	if ( now < node.entry.expires || node.entry.revalidating ) {
+		return Lookup::HIT;
+	}
+	node.entry.revalidating = true;
+	return Lookup::REVALIDATE;
+}
+
+bool ResponseCache::store(const std::string& key, const Response& response, time_t now)
+{
+	time_t max_age = 0, stale = 0;
+	if ( !lifetime(response, max_age, stale) ) {
+		return false;
+	}
+
+	size_t limit = max_bytes_ / MAX_ENTRY_DIVISOR;
+	if ( response.body().size() + key.size() > limit ) {
+		return false;
+	}
+
+	asio::DynamicBuffer head(1024);
+	size_t head_size = SerializeResponseHead(response, head);		// no Date : written per hit
+	std::shared_ptr<std::string> bytes = std::make_shared<std::string>();
+	bytes->reserve(head_size + response.body().size());
+	bytes->assign(head.readBegin(), head_size);
+	bytes->append(response.body());
+	if ( bytes->size() + key.size() > limit ) {
+		return false;
+	}
+
+	node_map_type::iterator iter = index_.find(key);
+	if ( iter != index_.end() ) {
+		drop(iter);
+	}
+
+	Node node;
+	node.key = key;
+	node.entry.bytes = std::move(bytes);
+	node.entry.head_size = head_size;
+	node.entry.stored = now;
+	node.entry.expires = now + max_age;
+	node.entry.stale_until = now + max_age + stale;
+	node.entry.revalidating = false;
+
+	nodes_.push_front(std::move(node));
+	index_.emplace(nodes_.front().key, nodes_.begin());
+	bytes_ += Cost(nodes_.front());
+
+	while ( bytes_ > max_bytes_ && !nodes_.empty() ) {
+		drop(index_.find(nodes_.back().key));
+	}
+	return true;
+}
+
+void ResponseCache::erase(const std::string& key)
+{
+	node_map_type::iterator iter = index_.find(key);
+	if ( iter != index_.end() ) {
+		drop(iter);
+	}
+}
+
+void ResponseCache::clear()
+{
+	index_.clear();
+	nodes_.clear();
+	bytes_ = 0;
+}
+
+bool ResponseCache::lifetime(const Response& response, time_t& max_age, time_t& stale) const
+{
+	if ( !CacheableState(response.state()) || response.file() ) {
+		return false;
+	}
+	if ( response.hasHeader(field::SET_COOKIE) || response.hasHeader(field::CONNECTION) ||
+		 response.hasHeader(field::DATE) ) {
+		return false;
+	}
+
+	bool vary_ok = true;
+	const field_array_type& fields = fields_;
+	VisitDirectives(response.getHeader(field::VARY), [&vary_ok, &fields](StringView name, StringView){
+		field_type f = StringToField(name.data(), name.size());
+		if ( f == field::HOST ) {
+			return;
+		}
+		bool keyed = false;
+		for ( field_type k : fields ) {
+			keyed |= (k == f);
+		}
+		vary_ok &= keyed && f != field::UNKNOWN;		// "*" is unknown as well
+	});
+	if ( !vary_ok ) {
+		return false;
+	}
+
+	bool storable = true, has_max_age = false, has_s_maxage = false, revalidate = false;
+	time_t s_maxage = 0;
+	max_age = 0;
+	stale = 0;
+	VisitDirectives(response.getHeader(field::CACHE_CONTROL), [&](StringView name, StringView value){
+		if ( name.iequals("no-store") || name.iequals("private") || name.iequals("no-cache") ) {
+			storable = false;
+		} else if ( name.iequals("s-maxage") ) {
+			has_s_maxage = ParseSeconds(value, s_maxage);
+		} else if ( name.iequals("max-age") ) {
+			has_max_age = ParseSeconds(value, max_age);
+		} else if ( name.iequals("stale-while-revalidate") ) {
+			ParseSeconds(value, stale);
+		} else if ( name.iequals("must-revalidate") || name.iequals("proxy-revalidate") ) {
+			revalidate = true;
+		}
+	});
+
+	if ( !storable || (!has_max_age && !has_s_maxage) ) {
+		return false;
+	}
+	if ( has_s_maxage ) {
+		max_age = s_maxage;
+	}
+	if ( revalidate ) {
+		stale = 0;
+	}
+	return max_age + stale > 0;
+}
+
+const ResponseCache::field_array_type& ResponseCache::fields() const
+{
+	return fields_;
+}
+
+size_t ResponseCache::size() const
+{
+	return index_.size();
+}
+
+size_t ResponseCache::bytes() const
+{
+	return bytes_;
+}
+
+size_t ResponseCache::maxBytes() const
+{
+	return max_bytes_;
+}
+
+size_t ResponseCache::hits() const
+{
+	return hits_;
+}
+
+size_t ResponseCache::misses() const
+{
+	return misses_;
+}
+
+void ResponseCache::Write(const Entry& entry, StringView date, time_t now,
+						  bool head_only, bool close, asio::DynamicBuffer& buffer)
+{
+	const std::string& bytes = *entry.bytes;
+	size_t blank = entry.head_size - kCRLF.size();
+	size_t tail = head_only ? entry.head_size : bytes.size();
+
+	char age[20];
+	size_t age_len = 0;
+	if ( now - entry.stored >= 1000 ) {
+		age_len = FormatDecimal((uint64_t)(now - entry.stored) / 1000, age);
+	}
+
+	size_t size = tail;
+	if ( !date.empty() ) {
+		size += kDate.size() + date.size() + kCRLF.size();
+	}
+	if ( age_len ) {
+		size += kAge.size() + age_len + kCRLF.size();
+	}
+	if ( close ) {
+		size += kConnectionClose.size();
+	}
+
+	buffer.reserve(size);
+	char* out = buffer.writeBegin();
+	out = put(out, StringView(bytes.data(), blank));
+	if ( !date.empty() ) {
+		out = put(out, kDate);
+		out = put(out, date);
+		out = put(out, kCRLF);
+	}
+	if ( age_len ) {
+		out = put(out, kAge);
+		out = put(out, StringView(age, age_len));
+		out = put(out, kCRLF);
+	}
+	if ( close ) {
+		out = put(out, kConnectionClose);
+	}
+	put(out, StringView(bytes.data() + blank, tail - blank));
+	buffer.write(size);
+}
+
+void ResponseCache::drop(node_map_type::iterator iter)
+{
+	node_list_type::iterator node = iter->second;
+	bytes_ -= Cost(*node);
+	index_.erase(iter);
+	nodes_.erase(node);
+}
+
+// the key is held twice : by the node and by the index
+size_t ResponseCache::Cost(const Node& node)
+{
+	return node.key.size() * 2 + node.entry.bytes->size();
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
@@ -0,0 +1,134 @@
+#ifndef __LCY_PROTOCOL_HTTP_RESPONSE_CACHE_H__
+#define __LCY_PROTOCOL_HTTP_RESPONSE_CACHE_H__
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <time.h>
+#include <stddef.h>
+
+#include "lcy/asio/src/dynamic_buffer.h"
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/http/message.h"
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+class RequestView;
+class Response;
+
+/*
+* Serialized responses by request, the cache of http::Server ( Server::setCache() ).
+*
+* Key : Host, URI and the values of `fields`, GET and HEAD share an entry ( only
+* GET responses are stored ). An entry holds the response as it goes on the wire
+* without its Date, so a hit is one copy : Date ( and Age, Connection ) go in
+* before the blank line.
+*
+* The handler opts in with Cache-Control ( RFC 9111, RFC 5861 ) :
+*	"max-age=N" or "s-maxage=N"			fresh for N seconds
+*	"stale-while-revalidate=N"			then served stale for N more seconds while
+*										one request refreshes it
+*	"no-store", "private", "no-cache"	never stored
+* "must-revalidate" or "proxy-revalidate" turn stale serving off. Set-Cookie, a Vary
+* on a field outside the key, Connection or Date set by the handler, a file body or a
+* status that is not cacheable by default keep a response out as well.
+*
+* notify :
+*	Not thread safe : the server keeps one cache per loop thread, max_bytes bounds
+*	each of them. Least recently used entries go first once it is exceeded.
+*	Times are milliseconds of asio::details::now_ms().
+*/
+class ResponseCache {
+public:
+	typedef std::shared_ptr<const std::string> bytes_ptr;
+	typedef std::vector<field_type> field_array_type;
+
+	struct Entry {
+		bytes_ptr bytes;		// head without Date, then the body
+		size_t head_size;		// up to and with the blank line
+		time_t stored;
+		time_t expires;			// fresh before
+		time_t stale_until;		// may be served while revalidating before
+		bool revalidating;
+	};
+
+	enum class Lookup {
+		MISS,
+		HIT,
+		REVALIDATE,		// a stale hit, the caller refreshes the entry
+	};
+
+	enum {
+		DEFAULT_MAX_BYTES = 64 * 1024 * 1024,
+		MAX_ENTRY_DIVISOR = 8,		// one entry takes at most max_bytes / 8
+	};
+
+	explicit ResponseCache(size_t max_bytes = DEFAULT_MAX_BYTES,
+						   field_array_type fields = field_array_type());
+	~ResponseCache();
+
+	/*
+	* The key of `request` into `key`, false for a request the cache neither answers
+	* nor stores : a method other than GET and HEAD, Authorization, Range or
+	* "Cache-Control: no-cache" / "no-store".
+	*/
+	bool makeKey(const RequestView& request, std::string& key) const;
+
+	/*
+	* REVALIDATE hands a stale entry to one caller only : it is marked revalidating
+	* and a HIT for the others until store() replaces it or it runs out.
+	*/
+	Lookup find(const std::string& key, time_t now, const Entry*& entry);
+	// false when `response` may not be stored, an entry under `key` is left as it was
+	bool store(const std::string& key, const Response& response, time_t now);
+	void erase(const std::string& key);
+	void clear();
+
+	// freshness and stale period of a storable response in ms, false for any other
+	bool lifetime(const Response& response, time_t& max_age, time_t& stale) const;
+
+	const field_array_type& fields() const;
+	size_t size() const;
+	size_t bytes() const;
+	size_t maxBytes() const;
+	size_t hits() const;		// REVALIDATE included
+	size_t misses() const;
+
+	// the entry with Date and Age, `close` adds "Connection: close"
+	static void Write(const Entry& entry, StringView date, time_t now,
+					  bool head_only, bool close, asio::DynamicBuffer& buffer);
+
+private:
+	ResponseCache(const ResponseCache&);
+	ResponseCache& operator=(const ResponseCache&);
+
+	struct Node {
+		std::string key;
+		Entry entry;
+	};
+
+	typedef std::list<Node> node_list_type;
+	typedef std::unordered_map<std::string, node_list_type::iterator> node_map_type;
+
+	void drop(node_map_type::iterator iter);
+	static size_t Cost(const Node& node);
+
+private:
+	size_t max_bytes_;
+	field_array_type fields_;
+	size_t bytes_;
+	size_t hits_;
+	size_t misses_;
+	node_list_type nodes_;		// most recently used first
+	node_map_type index_;
+};
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_RESPONSE_CACHE_H__
@@ -0,0 +1,329 @@
+#include "lcy/protocol/src/http/router.h"
+
+#include <vector>
+#include <algorithm>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+RouteParams::RouteParams() :
+	size_(0)
+{
+}
+
+RouteParams::~RouteParams()
+{
+}
+
+size_t RouteParams::size() const
+{
+	return size_;
+}
+
+bool RouteParams::empty() const
+{
+	return size_ == 0;
+}
+
+const RouteParams::param_type& RouteParams::operator[](size_t index) const
+{
+	return params_[index];
+}
+
+StringView RouteParams::get(StringView name, StringView def) const
+{
+	for ( size_t i = 0; i < size_; ++i ) {
+		if ( params_[i].first == name ) {
+			return params_[i].second;
+		}
+	}
+	return def;
+}
+
+void RouteParams::clear()
+{
+	size_ = 0;
+}
+
+bool RouteParams::push(StringView name, StringView value)
+{
+	if ( size_ == MAX_PARAMS ) {
+		return false;
+	}
+	params_[size_++] = param_type(name, value);
+	return true;
+}
+
+void RouteParams::truncate(size_t size)
+{
+	if ( size < size_ ) {
+		size_ = size;
+	}
+}
+
+///////////////////////////////////////////////////////////////
+
+// one id table per method, the last one ( method::INVALID ) for any method
+static const size_t METHOD_SLOTS = (size_t)method::INVALID + 1;
+static const size_t ANY_SLOT = (size_t)method::INVALID;
+
+static size_t SlotOf(method_type m)
+{
+	size_t slot = (size_t)m;
+	return slot < METHOD_SLOTS ? slot : ANY_SLOT;
+}
+
+/*
+* An edge of the tree. Static nodes carry the bytes of their edge in `prefix`,
+* siblings never share a first byte. Parameter and wildcard nodes consume their
+* segment / the rest of the path and carry the capture name instead.
+*/
+class Router::Node {
+public:
+	typedef std::unique_ptr<Node> node_ptr;
+	typedef std::vector<node_ptr> node_array_type;
+
+	Node(std::string p = std::string()) :
+		prefix(std::move(p))
+	{
+		for ( size_t i = 0; i < METHOD_SLOTS; ++i ) {
+			ids[i] = NO_ROUTE;
+		}
+	}
+
+	size_t id(size_t slot) const
+	{
+		return ids[slot] != NO_ROUTE ? ids[slot] : ids[ANY_SLOT];
+	}
+
+	std::string prefix;
+	std::string name;
+	std::string indices;		// first byte of each static child, in the order of `children`
+	node_array_type children;
+	node_ptr param;
+	node_ptr wildcard;
+	size_t ids[METHOD_SLOTS];
+};
+
+typedef Router::Node node_type;
+
+static size_t CommonPrefix(const std::string& a, StringView b)
+{
+	size_t n = std::min(a.size(), b.size());
+	size_t i = 0;
+	while ( i < n && a[i] == b[i] ) {
+		++i;
+	}
+	return i;
+}
+
+// Walks the static bytes `s` down from `node`, splitting an edge where `s` leaves it
+static node_type* StaticNode(node_type* node, StringView s, bool create)
+{
+	while ( !s.empty() ) {
+		size_t i = node->indices.find(s[0]);
+		if ( i == std::string::npos ) {
+			if ( !create ) {
+				return nullptr;
+			}
+			node->indices.push_back(s[0]);
+			node->children.push_back(node_type::node_ptr(new node_type(s.toString())));
+			return node->children.back().get();
+		}
+
+		node_type* child = node->children[i].get();
+		size_t common = CommonPrefix(child->prefix, s);
+		if ( common < child->prefix.size() ) {
+			if ( !create ) {
+				return nullptr;
+			}
+
+			node_type::node_ptr middle(new node_type(child->prefix.substr(0, common)));
+			node_type::node_ptr tail = std::move(node->children[i]);
+			tail->prefix.erase(0, common);
+			middle->indices.push_back(tail->prefix[0]);
+			middle->children.push_back(std::move(tail));
+			node->children[i] = std::move(middle);
+			child = node->children[i].get();
+		}
+
+		s = s.substr(common);
+		node = child;
+	}
+	return node;
+}
+
+// ':' and '*' only open a capture at the start of a segment
+static bool CaptureAt(StringView pattern, size_t pos)
+{
+	return (pattern[pos] == ':' || pattern[pos] == '*') && pos > 0 && pattern[pos - 1] == '/';
+}
+
+// The node that ends `pattern`, nullptr for an invalid pattern or a name conflict
+static node_type* PatternNode(node_type* node, StringView pattern, bool create)
+{
+	if ( pattern.empty() || pattern[0] != '/' ) {
+		return nullptr;
+	}
+
+	size_t pos = 0;
+	while ( pos < pattern.size() ) {
+		if ( !CaptureAt(pattern, pos) ) {
+			size_t end = pos + 1;
+			while ( end < pattern.size() && !CaptureAt(pattern, end) ) {
+				++end;
+			}
+
+			node = StaticNode(node, pattern.substr(pos, end - pos), create);
+			if ( !node ) {
+				return nullptr;
+			}
+			pos = end;
+			continue;
+		}
+
+		bool wildcard = pattern[pos] == '*';
+		size_t end = pattern.find('/', pos);
+		if ( end == StringView::npos ) {
+			end = pattern.size();
+		}
+
+		StringView name = pattern.substr(pos + 1, end - pos - 1);
+		if ( name.empty() || (wildcard && end != pattern.size()) ) {
+			return nullptr;
+		}
+
+		node_type::node_ptr& capture = wildcard ? node->wildcard : node->param;
+		if ( !capture ) {
+			if ( !create ) {
+				return nullptr;
+			}
+			capture.reset(new node_type());
+			capture->name = name.toString();
+		} else if ( StringView(capture->name) != name ) {
+			return nullptr;
+		}
+
+		node = capture.get();
+		pos = end;
+	}
+	return node;
+}
+
+/*
+* notify :
+*	Depth first in priority order : static edge, parameter, wildcard. Captures of
+*	a branch that fails are dropped before the next one is tried. A route with more
+*	than MAX_PARAMS captures still matches, the extra values are not recorded.
+*/
+static size_t Lookup(const node_type* node, StringView path, size_t pos,
+					 size_t slot, RouteParams& params)
+{
+	if ( pos == path.size() ) {
+		size_t id = node->id(slot);
+		if ( id != Router::NO_ROUTE || !node->wildcard ) {
+			return id;
+		}
+	} else {
+		size_t i = node->indices.find(path[pos]);
+		if ( i != std::string::npos ) {
+			const node_type* child = node->children[i].get();
+			if ( path.substr(pos).startsWith(child->prefix) ) {
+				size_t id = Lookup(child, path, pos + child->prefix.size(), slot, params);
+				if ( id != Router::NO_ROUTE ) {
+					return id;
+				}
+			}
+		}
+
+		if ( node->param ) {
+			size_t end = path.find('/', pos);
+			if ( end == StringView::npos ) {
+				end = path.size();
+			}
+
+			if ( end > pos ) {
+				size_t mark = params.size();
+				params.push(node->param->name, path.substr(pos, end - pos));
+				size_t id = Lookup(node->param.get(), path, end, slot, params);
+				if ( id != Router::NO_ROUTE ) {
+					return id;
+				}
+				params.truncate(mark);
+			}
+		}
+	}
+
+	if ( node->wildcard ) {
+		size_t id = node->wildcard->id(slot);
+		if ( id != Router::NO_ROUTE ) {
+			params.push(node->wildcard->name, path.substr(pos));
+			return id;
+		}
+	}
+	return Router::NO_ROUTE;
+}
+
+///////////////////////////////////////////////////////////////
+
+Router::Router() :
+	root_(new Node())
+{
+}
+
+Router::~Router()
+{
+}
+
+size_t Router::add(method_type method, StringView pattern, size_t id)
+{
+	Node* node = PatternNode(root_.get(), pattern, true);
+	if ( !node || id == NO_ROUTE ) {
+		return NO_ROUTE;
+	}
+
+	size_t& slot = node->ids[SlotOf(method)];
+	if ( slot == NO_ROUTE ) {
+		slot = id;
+	}
+	return slot;
+}
+
+size_t Router::remove(method_type method, StringView pattern)
+{
+	Node* node = PatternNode(root_.get(), pattern, false);
+	if ( !node ) {
+		return NO_ROUTE;
+	}
+
+	size_t& slot = node->ids[SlotOf(method)];
+	size_t id = slot;
+	slot = NO_ROUTE;
+	return id;
+}
+
+size_t Router::match(method_type method, StringView uri, RouteParams& params) const
+{
+	params.clear();
+
+	StringView path = Path(uri);
+	if ( path.empty() ) {
+		return NO_ROUTE;
+	}
+	return Lookup(root_.get(), path, 0, SlotOf(method), params);
+}
+
+StringView Router::Path(StringView uri)
+{
+	for ( size_t i = 0; i < uri.size(); ++i ) {
+		if ( uri[i] == '?' || uri[i] == '#' ) {
+			return uri.substr(0, i);
+		}
+	}
+	return uri;
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
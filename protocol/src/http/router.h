@@ -0,0 +1,102 @@
+#ifndef __LCY_PROTOCOL_HTTP_ROUTER_H__
+#define __LCY_PROTOCOL_HTTP_ROUTER_H__
+
+#include <string>
+#include <memory>
+#include <utility>
+#include <stddef.h>
+
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/http/request.h"
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+/*
+* Values captured by a route, fixed capacity so matching never allocates.
+* Names point into the Router, values into the matched URI.
+*/
+class RouteParams {
+public:
+	typedef std::pair<StringView, StringView> param_type;
+
+	enum {
+		MAX_PARAMS = 8,
+	};
+
+	RouteParams();
+	~RouteParams();
+
+	size_t size() const;
+	bool empty() const;
+	const param_type& operator[](size_t index) const;
+	StringView get(StringView name, StringView def = StringView()) const;
+
+	void clear();
+	bool push(StringView name, StringView value);	// false when full
+	void truncate(size_t size);
+
+private:
+	param_type params_[MAX_PARAMS];
+	size_t size_;
+};
+
+/*
+* Compressed radix tree from path patterns to route ids.
+*
+* pattern :
+*	"/users"			static, byte for byte
+*	"/users/:id"		":name" matches one non empty segment ( up to the next '/' )
+*	"/files/" "*path"	"*name" matches the rest of the path, possibly empty, last only
+*
+* Static edges win over a parameter, a parameter over a wildcard, a branch that
+* fails further down falls back to the next kind ( "/users/new" and "/users/:id"
+* can live side by side ).
+*
+* Every node has one table of ids per method, method::INVALID is the table for
+* any method and is consulted when the request method has no route of its own.
+*
+* notify :
+*	match() ignores the query and the fragment of the URI, does not allocate and
+*	returns NO_ROUTE when nothing matches. It may run concurrently with other
+*	match() calls, but not with add() or remove().
+*/
+class Router {
+public:
+	enum : size_t {
+		NO_ROUTE = (size_t)-1,
+	};
+
+	Router();
+	~Router();
+
+	/*
+	* Returns the id of the route : `id` when it is new, the id registered before
+	* when the method and pattern are already known, NO_ROUTE for an invalid pattern
+	* or a parameter whose name conflicts with an existing one at the same place.
+	*/
+	size_t add(method_type method, StringView pattern, size_t id);
+	// returns the id that was removed, or NO_ROUTE
+	size_t remove(method_type method, StringView pattern);
+
+	size_t match(method_type method, StringView uri, RouteParams& params) const;
+
+	// the path part of a request target, without "?query" and "#fragment"
+	static StringView Path(StringView uri);
+
+	class Node;		// defined in router.cc
+
+private:
+	Router(const Router&);
+	Router& operator=(const Router&);
+
+private:
+	std::unique_ptr<Node> root_;
+};
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_ROUTER_H__
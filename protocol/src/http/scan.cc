@@ -0,0 +1,205 @@
+#include "lcy/protocol/src/http/scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LCY_PROTOCOL_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+static const char* FindCRLFScalar(const char* begin, const char* end)
+{
+	for ( const char* ptr = begin; ptr + 1 < end; ++ptr ) {
+		if ( ptr[0] == '\r' && ptr[1] == '\n' ) {
+			return ptr;
+		}
+	}
+	return nullptr;
+}
+
+static const char* FindCharScalar(const char* begin, const char* end, char c)
+{
+	for ( const char* ptr = begin; ptr < end; ++ptr ) {
+		if ( *ptr == c ) {
+			return ptr;
+		}
+	}
+	return nullptr;
+}
+
+#ifdef LCY_PROTOCOL_SCAN_X86
+
+/*
+* notify :
+*	The CRLF kernels compare the block at `ptr` against '\r' and the block at
+*	`ptr + 1` against '\n', a set bit in both masks is a CRLF starting inside the
+*	block. The tail shorter than one block falls back to the scalar loop.
+*/
+__attribute__((target("sse2")))
+static const char* FindCRLFSSE2(const char* begin, const char* end)
+{
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+
+	const char* ptr = begin;
+	for ( ; end - ptr >= 17; ptr += 16 ) {
+		__m128i a = _mm_loadu_si128((const __m128i*)ptr);
+		__m128i b = _mm_loadu_si128((const __m128i*)(ptr + 1));
+		int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, cr),
+												   _mm_cmpeq_epi8(b, lf)));
+		if ( mask ) {
+			return ptr + __builtin_ctz(mask);
+		}
+	}
+
+	return FindCRLFScalar(ptr, end);
+}
+
+__attribute__((target("sse2")))
+static const char* FindCharSSE2(const char* begin, const char* end, char c)
+{
+	const __m128i needle = _mm_set1_epi8(c);
+
+	const char* ptr = begin;
+	for ( ; end - ptr >= 16; ptr += 16 ) {
+		__m128i a = _mm_loadu_si128((const __m128i*)ptr);
+		int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(a, needle));
+		if ( mask ) {
+			return ptr + __builtin_ctz(mask);
+		}
+	}
+
+	return FindCharScalar(ptr, end, c);
+}
+
+__attribute__((target("avx2")))
+static const char* FindCRLFAVX2(const char* begin, const char* end)
+{
+	const __m256i cr = _mm256_set1_epi8('\r');
+	const __m256i lf = _mm256_set1_epi8('\n');
+
+	const char* ptr = begin;
+	for ( ; end - ptr >= 33; ptr += 32 ) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)ptr);
+		__m256i b = _mm256_loadu_si256((const __m256i*)(ptr + 1));
+		unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, cr),
+																		 _mm256_cmpeq_epi8(b, lf)));
+		if ( mask ) {
+			return ptr + __builtin_ctz(mask);
+		}
+	}
+
+	return FindCRLFSSE2(ptr, end);
+}
+
+__attribute__((target("avx2")))
+static const char* FindCharAVX2(const char* begin, const char* end, char c)
+{
+	const __m256i needle = _mm256_set1_epi8(c);
+
+	const char* ptr = begin;
+	for ( ; end - ptr >= 32; ptr += 32 ) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)ptr);
+		unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, needle));
+		if ( mask ) {
+			return ptr + __builtin_ctz(mask);
+		}
+	}
+
+	return FindCharSSE2(ptr, end, c);
+}
+
+#endif	// LCY_PROTOCOL_SCAN_X86
+
+///////////////////////////////////////////////////////////////
+
+typedef const char* (*find_crlf_type)(const char*, const char*);
+typedef const char* (*find_char_type)(const char*, const char*, char);
+
+static scan_level_type SupportedLevel()
+{
+#ifdef LCY_PROTOCOL_SCAN_X86
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports("avx2") ) {
+		return scan_level::AVX2;
+	}
+	if ( __builtin_cpu_supports("sse2") ) {
+		return scan_level::SSE2;
+	}
+#endif
+	return scan_level::SCALAR;
+}
+
+struct ScanTable {
+	scan_level_type level;
+	find_crlf_type find_crlf;
+	find_char_type find_char;
+
+	ScanTable() { select(SupportedLevel()); }
+
+	void select(scan_level_type l)
+	{
+		level = scan_level::SCALAR;
+		find_crlf = &FindCRLFScalar;
+		find_char = &FindCharScalar;
+
+#ifdef LCY_PROTOCOL_SCAN_X86
+		if ( l == scan_level::AVX2 ) {
+			level = l;
+			find_crlf = &FindCRLFAVX2;
+			find_char = &FindCharAVX2;
+		} else if ( l == scan_level::SSE2 ) {
+			level = l;
+			find_crlf = &FindCRLFSSE2;
+			find_char = &FindCharSSE2;
+		}
+#endif
+	}
+};
+
+static ScanTable& Table()
+{
+	static ScanTable table;
+	return table;
+}
+
+const char* FindCRLF(const char* begin, const char* end)
+{
+	return Table().find_crlf(begin, end);
+}
+
+const char* FindChar(const char* begin, const char* end, char c)
+{
+	return Table().find_char(begin, end, c);
+}
+
+scan_level_type ScanLevel()
+{
+	return Table().level;
+}
+
+scan_level_type SetScanLevel(scan_level_type level)
+{
+	static const scan_level_type supported = SupportedLevel();
+	if ( (uint8_t)level > (uint8_t)supported ) {
+		level = supported;
+	}
+
+	Table().select(level);
+	return Table().level;
+}
+
+const char* ScanLevelToString(scan_level_type level)
+{
+	switch ( level ) {
+		case scan_level::AVX2 : return "avx2";
+		case scan_level::SSE2 : return "sse2";
+		default : return "scalar";
+	}
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
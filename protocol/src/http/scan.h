@@ -0,0 +1,45 @@
+#ifndef __LCY_PROTOCOL_HTTP_SCAN_H__
+#define __LCY_PROTOCOL_HTTP_SCAN_H__
+
+#include <stdint.h>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+/*
+* Delimiter search kernels used by the parser.
+*
+* On x86 the widest instruction set the CPU supports is picked once at startup
+* ( AVX2 : 32 bytes per step, SSE2 : 16 bytes per step ), every other target uses
+* the scalar byte loop. All kernels return the same result for the same input.
+*/
+typedef
+enum class scan_level :
+	uint8_t
+{
+	SCALAR = 0,
+	SSE2 = 1,
+	AVX2 = 2,
+}
+scan_level_type;
+
+// first "\r\n" in [begin, end), returns the '\r' or nullptr
+const char* FindCRLF(const char* begin, const char* end);
+// first `c` in [begin, end), returns nullptr when absent
+const char* FindChar(const char* begin, const char* end, char c);
+
+scan_level_type ScanLevel();
+/*
+* notify :
+*	For tests and benchmarks, not thread safe : call before any parsing starts.
+*	A level above what the CPU supports is clamped, the level in effect is returned.
+*/
+scan_level_type SetScanLevel(scan_level_type level);
+const char* ScanLevelToString(scan_level_type level);
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_SCAN_H__
@@ -0,0 +1,261 @@
+#include "lcy/protocol/src/http/serializer.h"
+
+#include <string>
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+struct StatusTable {
+	enum {
+		MIN_CODE = 100,
+		MAX_CODE = 600,
+	};
+
+	std::string lines[2][MAX_CODE - MIN_CODE];		// [ HTTP/1.0, HTTP/1.1 ][ code ]
+
+	StatusTable()
+	{
+#define XX(_code, _state, _desc)												\
+		lines[0][_code - MIN_CODE] = "HTTP/1.0 " #_code " " #_desc "\r\n";		\
+		lines[1][_code - MIN_CODE] = "HTTP/1.1 " #_code " " #_desc "\r\n";
+		HTTP_STATUS_MAP(XX)
+#undef XX
+	}
+};
+
+StringView StatusLine(state_type state, version_type v)
+{
+	static const StatusTable table;
+
+	int code = (int)state;
+	if ( code < StatusTable::MIN_CODE || code >= StatusTable::MAX_CODE ) {
+		return StringView();
+	}
+	return StringView(table.lines[v == version::HTTP_1_0 ? 0 : 1][code - StatusTable::MIN_CODE]);
+}
+
+size_t FormatDecimal(uint64_t value, char* out)
+{
+	char tmp[20];
+	size_t n = 0;
+	do {
+		tmp[n++] = (char)('0' + value % 10);
+		value /= 10;
+	} while ( value );
+
+	for ( size_t i = 0; i < n; ++i ) {
+		out[i] = tmp[n - 1 - i];
+	}
+	return n;
+}
+
+///////////////////////////////////////////////////////////////
+
+static const StringView kCRLF("\r\n", 2);
+static const StringView kColon(": ", 2);
+static const StringView kContentLength("Content-Length: ", 16);
+static const StringView kDate("Date: ", 6);
+
+static char* put(char* out, StringView s)
+{
+	::memcpy(out, s.data(), s.size());
+	return out + s.size();
+}
+
+static size_t headerLinesSize(const Message& msg)
+{
+	size_t size = 0;
+	msg.visitHeaders([&size](StringView key, const std::string& value){
+		size += key.size() + value.size() + 4;
+	});
+	return size;
+}
+
+static char* putHeaderLines(const Message& msg, char* out)
+{
+	msg.visitHeaders([&out](StringView key, const std::string& value){
+		out = put(out, key);
+		out = put(out, kColon);
+		out = put(out, StringView(value));
+		out = put(out, kCRLF);
+	});
+	return out;
+}
+
+/*
+* Content-Length lines the caller did not set itself.
+* notify :
+*	1xx, 204 and 304 responses never carry one.
+*/
+static bool needContentLength(const Message& msg, int code)
+{
+	if ( msg.hasHeader(field::CONTENT_LENGTH) || msg.hasHeader(field::TRANSFER_ENCODING) ) {
+		return false;
+	}
+	if ( code < 200 || code == 204 || code == 304 ) {
+		return false;
+	}
+	return true;
+}
+
+/*
+* Head of any message : start line, fields, the optional generated fields, blank line.
+* Returns the bytes written, `with_body` appends the body as well.
+*/
+static size_t serialize(const Message& msg,
+						StringView start_line,
+						StringView date,
+						bool add_length,
+						bool with_body,
+						asio::DynamicBuffer& buffer)
+{
+	char digits[20];
+	size_t ndigits = add_length ? FormatDecimal(msg.body().size(), digits) : 0;
+	bool add_date = !date.empty() && !msg.hasHeader(field::DATE);
+
+	size_t size = start_line.size() + headerLinesSize(msg) + kCRLF.size();
+	if ( add_length ) {
+		size += kContentLength.size() + ndigits + kCRLF.size();
+	}
+	if ( add_date ) {
+		size += kDate.size() + date.size() + kCRLF.size();
+	}
+	if ( with_body ) {
+		size += msg.body().size();
+	}
+
+	buffer.reserve(size);
+	char* out = buffer.writeBegin();
+
+	out = put(out, start_line);
+	out = putHeaderLines(msg, out);
+	if ( add_length ) {
+		out = put(out, kContentLength);
+		out = put(out, StringView(digits, ndigits));
+		out = put(out, kCRLF);
+	}
+	if ( add_date ) {
+		out = put(out, kDate);
+		out = put(out, date);
+		out = put(out, kCRLF);
+	}
+	out = put(out, kCRLF);
+	if ( with_body ) {
+		out = put(out, StringView(msg.body()));
+	}
+
+	buffer.write(size);
+	return size;
+}
+
+static size_t serializeResponse(const Response& response,
+								asio::DynamicBuffer& buffer,
+								StringView date,
+								bool with_body,
+								bool add_length = true)
+{
+	int code = (int)response.state();
+
+	StringView status = StatusLine(response.state(), response.version());
+	char fallback[32];
+	if ( status.empty() ) {
+		// outside HTTP_STATUS_MAP : number only, empty reason phrase
+		char* out = put(fallback, response.version() == version::HTTP_1_0 ? "HTTP/1.0 " : "HTTP/1.1 ");
+		out += FormatDecimal(code < 0 ? 0 : (uint64_t)code, out);
+		out = put(out, StringView(" \r\n", 3));
+		status = StringView(fallback, out - fallback);
+	}
+
+	return serialize(response, status, date, add_length && needContentLength(response, code), with_body, buffer);
+}
+
+static size_t serializeRequest(const Request& request,
+							   asio::DynamicBuffer& buffer,
+							   bool with_body)
+{
+	std::string line = MethodToString(request.method());
+	line.reserve(line.size() + request.uri().size() + 11);
+	line += ' ';
+	line += request.uri();
+	line += request.version() == version::HTTP_1_0 ? " HTTP/1.0\r\n" : " HTTP/1.1\r\n";
+
+	bool add_length = !request.body().empty() && needContentLength(request, 200);
+	return serialize(request, StringView(line), StringView(), add_length, with_body, buffer);
+}
+
+///////////////////////////////////////////////////////////////
+
+size_t SerializeResponseHead(const Response& response,
+							 asio::DynamicBuffer& buffer,
+							 StringView date)
+{
+	return serializeResponse(response, buffer, date, false);
+}
+
+size_t SerializeResponse(const Response& response,
+						 asio::DynamicBuffer& buffer,
+						 StringView date)
+{
+	return serializeResponse(response, buffer, date, true);
+}
+
+size_t SerializeStreamHead(const Response& response,
+						   asio::DynamicBuffer& buffer,
+						   StringView date)
+{
+	return serializeResponse(response, buffer, date, false, false);
+}
+
+size_t SerializeChunk(StringView data, asio::DynamicBuffer& buffer)
+{
+	if ( data.empty() ) {
+		return 0;
+	}
+
+	static const char kHex[] = "0123456789abcdef";
+	char digits[16];
+	size_t ndigits = 0;
+	for ( size_t value = data.size(); value; value >>= 4 ) {
+		digits[ndigits++] = kHex[value & 0xf];
+	}
+
+	size_t size = ndigits + kCRLF.size() + data.size() + kCRLF.size();
+	buffer.reserve(size);
+	char* out = buffer.writeBegin();
+
+	while ( ndigits ) {
+		*out++ = digits[--ndigits];
+	}
+	out = put(out, kCRLF);
+	out = put(out, data);
+	out = put(out, kCRLF);
+
+	buffer.write(size);
+	return size;
+}
+
+size_t SerializeLastChunk(asio::DynamicBuffer& buffer)
+{
+	static const StringView kLastChunk("0\r\n\r\n", 5);
+
+	buffer.reserve(kLastChunk.size());
+	put(buffer.writeBegin(), kLastChunk);
+	buffer.write(kLastChunk.size());
+	return kLastChunk.size();
+}
+
+size_t SerializeRequestHead(const Request& request, asio::DynamicBuffer& buffer)
+{
+	return serializeRequest(request, buffer, false);
+}
+
+size_t SerializeRequest(const Request& request, asio::DynamicBuffer& buffer)
+{
+	return serializeRequest(request, buffer, true);
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
@@ -0,0 +1,62 @@
+#ifndef __LCY_PROTOCOL_HTTP_SERIALIZER_H__
+#define __LCY_PROTOCOL_HTTP_SERIALIZER_H__
+
+#include <stddef.h>
+
+#include "lcy/asio/src/dynamic_buffer.h"
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/http/request.h"
+#include "lcy/protocol/src/http/response.h"
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+/*
+* Wire format writers, appending to a DynamicBuffer.
+*
+* The exact size is computed first so the buffer grows at most once, then every
+* part is copied straight in : status lines come from a table built once from
+* HTTP_STATUS_MAP and Content-Length is formatted without iostreams.
+*
+* notify :
+*	Content-Length is added from the body size unless the message sets it or uses
+*	Transfer-Encoding, Date is added from `date` ( see DateClock ) unless the
+*	message sets it or `date` is empty.
+*	The *Head variants stop after the blank line, so a large body can be sent from
+*	its own storage ( e.g. as the second buffer of a gather write ).
+*/
+size_t SerializeResponseHead(const Response& response,
+							 asio::DynamicBuffer& buffer,
+							 StringView date = StringView());
+size_t SerializeResponse(const Response& response,
+						 asio::DynamicBuffer& buffer,
+						 StringView date = StringView());
+
+/*
+* Head of a body whose length is not known yet : Content-Length is never added, the
+* body is chunked ( Transfer-Encoding set by the caller ) or ends with the connection.
+*/
+size_t SerializeStreamHead(const Response& response,
+						   asio::DynamicBuffer& buffer,
+						   StringView date = StringView());
+
+// One chunk of a chunked body, nothing for empty `data` ( an empty chunk ends the body )
+size_t SerializeChunk(StringView data, asio::DynamicBuffer& buffer);
+// The last chunk and the blank line, without trailer fields
+size_t SerializeLastChunk(asio::DynamicBuffer& buffer);
+
+size_t SerializeRequestHead(const Request& request, asio::DynamicBuffer& buffer);
+size_t SerializeRequest(const Request& request, asio::DynamicBuffer& buffer);
+
+// "HTTP/1.1 200 OK\r\n", empty for a state outside HTTP_STATUS_MAP
+StringView StatusLine(state_type state, version_type v = version::HTTP_1_1);
+
+// decimal digits of `value` into `out` ( at least 20 bytes ), returns the length
+size_t FormatDecimal(uint64_t value, char* out);
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_SERIALIZER_H__
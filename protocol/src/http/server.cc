@@ -0,0 +1,1634 @@
+#include "lcy/protocol/src/http/server.h"
+#include "lcy/protocol/src/http/parser.h"
+#include "lcy/protocol/src/http/request_view.h"
+#include "lcy/protocol/src/http/response.h"
+#include "lcy/protocol/src/http/serializer.h"
+#include "lcy/protocol/src/http/date_clock.h"
+#include "lcy/protocol/src/http/response_cache.h"
+#include "lcy/protocol/src/http/compression.h"
+#include "lcy/protocol/src/http/details/util.h"
+#include "lcy/protocol/src/http2/frame.h"
+#include "lcy/protocol/src/http2/session.h"
+
+#include "lcy/asio/src/io_context.hpp"
+#include "lcy/asio/src/steady_timer.h"
+#include "lcy/asio/src/thread_pool.h"
+#include "lcy/asio/src/dynamic_buffer.h"
+#include "lcy/asio/src/ip/tcp.h"
+#include "lcy/asio/src/details/timer_service.h"
+
+#include <list>
+#include <atomic>
+#include <future>
+#include <vector>
+#include <algorithm>
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+static const StringView kClose("close", 5);
+
+// Connection field of a response, returns whether the connection stays open after it
+static bool FinishHead(Response& response, bool keep_alive)
+{
+	if ( response.hasHeader(field::CONNECTION) ) {
+		return keep_alive && !details::HasToken(StringView(response.getHeader(field::CONNECTION)), kClose);
+	}
+
+	if ( !keep_alive ) {
+		if ( response.version() != version::HTTP_1_0 ) {
+			response.setHeader(field::CONNECTION, "close");
+		}
+	} else if ( response.version() == version::HTTP_1_0 ) {
+		response.setHeader(field::CONNECTION, "keep-alive");
+	}
+	return keep_alive;
+}
+
+///////////////////////////////////////////////////////////////
+
+struct ServerConfig {
+	Server::handler_type handler;
+	Server::stream_handler_type stream_handler;
+	time_t idle_timeout;
+	time_t header_timeout;
+	size_t max_connections;
+	size_t max_header_bytes;
+	size_t max_headers;
+	size_t max_body_bytes;
+	size_t cache_bytes;		// per loop thread, 0 : no cache
+	std::vector<field_type> cache_fields;
+	int compress_level;		// 0 : only responses asking for it
+	size_t compress_min_bytes;
+	bool http2;
+
+	ServerConfig() :
+		idle_timeout(Server::DEFAULT_IDLE_TIMEOUT_MS),
+		header_timeout(Server::DEFAULT_HEADER_TIMEOUT_MS),
+		max_connections(Server::DEFAULT_MAX_CONNECTIONS),
+		max_header_bytes(Parser::DEFAULT_MAX_HEADER_BYTES),
+		max_headers(Parser::DEFAULT_MAX_HEADERS),
+		max_body_bytes(Server::DEFAULT_MAX_BODY_BYTES),
+		cache_bytes(0),
+		compress_level(0),
+		compress_min_bytes(Server::DEFAULT_COMPRESS_MIN_BYTES),
+		http2(false)
+	{
+	}
+};
+
+class ServerConnection;
+
+/*
+* State of one streamed exchange, shared by ServerStream and its connection.
+*/
+class ServerStream::Impl {
+public:
+	Impl(asio::IOContext& ioc) :
+		ioc(ioc),
+		conn(nullptr),
+		keep_alive(true),
+		head_only(false),
+		paused(false),
+		body_done(false),
+		head_sent(false),
+		chunked(false),
+		bodyless(false),
+		ended(false),
+		want_drain(false),
+		upgraded(false),
+		coding(coding::IDENTITY)
+	{
+	}
+
+	// detached from the connection, the callbacks ( which may hold the stream ) go
+	void release()
+	{
+		conn = nullptr;
+		on_data = nullptr;
+		on_end = nullptr;
+		on_close = nullptr;
+		on_drain = nullptr;
+		compressor.reset();
+	}
+
+	asio::IOContext& ioc;
+	ServerConnection* conn;			// nullptr once the exchange is over
+	Response response;
+
+	data_handler_type on_data;
+	event_handler_type on_end;
+	event_handler_type on_close;
+	event_handler_type on_drain;
+
+	bool keep_alive;		// before the head : as the request asks, then : as sent
+	bool head_only;			// HEAD request
+	bool paused;
+	bool body_done;
+	bool head_sent;
+	bool chunked;
+	bool bodyless;			// HEAD, 1xx, 204, 304 : whatever is written is dropped
+	bool ended;
+	bool want_drain;		// write() returned false
+	bool upgraded;			// 101 sent : raw bytes both ways until the connection closes
+
+	coding_type coding;		// negotiated from Accept-Encoding
+	std::unique_ptr<Compressor> compressor;		// body of unknown length being compressed
+	std::string compressed;
+};
+
+/*
+* Everything one loop thread needs : its connections, the Date header, the response
+* cache and one timer expiring the idle and slow connections. Created and destroyed
+* on that thread, so the cache takes no lock.
+*/
+class ServerWorker {
+public:
+	typedef std::shared_ptr<ServerConnection> connection_ptr;
+	typedef std::list<connection_ptr> connection_list_type;
+	typedef connection_list_type::iterator iterator_type;
+
+	ServerWorker(asio::IOContext& ioc, const ServerConfig& config, std::atomic<size_t>& count);
+	~ServerWorker();
+
+	asio::IOContext& context();
+	const ServerConfig& config() const;
+	StringView date() const;
+	ResponseCache* cache();		// nullptr when off
+
+	iterator_type add(connection_ptr conn);
+	void remove(iterator_type iter);
+
+private:
+	ServerWorker(const ServerWorker&);
+	ServerWorker& operator=(const ServerWorker&);
+
+	void sweep();
+
+private:
+	asio::IOContext& ioc_;
+	const ServerConfig& config_;
+	std::atomic<size_t>& count_;
+	DateClock clock_;
+	asio::SteadyTimer sweep_timer_;
+	connection_list_type connections_;
+	std::unique_ptr<ResponseCache> cache_;
+};
+
+///////////////////////////////////////////////////////////////
+
+/*
+* notify :
+*	Responses are appended to out_[filling_] while out_[filling_ ^ 1] is being
+*	written, the buffer of a write in flight is never touched, so serializing the
+*	next batch can not move it.
+*/
+class ServerConnection :
+	public std::enable_shared_from_this<ServerConnection>
+{
+public:
+	ServerConnection(ServerWorker& worker);
+	~ServerConnection();
+
+	asio::ip::TCP::Socket& socket();
+
+	void start(ServerWorker::iterator_type self);
+	void close();
+	bool expired(time_t now) const;
+
+	// ServerStream
+	bool streamWrite(ServerStream::Impl& stream, StringView data);
+	void streamEnd(ServerStream::Impl& stream);
+	bool streamUpgrade(ServerStream::Impl& stream);
+	void streamResume();
+
+private:
+	ServerConnection(const ServerConnection&);
+	ServerConnection& operator=(const ServerConnection&);
+
+	void startRead();
+	void onRead(asio::errcode_type ec, size_t nread);
+	void onWrite(asio::errcode_type ec, size_t nwrite);
+	void onFileSent(asio::errcode_type ec, size_t nwrite);
+
+	void pump();
+	void drain();
+	bool detectHttp2();
+	void drainHttp2();
+	void handle();
+	void handleHttp2(const RequestView& request, Response& response);
+	bool answer(ResponseCache& cache, bool head_only, bool keep_alive);
+	void revalidate();
+	void reject(state_type state);
+	void expectContinue();
+	int compression(const Response& response) const;
+	void serialize(Response& response, bool head_only);
+	void flush();
+	void sendFile();
+	void touch();
+
+	bool offer();
+	bool feed();
+	void finishStream();
+	void sendHead(ServerStream::Impl& stream, bool ending);
+	void notifyDrain();
+
+	size_t pending() const;
+
+private:
+	ServerWorker& worker_;
+	asio::ip::TCP::Socket socket_;
+	asio::DynamicBuffer in_;
+	asio::DynamicBuffer out_[2];
+	size_t filling_;
+
+	Parser parser_;
+	RequestView view_;
+	Response response_;
+
+	Server::stream_ptr stream_;		// request taken by the stream handler, until it is over
+	std::unique_ptr<http2::ServerSession> h2_;		// the connection speaks HTTP/2
+
+	std::string cache_key_;
+	std::vector<std::string> revalidations_;		// requests of stale hits, run after the flush
+
+	open_file_ptr file_;			// body of the last response, goes out after out_
+	off_t file_offset_;
+	size_t file_left_;
+
+	ServerWorker::iterator_type self_;
+	time_t deadline_;		// 0 : none
+	time_t head_deadline_;	// header timeout of the request being received, 0 : none
+
+	bool reading_;
+	bool writing_;
+	bool pumping_;			// inside pump(), stream calls leave the rest to it
+	bool continued_;		// "100 Continue" sent for the current request
+	bool file_sent_;		// a file body went out within pump(), the requests behind it may go on
+	bool detected_;			// the first bytes told HTTP/1 from HTTP/2
+	bool h2_more_;			// the session had more DATA than the output could take
+	bool closing_;			// no more requests, close once the output is sent
+	bool closed_;
+};
+
+ServerConnection::ServerConnection(ServerWorker& worker) :
+	worker_(worker),
+	socket_(worker.context()),
+	in_(Server::READ_BUFFER_BYTES),
+	filling_(0),
+	file_offset_(0),
+	file_left_(0),
+	deadline_(0),
+	head_deadline_(0),
+	reading_(false),
+	writing_(false),
+	pumping_(false),
+	continued_(false),
+	file_sent_(false),
+	detected_(false),
+	h2_more_(false),
+	closing_(false),
+	closed_(false)
+{
+	parser_.setMaxHeaderBytes(worker.config().max_header_bytes);
+	parser_.setMaxHeaders(worker.config().max_headers);
+	parser_.setMaxBodyBytes(worker.config().max_body_bytes);
+}
+
+ServerConnection::~ServerConnection()
+{
+}
+
+asio::ip::TCP::Socket& ServerConnection::socket()
+{
+	return socket_;
+}
+
+void ServerConnection::start(ServerWorker::iterator_type self)
+{
+	self_ = self;
+	socket_.setDelay();
+
+	touch();
+	startRead();
+}
+
+void ServerConnection::close()
+{
+	if ( closed_ ) {
+		return;
+	}
+	closed_ = true;
+
+	// cancels the pending operations, their handlers still hold a reference
+	auto self = shared_from_this();
+	socket_.shutdown();
+	worker_.remove(self_);
+
+	if ( stream_ ) {
+		Server::stream_ptr stream = std::move(stream_);
+		ServerStream::Impl& s = *stream->pImpl_;
+
+		ServerStream::event_handler_type on_close;
+		if ( !s.ended || (!s.body_done && !s.upgraded) ) {
+			on_close = std::move(s.on_close);
+		}
+		s.release();
+		if ( on_close ) {
+			on_close();
+		}
+	}
+}
+
+bool ServerConnection::expired(time_t now) const
+{
+	return deadline_ != 0 && deadline_ <= now;
+}
+
+void ServerConnection::startRead()
+{
+	if ( reading_ || closing_ || closed_ || pending() >= Server::OUTPUT_HIGH_WATER ) {
+		return;
+	}
+	// a paused body stays in the kernel, and nothing is read ahead of an unfinished response
+	if ( file_ || (stream_ && (stream_->pImpl_->paused || stream_->pImpl_->body_done)) ) {
+		return;
+	}
+
+	in_.reserve(Server::READ_BUFFER_BYTES);
+	reading_ = true;
+
+	auto self = shared_from_this();
+	socket_.async_read(asio::buffer(in_.writeBegin(), in_.availableBytes()),
+			[this, self](asio::errcode_type ec, size_t nread){
+		onRead(ec, nread);
+	});
+}
+
+void ServerConnection::onRead(asio::errcode_type ec, size_t nread)
+{
+	reading_ = false;
+	if ( closed_ ) {
+		return;
+	}
+
+	if ( ec || nread == 0 ) {		// error or peer closed
+		close();
+		return;
+	}
+
+	in_.write(nread);
+	pump();
+}
+
+void ServerConnection::onWrite(asio::errcode_type ec, size_t)
+{
+	writing_ = false;
+	if ( closed_ ) {
+		return;
+	}
+
+	if ( ec ) {
+		close();
+		return;
+	}
+
+	asio::DynamicBuffer& sent = out_[filling_ ^ 1];
+	sent.read(sent.dataBytes());
+
+	// requests left behind by the high water mark
+	pump();
+}
+
+void ServerConnection::onFileSent(asio::errcode_type ec, size_t nwrite)
+{
+	writing_ = false;
+	if ( closed_ ) {
+		return;
+	}
+
+	if ( ec ) {
+		close();
+		return;
+	}
+
+	file_offset_ += nwrite;
+	file_left_ -= nwrite;
+	if ( file_left_ == 0 ) {
+		file_.reset();
+	}
+	pump();
+}
+
+/*
+* Runs after anything that may let the connection go on : input, sent output, or a
+* call of the stream.
+*/
+void ServerConnection::pump()
+{
+	if ( pumping_ || closed_ ) {
+		return;
+	}
+
+	pumping_ = true;
+	do {
+		file_sent_ = false;
+		h2_more_ = false;
+		drain();
+		flush();
+	} while ( (file_sent_ || (h2_more_ && pending() < Server::OUTPUT_HIGH_WATER)) && !closed_ );
+	if ( !revalidations_.empty() ) {
+		revalidate();
+	}
+	pumping_ = false;
+
+	if ( closed_ ) {
+		return;
+	}
+	touch();
+	startRead();
+	notifyDrain();
+}
+
+/*
+* Handles every complete request in `in_`, the responses pile up in out_[filling_].
+* A streamed request is fed from here until it is over, the requests behind it wait,
+* as they wait for a file body to be sent.
+*/
+void ServerConnection::drain()
+{
+	const ServerConfig& config = worker_.config();
+
+	if ( !detected_ && !detectHttp2() ) {
+		return;
+	}
+	if ( h2_ ) {
+		drainHttp2();
+		return;
+	}
+
+	while ( !file_ && !closing_ && !closed_ && pending() < Server::OUTPUT_HIGH_WATER ) {
+		if ( stream_ ) {
+			if ( !feed() ) {
+				break;
+			}
+			finishStream();
+			continue;
+		}
+
+		if ( in_.dataBytes() == 0 ) {
+			break;
+		}
+
+		Parser::RetCode retcode = Parser::RetCode::ERROR;
+		if ( config.stream_handler && !parser_.headerComplete() ) {
+			retcode = parser_.parseHead(in_.readBegin(), in_.dataBytes(), view_);
+			if ( retcode == Parser::RetCode::READY ) {
+				if ( offer() ) {
+					continue;
+				}
+				retcode = parser_.parse(in_.readBegin(), in_.dataBytes(), view_);
+			}
+		} else {
+			retcode = parser_.parse(in_.readBegin(), in_.dataBytes(), view_);
+		}
+
+		if ( retcode == Parser::RetCode::WAITING_DATA ) {
+			if ( parser_.headerComplete() ) {
+				expectContinue();
+			}
+			break;
+		}
+
+		if ( retcode == Parser::RetCode::ERROR ) {
+			Parser::ErrCode errcode = parser_.errcode();
+			if ( errcode == Parser::ErrCode::HEADER_TOO_LARGE ||
+				 errcode == Parser::ErrCode::TOO_MANY_HEADERS ) {
+				reject(state::REQUEST_HEADER_FIELDS_TOO_LARGE);
+			} else if ( errcode == Parser::ErrCode::BODY_TOO_LARGE ) {
+				reject(state::PAYLOAD_TOO_LARGE);
+			} else {
+				reject(state::BAD_REQUEST);
+			}
+			return;
+		}
+
+		handle();
+
+		in_.read(parser_.nparse());
+		parser_.reset();
+		view_.clear();
+		continued_ = false;
+	}
+}
+
+// false while the first bytes may still be the HTTP/2 preface
+bool ServerConnection::detectHttp2()
+{
+	if ( !worker_.config().http2 ) {
+		detected_ = true;
+		return true;
+	}
+
+	size_t n = std::min<size_t>(in_.dataBytes(), http2::CLIENT_PREFACE_BYTES);
+	if ( ::memcmp(in_.readBegin(), http2::CLIENT_PREFACE, n) != 0 ) {
+		detected_ = true;
+		return true;
+	}
+	if ( n < http2::CLIENT_PREFACE_BYTES ) {
+		return false;
+	}
+
+	const ServerConfig& config = worker_.config();
+	detected_ = true;
+	h2_.reset(new http2::ServerSession([this](const RequestView& request, Response& response){
+		handleHttp2(request, response);
+	}));
+	h2_->setMaxBodyBytes(config.max_body_bytes);
+	h2_->setMaxHeaderListBytes(config.max_header_bytes);
+	h2_->start(out_[filling_]);
+	return true;
+}
+
+/*
+* Frames in `in_` go to the session, a partial one stays there. Response bodies are
+* framed up to the high water mark, the rest once that much is written : by onWrite(),
+* or by pump() when the socket took it all at once.
+*/
+void ServerConnection::drainHttp2()
+{
+	if ( closing_ || closed_ ) {
+		return;
+	}
+
+	if ( in_.dataBytes() > 0 ) {
+		in_.read(h2_->receive(in_.readBegin(), in_.dataBytes(), out_[filling_]));
+	}
+	size_t queued = pending();
+	if ( queued < Server::OUTPUT_HIGH_WATER ) {
+		size_t budget = Server::OUTPUT_HIGH_WATER - queued;
+		h2_more_ = h2_->send(out_[filling_], budget) >= budget;
+	}
+
+	if ( h2_->over() ) {
+		closing_ = true;
+	}
+}
+
+void ServerConnection::handleHttp2(const RequestView& request, Response& response)
+{
+	const ServerConfig& config = worker_.config();
+
+	if ( config.handler ) {
+		config.handler(request, response);
+	} else {
+		response.setState(state::NOT_FOUND);
+	}
+
+	int level = compression(response);
+	if ( level > 0 ) {
+		CompressResponse(response, NegotiateCoding(request.getHeader(field::ACCEPT_ENCODING)),
+						 level, config.compress_min_bytes);
+	}
+	if ( !response.hasHeader(field::DATE) ) {
+		response.setHeader(field::DATE, worker_.date().toString());
+	}
+}
+
+void ServerConnection::handle()
+{
+	const ServerConfig& config = worker_.config();
+	ResponseCache* cache = worker_.cache();
+	bool head_only = view_.method() == method::HEAD;
+	bool keep_alive = details::KeepAlive(view_);
+
+	bool cacheable = cache && view_.version() == version::HTTP_1_1 && cache->makeKey(view_, cache_key_);
+	if ( cacheable && answer(*cache, head_only, keep_alive) ) {
+		return;
+	}
+
+	response_.clear();
+	response_.setVersion(view_.version() == version::HTTP_1_0 ? version::HTTP_1_0 : version::HTTP_1_1);
+	response_.setState(state::OK);
+
+	if ( config.handler ) {
+		config.handler(view_, response_);
+	} else {
+		response_.setState(state::NOT_FOUND);
+	}
+
+	int level = compression(response_);
+	if ( level > 0 ) {
+		CompressResponse(response_, NegotiateCoding(view_.getHeader(field::ACCEPT_ENCODING)),
+						 level, config.compress_min_bytes);
+	}
+
+	// before FinishHead : a Connection field of the handler keeps the response out
+	if ( cacheable && !head_only ) {
+		cache->store(cache_key_, response_, asio::details::now_ms());
+	}
+
+	keep_alive = FinishHead(response_, keep_alive);
+	serialize(response_, head_only);
+
+	if ( !keep_alive ) {
+		closing_ = true;
+	}
+}
+
+/*
+* The response to the current request from the cache, false on a miss. A stale
+* entry is sent as it is and the request kept to refresh it once it is out.
+*/
+bool ServerConnection::answer(ResponseCache& cache, bool head_only, bool keep_alive)
+{
+	time_t now = asio::details::now_ms();
+	const ResponseCache::Entry* entry = nullptr;
+	ResponseCache::Lookup lookup = cache.find(cache_key_, now, entry);
+	if ( lookup == ResponseCache::Lookup::MISS ) {
+		return false;
+	}
+
+	ResponseCache::Write(*entry, worker_.date(), now, head_only, !keep_alive, out_[filling_]);
+	if ( lookup == ResponseCache::Lookup::REVALIDATE ) {
+		revalidations_.push_back(std::string(in_.readBegin(), parser_.nparse()));
+	}
+
+	if ( !keep_alive ) {
+		closing_ = true;
+	}
+	return true;
+}
+
+/*
+* Runs the handler again for the stale hits of this pump, as a GET, and stores what
+* it answers. The entry is dropped when the new response may not be stored.
+*
+* notify :
+*	The requests are parsed again from their own copies, parser_ and view_ may hold
+*	the next request of the connection.
+*/
+void ServerConnection::revalidate()
+{
+	const ServerConfig& config = worker_.config();
+	ResponseCache* cache = worker_.cache();
+
+	std::vector<std::string> requests;
+	requests.swap(revalidations_);
+
+	Parser parser;
+	RequestView view;
+	Response response;
+	std::string key;
+	for ( const std::string& raw : requests ) {
+		parser.reset();
+		view.clear();
+		if ( parser.parse(raw.data(), raw.size(), view) != Parser::RetCode::READY ) {
+			continue;
+		}
+		view.setMethod(method::GET);
+		if ( !cache->makeKey(view, key) ) {
+			continue;
+		}
+
+		response.clear();
+		response.setVersion(version::HTTP_1_1);
+		response.setState(state::OK);
+		if ( config.handler ) {
+			config.handler(view, response);
+		} else {
+			response.setState(state::NOT_FOUND);
+		}
+
+		int level = compression(response);
+		if ( level > 0 ) {
+			CompressResponse(response, NegotiateCoding(view.getHeader(field::ACCEPT_ENCODING)),
+							 level, config.compress_min_bytes);
+		}
+
+		if ( !cache->store(key, response, asio::details::now_ms()) ) {
+			cache->erase(key);
+		}
+	}
+}
+
+void ServerConnection::reject(state_type state)
+{
+	response_.clear();
+	response_.setVersion(version::HTTP_1_1);
+	response_.setState(state);
+	response_.setHeader(field::CONNECTION, "close");
+	SerializeResponse(response_, out_[filling_], worker_.date());
+
+	closing_ = true;
+}
+
+// "Expect: 100-continue" : the client holds the body back until it is asked for
+void ServerConnection::expectContinue()
+{
+	static const StringView kContinue("HTTP/1.1 100 Continue\r\n\r\n", 25);
+
+	if ( continued_ || view_.version() == version::HTTP_1_0 ||
+		 !view_.getHeader(field::EXPECT).iequals("100-continue") ) {
+		return;
+	}
+
+	continued_ = true;
+	details::Append(out_[filling_], kContinue);
+}
+
+// the level of the response, or of the server when the response leaves it
+int ServerConnection::compression(const Response& response) const
+{
+	if ( response.compression() == Response::COMPRESSION_DEFAULT ) {
+		return worker_.config().compress_level;
+	}
+	return response.compression();
+}
+
+/*
+* notify :
+*	A file body is not copied : its head goes to out_[filling_] and the file waits
+*	in file_ until everything before it is written. Nothing is queued behind it.
+*/
+void ServerConnection::serialize(Response& response, bool head_only)
+{
+	if ( !response.file() ) {
+		if ( head_only ) {
+			SerializeResponseHead(response, out_[filling_], worker_.date());
+		} else {
+			SerializeResponse(response, out_[filling_], worker_.date());
+		}
+		return;
+	}
+
+	size_t length = response.fileLength();
+	response.setHeader(field::CONTENT_LENGTH, std::to_string(length));
+	SerializeResponseHead(response, out_[filling_], worker_.date());
+	if ( head_only || length == 0 ) {
+		return;
+	}
+
+	asio::DynamicBuffer& out = out_[filling_];
+	if ( length <= Server::FILE_COPY_BYTES ) {
+		out.reserve(length);
+		if ( response.file()->read(response.fileOffset(), length, out.writeBegin()) ) {
+			out.write(length);
+			return;
+		}
+		closing_ = true;		// the head promised more than the file has
+		return;
+	}
+
+	file_ = response.file();
+	file_offset_ = (off_t)response.fileOffset();
+	file_left_ = length;
+}
+
+/*
+* The head of a request is in and the stream handler may take it. When it does
+* the head leaves the buffer and the body goes to the stream.
+*/
+bool ServerConnection::offer()
+{
+	Server::stream_ptr stream = std::make_shared<ServerStream>(worker_.context());
+	ServerStream::Impl& s = *stream->pImpl_;
+	s.conn = this;
+	s.keep_alive = details::KeepAlive(view_);
+	s.head_only = view_.method() == method::HEAD;
+	s.coding = NegotiateCoding(view_.getHeader(field::ACCEPT_ENCODING));
+	s.response.setVersion(view_.version() == version::HTTP_1_0 ? version::HTTP_1_0 : version::HTTP_1_1);
+	s.response.setState(state::OK);
+
+	stream_ = stream;
+	if ( !worker_.config().stream_handler(view_, stream) ) {
+		s.release();
+		stream_.reset();
+		return false;
+	}
+
+	if ( !s.head_sent ) {
+		expectContinue();
+	}
+	in_.read(parser_.nparse());
+	return true;
+}
+
+/*
+* Hands the body of stream_ over while it is not paused, returns true once the
+* exchange is over : body read and response ended.
+*/
+bool ServerConnection::feed()
+{
+	Server::stream_ptr stream = stream_;		// the callbacks may close the connection
+	ServerStream::Impl& s = *stream->pImpl_;
+
+	if ( s.upgraded ) {
+		while ( !s.paused && !closed_ && in_.dataBytes() > 0 ) {
+			StringView piece(in_.readBegin(), in_.dataBytes());
+			if ( s.on_data ) {
+				s.on_data(piece);
+			}
+			in_.read(piece.size());
+		}
+		return false;		// over with the connection
+	}
+
+	while ( !s.body_done ) {
+		if ( s.paused || closed_ ) {
+			return false;
+		}
+
+		StringView piece;
+		size_t nparse = 0;
+		Parser::RetCode retcode = parser_.parseBody(in_.readBegin(), in_.dataBytes(), piece, nparse);
+		if ( retcode == Parser::RetCode::ERROR ) {
+			close();		// a response may be under way, too late for a 400
+			return false;
+		}
+
+		if ( !piece.empty() && s.on_data ) {
+			s.on_data(piece);
+		}
+		in_.read(nparse);
+
+		if ( retcode == Parser::RetCode::READY ) {
+			s.body_done = true;
+			if ( s.on_end ) {
+				s.on_end();
+			}
+		} else if ( piece.empty() ) {
+			return false;
+		}
+	}
+
+	return s.ended && !closed_;
+}
+
+void ServerConnection::finishStream()
+{
+	stream_->pImpl_->release();
+	stream_.reset();
+
+	parser_.reset();
+	view_.clear();
+	continued_ = false;
+}
+
+/*
+* notify :
+*	A response ended before anything was written is sent whole, with its Content-Length.
+*	Otherwise a body of unknown length is chunked ( HTTP/1.1 ) or delimited by the
+*	end of the connection ( HTTP/1.0 ).
+*/
+void ServerConnection::sendHead(ServerStream::Impl& s, bool ending)
+{
+	Response& response = s.response;
+	int code = (int)response.state();
+	s.head_sent = true;
+	s.bodyless = s.head_only || code < 200 || code == 204 || code == 304;
+
+	int level = compression(response);
+	if ( ending || s.bodyless ) {
+		if ( ending && !s.bodyless && level > 0 ) {
+			CompressResponse(response, s.coding, level, worker_.config().compress_min_bytes);
+		}
+		s.keep_alive = FinishHead(response, s.keep_alive);
+		serialize(response, s.head_only);
+		return;
+	}
+
+	// a body of unknown length : compressed as it is written, whatever its length
+	if ( level > 0 && s.coding != coding::IDENTITY && code != 206 &&
+		 !response.hasHeader(field::CONTENT_LENGTH) && !response.hasHeader(field::TRANSFER_ENCODING) &&
+		 !response.hasHeader(field::CONTENT_ENCODING) &&
+		 Compressible(StringView(response.getHeader(field::CONTENT_TYPE))) ) {
+		s.compressor.reset(new Compressor(s.coding, level));
+		if ( s.compressor->ok() ) {
+			response.setHeader(field::CONTENT_ENCODING, CodingToString(s.coding));
+			VaryOnAcceptEncoding(response);
+		} else {
+			s.compressor.reset();
+		}
+	}
+
+	if ( response.hasHeader(field::TRANSFER_ENCODING) ) {
+		s.chunked = details::HasToken(StringView(response.getHeader(field::TRANSFER_ENCODING)), StringView("chunked", 7));
+	} else if ( !response.hasHeader(field::CONTENT_LENGTH) ) {
+		if ( response.version() == version::HTTP_1_1 ) {
+			response.setHeader(field::TRANSFER_ENCODING, "chunked");
+			s.chunked = true;
+		} else {
+			s.keep_alive = false;
+		}
+	}
+
+	s.keep_alive = FinishHead(response, s.keep_alive);
+	SerializeStreamHead(response, out_[filling_], worker_.date());
+}
+
+bool ServerConnection::streamWrite(ServerStream::Impl& s, StringView data)
+{
+	if ( !s.head_sent ) {
+		sendHead(s, false);
+	}
+
+	if ( s.upgraded ) {
+		details::Append(out_[filling_], data);
+	} else if ( !s.bodyless ) {
+		if ( s.compressor ) {
+			s.compressed.clear();
+			s.compressor->write(data, s.compressed, true);
+			data = StringView(s.compressed);
+		}
+		if ( s.chunked ) {
+			SerializeChunk(data, out_[filling_]);
+		} else {
+			details::Append(out_[filling_], data);
+		}
+	}
+
+	if ( !pumping_ ) {
+		flush();
+		if ( closed_ ) {
+			return false;
+		}
+		touch();
+	}
+
+	if ( pending() >= Server::OUTPUT_HIGH_WATER ) {
+		s.want_drain = true;
+		return false;
+	}
+	return true;
+}
+
+void ServerConnection::streamEnd(ServerStream::Impl& s)
+{
+	if ( !s.head_sent ) {
+		sendHead(s, true);
+	} else if ( !s.bodyless && !s.upgraded ) {
+		if ( s.compressor ) {
+			s.compressed.clear();
+			s.compressor->finish(s.compressed);
+			if ( s.chunked ) {
+				SerializeChunk(StringView(s.compressed), out_[filling_]);
+			} else {
+				details::Append(out_[filling_], StringView(s.compressed));
+			}
+		}
+		if ( s.chunked ) {
+			SerializeLastChunk(out_[filling_]);
+		}
+	}
+
+	s.ended = true;
+	if ( !s.keep_alive ) {
+		closing_ = true;
+	}
+	pump();
+}
+
+bool ServerConnection::streamUpgrade(ServerStream::Impl& s)
+{
+	if ( s.head_sent || s.response.version() != version::HTTP_1_1 ) {
+		return false;
+	}
+
+	s.response.setState(state::SWITCHING_PROTOCOLS);
+	s.head_sent = true;
+	s.upgraded = true;
+	s.keep_alive = false;
+	s.body_done = false;		// a late upgrade reads again
+	SerializeStreamHead(s.response, out_[filling_], worker_.date());
+	pump();
+	return !closed_;
+}
+
+void ServerConnection::streamResume()
+{
+	pump();
+}
+
+void ServerConnection::notifyDrain()
+{
+	if ( !stream_ || !stream_->pImpl_->want_drain || pending() >= Server::OUTPUT_HIGH_WATER ) {
+		return;
+	}
+
+	Server::stream_ptr stream = stream_;
+	stream->pImpl_->want_drain = false;
+	if ( stream->pImpl_->on_drain ) {
+		stream->pImpl_->on_drain();
+	}
+}
+
+void ServerConnection::flush()
+{
+	if ( writing_ || closed_ ) {
+		return;
+	}
+
+	asio::DynamicBuffer& out = out_[filling_];
+	if ( out.dataBytes() > 0 ) {
+		// a batch usually fits the socket buffer, the reactor only waits for the rest
+		asio::errcode_type ec = asio::err::SUCCESS;
+		out.read(socket_.write_some(asio::buffer(out.readBegin(), out.dataBytes()), ec));
+		if ( ec ) {
+			close();
+			return;
+		}
+	}
+
+	if ( out.dataBytes() == 0 ) {
+		if ( file_ ) {
+			sendFile();
+		} else if ( closing_ ) {
+			socket_.shutdownWrite();
+			close();
+		}
+		return;
+	}
+
+	writing_ = true;
+	filling_ ^= 1;
+
+	auto self = shared_from_this();
+	socket_.async_write(asio::buffer(out.readBegin(), out.dataBytes()),
+			[this, self](asio::errcode_type ec, size_t nwrite){
+		onWrite(ec, nwrite);
+	});
+}
+
+/*
+* Like flush() : what the socket takes now, then the reactor. The reactor gets at
+* most FILE_CHUNK_BYTES at a time, each chunk sent counts as progress for the idle timeout.
+*/
+void ServerConnection::sendFile()
+{
+	asio::errcode_type ec = asio::err::SUCCESS;
+	file_left_ -= socket_.sendfile_some(file_->fd(), file_offset_, file_left_, ec);
+	if ( ec ) {
+		close();
+		return;
+	}
+
+	if ( file_left_ == 0 ) {
+		file_.reset();
+		file_sent_ = true;
+		if ( closing_ ) {
+			socket_.shutdownWrite();
+			close();
+		}
+		return;
+	}
+
+	writing_ = true;
+
+	auto self = shared_from_this();
+	socket_.async_sendfile(file_->fd(), file_offset_, std::min<size_t>(file_left_, Server::FILE_CHUNK_BYTES),
+			[this, self](asio::errcode_type ec, size_t nwrite){
+		onFileSent(ec, nwrite);
+	});
+}
+
+/*
+* A request head in progress is bounded by the header timeout from its first
+* byte, anything else ( between requests, body, output ) by the idle timeout
+* from the last progress.
+*/
+void ServerConnection::touch()
+{
+	const ServerConfig& config = worker_.config();
+	time_t now = asio::details::now_ms();
+
+	if ( !h2_ && in_.dataBytes() > 0 && !parser_.headerComplete() && config.header_timeout > 0 ) {
+		if ( head_deadline_ == 0 ) {
+			head_deadline_ = now + config.header_timeout;
+		}
+		deadline_ = head_deadline_;
+		return;
+	}
+
+	head_deadline_ = 0;
+	deadline_ = config.idle_timeout > 0 ? now + config.idle_timeout : 0;
+}
+
+size_t ServerConnection::pending() const
+{
+	return out_[0].dataBytes() + out_[1].dataBytes();
+}
+
+///////////////////////////////////////////////////////////////
+
+ServerWorker::ServerWorker(asio::IOContext& ioc, const ServerConfig& config, std::atomic<size_t>& count) :
+	ioc_(ioc),
+	config_(config),
+	count_(count),
+	clock_(ioc),
+	sweep_timer_(ioc, details::SweepInterval({ config.idle_timeout, config.header_timeout }))
+{
+	if ( config.cache_bytes > 0 ) {
+		std::vector<field_type> fields = config.cache_fields;
+		if ( config.compress_level > 0 &&
+			 std::find(fields.begin(), fields.end(), field::ACCEPT_ENCODING) == fields.end() ) {
+			fields.push_back(field::ACCEPT_ENCODING);
+		}
+		cache_.reset(new ResponseCache(config.cache_bytes, std::move(fields)));
+	}
+	sweep();
+}
+
+ServerWorker::~ServerWorker()
+{
+	sweep_timer_.cancel();
+
+	while ( !connections_.empty() ) {
+		connection_ptr conn = connections_.front();
+		conn->close();
+	}
+}
+
+asio::IOContext& ServerWorker::context()
+{
+	return ioc_;
+}
+
+const ServerConfig& ServerWorker::config() const
+{
+	return config_;
+}
+
+StringView ServerWorker::date() const
+{
+	return clock_.date();
+}
+
+ResponseCache* ServerWorker::cache()
+{
+	return cache_.get();
+}
+
+ServerWorker::iterator_type ServerWorker::add(connection_ptr conn)
+{
+	return connections_.insert(connections_.end(), std::move(conn));
+}
+
+void ServerWorker::remove(iterator_type iter)
+{
+	connections_.erase(iter);
+	count_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ServerWorker::sweep()
+{
+	sweep_timer_.async_wait([this](asio::errcode_type ec, asio::SteadyTimer::timeout_type){
+		if ( ec ) {
+			return;		// canceled by the destructor
+		}
+
+		time_t now = asio::details::now_ms();
+		for ( auto iter = connections_.begin(); iter != connections_.end(); ) {
+			connection_ptr conn = *iter++;		// close() erases the current node
+			if ( conn->expired(now) ) {
+				conn->close();
+			}
+		}
+
+		sweep();
+	});
+}
+
+///////////////////////////////////////////////////////////////
+
+class Server::Impl {
+public:
+	Impl(asio::IOContext& ioc, size_t thread_num);
+	~Impl();
+
+	void setHandler(handler_type handler);
+	void setStreamHandler(stream_handler_type handler);
+	void setIdleTimeout(time_t ms);
+	void setHeaderTimeout(time_t ms);
+	void setMaxConnections(size_t count);
+	void setMaxHeaderBytes(size_t bytes);
+	void setMaxHeaders(size_t count);
+	void setMaxBodyBytes(size_t bytes);
+	void setCompression(int level, size_t min_bytes);
+	void setCache(size_t max_bytes, std::vector<field_type> key_fields);
+	void setHttp2(bool on);
+
+	asio::errcode_type start(const asio::ip::Endpoint& endpoint);
+	void stop();
+
+	asio::errcode_type localAddr(asio::ip::Endpoint& endpoint);
+	size_t connections() const;
+
+private:
+	void startAccept();
+
+	void createWorker(asio::IOContext& ioc);
+	void destroyWorker(ServerWorker* worker);
+
+private:
+	typedef std::vector<ServerWorker*> worker_array_type;
+
+	asio::IOContext& ioc_;
+	asio::ip::TCP::Acceptor acceptor_;
+	size_t thread_num_;
+	asio::ThreadPool io_thread_pool_;
+
+	ServerConfig config_;
+	bool is_start_;
+	size_t next_;
+	worker_array_type workers_;
+	std::atomic<size_t> count_;
+
+	std::shared_ptr<ServerConnection> accepting_;	// target of the pending accept
+	ServerWorker* accepting_worker_;
+};
+
+Server::Impl::Impl(asio::IOContext& ioc, size_t thread_num) :
+	ioc_(ioc),
+	acceptor_(ioc),
+	thread_num_(thread_num),
+	io_thread_pool_(thread_num),
+	is_start_(false),
+	next_(0),
+	count_(0),
+	accepting_worker_(nullptr)
+{
+}
+
+Server::Impl::~Impl()
+{
+	stop();
+}
+
+void Server::Impl::setHandler(handler_type handler)
+{
+	config_.handler = std::move(handler);
+}
+
+void Server::Impl::setStreamHandler(stream_handler_type handler)
+{
+	config_.stream_handler = std::move(handler);
+}
+
+void Server::Impl::setIdleTimeout(time_t ms)
+{
+	config_.idle_timeout = ms;
+}
+
+void Server::Impl::setHeaderTimeout(time_t ms)
+{
+	config_.header_timeout = ms;
+}
+
+void Server::Impl::setMaxConnections(size_t count)
+{
+	config_.max_connections = count;
+}
+
+void Server::Impl::setMaxHeaderBytes(size_t bytes)
+{
+	config_.max_header_bytes = bytes;
+}
+
+void Server::Impl::setMaxHeaders(size_t count)
+{
+	config_.max_headers = count;
+}
+
+void Server::Impl::setMaxBodyBytes(size_t bytes)
+{
+	config_.max_body_bytes = bytes;
+}
+
+void Server::Impl::setCompression(int level, size_t min_bytes)
+{
+	config_.compress_level = level;
+	config_.compress_min_bytes = min_bytes;
+}
+
+void Server::Impl::setCache(size_t max_bytes, std::vector<field_type> key_fields)
+{
+	config_.cache_bytes = max_bytes;
+	config_.cache_fields = std::move(key_fields);
+}
+
+void Server::Impl::setHttp2(bool on)
+{
+	config_.http2 = on;
+}
+
+asio::errcode_type Server::Impl::start(const asio::ip::Endpoint& endpoint)
+{
+	if ( is_start_ ) {
+		return asio::err::SUCCESS;
+	}
+
+	asio::errcode_type ec = acceptor_.setup(endpoint);
+	if ( ec ) {
+		return ec;
+	}
+
+	if ( thread_num_ == 0 ) {
+		createWorker(ioc_);
+	} else {
+		io_thread_pool_.start();
+		for ( size_t i = 0; i < thread_num_; ++i ) {
+			createWorker(io_thread_pool_.nextContext());
+		}
+	}
+
+	is_start_ = true;
+	startAccept();
+	return asio::err::SUCCESS;
+}
+
+void Server::Impl::stop()
+{
+	if ( !is_start_ ) {
+		return;
+	}
+	is_start_ = false;
+
+	acceptor_.cancel();
+
+	for ( ServerWorker* worker : workers_ ) {
+		destroyWorker(worker);
+	}
+	workers_.clear();
+
+	io_thread_pool_.stop();
+}
+
+asio::errcode_type Server::Impl::localAddr(asio::ip::Endpoint& endpoint)
+{
+	return acceptor_.localAddr(endpoint);
+}
+
+size_t Server::Impl::connections() const
+{
+	return count_.load(std::memory_order_relaxed);
+}
+
+void Server::Impl::startAccept()
+{
+	// after a failed accept the same connection is reused, it must not die on this thread
+	if ( !accepting_ ) {
+		accepting_worker_ = workers_[next_++ % workers_.size()];
+		accepting_ = std::make_shared<ServerConnection>(*accepting_worker_);
+	}
+
+	acceptor_.async_accept(accepting_->socket(), [this](asio::errcode_type ec){
+		if ( ec == asio::err::EOPCANCELED ) {
+			return;		// stop() releases accepting_ on its loop thread
+		}
+
+		if ( !ec ) {
+			size_t count = count_.fetch_add(1, std::memory_order_relaxed) + 1;
+			bool over = config_.max_connections != 0 && count > config_.max_connections;
+
+			std::shared_ptr<ServerConnection> conn = std::move(accepting_);
+			ServerWorker* worker = accepting_worker_;
+			asio::post(worker->context(), [conn, worker, over](){
+				ServerWorker::iterator_type self = worker->add(conn);
+				conn->start(self);
+				if ( over ) {
+					conn->close();
+				}
+			});
+		}
+
+		// a failed accept ( e.g. the peer already reset ) does not stop the server
+		startAccept();
+	});
+}
+
+/*
+* notify :
+*	A worker lives on its loop thread : DateClock and the sweep timer register with
+*	the TimerService of that IOContext, which is not thread safe.
+*/
+void Server::Impl::createWorker(asio::IOContext& ioc)
+{
+	std::promise<ServerWorker*> created;
+	std::future<ServerWorker*> future = created.get_future();
+
+	asio::post(ioc, [this, &ioc, &created](){
+		created.set_value(new ServerWorker(ioc, config_, count_));
+	});
+
+	workers_.push_back(future.get());
+}
+
+void Server::Impl::destroyWorker(ServerWorker* worker)
+{
+	std::promise<void> destroyed;
+	std::future<void> future = destroyed.get_future();
+
+	asio::post(worker->context(), [this, worker, &destroyed](){
+		if ( accepting_worker_ == worker ) {
+			accepting_.reset();		// its socket belongs to this loop
+		}
+		delete worker;
+		destroyed.set_value();
+	});
+
+	future.wait();
+}
+
+///////////////////////////////////////////////////////////////
+
+Server::Server(asio::IOContext& ioc, size_t thread_num) :
+	pImpl_(new Impl(ioc, thread_num))
+{
+}
+
+Server::~Server()
+{
+}
+
+void Server::setHandler(handler_type handler)
+{
+	pImpl_->setHandler(std::move(handler));
+}
+
+void Server::setStreamHandler(stream_handler_type handler)
+{
+	pImpl_->setStreamHandler(std::move(handler));
+}
+
+void Server::setIdleTimeout(time_t ms)
+{
+	pImpl_->setIdleTimeout(ms);
+}
+
+void Server::setHeaderTimeout(time_t ms)
+{
+	pImpl_->setHeaderTimeout(ms);
+}
+
+void Server::setMaxConnections(size_t count)
+{
+	pImpl_->setMaxConnections(count);
+}
+
+void Server::setMaxHeaderBytes(size_t bytes)
+{
+	pImpl_->setMaxHeaderBytes(bytes);
+}
+
+void Server::setMaxHeaders(size_t count)
+{
+	pImpl_->setMaxHeaders(count);
+}
+
+void Server::setMaxBodyBytes(size_t bytes)
+{
+	pImpl_->setMaxBodyBytes(bytes);
+}
+
+void Server::setCompression(int level, size_t min_bytes)
+{
+	pImpl_->setCompression(level, min_bytes);
+}
+
+void Server::setCache(size_t max_bytes, std::vector<field_type> key_fields)
+{
+	pImpl_->setCache(max_bytes, std::move(key_fields));
+}
+
+void Server::setHttp2(bool on)
+{
+	pImpl_->setHttp2(on);
+}
+
+asio::errcode_type Server::start(const asio::ip::Endpoint& endpoint)
+{
+	return pImpl_->start(endpoint);
+}
+
+void Server::stop()
+{
+	pImpl_->stop();
+}
+
+asio::errcode_type Server::localAddr(asio::ip::Endpoint& endpoint)
+{
+	return pImpl_->localAddr(endpoint);
+}
+
+size_t Server::connections() const
+{
+	return pImpl_->connections();
+}
+
+///////////////////////////////////////////////////////////////
+
+ServerStream::ServerStream(asio::IOContext& ioc) :
+	pImpl_(new Impl(ioc))
+{
+}
+
+ServerStream::~ServerStream()
+{
+}
+
+asio::IOContext& ServerStream::context()
+{
+	return pImpl_->ioc;
+}
+
+bool ServerStream::closed() const
+{
+	return pImpl_->conn == nullptr;
+}
+
+void ServerStream::onData(data_handler_type handler)
+{
+	if ( pImpl_->conn ) {
+		pImpl_->on_data = std::move(handler);
+	}
+}
+
+void ServerStream::onEnd(event_handler_type handler)
+{
+	if ( pImpl_->conn ) {
+		pImpl_->on_end = std::move(handler);
+	}
+}
+
+void ServerStream::onClose(event_handler_type handler)
+{
+	if ( pImpl_->conn ) {
+		pImpl_->on_close = std::move(handler);
+	}
+}
+
+void ServerStream::pause()
+{
+	pImpl_->paused = true;
+}
+
+void ServerStream::resume()
+{
+	if ( !pImpl_->paused ) {
+		return;
+	}
+	pImpl_->paused = false;
+	if ( pImpl_->conn ) {
+		pImpl_->conn->streamResume();
+	}
+}
+
+Response& ServerStream::response()
+{
+	return pImpl_->response;
+}
+
+bool ServerStream::write(StringView data)
+{
+	if ( !pImpl_->conn || pImpl_->ended ) {
+		return false;
+	}
+	return pImpl_->conn->streamWrite(*pImpl_, data);
+}
+
+void ServerStream::onDrain(event_handler_type handler)
+{
+	if ( pImpl_->conn ) {
+		pImpl_->on_drain = std::move(handler);
+	}
+}
+
+void ServerStream::end()
+{
+	if ( !pImpl_->conn || pImpl_->ended ) {
+		return;
+	}
+	pImpl_->conn->streamEnd(*pImpl_);
+}
+
+bool ServerStream::upgrade()
+{
+	if ( !pImpl_->conn ) {
+		return false;
+	}
+	return pImpl_->conn->streamUpgrade(*pImpl_);
+}
+
+void ServerStream::abort()
+{
+	if ( pImpl_->conn ) {
+		pImpl_->conn->close();
+	}
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
@@ -0,0 +1,221 @@
+#ifndef __LCY_PROTOCOL_HTTP_SERVER_H__
+#define __LCY_PROTOCOL_HTTP_SERVER_H__
+
+#include <time.h>
+#include <stddef.h>
+#include <memory>
+#include <vector>
+#include <functional>
+
+#include "lcy/asio/src/errinfo.h"
+#include "lcy/asio/src/ip/endpoint.h"
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/http/message.h"
+
+namespace lcy {
+namespace asio {
+class IOContext;
+}	// namespace asio
+
+namespace protocol {
+namespace http {
+
+class RequestView;
+class Response;
+class ServerStream;
+
+/*
+* HTTP/1.x server : keep-alive, pipelining, timeouts and a connection limit, and
+* HTTP/2 over cleartext TCP with setHttp2().
+*
+* The acceptor runs on the IOContext passed to the constructor, connections are
+* spread over `thread_num` loop threads ( or served on that IOContext when 0 ).
+* Every loop thread owns one DateClock and one sweep timer for all of its
+* connections, so a request never registers a timer of its own.
+*
+* On each read every complete request already in the buffer is handled and all
+* of their responses are sent with a single write.
+*
+* example :
+*
+*	http::Server server(ioc, 4);
+*	server.setHandler([](const http::RequestView& request, http::Response& response){
+*		response.setBody("hello");
+*	});
+*	server.start(asio::ip::Endpoint("0.0.0.0", 8080));
+*	ioc.loop_wait();
+*
+* notify :
+*	The handler runs on the loop thread of the connection. The response arrives
+*	with the version of the request and 200 OK, Content-Length and Date are filled
+*	in by the serializer.
+*	`request` refers into the receive buffer, it is only valid during the call.
+*	The body is collected before the handler runs, up to setMaxBodyBytes() ( 413 above
+*	it ) : large uploads and downloads go through the stream handler instead.
+*	A response with a file ( Response::setFile(), see StaticFiles ) is sent with
+*	sendfile(2), the requests behind it wait until it is out. Up to FILE_COPY_BYTES
+*	the file is read in behind the head instead, one write beats two for small files.
+*	With setCompression() bodies of a Compressible() type are gzip or deflate coded
+*	as the client accepts, a collected body from min_bytes on, a streamed body of
+*	unknown length whatever its length ( each write() is flushed as one piece ).
+*	Response::setCompression() sets the level of one response, e.g. for a route.
+*	With setCache() GET and HEAD requests of HTTP/1.1 are answered from a ResponseCache
+*	of the loop thread before the handler is asked, the handler opts in with
+*	Cache-Control ( see ResponseCache ). A stale entry is refreshed by running the
+*	handler again once the stale response has been written.
+*	With setHttp2() a connection opening with the HTTP/2 preface ( prior knowledge,
+*	e.g. curl --http2-prior-knowledge ) is served by an http2::ServerSession : its
+*	streams are multiplexed and each request goes to the handler as a RequestView of
+*	version HTTP_2, compression applies as above. The stream handler and the cache
+*	are HTTP/1 only.
+*	Timeouts are in milliseconds, 0 disables one. Settings must be made before start().
+*/
+class Server {
+public:
+	typedef std::function<void (const RequestView&, Response&)> handler_type;
+	typedef std::shared_ptr<ServerStream> stream_ptr;
+	/*
+	* Called as soon as the head of a request is in, `request` has no body yet.
+	* Returns false, without touching `stream`, to leave the request to the handler.
+	*/
+	typedef std::function<bool (const RequestView&, const stream_ptr&)> stream_handler_type;
+
+	enum {
+		DEFAULT_IDLE_TIMEOUT_MS = 60 * 1000,		// between requests of a keep-alive connection
+		DEFAULT_HEADER_TIMEOUT_MS = 10 * 1000,		// from the first byte of a request to its blank line
+		DEFAULT_MAX_CONNECTIONS = 10000,
+		DEFAULT_MAX_BODY_BYTES = 8 * 1024 * 1024,	// collected bodies only
+		READ_BUFFER_BYTES = 16 * 1024,
+		OUTPUT_HIGH_WATER = 1024 * 1024,			// stop handling requests while this much is unsent
+		FILE_CHUNK_BYTES = 1024 * 1024,				// a file body is handed to the reactor in such steps
+		FILE_COPY_BYTES = 16 * 1024,				// smaller file bodies are copied behind their head
+		DEFAULT_COMPRESS_MIN_BYTES = 1024,			// smaller bodies gain less than the coding costs
+	};
+
+	Server(asio::IOContext& ioc, size_t thread_num);
+	~Server();
+
+	void setHandler(handler_type handler);
+	void setStreamHandler(stream_handler_type handler);
+	void setIdleTimeout(time_t ms);
+	void setHeaderTimeout(time_t ms);
+	void setMaxConnections(size_t count);		// accepted connections above it are closed at once
+	void setMaxHeaderBytes(size_t bytes);		// see Parser, answered with 431
+	void setMaxHeaders(size_t count);
+	void setMaxBodyBytes(size_t bytes);		// 0 : no limit
+	// zlib `level` 1 to 9, 0 ( the default ) : only the responses that ask for it
+	void setCompression(int level, size_t min_bytes = DEFAULT_COMPRESS_MIN_BYTES);
+	/*
+	* Up to `max_bytes` of responses per loop thread, 0 ( the default ) turns the cache
+	* off. The values of `key_fields` are part of the key, Accept-Encoding is added
+	* when setCompression() is on.
+	*/
+	void setCache(size_t max_bytes, std::vector<field_type> key_fields = std::vector<field_type>());
+	// serves HTTP/2 to the connections starting with its preface, off by default
+	void setHttp2(bool on);
+
+	asio::errcode_type start(const asio::ip::Endpoint& endpoint);
+	/*
+	* notify :
+	*	Closes every connection and joins the loop threads. Call it from the thread of
+	*	the IOContext given to the constructor, never from a handler.
+	*/
+	void stop();
+
+	asio::errcode_type localAddr(asio::ip::Endpoint& endpoint);
+	size_t connections() const;
+
+private:
+	Server(const Server&);
+	Server& operator=(const Server&);
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> pImpl_;
+};
+
+/*
+* A request taken by the stream handler : its body is handed over as it arrives and
+* its response is written as it is produced, so neither has to fit in memory.
+*
+* example :
+*
+*	server.setStreamHandler([](const http::RequestView& request, const http::Server::stream_ptr& stream){
+*		if ( request.method() != http::method::PUT ) {
+*			return false;
+*		}
+*		std::shared_ptr<Upload> upload = ...;
+*		stream->onData([upload](StringView piece){ upload->append(piece); });
+*		stream->onEnd([stream](){
+*			stream->response().setState(http::state::CREATED);
+*			stream->end();
+*		});
+*		return true;
+*	});
+*
+* Request side : a piece passed to onData() is only valid during the call, onEnd()
+* follows the last one. While paused the socket is not read and nothing is delivered.
+*
+* Response side : response() is the head, sent by the first write() or by end().
+* Without a Content-Length of its own an HTTP/1.1 body is chunked and an HTTP/1.0
+* body ends with the connection. write() returns false once OUTPUT_HIGH_WATER bytes
+* are waiting to be sent, onDrain() tells when to go on.
+*
+* Upgrade : upgrade() answers with response() as it is ( 101 Switching Protocols ) and
+* hands the connection over. From then on onData() gets every byte read, write() sends
+* its data as it is and end() closes the connection once the output is out. onEnd() is
+* not called again, the exchange lasts until end(), abort() or onClose(). The idle
+* timeout still applies, a protocol on top keeps the connection busy ( e.g. pings ).
+*
+* notify :
+*	Every member must be called on context(), the loop of the connection. Requests
+*	pipelined behind this one wait until its body is read and its response ended.
+*	When the connection goes away first, onClose() is called instead and everything
+*	after it is ignored. The callbacks are dropped once the exchange is over, so they
+*	may hold the stream.
+*/
+class ServerStream {
+public:
+	typedef std::function<void (StringView)> data_handler_type;
+	typedef std::function<void ()> event_handler_type;
+
+	explicit ServerStream(asio::IOContext& ioc);	// made by the server
+	~ServerStream();
+
+	asio::IOContext& context();
+	bool closed() const;
+
+	void onData(data_handler_type handler);
+	void onEnd(event_handler_type handler);
+	void onClose(event_handler_type handler);
+	void pause();
+	void resume();
+
+	Response& response();
+	bool write(StringView data);
+	void onDrain(event_handler_type handler);
+	void end();
+	void abort();		// closes the connection, for a request that can not be served
+	/*
+	* Sends the head with state 101 and turns the connection into a byte stream,
+	* false once the head is out or for an HTTP/1.0 request. Call it from the stream
+	* handler, the callbacks set before it returns see the first bytes.
+	*/
+	bool upgrade();
+
+private:
+	ServerStream(const ServerStream&);
+	ServerStream& operator=(const ServerStream&);
+
+private:
+	friend class ServerConnection;
+
+	class Impl;
+	std::unique_ptr<Impl> pImpl_;
+};
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_SERVER_H__
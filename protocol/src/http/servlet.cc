@@ -16,22 +16,63 @@ Servlet::~Servlet()
 
 void Servlet::setFunction(std::string uri, function_type func)
 {
-	url_func_umap_[std::move(uri)] = std::move(func);
+	setFunction(method::INVALID, uri, std::move(func));
+}
+
+void Servlet::setFunction(method_type method, StringView pattern, function_type func)
+{
+	// a new route takes the id of a removed one first
+	size_t free_id = free_ids_.empty() ? functions_.size() : free_ids_.back();
+	size_t id = router_.add(method, pattern, free_id);
+	if ( id == Router::NO_ROUTE ) {
+		return;
+	}
+
+	if ( id == free_id && !free_ids_.empty() ) {
+		free_ids_.pop_back();
+		functions_[id] = std::move(func);
+	} else if ( id == functions_.size() ) {
+		functions_.push_back(std::move(func));
+	} else {
+		functions_[id] = std::move(func);
+	}
 }
 
 void Servlet::removeFunction(const std::string& uri)
 {
-	url_func_umap_.erase(uri);
+	removeFunction(method::INVALID, uri);
+}
+
+void Servlet::removeFunction(method_type method, StringView pattern)
+{
+	size_t id = router_.remove(method, pattern);
+	if ( id != Router::NO_ROUTE ) {
+		functions_[id] = {};
+		free_ids_.push_back(id);
+	}
 }
 
 Servlet::function_type Servlet::getFunction(const std::string& uri) const
 {
-	auto kv_iter = url_func_umap_.find(uri);
-	if ( kv_iter != url_func_umap_.end() )
-		return kv_iter->second;
+	RouteParams params;
+	const function_type* func = findFunction(method::INVALID, uri, params);
+	if ( func ) {
+		return *func;
+	}
 	return {};
 }
 
+const Servlet::function_type* Servlet::findFunction(method_type method,
+													StringView uri,
+													RouteParams& params) const
+{
+	size_t id = router_.match(method, uri, params);
+	if ( id == Router::NO_ROUTE || !functions_[id] ) {
+		return nullptr;
+	}
+	return &functions_[id];
+}
+
 }   // namespace http
 }   // namespace protocol
 }	// namespace lcy
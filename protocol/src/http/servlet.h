@@ -2,10 +2,13 @@
 #define __LCY_PROTOCOL_HTTP_SERVLET_H__ 
 
 #include <string>
+#include <vector>
 #include <memory>
 #include <functional>
 
-#include <unordered_map>
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/http/request.h"
+#include "lcy/protocol/src/http/router.h"
 
 namespace lcy {
 namespace protocol {
@@ -14,6 +17,20 @@ namespace http {
 class Request;
 class Response;
 
+/*
+* Functions by method and path pattern ( see Router for the pattern syntax ).
+*
+* example :
+*
+*	servlet.setFunction(method::GET, "/users/:id", get_user);
+*	servlet.setFunction("/static/" "*path", serve_file);		// any method
+*
+*	RouteParams params;
+*	auto func = servlet.findFunction(request.method(), request.uri(), params);
+*	if ( func ) {
+*		(*func)(request, response);		// params.get("id") points into request.uri()
+*	}
+*/
 class Servlet {
 public:
     typedef std::function<
@@ -23,17 +40,25 @@ public:
     Servlet();
     ~Servlet();
 
+	// `uri` is a pattern, a function for any method
     void setFunction(std::string uri, function_type func);
+    void setFunction(method_type method, StringView pattern, function_type func);
     void removeFunction(const std::string& uri);
+    void removeFunction(method_type method, StringView pattern);
+
+	// copies the function, kept for existing callers : prefer findFunction()
     function_type getFunction(const std::string& uri) const;
+	// nullptr when no route matches, never allocates
+	const function_type* findFunction(method_type method,
+									  StringView uri,
+									  RouteParams& params) const;
 
 private:
-	typedef std::unordered_map<
-				std::string, 
-				function_type
-			> url_func_umap_type;
+	typedef std::vector<function_type> function_array_type;
 
-	url_func_umap_type url_func_umap_;
+	Router router_;
+	function_array_type functions_;		// indexed by route id
+	std::vector<size_t> free_ids_;		// ids of removed routes, reused by setFunction()
 };
 
 }   // namespace http
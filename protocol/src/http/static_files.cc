@@ -0,0 +1,410 @@
+#include "lcy/protocol/src/http/static_files.h"
+#include "lcy/protocol/src/http/request_view.h"
+#include "lcy/protocol/src/http/date_clock.h"
+#include "lcy/protocol/src/http/router.h"
+#include "lcy/protocol/src/http/compression.h"
+
+#include <errno.h>
+#include <algorithm>
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+struct StaticFiles::Conditions {
+	method_type method;
+	StringView if_none_match;
+	StringView if_modified_since;
+	StringView range;
+	StringView if_range;
+	StringView accept_encoding;
+};
+
+static const StringView kDefaultType("application/octet-stream", 24);
+
+static const struct {
+	const char* ext;
+	const char* type;
+} kMimeTypes[] = {
+	{ "html",	"text/html; charset=utf-8" },
+	{ "htm",	"text/html; charset=utf-8" },
+	{ "css",	"text/css; charset=utf-8" },
+	{ "js",		"text/javascript; charset=utf-8" },
+	{ "mjs",	"text/javascript; charset=utf-8" },
+	{ "json",	"application/json" },
+	{ "txt",	"text/plain; charset=utf-8" },
+	{ "xml",	"application/xml" },
+	{ "svg",	"image/svg+xml" },
+	{ "png",	"image/png" },
+	{ "jpg",	"image/jpeg" },
+	{ "jpeg",	"image/jpeg" },
+	{ "gif",	"image/gif" },
+	{ "webp",	"image/webp" },
+	{ "ico",	"image/x-icon" },
+	{ "woff",	"font/woff" },
+	{ "woff2",	"font/woff2" },
+	{ "wasm",	"application/wasm" },
+	{ "pdf",	"application/pdf" },
+	{ "zip",	"application/zip" },
+	{ "gz",		"application/gzip" },
+	{ "mp4",	"video/mp4" },
+	{ "mp3",	"audio/mpeg" },
+};
+
+static StringView Trim(StringView s)
+{
+	size_t begin = 0, end = s.size();
+	while ( begin < end && (s[begin] == ' ' || s[begin] == '\t') ) ++begin;
+	while ( end > begin && (s[end - 1] == ' ' || s[end - 1] == '\t') ) --end;
+	return s.substr(begin, end - begin);
+}
+
+static int HexValue(char c)
+{
+	if ( c >= '0' && c <= '9' ) return c - '0';
+	if ( c >= 'a' && c <= 'f' ) return c - 'a' + 10;
+	if ( c >= 'A' && c <= 'F' ) return c - 'A' + 10;
+	return -1;
+}
+
+/*
+* The file below `root` for the URI path `path`, percent decoded segment by segment.
+* Returns 0 on success, or the status to answer.
+*/
+static int ResolvePath(const std::string& root, StringView path, const std::string& index, std::string& out)
+{
+	out = root;
+	std::string segment;
+
+	size_t pos = 0;
+	while ( pos <= path.size() ) {
+		size_t end = path.find('/', pos);
+		if ( end == StringView::npos ) {
+			end = path.size();
+		}
+
+		segment.clear();
+		for ( size_t i = pos; i < end; ++i ) {
+			char c = path[i];
+			if ( c == '%' ) {
+				int hi = i + 2 < end ? HexValue(path[i + 1]) : -1;
+				int lo = hi >= 0 ? HexValue(path[i + 2]) : -1;
+				if ( lo < 0 ) {
+					return (int)state::BAD_REQUEST;
+				}
+				c = (char)(hi * 16 + lo);
+				i += 2;
+			}
+			// a decoded '/' would open a segment the check below never saw
+			if ( c == '\0' || c == '/' ) {
+				return (int)state::BAD_REQUEST;
+			}
+			segment.push_back(c);
+		}
+
+		if ( segment == ".." ) {
+			return (int)state::FORBIDDEN;
+		}
+		if ( !segment.empty() && segment != "." ) {
+			out += '/';
+			out += segment;
+		}
+		pos = end + 1;
+	}
+
+	if ( path.empty() || path[path.size() - 1] == '/' ) {
+		if ( index.empty() ) {
+			return (int)state::FORBIDDEN;
+		}
+		out += '/';
+		out += index;
+	}
+	return 0;
+}
+
+// If-None-Match : "*" or a list of entity tags, compared weakly
+static bool MatchEtag(StringView header, StringView etag)
+{
+	if ( Trim(header) == StringView("*", 1) ) {
+		return true;
+	}
+
+	size_t pos = 0;
+	while ( pos < header.size() ) {
+		size_t comma = header.find(',', pos);
+		if ( comma == StringView::npos ) {
+			comma = header.size();
+		}
+
+		StringView tag = Trim(header.substr(pos, comma - pos));
+		if ( tag.startsWith(StringView("W/", 2)) ) {
+			tag = tag.substr(2);
+		}
+		if ( tag == etag ) {
+			return true;
+		}
+		pos = comma + 1;
+	}
+	return false;
+}
+
+// digits only, false on overflow
+static bool ParseSize(StringView s, size_t& value)
+{
+	if ( s.empty() ) {
+		return false;
+	}
+
+	value = 0;
+	for ( size_t i = 0; i < s.size(); ++i ) {
+		if ( s[i] < '0' || s[i] > '9' ) {
+			return false;
+		}
+		size_t digit = (size_t)(s[i] - '0');
+		if ( value > ((size_t)-1 - digit) / 10 ) {
+			return false;
+		}
+		value = value * 10 + digit;
+	}
+	return true;
+}
+
+StaticFiles::RangeResult StaticFiles::ParseRange(StringView range, size_t size, size_t& first, size_t& last)
+{
+	range = Trim(range);
+	if ( range.size() < 6 || !range.substr(0, 6).iequals(StringView("bytes=", 6)) ) {
+		return RangeResult::NONE;
+	}
+
+	StringView spec = Trim(range.substr(6));
+	size_t dash = spec.find('-');
+	if ( dash == StringView::npos || spec.find(',') != StringView::npos ) {
+		return RangeResult::NONE;
+	}
+
+	StringView from = Trim(spec.substr(0, dash));
+	StringView to = Trim(spec.substr(dash + 1));
+
+	if ( from.empty() ) {		// "-n" : the last n bytes
+		size_t suffix = 0;
+		if ( !ParseSize(to, suffix) ) {
+			return RangeResult::NONE;
+		}
+		if ( suffix == 0 || size == 0 ) {
+			return RangeResult::UNSATISFIABLE;
+		}
+		first = size - std::min(suffix, size);
+		last = size - 1;
+		return RangeResult::OK;
+	}
+
+	if ( !ParseSize(from, first) ) {
+		return RangeResult::NONE;
+	}
+	last = (size_t)-1;
+	if ( !to.empty() && (!ParseSize(to, last) || last < first) ) {
+		return RangeResult::NONE;
+	}
+
+	if ( first >= size ) {
+		return RangeResult::UNSATISFIABLE;
+	}
+	last = std::min(last, size - 1);
+	return RangeResult::OK;
+}
+
+StringView StaticFiles::MimeType(StringView path)
+{
+	size_t dot = path.size();
+	while ( dot > 0 && path[dot - 1] != '.' && path[dot - 1] != '/' ) {
+		--dot;
+	}
+	if ( dot == 0 || path[dot - 1] != '.' ) {
+		return kDefaultType;
+	}
+
+	StringView ext = path.substr(dot);
+	for ( size_t i = 0; i < sizeof(kMimeTypes) / sizeof(kMimeTypes[0]); ++i ) {
+		if ( ext.iequals(StringView(kMimeTypes[i].ext)) ) {
+			return StringView(kMimeTypes[i].type);
+		}
+	}
+	return kDefaultType;
+}
+
+///////////////////////////////////////////////////////////////
+
+StaticFiles::StaticFiles(std::string root, size_t cache_capacity, time_t revalidate_ms) :
+	root_(std::move(root)),
+	index_("index.html"),
+	precompressed_(false),
+	cache_(cache_capacity, revalidate_ms)
+{
+	while ( root_.size() > 1 && root_[root_.size() - 1] == '/' ) {
+		root_.pop_back();
+	}
+}
+
+StaticFiles::~StaticFiles()
+{
+}
+
+void StaticFiles::setIndex(std::string name)
+{
+	index_ = std::move(name);
+}
+
+void StaticFiles::setCacheControl(std::string value)
+{
+	cache_control_ = std::move(value);
+}
+
+void StaticFiles::setPrecompressed(bool on)
+{
+	precompressed_ = on;
+}
+
+FileCache& StaticFiles::cache()
+{
+	return cache_;
+}
+
+void StaticFiles::serve(const Request& request, StringView path, Response& response) const
+{
+	Conditions conds;
+	conds.method = request.method();
+	conds.if_none_match = StringView(request.getHeader(field::IF_NONE_MATCH));
+	conds.if_modified_since = StringView(request.getHeader(field::IF_MODIFIED_SINCE));
+	conds.range = StringView(request.getHeader(field::RANGE));
+	conds.if_range = StringView(request.getHeader(field::IF_RANGE));
+	conds.accept_encoding = StringView(request.getHeader(field::ACCEPT_ENCODING));
+	serve(conds, path, response);
+}
+
+void StaticFiles::serve(const RequestView& request, StringView path, Response& response) const
+{
+	Conditions conds;
+	conds.method = request.method();
+	conds.if_none_match = request.getHeader(field::IF_NONE_MATCH);
+	conds.if_modified_since = request.getHeader(field::IF_MODIFIED_SINCE);
+	conds.range = request.getHeader(field::RANGE);
+	conds.if_range = request.getHeader(field::IF_RANGE);
+	conds.accept_encoding = request.getHeader(field::ACCEPT_ENCODING);
+	serve(conds, path, response);
+}
+
+Servlet::function_type StaticFiles::function(std::string prefix) const
+{
+	return [this, prefix](const Request& request, Response& response){
+		StringView path = Router::Path(StringView(request.uri()));
+		if ( !path.startsWith(StringView(prefix)) ) {
+			response.setState(state::NOT_FOUND);
+			return;
+		}
+		serve(request, path.substr(prefix.size()), response);
+	};
+}
+
+void StaticFiles::serve(const Conditions& conds, StringView path, Response& response) const
+{
+	if ( conds.method != method::GET && conds.method != method::HEAD ) {
+		response.setState(state::METHOD_NOT_ALLOWED);
+		response.setHeader("Allow", "GET, HEAD");
+		return;
+	}
+
+	std::string full;
+	int status = ResolvePath(root_, path, index_, full);
+	if ( status != 0 ) {
+		response.setState((state_type)status);
+		return;
+	}
+
+	asio::errcode_type ec = asio::err::SUCCESS;
+	open_file_ptr file = cache_.open(full, ec);
+	if ( !file && ec == EISDIR && !index_.empty() ) {
+		full += '/';
+		full += index_;
+		file = cache_.open(full, ec);
+	}
+	if ( !file ) {
+		if ( ec == ENOENT || ec == ENOTDIR ) {
+			response.setState(state::NOT_FOUND);
+		} else if ( ec == EACCES || ec == EISDIR || ec == EPERM ) {
+			response.setState(state::FORBIDDEN);
+		} else {
+			response.setState(state::INTERNAL_SERVER_ERROR);
+		}
+		return;
+	}
+
+	// the sidecar stands in for the file, a stale one ( older than the file ) is ignored
+	bool gzipped = false;
+	if ( precompressed_ ) {
+		response.setHeader(field::VARY, "Accept-Encoding");
+		if ( AcceptsCoding(conds.accept_encoding, StringView("gzip", 4)) ) {
+			open_file_ptr gz = cache_.open(full + ".gz", ec);
+			if ( gz && gz->mtime() >= file->mtime() ) {
+				file = std::move(gz);
+				gzipped = true;
+			}
+		}
+	}
+
+	response.setHeader(field::ETAG, file->etag().toString());
+	response.setHeader(field::LAST_MODIFIED, file->lastModified().toString());
+	if ( !cache_control_.empty() ) {
+		response.setHeader(field::CACHE_CONTROL, cache_control_);
+	}
+
+	// If-Modified-Since only counts without If-None-Match
+	bool not_modified = false;
+	time_t since = 0;
+	if ( !conds.if_none_match.empty() ) {
+		not_modified = MatchEtag(conds.if_none_match, file->etag());
+	} else if ( DateClock::parse(Trim(conds.if_modified_since), since) ) {
+		not_modified = file->mtime() <= since;
+	}
+	if ( not_modified ) {
+		response.setState(state::NOT_MODIFIED);
+		return;
+	}
+
+	response.setHeader(field::CONTENT_TYPE, MimeType(StringView(full)).toString());
+	response.setHeader(field::ACCEPT_RANGES, "bytes");
+	if ( gzipped ) {
+		response.setHeader(field::CONTENT_ENCODING, "gzip");
+	}
+
+	size_t size = file->size();
+	size_t first = 0, last = 0;
+	RangeResult range = RangeResult::NONE;
+	// If-Range holds the ETag or the Last-Modified the client has, strong comparison
+	if ( conds.method == method::GET && !conds.range.empty() &&
+		 (conds.if_range.empty() || Trim(conds.if_range) == file->etag() ||
+		  Trim(conds.if_range) == file->lastModified()) ) {
+		range = ParseRange(conds.range, size, first, last);
+	}
+
+	if ( range == RangeResult::UNSATISFIABLE ) {
+		response.setState(state::RANGE_NOT_SATISFIABLE);
+		response.setHeader(field::CONTENT_RANGE, "bytes */" + std::to_string(size));
+		response.removeHeader(field::CONTENT_TYPE);
+		return;
+	}
+
+	if ( range == RangeResult::OK ) {
+		response.setState(state::PARTIAL_CONTENT);
+		response.setHeader(field::CONTENT_RANGE, "bytes " + std::to_string(first) + "-" +
+							std::to_string(last) + "/" + std::to_string(size));
+		response.setFile(std::move(file), first, last - first + 1);
+		return;
+	}
+
+	response.setState(state::OK);
+	response.setFile(std::move(file), 0, size);
+}
+
+}	// namespace http
+}	// namespace protocol
+}	// namespace lcy
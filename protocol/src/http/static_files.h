@@ -0,0 +1,100 @@
+#ifndef __LCY_PROTOCOL_HTTP_STATIC_FILES_H__
+#define __LCY_PROTOCOL_HTTP_STATIC_FILES_H__
+
+#include <string>
+#include <time.h>
+
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/http/request.h"
+#include "lcy/protocol/src/http/response.h"
+#include "lcy/protocol/src/http/servlet.h"
+#include "lcy/protocol/src/http/file_cache.h"
+
+namespace lcy {
+namespace protocol {
+namespace http {
+
+class RequestView;
+
+/*
+* Files below a root directory, for a Servlet route or a Server handler.
+*
+* The body is the file itself ( Response::setFile() ), http::Server sends it with
+* sendfile(2). Open descriptors and their stat come from a FileCache.
+*
+*	GET and HEAD only, 405 otherwise.
+*	ETag and Last-Modified come from the stat of the file, a matching If-None-Match
+*	( or, without it, If-Modified-Since ) gives 304.
+*	One "bytes=" range gives 206 with Content-Range, an unsatisfiable one 416.
+*	Several ranges, or an If-Range that no longer matches, give the whole file.
+*	A path ending with '/' serves the index file of the directory.
+*	With setPrecompressed() a "<file>.gz" next to the file, not older than it, is
+*	sent instead with Content-Encoding: gzip to a client accepting gzip : nothing is
+*	compressed per request. Its ETag is its own, ranges apply to it.
+*
+* example :
+*
+*	http::StaticFiles files("/var/www");
+*	servlet.setFunction(http::method::GET, "/static/" "*path", files.function("/static/"));
+*
+* notify :
+*	The path is percent decoded before it is checked, a ".." segment gives 403.
+*	Symbolic links below the root are followed.
+*	Configure before serving, then one instance may serve every loop thread. The
+*	functions it returns refer to it, it must outlive them.
+*/
+class StaticFiles {
+public:
+	StaticFiles(std::string root,
+				size_t cache_capacity = FileCache::DEFAULT_CAPACITY,
+				time_t revalidate_ms = FileCache::DEFAULT_REVALIDATE_MS);
+	~StaticFiles();
+
+	void setIndex(std::string name);				// "index.html", "" : none
+	void setCacheControl(std::string value);		// none by default
+	void setPrecompressed(bool on);					// off by default
+
+	// `path` is below the root, as it was in the URI : percent encoded, no query
+	void serve(const Request& request, StringView path, Response& response) const;
+	void serve(const RequestView& request, StringView path, Response& response) const;
+
+	// serves the path of the request below `prefix`, 404 for other paths
+	Servlet::function_type function(std::string prefix = "/") const;
+
+	FileCache& cache();
+
+	// Content-Type by extension, "application/octet-stream" when unknown
+	static StringView MimeType(StringView path);
+
+	/*
+	* One range of a Range field against a representation of `size` bytes :
+	* NONE to ignore it ( absent, malformed, several ranges ), UNSATISFIABLE for 416.
+	*/
+	enum class RangeResult {
+		NONE,
+		OK,
+		UNSATISFIABLE,
+	};
+	static RangeResult ParseRange(StringView range, size_t size, size_t& first, size_t& last);
+
+	struct Conditions;		// the fields of the request that matter here
+
+private:
+	StaticFiles(const StaticFiles&);
+	StaticFiles& operator=(const StaticFiles&);
+
+	void serve(const Conditions& conds, StringView path, Response& response) const;
+
+private:
+	std::string root_;
+	std::string index_;
+	std::string cache_control_;
+	bool precompressed_;
+	mutable FileCache cache_;
+};
+
+}   // namespace http
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP_STATIC_FILES_H__
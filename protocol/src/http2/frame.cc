@@ -0,0 +1,171 @@
+#include "lcy/protocol/src/http2/frame.h"
+
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace http2 {
+
+const char* FrameToString(frame_type f)
+{
+	switch ( f ) {
+		case frame::DATA : return "DATA";
+		case frame::HEADERS : return "HEADERS";
+		case frame::PRIORITY : return "PRIORITY";
+		case frame::RST_STREAM : return "RST_STREAM";
+		case frame::SETTINGS : return "SETTINGS";
+		case frame::PUSH_PROMISE : return "PUSH_PROMISE";
+		case frame::PING : return "PING";
+		case frame::GOAWAY : return "GOAWAY";
+		case frame::WINDOW_UPDATE : return "WINDOW_UPDATE";
+		case frame::CONTINUATION : return "CONTINUATION";
+		default : return "UNKNOWN";
+	}
+}
+
+const char* ErrorToString(error_type e)
+{
+	switch ( e ) {
+		case error::NO_ERROR : return "NO_ERROR";
+		case error::PROTOCOL_ERROR : return "PROTOCOL_ERROR";
+		case error::INTERNAL_ERROR : return "INTERNAL_ERROR";
+		case error::FLOW_CONTROL_ERROR : return "FLOW_CONTROL_ERROR";
+		case error::SETTINGS_TIMEOUT : return "SETTINGS_TIMEOUT";
+		case error::STREAM_CLOSED : return "STREAM_CLOSED";
+		case error::FRAME_SIZE_ERROR : return "FRAME_SIZE_ERROR";
+		case error::REFUSED_STREAM : return "REFUSED_STREAM";
+		case error::CANCEL : return "CANCEL";
+		case error::COMPRESSION_ERROR : return "COMPRESSION_ERROR";
+		case error::CONNECT_ERROR : return "CONNECT_ERROR";
+		case error::ENHANCE_YOUR_CALM : return "ENHANCE_YOUR_CALM";
+		case error::INADEQUATE_SECURITY : return "INADEQUATE_SECURITY";
+		case error::HTTP_1_1_REQUIRED : return "HTTP_1_1_REQUIRED";
+		default : return "UNKNOWN";
+	}
+}
+
+uint32_t ReadUint32(const char* data)
+{
+	const uint8_t* p = (const uint8_t*)data;
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+void ParseFrameHead(const char* data, FrameHead& head)
+{
+	const uint8_t* p = (const uint8_t*)data;
+	head.length = ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2];
+	head.type = (frame_type)p[3];
+	head.flags = p[4];
+	head.stream_id = ReadUint32(data + 5) & 0x7FFFFFFF;		// the reserved bit is ignored
+}
+
+static void PutUint32(char* out, uint32_t value)
+{
+	out[0] = (char)(value >> 24);
+	out[1] = (char)(value >> 16);
+	out[2] = (char)(value >> 8);
+	out[3] = (char)value;
+}
+
+void SerializeFrameHead(char* out, uint32_t length, frame_type type, uint8_t flags, uint32_t stream_id)
+{
+	out[0] = (char)(length >> 16);
+	out[1] = (char)(length >> 8);
+	out[2] = (char)length;
+	out[3] = (char)type;
+	out[4] = (char)flags;
+	PutUint32(out + 5, stream_id & 0x7FFFFFFF);
+}
+
+void WriteFrameHead(asio::DynamicBuffer& out, uint32_t length, frame_type type, uint8_t flags, uint32_t stream_id)
+{
+	out.reserve(FRAME_HEAD_BYTES + length);
+	SerializeFrameHead(out.writeBegin(), length, type, flags, stream_id);
+	out.write(FRAME_HEAD_BYTES);
+}
+
+// appends a payload the frame head has reserved room for
+static void Put(asio::DynamicBuffer& out, const void* data, size_t len)
+{
+	if ( len > 0 ) {
+		out.reserve(len);
+		::memcpy(out.writeBegin(), data, len);
+		out.write(len);
+	}
+}
+
+void WriteSettings(asio::DynamicBuffer& out, const setting_type* ids, const uint32_t* values, size_t count)
+{
+	WriteFrameHead(out, (uint32_t)(count * 6), frame::SETTINGS, 0, 0);
+	for ( size_t i = 0; i < count; ++i ) {
+		char entry[6];
+		entry[0] = (char)((uint16_t)ids[i] >> 8);
+		entry[1] = (char)(uint16_t)ids[i];
+		PutUint32(entry + 2, values[i]);
+		Put(out, entry, sizeof(entry));
+	}
+}
+
+void WriteSettingsAck(asio::DynamicBuffer& out)
+{
+	WriteFrameHead(out, 0, frame::SETTINGS, FLAG_ACK, 0);
+}
+
+void WritePing(asio::DynamicBuffer& out, const char payload[8], bool ack)
+{
+	WriteFrameHead(out, 8, frame::PING, ack ? FLAG_ACK : 0, 0);
+	Put(out, payload, 8);
+}
+
+void WriteGoaway(asio::DynamicBuffer& out, uint32_t last_stream_id, error_type code, StringView debug)
+{
+	WriteFrameHead(out, (uint32_t)(8 + debug.size()), frame::GOAWAY, 0, 0);
+	char payload[8];
+	PutUint32(payload, last_stream_id & 0x7FFFFFFF);
+	PutUint32(payload + 4, (uint32_t)code);
+	Put(out, payload, sizeof(payload));
+	Put(out, debug.data(), debug.size());
+}
+
+void WriteRstStream(asio::DynamicBuffer& out, uint32_t stream_id, error_type code)
+{
+	WriteFrameHead(out, 4, frame::RST_STREAM, 0, stream_id);
+	char payload[4];
+	PutUint32(payload, (uint32_t)code);
+	Put(out, payload, sizeof(payload));
+}
+
+void WriteWindowUpdate(asio::DynamicBuffer& out, uint32_t stream_id, uint32_t increment)
+{
+	WriteFrameHead(out, 4, frame::WINDOW_UPDATE, 0, stream_id);
+	char payload[4];
+	PutUint32(payload, increment & 0x7FFFFFFF);
+	Put(out, payload, sizeof(payload));
+}
+
+void WriteData(asio::DynamicBuffer& out, uint32_t stream_id, StringView data, bool end_stream)
+{
+	WriteFrameHead(out, (uint32_t)data.size(), frame::DATA, end_stream ? FLAG_END_STREAM : 0, stream_id);
+	Put(out, data.data(), data.size());
+}
+
+void WriteHeaders(asio::DynamicBuffer& out, uint32_t stream_id, StringView block, bool end_stream,
+				  size_t max_frame_bytes)
+{
+	size_t first = block.size() < max_frame_bytes ? block.size() : max_frame_bytes;
+	uint8_t flags = (end_stream ? FLAG_END_STREAM : 0) | (first == block.size() ? FLAG_END_HEADERS : 0);
+	WriteFrameHead(out, (uint32_t)first, frame::HEADERS, flags, stream_id);
+	Put(out, block.data(), first);
+
+	for ( size_t at = first; at < block.size(); ) {
+		size_t n = block.size() - at < max_frame_bytes ? block.size() - at : max_frame_bytes;
+		flags = at + n == block.size() ? FLAG_END_HEADERS : 0;
+		WriteFrameHead(out, (uint32_t)n, frame::CONTINUATION, flags, stream_id);
+		Put(out, block.data() + at, n);
+		at += n;
+	}
+}
+
+}   // namespace http2
+}   // namespace protocol
+}	// namespace lcy
@@ -0,0 +1,129 @@
+#ifndef __LCY_PROTOCOL_HTTP2_FRAME_H__
+#define __LCY_PROTOCOL_HTTP2_FRAME_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "lcy/asio/src/dynamic_buffer.h"
+#include "lcy/protocol/src/string_view.h"
+
+namespace lcy {
+namespace protocol {
+namespace http2 {
+
+/*
+* Frame layer of HTTP/2 ( RFC 9113 ).
+*/
+
+// what a client sends first, before its SETTINGS
+static const char CLIENT_PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+enum {
+	CLIENT_PREFACE_BYTES = 24,
+	FRAME_HEAD_BYTES = 9,
+	DEFAULT_WINDOW_BYTES = 65535,			// initial flow control window of a stream and of the connection
+	MAX_WINDOW_BYTES = 0x7FFFFFFF,
+	DEFAULT_MAX_FRAME_BYTES = 16384,		// largest payload until SETTINGS_MAX_FRAME_SIZE says otherwise
+	MAX_FRAME_BYTES_LIMIT = 16777215,
+	DEFAULT_HEADER_TABLE_BYTES = 4096,
+};
+
+typedef
+enum class frame :
+	uint8_t
+{
+	DATA = 0x0,
+	HEADERS = 0x1,
+	PRIORITY = 0x2,
+	RST_STREAM = 0x3,
+	SETTINGS = 0x4,
+	PUSH_PROMISE = 0x5,
+	PING = 0x6,
+	GOAWAY = 0x7,
+	WINDOW_UPDATE = 0x8,
+	CONTINUATION = 0x9,
+}
+frame_type;
+
+enum frame_flag {
+	FLAG_END_STREAM = 0x01,
+	FLAG_ACK = 0x01,			// SETTINGS, PING
+	FLAG_END_HEADERS = 0x04,
+	FLAG_PADDED = 0x08,
+	FLAG_PRIORITY = 0x20,
+};
+
+typedef
+enum class error :
+	uint32_t
+{
+	NO_ERROR = 0x0,
+	PROTOCOL_ERROR = 0x1,
+	INTERNAL_ERROR = 0x2,
+	FLOW_CONTROL_ERROR = 0x3,
+	SETTINGS_TIMEOUT = 0x4,
+	STREAM_CLOSED = 0x5,
+	FRAME_SIZE_ERROR = 0x6,
+	REFUSED_STREAM = 0x7,
+	CANCEL = 0x8,
+	COMPRESSION_ERROR = 0x9,
+	CONNECT_ERROR = 0xA,
+	ENHANCE_YOUR_CALM = 0xB,
+	INADEQUATE_SECURITY = 0xC,
+	HTTP_1_1_REQUIRED = 0xD,
+}
+error_type;
+
+typedef
+enum class setting :
+	uint16_t
+{
+	HEADER_TABLE_SIZE = 0x1,
+	ENABLE_PUSH = 0x2,
+	MAX_CONCURRENT_STREAMS = 0x3,
+	INITIAL_WINDOW_SIZE = 0x4,
+	MAX_FRAME_SIZE = 0x5,
+	MAX_HEADER_LIST_SIZE = 0x6,
+}
+setting_type;
+
+const char* FrameToString(frame_type f);
+const char* ErrorToString(error_type e);
+
+struct FrameHead {
+	uint32_t length;		// of the payload
+	frame_type type;
+	uint8_t flags;
+	uint32_t stream_id;
+
+	FrameHead() : length(0), type(frame::DATA), flags(0), stream_id(0) {}
+};
+
+// the FRAME_HEAD_BYTES at `data`
+void ParseFrameHead(const char* data, FrameHead& head);
+void SerializeFrameHead(char* out, uint32_t length, frame_type type, uint8_t flags, uint32_t stream_id);
+uint32_t ReadUint32(const char* data);
+
+/*
+* Writers, appending whole frames to `out`.
+*
+* notify :
+*	Payloads are not checked against the maximum frame size of the peer, except by
+*	WriteHeaders() which goes on in CONTINUATION frames.
+*/
+void WriteFrameHead(asio::DynamicBuffer& out, uint32_t length, frame_type type, uint8_t flags, uint32_t stream_id);
+void WriteSettings(asio::DynamicBuffer& out, const setting_type* ids, const uint32_t* values, size_t count);
+void WriteSettingsAck(asio::DynamicBuffer& out);
+void WritePing(asio::DynamicBuffer& out, const char payload[8], bool ack);
+void WriteGoaway(asio::DynamicBuffer& out, uint32_t last_stream_id, error_type code, StringView debug = StringView());
+void WriteRstStream(asio::DynamicBuffer& out, uint32_t stream_id, error_type code);
+void WriteWindowUpdate(asio::DynamicBuffer& out, uint32_t stream_id, uint32_t increment);
+void WriteData(asio::DynamicBuffer& out, uint32_t stream_id, StringView data, bool end_stream);
+void WriteHeaders(asio::DynamicBuffer& out, uint32_t stream_id, StringView block, bool end_stream,
+				  size_t max_frame_bytes = DEFAULT_MAX_FRAME_BYTES);
+
+}   // namespace http2
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP2_FRAME_H__
@@ -0,0 +1,816 @@
+#include "lcy/protocol/src/http2/hpack.h"
+
+#include <string.h>
+#include <deque>
+#include <unordered_map>
+
+namespace lcy {
+namespace protocol {
+namespace http2 {
+
+/*
+* Huffman code
+*/
+
+struct HuffmanCode {
+	uint32_t code;
+	uint8_t bits;
+};
+
+static const HuffmanCode HUFFMAN_CODES[256] = {
+	{ 0x00001ff8, 13 }, { 0x007fffd8, 23 }, { 0x0fffffe2, 28 }, { 0x0fffffe3, 28 },
+	{ 0x0fffffe4, 28 }, { 0x0fffffe5, 28 }, { 0x0fffffe6, 28 }, { 0x0fffffe7, 28 },
+	{ 0x0fffffe8, 28 }, { 0x00ffffea, 24 }, { 0x3ffffffc, 30 }, { 0x0fffffe9, 28 },
+	{ 0x0fffffea, 28 }, { 0x3ffffffd, 30 }, { 0x0fffffeb, 28 }, { 0x0fffffec, 28 },
+	{ 0x0fffffed, 28 }, { 0x0fffffee, 28 }, { 0x0fffffef, 28 }, { 0x0ffffff0, 28 },
+	{ 0x0ffffff1, 28 }, { 0x0ffffff2, 28 }, { 0x3ffffffe, 30 }, { 0x0ffffff3, 28 },
+	{ 0x0ffffff4, 28 }, { 0x0ffffff5, 28 }, { 0x0ffffff6, 28 }, { 0x0ffffff7, 28 },
+	{ 0x0ffffff8, 28 }, { 0x0ffffff9, 28 }, { 0x0ffffffa, 28 }, { 0x0ffffffb, 28 },
+	{ 0x00000014,  6 }, { 0x000003f8, 10 }, { 0x000003f9, 10 }, { 0x00000ffa, 12 },
+	{ 0x00001ff9, 13 }, { 0x00000015,  6 }, { 0x000000f8,  8 }, { 0x000007fa, 11 },
+	{ 0x000003fa, 10 }, { 0x000003fb, 10 }, { 0x000000f9,  8 }, { 0x000007fb, 11 },
+	{ 0x000000fa,  8 }, { 0x00000016,  6 }, { 0x00000017,  6 }, { 0x00000018,  6 },
+	{ 0x00000000,  5 }, { 0x00000001,  5 }, { 0x00000002,  5 }, { 0x00000019,  6 },
+	{ 0x0000001a,  6 }, { 0x0000001b,  6 }, { 0x0000001c,  6 }, { 0x0000001d,  6 },
+	{ 0x0000001e,  6 }, { 0x0000001f,  6 }, { 0x0000005c,  7 }, { 0x000000fb,  8 },
+	{ 0x00007ffc, 15 }, { 0x00000020,  6 }, { 0x00000ffb, 12 }, { 0x000003fc, 10 },
+	{ 0x00001ffa, 13 }, { 0x00000021,  6 }, { 0x0000005d,  7 }, { 0x0000005e,  7 },
+	{ 0x0000005f,  7 }, { 0x00000060,  7 }, { 0x00000061,  7 }, { 0x00000062,  7 },
+	{ 0x00000063,  7 }, { 0x00000064,  7 }, { 0x00000065,  7 }, { 0x00000066,  7 },
+	{ 0x00000067,  7 }, { 0x00000068,  7 }, { 0x00000069,  7 }, { 0x0000006a,  7 },
+	{ 0x0000006b,  7 }, { 0x0000006c,  7 }, { 0x0000006d,  7 }, { 0x0000006e,  7 },
+	{ 0x0000006f,  7 }, { 0x00000070,  7 }, { 0x00000071,  7 }, { 0x00000072,  7 },
+	{ 0x000000fc,  8 }, { 0x00000073,  7 }, { 0x000000fd,  8 }, { 0x00001ffb, 13 },
+	{ 0x0007fff0, 19 }, { 0x00001ffc, 13 }, { 0x00003ffc, 14 }, { 0x00000022,  6 },
+	{ 0x00007ffd, 15 }, { 0x00000003,  5 }, { 0x00000023,  6 }, { 0x00000004,  5 },
+	{ 0x00000024,  6 }, { 0x00000005,  5 }, { 0x00000025,  6 }, { 0x00000026,  6 },
+	{ 0x00000027,  6 }, { 0x00000006,  5 }, { 0x00000074,  7 }, { 0x00000075,  7 },
+	{ 0x00000028,  6 }, { 0x00000029,  6 }, { 0x0000002a,  6 }, { 0x00000007,  5 },
+	{ 0x0000002b,  6 }, { 0x00000076,  7 }, { 0x0000002c,  6 }, { 0x00000008,  5 },
+	{ 0x00000009,  5 }, { 0x0000002d,  6 }, { 0x00000077,  7 }, { 0x00000078,  7 },
+	{ 0x00000079,  7 }, { 0x0000007a,  7 }, { 0x0000007b,  7 }, { 0x00007ffe, 15 },
+	{ 0x000007fc, 11 }, { 0x00003ffd, 14 }, { 0x00001ffd, 13 }, { 0x0ffffffc, 28 },
+	{ 0x000fffe6, 20 }, { 0x003fffd2, 22 }, { 0x000fffe7, 20 }, { 0x000fffe8, 20 },
+	{ 0x003fffd3, 22 }, { 0x003fffd4, 22 }, { 0x003fffd5, 22 }, { 0x007fffd9, 23 },
+	{ 0x003fffd6, 22 }, { 0x007fffda, 23 }, { 0x007fffdb, 23 }, { 0x007fffdc, 23 },
+	{ 0x007fffdd, 23 }, { 0x007fffde, 23 }, { 0x00ffffeb, 24 }, { 0x007fffdf, 23 },
+	{ 0x00ffffec, 24 }, { 0x00ffffed, 24 }, { 0x003fffd7, 22 }, { 0x007fffe0, 23 },
+	{ 0x00ffffee, 24 }, { 0x007fffe1, 23 }, { 0x007fffe2, 23 }, { 0x007fffe3, 23 },
+	{ 0x007fffe4, 23 }, { 0x001fffdc, 21 }, { 0x003fffd8, 22 }, { 0x007fffe5, 23 },
+	{ 0x003fffd9, 22 }, { 0x007fffe6, 23 }, { 0x007fffe7, 23 }, { 0x00ffffef, 24 },
+	{ 0x003fffda, 22 }, { 0x001fffdd, 21 }, { 0x000fffe9, 20 }, { 0x003fffdb, 22 },
+	{ 0x003fffdc, 22 }, { 0x007fffe8, 23 }, { 0x007fffe9, 23 }, { 0x001fffde, 21 },
+	{ 0x007fffea, 23 }, { 0x003fffdd, 22 }, { 0x003fffde, 22 }, { 0x00fffff0, 24 },
+	{ 0x001fffdf, 21 }, { 0x003fffdf, 22 }, { 0x007fffeb, 23 }, { 0x007fffec, 23 },
+	{ 0x001fffe0, 21 }, { 0x001fffe1, 21 }, { 0x003fffe0, 22 }, { 0x001fffe2, 21 },
+	{ 0x007fffed, 23 }, { 0x003fffe1, 22 }, { 0x007fffee, 23 }, { 0x007fffef, 23 },
+	{ 0x000fffea, 20 }, { 0x003fffe2, 22 }, { 0x003fffe3, 22 }, { 0x003fffe4, 22 },
+	{ 0x007ffff0, 23 }, { 0x003fffe5, 22 }, { 0x003fffe6, 22 }, { 0x007ffff1, 23 },
+	{ 0x03ffffe0, 26 }, { 0x03ffffe1, 26 }, { 0x000fffeb, 20 }, { 0x0007fff1, 19 },
+	{ 0x003fffe7, 22 }, { 0x007ffff2, 23 }, { 0x003fffe8, 22 }, { 0x01ffffec, 25 },
+	{ 0x03ffffe2, 26 }, { 0x03ffffe3, 26 }, { 0x03ffffe4, 26 }, { 0x07ffffde, 27 },
+	{ 0x07ffffdf, 27 }, { 0x03ffffe5, 26 }, { 0x00fffff1, 24 }, { 0x01ffffed, 25 },
+	{ 0x0007fff2, 19 }, { 0x001fffe3, 21 }, { 0x03ffffe6, 26 }, { 0x07ffffe0, 27 },
+	{ 0x07ffffe1, 27 }, { 0x03ffffe7, 26 }, { 0x07ffffe2, 27 }, { 0x00fffff2, 24 },
+	{ 0x001fffe4, 21 }, { 0x001fffe5, 21 }, { 0x03ffffe8, 26 }, { 0x03ffffe9, 26 },
+	{ 0x0ffffffd, 28 }, { 0x07ffffe3, 27 }, { 0x07ffffe4, 27 }, { 0x07ffffe5, 27 },
+	{ 0x000fffec, 20 }, { 0x00fffff3, 24 }, { 0x000fffed, 20 }, { 0x001fffe6, 21 },
+	{ 0x003fffe9, 22 }, { 0x001fffe7, 21 }, { 0x001fffe8, 21 }, { 0x007ffff3, 23 },
+	{ 0x003fffea, 22 }, { 0x003fffeb, 22 }, { 0x01ffffee, 25 }, { 0x01ffffef, 25 },
+	{ 0x00fffff4, 24 }, { 0x00fffff5, 24 }, { 0x03ffffea, 26 }, { 0x007ffff4, 23 },
+	{ 0x03ffffeb, 26 }, { 0x07ffffe6, 27 }, { 0x03ffffec, 26 }, { 0x03ffffed, 26 },
+	{ 0x07ffffe7, 27 }, { 0x07ffffe8, 27 }, { 0x07ffffe9, 27 }, { 0x07ffffea, 27 },
+	{ 0x07ffffeb, 27 }, { 0x0ffffffe, 28 }, { 0x07ffffec, 27 }, { 0x07ffffed, 27 },
+	{ 0x07ffffee, 27 }, { 0x07ffffef, 27 }, { 0x07fffff0, 27 }, { 0x03ffffee, 26 },
+};
+
+static const HuffmanCode HUFFMAN_EOS = { 0x3fffffff, 30 };
+
+enum {
+	HUFFMAN_MAX_BITS = 30,
+	HUFFMAN_SYMBOL_EOS = 256,
+	HUFFMAN_FAST_BITS = 8,
+};
+
+/*
+* The code is canonical : the codes of one length are consecutive and left aligned
+* they are above every shorter one. Looking at the next HUFFMAN_MAX_BITS bits, the
+* length of the code is the first one whose limit is above them. Codes up to
+* HUFFMAN_FAST_BITS long ( the printable characters that matter most ) come from a
+* table indexed by the next byte.
+*/
+struct HuffmanDecodeTable {
+	uint32_t limit[HUFFMAN_MAX_BITS + 1];		// first code past those of the length, left aligned on 30 bits
+	uint32_t first[HUFFMAN_MAX_BITS + 1];		// first code of the length
+	uint16_t offset[HUFFMAN_MAX_BITS + 1];		// of its first symbol in `symbols`
+	uint16_t symbols[HUFFMAN_SYMBOL_EOS + 1];	// by length, then code
+	struct { uint16_t symbol; uint8_t bits; } fast[1 << HUFFMAN_FAST_BITS];
+
+	HuffmanDecodeTable()
+	{
+		size_t count[HUFFMAN_MAX_BITS + 1] = { 0 };
+		for ( size_t s = 0; s <= HUFFMAN_SYMBOL_EOS; ++s ) {
+			++count[code(s).bits];
+		}
+		uint32_t next = 0;
+		uint16_t at = 0;
+		for ( size_t len = 1; len <= HUFFMAN_MAX_BITS; ++len ) {
+			next <<= 1;
+			first[len] = next;
+			offset[len] = at;
+			next += (uint32_t)count[len];
+			at += (uint16_t)count[len];
+			limit[len] = next << (HUFFMAN_MAX_BITS - len);
+		}
+		uint16_t fill[HUFFMAN_MAX_BITS + 1];
+		::memcpy(fill, offset, sizeof(fill));
+		for ( size_t len = 1; len <= HUFFMAN_MAX_BITS; ++len ) {
+			// codes of a length rise with the symbol
+			for ( size_t s = 0; s <= HUFFMAN_SYMBOL_EOS; ++s ) {
+				if ( code(s).bits == len ) {
+					symbols[fill[len]++] = (uint16_t)s;
+				}
+			}
+		}
+		for ( size_t i = 0; i < (1u << HUFFMAN_FAST_BITS); ++i ) {
+			fast[i].symbol = 0;
+			fast[i].bits = 0;
+		}
+		for ( size_t s = 0; s < HUFFMAN_SYMBOL_EOS; ++s ) {
+			const HuffmanCode& c = HUFFMAN_CODES[s];
+			if ( c.bits <= HUFFMAN_FAST_BITS ) {
+				uint32_t from = c.code << (HUFFMAN_FAST_BITS - c.bits);
+				for ( uint32_t i = 0; i < (1u << (HUFFMAN_FAST_BITS - c.bits)); ++i ) {
+					fast[from + i].symbol = (uint16_t)s;
+					fast[from + i].bits = c.bits;
+				}
+			}
+		}
+	}
+
+	static const HuffmanCode& code(size_t symbol)
+	{
+		return symbol == HUFFMAN_SYMBOL_EOS ? HUFFMAN_EOS : HUFFMAN_CODES[symbol];
+	}
+};
+
+static const HuffmanDecodeTable& DecodeTable()
+{
+	static const HuffmanDecodeTable table;
+	return table;
+}
+
+size_t HuffmanEncodedLength(StringView data)
+{
+	size_t bits = 0;
+	for ( size_t i = 0; i < data.size(); ++i ) {
+		bits += HUFFMAN_CODES[(uint8_t)data[i]].bits;
+	}
+	return (bits + 7) / 8;
+}
+
+void HuffmanEncode(StringView data, std::string& out)
+{
+	uint64_t acc = 0;
+	size_t bits = 0;
+	for ( size_t i = 0; i < data.size(); ++i ) {
+		const HuffmanCode& c = HUFFMAN_CODES[(uint8_t)data[i]];
+		acc = (acc << c.bits) | c.code;
+		bits += c.bits;
+		while ( bits >= 8 ) {
+			bits -= 8;
+			out.push_back((char)(acc >> bits));
+		}
+	}
+	if ( bits > 0 ) {
+		// padded with the most significant bits of EOS
+		out.push_back((char)((acc << (8 - bits)) | (0xFF >> bits)));
+	}
+}
+
+bool HuffmanDecode(StringView data, std::string& out)
+{
+	const HuffmanDecodeTable& table = DecodeTable();
+	const uint8_t* p = (const uint8_t*)data.data();
+	const uint8_t* end = p + data.size();
+	uint64_t acc = 0;
+	size_t bits = 0;
+
+	for ( ;; ) {
+		while ( bits <= 56 && p < end ) {
+			acc = (acc << 8) | *p++;
+			bits += 8;
+		}
+		if ( bits == 0 ) {
+			return true;
+		}
+
+		uint32_t peek;
+		if ( bits >= HUFFMAN_MAX_BITS ) {
+			peek = (uint32_t)(acc >> (bits - HUFFMAN_MAX_BITS)) & 0x3FFFFFFF;
+		}
+		else {
+			// what is missing reads as ones, the padding
+			size_t missing = HUFFMAN_MAX_BITS - bits;
+			peek = (uint32_t)(((acc << missing) | ((1u << missing) - 1)) & 0x3FFFFFFF);
+		}
+
+		size_t len;
+		uint16_t symbol;
+		size_t top = peek >> (HUFFMAN_MAX_BITS - HUFFMAN_FAST_BITS);
+		if ( table.fast[top].bits != 0 ) {
+			len = table.fast[top].bits;
+			symbol = table.fast[top].symbol;
+		}
+		else {
+			len = HUFFMAN_FAST_BITS + 1;
+			while ( peek >= table.limit[len] ) {
+				++len;
+			}
+			uint32_t code = peek >> (HUFFMAN_MAX_BITS - len);
+			symbol = table.symbols[table.offset[len] + (code - table.first[len])];
+		}
+
+		if ( len > bits ) {
+			// the rest is padding : fewer than 8 bits, all ones
+			return bits < 8 && (acc & ((1u << bits) - 1)) == ((1u << bits) - 1);
+		}
+		if ( symbol == HUFFMAN_SYMBOL_EOS ) {
+			return false;
+		}
+		out.push_back((char)symbol);
+		bits -= len;
+	}
+}
+
+/*
+* Tables
+*/
+
+struct StaticEntry {
+	StringView name;
+	StringView value;
+};
+
+static const StaticEntry STATIC_TABLE[HPACK_STATIC_ENTRIES] = {
+	{ StringView(":authority", 10), StringView("", 0) },
+	{ StringView(":method", 7), StringView("GET", 3) },
+	{ StringView(":method", 7), StringView("POST", 4) },
+	{ StringView(":path", 5), StringView("/", 1) },
+	{ StringView(":path", 5), StringView("/index.html", 11) },
+	{ StringView(":scheme", 7), StringView("http", 4) },
+	{ StringView(":scheme", 7), StringView("https", 5) },
+	{ StringView(":status", 7), StringView("200", 3) },
+	{ StringView(":status", 7), StringView("204", 3) },
+	{ StringView(":status", 7), StringView("206", 3) },
+	{ StringView(":status", 7), StringView("304", 3) },
+	{ StringView(":status", 7), StringView("400", 3) },
+	{ StringView(":status", 7), StringView("404", 3) },
+	{ StringView(":status", 7), StringView("500", 3) },
+	{ StringView("accept-charset", 14), StringView("", 0) },
+	{ StringView("accept-encoding", 15), StringView("gzip, deflate", 13) },
+	{ StringView("accept-language", 15), StringView("", 0) },
+	{ StringView("accept-ranges", 13), StringView("", 0) },
+	{ StringView("accept", 6), StringView("", 0) },
+	{ StringView("access-control-allow-origin", 27), StringView("", 0) },
+	{ StringView("age", 3), StringView("", 0) },
+	{ StringView("allow", 5), StringView("", 0) },
+	{ StringView("authorization", 13), StringView("", 0) },
+	{ StringView("cache-control", 13), StringView("", 0) },
+	{ StringView("content-disposition", 19), StringView("", 0) },
+	{ StringView("content-encoding", 16), StringView("", 0) },
+	{ StringView("content-language", 16), StringView("", 0) },
+	{ StringView("content-length", 14), StringView("", 0) },
+	{ StringView("content-location", 16), StringView("", 0) },
+	{ StringView("content-range", 13), StringView("", 0) },
+	{ StringView("content-type", 12), StringView("", 0) },
+	{ StringView("cookie", 6), StringView("", 0) },
+	{ StringView("date", 4), StringView("", 0) },
+	{ StringView("etag", 4), StringView("", 0) },
+	{ StringView("expect", 6), StringView("", 0) },
+	{ StringView("expires", 7), StringView("", 0) },
+	{ StringView("from", 4), StringView("", 0) },
+	{ StringView("host", 4), StringView("", 0) },
+	{ StringView("if-match", 8), StringView("", 0) },
+	{ StringView("if-modified-since", 17), StringView("", 0) },
+	{ StringView("if-none-match", 13), StringView("", 0) },
+	{ StringView("if-range", 8), StringView("", 0) },
+	{ StringView("if-unmodified-since", 19), StringView("", 0) },
+	{ StringView("last-modified", 13), StringView("", 0) },
+	{ StringView("link", 4), StringView("", 0) },
+	{ StringView("location", 8), StringView("", 0) },
+	{ StringView("max-forwards", 12), StringView("", 0) },
+	{ StringView("proxy-authenticate", 18), StringView("", 0) },
+	{ StringView("proxy-authorization", 19), StringView("", 0) },
+	{ StringView("range", 5), StringView("", 0) },
+	{ StringView("referer", 7), StringView("", 0) },
+	{ StringView("refresh", 7), StringView("", 0) },
+	{ StringView("retry-after", 11), StringView("", 0) },
+	{ StringView("server", 6), StringView("", 0) },
+	{ StringView("set-cookie", 10), StringView("", 0) },
+	{ StringView("strict-transport-security", 25), StringView("", 0) },
+	{ StringView("transfer-encoding", 17), StringView("", 0) },
+	{ StringView("user-agent", 10), StringView("", 0) },
+	{ StringView("vary", 4), StringView("", 0) },
+	{ StringView("via", 3), StringView("", 0) },
+	{ StringView("www-authenticate", 16), StringView("", 0) },
+};
+
+static size_t EntryBytes(StringView name, StringView value)
+{
+	return name.size() + value.size() + HPACK_ENTRY_OVERHEAD;
+}
+
+struct DynamicEntry {
+	std::string name;
+	std::string value;
+
+	size_t bytes() const { return EntryBytes(name, value); }
+};
+
+static void EncodeInteger(std::string& out, uint64_t value, size_t prefix_bits, uint8_t pattern)
+{
+	uint64_t max = (1u << prefix_bits) - 1;
+	if ( value < max ) {
+		out.push_back((char)(pattern | value));
+		return;
+	}
+	out.push_back((char)(pattern | max));
+	value -= max;
+	while ( value >= 0x80 ) {
+		out.push_back((char)(0x80 | (value & 0x7F)));
+		value >>= 7;
+	}
+	out.push_back((char)value);
+}
+
+// false when the input ends first or the value does not fit 32 bits
+static bool DecodeInteger(const uint8_t*& p, const uint8_t* end, size_t prefix_bits, uint64_t& value)
+{
+	if ( p >= end ) {
+		return false;
+	}
+	uint64_t max = (1u << prefix_bits) - 1;
+	value = *p++ & max;
+	if ( value < max ) {
+		return true;
+	}
+	for ( size_t shift = 0; p < end; shift += 7 ) {
+		uint8_t b = *p++;
+		value += (uint64_t)(b & 0x7F) << shift;
+		if ( value > 0xFFFFFFFF ) {
+			return false;
+		}
+		if ( (b & 0x80) == 0 ) {
+			return true;
+		}
+		if ( shift >= 28 ) {
+			return false;
+		}
+	}
+	return false;
+}
+
+static void EncodeString(std::string& out, StringView data)
+{
+	size_t huffman = HuffmanEncodedLength(data);
+	if ( huffman < data.size() ) {
+		EncodeInteger(out, huffman, 7, 0x80);
+		HuffmanEncode(data, out);
+	}
+	else {
+		EncodeInteger(out, data.size(), 7, 0x00);
+		out.append(data.data(), data.size());
+	}
+}
+
+/*
+* HpackDecoder
+*/
+
+class HpackDecoder::Impl {
+public:
+	Impl() :
+		table_bytes_(0),
+		max_table_bytes_(DEFAULT_TABLE_BYTES),
+		settings_max_table_bytes_(DEFAULT_TABLE_BYTES)
+	{
+	}
+
+	enum {
+		DEFAULT_TABLE_BYTES = 4096,
+	};
+
+	bool decode(const char* data, size_t len, const field_handler_type& handler)
+	{
+		const uint8_t* p = (const uint8_t*)data;
+		const uint8_t* end = p + len;
+		bool fields = false;
+
+		while ( p < end ) {
+			uint8_t b = *p;
+			uint64_t index;
+			if ( b & 0x80 ) {
+				// indexed field
+				if ( !DecodeInteger(p, end, 7, index) || !entry(index, name_, value_) ) {
+					return false;
+				}
+				if ( !handler(name_, value_) ) {
+					return false;
+				}
+				fields = true;
+				continue;
+			}
+			if ( (b & 0xE0) == 0x20 ) {
+				// dynamic table size update, only ahead of the fields
+				uint64_t bytes;
+				if ( fields || !DecodeInteger(p, end, 5, bytes) || bytes > settings_max_table_bytes_ ) {
+					return false;
+				}
+				max_table_bytes_ = (size_t)bytes;
+				evict(0);
+				continue;
+			}
+
+			bool indexing = (b & 0xC0) == 0x40;
+			if ( !DecodeInteger(p, end, indexing ? 6 : 4, index) ) {
+				return false;
+			}
+			StringView name;
+			if ( index == 0 ) {
+				if ( !decodeString(p, end, name_buffer_, name) ) {
+					return false;
+				}
+			}
+			else {
+				StringView unused;
+				if ( !entry(index, name, unused) ) {
+					return false;
+				}
+			}
+			StringView value;
+			if ( !decodeString(p, end, value_buffer_, value) ) {
+				return false;
+			}
+
+			if ( indexing ) {
+				// `name` may be evicted on the way, go on with the copies
+				if ( insert(name, value) ) {
+					name = table_.front().name;
+					value = table_.front().value;
+				}
+				else {
+					name = name_buffer_;
+					value = value_buffer_;
+				}
+			}
+			if ( !handler(name, value) ) {
+				return false;
+			}
+			fields = true;
+		}
+		return true;
+	}
+
+	// the field at `index`, 1 based, static entries first
+	bool entry(uint64_t index, StringView& name, StringView& value) const
+	{
+		if ( index == 0 ) {
+			return false;
+		}
+		if ( index <= HPACK_STATIC_ENTRIES ) {
+			name = STATIC_TABLE[index - 1].name;
+			value = STATIC_TABLE[index - 1].value;
+			return true;
+		}
+		index -= HPACK_STATIC_ENTRIES + 1;
+		if ( index >= table_.size() ) {
+			return false;
+		}
+		name = table_[(size_t)index].name;
+		value = table_[(size_t)index].value;
+		return true;
+	}
+
+	bool decodeString(const uint8_t*& p, const uint8_t* end, std::string& buffer, StringView& result)
+	{
+		if ( p >= end ) {
+			return false;
+		}
+		bool huffman = (*p & 0x80) != 0;
+		uint64_t len;
+		if ( !DecodeInteger(p, end, 7, len) || len > (uint64_t)(end - p) ) {
+			return false;
+		}
+		StringView raw((const char*)p, (size_t)len);
+		p += len;
+		buffer.clear();
+		if ( huffman ) {
+			if ( !HuffmanDecode(raw, buffer) ) {
+				return false;
+			}
+			result = buffer;
+		}
+		else {
+			result = raw;
+		}
+		return true;
+	}
+
+	// false when the entry is larger than the table : it is emptied and the field copied to the buffers
+	bool insert(StringView name, StringView value)
+	{
+		size_t bytes = EntryBytes(name, value);
+		DynamicEntry e;
+		e.name.assign(name.data(), name.size());
+		e.value.assign(value.data(), value.size());
+		if ( bytes > max_table_bytes_ ) {
+			table_.clear();
+			table_bytes_ = 0;
+			name_buffer_.swap(e.name);
+			value_buffer_.swap(e.value);
+			return false;
+		}
+		evict(bytes);
+		table_bytes_ += bytes;
+		table_.push_front(std::move(e));
+		return true;
+	}
+
+	// makes room for `bytes` more
+	void evict(size_t bytes)
+	{
+		while ( !table_.empty() && table_bytes_ + bytes > max_table_bytes_ ) {
+			table_bytes_ -= table_.back().bytes();
+			table_.pop_back();
+		}
+	}
+
+
+	std::deque<DynamicEntry> table_;		// newest first
+	size_t table_bytes_;
+	size_t max_table_bytes_;
+	size_t settings_max_table_bytes_;
+	StringView name_;
+	StringView value_;
+	std::string name_buffer_;
+	std::string value_buffer_;
+};
+
+HpackDecoder::HpackDecoder() :
+	pImpl_(new Impl())
+{
+}
+
+HpackDecoder::~HpackDecoder()
+{
+}
+
+void HpackDecoder::setMaxTableBytes(size_t bytes)
+{
+	pImpl_->settings_max_table_bytes_ = bytes;
+	if ( pImpl_->max_table_bytes_ > bytes ) {
+		pImpl_->max_table_bytes_ = bytes;
+		pImpl_->evict(0);
+	}
+}
+
+bool HpackDecoder::decode(const char* data, size_t len, const field_handler_type& handler)
+{
+	return pImpl_->decode(data, len, handler);
+}
+
+size_t HpackDecoder::tableBytes() const
+{
+	return pImpl_->table_bytes_;
+}
+
+size_t HpackDecoder::tableEntries() const
+{
+	return pImpl_->table_.size();
+}
+
+/*
+* HpackEncoder
+*/
+
+namespace {
+
+struct StaticIndex {
+	std::unordered_map<std::string, size_t> fields;		// name '\0' value
+	std::unordered_map<std::string, size_t> names;		// the first entry of the name
+
+	StaticIndex()
+	{
+		for ( size_t i = HPACK_STATIC_ENTRIES; i > 0; --i ) {
+			const StaticEntry& e = STATIC_TABLE[i - 1];
+			std::string name = e.name.toString();
+			names[name] = i;
+			if ( !e.value.empty() ) {
+				fields[name + '\0' + e.value.toString()] = i;
+			}
+		}
+	}
+};
+
+const StaticIndex& GetStaticIndex()
+{
+	static const StaticIndex index;
+	return index;
+}
+
+bool IsSensitive(StringView name)
+{
+	return name == "authorization" || name == "proxy-authorization" || name == "cookie" || name == "set-cookie";
+}
+
+// fields whose values seldom come again would only push useful ones out
+bool IsIndexable(StringView name)
+{
+	return !(name == ":path" || name == "content-length" || name == "content-range" || name == "etag" ||
+			 name == "last-modified" || name == "location" || name == "if-none-match" || name == "if-modified-since");
+}
+
+}	// namespace
+
+class HpackEncoder::Impl {
+public:
+	enum {
+		MAX_TABLE_BYTES = 4096,
+	};
+
+	Impl() :
+		table_bytes_(0),
+		max_table_bytes_(MAX_TABLE_BYTES),
+		inserted_(0),
+		update_pending_(false),
+		smallest_update_(MAX_TABLE_BYTES)
+	{
+	}
+
+	void encode(StringView name, StringView value, std::string& out, bool sensitive)
+	{
+		if ( update_pending_ ) {
+			if ( smallest_update_ < max_table_bytes_ ) {
+				EncodeInteger(out, smallest_update_, 5, 0x20);
+			}
+			EncodeInteger(out, max_table_bytes_, 5, 0x20);
+			update_pending_ = false;
+		}
+
+		const StaticIndex& statics = GetStaticIndex();
+		key_.assign(name.data(), name.size());
+		key_.push_back('\0');
+		key_.append(value.data(), value.size());
+
+		std::unordered_map<std::string, size_t>::const_iterator hit = statics.fields.find(key_);
+		if ( hit != statics.fields.end() ) {
+			EncodeInteger(out, hit->second, 7, 0x80);
+			return;
+		}
+		sensitive = sensitive || IsSensitive(name);
+		if ( !sensitive ) {
+			size_t index = dynamicIndex(fields_, key_);
+			if ( index != 0 ) {
+				EncodeInteger(out, index, 7, 0x80);
+				return;
+			}
+		}
+
+		size_t name_index = 0;
+		key_.resize(name.size());
+		hit = statics.names.find(key_);
+		if ( hit != statics.names.end() ) {
+			name_index = hit->second;
+		}
+		else {
+			name_index = dynamicIndex(names_, key_);
+		}
+
+		bool indexing = false;
+		if ( sensitive ) {
+			EncodeInteger(out, name_index, 4, 0x10);
+		}
+		else if ( IsIndexable(name) && EntryBytes(name, value) * 4 <= max_table_bytes_ ) {
+			EncodeInteger(out, name_index, 6, 0x40);
+			indexing = true;
+		}
+		else {
+			EncodeInteger(out, name_index, 4, 0x00);
+		}
+		if ( name_index == 0 ) {
+			EncodeString(out, name);
+		}
+		EncodeString(out, value);
+
+		if ( indexing ) {
+			insert(name, value);
+		}
+	}
+
+	// index of a live entry of the dynamic table, 0 if none
+	size_t dynamicIndex(const std::unordered_map<std::string, uint64_t>& map, const std::string& key) const
+	{
+		std::unordered_map<std::string, uint64_t>::const_iterator it = map.find(key);
+		if ( it == map.end() || it->second < inserted_ - table_.size() ) {
+			return 0;
+		}
+		return HPACK_STATIC_ENTRIES + 1 + (size_t)(inserted_ - 1 - it->second);
+	}
+
+	void insert(StringView name, StringView value)
+	{
+		size_t bytes = EntryBytes(name, value);
+		evict(bytes);
+		DynamicEntry e;
+		e.name.assign(name.data(), name.size());
+		e.value.assign(value.data(), value.size());
+		table_bytes_ += bytes;
+		table_.push_front(std::move(e));
+
+		uint64_t seq = inserted_++;
+		names_[table_.front().name] = seq;
+		key_.assign(table_.front().name);
+		key_.push_back('\0');
+		key_.append(table_.front().value);
+		fields_[key_] = seq;
+	}
+
+	void evict(size_t bytes)
+	{
+		while ( !table_.empty() && table_bytes_ + bytes > max_table_bytes_ ) {
+			const DynamicEntry& e = table_.back();
+			uint64_t seq = inserted_ - table_.size();
+			std::unordered_map<std::string, uint64_t>::iterator it = names_.find(e.name);
+			if ( it != names_.end() && it->second == seq ) {
+				names_.erase(it);
+			}
+			std::string key = e.name;
+			key.push_back('\0');
+			key.append(e.value);
+			it = fields_.find(key);
+			if ( it != fields_.end() && it->second == seq ) {
+				fields_.erase(it);
+			}
+			table_bytes_ -= e.bytes();
+			table_.pop_back();
+		}
+	}
+
+	std::deque<DynamicEntry> table_;		// newest first
+	size_t table_bytes_;
+	size_t max_table_bytes_;
+	uint64_t inserted_;						// entries ever added, the sequence of the next one
+	std::unordered_map<std::string, uint64_t> fields_;	// name '\0' value : sequence of the newest entry
+	std::unordered_map<std::string, uint64_t> names_;
+	bool update_pending_;
+	size_t smallest_update_;
+	std::string key_;
+};
+
+HpackEncoder::HpackEncoder() :
+	pImpl_(new Impl())
+{
+}
+
+HpackEncoder::~HpackEncoder()
+{
+}
+
+void HpackEncoder::setMaxTableBytes(size_t bytes)
+{
+	if ( bytes > Impl::MAX_TABLE_BYTES ) {
+		bytes = Impl::MAX_TABLE_BYTES;
+	}
+	if ( bytes == pImpl_->max_table_bytes_ && !pImpl_->update_pending_ ) {
+		return;
+	}
+	if ( !pImpl_->update_pending_ ) {
+		pImpl_->smallest_update_ = bytes;
+	}
+	else if ( bytes < pImpl_->smallest_update_ ) {
+		pImpl_->smallest_update_ = bytes;
+	}
+	pImpl_->update_pending_ = true;
+	pImpl_->max_table_bytes_ = bytes;
+	pImpl_->evict(0);
+}
+
+void HpackEncoder::encode(StringView name, StringView value, std::string& out, bool sensitive)
+{
+	pImpl_->encode(name, value, out, sensitive);
+}
+
+size_t HpackEncoder::tableBytes() const
+{
+	return pImpl_->table_bytes_;
+}
+
+size_t HpackEncoder::tableEntries() const
+{
+	return pImpl_->table_.size();
+}
+
+}   // namespace http2
+}   // namespace protocol
+}	// namespace lcy
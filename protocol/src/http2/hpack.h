@@ -0,0 +1,103 @@
+#ifndef __LCY_PROTOCOL_HTTP2_HPACK_H__
+#define __LCY_PROTOCOL_HTTP2_HPACK_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string>
+#include <memory>
+#include <functional>
+
+#include "lcy/protocol/src/string_view.h"
+
+namespace lcy {
+namespace protocol {
+namespace http2 {
+
+/*
+* HPACK ( RFC 7541 ), the header compression of HTTP/2.
+*/
+
+enum {
+	HPACK_STATIC_ENTRIES = 61,
+	HPACK_ENTRY_OVERHEAD = 32,		// counted per dynamic table entry besides its name and value
+};
+
+// the Huffman code of appendix B
+size_t HuffmanEncodedLength(StringView data);
+void HuffmanEncode(StringView data, std::string& out);				// appends
+bool HuffmanDecode(StringView data, std::string& out);				// appends, false on a malformed code
+
+/*
+* Decoder of header blocks, keeping the dynamic table between them.
+*
+* notify :
+*	`name` and `value` given to the handler are only valid during the call. Names
+*	are passed as they are : HTTP/2 requires them in lower case, checking that is
+*	left to the caller.
+*	Any error is a COMPRESSION_ERROR of the connection : the table can no longer be
+*	trusted.
+*/
+class HpackDecoder {
+public:
+	// false stops decoding and fails it
+	typedef std::function<bool (StringView name, StringView value)> field_handler_type;
+
+	HpackDecoder();
+	~HpackDecoder();
+
+	// the most a size update of the encoder may ask for, what SETTINGS_HEADER_TABLE_SIZE announced
+	void setMaxTableBytes(size_t bytes);
+
+	bool decode(const char* data, size_t len, const field_handler_type& handler);
+
+	size_t tableBytes() const;
+	size_t tableEntries() const;
+
+private:
+	HpackDecoder(const HpackDecoder&);
+	HpackDecoder& operator=(const HpackDecoder&);
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> pImpl_;
+};
+
+/*
+* Encoder of header blocks.
+*
+* Fields found whole in the static or the dynamic table go as one index, others are
+* added to the dynamic table unless their values seldom repeat ( content-length, etag,
+* :path ... ). Sensitive ones ( set-cookie, cookie, authorization, or asked for ) are
+* sent as never indexed literals. Strings are Huffman coded when it makes them shorter.
+*
+* notify :
+*	`name` must be lower case.
+*/
+class HpackEncoder {
+public:
+	HpackEncoder();
+	~HpackEncoder();
+
+	// from the SETTINGS_HEADER_TABLE_SIZE of the peer, the table never grows past 4096 bytes
+	void setMaxTableBytes(size_t bytes);
+
+	// appends the representation of one field to the block in `out`
+	void encode(StringView name, StringView value, std::string& out, bool sensitive = false);
+
+	size_t tableBytes() const;
+	size_t tableEntries() const;
+
+private:
+	HpackEncoder(const HpackEncoder&);
+	HpackEncoder& operator=(const HpackEncoder&);
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> pImpl_;
+};
+
+}   // namespace http2
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP2_HPACK_H__
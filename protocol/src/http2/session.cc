@@ -0,0 +1,971 @@
+#include "lcy/protocol/src/http2/session.h"
+#include "lcy/protocol/src/http2/frame.h"
+#include "lcy/protocol/src/http2/hpack.h"
+#include "lcy/protocol/src/http/request_view.h"
+#include "lcy/protocol/src/http/response.h"
+#include "lcy/protocol/src/http/open_file.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace http2 {
+
+namespace {
+
+typedef http::RequestView::slice_type slice_type;
+
+enum pseudo_flag {
+	PSEUDO_METHOD = 0x1,
+	PSEUDO_SCHEME = 0x2,
+	PSEUDO_PATH = 0x4,
+	PSEUDO_AUTHORITY = 0x8,
+};
+
+/*
+* One request and its response. The names and values of the request are copied to
+* `arena` as they are decoded, the view refers into it.
+*/
+struct Stream {
+	uint32_t id;
+	bool end_remote;			// END_STREAM received
+	bool responded;				// HEADERS of the response sent
+	bool queued;				// in the send queue
+	bool head_only;
+	bool malformed;
+	bool regular;				// a regular field came, no pseudo field may follow
+	uint8_t pseudo;
+	http::state_type reject;	// answered by the session, INVALID : by the handler
+	size_t header_bytes;
+
+	std::string arena;
+	slice_type method;
+	slice_type path;
+	slice_type authority;
+	bool has_host;
+	std::vector<std::pair<slice_type, slice_type> > fields;
+	std::vector<slice_type> cookies;
+	std::string body;
+
+	int64_t send_window;
+	int64_t recv_window;
+	uint32_t recv_unacked;
+
+	http::Response response;
+	size_t send_offset;
+	size_t send_left;
+
+	void reset(uint32_t stream_id, int64_t window, int64_t receive_window)
+	{
+		id = stream_id;
+		end_remote = false;
+		responded = false;
+		queued = false;
+		head_only = false;
+		malformed = false;
+		regular = false;
+		pseudo = 0;
+		reject = http::state::INVALID;
+		header_bytes = 0;
+		arena.clear();
+		method = slice_type();
+		path = slice_type();
+		authority = slice_type();
+		has_host = false;
+		fields.clear();
+		cookies.clear();
+		body.clear();
+		send_window = window;
+		recv_window = receive_window;
+		recv_unacked = 0;
+		response.clear();
+		send_offset = 0;
+		send_left = 0;
+	}
+};
+
+slice_type Copy(std::string& arena, StringView data)
+{
+	slice_type slice(arena.size(), data.size());
+	arena.append(data.data(), data.size());
+	return slice;
+}
+
+StringView Resolve(const std::string& arena, slice_type slice)
+{
+	return StringView(arena.data() + slice.offset, slice.length);
+}
+
+bool HasUpper(StringView name)
+{
+	for ( size_t i = 0; i < name.size(); ++i ) {
+		if ( name[i] >= 'A' && name[i] <= 'Z' ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// fields of HTTP/1 connections, malformed in a request, dropped from a response
+bool IsConnectionSpecific(StringView name)
+{
+	return name.iequals("connection") || name.iequals("keep-alive") || name.iequals("proxy-connection") ||
+		   name.iequals("transfer-encoding") || name.iequals("upgrade");
+}
+
+}	// namespace
+
+class ServerSession::Impl {
+public:
+	// what a header block being received is for
+	enum block_type {
+		BLOCK_REQUEST,
+		BLOCK_TRAILERS,
+		BLOCK_IGNORED,		// refused or closed stream : decoded for the table only
+	};
+
+	Impl(handler_type handler) :
+		handler_(std::move(handler)),
+		max_concurrent_(DEFAULT_MAX_CONCURRENT_STREAMS),
+		max_body_bytes_(0),
+		max_header_list_bytes_(DEFAULT_MAX_HEADER_LIST_BYTES),
+		block_stream_(0),
+		block_type_(BLOCK_IGNORED),
+		block_end_stream_(false),
+		last_stream_id_(0),
+		send_window_(DEFAULT_WINDOW_BYTES),
+		recv_window_(RECEIVE_WINDOW_BYTES),
+		recv_unacked_(0),
+		peer_initial_window_(DEFAULT_WINDOW_BYTES),
+		peer_max_frame_(DEFAULT_MAX_FRAME_BYTES),
+		pending_bytes_(0),
+		preface_(false),
+		settings_(false),
+		over_(false),
+		goaway_sent_(false),
+		goaway_received_(false)
+	{
+	}
+
+	void start(asio::DynamicBuffer& out)
+	{
+		const setting_type ids[] = {
+			setting::MAX_CONCURRENT_STREAMS,
+			setting::INITIAL_WINDOW_SIZE,
+			setting::MAX_HEADER_LIST_SIZE,
+		};
+		const uint32_t values[] = {
+			max_concurrent_,
+			RECEIVE_WINDOW_BYTES,
+			(uint32_t)max_header_list_bytes_,
+		};
+		WriteSettings(out, ids, values, sizeof(ids) / sizeof(ids[0]));
+		WriteWindowUpdate(out, 0, RECEIVE_WINDOW_BYTES - DEFAULT_WINDOW_BYTES);
+	}
+
+	size_t receive(const char* data, size_t len, asio::DynamicBuffer& out)
+	{
+		if ( over_ ) {
+			return len;
+		}
+
+		size_t at = 0;
+		if ( !preface_ ) {
+			size_t n = std::min<size_t>(len, CLIENT_PREFACE_BYTES);
+			if ( ::memcmp(data, CLIENT_PREFACE, n) != 0 ) {
+				fail(error::PROTOCOL_ERROR, out);
+				return len;
+			}
+			if ( n < CLIENT_PREFACE_BYTES ) {
+				return 0;
+			}
+			preface_ = true;
+			at = CLIENT_PREFACE_BYTES;
+		}
+
+		while ( !over_ && len - at >= FRAME_HEAD_BYTES ) {
+			FrameHead head;
+			ParseFrameHead(data + at, head);
+			if ( head.length > DEFAULT_MAX_FRAME_BYTES ) {
+				fail(error::FRAME_SIZE_ERROR, out);
+				break;
+			}
+			if ( len - at - FRAME_HEAD_BYTES < head.length ) {
+				break;
+			}
+			onFrame(head, data + at + FRAME_HEAD_BYTES, out);
+			at += FRAME_HEAD_BYTES + head.length;
+		}
+		return over_ ? len : at;
+	}
+
+	void onFrame(const FrameHead& head, const char* payload, asio::DynamicBuffer& out)
+	{
+		if ( !settings_ ) {
+			if ( head.type != frame::SETTINGS || (head.flags & FLAG_ACK) ) {
+				fail(error::PROTOCOL_ERROR, out);
+				return;
+			}
+			settings_ = true;
+		}
+		if ( block_stream_ != 0 && (head.type != frame::CONTINUATION || head.stream_id != block_stream_) ) {
+			fail(error::PROTOCOL_ERROR, out);
+			return;
+		}
+
+		switch ( head.type ) {
+			case frame::DATA : onData(head, payload, out); break;
+			case frame::HEADERS : onHeaders(head, payload, out); break;
+			case frame::PRIORITY : onPriority(head, out); break;
+			case frame::RST_STREAM : onRstStream(head, out); break;
+			case frame::SETTINGS : onSettings(head, payload, out); break;
+			case frame::PUSH_PROMISE : fail(error::PROTOCOL_ERROR, out); break;
+			case frame::PING : onPing(head, payload, out); break;
+			case frame::GOAWAY : onGoaway(head, out); break;
+			case frame::WINDOW_UPDATE : onWindowUpdate(head, payload, out); break;
+			case frame::CONTINUATION : onContinuation(head, payload, out); break;
+			default : break;		// unknown types are ignored
+		}
+	}
+
+	// the payload without its padding, false on a connection error
+	bool unpad(const FrameHead& head, const char*& payload, size_t& len, asio::DynamicBuffer& out)
+	{
+		len = head.length;
+		if ( head.flags & FLAG_PADDED ) {
+			if ( len < 1 || (uint8_t)payload[0] >= len ) {
+				fail(error::PROTOCOL_ERROR, out);
+				return false;
+			}
+			len -= 1 + (uint8_t)payload[0];
+			payload += 1;
+		}
+		return true;
+	}
+
+	void onData(const FrameHead& head, const char* payload, asio::DynamicBuffer& out)
+	{
+		if ( head.stream_id == 0 || head.stream_id > last_stream_id_ ) {
+			fail(error::PROTOCOL_ERROR, out);
+			return;
+		}
+		size_t len;
+		if ( !unpad(head, payload, len, out) ) {
+			return;
+		}
+
+		// the whole frame counts, padding included
+		recv_window_ -= head.length;
+		if ( recv_window_ < 0 ) {
+			fail(error::FLOW_CONTROL_ERROR, out);
+			return;
+		}
+		recv_unacked_ += head.length;
+		if ( recv_unacked_ >= RECEIVE_WINDOW_BYTES / 2 ) {
+			WriteWindowUpdate(out, 0, recv_unacked_);
+			recv_window_ += recv_unacked_;
+			recv_unacked_ = 0;
+		}
+
+		// a stream already reset may still have frames on the way
+		Stream* s = find(head.stream_id);
+		if ( s == nullptr ) {
+			return;
+		}
+		if ( s->end_remote ) {
+			resetStream(*s, error::STREAM_CLOSED, out);
+			return;
+		}
+		s->recv_window -= head.length;
+		if ( s->recv_window < 0 ) {
+			resetStream(*s, error::FLOW_CONTROL_ERROR, out);
+			return;
+		}
+		if ( s->responded ) {
+			return;
+		}
+
+		if ( max_body_bytes_ > 0 && s->body.size() + len > max_body_bytes_ ) {
+			s->reject = http::state::PAYLOAD_TOO_LARGE;
+			dispatch(*s, out);
+			return;
+		}
+		s->body.append(payload, len);
+
+		if ( head.flags & FLAG_END_STREAM ) {
+			s->end_remote = true;
+			dispatch(*s, out);
+			return;
+		}
+		s->recv_unacked += head.length;
+		if ( s->recv_unacked >= RECEIVE_WINDOW_BYTES / 2 ) {
+			WriteWindowUpdate(out, s->id, s->recv_unacked);
+			s->recv_window += s->recv_unacked;
+			s->recv_unacked = 0;
+		}
+	}
+
+	void onHeaders(const FrameHead& head, const char* payload, asio::DynamicBuffer& out)
+	{
+		if ( head.stream_id == 0 || (head.stream_id & 1) == 0 ) {
+			fail(error::PROTOCOL_ERROR, out);
+			return;
+		}
+		size_t len;
+		if ( !unpad(head, payload, len, out) ) {
+			return;
+		}
+		if ( head.flags & FLAG_PRIORITY ) {
+			// dependency and weight, priorities are not used
+			if ( len < 5 ) {
+				fail(error::FRAME_SIZE_ERROR, out);
+				return;
+			}
+			payload += 5;
+			len -= 5;
+		}
+
+		if ( head.stream_id > last_stream_id_ ) {
+			last_stream_id_ = head.stream_id;
+			if ( goaway_sent_ || streams_.size() >= max_concurrent_ ) {
+				WriteRstStream(out, head.stream_id, error::REFUSED_STREAM);
+				block_type_ = BLOCK_IGNORED;
+			}
+			else {
+				open(head.stream_id);
+				block_type_ = BLOCK_REQUEST;
+			}
+		}
+		else {
+			Stream* s = find(head.stream_id);
+			if ( s != nullptr && !s->end_remote && !s->responded ) {
+				if ( (head.flags & FLAG_END_STREAM) == 0 ) {
+					fail(error::PROTOCOL_ERROR, out);
+					return;
+				}
+				block_type_ = BLOCK_TRAILERS;
+			}
+			else {
+				block_type_ = BLOCK_IGNORED;
+			}
+		}
+
+		block_.assign(payload, len);
+		block_end_stream_ = (head.flags & FLAG_END_STREAM) != 0;
+		if ( head.flags & FLAG_END_HEADERS ) {
+			finishBlock(head.stream_id, out);
+		}
+		else {
+			block_stream_ = head.stream_id;
+		}
+	}
+
+	void onContinuation(const FrameHead& head, const char* payload, asio::DynamicBuffer& out)
+	{
+		if ( block_stream_ == 0 ) {
+			fail(error::PROTOCOL_ERROR, out);
+			return;
+		}
+		// past the limit the fields decode to more anyway, this only stops a flood
+		if ( block_.size() + head.length > max_header_list_bytes_ + DEFAULT_MAX_FRAME_BYTES ) {
+			fail(error::ENHANCE_YOUR_CALM, out);
+			return;
+		}
+		block_.append(payload, head.length);
+		if ( head.flags & FLAG_END_HEADERS ) {
+			uint32_t id = block_stream_;
+			block_stream_ = 0;
+			finishBlock(id, out);
+		}
+	}
+
+	void finishBlock(uint32_t id, asio::DynamicBuffer& out)
+	{
+		Stream* s = block_type_ == BLOCK_IGNORED ? nullptr : find(id);
+		bool trailers = block_type_ == BLOCK_TRAILERS;
+
+		bool decoded = decoder_.decode(block_.data(), block_.size(), [&](StringView name, StringView value){
+			if ( s != nullptr ) {
+				addField(*s, name, value, trailers);
+			}
+			return true;
+		});
+		if ( !decoded ) {
+			fail(error::COMPRESSION_ERROR, out);
+			return;
+		}
+		if ( s == nullptr ) {
+			return;
+		}
+
+		if ( !trailers && s->reject == http::state::INVALID ) {
+			bool complete = (s->pseudo & PSEUDO_METHOD) &&
+							(s->pseudo & PSEUDO_SCHEME) &&
+							(s->pseudo & PSEUDO_PATH) && s->path.length > 0;
+			if ( !complete ) {
+				s->malformed = true;
+			}
+		}
+		if ( s->malformed ) {
+			resetStream(*s, error::PROTOCOL_ERROR, out);
+			return;
+		}
+
+		if ( block_end_stream_ ) {
+			s->end_remote = true;
+		}
+		if ( s->end_remote || s->reject != http::state::INVALID ) {
+			dispatch(*s, out);
+		}
+	}
+
+	void addField(Stream& s, StringView name, StringView value, bool trailers)
+	{
+		s.header_bytes += name.size() + value.size() + HPACK_ENTRY_OVERHEAD;
+		if ( s.header_bytes > max_header_list_bytes_ ) {
+			s.reject = http::state::REQUEST_HEADER_FIELDS_TOO_LARGE;
+		}
+		if ( s.malformed || s.reject != http::state::INVALID ) {
+			return;
+		}
+		if ( name.empty() ) {
+			s.malformed = true;
+			return;
+		}
+
+		if ( name[0] == ':' ) {
+			uint8_t flag = 0;
+			if ( name == ":method" ) {
+				flag = PSEUDO_METHOD;
+				s.method = Copy(s.arena, value);
+			} else if ( name == ":scheme" ) {
+				flag = PSEUDO_SCHEME;
+			} else if ( name == ":path" ) {
+				flag = PSEUDO_PATH;
+				s.path = Copy(s.arena, value);
+			} else if ( name == ":authority" ) {
+				flag = PSEUDO_AUTHORITY;
+				s.authority = Copy(s.arena, value);
+			}
+			// unknown, repeated, after a regular field or in trailers
+			if ( flag == 0 || (s.pseudo & flag) || s.regular || trailers ) {
+				s.malformed = true;
+			}
+			s.pseudo |= flag;
+			return;
+		}
+
+		s.regular = true;
+		if ( HasUpper(name) || IsConnectionSpecific(name) || (name == "te" && value != "trailers") ) {
+			s.malformed = true;
+			return;
+		}
+		if ( trailers ) {
+			return;
+		}
+		if ( name == "cookie" ) {
+			s.cookies.push_back(Copy(s.arena, value));
+			return;
+		}
+		if ( name == "host" ) {
+			s.has_host = true;
+		}
+		slice_type key = Copy(s.arena, name);
+		s.fields.push_back(std::make_pair(key, Copy(s.arena, value)));
+	}
+
+	void onPriority(const FrameHead& head, asio::DynamicBuffer& out)
+	{
+		if ( head.stream_id == 0 ) {
+			fail(error::PROTOCOL_ERROR, out);
+			return;
+		}
+		if ( head.length != 5 ) {
+			WriteRstStream(out, head.stream_id, error::FRAME_SIZE_ERROR);
+			closeStream(head.stream_id);
+		}
+	}
+
+	void onRstStream(const FrameHead& head, asio::DynamicBuffer& out)
+	{
+		if ( head.stream_id == 0 || head.stream_id > last_stream_id_ ) {
+			fail(error::PROTOCOL_ERROR, out);
+			return;
+		}
+		if ( head.length != 4 ) {
+			fail(error::FRAME_SIZE_ERROR, out);
+			return;
+		}
+		closeStream(head.stream_id);
+	}
+
+	void onSettings(const FrameHead& head, const char* payload, asio::DynamicBuffer& out)
+	{
+		if ( head.stream_id != 0 ) {
+			fail(error::PROTOCOL_ERROR, out);
+			return;
+		}
+		if ( head.flags & FLAG_ACK ) {
+			if ( head.length != 0 ) {
+				fail(error::FRAME_SIZE_ERROR, out);
+			}
+			return;
+		}
+		if ( head.length % 6 != 0 ) {
+			fail(error::FRAME_SIZE_ERROR, out);
+			return;
+		}
+
+		for ( size_t at = 0; at < head.length; at += 6 ) {
+			uint16_t id = (uint16_t)(((uint8_t)payload[at] << 8) | (uint8_t)payload[at + 1]);
+			uint32_t value = ReadUint32(payload + at + 2);
+			switch ( (setting_type)id ) {
+				case setting::HEADER_TABLE_SIZE :
+					encoder_.setMaxTableBytes(value);
+					break;
+				case setting::ENABLE_PUSH :
+					if ( value > 1 ) {
+						fail(error::PROTOCOL_ERROR, out);
+						return;
+					}
+					break;
+				case setting::INITIAL_WINDOW_SIZE :
+					if ( value > MAX_WINDOW_BYTES || !setInitialWindow(value) ) {
+						fail(error::FLOW_CONTROL_ERROR, out);
+						return;
+					}
+					break;
+				case setting::MAX_FRAME_SIZE :
+					if ( value < DEFAULT_MAX_FRAME_BYTES || value > MAX_FRAME_BYTES_LIMIT ) {
+						fail(error::PROTOCOL_ERROR, out);
+						return;
+					}
+					peer_max_frame_ = value;
+					break;
+				default :
+					break;		// the limits of the peer on what it receives from us do not matter here
+			}
+		}
+		WriteSettingsAck(out);
+	}
+
+	// applies the difference to every stream, false when a window overflows
+	bool setInitialWindow(uint32_t value)
+	{
+		int64_t delta = (int64_t)value - peer_initial_window_;
+		peer_initial_window_ = value;
+		for ( auto& kv : streams_ ) {
+			Stream& s = *kv.second;
+			s.send_window += delta;
+			if ( s.send_window > MAX_WINDOW_BYTES ) {
+				return false;
+			}
+			enqueue(s);
+		}
+		return true;
+	}
+
+	void onPing(const FrameHead& head, const char* payload, asio::DynamicBuffer& out)
+	{
+		if ( head.stream_id != 0 ) {
+			fail(error::PROTOCOL_ERROR, out);
+			return;
+		}
+		if ( head.length != 8 ) {
+			fail(error::FRAME_SIZE_ERROR, out);
+			return;
+		}
+		if ( (head.flags & FLAG_ACK) == 0 ) {
+			WritePing(out, payload, true);
+		}
+	}
+
+	void onGoaway(const FrameHead& head, asio::DynamicBuffer& out)
+	{
+		if ( head.stream_id != 0 ) {
+			fail(error::PROTOCOL_ERROR, out);
+			return;
+		}
+		if ( head.length < 8 ) {
+			fail(error::FRAME_SIZE_ERROR, out);
+			return;
+		}
+		goaway_received_ = true;
+	}
+
+	void onWindowUpdate(const FrameHead& head, const char* payload, asio::DynamicBuffer& out)
+	{
+		if ( head.length != 4 ) {
+			fail(error::FRAME_SIZE_ERROR, out);
+			return;
+		}
+		uint32_t increment = ReadUint32(payload) & 0x7FFFFFFF;
+
+		if ( head.stream_id == 0 ) {
+			if ( increment == 0 ) {
+				fail(error::PROTOCOL_ERROR, out);
+				return;
+			}
+			send_window_ += increment;
+			if ( send_window_ > MAX_WINDOW_BYTES ) {
+				fail(error::FLOW_CONTROL_ERROR, out);
+			}
+			return;
+		}
+
+		if ( head.stream_id > last_stream_id_ ) {
+			fail(error::PROTOCOL_ERROR, out);
+			return;
+		}
+		Stream* s = find(head.stream_id);
+		if ( s == nullptr ) {
+			return;
+		}
+		if ( increment == 0 ) {
+			resetStream(*s, error::PROTOCOL_ERROR, out);
+			return;
+		}
+		s->send_window += increment;
+		if ( s->send_window > MAX_WINDOW_BYTES ) {
+			resetStream(*s, error::FLOW_CONTROL_ERROR, out);
+			return;
+		}
+		enqueue(*s);
+	}
+
+	/*
+	* Streams
+	*/
+
+	Stream* find(uint32_t id)
+	{
+		auto it = streams_.find(id);
+		return it == streams_.end() ? nullptr : it->second.get();
+	}
+
+	Stream& open(uint32_t id)
+	{
+		std::unique_ptr<Stream> s;
+		if ( !free_.empty() ) {
+			s = std::move(free_.back());
+			free_.pop_back();
+		}
+		else {
+			s.reset(new Stream());
+		}
+		s->reset(id, peer_initial_window_, RECEIVE_WINDOW_BYTES);
+		Stream& ref = *s;
+		streams_[id] = std::move(s);
+		return ref;
+	}
+
+	void closeStream(uint32_t id)
+	{
+		auto it = streams_.find(id);
+		if ( it == streams_.end() ) {
+			return;
+		}
+		pending_bytes_ -= it->second->send_left;
+		it->second->response.clear();		// lets go of a file
+		if ( free_.size() < DEFAULT_MAX_CONCURRENT_STREAMS ) {
+			free_.push_back(std::move(it->second));
+		}
+		streams_.erase(it);
+	}
+
+	void resetStream(Stream& s, error_type code, asio::DynamicBuffer& out)
+	{
+		WriteRstStream(out, s.id, code);
+		closeStream(s.id);
+	}
+
+	void enqueue(Stream& s)
+	{
+		if ( s.send_left > 0 && s.send_window > 0 && !s.queued ) {
+			s.queued = true;
+			queue_.push_back(s.id);
+		}
+	}
+
+	/*
+	* Responses
+	*/
+
+	void dispatch(Stream& s, asio::DynamicBuffer& out)
+	{
+		s.response.setVersion(http::version::HTTP_2);
+		s.response.setState(http::state::OK);
+		if ( s.reject != http::state::INVALID ) {
+			s.response.setState(s.reject);
+			respond(s, out);
+			return;
+		}
+
+		http::method_type method = http::StringToMethod(s.arena.data() + s.method.offset, s.method.length);
+		if ( method == http::method::INVALID ) {
+			s.response.setState(http::state::NOT_IMPLEMENTED);
+			respond(s, out);
+			return;
+		}
+		s.head_only = method == http::method::HEAD;
+
+		// everything is in the arena before the view binds it
+		if ( s.authority.length > 0 && !s.has_host ) {
+			slice_type key = Copy(s.arena, "host");
+			s.fields.push_back(std::make_pair(key, s.authority));
+		}
+		if ( !s.cookies.empty() ) {
+			slice_type key = Copy(s.arena, "cookie");
+			slice_type value = s.cookies[0];
+			if ( s.cookies.size() > 1 ) {
+				value = slice_type(s.arena.size(), 0);
+				for ( size_t i = 0; i < s.cookies.size(); ++i ) {
+					if ( i > 0 ) {
+						s.arena.append("; ", 2);
+					}
+					s.arena.append(s.arena.data() + s.cookies[i].offset, s.cookies[i].length);
+				}
+				value.length = s.arena.size() - value.offset;
+			}
+			s.fields.push_back(std::make_pair(key, value));
+		}
+
+		view_.clear();
+		view_.bind(s.arena.data());
+		view_.setMethod(method);
+		view_.setUri(s.path);
+		view_.setVersion(http::version::HTTP_2);
+		for ( const auto& f : s.fields ) {
+			StringView name = Resolve(s.arena, f.first);
+			view_.addHeader(f.first, f.second, http::StringToField(name.data(), name.size()));
+		}
+
+		StringView length = view_.getHeader(http::field::CONTENT_LENGTH);
+		if ( !length.empty() && ::strtoull(length.toString().c_str(), nullptr, 10) != s.body.size() ) {
+			resetStream(s, error::PROTOCOL_ERROR, out);
+			return;
+		}
+		view_.setBody(std::move(s.body));
+
+		handler_(view_, s.response);
+		respond(s, out);
+	}
+
+	void respond(Stream& s, asio::DynamicBuffer& out)
+	{
+		http::Response& r = s.response;
+		int status = (int)r.state();
+		bool bodyless = s.head_only || status < 200 || status == 204 || status == 304;
+		size_t length = r.file() ? r.fileLength() : r.body().size();
+
+		block_out_.clear();
+		encoder_.encode(":status", std::to_string(status), block_out_);
+		bool has_length = false;
+		r.visitHeaders([&](StringView name, const std::string& value){
+			if ( IsConnectionSpecific(name) ) {
+				return;
+			}
+			if ( name.iequals("content-length") ) {
+				if ( r.file() ) {
+					return;
+				}
+				has_length = true;
+			}
+			name_.assign(name.data(), name.size());
+			std::transform(name_.begin(), name_.end(), name_.begin(), ::tolower);
+			encoder_.encode(name_, value, block_out_);
+		});
+		if ( !has_length && status >= 200 && status != 204 && status != 304 ) {
+			encoder_.encode("content-length", std::to_string(length), block_out_);
+		}
+
+		bool end = bodyless || length == 0;
+		WriteHeaders(out, s.id, block_out_, end, peer_max_frame_);
+		s.responded = true;
+		if ( end ) {
+			finish(s, out);
+			return;
+		}
+
+		s.send_offset = r.file() ? r.fileOffset() : 0;
+		s.send_left = length;
+		pending_bytes_ += length;
+		enqueue(s);
+	}
+
+	// the response is out, a request still sending is told to stop
+	void finish(Stream& s, asio::DynamicBuffer& out)
+	{
+		if ( !s.end_remote ) {
+			WriteRstStream(out, s.id, error::NO_ERROR);
+		}
+		closeStream(s.id);
+	}
+
+	size_t send(asio::DynamicBuffer& out, size_t max_bytes)
+	{
+		size_t written = 0;
+		while ( !over_ && !queue_.empty() && send_window_ > 0 && written < max_bytes ) {
+			Stream* s = find(queue_.front());
+			queue_.pop_front();
+			if ( s == nullptr ) {
+				continue;
+			}
+			s->queued = false;
+			if ( s->send_left == 0 || s->send_window <= 0 ) {
+				continue;		// back in the queue on its WINDOW_UPDATE
+			}
+
+			size_t n = std::min(s->send_left, peer_max_frame_);
+			n = (size_t)std::min<int64_t>((int64_t)n, std::min(send_window_, s->send_window));
+			bool end = n == s->send_left;
+
+			out.reserve(FRAME_HEAD_BYTES + n);
+			char* frame = out.writeBegin();
+			const http::Response& r = s->response;
+			if ( r.file() ) {
+				if ( !r.file()->read(s->send_offset, n, frame + FRAME_HEAD_BYTES) ) {
+					resetStream(*s, error::INTERNAL_ERROR, out);
+					continue;
+				}
+			}
+			else {
+				::memcpy(frame + FRAME_HEAD_BYTES, r.body().data() + s->send_offset, n);
+			}
+			SerializeFrameHead(frame, (uint32_t)n, frame::DATA, end ? FLAG_END_STREAM : 0, s->id);
+			out.write(FRAME_HEAD_BYTES + n);
+
+			s->send_offset += n;
+			s->send_left -= n;
+			s->send_window -= n;
+			send_window_ -= n;
+			pending_bytes_ -= n;
+			written += FRAME_HEAD_BYTES + n;
+
+			if ( end ) {
+				finish(*s, out);
+			}
+			else {
+				enqueue(*s);
+			}
+		}
+		return written;
+	}
+
+	void fail(error_type code, asio::DynamicBuffer& out)
+	{
+		if ( over_ ) {
+			return;
+		}
+		WriteGoaway(out, last_stream_id_, code);
+		over_ = true;
+	}
+
+	handler_type handler_;
+	HpackDecoder decoder_;
+	HpackEncoder encoder_;
+
+	uint32_t max_concurrent_;
+	size_t max_body_bytes_;
+	size_t max_header_list_bytes_;
+
+	std::unordered_map<uint32_t, std::unique_ptr<Stream> > streams_;
+	std::vector<std::unique_ptr<Stream> > free_;		// closed streams kept for their capacity
+	std::deque<uint32_t> queue_;						// streams with data and window, in turn
+	http::RequestView view_;
+
+	std::string block_;				// header block being received
+	uint32_t block_stream_;			// its stream while CONTINUATION frames are due, else 0
+	block_type block_type_;
+	bool block_end_stream_;
+	std::string block_out_;			// header block of a response
+	std::string name_;
+
+	uint32_t last_stream_id_;
+	int64_t send_window_;			// of the connection
+	int64_t recv_window_;
+	uint32_t recv_unacked_;
+	int64_t peer_initial_window_;
+	size_t peer_max_frame_;
+	size_t pending_bytes_;
+
+	bool preface_;
+	bool settings_;			// the first SETTINGS of the client came
+	bool over_;
+	bool goaway_sent_;
+	bool goaway_received_;
+};
+
+ServerSession::ServerSession(handler_type handler) :
+	pImpl_(new Impl(std::move(handler)))
+{
+}
+
+ServerSession::~ServerSession()
+{
+}
+
+void ServerSession::setMaxConcurrentStreams(uint32_t count)
+{
+	pImpl_->max_concurrent_ = count;
+}
+
+void ServerSession::setMaxBodyBytes(size_t bytes)
+{
+	pImpl_->max_body_bytes_ = bytes;
+}
+
+void ServerSession::setMaxHeaderListBytes(size_t bytes)
+{
+	pImpl_->max_header_list_bytes_ = bytes;
+}
+
+void ServerSession::start(asio::DynamicBuffer& out)
+{
+	pImpl_->start(out);
+}
+
+size_t ServerSession::receive(const char* data, size_t len, asio::DynamicBuffer& out)
+{
+	return pImpl_->receive(data, len, out);
+}
+
+size_t ServerSession::send(asio::DynamicBuffer& out, size_t max_bytes)
+{
+	return pImpl_->send(out, max_bytes);
+}
+
+void ServerSession::shutdown(asio::DynamicBuffer& out)
+{
+	if ( pImpl_->goaway_sent_ || pImpl_->over_ ) {
+		return;
+	}
+	WriteGoaway(out, pImpl_->last_stream_id_, error::NO_ERROR);
+	pImpl_->goaway_sent_ = true;
+}
+
+bool ServerSession::over() const
+{
+	return pImpl_->over_ || ((pImpl_->goaway_sent_ || pImpl_->goaway_received_) && pImpl_->streams_.empty());
+}
+
+size_t ServerSession::streams() const
+{
+	return pImpl_->streams_.size();
+}
+
+size_t ServerSession::pendingBytes() const
+{
+	return pImpl_->pending_bytes_;
+}
+
+}   // namespace http2
+}   // namespace protocol
+}	// namespace lcy
@@ -0,0 +1,104 @@
+#ifndef __LCY_PROTOCOL_HTTP2_SESSION_H__
+#define __LCY_PROTOCOL_HTTP2_SESSION_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <functional>
+
+#include "lcy/asio/src/dynamic_buffer.h"
+
+namespace lcy {
+namespace protocol {
+
+namespace http {
+class RequestView;
+class Response;
+}	// namespace http
+
+namespace http2 {
+
+/*
+* Server side of an HTTP/2 connection, without the socket : bytes received go in,
+* frames to send come out. http::Server runs one per connection that starts with the
+* client preface ( see Server::setHttp2() ).
+*
+* example :
+*
+*	http2::ServerSession session([](const http::RequestView& request, http::Response& response){
+*		response.setBody("hello");
+*	});
+*	session.start(out);
+*	in.read(session.receive(in.readBegin(), in.dataBytes(), out));
+*	session.send(out, budget);
+*
+* Streams are multiplexed : every request whose headers and body are in is passed to
+* the handler at once, whatever the streams before it still send. Its view has the
+* version HTTP_2, :authority as Host and cookie fields joined into one. The response
+* starts as 200 OK, its head goes out in HEADERS right away ( fields lower cased,
+* those of HTTP/1 connections dropped, Content-Length added ) and its body, collected
+* or a file, waits for send().
+*
+* Flow control : the session announces RECEIVE_WINDOW_BYTES per stream and for the
+* connection and gives the credit back once half of it is used. send() writes DATA
+* as far as the windows of the peer allow, a frame of each stream with data in turn.
+*
+* notify :
+*	A request body is collected up to setMaxBodyBytes(), above it the stream gets
+*	413 and a RST_STREAM ( NO_ERROR ) telling the client to stop. Header blocks are
+*	limited by setMaxHeaderListBytes() ( 431 ).
+*	Stream errors reset the stream, connection errors write a GOAWAY : over() turns
+*	true and anything received afterwards is dropped. A GOAWAY of the peer lets the
+*	streams it already opened finish.
+*	Server push, priorities and the h2c Upgrade from HTTP/1.1 are not supported.
+*/
+class ServerSession {
+public:
+	typedef std::function<void (const http::RequestView&, http::Response&)> handler_type;
+
+	enum {
+		DEFAULT_MAX_CONCURRENT_STREAMS = 100,
+		DEFAULT_MAX_HEADER_LIST_BYTES = 64 * 1024,
+		RECEIVE_WINDOW_BYTES = 1024 * 1024,
+	};
+
+	explicit ServerSession(handler_type handler);
+	~ServerSession();
+
+	// settings are made before start()
+	void setMaxConcurrentStreams(uint32_t count);		// streams above it are refused
+	void setMaxBodyBytes(size_t bytes);				// 0 : no limit
+	void setMaxHeaderListBytes(size_t bytes);		// names, values and 32 per field
+
+	// the server preface : SETTINGS, and credit for the connection
+	void start(asio::DynamicBuffer& out);
+	/*
+	* Handles the client preface and every whole frame in `data`, returns how many
+	* bytes that was : a partial frame at the end is left for the next call. Once
+	* over() everything is consumed and ignored.
+	*/
+	size_t receive(const char* data, size_t len, asio::DynamicBuffer& out);
+	// DATA frames of the responses, about `max_bytes` at most, returns the bytes written
+	size_t send(asio::DynamicBuffer& out, size_t max_bytes);
+	// GOAWAY : the streams already open are served, no new ones are accepted
+	void shutdown(asio::DynamicBuffer& out);
+
+	// the connection can go once `out` is sent : after a connection error, or a GOAWAY with no stream left
+	bool over() const;
+	size_t streams() const;			// open, or still sending their response
+	size_t pendingBytes() const;		// response bodies waiting for send()
+
+private:
+	ServerSession(const ServerSession&);
+	ServerSession& operator=(const ServerSession&);
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> pImpl_;
+};
+
+}   // namespace http2
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_HTTP2_SESSION_H__
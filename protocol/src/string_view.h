@@ -0,0 +1,136 @@
+#ifndef __LCY_PROTOCOL_STRING_VIEW_H__
+#define __LCY_PROTOCOL_STRING_VIEW_H__
+
+#include <string>
+#include <ostream>
+#include <string.h>
+#include <stddef.h>
+
+namespace lcy {
+namespace protocol {
+
+/*
+* Non owning slice of a character buffer ( C++11 stand-in for std::string_view ).
+* The viewed bytes must outlive the view.
+*/
+class StringView {
+public:
+	typedef const char* const_iterator;
+	static const size_t npos = (size_t)-1;
+
+	StringView() :
+		data_(nullptr),
+		size_(0)
+	{
+	}
+
+	StringView(const char* data, size_t size) :
+		data_(data),
+		size_(size)
+	{
+	}
+
+	StringView(const char* str) :
+		data_(str),
+		size_(str ? ::strlen(str) : 0)
+	{
+	}
+
+	StringView(const std::string& str) :
+		data_(str.data()),
+		size_(str.size())
+	{
+	}
+
+	const char* data() const { return data_; }
+	size_t size() const { return size_; }
+	size_t length() const { return size_; }
+	bool empty() const { return size_ == 0; }
+
+	const_iterator begin() const { return data_; }
+	const_iterator end() const { return data_ + size_; }
+
+	char operator[](size_t i) const { return data_[i]; }
+
+	StringView substr(size_t pos, size_t n = npos) const
+	{
+		if ( pos > size_ ) {
+			pos = size_;
+		}
+		if ( n > size_ - pos ) {
+			n = size_ - pos;
+		}
+		return StringView(data_ + pos, n);
+	}
+
+	size_t find(char c, size_t pos = 0) const
+	{
+		if ( pos >= size_ ) {
+			return npos;
+		}
+
+		const void* hit = ::memchr(data_ + pos, c, size_ - pos);
+		return hit ? (const char*)hit - data_ : npos;
+	}
+
+	bool equals(StringView other) const
+	{
+		return size_ == other.size_ &&
+			   (size_ == 0 || ::memcmp(data_, other.data_, size_) == 0);
+	}
+
+	bool startsWith(StringView prefix) const
+	{
+		return size_ >= prefix.size_ &&
+			   (prefix.size_ == 0 || ::memcmp(data_, prefix.data_, prefix.size_) == 0);
+	}
+
+	// ASCII case insensitive, as required for HTTP field names
+	bool iequals(StringView other) const
+	{
+		if ( size_ != other.size_ ) {
+			return false;
+		}
+
+		for ( size_t i = 0; i < size_; ++i ) {
+			unsigned char a = (unsigned char)data_[i];
+			unsigned char b = (unsigned char)other.data_[i];
+			if ( a != b && (a | 0x20) != (b | 0x20) ) {
+				return false;
+			}
+			if ( a != b && ((a | 0x20) < 'a' || (a | 0x20) > 'z') ) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string toString() const
+	{
+		return std::string(data_, size_);
+	}
+
+private:
+	const char* data_;
+	size_t size_;
+};
+
+inline bool operator==(StringView lhs, StringView rhs)
+{
+	return lhs.equals(rhs);
+}
+
+inline bool operator!=(StringView lhs, StringView rhs)
+{
+	return !lhs.equals(rhs);
+}
+
+inline std::ostream& operator<<(std::ostream& os, StringView view)
+{
+	return os.write(view.data(), view.size());
+}
+
+}	// namespace protocol
+}	// namespace lcy
+
+#endif	// __LCY_PROTOCOL_STRING_VIEW_H__
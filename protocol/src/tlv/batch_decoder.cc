@@ -0,0 +1,145 @@
+#include "lcy/protocol/src/tlv/batch_decoder.h"
+#include "lcy/protocol/src/tlv/parser.h"
+
+#include <string.h>
+#include <arpa/inet.h>
+
+namespace lcy {
+namespace protocol {
+namespace tlv {
+
+/*
+* notify :
+*	The head is loaded with memcpy and byte swapped, no per field state : the loop
+*	body is two loads, two compares and a store.
+*/
+static inline void loadHead(const char* p, uint16_t& type, uint32_t& length)
+{
+	::memcpy(&type, p, TYPE_BYTES);
+	::memcpy(&length, p + TYPE_BYTES, LENGTH_BYTES);
+	type = ntohs(type);
+	length = ntohl(length);
+}
+
+// what the frame at `at` lacks, if any
+static size_t neededAt(const char* data, size_t len, size_t at)
+{
+	size_t left = len - at;
+	if ( left == 0 ) {
+		return 0;
+	}
+	if ( left < HEAD_BYTES ) {
+		return HEAD_BYTES - left;
+	}
+
+	uint16_t type;
+	uint32_t length;
+	loadHead(data + at, type, length);
+	return left - HEAD_BYTES < length ? length - (left - HEAD_BYTES) : 0;
+}
+
+// `sink(type, length, offset)` for each whole frame, at most `max_frames`
+template <typename Sink>
+static DecodeResult decodeFixed(const char* p, size_t len, size_t max_frames, Sink sink)
+{
+	DecodeResult result;
+	size_t at = 0;
+	size_t n = 0;
+
+	while ( n < max_frames && len - at >= HEAD_BYTES ) {
+		uint16_t type;
+		uint32_t length;
+		loadHead(p + at, type, length);
+		if ( len - at - HEAD_BYTES < length ) {
+			break;
+		}
+
+		sink(type, length, at + HEAD_BYTES);
+		++n;
+		at += HEAD_BYTES + length;
+	}
+
+	result.frames = n;
+	result.consumed = at;
+	result.needed = neededAt(p, len, at);
+	return result;
+}
+
+/*
+* The compact framing : heads go through ReadCompactHead(), ParseHead() tells a partial
+* head from a malformed one when that fails.
+*/
+template <typename Sink>
+static DecodeResult decodeCompact(const char* p, size_t len, size_t max_frames, Sink sink)
+{
+	DecodeResult result;
+	size_t at = 0;
+	size_t n = 0;
+
+	while ( n < max_frames && at < len ) {
+		uint16_t type;
+		uint32_t length;
+		size_t left = len - at;
+		size_t head_bytes = ReadCompactHead(p + at, left, type, length);
+		if ( head_bytes == 0 ) {
+			Parser::RetCode retcode = ParseHead(p + at, left, framing::COMPACT, type, length, head_bytes);
+			if ( retcode == Parser::RetCode::WAITING_DATA ) {
+				result.needed = 1;
+				break;
+			}
+			if ( retcode == Parser::RetCode::ERROR ) {
+				result.error = true;
+				break;
+			}
+		}
+
+		if ( left - head_bytes < length ) {
+			result.needed = length - (left - head_bytes);
+			break;
+		}
+
+		sink(type, length, at + head_bytes);
+		++n;
+		at += head_bytes + length;
+	}
+
+	result.frames = n;
+	result.consumed = at;
+	return result;
+}
+
+template <typename Sink>
+static DecodeResult decode(const char* p, size_t len, size_t max_frames, framing_type f, Sink sink)
+{
+	if ( f == framing::COMPACT ) {
+		return decodeCompact(p, len, max_frames, sink);
+	}
+	return decodeFixed(p, len, max_frames, sink);
+}
+
+DecodeResult DecodeFrames(const void* data, size_t len, FrameDesc* frames, size_t max_frames, framing_type f)
+{
+	return decode((const char*)data, len, max_frames, f,
+				  [frames](uint16_t type, uint32_t length, size_t offset) mutable {
+		FrameDesc& desc = *frames++;
+		desc.type = type;
+		desc.length = length;
+		desc.offset = offset;
+	});
+}
+
+DecodeResult DecodeFrames(const void* data, size_t len, std::vector<FrameDesc>& frames, framing_type f)
+{
+	frames.clear();
+	return decode((const char*)data, len, (size_t)-1, f, [&frames](uint16_t type, uint32_t length, size_t offset){
+		FrameDesc desc;
+		desc.type = type;
+		desc.length = length;
+		desc.offset = offset;
+		frames.push_back(desc);
+	});
+}
+
+}	// namespace tlv
+}	// namespace protocol
+}	// namespace lcy
@@ -0,0 +1,70 @@
+#ifndef __LCY_PROTOCOL_TLV_BATCH_DECODER_H__
+#define __LCY_PROTOCOL_TLV_BATCH_DECODER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/tlv/message.h"
+
+namespace lcy {
+namespace protocol {
+namespace tlv {
+
+/*
+* Batch decoding : every whole frame of a contiguous buffer in one pass, without the
+* state of a Parser to reset between them.
+*
+* example :
+*
+*	tlv::FrameDesc frames[256];
+*	tlv::DecodeResult result;
+*	do {
+*		result = tlv::DecodeFrames(in.readBegin(), in.dataBytes(), frames, 256);
+*		for ( size_t i = 0; i < result.frames; ++i ) {
+*			handle(frames[i].type, tlv::FrameValue(in.readBegin(), frames[i]));
+*		}
+*		in.read(result.consumed);
+*	} while ( result.frames == 256 );
+*	in.reserve(result.needed);	// the trailing partial frame stays for the next read
+*/
+
+typedef struct FrameDesc {
+	uint16_t type;
+	uint32_t length;
+	size_t offset;		// of the value, from the start of the buffer
+} frame_desc_type;
+
+typedef struct DecodeResult {
+	size_t frames;		// descriptors written
+	size_t consumed;	// bytes of those frames, where the next one starts
+	size_t needed;		// bytes the frame at `consumed` still lacks, 0 if it is whole or absent
+	bool error;			// the head at `consumed` is malformed ( compact framing only )
+
+	DecodeResult() : frames(0), consumed(0), needed(0), error(false) {}
+} decode_result_type;
+
+/*
+* notify :
+*	With the compact framing a head cut short does not tell its size : `needed` is
+*	then 1, at least one more byte.
+*/
+
+// up to `max_frames` descriptors into `frames`
+DecodeResult DecodeFrames(const void* data, size_t len, FrameDesc* frames, size_t max_frames,
+						  framing_type f = framing::FIXED);
+// every whole frame, `frames` is cleared first and keeps its capacity
+DecodeResult DecodeFrames(const void* data, size_t len, std::vector<FrameDesc>& frames,
+						  framing_type f = framing::FIXED);
+
+inline StringView FrameValue(const void* data, const FrameDesc& frame)
+{
+	return StringView((const char*)data + frame.offset, frame.length);
+}
+
+}	// namespace tlv
+}	// namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_TLV_BATCH_DECODER_H__
@@ -1,8 +1,5 @@
 #include "lcy/protocol/src/tlv/message.h"
-#include "lcy/protocol/src/tlv/variant_encode.h"
-
-#include <string.h>
-#include <arpa/inet.h>
+#include "lcy/protocol/src/tlv/serializer.h"
 
 namespace lcy {
 namespace protocol {
@@ -48,34 +45,18 @@ void Message::setValue(std::string value)
 	value_ = std::move(value);
 }
 
-std::string Message::dump() const
+std::string Message::dump(framing_type f) const
 {
-//	if ( value_.size() < length_ ) return "";
-//
-//	size_t encode_len = 0;
-//	char buf[BUFLEN_UINT16 + BUFLEN_UINT32];
-//
-//	encode_len = VariantEncodeUint16(type_, buf, sizeof(buf));
-//	encode_len += VariantEncodeUint32(length_,
-//									  buf + encode_len,
-//									  sizeof(buf) - encode_len);
-//	std::string tmp;
-//	tmp += std::string(buf, encode_len);
-//	tmp += std::string(value_.c_str(), length_);
-//
-//	return tmp;
-
 	if ( value_.size() < length_ ) return "";
-	
-	uint16_t type_tmp = htons(type_);
-	uint32_t length_tmp = htonl(length_);
-	
-	std::string tmp;
-	tmp.resize(sizeof(type_tmp) + sizeof(length_tmp));
-	::memcpy(&tmp[0], &type_tmp, sizeof(type_tmp));
-	::memcpy(&tmp[0] + sizeof(type_tmp), &length_tmp, sizeof(length_tmp));
 
-	tmp += std::string(value_.c_str(), length_);
+	// one allocation : the head, then the value appended in place
+	char head[MAX_HEAD_BYTES];
+	size_t head_bytes = SerializeHead(type_, length_, head, f);
+
+	std::string tmp;
+	tmp.reserve(head_bytes + length_);
+	tmp.append(head, head_bytes);
+	tmp.append(value_.data(), length_);
 
 	return tmp;
 }
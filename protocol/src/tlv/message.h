@@ -4,10 +4,80 @@
 #include <stdint.h>
 #include <string>
 
+#include "lcy/protocol/src/tlv/variant_encode.h"
+
 namespace lcy {
 namespace protocol {
 namespace tlv {
 
+/*
+* Wire format : type ( 2 bytes ) and length ( 4 bytes ) in network order, then
+* `length` bytes of value. The compact framing writes type and length as varints
+* instead ( see VariantEncodeUint16/32 ) : 2 bytes of head for a type below 128 and a
+* value below 128 bytes. Both ends must agree on the framing, it is not marked on
+* the wire.
+*/
+enum {
+	TYPE_BYTES = 2,
+	LENGTH_BYTES = 4,
+	HEAD_BYTES = TYPE_BYTES + LENGTH_BYTES,
+	COMPACT_MAX_HEAD_BYTES = BUFLEN_UINT16 + BUFLEN_UINT32,
+	MAX_HEAD_BYTES = COMPACT_MAX_HEAD_BYTES,
+};
+
+typedef
+enum class framing :
+	uint8_t
+{
+	FIXED,
+	COMPACT,
+}
+framing_type;
+
+/*
+* The compact head, what every compact reader and writer goes through : a type of at
+* most BUFLEN_UINT16 bytes and below 2^16, then a length of at most BUFLEN_UINT32 bytes
+* and below 2^32, both as VariantReadUint32() takes them.
+*/
+// returns the bytes written, 0 if `len` is too small. Bytes past the head, up to `len`, may be overwritten
+inline size_t WriteCompactHead(uint16_t type, uint32_t length, void* buf, size_t len)
+{
+	if ( (type | length) < 0x80 && len >= 2 ) {
+		((uint8_t*)buf)[0] = (uint8_t)type;
+		((uint8_t*)buf)[1] = (uint8_t)length;
+		return 2;
+	}
+	size_t n = VariantWriteUint32(type, buf, len);
+	if ( n == 0 ) {
+		return 0;
+	}
+	size_t m = VariantWriteUint32(length, (uint8_t*)buf + n, len - n);
+	return m == 0 ? 0 : n + m;
+}
+
+// returns the bytes read, 0 if `len` ends before the head or it is malformed
+inline size_t ReadCompactHead(const void* buf, size_t len, uint16_t& type, uint32_t& length)
+{
+	const uint8_t* p = (const uint8_t*)buf;
+	if ( len >= 2 && (p[0] | p[1]) < 0x80 ) {
+		type = p[0];
+		length = p[1];
+		return 2;
+	}
+	uint32_t t;
+	size_t n = VariantReadUint32(buf, len, t);
+	// 3 bytes hold 21 bits : a longer type is malformed even if it is small
+	if ( n == 0 || n > BUFLEN_UINT16 || t > 0xFFFF ) {
+		return 0;
+	}
+	size_t m = VariantReadUint32(p + n, len - n, length);
+	if ( m == 0 ) {
+		return 0;
+	}
+	type = (uint16_t)t;
+	return n + m;
+}
+
 class Message {
 public:
 	Message();
@@ -21,7 +91,8 @@ public:
 	void setLength(uint32_t length);
 	void setValue(std::string value);
 
-	std::string dump() const;
+	// head and the first length() bytes of value(), empty if value() is shorter
+	std::string dump(framing_type f = framing::FIXED) const;
 
 private:
 	uint16_t type_;
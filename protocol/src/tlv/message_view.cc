@@ -0,0 +1,78 @@
+#include "lcy/protocol/src/tlv/message_view.h"
+
+namespace lcy {
+namespace protocol {
+namespace tlv {
+
+MessageView::MessageView() :
+	base_(nullptr),
+	head_bytes_(HEAD_BYTES),
+	type_(0),
+	length_(0)
+{
+}
+
+MessageView::~MessageView()
+{
+}
+
+uint16_t MessageView::type() const
+{
+	return type_;
+}
+
+uint32_t MessageView::length() const
+{
+	return length_;
+}
+
+StringView MessageView::value() const
+{
+	if ( base_ == nullptr ) {
+		return StringView();
+	}
+	return StringView(base_ + head_bytes_, length_);
+}
+
+void MessageView::clear()
+{
+	base_ = nullptr;
+	head_bytes_ = HEAD_BYTES;
+	type_ = 0;
+	length_ = 0;
+}
+
+void MessageView::toMessage(Message& msg) const
+{
+	StringView v = value();
+	msg.setType(type_);
+	msg.setLength((uint32_t)v.size());
+	msg.setValue(v.toString());
+}
+
+Message MessageView::toMessage() const
+{
+	Message msg;
+	toMessage(msg);
+	return msg;
+}
+
+void MessageView::bind(const char* base, size_t head_bytes)
+{
+	base_ = base;
+	head_bytes_ = head_bytes;
+}
+
+void MessageView::setType(uint16_t type)
+{
+	type_ = type;
+}
+
+void MessageView::setLength(uint32_t length)
+{
+	length_ = length;
+}
+
+}	// namespace tlv
+}	// namespace protocol
+}	// namespace lcy
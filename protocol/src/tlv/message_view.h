@@ -0,0 +1,63 @@
+#ifndef __LCY_PROTOCOL_TLV_MESSAGE_VIEW_H__
+#define __LCY_PROTOCOL_TLV_MESSAGE_VIEW_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/tlv/message.h"
+
+namespace lcy {
+namespace protocol {
+namespace tlv {
+
+/*
+* Message whose value is a slice of the receive buffer instead of an owned string.
+*
+* The parser binds the view to the buffer passed to the call that returns READY, the
+* value starts after the head ( HEAD_BYTES, or less with the compact framing ). It
+* stays valid until that buffer is consumed or modified, use toMessage() to keep it
+* longer.
+*
+* example :
+*
+*	tlv::MessageView view;
+*	if ( parser.parse(in.readBegin(), in.dataBytes(), view) == tlv::Parser::READY ) {
+*		handle(view.type(), view.value());
+*		in.read(parser.nparse());
+*		parser.reset();
+*	}
+*/
+class MessageView {
+public:
+	MessageView();
+	~MessageView();
+
+	uint16_t type() const;
+	uint32_t length() const;
+	StringView value() const;
+
+	void clear();
+
+	void toMessage(Message& msg) const;
+	Message toMessage() const;
+
+	/*
+	* Filled by the parser
+	*/
+	void bind(const char* base, size_t head_bytes = HEAD_BYTES);		// start of the message, its head
+	void setType(uint16_t type);
+	void setLength(uint32_t length);
+
+private:
+	const char* base_;
+	size_t head_bytes_;
+	uint16_t type_;
+	uint32_t length_;
+};
+
+}	// namespace tlv
+}	// namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_TLV_MESSAGE_VIEW_H__
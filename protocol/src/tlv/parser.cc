@@ -1,5 +1,6 @@
 #include "lcy/protocol/src/tlv/parser.h"
 #include "lcy/protocol/src/tlv/message.h"
+#include "lcy/protocol/src/tlv/message_view.h"
 
 #include <string.h>
 #include <arpa/inet.h>
@@ -8,19 +9,49 @@ namespace lcy {
 namespace protocol {
 namespace tlv {
 
+// bytes of the varint at `data`, 0 if `len` ends before it, `max` + 1 if it is longer
+static size_t varintBytes(const char* data, size_t len, size_t max)
+{
+	for ( size_t i = 0; i < max; ++i ) {
+		if ( i == len ) {
+			return 0;
+		}
+		if ( !((uint8_t)data[i] & 0x80) ) {
+			return i + 1;
+		}
+	}
+	return max + 1;
+}
+
 static Parser::RetCode parseType(const char* data_ptr,
 								 size_t len, 
-								 Message& msg,
+								 framing_type f,
+								 uint16_t& type,
 								 size_t& nparse)
 {
+	if ( f == framing::COMPACT ) {
+		size_t n = varintBytes(data_ptr, len, BUFLEN_UINT16);
+		if ( n == 0 ) {
+			return Parser::RetCode::WAITING_DATA;
+		}
+
+		// 3 bytes hold 21 bits
+		uint32_t value = 0;
+		if ( n > BUFLEN_UINT16 || !VariantDecodeUint32(value, data_ptr, n) || value > 0xFFFF ) {
+			return Parser::RetCode::ERROR;
+		}
+		type = (uint16_t)value;
+		nparse += n;
+		return Parser::RetCode::READY;
+	}
+
 	if ( len < sizeof(uint16_t) ) {
 		return Parser::RetCode::WAITING_DATA; 
 	}
 
-	uint16_t type = 0;
 	::memcpy(&type, data_ptr, sizeof(uint16_t));
+	type = ntohs(type);
 
-	msg.setType(ntohs(type));
 	nparse += sizeof(uint16_t);
 
 	return Parser::RetCode::READY;
@@ -28,35 +59,46 @@ static Parser::RetCode parseType(const char* data_ptr,
 
 static Parser::RetCode parseLength(const char* data_ptr,
 								   size_t len,
-								   Message& msg,
+								   framing_type f,
+								   uint32_t& length,
 								   size_t& nparse)
 {
+	if ( f == framing::COMPACT ) {
+		size_t n = varintBytes(data_ptr, len, BUFLEN_UINT32);
+		if ( n == 0 ) {
+			return Parser::RetCode::WAITING_DATA;
+		}
+
+		// 5 bytes hold 35 bits
+		uint64_t value = 0;
+		if ( n > BUFLEN_UINT32 || !VariantDecodeUint64(value, data_ptr, n) || value > 0xFFFFFFFF ) {
+			return Parser::RetCode::ERROR;
+		}
+		length = (uint32_t)value;
+		nparse += n;
+		return Parser::RetCode::READY;
+	}
+
 	if ( len < sizeof(uint32_t) ) {
 		return Parser::RetCode::WAITING_DATA; 
 	}
 
-	uint32_t length = 0;
 	::memcpy(&length, data_ptr, sizeof(uint32_t));
+	length = ntohl(length);
 
-	msg.setLength(ntohl(length));
 	nparse += sizeof(uint32_t);
 
 	return Parser::RetCode::READY;
 }
 
-static Parser::RetCode parseValue(const char* data_ptr,
-								  size_t len,
-								  Message& msg,
+// the value is not copied : the caller takes it from the buffer once READY
+static Parser::RetCode parseValue(size_t len,
+								  uint32_t length,
 								  size_t& nparse)
 {
-	uint32_t length = msg.length();
-
 	if ( len < length ) {
 		return Parser::RetCode::WAITING_DATA;
 	}
-	
-	std::string value = std::string(data_ptr, length);
-	msg.setValue(std::move(value));
 
 	nparse += length;
 	
@@ -80,17 +122,32 @@ public:
     void reset();
 	size_t nparse() const;
     RetCode parse(const void* data, size_t len, Message& msg);
+    RetCode parse(const void* data, size_t len, MessageView& view);
+
+	void setFraming(framing_type f);
+	framing_type framing() const;
+
+private:
+	RetCode advance(const char* data, size_t len);
 
 private:
     Tag tag_;
 	size_t already_parse_;
+	framing_type framing_;
+	uint16_t type_;
+	uint32_t length_;
+	size_t head_bytes_;
 };
 
 ////////////////////////////////////////////////////////////
 
 Parser::Impl::Impl() :
 	tag_(Tag::TYPE),
-	already_parse_(0)
+	already_parse_(0),
+	framing_(framing::FIXED),
+	type_(0),
+	length_(0),
+	head_bytes_(0)
 {
 }
 
@@ -102,6 +159,9 @@ void Parser::Impl::reset()
 {
 	tag_ = Tag::TYPE;
 	already_parse_ = 0;
+	type_ = 0;
+	length_ = 0;
+	head_bytes_ = 0;
 }
 
 size_t Parser::Impl::nparse() const
@@ -109,10 +169,44 @@ size_t Parser::Impl::nparse() const
 	return already_parse_;
 }
 
+void Parser::Impl::setFraming(framing_type f)
+{
+	framing_ = f;
+}
+
+framing_type Parser::Impl::framing() const
+{
+	return framing_;
+}
+
 Parser::RetCode Parser::Impl::parse(const void* data, size_t len, Message& msg)
 {
 	const char* data_ptr = (const char*)data;
+	Parser::RetCode retcode = advance(data_ptr, len);
 
+	if ( retcode == Parser::RetCode::READY ) {
+		msg.setType(type_);
+		msg.setLength(length_);
+		msg.setValue(std::string(data_ptr + head_bytes_, length_));
+	}
+	return retcode;
+}
+
+Parser::RetCode Parser::Impl::parse(const void* data, size_t len, MessageView& view)
+{
+	const char* data_ptr = (const char*)data;
+	Parser::RetCode retcode = advance(data_ptr, len);
+
+	if ( retcode == Parser::RetCode::READY ) {
+		view.bind(data_ptr, head_bytes_);
+		view.setType(type_);
+		view.setLength(length_);
+	}
+	return retcode;
+}
+
+Parser::RetCode Parser::Impl::advance(const char* data_ptr, size_t len)
+{
 	while ( tag_ != Tag::READY ) {
 		size_t nparse = 0;
 		Parser::RetCode retcode = Parser::RetCode::ERROR;
@@ -120,7 +214,7 @@ Parser::RetCode Parser::Impl::parse(const void* data, size_t len, Message& msg)
 		switch ( tag_ ) {
 			case Tag::TYPE : {
 				retcode = parseType(data_ptr + already_parse_, 
-									len - already_parse_, msg, nparse);
+									len - already_parse_, framing_, type_, nparse);
 				
 				if ( retcode == Parser::RetCode::READY ) {
 					already_parse_ += nparse;
@@ -134,10 +228,11 @@ Parser::RetCode Parser::Impl::parse(const void* data, size_t len, Message& msg)
 
 			case Tag::LENGTH : {
 				retcode = parseLength(data_ptr + already_parse_, 
-									  len - already_parse_, msg, nparse);
+									  len - already_parse_, framing_, length_, nparse);
 				
 				if ( retcode == Parser::RetCode::READY ) {
 					already_parse_ += nparse;
+					head_bytes_ = already_parse_;
 					tag_ = Tag::VALUE;
 				} else {
 					return retcode;
@@ -147,8 +242,7 @@ Parser::RetCode Parser::Impl::parse(const void* data, size_t len, Message& msg)
 			}
 
 			case Tag::VALUE : {
-				retcode = parseValue(data_ptr + already_parse_, 
-									 len - already_parse_, msg, nparse);
+				retcode = parseValue(len - already_parse_, length_, nparse);
 				
 				if ( retcode == Parser::RetCode::READY ) {
 					already_parse_ += nparse;
@@ -174,9 +268,10 @@ Parser::RetCode Parser::Impl::parse(const void* data, size_t len, Message& msg)
 
 //////////////////////////////////////////////////////////////////////
 
-Parser::Parser() :
+Parser::Parser(framing_type f) :
 	pImpl_(new Impl())
 {
+	pImpl_->setFraming(f);
 }
 
 Parser::~Parser()
@@ -198,6 +293,39 @@ Parser::RetCode Parser::parse(const void* data, size_t len, Message& msg)
 	return pImpl_->parse(data, len, msg);
 }
 
+Parser::RetCode Parser::parse(const void* data, size_t len, MessageView& view)
+{
+	return pImpl_->parse(data, len, view);
+}
+
+void Parser::setFraming(framing_type f)
+{
+	pImpl_->setFraming(f);
+}
+
+framing_type Parser::framing() const
+{
+	return pImpl_->framing();
+}
+
+//////////////////////////////////////////////////////////////////////
+
+Parser::RetCode ParseHead(const char* data, size_t len, framing_type f,
+						  uint16_t& type, uint32_t& length, size_t& head_bytes)
+{
+	size_t nparse = 0;
+	Parser::RetCode retcode = parseType(data, len, f, type, nparse);
+	if ( retcode != Parser::RetCode::READY ) {
+		return retcode;
+	}
+
+	retcode = parseLength(data + nparse, len - nparse, f, length, nparse);
+	if ( retcode == Parser::RetCode::READY ) {
+		head_bytes = nparse;
+	}
+	return retcode;
+}
+
 }	// namespace tlv
 }	// namespace protocol
 }	// namespace lcy
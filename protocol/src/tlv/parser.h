@@ -2,27 +2,41 @@
 #define __LCY_PROTOCOL_TLV_PARSER_H__
 
 #include <memory>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "lcy/protocol/src/tlv/message.h"
 
 namespace lcy {
 namespace protocol {
 namespace tlv {
 
-class Message;
+class MessageView;
 
 class Parser {
 public:
     enum RetCode {
         READY,              // http protocol is ready
         WAITING_DATA,       // http protocol is incomplete
-        ERROR               // an error occurred, not be used
+        ERROR               // a malformed compact head
     };
 
-    Parser();
+    explicit Parser(framing_type f = framing::FIXED);
     ~Parser();
 
+	// both ends agree on it, e.g. when the connection is set up : changed between messages only
+	void setFraming(framing_type f);
+	framing_type framing() const;
+
     void reset();
 	size_t nparse() const;
+	/*
+	* `data` starts at the message, calls for the same message pass the same bytes
+	* again with more appended ( the buffer may have moved ).
+	*/
     RetCode parse(const void* data, size_t len, Message& msg);
+	// Zero copy variant, `view` refers into `data` ( see MessageView )
+    RetCode parse(const void* data, size_t len, MessageView& view);
 
 private:
 	Parser(const Parser&);
@@ -33,6 +47,13 @@ private:
     std::unique_ptr<Impl> pImpl_;
 };
 
+/*
+* The head alone, READY with `head_bytes` set, WAITING_DATA if `len` does not hold it
+* yet, ERROR if malformed.
+*/
+Parser::RetCode ParseHead(const char* data, size_t len, framing_type f,
+						  uint16_t& type, uint32_t& length, size_t& head_bytes);
+
 }	// namespace tlv
 }	// namespace protocol
 }	// namespace lcy
@@ -0,0 +1,84 @@
+#ifndef __LCY_PROTOCOL_TLV_RECORD_HPP__
+#define __LCY_PROTOCOL_TLV_RECORD_HPP__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "lcy/asio/src/dynamic_buffer.h"
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/tlv/message.h"
+
+namespace lcy {
+namespace protocol {
+namespace tlv {
+
+/*
+* Typed records : a struct with a schema known at compile time, as nested TLV.
+*
+* Every field is a TLV of its own inside the value of the record, its tag as the
+* type. The schema lists the tags and the members, a codec is picked per member type
+* when the templates are instantiated : no reflection, no virtual call, no table at
+* run time, nothing allocated but what a std::string field holds itself.
+*
+*	struct Quote {
+*		uint32_t id;
+*		double price;
+*		StringView symbol;
+*
+*		typedef tlv::Schema<
+*			LCY_TLV_FIELD(1, Quote, id),
+*			LCY_TLV_FIELD(2, Quote, price),
+*			LCY_TLV_FIELD(3, Quote, symbol)
+*		> schema_type;
+*	};
+*
+* notify :
+*	Field values by member type :
+*	integers and enums	fixed width in network order, with the compact framing varints
+*						( zigzag for the signed )
+*	bool				one byte, 0 or 1
+*	float, double		their IEEE bits in network order
+*	StringView, string	the bytes, a StringView decodes pointing into the value
+*	std::array<T, N>	N arithmetic T packed, fixed width in network order
+*	a record			its fields, nested
+*
+*	Fields are written in schema order, their heads in the framing of the record.
+*	Decoding takes them in any order, skips unknown tags ( a newer peer ) and leaves
+*	missing fields as they were. Tags are unique within a schema, that is checked
+*	when it is compiled.
+*/
+
+template <uint16_t Tag, typename Member, Member Ptr>
+struct Field;
+
+template <typename... Fields>
+struct Schema {};
+
+// a field of a record, as an argument of Schema
+#define LCY_TLV_FIELD(tag, record, member)	\
+	::lcy::protocol::tlv::Field<tag, decltype(&record::member), &record::member>
+
+// bytes of the value of `rec`, its fields with their heads
+template <typename Record>
+size_t RecordBytes(const Record& rec, framing_type f = framing::FIXED);
+
+// the value of `rec` into `out`, which holds RecordBytes() : returns the bytes written
+template <typename Record>
+size_t EncodeRecord(const Record& rec, char* out, framing_type f = framing::FIXED);
+
+// appends a message of type `type` holding `rec`, returns the bytes written
+template <typename Record>
+size_t SerializeRecord(uint16_t type, const Record& rec, asio::DynamicBuffer& buffer,
+						framing_type f = framing::FIXED);
+
+// the fields in `value`, e.g. MessageView::value() : false if malformed, `rec` then partly set
+template <typename Record>
+bool DecodeRecord(StringView value, Record& rec, framing_type f = framing::FIXED);
+
+}	// namespace tlv
+}	// namespace protocol
+}	// namespace lcy
+
+#include "record.ipp"
+
+#endif	// __LCY_PROTOCOL_TLV_RECORD_HPP__
@@ -0,0 +1,438 @@
+#include <array>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include "lcy/protocol/src/tlv/variant_encode.h"
+
+namespace lcy {
+namespace protocol {
+namespace tlv {
+
+namespace details {
+
+template <typename Member>
+struct MemberTraits;
+
+template <typename Record, typename T>
+struct MemberTraits<T Record::*> {
+	typedef Record record_type;
+	typedef T value_type;
+};
+
+}	// namespace details
+
+template <uint16_t Tag, typename Member, Member Ptr>
+struct Field {
+	typedef typename details::MemberTraits<Member>::record_type record_type;
+	typedef typename details::MemberTraits<Member>::value_type value_type;
+
+	static const uint16_t tag = Tag;
+
+	static const value_type& get(const record_type& rec) { return rec.*Ptr; }
+	static value_type& get(record_type& rec) { return rec.*Ptr; }
+};
+
+namespace details {
+
+template <typename T>
+struct Void {
+	typedef void type;
+};
+
+template <typename T, typename = void>
+struct IsRecord : std::false_type {};
+
+template <typename T>
+struct IsRecord<T, typename Void<typename T::schema_type>::type> : std::true_type {};
+
+////////////////////////////////////////////////////
+
+template <size_t Bytes>
+struct UintOf;
+
+template <> struct UintOf<1> { typedef uint8_t type; };
+template <> struct UintOf<2> { typedef uint16_t type; };
+template <> struct UintOf<4> { typedef uint32_t type; };
+template <> struct UintOf<8> { typedef uint64_t type; };
+
+inline uint8_t NetOrder(uint8_t v) { return v; }
+inline uint16_t NetOrder(uint16_t v) { return htons(v); }
+inline uint32_t NetOrder(uint32_t v) { return htonl(v); }
+
+inline uint64_t NetOrder(uint64_t v)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	return __builtin_bswap64(v);
+#else
+	return v;
+#endif
+}
+
+// the bits of an integer, enum or floating point `v`, in network order
+template <typename T>
+inline void StoreNet(T v, char* out)
+{
+	typename UintOf<sizeof(T)>::type bits;
+	::memcpy(&bits, &v, sizeof(T));
+	bits = NetOrder(bits);
+	::memcpy(out, &bits, sizeof(T));
+}
+
+template <typename T>
+inline T LoadNet(const char* p)
+{
+	typename UintOf<sizeof(T)>::type bits;
+	::memcpy(&bits, p, sizeof(T));
+	bits = NetOrder(bits);
+	T v;
+	::memcpy(&v, &bits, sizeof(T));
+	return v;
+}
+
+// as HeadBytes() and SerializeHead(), inline for the field loops
+inline size_t HeadBytesOf(uint16_t type, uint32_t length, framing_type f)
+{
+	if ( f == framing::COMPACT ) {
+		return VariantLengthUint32(type) + VariantLengthUint32(length);
+	}
+	return HEAD_BYTES;
+}
+
+inline size_t PutHead(uint16_t type, uint32_t length, char* out, framing_type f)
+{
+	if ( f == framing::COMPACT ) {
+		// `out` holds exactly the head and what follows it
+		return WriteCompactHead(type, length, out, HeadBytesOf(type, length, f));
+	}
+	StoreNet(type, out);
+	StoreNet(length, out + TYPE_BYTES);
+	return HEAD_BYTES;
+}
+
+// false if `len` ends before the head or it is malformed
+inline bool GetHead(const char* p, size_t len, framing_type f, uint16_t& type, uint32_t& length,
+					size_t& head_bytes)
+{
+	if ( f == framing::COMPACT ) {
+		head_bytes = ReadCompactHead(p, len, type, length);
+		return head_bytes != 0;
+	}
+	if ( len < HEAD_BYTES ) {
+		return false;
+	}
+	type = LoadNet<uint16_t>(p);
+	length = LoadNet<uint32_t>(p + TYPE_BYTES);
+	head_bytes = HEAD_BYTES;
+	return true;
+}
+
+////////////////////////////////////////////////////
+
+/*
+* notify :
+*	A codec per member type : bytes() of the value, write() of exactly those bytes,
+*	read() of a whole field value, false if it does not hold a T. A type without a
+*	specialization is not a supported field type.
+*/
+template <typename T, typename Enable = void>
+struct Codec;
+
+template <typename T>
+struct Codec<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+	// zigzag for the signed, small magnitudes in few bytes
+	static uint64_t toWire(T v)
+	{
+		if ( std::is_signed<T>::value ) {
+			int64_t s = (int64_t)v;
+			return ((uint64_t)s << 1) ^ (uint64_t)(s >> 63);
+		}
+		return (uint64_t)v;
+	}
+
+	static bool fromWire(uint64_t u, T& v)
+	{
+		if ( std::is_signed<T>::value ) {
+			int64_t s = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+			if ( s < (int64_t)std::numeric_limits<T>::min() || s > (int64_t)std::numeric_limits<T>::max() ) {
+				return false;
+			}
+			v = (T)s;
+			return true;
+		}
+		if ( u > (uint64_t)std::numeric_limits<T>::max() ) {
+			return false;
+		}
+		v = (T)u;
+		return true;
+	}
+
+	static size_t bytes(T v, framing_type f)
+	{
+		return f == framing::COMPACT ? VariantLengthUint64(toWire(v)) : sizeof(T);
+	}
+
+	static void write(T v, char* out, size_t n, framing_type f)
+	{
+		if ( f == framing::COMPACT ) {
+			VariantWriteUint64(toWire(v), out, n);
+		} else {
+			StoreNet(v, out);
+		}
+	}
+
+	static bool read(const char* p, size_t len, T& v, framing_type f)
+	{
+		if ( f == framing::COMPACT ) {
+			uint64_t u = 0;
+			return len != 0 && VariantReadUint64(p, len, u) == len && fromWire(u, v);
+		}
+		if ( len != sizeof(T) ) {
+			return false;
+		}
+		v = LoadNet<T>(p);
+		return true;
+	}
+};
+
+template <typename T>
+struct Codec<T, typename std::enable_if<std::is_enum<T>::value>::type> {
+	typedef typename std::underlying_type<T>::type underlying_type;
+	typedef Codec<underlying_type> codec_type;
+
+	static size_t bytes(T v, framing_type f) { return codec_type::bytes((underlying_type)v, f); }
+	static void write(T v, char* out, size_t n, framing_type f) { codec_type::write((underlying_type)v, out, n, f); }
+
+	static bool read(const char* p, size_t len, T& v, framing_type f)
+	{
+		underlying_type u;
+		if ( !codec_type::read(p, len, u, f) ) {
+			return false;
+		}
+		v = (T)u;
+		return true;
+	}
+};
+
+template <>
+struct Codec<bool> {
+	static size_t bytes(bool, framing_type) { return 1; }
+	static void write(bool v, char* out, size_t, framing_type) { *out = v ? 1 : 0; }
+
+	static bool read(const char* p, size_t len, bool& v, framing_type)
+	{
+		if ( len != 1 || (uint8_t)p[0] > 1 ) {
+			return false;
+		}
+		v = p[0] != 0;
+		return true;
+	}
+};
+
+template <typename T>
+struct Codec<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+	static size_t bytes(T, framing_type) { return sizeof(T); }
+	static void write(T v, char* out, size_t, framing_type) { StoreNet(v, out); }
+
+	static bool read(const char* p, size_t len, T& v, framing_type)
+	{
+		if ( len != sizeof(T) ) {
+			return false;
+		}
+		v = LoadNet<T>(p);
+		return true;
+	}
+};
+
+template <>
+struct Codec<StringView> {
+	static size_t bytes(StringView v, framing_type) { return v.size(); }
+	static void write(StringView v, char* out, size_t n, framing_type) { ::memcpy(out, v.data(), n); }
+
+	static bool read(const char* p, size_t len, StringView& v, framing_type)
+	{
+		v = StringView(p, len);
+		return true;
+	}
+};
+
+template <>
+struct Codec<std::string> {
+	static size_t bytes(const std::string& v, framing_type) { return v.size(); }
+	static void write(const std::string& v, char* out, size_t n, framing_type) { ::memcpy(out, v.data(), n); }
+
+	static bool read(const char* p, size_t len, std::string& v, framing_type)
+	{
+		v.assign(p, len);
+		return true;
+	}
+};
+
+// element by element byte swaps : the loops vectorize to byte shuffles where the target
+// has them ( SSSE3 and up ), plain bswap otherwise
+template <typename T, size_t N>
+struct Codec<std::array<T, N>, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type> {
+	static size_t bytes(const std::array<T, N>&, framing_type) { return N * sizeof(T); }
+
+	static void write(const std::array<T, N>& v, char* out, size_t, framing_type)
+	{
+		for ( size_t i = 0; i < N; ++i ) {
+			StoreNet(v[i], out + i * sizeof(T));
+		}
+	}
+
+	static bool read(const char* p, size_t len, std::array<T, N>& v, framing_type)
+	{
+		if ( len != N * sizeof(T) ) {
+			return false;
+		}
+		for ( size_t i = 0; i < N; ++i ) {
+			v[i] = LoadNet<T>(p + i * sizeof(T));
+		}
+		return true;
+	}
+};
+
+////////////////////////////////////////////////////
+
+template <uint16_t Tag, typename... Fields>
+struct HasTag : std::false_type {};
+
+template <uint16_t Tag, typename F, typename... Rest>
+struct HasTag<Tag, F, Rest...> :
+	std::integral_constant<bool, F::tag == Tag || HasTag<Tag, Rest...>::value> {};
+
+template <typename... Fields>
+struct UniqueTags : std::true_type {};
+
+template <typename F, typename... Rest>
+struct UniqueTags<F, Rest...> :
+	std::integral_constant<bool, !HasTag<F::tag, Rest...>::value && UniqueTags<Rest...>::value> {};
+
+// the fields of a schema, one step per field : all of it inlines into the caller
+template <typename... Fields>
+struct FieldList {
+	template <typename Record>
+	static size_t bytes(const Record&, framing_type) { return 0; }
+
+	template <typename Record>
+	static char* write(const Record&, char* out, framing_type) { return out; }
+
+	// an unknown tag, skipped
+	template <typename Record>
+	static bool read(uint16_t, const char*, size_t, Record&, framing_type) { return true; }
+};
+
+template <typename F, typename... Rest>
+struct FieldList<F, Rest...> {
+	typedef Codec<typename F::value_type> codec_type;
+	typedef FieldList<Rest...> rest_type;
+
+	template <typename Record>
+	static size_t bytes(const Record& rec, framing_type f)
+	{
+		static_assert(std::is_base_of<typename F::record_type, Record>::value, "a field of another record");
+		size_t n = codec_type::bytes(F::get(rec), f);
+		return HeadBytesOf(F::tag, (uint32_t)n, f) + n + rest_type::bytes(rec, f);
+	}
+
+	template <typename Record>
+	static char* write(const Record& rec, char* out, framing_type f)
+	{
+		size_t n = codec_type::bytes(F::get(rec), f);
+		out += PutHead(F::tag, (uint32_t)n, out, f);
+		codec_type::write(F::get(rec), out, n, f);
+		return rest_type::write(rec, out + n, f);
+	}
+
+	template <typename Record>
+	static bool read(uint16_t tag, const char* p, size_t len, Record& rec, framing_type f)
+	{
+		if ( tag == F::tag ) {
+			return codec_type::read(p, len, F::get(rec), f);
+		}
+		return rest_type::read(tag, p, len, rec, f);
+	}
+};
+
+template <typename Schema>
+struct SchemaTraits;
+
+template <typename... Fields>
+struct SchemaTraits<Schema<Fields...> > {
+	static_assert(UniqueTags<Fields...>::value, "two fields with the same tag");
+	typedef FieldList<Fields...> field_list_type;
+};
+
+template <typename Record>
+struct RecordTraits {
+	static_assert(IsRecord<Record>::value, "not a record : no schema_type");
+	typedef typename SchemaTraits<typename Record::schema_type>::field_list_type field_list_type;
+};
+
+// a nested record
+template <typename T>
+struct Codec<T, typename std::enable_if<IsRecord<T>::value>::type> {
+	static size_t bytes(const T& v, framing_type f) { return RecordBytes(v, f); }
+	static void write(const T& v, char* out, size_t, framing_type f) { EncodeRecord(v, out, f); }
+	static bool read(const char* p, size_t len, T& v, framing_type f) { return DecodeRecord(StringView(p, len), v, f); }
+};
+
+}	// namespace details
+
+template <typename Record>
+inline size_t RecordBytes(const Record& rec, framing_type f)
+{
+	return details::RecordTraits<Record>::field_list_type::bytes(rec, f);
+}
+
+template <typename Record>
+inline size_t EncodeRecord(const Record& rec, char* out, framing_type f)
+{
+	return (size_t)(details::RecordTraits<Record>::field_list_type::write(rec, out, f) - out);
+}
+
+template <typename Record>
+inline size_t SerializeRecord(uint16_t type, const Record& rec, asio::DynamicBuffer& buffer, framing_type f)
+{
+	size_t n = RecordBytes(rec, f);
+	if ( n > 0xFFFFFFFF ) {
+		return 0;
+	}
+	buffer.reserve(MAX_HEAD_BYTES + n);
+	char* out = buffer.writeBegin();
+	size_t head_bytes = details::PutHead(type, (uint32_t)n, out, f);
+	EncodeRecord(rec, out + head_bytes, f);
+	buffer.write(head_bytes + n);
+	return head_bytes + n;
+}
+
+template <typename Record>
+inline bool DecodeRecord(StringView value, Record& rec, framing_type f)
+{
+	typedef typename details::RecordTraits<Record>::field_list_type field_list_type;
+
+	const char* p = value.data();
+	size_t len = value.size();
+	size_t at = 0;
+	while ( at < len ) {
+		uint16_t tag;
+		uint32_t length;
+		size_t head_bytes;
+		if ( !details::GetHead(p + at, len - at, f, tag, length, head_bytes) ||
+			 length > len - at - head_bytes ) {
+			return false;
+		}
+		if ( !field_list_type::read(tag, p + at + head_bytes, length, rec, f) ) {
+			return false;
+		}
+		at += head_bytes + length;
+	}
+	return true;
+}
+
+}	// namespace tlv
+}	// namespace protocol
+}	// namespace lcy
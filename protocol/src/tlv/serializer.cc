@@ -0,0 +1,69 @@
+#include "lcy/protocol/src/tlv/serializer.h"
+#include "lcy/protocol/src/tlv/variant_encode.h"
+
+#include <string.h>
+#include <arpa/inet.h>
+
+namespace lcy {
+namespace protocol {
+namespace tlv {
+
+size_t HeadBytes(uint16_t type, uint32_t length, framing_type f)
+{
+	if ( f == framing::COMPACT ) {
+		return VariantLengthUint32(type) + VariantLengthUint32(length);
+	}
+	return HEAD_BYTES;
+}
+
+size_t SerializeHead(uint16_t type, uint32_t length, char* out, framing_type f)
+{
+	if ( f == framing::COMPACT ) {
+		return WriteCompactHead(type, length, out, MAX_HEAD_BYTES);
+	}
+
+	uint16_t type_tmp = htons(type);
+	uint32_t length_tmp = htonl(length);
+
+	::memcpy(out, &type_tmp, TYPE_BYTES);
+	::memcpy(out + TYPE_BYTES, &length_tmp, LENGTH_BYTES);
+	return HEAD_BYTES;
+}
+
+size_t SerializeMessage(uint16_t type, StringView value, asio::DynamicBuffer& buffer, framing_type f)
+{
+	buffer.reserve(MAX_HEAD_BYTES + value.size());
+
+	char* out = buffer.writeBegin();
+	size_t head_bytes = SerializeHead(type, (uint32_t)value.size(), out, f);
+	if ( !value.empty() ) {
+		::memcpy(out + head_bytes, value.data(), value.size());
+	}
+	buffer.write(head_bytes + value.size());
+
+	return head_bytes + value.size();
+}
+
+size_t SerializeMessage(const Message& msg, asio::DynamicBuffer& buffer, framing_type f)
+{
+	if ( msg.value().size() < msg.length() ) {
+		return 0;
+	}
+	return SerializeMessage(msg.type(), StringView(msg.value().data(), msg.length()), buffer, f);
+}
+
+size_t SerializeMessage(uint16_t type, StringView value, char* head, struct iovec iov[2], framing_type f)
+{
+	size_t head_bytes = SerializeHead(type, (uint32_t)value.size(), head, f);
+
+	iov[0].iov_base = head;
+	iov[0].iov_len = head_bytes;
+	iov[1].iov_base = (void*)value.data();
+	iov[1].iov_len = value.size();
+
+	return head_bytes + value.size();
+}
+
+}	// namespace tlv
+}	// namespace protocol
+}	// namespace lcy
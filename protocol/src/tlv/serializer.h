@@ -0,0 +1,45 @@
+#ifndef __LCY_PROTOCOL_TLV_SERIALIZER_H__
+#define __LCY_PROTOCOL_TLV_SERIALIZER_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+#include "lcy/asio/src/dynamic_buffer.h"
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/tlv/message.h"
+
+namespace lcy {
+namespace protocol {
+namespace tlv {
+
+/*
+* Wire format writers without intermediate strings.
+*
+* notify :
+*	The DynamicBuffer variants reserve the whole message once, then copy the head and
+*	the value straight in. The iovec variant copies only the head, into `head`, and
+*	points the second buffer at the value itself : both must outlive the write.
+*	`head` holds MAX_HEAD_BYTES, what the framing needs at most.
+*/
+
+// bytes of the head, HEAD_BYTES or 2 to COMPACT_MAX_HEAD_BYTES
+size_t HeadBytes(uint16_t type, uint32_t length, framing_type f = framing::FIXED);
+// type and length into `out`, returns the bytes written
+size_t SerializeHead(uint16_t type, uint32_t length, char* out, framing_type f = framing::FIXED);
+
+// appends the message, returns the bytes written
+size_t SerializeMessage(uint16_t type, StringView value, asio::DynamicBuffer& buffer,
+						framing_type f = framing::FIXED);
+// nothing if value() is shorter than length(), as dump()
+size_t SerializeMessage(const Message& msg, asio::DynamicBuffer& buffer, framing_type f = framing::FIXED);
+
+// iov[0] the head in `head`, iov[1] the value, for writev(2) or sendmsg(2)
+size_t SerializeMessage(uint16_t type, StringView value, char* head, struct iovec iov[2],
+						framing_type f = framing::FIXED);
+
+}	// namespace tlv
+}	// namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_TLV_SERIALIZER_H__
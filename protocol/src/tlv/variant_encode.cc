@@ -1,5 +1,12 @@
 #include "lcy/protocol/src/tlv/variant_encode.h"
 
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LCY_PROTOCOL_VARIANT_X86 1
+#include <immintrin.h>
+#endif
+
 namespace lcy {
 namespace protocol {
 namespace tlv {
@@ -79,7 +86,7 @@ int64_t ZigzagDecodeUint64(uint64_t v)
 	type tmp = 0;											\
 															\
 	size_t shift = 0;										\
-	uint8_t* buf_ptr = (uint8_t*)buf;						\
+	const uint8_t* buf_ptr = (const uint8_t*)buf;			\
 	for ( size_t i = 0; i < max_len && i < len; ++i ) {		\
 		tmp |= ((type)(buf_ptr[i] & 0x7f)) << shift;		\
 															\
@@ -98,7 +105,7 @@ size_t VariantEncodeUint8(uint8_t v, void* buf, size_t len)
 	VARIANT_ENCODE(BUFLEN_UINT8, v, buf, len)
 }
 
-bool VariantDecodeUint8(uint8_t& v, void* buf, size_t len)
+bool VariantDecodeUint8(uint8_t& v, const void* buf, size_t len)
 {
 	VARIANT_DECODE(uint8_t, BUFLEN_UINT8, v, buf, len)
 }
@@ -108,7 +115,7 @@ size_t VariantEncodeUint16(uint16_t v, void* buf, size_t len)
 	VARIANT_ENCODE(BUFLEN_UINT16, v, buf, len)
 }
 
-bool VariantDecodeUint16(uint16_t& v, void* buf, size_t len)
+bool VariantDecodeUint16(uint16_t& v, const void* buf, size_t len)
 {
 	VARIANT_DECODE(uint16_t, BUFLEN_UINT16, v, buf, len)
 }
@@ -118,7 +125,7 @@ size_t VariantEncodeUint32(uint32_t v, void* buf, size_t len)
 	VARIANT_ENCODE(BUFLEN_UINT32, v, buf, len)
 }
 
-bool VariantDecodeUint32(uint32_t& v, void* buf, size_t len)
+bool VariantDecodeUint32(uint32_t& v, const void* buf, size_t len)
 {
 	VARIANT_DECODE(uint32_t, BUFLEN_UINT32, v, buf, len)
 }
@@ -128,7 +135,7 @@ size_t VariantEncodeUint64(uint64_t v, void* buf, size_t len)
 	VARIANT_ENCODE(BUFLEN_UINT64, v, buf, len)
 }
 
-bool VariantDecodeUint64(uint64_t& v, void* buf, size_t len)
+bool VariantDecodeUint64(uint64_t& v, const void* buf, size_t len)
 {
 	VARIANT_DECODE(uint64_t, BUFLEN_UINT64, v, buf, len)
 }
@@ -137,6 +144,202 @@ bool VariantDecodeUint64(uint64_t& v, void* buf, size_t len)
 
 #undef VARIANT_DECODE
 
+////////////////////////////////////////////////////
+
+// what follows a run of one byte varints, or the tail
+static inline bool DecodeOne(const uint8_t* p, size_t len, size_t& at, uint32_t* out, size_t& n)
+{
+	size_t r = VariantReadUint32(p + at, len - at, out[n]);
+	if ( r == 0 ) {
+		return false;
+	}
+	at += r;
+	++n;
+	return true;
+}
+
+static size_t DecodeStreamScalar(const uint8_t* p, size_t len, uint32_t* out, size_t count, size_t& nread)
+{
+	size_t at = 0;
+	size_t n = 0;
+	while ( n < count ) {
+#ifdef LCY_PROTOCOL_VARIANT_WORD
+		if ( len - at >= 8 && count - n >= 8 ) {
+			uint64_t word;
+			::memcpy(&word, p + at, 8);
+			if ( (word & details::VARIANT_HIGH_BITS) == 0 ) {
+				for ( size_t i = 0; i < 8; ++i ) {
+					out[n + i] = p[at + i];
+				}
+				at += 8;
+				n += 8;
+				continue;
+			}
+		}
+#endif
+		if ( at == len || !DecodeOne(p, len, at, out, n) ) {
+			break;
+		}
+	}
+
+	nread = at;
+	return n;
+}
+
+#ifdef LCY_PROTOCOL_VARIANT_X86
+
+// 16 bytes to 16 uint32
+__attribute__((target("sse2")))
+static inline void WidenSSE2(__m128i v, uint32_t* out)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo = _mm_unpacklo_epi8(v, zero);
+	__m128i hi = _mm_unpackhi_epi8(v, zero);
+	_mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(lo, zero));
+	_mm_storeu_si128((__m128i*)(out + 4), _mm_unpackhi_epi16(lo, zero));
+	_mm_storeu_si128((__m128i*)(out + 8), _mm_unpacklo_epi16(hi, zero));
+	_mm_storeu_si128((__m128i*)(out + 12), _mm_unpackhi_epi16(hi, zero));
+}
+
+/*
+* notify :
+*	The movemask of a block is its continuation bits : none, every byte is a varint
+*	and the block is widened whole. Otherwise the bytes below the first set bit are
+*	widened all the same ( the lanes after them are written over later, there is
+*	room for a whole block in `out` ) and the varint there is read on its own. A block
+*	starting with a longer varint is not widened at all.
+*/
+__attribute__((target("sse2")))
+static size_t DecodeStreamSSE2(const uint8_t* p, size_t len, uint32_t* out, size_t count, size_t& nread)
+{
+	size_t at = 0;
+	size_t n = 0;
+	while ( n < count ) {
+		if ( len - at >= 16 && count - n >= 16 ) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(p + at));
+			uint32_t mask = (uint32_t)_mm_movemask_epi8(v);
+			if ( !(mask & 1) ) {
+				WidenSSE2(v, out + n);
+				if ( mask == 0 ) {
+					at += 16;
+					n += 16;
+					continue;
+				}
+				size_t run = (size_t)__builtin_ctz(mask);
+				at += run;
+				n += run;
+			}
+		}
+		if ( at == len || !DecodeOne(p, len, at, out, n) ) {
+			break;
+		}
+	}
+
+	nread = at;
+	return n;
+}
+
+__attribute__((target("avx2")))
+static size_t DecodeStreamAVX2(const uint8_t* p, size_t len, uint32_t* out, size_t count, size_t& nread)
+{
+	size_t at = 0;
+	size_t n = 0;
+	while ( n < count ) {
+		if ( len - at >= 32 && count - n >= 32 ) {
+			__m256i v = _mm256_loadu_si256((const __m256i*)(p + at));
+			uint32_t mask = (uint32_t)_mm256_movemask_epi8(v);
+			if ( !(mask & 1) ) {
+				for ( size_t i = 0; i < 32; i += 8 ) {
+					__m128i bytes = _mm_loadl_epi64((const __m128i*)(p + at + i));
+					_mm256_storeu_si256((__m256i*)(out + n + i), _mm256_cvtepu8_epi32(bytes));
+				}
+				if ( mask == 0 ) {
+					at += 32;
+					n += 32;
+					continue;
+				}
+				size_t run = (size_t)__builtin_ctz(mask);
+				at += run;
+				n += run;
+			}
+		}
+		if ( at == len || !DecodeOne(p, len, at, out, n) ) {
+			break;
+		}
+	}
+
+	nread = at;
+	return n;
+}
+
+#endif	// LCY_PROTOCOL_VARIANT_X86
+
+typedef size_t (*decode_stream_type)(const uint8_t*, size_t, uint32_t*, size_t, size_t&);
+
+static http::scan_level_type SupportedLevel()
+{
+#ifdef LCY_PROTOCOL_VARIANT_X86
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports("avx2") ) {
+		return http::scan_level::AVX2;
+	}
+	if ( __builtin_cpu_supports("sse2") ) {
+		return http::scan_level::SSE2;
+	}
+#endif
+	return http::scan_level::SCALAR;
+}
+
+struct VariantTable {
+	http::scan_level_type level;
+	decode_stream_type decode_stream;
+
+	VariantTable() { select(SupportedLevel()); }
+
+	void select(http::scan_level_type l)
+	{
+		level = http::scan_level::SCALAR;
+		decode_stream = &DecodeStreamScalar;
+
+#ifdef LCY_PROTOCOL_VARIANT_X86
+		if ( l == http::scan_level::AVX2 ) {
+			level = l;
+			decode_stream = &DecodeStreamAVX2;
+		} else if ( l == http::scan_level::SSE2 ) {
+			level = l;
+			decode_stream = &DecodeStreamSSE2;
+		}
+#endif
+	}
+};
+
+static VariantTable& Table()
+{
+	static VariantTable table;
+	return table;
+}
+
+size_t VariantDecodeStreamUint32(const void* buf, size_t len, uint32_t* out, size_t count, size_t& nread)
+{
+	return Table().decode_stream((const uint8_t*)buf, len, out, count, nread);
+}
+
+http::scan_level_type VariantLevel()
+{
+	return Table().level;
+}
+
+http::scan_level_type SetVariantLevel(http::scan_level_type level)
+{
+	static const http::scan_level_type supported = SupportedLevel();
+	if ( (uint8_t)level > (uint8_t)supported ) {
+		level = supported;
+	}
+
+	Table().select(level);
+	return Table().level;
+}
+
 }	// namespace tlv
 }	// namespace protocol
 }	// namespace lcy
@@ -3,6 +3,13 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
+
+#include "lcy/protocol/src/http/scan.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define LCY_PROTOCOL_VARIANT_WORD 1
+#endif
 
 namespace lcy {
 namespace protocol {
@@ -27,16 +34,225 @@ constexpr size_t BUFLEN_UINT32 = (((sizeof(uint32_t) * 8) / 7) + 1);
 constexpr size_t BUFLEN_UINT64 = (((sizeof(uint64_t) * 8) / 7) + 1);
 
 size_t VariantEncodeUint8(uint8_t v, void* buf, size_t len);
-bool VariantDecodeUint8(uint8_t& v, void* buf, size_t len);
+bool VariantDecodeUint8(uint8_t& v, const void* buf, size_t len);
 
 size_t VariantEncodeUint16(uint16_t v, void* buf, size_t len);
-bool VariantDecodeUint16(uint16_t& v, void* buf, size_t len);
+bool VariantDecodeUint16(uint16_t& v, const void* buf, size_t len);
 
 size_t VariantEncodeUint32(uint32_t v, void* buf, size_t len);
-bool VariantDecodeUint32(uint32_t& v, void* buf, size_t len);
+bool VariantDecodeUint32(uint32_t& v, const void* buf, size_t len);
 
 size_t VariantEncodeUint64(uint64_t v, void* buf, size_t len);
-bool VariantDecodeUint64(uint64_t& v, void* buf, size_t len);
+bool VariantDecodeUint64(uint64_t& v, const void* buf, size_t len);
+
+/*
+* Kernels, bounds checked and on const buffers. Inline ( defined at the end of this
+* file ) for the framings and the record codecs, which all go through them.
+*
+* The length comes from the count of leading zeros, without a loop. Readers and
+* writers move 8 bytes with one load or store while the buffer has room for them,
+* the byte loop only runs near its end ( or for the 9 and 10 byte varints of 64 bit
+* values ). Unlike VariantDecodeUint*, a varint longer than the type allows or above
+* its range is rejected.
+*/
+inline size_t VariantLengthUint32(uint32_t v)
+{
+	// (bits + 6) / 7 for 1 to 64 bits
+	return (size_t)(((32 - __builtin_clz(v | 1)) * 9 + 64) / 64);
+}
+
+inline size_t VariantLengthUint64(uint64_t v)
+{
+	return (size_t)(((64 - __builtin_clzll(v | 1)) * 9 + 64) / 64);
+}
+
+// returns the bytes written, 0 if `len` is too small. Bytes past the varint, up to `len`, may be overwritten
+inline size_t VariantWriteUint32(uint32_t v, void* buf, size_t len);
+inline size_t VariantWriteUint64(uint64_t v, void* buf, size_t len);
+// returns the bytes read, 0 if `len` ends before the varint or it does not fit the type
+inline size_t VariantReadUint32(const void* buf, size_t len, uint32_t& v);
+inline size_t VariantReadUint64(const void* buf, size_t len, uint64_t& v);
+
+/*
+* Consecutive varints, up to `count` of them into `out` : returns how many, `nread`
+* is the bytes they took. Stops at a truncated or malformed varint.
+*
+* On x86 runs of one byte varints are widened 16 ( SSE2 ) or 32 ( AVX2 ) at a time
+* from the mask of their continuation bits, the scalar level does 8 with one 64 bit
+* word. Other varints are read as by VariantReadUint32. All levels return the same.
+*/
+size_t VariantDecodeStreamUint32(const void* buf, size_t len, uint32_t* out, size_t count, size_t& nread);
+
+http::scan_level_type VariantLevel();
+/*
+* notify :
+*	For tests and benchmarks, not thread safe : call before any decoding starts.
+*	A level above what the CPU supports is clamped, the level in effect is returned.
+*/
+http::scan_level_type SetVariantLevel(http::scan_level_type level);
+
+////////////////////////////////////////////////////
+
+namespace details {
+
+static const uint64_t VARIANT_HIGH_BITS = 0x8080808080808080ull;
+static const uint64_t VARIANT_LOW_BITS = 0x7F7F7F7F7F7F7F7Full;
+
+inline size_t VariantWriteBytes(uint64_t v, uint8_t* p, size_t len)
+{
+	size_t count = 0;
+	while ( v > 0x7F ) {
+		if ( count == len ) {
+			return 0;
+		}
+		p[count++] = (uint8_t)((v & 0x7F) | 0x80);
+		v >>= 7;
+	}
+	if ( count == len ) {
+		return 0;
+	}
+	p[count++] = (uint8_t)v;
+	return count;
+}
+
+// `max` bytes at most, 0 if truncated or longer
+inline size_t VariantReadBytes(const uint8_t* p, size_t len, size_t max, uint64_t& v)
+{
+	uint64_t tmp = 0;
+	for ( size_t i = 0; i < max && i < len; ++i ) {
+		tmp |= (uint64_t)(p[i] & 0x7F) << (7 * i);
+		if ( !(p[i] & 0x80) ) {
+			v = tmp;
+			return i + 1;
+		}
+	}
+	return 0;
+}
+
+#ifdef LCY_PROTOCOL_VARIANT_WORD
+
+/*
+* notify :
+*	The 7 bit groups of a value below 2^56 are spread to one per byte by three shift
+*	and mask steps, and gathered back the same way : no loop, no branch per byte.
+*/
+inline uint64_t VariantSpread(uint64_t x)
+{
+	x = (x & 0x000000000FFFFFFFull) | ((x & 0x00FFFFFFF0000000ull) << 4);
+	x = (x & 0x00003FFF00003FFFull) | ((x & 0x0FFFC0000FFFC000ull) << 2);
+	x = (x & 0x007F007F007F007Full) | ((x & 0x3F803F803F803F80ull) << 1);
+	return x;
+}
+
+inline uint64_t VariantGather(uint64_t x)
+{
+	x = (x & 0x007F007F007F007Full) | ((x & 0x7F007F007F007F00ull) >> 1);
+	x = (x & 0x00003FFF00003FFFull) | ((x & 0x3FFF00003FFF0000ull) >> 2);
+	x = (x & 0x000000000FFFFFFFull) | ((x & 0x0FFFFFFF00000000ull) >> 4);
+	return x;
+}
+
+// v below 2^56 and 8 bytes of room
+inline size_t VariantWriteWord(uint64_t v, uint8_t* p)
+{
+	size_t n = VariantLengthUint64(v);
+	uint64_t word = VariantSpread(v) | (VARIANT_HIGH_BITS & ((1ull << (8 * (n - 1))) - 1));
+	::memcpy(p, &word, 8);
+	return n;
+}
+
+// 8 bytes readable, 0 if the varint is longer than 8 bytes
+inline size_t VariantReadWord(const uint8_t* p, uint64_t& v)
+{
+	uint64_t word;
+	::memcpy(&word, p, 8);
+	uint64_t ends = ~word & VARIANT_HIGH_BITS;
+	if ( ends == 0 ) {
+		return 0;
+	}
+	// the bytes up to the first without a continuation bit
+	word &= (ends ^ (ends - 1)) & VARIANT_LOW_BITS;
+	v = VariantGather(word);
+	return (size_t)(__builtin_ctzll(ends) >> 3) + 1;
+}
+
+#endif	// LCY_PROTOCOL_VARIANT_WORD
+
+}	// namespace details
+
+inline size_t VariantWriteUint32(uint32_t v, void* buf, size_t len)
+{
+	if ( v < 0x80 && len != 0 ) {
+		*(uint8_t*)buf = (uint8_t)v;
+		return 1;
+	}
+#ifdef LCY_PROTOCOL_VARIANT_WORD
+	if ( len >= 8 ) {
+		return details::VariantWriteWord(v, (uint8_t*)buf);
+	}
+#endif
+	return details::VariantWriteBytes(v, (uint8_t*)buf, len);
+}
+
+inline size_t VariantWriteUint64(uint64_t v, void* buf, size_t len)
+{
+#ifdef LCY_PROTOCOL_VARIANT_WORD
+	if ( len >= 8 && v < (1ull << 56) ) {
+		return details::VariantWriteWord(v, (uint8_t*)buf);
+	}
+#endif
+	return details::VariantWriteBytes(v, (uint8_t*)buf, len);
+}
+
+inline size_t VariantReadUint32(const void* buf, size_t len, uint32_t& v)
+{
+	const uint8_t* p = (const uint8_t*)buf;
+	if ( len != 0 && p[0] < 0x80 ) {
+		v = p[0];
+		return 1;
+	}
+	uint64_t tmp = 0;
+	size_t n;
+#ifdef LCY_PROTOCOL_VARIANT_WORD
+	if ( len >= 8 ) {
+		n = details::VariantReadWord(p, tmp);
+	} else
+#endif
+	{
+		n = details::VariantReadBytes(p, len, BUFLEN_UINT32, tmp);
+	}
+
+	// 5 bytes hold 35 bits
+	if ( n == 0 || n > BUFLEN_UINT32 || tmp > 0xFFFFFFFFull ) {
+		return 0;
+	}
+	v = (uint32_t)tmp;
+	return n;
+}
+
+inline size_t VariantReadUint64(const void* buf, size_t len, uint64_t& v)
+{
+	const uint8_t* p = (const uint8_t*)buf;
+	uint64_t tmp = 0;
+	size_t n = 0;
+#ifdef LCY_PROTOCOL_VARIANT_WORD
+	if ( len >= 8 ) {
+		n = details::VariantReadWord(p, tmp);
+	}
+#endif
+	if ( n == 0 ) {
+		n = details::VariantReadBytes(p, len, BUFLEN_UINT64, tmp);
+		// 10 bytes hold 70 bits : the last one is 0 or 1
+		if ( n == BUFLEN_UINT64 && p[9] > 1 ) {
+			return 0;
+		}
+	}
+	if ( n == 0 ) {
+		return 0;
+	}
+	v = tmp;
+	return n;
+}
 
 }	// namespace tlv
 }	// namespace protocol
@@ -0,0 +1,484 @@
+#include "lcy/protocol/src/websocket/connection.h"
+#include "lcy/protocol/src/websocket/handshake.h"
+#include "lcy/protocol/src/websocket/deflate.h"
+#include "lcy/protocol/src/http/request_view.h"
+#include "lcy/protocol/src/http/response.h"
+
+#include "lcy/asio/src/dynamic_buffer.h"
+
+#include <string>
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace websocket {
+
+bool IsUtf8(StringView data)
+{
+	const uint8_t* ptr = (const uint8_t*)data.data();
+	const uint8_t* end = ptr + data.size();
+
+	while ( ptr < end ) {
+		// ASCII runs, 8 bytes at a time
+		while ( end - ptr >= 8 ) {
+			uint64_t word;
+			::memcpy(&word, ptr, 8);
+			if ( word & 0x8080808080808080ULL ) {
+				break;
+			}
+			ptr += 8;
+		}
+		if ( ptr == end ) {
+			break;
+		}
+
+		uint8_t c = *ptr;
+		if ( c < 0x80 ) {
+			++ptr;
+			continue;
+		}
+
+		size_t n = 0;
+		uint8_t lo = 0x80, hi = 0xBF;		// range of the second byte
+		if ( c >= 0xC2 && c <= 0xDF ) {
+			n = 1;
+		} else if ( c >= 0xE0 && c <= 0xEF ) {
+			n = 2;
+			if ( c == 0xE0 ) lo = 0xA0;		// overlong
+			if ( c == 0xED ) hi = 0x9F;		// surrogates
+		} else if ( c >= 0xF0 && c <= 0xF4 ) {
+			n = 3;
+			if ( c == 0xF0 ) lo = 0x90;		// overlong
+			if ( c == 0xF4 ) hi = 0x8F;		// above U+10FFFF
+		} else {
+			return false;
+		}
+
+		if ( (size_t)(end - ptr) <= n || ptr[1] < lo || ptr[1] > hi ) {
+			return false;
+		}
+		for ( size_t i = 2; i <= n; ++i ) {
+			if ( (ptr[i] & 0xC0) != 0x80 ) {
+				return false;
+			}
+		}
+		ptr += n + 1;
+	}
+	return true;
+}
+
+// codes a peer may send ( RFC 6455 7.4 )
+static bool ValidCloseCode(uint16_t code)
+{
+	if ( code >= 3000 && code <= 4999 ) {
+		return true;
+	}
+	return (code >= 1000 && code <= 1003) || (code >= 1007 && code <= 1011);
+}
+
+///////////////////////////////////////////////////////////////
+
+class Connection::Impl {
+public:
+	Impl(const http::Server::stream_ptr& stream, const Options& options) :
+		ioc(stream->context()),
+		stream(stream),
+		options(options),
+		in(4096),
+		out(4096),
+		message_op(opcode::TEXT),
+		in_message(false),
+		message_compressed(false),
+		sending(false),
+		send_compressed(false),
+		close_sent(false),
+		closed(false)
+	{
+		parser.setMaxPayloadBytes(options.max_message_bytes);
+	}
+
+	void receive(StringView piece);
+	bool handle(Frame& frame);
+	bool handleClose(StringView payload);
+	bool deliver(opcode_type op, StringView data, bool compressed);
+
+	bool writeFrame(opcode_type op, StringView payload, bool fin, bool rsv1);
+	void sendClose(uint16_t code, StringView reason);
+	bool fail(uint16_t code);
+	void finish(uint16_t code, StringView reason);
+
+	asio::IOContext& ioc;
+	http::Server::stream_ptr stream;		// reset once closed
+	Options options;
+	FrameParser parser;
+	asio::DynamicBuffer in;
+	asio::DynamicBuffer out;
+	std::unique_ptr<Deflate> deflate;
+
+	std::string message;		// fragments being joined
+	std::string inflated;
+	std::string compressed;		// outgoing
+	opcode_type message_op;
+	bool in_message;
+	bool message_compressed;
+	bool sending;				// a fragmented message is being sent
+	bool send_compressed;
+	bool close_sent;
+	bool closed;
+
+	message_handler_type on_message;
+	pong_handler_type on_pong;
+	close_handler_type on_close;
+};
+
+void Connection::Impl::receive(StringView piece)
+{
+	if ( closed ) {
+		return;
+	}
+
+	in.reserve(piece.size());
+	::memcpy(in.writeBegin(), piece.data(), piece.size());
+	in.write(piece.size());
+
+	Frame frame;
+	while ( !closed ) {
+		FrameParser::RetCode retcode = parser.parse(in, frame);
+		if ( retcode == FrameParser::WAITING_DATA ) {
+			break;
+		}
+		if ( retcode == FrameParser::ERROR ) {
+			fail(parser.errcode() == FrameParser::ErrCode::TOO_LARGE ? CLOSE_TOO_BIG : CLOSE_PROTOCOL_ERROR);
+			return;
+		}
+		if ( !handle(frame) ) {
+			return;
+		}
+	}
+}
+
+bool Connection::Impl::handle(Frame& frame)
+{
+	if ( IsControl(frame.opcode) ) {
+		if ( frame.rsv1 ) {
+			return fail(CLOSE_PROTOCOL_ERROR);
+		}
+
+		switch ( frame.opcode ) {
+			case opcode::PING :
+				if ( !close_sent ) {
+					writeFrame(opcode::PONG, frame.payload, true, false);
+				}
+				return !closed;
+			case opcode::PONG :
+				if ( on_pong ) {
+					pong_handler_type handler = on_pong;
+					handler(frame.payload);
+				}
+				return !closed;
+			default :
+				return handleClose(frame.payload);
+		}
+	}
+
+	if ( frame.opcode == opcode::CONTINUATION ) {
+		if ( !in_message || frame.rsv1 ) {
+			return fail(CLOSE_PROTOCOL_ERROR);
+		}
+	} else {
+		if ( in_message || (frame.rsv1 && !deflate) ) {
+			return fail(CLOSE_PROTOCOL_ERROR);
+		}
+		message_op = frame.opcode;
+		message_compressed = frame.rsv1;
+	}
+
+	// a whole message in one frame goes out of the receive buffer as it is
+	if ( frame.fin && !in_message ) {
+		return deliver(message_op, frame.payload, message_compressed);
+	}
+
+	if ( options.max_message_bytes > 0 &&
+		 message.size() + frame.payload.size() > options.max_message_bytes ) {
+		return fail(CLOSE_TOO_BIG);
+	}
+	message.append(frame.payload.data(), frame.payload.size());
+	in_message = !frame.fin;
+	if ( !frame.fin ) {
+		return true;
+	}
+
+	bool open = deliver(message_op, StringView(message), message_compressed);
+	message.clear();
+	return open;
+}
+
+bool Connection::Impl::handleClose(StringView payload)
+{
+	uint16_t code = CLOSE_NO_STATUS;
+	StringView reason;
+	if ( payload.size() == 1 ) {
+		return fail(CLOSE_PROTOCOL_ERROR);
+	}
+	if ( payload.size() >= 2 ) {
+		code = (uint16_t)(((uint8_t)payload[0] << 8) | (uint8_t)payload[1]);
+		reason = payload.substr(2);
+		if ( !ValidCloseCode(code) ) {
+			return fail(CLOSE_PROTOCOL_ERROR);
+		}
+		if ( !IsUtf8(reason) ) {
+			return fail(CLOSE_INVALID_PAYLOAD);
+		}
+	}
+
+	if ( !close_sent ) {
+		sendClose(code, StringView());
+	}
+	finish(code, reason);
+	return false;
+}
+
+bool Connection::Impl::deliver(opcode_type op, StringView data, bool compressed)
+{
+	if ( close_sent ) {
+		return true;		// waiting for the answer to our close frame, data goes
+	}
+
+	if ( compressed ) {
+		inflated.clear();
+		if ( !deflate->decompress(data, inflated, options.max_message_bytes) ) {
+			return fail(CLOSE_INVALID_PAYLOAD);
+		}
+		data = StringView(inflated);
+	}
+
+	if ( op == opcode::TEXT && !IsUtf8(data) ) {
+		return fail(CLOSE_INVALID_PAYLOAD);
+	}
+
+	if ( on_message ) {
+		message_handler_type handler = on_message;		// may close the connection
+		handler(op, data);
+	}
+	return !closed;
+}
+
+bool Connection::Impl::writeFrame(opcode_type op, StringView payload, bool fin, bool rsv1)
+{
+	if ( !stream ) {
+		return false;
+	}
+
+	SerializeFrame(out, op, payload, fin, rsv1);
+	StringView wire(out.readBegin(), out.dataBytes());
+	http::Server::stream_ptr keep = stream;		// a failed write closes the connection
+	bool ok = keep->write(wire);
+	out.read(wire.size());
+	return ok && !closed;
+}
+
+void Connection::Impl::sendClose(uint16_t code, StringView reason)
+{
+	close_sent = true;
+
+	char payload[MAX_CONTROL_PAYLOAD];
+	size_t len = 0;
+	if ( code != CLOSE_NO_STATUS && code != CLOSE_ABNORMAL ) {
+		payload[0] = (char)(code >> 8);
+		payload[1] = (char)code;
+		len = reason.size();
+		if ( len > sizeof(payload) - 2 ) {
+			// cut before the code point that does not fit, not inside it
+			len = sizeof(payload) - 2;
+			while ( len > 0 && ((uint8_t)reason[len] & 0xC0) == 0x80 ) {
+				--len;
+			}
+		}
+		if ( len > 0 ) {
+			::memcpy(payload + 2, reason.data(), len);
+		}
+		len += 2;
+	}
+	writeFrame(opcode::CLOSE, StringView(payload, len), true, false);
+}
+
+bool Connection::Impl::fail(uint16_t code)
+{
+	if ( !close_sent ) {
+		sendClose(code, StringView());
+	}
+	finish(code, StringView());
+	return false;
+}
+
+void Connection::Impl::finish(uint16_t code, StringView reason)
+{
+	if ( closed ) {
+		return;
+	}
+	closed = true;
+
+	// the stream callbacks hold the connection, they go with the stream
+	http::Server::stream_ptr gone = std::move(stream);
+	close_handler_type handler = std::move(on_close);
+	on_message = nullptr;
+	on_pong = nullptr;
+	if ( gone ) {
+		gone->end();
+	}
+	if ( handler ) {
+		handler(code, reason);
+	}
+}
+
+///////////////////////////////////////////////////////////////
+
+Connection::pointer Connection::Accept(const http::RequestView& request, const http::Server::stream_ptr& stream,
+									   const Options& options)
+{
+	if ( !IsUpgrade(request) ) {
+		return nullptr;
+	}
+
+	http::Response& response = stream->response();
+	DeflateParams params;
+	bool deflated = false;
+	websocket::Accept(request, response, options.deflate ? &params : nullptr, &deflated);
+
+	pointer conn = std::make_shared<Connection>(stream, options);
+	if ( deflated ) {
+		conn->pImpl_->deflate.reset(new Deflate(params, options.deflate_level));
+		if ( !conn->pImpl_->deflate->ok() ) {
+			conn->pImpl_->deflate.reset();
+			response.removeHeader("Sec-WebSocket-Extensions");
+		}
+	}
+
+	Impl* impl = conn->pImpl_.get();
+	stream->onData([conn, impl](StringView piece){
+		pointer self = conn;		// the stream may drop this callback meanwhile
+		impl->receive(piece);
+	});
+	stream->onClose([conn, impl](){
+		pointer self = conn;
+		impl->stream.reset();
+		impl->finish(CLOSE_ABNORMAL, StringView());
+	});
+
+	if ( !stream->upgrade() ) {		// the head is out already, or the connection went
+		stream->onData(nullptr);
+		stream->onClose(nullptr);
+		impl->closed = true;
+		impl->stream.reset();
+		return nullptr;
+	}
+	return conn;
+}
+
+Connection::Connection(const http::Server::stream_ptr& stream, const Options& options) :
+	pImpl_(new Impl(stream, options))
+{
+}
+
+Connection::~Connection()
+{
+}
+
+asio::IOContext& Connection::context()
+{
+	return pImpl_->ioc;
+}
+
+bool Connection::closed() const
+{
+	return pImpl_->closed || pImpl_->close_sent;
+}
+
+bool Connection::deflated() const
+{
+	return pImpl_->deflate != nullptr;
+}
+
+void Connection::onMessage(message_handler_type handler)
+{
+	if ( !pImpl_->closed ) {
+		pImpl_->on_message = std::move(handler);
+	}
+}
+
+void Connection::onPong(pong_handler_type handler)
+{
+	if ( !pImpl_->closed ) {
+		pImpl_->on_pong = std::move(handler);
+	}
+}
+
+void Connection::onClose(close_handler_type handler)
+{
+	if ( !pImpl_->closed ) {
+		pImpl_->on_close = std::move(handler);
+	}
+}
+
+void Connection::onDrain(event_handler_type handler)
+{
+	if ( pImpl_->stream ) {
+		pImpl_->stream->onDrain(std::move(handler));
+	}
+}
+
+bool Connection::send(opcode_type op, StringView data, bool fin)
+{
+	Impl& impl = *pImpl_;
+	if ( impl.closed || impl.close_sent || IsControl(op) ) {
+		return false;
+	}
+
+	opcode_type wire_op = impl.sending ? opcode::CONTINUATION : op;
+	bool rsv1 = false;
+	if ( !impl.sending ) {
+		impl.send_compressed = impl.deflate && (!fin || data.size() >= impl.options.compress_min_bytes);
+		rsv1 = impl.send_compressed;
+	}
+	if ( impl.send_compressed ) {
+		impl.compressed.clear();
+		if ( !impl.deflate->compress(data, fin, impl.compressed) ) {
+			impl.fail(CLOSE_INTERNAL_ERROR);
+			return false;
+		}
+		data = StringView(impl.compressed);
+	}
+
+	impl.sending = !fin;
+	return impl.writeFrame(wire_op, data, fin, rsv1);
+}
+
+bool Connection::sendText(StringView text)
+{
+	return send(opcode::TEXT, text);
+}
+
+bool Connection::sendBinary(StringView data)
+{
+	return send(opcode::BINARY, data);
+}
+
+bool Connection::ping(StringView payload)
+{
+	if ( closed() || payload.size() > MAX_CONTROL_PAYLOAD ) {
+		return false;
+	}
+	return pImpl_->writeFrame(opcode::PING, payload, true, false);
+}
+
+void Connection::close(uint16_t code, StringView reason)
+{
+	if ( closed() ) {
+		return;
+	}
+	pImpl_->sendClose(code, reason);
+}
+
+}   // namespace websocket
+}   // namespace protocol
+}	// namespace lcy
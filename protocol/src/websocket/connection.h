@@ -0,0 +1,136 @@
+#ifndef __LCY_PROTOCOL_WEBSOCKET_CONNECTION_H__
+#define __LCY_PROTOCOL_WEBSOCKET_CONNECTION_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <memory>
+#include <functional>
+
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/http/server.h"
+#include "lcy/protocol/src/websocket/frame.h"
+
+namespace lcy {
+namespace asio {
+class IOContext;
+}	// namespace asio
+
+namespace protocol {
+
+namespace http {
+class RequestView;
+}	// namespace http
+
+namespace websocket {
+
+/*
+* Server side WebSocket connection, on a stream of http::Server taken over with
+* ServerStream::upgrade().
+*
+* example :
+*
+*	server.setStreamHandler([](const http::RequestView& request, const http::Server::stream_ptr& stream){
+*		websocket::Connection::pointer ws = websocket::Connection::Accept(request, stream);
+*		if ( !ws ) {
+*			return false;
+*		}
+*		ws->onMessage([ws](websocket::opcode_type op, StringView message){
+*			ws->send(op, message);
+*		});
+*		return true;
+*	});
+*
+* Messages are handed over whole : fragments are joined, text is checked to be
+* UTF-8. A ping is answered with a pong, a close frame with a close frame before the
+* connection goes. A peer breaking the protocol gets a close frame with the reason
+* ( 1002, 1007, 1009 ) and the connection is closed.
+*
+* notify :
+*	Everything runs on context(), the loop of the HTTP connection : every member
+*	must be called there. `message` is only valid during the call.
+*	A message that is one unfragmented, uncompressed frame is passed from the receive
+*	buffer as it is. Frames are written straight into a buffer kept for the life of
+*	the connection : past the first messages sending one does not allocate.
+*	The callbacks are dropped once the connection is closed, so they may hold it.
+*	The idle timeout of the server applies : ping() keeps a quiet connection open.
+*/
+class Connection {
+public:
+	typedef std::shared_ptr<Connection> pointer;
+	// TEXT or BINARY
+	typedef std::function<void (opcode_type, StringView)> message_handler_type;
+	typedef std::function<void (StringView)> pong_handler_type;
+	// the code of the close frame ( or CLOSE_NO_STATUS, CLOSE_ABNORMAL ) and its reason
+	typedef std::function<void (uint16_t, StringView)> close_handler_type;
+	typedef std::function<void ()> event_handler_type;
+
+	enum {
+		DEFAULT_MAX_MESSAGE_BYTES = 16 * 1024 * 1024,	// joined fragments, or inflated
+		DEFAULT_COMPRESS_MIN_BYTES = 64,				// smaller messages are sent as they are
+	};
+
+	struct Options {
+		bool deflate;				// take a permessage-deflate offer
+		int deflate_level;			// zlib 1 to 9
+		size_t max_message_bytes;	// 0 : no limit
+		size_t compress_min_bytes;
+
+		Options() :
+			deflate(false),
+			deflate_level(6),
+			max_message_bytes(DEFAULT_MAX_MESSAGE_BYTES),
+			compress_min_bytes(DEFAULT_COMPRESS_MIN_BYTES)
+		{
+		}
+	};
+
+	/*
+	* Answers the upgrade on `stream` ( see websocket::Accept() ) and returns the
+	* connection, nullptr with `stream` untouched when `request` is no upgrade request.
+	* Call it from the stream handler and set the callbacks before it returns.
+	*/
+	static pointer Accept(const http::RequestView& request, const http::Server::stream_ptr& stream,
+						  const Options& options = Options());
+
+	explicit Connection(const http::Server::stream_ptr& stream, const Options& options);	// made by Accept()
+	~Connection();
+
+	asio::IOContext& context();
+	bool closed() const;		// closed, or a close frame sent
+	bool deflated() const;		// permessage-deflate agreed
+
+	void onMessage(message_handler_type handler);
+	void onPong(pong_handler_type handler);
+	void onClose(close_handler_type handler);
+	void onDrain(event_handler_type handler);
+
+	/*
+	* A message, or a fragment of one : after a call with `fin` false the next calls
+	* continue the same message ( whatever their `op` ) until one with `fin`.
+	* Returns false once Server::OUTPUT_HIGH_WATER bytes wait to be sent ( see
+	* onDrain() ), or when the connection is closed.
+	*/
+	bool send(opcode_type op, StringView data, bool fin = true);
+	bool sendText(StringView text);
+	bool sendBinary(StringView data);
+	bool ping(StringView payload = StringView());		// up to MAX_CONTROL_PAYLOAD bytes
+	// sends a close frame, the connection goes once the peer answers it
+	void close(uint16_t code = CLOSE_NORMAL, StringView reason = StringView());
+
+private:
+	Connection(const Connection&);
+	Connection& operator=(const Connection&);
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> pImpl_;
+};
+
+// whether `data` is well formed UTF-8 ( no overlongs, surrogates or code points above U+10FFFF )
+bool IsUtf8(StringView data);
+
+}   // namespace websocket
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_WEBSOCKET_CONNECTION_H__
@@ -0,0 +1,262 @@
+#include "lcy/protocol/src/websocket/deflate.h"
+
+#include <zlib.h>
+#include <limits.h>
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace websocket {
+
+static const size_t STREAM_CHUNK = 16 * 1024;
+static const int MEM_LEVEL = 8;
+static const int INFLATE_WINDOW_BITS = 15;		// takes whatever window the peer used
+static const char kTail[4] = { 0x00, 0x00, (char)0xFF, (char)0xFF };
+
+static StringView Trim(StringView value)
+{
+	size_t begin = 0, end = value.size();
+	while ( begin < end && (value[begin] == ' ' || value[begin] == '\t') ) ++begin;
+	while ( end > begin && (value[end - 1] == ' ' || value[end - 1] == '\t') ) --end;
+	return value.substr(begin, end - begin);
+}
+
+// "15" or "\"15\"" between 8 and 15, -1 otherwise
+static int WindowBits(StringView value)
+{
+	if ( value.size() >= 2 && value[0] == '"' && value[value.size() - 1] == '"' ) {
+		value = value.substr(1, value.size() - 2);
+	}
+	if ( value.empty() || value.size() > 2 ) {
+		return -1;
+	}
+
+	int bits = 0;
+	for ( char c : value ) {
+		if ( c < '0' || c > '9' ) {
+			return -1;
+		}
+		bits = bits * 10 + (c - '0');
+	}
+	return bits >= 8 && bits <= 15 ? bits : -1;
+}
+
+// one offer : "permessage-deflate; param[=value]; ..."
+static bool TakeOffer(StringView offer, DeflateParams& params)
+{
+	size_t semi = offer.find(';');
+	if ( !Trim(offer.substr(0, semi)).iequals(StringView("permessage-deflate")) ) {
+		return false;
+	}
+
+	DeflateParams taken;
+	bool client_window_seen = false;
+	while ( semi != StringView::npos ) {
+		size_t begin = semi + 1;
+		semi = offer.find(';', begin);
+		StringView param = offer.substr(begin, semi == StringView::npos ? StringView::npos : semi - begin);
+
+		size_t eq = param.find('=');
+		StringView name = Trim(param.substr(0, eq));
+		StringView value = eq == StringView::npos ? StringView() : Trim(param.substr(eq + 1));
+
+		if ( name.iequals(StringView("server_no_context_takeover")) ) {
+			if ( taken.server_no_context_takeover || eq != StringView::npos ) {
+				return false;
+			}
+			taken.server_no_context_takeover = true;
+		} else if ( name.iequals(StringView("client_no_context_takeover")) ) {
+			if ( taken.client_no_context_takeover || eq != StringView::npos ) {
+				return false;
+			}
+			taken.client_no_context_takeover = true;
+		} else if ( name.iequals(StringView("server_max_window_bits")) ) {
+			int bits = WindowBits(value);
+			if ( taken.server_window_asked || bits < 9 ) {
+				return false;
+			}
+			taken.server_window_asked = true;
+			taken.server_max_window_bits = bits;
+		} else if ( name.iequals(StringView("client_max_window_bits")) ) {
+			// the client may limit its own window, any window inflates with 15 bits
+			if ( client_window_seen || (eq != StringView::npos && WindowBits(value) < 0) ) {
+				return false;
+			}
+			client_window_seen = true;
+		} else {
+			return false;
+		}
+	}
+
+	params = taken;
+	return true;
+}
+
+std::string DeflateParams::toString() const
+{
+	std::string value("permessage-deflate");
+	if ( server_no_context_takeover ) {
+		value.append("; server_no_context_takeover");
+	}
+	if ( client_no_context_takeover ) {
+		value.append("; client_no_context_takeover");
+	}
+	if ( server_window_asked ) {
+		value.append("; server_max_window_bits=");
+		value.append(std::to_string(server_max_window_bits));
+	}
+	return value;
+}
+
+bool NegotiateDeflate(StringView extensions, DeflateParams& params)
+{
+	// offers are separated by commas, no parameter of this extension holds one
+	size_t pos = 0;
+	while ( pos < extensions.size() ) {
+		size_t comma = extensions.find(',', pos);
+		if ( comma == StringView::npos ) {
+			comma = extensions.size();
+		}
+		if ( TakeOffer(extensions.substr(pos, comma - pos), params) ) {
+			return true;
+		}
+		pos = comma + 1;
+	}
+	return false;
+}
+
+///////////////////////////////////////////////////////////////
+
+class Deflate::Impl {
+public:
+	z_stream deflater;
+	z_stream inflater;
+	bool deflate_init;
+	bool inflate_init;
+	bool reset_deflater;		// server_no_context_takeover
+	bool reset_inflater;		// client_no_context_takeover
+
+	Impl() :
+		deflate_init(false),
+		inflate_init(false),
+		reset_deflater(false),
+		reset_inflater(false)
+	{
+		::memset(&deflater, 0, sizeof(deflater));
+		::memset(&inflater, 0, sizeof(inflater));
+	}
+
+	~Impl()
+	{
+		if ( deflate_init ) {
+			::deflateEnd(&deflater);
+		}
+		if ( inflate_init ) {
+			::inflateEnd(&inflater);
+		}
+	}
+
+	bool inflate(StringView data, std::string& out, size_t base, size_t max_bytes)
+	{
+		inflater.next_in = (Bytef*)data.data();
+		inflater.avail_in = (uInt)data.size();
+		while ( inflater.avail_in > 0 ) {
+			size_t at = out.size();
+			out.resize(at + STREAM_CHUNK);
+			inflater.next_out = (Bytef*)&out[at];
+			inflater.avail_out = STREAM_CHUNK;
+			int ret = ::inflate(&inflater, Z_SYNC_FLUSH);
+			out.resize(at + STREAM_CHUNK - inflater.avail_out);
+
+			if ( ret == Z_STREAM_END ) {
+				::inflateReset(&inflater);		// a final block, the next one starts afresh
+			} else if ( ret != Z_OK && !(ret == Z_BUF_ERROR && inflater.avail_in == 0) ) {
+				return false;
+			}
+			if ( max_bytes && out.size() - base > max_bytes ) {
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+Deflate::Deflate(const DeflateParams& params, int level) :
+	pImpl_(new Impl())
+{
+	if ( level < 1 || level > 9 ) {
+		level = Z_DEFAULT_COMPRESSION;
+	}
+
+	pImpl_->deflate_init = ::deflateInit2(&pImpl_->deflater, level, Z_DEFLATED,
+										  -params.server_max_window_bits, MEM_LEVEL,
+										  Z_DEFAULT_STRATEGY) == Z_OK;
+	pImpl_->inflate_init = ::inflateInit2(&pImpl_->inflater, -INFLATE_WINDOW_BITS) == Z_OK;
+	pImpl_->reset_deflater = params.server_no_context_takeover;
+	pImpl_->reset_inflater = params.client_no_context_takeover;
+}
+
+Deflate::~Deflate()
+{
+}
+
+bool Deflate::ok() const
+{
+	return pImpl_->deflate_init && pImpl_->inflate_init;
+}
+
+bool Deflate::compress(StringView data, bool fin, std::string& out)
+{
+	if ( !pImpl_->deflate_init || data.size() > UINT_MAX ) {
+		return false;
+	}
+
+	z_stream& zs = pImpl_->deflater;
+	zs.next_in = (Bytef*)data.data();
+	zs.avail_in = (uInt)data.size();
+	do {
+		size_t at = out.size();
+		out.resize(at + STREAM_CHUNK);
+		zs.next_out = (Bytef*)&out[at];
+		zs.avail_out = STREAM_CHUNK;
+		int ret = ::deflate(&zs, Z_SYNC_FLUSH);
+		out.resize(at + STREAM_CHUNK - zs.avail_out);
+		if ( ret == Z_STREAM_ERROR ) {
+			return false;
+		}
+	} while ( zs.avail_out == 0 );
+
+	if ( fin ) {
+		if ( out.size() >= 4 && ::memcmp(out.data() + out.size() - 4, kTail, 4) == 0 ) {
+			out.resize(out.size() - 4);
+		}
+		if ( pImpl_->reset_deflater ) {
+			::deflateReset(&zs);
+		}
+	}
+	return true;
+}
+
+bool Deflate::decompress(StringView message, std::string& out, size_t max_bytes)
+{
+	if ( !pImpl_->inflate_init || message.size() > UINT_MAX ) {
+		return false;
+	}
+
+	size_t base = out.size();
+	bool done = pImpl_->inflate(message, out, base, max_bytes) &&
+				pImpl_->inflate(StringView(kTail, 4), out, base, max_bytes);
+	if ( !done ) {
+		out.resize(base);
+		return false;
+	}
+
+	if ( pImpl_->reset_inflater ) {
+		::inflateReset(&pImpl_->inflater);
+	}
+	return true;
+}
+
+}   // namespace websocket
+}   // namespace protocol
+}	// namespace lcy
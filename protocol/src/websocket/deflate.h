@@ -0,0 +1,78 @@
+#ifndef __LCY_PROTOCOL_WEBSOCKET_DEFLATE_H__
+#define __LCY_PROTOCOL_WEBSOCKET_DEFLATE_H__
+
+#include <string>
+#include <memory>
+#include <stddef.h>
+
+#include "lcy/protocol/src/string_view.h"
+
+namespace lcy {
+namespace protocol {
+namespace websocket {
+
+/*
+* permessage-deflate ( RFC 7692 ) : parameters agreed in the handshake.
+*/
+struct DeflateParams {
+	bool server_no_context_takeover;
+	bool client_no_context_takeover;
+	int server_max_window_bits;		// 9 to 15
+	bool server_window_asked;		// the offer named server_max_window_bits
+
+	DeflateParams() :
+		server_no_context_takeover(false),
+		client_no_context_takeover(false),
+		server_max_window_bits(15),
+		server_window_asked(false)
+	{
+	}
+
+	// the Sec-WebSocket-Extensions value of the answer
+	std::string toString() const;
+};
+
+/*
+* The first permessage-deflate offer of a Sec-WebSocket-Extensions value the server
+* can take. An offer with unknown or repeated parameters, or asking for a window of
+* 8 bits ( zlib can not make raw deflate of that window ), is passed over.
+*/
+bool NegotiateDeflate(StringView extensions, DeflateParams& params);
+
+/*
+* The compressor and decompressor of one server side connection.
+*
+* notify :
+*	Each direction holds a zlib stream for the life of the connection ( the
+*	context is taken over from message to message unless the peer opted out ),
+*	about 256 KiB for the compressor at level 6 and 44 KiB for the decompressor.
+*/
+class Deflate {
+public:
+	Deflate(const DeflateParams& params, int level);
+	~Deflate();
+
+	bool ok() const;		// false when zlib could not be set up
+
+	/*
+	* Compresses a piece of an outgoing message and appends it to `out`. The last
+	* piece ( `fin` ) drops the 0x00 0x00 0xFF 0xFF the flush ends with.
+	*/
+	bool compress(StringView data, bool fin, std::string& out);
+	// a whole incoming message, at most `max_bytes` out ( 0 : no limit )
+	bool decompress(StringView message, std::string& out, size_t max_bytes = 0);
+
+private:
+	Deflate(const Deflate&);
+	Deflate& operator=(const Deflate&);
+
+private:
+	class Impl;
+	std::unique_ptr<Impl> pImpl_;
+};
+
+}   // namespace websocket
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_WEBSOCKET_DEFLATE_H__
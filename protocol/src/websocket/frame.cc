@@ -0,0 +1,355 @@
+#include "lcy/protocol/src/websocket/frame.h"
+
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LCY_PROTOCOL_MASK_X86 1
+#include <immintrin.h>
+#endif
+
+namespace lcy {
+namespace protocol {
+namespace websocket {
+
+const char* OpcodeToString(opcode_type op)
+{
+	switch ( op ) {
+		case opcode::CONTINUATION : return "continuation";
+		case opcode::TEXT : return "text";
+		case opcode::BINARY : return "binary";
+		case opcode::CLOSE : return "close";
+		case opcode::PING : return "ping";
+		case opcode::PONG : return "pong";
+		default : return "unknown";
+	}
+}
+
+bool IsControl(opcode_type op)
+{
+	return ((uint8_t)op & 0x8) != 0;
+}
+
+///////////////////////////////////////////////////////////////
+
+// the key as the 4 bytes starting at data[0], whatever `offset` is
+static uint32_t RotateKey(const uint8_t key[4], size_t offset)
+{
+	uint8_t rotated[4];
+	for ( size_t i = 0; i < 4; ++i ) {
+		rotated[i] = key[(offset + i) & 3];
+	}
+
+	uint32_t word;
+	::memcpy(&word, rotated, 4);
+	return word;
+}
+
+static void MaskTail(char* data, size_t len, uint32_t word)
+{
+	uint8_t key[4];
+	::memcpy(key, &word, 4);
+	for ( size_t i = 0; i < len; ++i ) {
+		data[i] ^= (char)key[i & 3];
+	}
+}
+
+static void MaskScalar(char* data, size_t len, uint32_t word)
+{
+	uint64_t wide = ((uint64_t)word << 32) | word;
+
+	size_t i = 0;
+	for ( ; len - i >= 8; i += 8 ) {
+		uint64_t v;
+		::memcpy(&v, data + i, 8);
+		v ^= wide;
+		::memcpy(data + i, &v, 8);
+	}
+	MaskTail(data + i, len - i, word);
+}
+
+#ifdef LCY_PROTOCOL_MASK_X86
+
+/*
+* notify :
+*	A block is a multiple of 4 bytes, so the key lines up the same way in every
+*	block and one broadcast register serves the whole payload.
+*/
+__attribute__((target("sse2")))
+static void MaskSSE2(char* data, size_t len, uint32_t word)
+{
+	const __m128i key = _mm_set1_epi32((int)word);
+
+	size_t i = 0;
+	for ( ; len - i >= 16; i += 16 ) {
+		__m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+		_mm_storeu_si128((__m128i*)(data + i), _mm_xor_si128(v, key));
+	}
+	MaskTail(data + i, len - i, word);
+}
+
+__attribute__((target("avx2")))
+static void MaskAVX2(char* data, size_t len, uint32_t word)
+{
+	const __m256i key = _mm256_set1_epi32((int)word);
+
+	size_t i = 0;
+	for ( ; len - i >= 32; i += 32 ) {
+		__m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+		_mm256_storeu_si256((__m256i*)(data + i), _mm256_xor_si256(v, key));
+	}
+	MaskSSE2(data + i, len - i, word);
+}
+
+#endif	// LCY_PROTOCOL_MASK_X86
+
+typedef void (*mask_type)(char*, size_t, uint32_t);
+
+static http::scan_level_type SupportedLevel()
+{
+#ifdef LCY_PROTOCOL_MASK_X86
+	__builtin_cpu_init();
+	if ( __builtin_cpu_supports("avx2") ) {
+		return http::scan_level::AVX2;
+	}
+	if ( __builtin_cpu_supports("sse2") ) {
+		return http::scan_level::SSE2;
+	}
+#endif
+	return http::scan_level::SCALAR;
+}
+
+struct MaskTable {
+	http::scan_level_type level;
+	mask_type mask;
+
+	MaskTable() { select(SupportedLevel()); }
+
+	void select(http::scan_level_type l)
+	{
+		level = http::scan_level::SCALAR;
+		mask = &MaskScalar;
+
+#ifdef LCY_PROTOCOL_MASK_X86
+		if ( l == http::scan_level::AVX2 ) {
+			level = l;
+			mask = &MaskAVX2;
+		} else if ( l == http::scan_level::SSE2 ) {
+			level = l;
+			mask = &MaskSSE2;
+		}
+#endif
+	}
+};
+
+static MaskTable& Table()
+{
+	static MaskTable table;
+	return table;
+}
+
+void Mask(char* data, size_t len, const uint8_t key[4], size_t offset)
+{
+	Table().mask(data, len, RotateKey(key, offset));
+}
+
+http::scan_level_type MaskLevel()
+{
+	return Table().level;
+}
+
+http::scan_level_type SetMaskLevel(http::scan_level_type level)
+{
+	static const http::scan_level_type supported = SupportedLevel();
+	if ( (uint8_t)level > (uint8_t)supported ) {
+		level = supported;
+	}
+
+	Table().select(level);
+	return Table().level;
+}
+
+///////////////////////////////////////////////////////////////
+
+FrameParser::FrameParser() :
+	require_mask_(true),
+	max_payload_bytes_(DEFAULT_MAX_PAYLOAD_BYTES),
+	nparse_(0),
+	errcode_(ErrCode::NONE)
+{
+}
+
+void FrameParser::setRequireMask(bool on)
+{
+	require_mask_ = on;
+}
+
+void FrameParser::setMaxPayloadBytes(size_t bytes)
+{
+	max_payload_bytes_ = bytes;
+}
+
+size_t FrameParser::maxPayloadBytes() const
+{
+	return max_payload_bytes_;
+}
+
+size_t FrameParser::nparse() const
+{
+	return nparse_;
+}
+
+FrameParser::ErrCode FrameParser::errcode() const
+{
+	return errcode_;
+}
+
+FrameParser::RetCode FrameParser::fail(ErrCode errcode)
+{
+	nparse_ = 0;
+	errcode_ = errcode;
+	return ERROR;
+}
+
+FrameParser::RetCode FrameParser::parse(char* data, size_t len, Frame& frame)
+{
+	nparse_ = 0;
+	errcode_ = ErrCode::NONE;
+	if ( len < 2 ) {
+		return WAITING_DATA;
+	}
+
+	const uint8_t* head = (const uint8_t*)data;
+	if ( head[0] & 0x30 ) {		// RSV2, RSV3 : no extension uses them
+		return fail(ErrCode::PROTOCOL_ERROR);
+	}
+
+	frame.fin = (head[0] & 0x80) != 0;
+	frame.rsv1 = (head[0] & 0x40) != 0;
+	frame.opcode = (opcode_type)(head[0] & 0x0F);
+	frame.masked = (head[1] & 0x80) != 0;
+
+	switch ( frame.opcode ) {
+		case opcode::CONTINUATION :
+		case opcode::TEXT :
+		case opcode::BINARY :
+		case opcode::CLOSE :
+		case opcode::PING :
+		case opcode::PONG :
+			break;
+		default :
+			return fail(ErrCode::PROTOCOL_ERROR);
+	}
+	if ( frame.masked != require_mask_ ) {
+		return fail(ErrCode::PROTOCOL_ERROR);
+	}
+
+	uint64_t length = head[1] & 0x7F;
+	size_t pos = 2;
+	if ( IsControl(frame.opcode) && (!frame.fin || length > MAX_CONTROL_PAYLOAD) ) {
+		return fail(ErrCode::PROTOCOL_ERROR);
+	}
+
+	if ( length == 126 ) {
+		if ( len < 4 ) {
+			return WAITING_DATA;
+		}
+		length = ((uint64_t)head[2] << 8) | head[3];
+		pos = 4;
+	} else if ( length == 127 ) {
+		if ( len < 10 ) {
+			return WAITING_DATA;
+		}
+		length = 0;
+		for ( size_t i = 2; i < 10; ++i ) {
+			length = (length << 8) | head[i];
+		}
+		if ( length >> 63 ) {
+			return fail(ErrCode::PROTOCOL_ERROR);
+		}
+		pos = 10;
+	}
+
+	if ( max_payload_bytes_ > 0 && length > max_payload_bytes_ ) {
+		return fail(ErrCode::TOO_LARGE);
+	}
+
+	if ( frame.masked ) {
+		if ( len < pos + 4 ) {
+			return WAITING_DATA;
+		}
+		::memcpy(frame.mask, head + pos, 4);
+		pos += 4;
+	}
+
+	if ( len - pos < length ) {
+		return WAITING_DATA;
+	}
+
+	char* payload = data + pos;
+	if ( frame.masked ) {
+		Mask(payload, (size_t)length, frame.mask);
+	}
+	frame.payload = StringView(payload, (size_t)length);
+	nparse_ = pos + (size_t)length;
+	return READY;
+}
+
+FrameParser::RetCode FrameParser::parse(asio::DynamicBuffer& in, Frame& frame)
+{
+	// the bytes belong to the buffer, it only hands them out as const
+	RetCode retcode = parse(const_cast<char*>(in.readBegin()), in.dataBytes(), frame);
+	if ( retcode == READY ) {
+		in.read(nparse_);
+	}
+	return retcode;
+}
+
+///////////////////////////////////////////////////////////////
+
+size_t SerializeFrame(asio::DynamicBuffer& out, opcode_type op, StringView payload,
+					  bool fin, bool rsv1, const uint8_t* mask)
+{
+	size_t len = payload.size();
+	size_t head_bytes = 2 + (len < 126 ? 0 : (len <= 0xFFFF ? 2 : 8)) + (mask ? 4 : 0);
+
+	out.reserve(head_bytes + len);
+	uint8_t* head = (uint8_t*)out.writeBegin();
+
+	head[0] = (uint8_t)((fin ? 0x80 : 0) | (rsv1 ? 0x40 : 0) | (uint8_t)op);
+	uint8_t mask_bit = mask ? 0x80 : 0;
+	size_t pos = 2;
+	if ( len < 126 ) {
+		head[1] = (uint8_t)(mask_bit | len);
+	} else if ( len <= 0xFFFF ) {
+		head[1] = (uint8_t)(mask_bit | 126);
+		head[2] = (uint8_t)(len >> 8);
+		head[3] = (uint8_t)len;
+		pos = 4;
+	} else {
+		head[1] = (uint8_t)(mask_bit | 127);
+		for ( size_t i = 0; i < 8; ++i ) {
+			head[2 + i] = (uint8_t)((uint64_t)len >> (56 - 8 * i));
+		}
+		pos = 10;
+	}
+
+	if ( mask ) {
+		::memcpy(head + pos, mask, 4);
+		pos += 4;
+	}
+
+	char* body = (char*)head + pos;
+	if ( len > 0 ) {
+		::memcpy(body, payload.data(), len);
+		if ( mask ) {
+			Mask(body, len, mask);
+		}
+	}
+
+	out.write(head_bytes + len);
+	return head_bytes + len;
+}
+
+}   // namespace websocket
+}   // namespace protocol
+}	// namespace lcy
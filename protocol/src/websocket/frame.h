@@ -0,0 +1,151 @@
+#ifndef __LCY_PROTOCOL_WEBSOCKET_FRAME_H__
+#define __LCY_PROTOCOL_WEBSOCKET_FRAME_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "lcy/asio/src/dynamic_buffer.h"
+#include "lcy/protocol/src/string_view.h"
+#include "lcy/protocol/src/http/scan.h"
+
+namespace lcy {
+namespace protocol {
+namespace websocket {
+
+/*
+* Frame layer of RFC 6455.
+*/
+typedef
+enum class opcode :
+	uint8_t
+{
+	CONTINUATION = 0x0,
+	TEXT = 0x1,
+	BINARY = 0x2,
+	CLOSE = 0x8,
+	PING = 0x9,
+	PONG = 0xA,
+}
+opcode_type;
+
+// status codes of a close frame
+enum close_code {
+	CLOSE_NORMAL = 1000,
+	CLOSE_GOING_AWAY = 1001,
+	CLOSE_PROTOCOL_ERROR = 1002,
+	CLOSE_UNSUPPORTED = 1003,
+	CLOSE_NO_STATUS = 1005,			// never sent : the close frame had no code
+	CLOSE_ABNORMAL = 1006,			// never sent : the connection went away without a close frame
+	CLOSE_INVALID_PAYLOAD = 1007,	// e.g. a text message that is not UTF-8
+	CLOSE_POLICY = 1008,
+	CLOSE_TOO_BIG = 1009,
+	CLOSE_INTERNAL_ERROR = 1011,
+};
+
+const char* OpcodeToString(opcode_type op);
+bool IsControl(opcode_type op);
+
+struct Frame {
+	bool fin;
+	bool rsv1;				// permessage-deflate : the message is compressed
+	opcode_type opcode;
+	bool masked;
+	uint8_t mask[4];
+	StringView payload;		// unmasked, refers into the parsed data
+
+	Frame() : fin(false), rsv1(false), opcode(opcode::CONTINUATION), masked(false), mask() {}
+};
+
+enum {
+	MAX_HEAD_BYTES = 14,			// 2 + 8 byte length + 4 byte mask
+	MAX_CONTROL_PAYLOAD = 125,
+};
+
+/*
+* XORs `data` with the masking `key` in place, `offset` is the position of data[0]
+* within the payload ( a payload may be masked piece by piece ).
+*
+* On x86 the widest instruction set the CPU supports is picked once at startup, as
+* for the HTTP scan kernels ( AVX2 : 32 bytes per step, SSE2 : 16 ), other targets
+* mask 8 bytes per step. All of them give the same result.
+*/
+void Mask(char* data, size_t len, const uint8_t key[4], size_t offset = 0);
+
+http::scan_level_type MaskLevel();
+// for tests and benchmarks, same contract as http::SetScanLevel()
+http::scan_level_type SetMaskLevel(http::scan_level_type level);
+
+/*
+* Cuts frames out of received data, one per call.
+*
+* example :
+*
+*	websocket::FrameParser parser;
+*	websocket::Frame frame;
+*	while ( parser.parse(in, frame) == websocket::FrameParser::READY ) {
+*		... frame.opcode, frame.payload ...
+*	}
+*
+* notify :
+*	A frame is returned once it is complete, so setMaxPayloadBytes() also bounds
+*	how much is buffered. The payload is unmasked in place : it refers into the
+*	parsed data and stays valid until that buffer is written again.
+*	Reserved bits other than RSV1, unknown opcodes, fragmented or oversized control
+*	frames and a 64 bit length with its top bit set are errors ( PROTOCOL_ERROR ).
+*/
+class FrameParser {
+public:
+	enum RetCode {
+		READY,
+		WAITING_DATA,
+		ERROR
+	};
+
+	enum class ErrCode {
+		NONE,
+		PROTOCOL_ERROR,		// malformed frame, or unmasked while masking is required
+		TOO_LARGE,			// payload above maxPayloadBytes()
+	};
+
+	enum {
+		DEFAULT_MAX_PAYLOAD_BYTES = 16 * 1024 * 1024,
+	};
+
+	FrameParser();
+
+	// a server requires masked frames ( the default ), a client unmasked ones
+	void setRequireMask(bool on);
+	void setMaxPayloadBytes(size_t bytes);		// 0 : no limit
+	size_t maxPayloadBytes() const;
+
+	size_t nparse() const;		// bytes of the frame returned by the last READY
+	ErrCode errcode() const;
+
+	RetCode parse(char* data, size_t len, Frame& frame);
+	// consumes the frame from `in` on READY
+	RetCode parse(asio::DynamicBuffer& in, Frame& frame);
+
+private:
+	RetCode fail(ErrCode errcode);
+
+private:
+	bool require_mask_;
+	size_t max_payload_bytes_;
+	size_t nparse_;
+	ErrCode errcode_;
+};
+
+/*
+* Appends one frame to `out` : the head is written straight into the reserved space
+* and the payload copied behind it, masked when `mask` is given ( a client ). Only
+* the buffer grows, in the steady state a frame costs no allocation.
+* Returns the bytes appended.
+*/
+size_t SerializeFrame(asio::DynamicBuffer& out, opcode_type op, StringView payload,
+					  bool fin = true, bool rsv1 = false, const uint8_t* mask = nullptr);
+
+}   // namespace websocket
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_WEBSOCKET_FRAME_H__
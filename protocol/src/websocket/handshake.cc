@@ -0,0 +1,244 @@
+#include "lcy/protocol/src/websocket/handshake.h"
+#include "lcy/protocol/src/websocket/deflate.h"
+#include "lcy/protocol/src/http/request.h"
+#include "lcy/protocol/src/http/request_view.h"
+#include "lcy/protocol/src/http/response.h"
+#include "lcy/protocol/src/http/details/util.h"
+
+#include <stdint.h>
+#include <string.h>
+
+namespace lcy {
+namespace protocol {
+namespace websocket {
+
+static const char kGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static const StringView kKey("Sec-WebSocket-Key", 17);
+static const StringView kVersion("Sec-WebSocket-Version", 21);
+static const StringView kAccept("Sec-WebSocket-Accept", 20);
+static const StringView kExtensions("Sec-WebSocket-Extensions", 24);
+
+///////////////////////////////////////////////////////////////
+
+// SHA-1 ( RFC 3174 ), only ever run over a key of a few dozen bytes
+class Sha1 {
+public:
+	Sha1() : length_(0), used_(0)
+	{
+		h_[0] = 0x67452301;
+		h_[1] = 0xEFCDAB89;
+		h_[2] = 0x98BADCFE;
+		h_[3] = 0x10325476;
+		h_[4] = 0xC3D2E1F0;
+	}
+
+	void update(const void* data, size_t len)
+	{
+		const uint8_t* bytes = (const uint8_t*)data;
+		length_ += len;
+		while ( len > 0 ) {
+			size_t n = 64 - used_ < len ? 64 - used_ : len;
+			::memcpy(block_ + used_, bytes, n);
+			used_ += n;
+			bytes += n;
+			len -= n;
+			if ( used_ == 64 ) {
+				compress();
+				used_ = 0;
+			}
+		}
+	}
+
+	void finish(uint8_t digest[20])
+	{
+		uint64_t bits = length_ * 8;
+		uint8_t pad = 0x80;
+		update(&pad, 1);
+		pad = 0;
+		while ( used_ != 56 ) {
+			update(&pad, 1);
+		}
+		uint8_t size[8];
+		for ( size_t i = 0; i < 8; ++i ) {
+			size[i] = (uint8_t)(bits >> (56 - 8 * i));
+		}
+		update(size, 8);
+
+		for ( size_t i = 0; i < 5; ++i ) {
+			for ( size_t j = 0; j < 4; ++j ) {
+				digest[i * 4 + j] = (uint8_t)(h_[i] >> (24 - 8 * j));
+			}
+		}
+	}
+
+private:
+	static uint32_t rol(uint32_t v, int n) { return (v << n) | (v >> (32 - n)); }
+
+	void compress()
+	{
+		uint32_t w[80];
+		for ( size_t i = 0; i < 16; ++i ) {
+			w[i] = ((uint32_t)block_[i * 4] << 24) | ((uint32_t)block_[i * 4 + 1] << 16) |
+				   ((uint32_t)block_[i * 4 + 2] << 8) | block_[i * 4 + 3];
+		}
+		for ( size_t i = 16; i < 80; ++i ) {
+			w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+		}
+
+		uint32_t a = h_[0], b = h_[1], c = h_[2], d = h_[3], e = h_[4];
+		for ( size_t i = 0; i < 80; ++i ) {
+			uint32_t f, k;
+			if ( i < 20 ) {
+				f = (b & c) | (~b & d);
+				k = 0x5A827999;
+			} else if ( i < 40 ) {
+				f = b ^ c ^ d;
+				k = 0x6ED9EBA1;
+			} else if ( i < 60 ) {
+				f = (b & c) | (b & d) | (c & d);
+				k = 0x8F1BBCDC;
+			} else {
+				f = b ^ c ^ d;
+				k = 0xCA62C1D6;
+			}
+			uint32_t t = rol(a, 5) + f + e + k + w[i];
+			e = d;
+			d = c;
+			c = rol(b, 30);
+			b = a;
+			a = t;
+		}
+
+		h_[0] += a;
+		h_[1] += b;
+		h_[2] += c;
+		h_[3] += d;
+		h_[4] += e;
+	}
+
+private:
+	uint32_t h_[5];
+	uint64_t length_;
+	uint8_t block_[64];
+	size_t used_;
+};
+
+static std::string Base64(const uint8_t* data, size_t len)
+{
+	static const char kAlphabet[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+	std::string out;
+	out.reserve((len + 2) / 3 * 4);
+	for ( size_t i = 0; i < len; i += 3 ) {
+		uint32_t v = (uint32_t)data[i] << 16;
+		if ( i + 1 < len ) v |= (uint32_t)data[i + 1] << 8;
+		if ( i + 2 < len ) v |= data[i + 2];
+
+		out.push_back(kAlphabet[(v >> 18) & 0x3F]);
+		out.push_back(kAlphabet[(v >> 12) & 0x3F]);
+		out.push_back(i + 1 < len ? kAlphabet[(v >> 6) & 0x3F] : '=');
+		out.push_back(i + 2 < len ? kAlphabet[v & 0x3F] : '=');
+	}
+	return out;
+}
+
+std::string AcceptKey(StringView key)
+{
+	Sha1 sha1;
+	sha1.update(key.data(), key.size());
+	sha1.update(kGuid, sizeof(kGuid) - 1);
+
+	uint8_t digest[20];
+	sha1.finish(digest);
+	return Base64(digest, sizeof(digest));
+}
+
+///////////////////////////////////////////////////////////////
+
+// fields outside HTTP_FIELD_MAP keep the case they came with in a Request
+static StringView Header(const http::Request& request, StringView name)
+{
+	for ( auto& kv : request.getHeadersRef() ) {
+		if ( StringView(kv.first).iequals(name) ) {
+			return StringView(kv.second);
+		}
+	}
+	return StringView();
+}
+
+static StringView Header(const http::Request& request, http::field_type f)
+{
+	return StringView(request.getHeader(f));
+}
+
+static StringView Header(const http::RequestView& request, StringView name)
+{
+	return request.getHeader(name);
+}
+
+static StringView Header(const http::RequestView& request, http::field_type f)
+{
+	return request.getHeader(f);
+}
+
+template <typename RequestType>
+static bool IsUpgradeRequest(const RequestType& request)
+{
+	return request.method() == http::method::GET &&
+		   request.version() == http::version::HTTP_1_1 &&
+		   http::details::HasToken(Header(request, http::field::UPGRADE), StringView("websocket", 9)) &&
+		   http::details::HasToken(Header(request, http::field::CONNECTION), StringView("upgrade", 7)) &&
+		   !Header(request, kKey).empty() &&
+		   Header(request, kVersion) == StringView("13", 2);
+}
+
+template <typename RequestType>
+static bool AcceptRequest(const RequestType& request, http::Response& response,
+						  DeflateParams* deflate, bool* deflated)
+{
+	if ( !IsUpgradeRequest(request) ) {
+		return false;
+	}
+
+	response.setState(http::state::SWITCHING_PROTOCOLS);
+	response.setHeader(http::field::UPGRADE, "websocket");
+	response.setHeader(http::field::CONNECTION, "Upgrade");
+	response.setHeader(kAccept.toString(), AcceptKey(Header(request, kKey)));
+
+	bool taken = deflate && NegotiateDeflate(Header(request, kExtensions), *deflate);
+	if ( taken ) {
+		response.setHeader(kExtensions.toString(), deflate->toString());
+	}
+	if ( deflated ) {
+		*deflated = taken;
+	}
+	return true;
+}
+
+bool IsUpgrade(const http::RequestView& request)
+{
+	return IsUpgradeRequest(request);
+}
+
+bool IsUpgrade(const http::Request& request)
+{
+	return IsUpgradeRequest(request);
+}
+
+bool Accept(const http::RequestView& request, http::Response& response,
+			DeflateParams* deflate, bool* deflated)
+{
+	return AcceptRequest(request, response, deflate, deflated);
+}
+
+bool Accept(const http::Request& request, http::Response& response,
+			DeflateParams* deflate, bool* deflated)
+{
+	return AcceptRequest(request, response, deflate, deflated);
+}
+
+}   // namespace websocket
+}   // namespace protocol
+}	// namespace lcy
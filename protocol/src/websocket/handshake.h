@@ -0,0 +1,49 @@
+#ifndef __LCY_PROTOCOL_WEBSOCKET_HANDSHAKE_H__
+#define __LCY_PROTOCOL_WEBSOCKET_HANDSHAKE_H__
+
+#include <string>
+
+#include "lcy/protocol/src/string_view.h"
+
+namespace lcy {
+namespace protocol {
+
+namespace http {
+class Request;
+class RequestView;
+class Response;
+}	// namespace http
+
+namespace websocket {
+
+struct DeflateParams;
+
+/*
+* Opening handshake of RFC 6455, server side.
+*
+* An upgrade request is a GET of HTTP/1.1 with "Upgrade: websocket", "upgrade" among
+* the Connection tokens, a Sec-WebSocket-Key and Sec-WebSocket-Version 13.
+*/
+bool IsUpgrade(const http::RequestView& request);
+bool IsUpgrade(const http::Request& request);
+
+// base64( SHA-1( key + the RFC 6455 GUID ) ) : the Sec-WebSocket-Accept for `key`
+std::string AcceptKey(StringView key);
+
+/*
+* Fills `response` with the answer to an upgrade request : 101 Switching Protocols,
+* Upgrade, Connection and Sec-WebSocket-Accept. Returns false, `response` untouched,
+* when `request` is no upgrade request.
+* With `deflate` a permessage-deflate offer of the request is taken when there is one
+* ( see NegotiateDeflate() ) : `*deflated` tells, Sec-WebSocket-Extensions is set.
+*/
+bool Accept(const http::RequestView& request, http::Response& response,
+			DeflateParams* deflate = nullptr, bool* deflated = nullptr);
+bool Accept(const http::Request& request, http::Response& response,
+			DeflateParams* deflate = nullptr, bool* deflated = nullptr);
+
+}   // namespace websocket
+}   // namespace protocol
+}	// namespace lcy
+
+#endif // __LCY_PROTOCOL_WEBSOCKET_HANDSHAKE_H__
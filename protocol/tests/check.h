@@ -0,0 +1,14 @@
+#ifndef __LCY_PROTOCOL_TESTS_CHECK_H__
+#define __LCY_PROTOCOL_TESTS_CHECK_H__
+
+#include <iostream>
+
+// prints `what` when `cond` is false, returns `cond` : ok &= check(...)
+inline bool check(bool cond, const char* what) {
+	if ( !cond ) {
+		std::cout << "failed : " << what << std::endl;
+	}
+	return cond;
+}
+
+#endif	// __LCY_PROTOCOL_TESTS_CHECK_H__
@@ -0,0 +1,124 @@
+#ifndef __LCY_PROTOCOL_TESTS_LOOPBACK_H__
+#define __LCY_PROTOCOL_TESTS_LOOPBACK_H__
+
+#include "protocol/protocol.hpp"
+#include "asio/asio.hpp"
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+/*
+* Blocking loopback client of the server tests, the servers run on a loop of their
+* own ( the main thread's or a pool thread's ). Reads time out after 2 seconds.
+*/
+inline int connect_to(uint16_t port) {
+	int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+	struct sockaddr_in addr;
+	::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ( ::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) ) {
+		::close(fd);
+		return -1;
+	}
+
+	struct timeval tv = { 2, 0 };
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	int one = 1;
+	::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	return fd;
+}
+
+inline void send_all(int fd, lcy::protocol::StringView data) {
+	size_t sent = 0;
+	while ( sent < data.size() ) {
+		ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if ( n <= 0 ) {
+			return;
+		}
+		sent += n;
+	}
+}
+
+// sends and consumes what `out` holds
+inline void send_all(int fd, lcy::asio::DynamicBuffer& out) {
+	while ( out.dataBytes() > 0 ) {
+		ssize_t n = ::send(fd, out.readBegin(), out.dataBytes(), MSG_NOSIGNAL);
+		if ( n <= 0 ) {
+			return;
+		}
+		out.read(n);
+	}
+}
+
+// Reads until `count` responses are complete, after a pause when `late` : the send buffer fills up
+inline std::vector<lcy::protocol::http::Response> recv_responses(int fd, size_t count, bool late = false) {
+	std::vector<lcy::protocol::http::Response> responses;
+	std::string in;
+	lcy::protocol::http::Parser parser;
+	lcy::protocol::http::Response response;
+
+	char buf[65536];
+	while ( responses.size() < count ) {
+		while ( !in.empty() ) {
+			lcy::protocol::http::Parser::RetCode retcode = parser.parse(in.data(), in.size(), response);
+			if ( retcode != lcy::protocol::http::Parser::RetCode::READY ) {
+				break;
+			}
+			responses.push_back(response);
+			in.erase(0, parser.nparse());
+			parser.reset();
+			response.clear();
+		}
+		if ( responses.size() == count ) {
+			break;
+		}
+
+		if ( late ) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			late = false;
+		}
+		ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+		if ( n <= 0 ) {
+			break;
+		}
+		in.append(buf, n);
+	}
+	return responses;
+}
+
+// One request, one response read whole : false if anything follows it
+inline bool exchange(int fd, const std::string& request, lcy::protocol::http::Response& response) {
+	if ( ::send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size() ) {
+		return false;
+	}
+
+	std::string in;
+	lcy::protocol::http::Parser parser;
+	response.clear();
+	char buf[4096];
+	for ( ;; ) {
+		if ( !in.empty() && parser.parse(in.data(), in.size(), response) == lcy::protocol::http::Parser::RetCode::READY ) {
+			return parser.nparse() == in.size();
+		}
+
+		ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+		if ( n <= 0 ) {
+			return false;
+		}
+		in.append(buf, n);
+	}
+}
+
+#endif	// __LCY_PROTOCOL_TESTS_LOOPBACK_H__
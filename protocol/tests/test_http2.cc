@@ -0,0 +1,853 @@
+#include "protocol/protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+#include "loopback.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+static std::string unhex(const char* hex) {
+	std::string out;
+	for ( const char* p = hex; *p; ) {
+		if ( *p == ' ' ) {
+			++p;
+			continue;
+		}
+		out.push_back((char)::strtol(std::string(p, 2).c_str(), nullptr, 16));
+		p += 2;
+	}
+	return out;
+}
+
+typedef std::vector<std::pair<std::string, std::string> > field_list;
+
+static bool decode(http2::HpackDecoder& decoder, const std::string& block, field_list& fields) {
+	fields.clear();
+	return decoder.decode(block.data(), block.size(), [&fields](StringView name, StringView value){
+		fields.push_back(std::make_pair(name.toString(), value.toString()));
+		return true;
+	});
+}
+
+///////////////////////////////////////////////////////////////
+
+bool test_huffman() {
+	bool ok = true;
+	// RFC 7541 C.4.1
+	std::string coded;
+	http2::HuffmanEncode("www.example.com", coded);
+	ok &= check(coded == unhex("f1e3c2e5f23a6ba0ab90f4ff"), "encoded");
+	ok &= check(http2::HuffmanEncodedLength("www.example.com") == coded.size(), "encoded length");
+
+	std::string plain;
+	ok &= check(http2::HuffmanDecode(coded, plain) && plain == "www.example.com", "decoded");
+
+	// every byte, codes from 5 to 30 bits
+	std::string all;
+	for ( int round = 0; round < 3; ++round ) {
+		for ( int c = 0; c < 256; ++c ) {
+			all.push_back((char)(c * (round + 1)));
+		}
+	}
+	for ( size_t len = 0; len < all.size(); len += 37 ) {
+		std::string piece = all.substr(0, len), wire, back;
+		http2::HuffmanEncode(piece, wire);
+		ok &= check(http2::HuffmanDecode(wire, back) && back == piece, "round trip");
+	}
+
+	plain.clear();
+	ok &= check(!http2::HuffmanDecode(unhex("ffffffff"), plain), "EOS");
+	ok &= check(!http2::HuffmanDecode(unhex("f1e3c2e5f23a6ba0ab90f4ff ff"), plain), "padding of 8 bits");
+	plain.clear();
+	// 'a' is 00011, padded with zeros instead of ones
+	ok &= check(!http2::HuffmanDecode(unhex("18"), plain), "padding not of ones");
+	plain.clear();
+	ok &= check(http2::HuffmanDecode(unhex("1f"), plain) && plain == "a", "padding of ones");
+	return ok;
+}
+
+// RFC 7541 C.3 and C.4 : three requests on one connection
+bool test_hpack_requests() {
+	bool ok = true;
+	const char* blocks[2][3] = {
+		{
+			"828684410f7777772e6578616d706c652e636f6d",
+			"828684be58086e6f2d6361636865",
+			"828785bf400a637573746f6d2d6b65790c637573746f6d2d76616c7565",
+		},
+		{
+			"828684418cf1e3c2e5f23a6ba0ab90f4ff",
+			"828684be5886a8eb10649cbf",
+			"828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf",
+		},
+	};
+	const size_t table_bytes[3] = { 57, 110, 164 };
+
+	for ( int huffman = 0; huffman < 2; ++huffman ) {
+		http2::HpackDecoder decoder;
+		field_list fields;
+
+		ok &= check(decode(decoder, unhex(blocks[huffman][0]), fields), "first request");
+		ok &= check(fields.size() == 4 && fields[0].first == ":method" && fields[0].second == "GET" &&
+					fields[2].second == "/" && fields[3].first == ":authority" &&
+					fields[3].second == "www.example.com", "first fields");
+		ok &= check(decoder.tableBytes() == table_bytes[0] && decoder.tableEntries() == 1, "first table");
+
+		ok &= check(decode(decoder, unhex(blocks[huffman][1]), fields), "second request");
+		ok &= check(fields.size() == 5 && fields[3].second == "www.example.com" &&
+					fields[4].first == "cache-control" && fields[4].second == "no-cache", "second fields");
+		ok &= check(decoder.tableBytes() == table_bytes[1], "second table");
+
+		ok &= check(decode(decoder, unhex(blocks[huffman][2]), fields), "third request");
+		ok &= check(fields.size() == 5 && fields[1].second == "https" && fields[2].second == "/index.html" &&
+					fields[4].first == "custom-key" && fields[4].second == "custom-value", "third fields");
+		ok &= check(decoder.tableBytes() == table_bytes[2] && decoder.tableEntries() == 3, "third table");
+	}
+	return ok;
+}
+
+bool test_hpack_round_trip() {
+	bool ok = true;
+	http2::HpackEncoder encoder;
+	http2::HpackDecoder decoder;
+	field_list fields;
+
+	field_list response = {
+		{ ":status", "200" },
+		{ "content-type", "text/html; charset=utf-8" },
+		{ "server", "lcy" },
+		{ "x-request-id", "abc" },
+		{ "content-length", "1234" },
+		{ "set-cookie", "id=42; HttpOnly" },
+	};
+	std::string first, second;
+	for ( const auto& f : response ) {
+		encoder.encode(f.first, f.second, first);
+	}
+	ok &= check(decode(decoder, first, fields) && fields == response, "first block");
+	for ( const auto& f : response ) {
+		encoder.encode(f.first, f.second, second);
+	}
+	ok &= check(decode(decoder, second, fields) && fields == response, "second block");
+	// content-length and set-cookie stay literals, the others are an index each
+	ok &= check(second.size() < first.size() / 2, "indexed the second time");
+	ok &= check(encoder.tableEntries() == decoder.tableEntries() && encoder.tableBytes() == decoder.tableBytes(),
+				"same tables");
+
+	std::string sensitive;
+	encoder.encode("authorization", "secret", sensitive);
+	ok &= check(((uint8_t)sensitive[0] & 0xF0) == 0x10, "never indexed");
+	ok &= check(decode(decoder, sensitive, fields) && fields[0].second == "secret", "never indexed decoded");
+
+	// the table shrinks : a size update leads the next block and evicts on both sides
+	encoder.setMaxTableBytes(64);
+	std::string shrunk;
+	encoder.encode("x-request-id", "def", shrunk);
+	ok &= check(((uint8_t)shrunk[0] & 0xE0) == 0x20, "size update first");
+	ok &= check(decode(decoder, shrunk, fields) && fields.size() == 1 && fields[0].second == "def", "after update");
+	ok &= check(encoder.tableBytes() <= 64 && encoder.tableBytes() == decoder.tableBytes() &&
+				encoder.tableEntries() == decoder.tableEntries(), "evicted alike");
+
+	// many distinct fields turn the table over
+	http2::HpackEncoder big_encoder;
+	http2::HpackDecoder big_decoder;
+	for ( int i = 0; i < 500; ++i ) {
+		std::string block;
+		field_list sent = {
+			{ "x-counter", std::to_string(i % 50) },
+			{ "x-name-" + std::to_string(i % 70), std::string(i % 40, 'v') },
+		};
+		for ( const auto& f : sent ) {
+			big_encoder.encode(f.first, f.second, block);
+		}
+		if ( !decode(big_decoder, block, fields) || fields != sent ) {
+			ok &= check(false, "turned over");
+			break;
+		}
+	}
+	ok &= check(big_encoder.tableBytes() <= 4096 && big_encoder.tableBytes() == big_decoder.tableBytes(),
+				"tables in step");
+
+	http2::HpackDecoder bad;
+	ok &= check(!decode(bad, unhex("80"), fields), "index 0");
+	ok &= check(!decode(bad, unhex("be"), fields), "index past the table");
+	ok &= check(!decode(bad, unhex("410f7777"), fields), "truncated string");
+	ok &= check(!decode(bad, unhex("3fe21f"), fields), "size update above the setting");
+	ok &= check(!decode(bad, unhex("8220"), fields), "size update after a field");
+	ok &= check(!decode(bad, unhex("ff8080808080"), fields), "integer overflow");
+	return ok;
+}
+
+bool test_frames() {
+	bool ok = true;
+	asio::DynamicBuffer out;
+	std::string block(40, 'b');
+	http2::WriteHeaders(out, 5, block, true, 16);
+
+	http2::FrameHead head;
+	http2::ParseFrameHead(out.readBegin(), head);
+	ok &= check(head.type == http2::frame::HEADERS && head.length == 16 && head.stream_id == 5 &&
+				head.flags == http2::FLAG_END_STREAM, "HEADERS");
+	out.read(http2::FRAME_HEAD_BYTES + 16);
+	http2::ParseFrameHead(out.readBegin(), head);
+	ok &= check(head.type == http2::frame::CONTINUATION && head.length == 16 && head.flags == 0, "CONTINUATION");
+	out.read(http2::FRAME_HEAD_BYTES + 16);
+	http2::ParseFrameHead(out.readBegin(), head);
+	ok &= check(head.type == http2::frame::CONTINUATION && head.length == 8 &&
+				head.flags == http2::FLAG_END_HEADERS, "last CONTINUATION");
+	out.read(http2::FRAME_HEAD_BYTES + 8);
+	ok &= check(out.dataBytes() == 0, "three frames");
+
+	http2::WriteWindowUpdate(out, 0x7FFFFFFF, 1000);
+	http2::ParseFrameHead(out.readBegin(), head);
+	ok &= check(head.stream_id == 0x7FFFFFFF && head.length == 4 &&
+				http2::ReadUint32(out.readBegin() + http2::FRAME_HEAD_BYTES) == 1000, "WINDOW_UPDATE");
+	ok &= check(std::string(http2::FrameToString(http2::frame::GOAWAY)) == "GOAWAY" &&
+				std::string(http2::ErrorToString(http2::error::FLOW_CONTROL_ERROR)) == "FLOW_CONTROL_ERROR", "names");
+	return ok;
+}
+
+///////////////////////////////////////////////////////////////
+
+struct Frame {
+	http2::FrameHead head;
+	std::string payload;
+};
+
+// every whole frame in `in`, consumed
+static std::vector<Frame> parse_frames(asio::DynamicBuffer& in) {
+	std::vector<Frame> frames;
+	while ( in.dataBytes() >= http2::FRAME_HEAD_BYTES ) {
+		Frame f;
+		http2::ParseFrameHead(in.readBegin(), f.head);
+		if ( in.dataBytes() < http2::FRAME_HEAD_BYTES + f.head.length ) {
+			break;
+		}
+		f.payload.assign(in.readBegin() + http2::FRAME_HEAD_BYTES, f.head.length);
+		in.read(http2::FRAME_HEAD_BYTES + f.head.length);
+		frames.push_back(f);
+	}
+	return frames;
+}
+
+struct Reply {
+	int status;
+	field_list fields;
+	std::string body;
+	bool ended;
+	int reset;		// error code of a RST_STREAM, -1 if none
+
+	Reply() : status(0), ended(false), reset(-1) {}
+
+	std::string field(const std::string& name) const
+	{
+		for ( const auto& f : fields ) {
+			if ( f.first == name ) {
+				return f.second;
+			}
+		}
+		return std::string();
+	}
+};
+
+/*
+* The client end : HPACK state, replies by stream, and what the connection got besides.
+*/
+struct Peer {
+	http2::HpackEncoder encoder;
+	http2::HpackDecoder decoder;
+	std::map<uint32_t, Reply> replies;
+	std::string block;				// header block of a HEADERS still waiting for CONTINUATION
+	int goaway;						// error code of a GOAWAY, -1 if none
+	size_t pings;
+	size_t settings_acks;
+	size_t settings;
+	uint32_t window_updates;		// sum of the increments for the connection
+
+	Peer() : goaway(-1), pings(0), settings_acks(0), settings(0), window_updates(0) {}
+
+	void request(asio::DynamicBuffer& out, uint32_t id, const char* method, const std::string& path,
+				 const field_list& extra = field_list(), bool end_stream = true)
+	{
+		std::string fields;
+		encoder.encode(":method", method, fields);
+		encoder.encode(":scheme", "http", fields);
+		encoder.encode(":path", path, fields);
+		encoder.encode(":authority", "example.test", fields);
+		for ( const auto& f : extra ) {
+			encoder.encode(f.first, f.second, fields);
+		}
+		http2::WriteHeaders(out, id, fields, end_stream);
+	}
+
+	void preface(asio::DynamicBuffer& out, uint32_t initial_window = 0)
+	{
+		out.reserve(http2::CLIENT_PREFACE_BYTES);
+		::memcpy(out.writeBegin(), http2::CLIENT_PREFACE, http2::CLIENT_PREFACE_BYTES);
+		out.write(http2::CLIENT_PREFACE_BYTES);
+		http2::setting_type id = http2::setting::INITIAL_WINDOW_SIZE;
+		http2::WriteSettings(out, &id, &initial_window, initial_window > 0 ? 1 : 0);
+	}
+
+	void take(const Frame& f)
+	{
+		Reply& r = replies[f.head.stream_id];
+		switch ( f.head.type ) {
+			case http2::frame::HEADERS :
+			case http2::frame::CONTINUATION :
+				block += f.payload;
+				if ( f.head.flags & http2::FLAG_END_HEADERS ) {
+					decode(decoder, block, r.fields);
+					r.status = ::atoi(r.field(":status").c_str());
+					block.clear();
+				}
+				if ( f.head.type == http2::frame::HEADERS && (f.head.flags & http2::FLAG_END_STREAM) ) {
+					r.ended = true;
+				}
+				break;
+			case http2::frame::DATA :
+				r.body += f.payload;
+				r.ended = r.ended || (f.head.flags & http2::FLAG_END_STREAM) != 0;
+				break;
+			case http2::frame::RST_STREAM :
+				r.reset = (int)http2::ReadUint32(f.payload.data());
+				break;
+			case http2::frame::GOAWAY :
+				goaway = (int)http2::ReadUint32(f.payload.data() + 4);
+				break;
+			case http2::frame::PING :
+				pings += (f.head.flags & http2::FLAG_ACK) ? 1 : 0;
+				break;
+			case http2::frame::SETTINGS :
+				if ( f.head.flags & http2::FLAG_ACK ) {
+					++settings_acks;
+				} else {
+					++settings;
+				}
+				break;
+			case http2::frame::WINDOW_UPDATE :
+				if ( f.head.stream_id == 0 ) {
+					window_updates += http2::ReadUint32(f.payload.data());
+				}
+				break;
+			default :
+				break;
+		}
+		if ( f.head.stream_id == 0 ) {
+			replies.erase(0);
+		}
+	}
+};
+
+/*
+* In memory : a ServerSession fed by hand.
+*/
+struct Harness {
+	http2::ServerSession session;
+	asio::DynamicBuffer in;			// from the client
+	asio::DynamicBuffer out;		// from the server
+	Peer peer;
+
+	explicit Harness(http2::ServerSession::handler_type handler, size_t max_body = 0) :
+		session(std::move(handler))
+	{
+		session.setMaxConcurrentStreams(4);
+		session.setMaxBodyBytes(max_body);
+		session.setMaxHeaderListBytes(1024);
+		session.start(out);
+	}
+
+	// what is in `in` goes to the session, what it answers to the peer
+	void run(size_t send_budget = 1 << 30)
+	{
+		in.read(session.receive(in.readBegin(), in.dataBytes(), out));
+		session.send(out, send_budget);
+		for ( const Frame& f : parse_frames(out) ) {
+			peer.take(f);
+		}
+	}
+};
+
+static void echo_handler(const http::RequestView& request, http::Response& response) {
+	if ( request.uri() == "/big" ) {
+		response.setBody(std::string(100000, 'z'));
+		return;
+	}
+	response.setHeader("X-Method", http::MethodToString(request.method()));
+	response.setHeader("X-Host", request.getHeader(http::field::HOST).toString());
+	response.setHeader("X-Cookie", request.getHeader(http::field::COOKIE).toString());
+	response.setHeader(http::field::CONNECTION, "keep-alive");
+	response.setBody(http::VersionToString(request.version()) + " " + request.uri().toString() + " " +
+					 request.body().toString());
+}
+
+bool test_session_basics() {
+	bool ok = true;
+	Harness h(echo_handler);
+	h.peer.preface(h.in);
+	h.peer.request(h.in, 1, "GET", "/a", { { "cookie", "a=1" }, { "cookie", "b=2" } });
+	h.peer.request(h.in, 3, "POST", "/b", field_list(), false);
+	http2::WriteData(h.in, 3, "part one,", false);
+	http2::WriteData(h.in, 3, " part two", true);
+	const char ping[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	http2::WritePing(h.in, ping, false);
+
+	// bytes trickle in : partial frames wait for the rest
+	std::string all(h.in.readBegin(), h.in.dataBytes());
+	h.in.read(h.in.dataBytes());
+	for ( size_t at = 0; at < all.size(); at += 7 ) {
+		std::string piece = all.substr(at, 7);
+		h.in.reserve(piece.size());
+		::memcpy(h.in.writeBegin(), piece.data(), piece.size());
+		h.in.write(piece.size());
+		h.run();
+	}
+
+	ok &= check(h.peer.settings == 1 && h.peer.settings_acks == 1 && h.peer.pings == 1, "settings and ping");
+	ok &= check(h.peer.window_updates == http2::ServerSession::RECEIVE_WINDOW_BYTES - 65535, "connection window");
+	const Reply& a = h.peer.replies[1];
+	ok &= check(a.ended && a.status == 200 && a.body == "HTTP/2 /a ", "GET");
+	ok &= check(a.field("x-host") == "example.test", ":authority as Host");
+	ok &= check(a.field("x-cookie") == "a=1; b=2", "cookies joined");
+	ok &= check(a.field("connection").empty(), "connection field dropped");
+	ok &= check(a.field("content-length") == std::to_string(a.body.size()), "content-length added");
+	const Reply& b = h.peer.replies[3];
+	ok &= check(b.ended && b.field("x-method") == "POST" && b.body == "HTTP/2 /b part one, part two", "POST");
+	ok &= check(h.session.streams() == 0 && !h.session.over(), "streams closed");
+
+	// a HEAD gets the length but no DATA
+	h.peer.request(h.in, 5, "HEAD", "/big");
+	h.run();
+	ok &= check(h.peer.replies[5].ended && h.peer.replies[5].body.empty() &&
+				h.peer.replies[5].field("content-length") == "100000", "HEAD");
+	return ok;
+}
+
+bool test_session_flow_control() {
+	bool ok = true;
+	Harness h(echo_handler);
+	h.peer.preface(h.in, 1000);		// 1000 bytes per stream, 65535 for the connection
+	h.peer.request(h.in, 1, "GET", "/big");
+	h.peer.request(h.in, 3, "GET", "/big");
+	h.run();
+	ok &= check(h.peer.replies[1].body.size() == 1000 && h.peer.replies[3].body.size() == 1000, "stream windows");
+	ok &= check(h.session.pendingBytes() == 2 * 99000, "pending");
+
+	// more for stream 1 : the connection window stops it
+	http2::WriteWindowUpdate(h.in, 1, 200000);
+	h.run();
+	ok &= check(h.peer.replies[1].body.size() == 65535 - 1000, "connection window");
+	ok &= check(h.peer.replies[3].body.size() == 1000, "stream 3 still blocked");
+
+	// the window grows for streams already open
+	http2::setting_type id = http2::setting::INITIAL_WINDOW_SIZE;
+	uint32_t value = 200000;
+	http2::WriteSettings(h.in, &id, &value, 1);
+	http2::WriteWindowUpdate(h.in, 0, 1000000);
+	h.run();
+	ok &= check(h.peer.replies[1].ended && h.peer.replies[1].body == std::string(100000, 'z'), "stream 1 done");
+	ok &= check(h.peer.replies[3].ended && h.peer.replies[3].body.size() == 100000, "stream 3 done");
+	ok &= check(h.session.pendingBytes() == 0 && h.session.streams() == 0, "nothing left");
+
+	// send() keeps to its budget, one frame at a time in turn
+	Harness t(echo_handler);
+	t.peer.preface(t.in, 1 << 20);
+	http2::WriteWindowUpdate(t.in, 0, 1 << 20);
+	t.peer.request(t.in, 1, "GET", "/big");
+	t.peer.request(t.in, 3, "GET", "/big");
+	t.run(20000);
+	ok &= check(t.peer.replies[1].body.size() == 16384 && t.peer.replies[3].body.size() == 16384, "round robin");
+
+	// a window past 2^31 - 1
+	Harness o(echo_handler);
+	o.peer.preface(o.in);
+	http2::WriteWindowUpdate(o.in, 0, 0x7FFFFFFF);
+	o.run();
+	ok &= check(o.peer.goaway == (int)http2::error::FLOW_CONTROL_ERROR && o.session.over(), "window overflow");
+	return ok;
+}
+
+bool test_session_limits() {
+	bool ok = true;
+	Harness h(echo_handler, 100);
+	h.peer.preface(h.in);
+
+	// beyond the 4 concurrent streams : refused, the others go on
+	for ( uint32_t id = 1; id <= 11; id += 2 ) {
+		h.peer.request(h.in, id, "POST", "/s", field_list(), false);
+	}
+	h.run();
+	ok &= check(h.session.streams() == 4, "four open");
+	ok &= check(h.peer.replies[9].reset == (int)http2::error::REFUSED_STREAM &&
+				h.peer.replies[11].reset == (int)http2::error::REFUSED_STREAM, "refused");
+
+	// a body above the limit : 413, then told to stop
+	http2::WriteData(h.in, 1, std::string(101, 'x'), false);
+	h.run();
+	ok &= check(h.peer.replies[1].status == 413 && h.peer.replies[1].reset == (int)http2::error::NO_ERROR, "413");
+	http2::WriteData(h.in, 1, "late", true);		// already on the way, ignored
+	http2::WriteData(h.in, 3, "fine", true);
+	h.run();
+	ok &= check(h.peer.replies[3].body == "HTTP/2 /s fine", "next stream");
+
+	// a header list above the limit
+	h.peer.request(h.in, 13, "GET", "/h", { { "x-large", std::string(2000, 'l') } });
+	h.run();
+	ok &= check(h.peer.replies[13].status == 431, "431");
+
+	// malformed requests reset their stream only
+	h.peer.request(h.in, 15, "GET", "/m", { { "X-Upper", "1" } });
+	h.peer.request(h.in, 17, "GET", "/m", { { "transfer-encoding", "chunked" } });
+	std::string fields;
+	h.peer.encoder.encode(":method", "GET", fields);
+	h.peer.encoder.encode(":path", "/m", fields);
+	http2::WriteHeaders(h.in, 19, fields, true);		// no :scheme
+	h.peer.request(h.in, 21, "GET", "/ok");
+	h.run();
+	ok &= check(h.peer.replies[15].reset == (int)http2::error::PROTOCOL_ERROR &&
+				h.peer.replies[17].reset == (int)http2::error::PROTOCOL_ERROR &&
+				h.peer.replies[19].reset == (int)http2::error::PROTOCOL_ERROR, "malformed");
+	ok &= check(h.peer.replies[21].status == 200 && h.peer.goaway == -1, "connection alive");
+
+	// a header block split over CONTINUATION frames
+	std::string block;
+	h.peer.encoder.encode(":method", "GET", block);
+	h.peer.encoder.encode(":scheme", "http", block);
+	h.peer.encoder.encode(":path", "/continued", block);
+	http2::WriteHeaders(h.in, 23, block, true, 5);
+	h.run();
+	ok &= check(h.peer.replies[23].body == "HTTP/2 /continued ", "CONTINUATION");
+	return ok;
+}
+
+bool test_session_errors() {
+	bool ok = true;
+	struct Case {
+		const char* what;
+		std::function<void (Peer&, asio::DynamicBuffer&)> write;
+		http2::error_type code;
+	};
+	std::vector<Case> cases = {
+		{ "bad preface", [](Peer&, asio::DynamicBuffer& in){
+			in.reserve(24);
+			::memcpy(in.writeBegin(), "GET / HTTP/1.1\r\nHost: x\r\n", 24);
+			in.write(24);
+		}, http2::error::PROTOCOL_ERROR },
+		{ "first frame not SETTINGS", [](Peer&, asio::DynamicBuffer& in){
+			const char ping[8] = { 0 };
+			in.reserve(http2::CLIENT_PREFACE_BYTES);
+			::memcpy(in.writeBegin(), http2::CLIENT_PREFACE, http2::CLIENT_PREFACE_BYTES);
+			in.write(http2::CLIENT_PREFACE_BYTES);
+			http2::WritePing(in, ping, false);
+		}, http2::error::PROTOCOL_ERROR },
+		{ "frame too large", [](Peer& p, asio::DynamicBuffer& in){
+			p.preface(in);
+			p.request(in, 1, "POST", "/", field_list(), false);
+			http2::WriteData(in, 1, std::string(20000, 'x'), true);
+		}, http2::error::FRAME_SIZE_ERROR },
+		{ "even stream", [](Peer& p, asio::DynamicBuffer& in){
+			p.preface(in);
+			p.request(in, 2, "GET", "/");
+		}, http2::error::PROTOCOL_ERROR },
+		{ "interleaved CONTINUATION", [](Peer& p, asio::DynamicBuffer& in){
+			p.preface(in);
+			std::string block(30, '\x82');
+			http2::WriteFrameHead(in, 10, http2::frame::HEADERS, 0, 1);
+			in.reserve(10);
+			::memcpy(in.writeBegin(), block.data(), 10);
+			in.write(10);
+			http2::WriteWindowUpdate(in, 0, 10);
+		}, http2::error::PROTOCOL_ERROR },
+		{ "HPACK garbage", [](Peer& p, asio::DynamicBuffer& in){
+			p.preface(in);
+			http2::WriteHeaders(in, 1, "\x80\xff", true);
+		}, http2::error::COMPRESSION_ERROR },
+		{ "PUSH_PROMISE", [](Peer& p, asio::DynamicBuffer& in){
+			p.preface(in);
+			http2::WriteFrameHead(in, 4, http2::frame::PUSH_PROMISE, http2::FLAG_END_HEADERS, 1);
+			in.reserve(4);
+			::memset(in.writeBegin(), 0, 4);
+			in.write(4);
+		}, http2::error::PROTOCOL_ERROR },
+		{ "DATA on an idle stream", [](Peer& p, asio::DynamicBuffer& in){
+			p.preface(in);
+			http2::WriteData(in, 7, "x", true);
+		}, http2::error::PROTOCOL_ERROR },
+		{ "bad SETTINGS length", [](Peer& p, asio::DynamicBuffer& in){
+			p.preface(in);
+			http2::WriteFrameHead(in, 5, http2::frame::SETTINGS, 0, 0);
+			in.reserve(5);
+			::memset(in.writeBegin(), 0, 5);
+			in.write(5);
+		}, http2::error::FRAME_SIZE_ERROR },
+	};
+
+	for ( const Case& c : cases ) {
+		Harness h(echo_handler);
+		c.write(h.peer, h.in);
+		h.run();
+		if ( !check(h.peer.goaway == (int)c.code && h.session.over(), c.what) ) {
+			ok = false;
+			continue;
+		}
+		// anything after is dropped
+		size_t left = h.in.dataBytes();
+		h.peer.request(h.in, 101, "GET", "/");
+		h.run();
+		ok &= check(left == 0 && h.in.dataBytes() == 0 && h.peer.replies.count(101) == 0, "ignored after GOAWAY");
+	}
+
+	// a GOAWAY of the client lets the open streams finish
+	Harness g(echo_handler);
+	g.peer.preface(g.in, 100);
+	g.peer.request(g.in, 1, "GET", "/big");
+	http2::WriteGoaway(g.in, 0, http2::error::NO_ERROR);
+	g.run();
+	ok &= check(!g.session.over() && g.session.streams() == 1, "served after GOAWAY");
+	http2::WriteWindowUpdate(g.in, 1, 200000);
+	http2::WriteWindowUpdate(g.in, 0, 200000);
+	g.run();
+	ok &= check(g.peer.replies[1].ended && g.session.over(), "over once done");
+
+	// shutdown : new streams are refused
+	Harness s(echo_handler);
+	s.peer.preface(s.in);
+	s.run();
+	s.session.shutdown(s.out);
+	s.peer.request(s.in, 1, "GET", "/");
+	s.run();
+	ok &= check(s.peer.goaway == (int)http2::error::NO_ERROR &&
+				s.peer.replies[1].reset == (int)http2::error::REFUSED_STREAM && s.session.over(), "shutdown");
+	return ok;
+}
+
+///////////////////////////////////////////////////////////////
+
+/*
+* Reads until every stream of `ids` has ended or was reset, giving back the credit
+* of each DATA frame unless `credit` is false. False on close or timeout.
+*/
+static bool wait_replies(int fd, Peer& peer, const std::vector<uint32_t>& ids, bool credit = true) {
+	asio::DynamicBuffer in, out;
+	while ( true ) {
+		bool done = true;
+		for ( uint32_t id : ids ) {
+			done &= peer.replies[id].ended || peer.replies[id].reset >= 0;
+		}
+		if ( done ) {
+			return true;
+		}
+
+		in.reserve(65536);
+		ssize_t n = ::recv(fd, in.writeBegin(), in.availableBytes(), 0);
+		if ( n <= 0 ) {
+			return false;
+		}
+		in.write(n);
+		for ( const Frame& f : parse_frames(in) ) {
+			peer.take(f);
+			if ( credit && f.head.type == http2::frame::DATA && f.head.length > 0 ) {
+				http2::WriteWindowUpdate(out, 0, f.head.length);
+				http2::WriteWindowUpdate(out, f.head.stream_id, f.head.length);
+			}
+		}
+		send_all(fd, out);
+	}
+}
+
+bool test_loopback(uint16_t port) {
+	bool ok = true;
+	int fd = connect_to(port);
+	Peer peer;
+	asio::DynamicBuffer out;
+	peer.preface(out);
+
+	// fifty streams at once, in one write
+	std::vector<uint32_t> ids;
+	for ( uint32_t i = 0; i < 50; ++i ) {
+		uint32_t id = 1 + 2 * i;
+		ids.push_back(id);
+		if ( i % 10 == 9 ) {
+			peer.request(out, id, "GET", "/big");
+		} else {
+			peer.request(out, id, "GET", "/users/" + std::to_string(i), { { "accept-encoding", "gzip" } });
+		}
+	}
+	send_all(fd, out);
+	ok &= check(wait_replies(fd, peer, ids), "fifty replies");
+
+	bool all = true;
+	for ( uint32_t i = 0; i < 50; ++i ) {
+		const Reply& r = peer.replies[1 + 2 * i];
+		if ( i % 10 == 9 ) {
+			all &= r.status == 200 && r.body.size() == 300000 && r.field("content-encoding").empty();
+		} else {
+			all &= r.status == 200 && r.body == "user /users/" + std::to_string(i) + " on HTTP/2";
+			all &= !r.field("date").empty();
+		}
+	}
+	ok &= check(all, "multiplexed answers");
+
+	// a POST body over several DATA frames, a route that is missing
+	std::string body(40000, 'p');
+	for ( size_t i = 0; i < body.size(); ++i ) {
+		body[i] = (char)('a' + i % 26);
+	}
+	peer.request(out, 101, "POST", "/echo", { { "content-type", "text/plain" } }, false);
+	for ( size_t at = 0; at < body.size(); at += http2::DEFAULT_MAX_FRAME_BYTES ) {
+		size_t n = std::min<size_t>(http2::DEFAULT_MAX_FRAME_BYTES, body.size() - at);
+		http2::WriteData(out, 101, StringView(body.data() + at, n), at + n == body.size());
+	}
+	peer.request(out, 103, "GET", "/missing");
+	send_all(fd, out);
+	ok &= check(wait_replies(fd, peer, { 101, 103 }), "second batch");
+	ok &= check(peer.replies[101].body == body, "echoed");
+	ok &= check(peer.replies[103].status == 404, "404");
+	ok &= check(peer.goaway == -1, "no GOAWAY");
+	::close(fd);
+	return ok;
+}
+
+// the compressible body of a client that accepts gzip goes out coded
+bool test_loopback_compression(uint16_t port) {
+	bool ok = true;
+	int fd = connect_to(port);
+	Peer peer;
+	asio::DynamicBuffer out;
+	peer.preface(out);
+	peer.request(out, 1, "GET", "/text", { { "accept-encoding", "gzip" } });
+	send_all(fd, out);
+	ok &= check(wait_replies(fd, peer, { 1 }), "reply");
+	const Reply& r = peer.replies[1];
+	ok &= check(r.field("content-encoding") == "gzip" && r.body.size() < 1000, "gzip");
+	ok &= check(r.field("content-length") == std::to_string(r.body.size()), "length of the coded body");
+	::close(fd);
+	return ok;
+}
+
+// a client that gives no credit gets what the initial windows allow, then the rest
+bool test_loopback_flow_control(uint16_t port) {
+	bool ok = true;
+	int fd = connect_to(port);
+	Peer peer;
+	asio::DynamicBuffer out;
+	peer.preface(out, 5000);
+	peer.request(out, 1, "GET", "/big");
+	send_all(fd, out);
+
+	// the 5000 bytes, then nothing
+	struct timeval tv = { 0, 300 * 1000 };
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	ok &= check(!wait_replies(fd, peer, { 1 }, false), "stalled");
+	ok &= check(peer.replies[1].body.size() == 5000, "initial window");
+
+	tv.tv_sec = 2;
+	tv.tv_usec = 0;
+	::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	http2::WriteWindowUpdate(out, 1, 1000000);
+	http2::WriteWindowUpdate(out, 0, 1000000);
+	send_all(fd, out);
+	ok &= check(wait_replies(fd, peer, { 1 }, false), "resumed");
+	ok &= check(peer.replies[1].body.size() == 300000, "whole body");
+	::close(fd);
+	return ok;
+}
+
+// HTTP/1.1 on the same port
+bool test_loopback_http1(uint16_t port) {
+	int fd = connect_to(port);
+	const char request[] = "GET /users/7 HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n";
+	::send(fd, request, sizeof(request) - 1, MSG_NOSIGNAL);
+	std::string raw;
+	char buf[4096];
+	ssize_t n;
+	while ( (n = ::recv(fd, buf, sizeof(buf), 0)) > 0 ) {
+		raw.append(buf, n);
+	}
+	::close(fd);
+	return check(raw.find("HTTP/1.1 200 OK") == 0 && raw.find("user /users/7 on HTTP/1.1") != std::string::npos,
+				 "HTTP/1.1 still served");
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_huffman();
+	ok &= test_hpack_requests();
+	ok &= test_hpack_round_trip();
+	ok &= test_frames();
+	ok &= test_session_basics();
+	ok &= test_session_flow_control();
+	ok &= test_session_limits();
+	ok &= test_session_errors();
+
+	// every stream goes to the routes of a Servlet
+	http::Servlet servlet;
+	servlet.setFunction(http::method::GET, "/users/:id", [](const http::Request& request, http::Response& response){
+		response.setBody("user " + request.uri() + " on " + http::VersionToString(request.version()));
+	});
+	servlet.setFunction(http::method::POST, "/echo", [](const http::Request& request, http::Response& response){
+		response.setHeader(http::field::CONTENT_TYPE, request.getHeader(http::field::CONTENT_TYPE));
+		response.setBody(request.body());
+	});
+	servlet.setFunction(http::method::GET, "/big", [](const http::Request&, http::Response& response){
+		response.setBody(std::string(300000, 'b'));
+	});
+	servlet.setFunction(http::method::GET, "/text", [](const http::Request&, http::Response& response){
+		std::string text;
+		for ( int i = 0; i < 500; ++i ) {
+			text += "compressible text ";
+		}
+		response.setHeader(http::field::CONTENT_TYPE, "text/plain");
+		response.setCompression(6);
+		response.setBody(text);
+	});
+
+	asio::IOContext ioc;
+	http::Server server(ioc, 1);
+	server.setHttp2(true);
+	server.setHandler([&servlet](const http::RequestView& request, http::Response& response){
+		http::RouteParams params;
+		const http::Servlet::function_type* func = servlet.findFunction(request.method(), request.uri(), params);
+		if ( func ) {
+			(*func)(request.toRequest(), response);
+		} else {
+			response.setState(http::state::NOT_FOUND);
+		}
+	});
+	server.start(asio::ip::Endpoint("127.0.0.1", 0));
+
+	asio::ip::Endpoint endpoint;
+	server.localAddr(endpoint);
+	uint16_t port = endpoint.port();
+
+	std::thread client([&](){
+		ok &= test_loopback(port);
+		ok &= test_loopback_compression(port);
+		ok &= test_loopback_flow_control(port);
+		ok &= test_loopback_http1(port);
+
+		asio::post(ioc, [&ioc](){ ioc.quit(); });
+	});
+
+	ioc.loop_wait();
+	client.join();
+	server.stop();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
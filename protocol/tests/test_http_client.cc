@@ -0,0 +1,433 @@
+#include "protocol/protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+static uint16_t port_of(http::Server& server) {
+	asio::ip::Endpoint endpoint;
+	server.localAddr(endpoint);
+	return endpoint.port();
+}
+
+static asio::ip::Endpoint loopback(uint16_t port) {
+	return asio::ip::Endpoint("127.0.0.1", port);
+}
+
+static http::Request get(const std::string& uri, http::method_type m = http::method::GET) {
+	http::Request request;
+	request.setMethod(m);
+	request.setUri(uri);
+	return request;
+}
+
+// Runs the loop until a handler quits it, or `ms` pass
+static void run(asio::IOContext& ioc, time_t ms = 5000) {
+	asio::SteadyTimer guard(ioc, ms);
+	guard.async_wait([&ioc](asio::errcode_type ec, asio::SteadyTimer::timeout_type){
+		if ( !ec ) {
+			ioc.quit();
+		}
+	});
+	ioc.loop_wait();
+}
+
+/*
+* Blocking loopback listener, for the answers http::Server never gives : it runs
+* `script` on a thread with each accepted connection in turn.
+*/
+static int listen_any(uint16_t& port) {
+	int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+
+	struct sockaddr_in addr;
+	::memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	::bind(fd, (struct sockaddr*)&addr, sizeof(addr));
+	::listen(fd, 16);
+
+	socklen_t len = sizeof(addr);
+	::getsockname(fd, (struct sockaddr*)&addr, &len);
+	port = ntohs(addr.sin_port);
+	return fd;
+}
+
+// Reads one request head, the requests of these tests have no body
+static std::string recv_head(int fd) {
+	std::string in;
+	char c;
+	while ( in.find("\r\n\r\n") == std::string::npos && ::recv(fd, &c, 1, 0) == 1 ) {
+		in.push_back(c);
+	}
+	return in;
+}
+
+static void send_all(int fd, const std::string& data) {
+	::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+}
+
+static void echo_uri(const http::RequestView& request, http::Response& response) {
+	response.setHeader(http::field::CONTENT_TYPE, "text/plain");
+	response.setBody(request.uri().toString());
+}
+
+///////////////////////////////////////////////////////////////
+
+static bool test_keep_alive(asio::IOContext& ioc, uint16_t port) {
+	http::Client client(ioc);
+	const size_t kRequests = 20;
+
+	size_t done = 0;
+	bool ok = true;
+	std::function<void ()> next = [&](){
+		std::string uri = "/n" + std::to_string(done);
+		client.request(loopback(port), get(uri), [&, uri](asio::errcode_type ec, http::Response& response){
+			ok &= check(!ec, "keep-alive : no error");
+			ok &= check(response.state() == http::state::OK, "keep-alive : 200");
+			ok &= check(response.body() == uri, "keep-alive : body");
+			ok &= check(client.connections() == 1, "keep-alive : one connection");
+			if ( ++done == kRequests ) {
+				ioc.quit();
+			} else {
+				next();
+			}
+		});
+	};
+	next();
+	run(ioc);
+
+	ok &= check(done == kRequests, "keep-alive : all answered");
+	ok &= check(client.idleConnections() == 1, "keep-alive : pooled");
+
+	// HEAD : a Content-Length but no body
+	client.request(loopback(port), get("/head", http::method::HEAD), [&](asio::errcode_type ec, http::Response& response){
+		ok &= check(!ec && response.body().empty(), "keep-alive : HEAD");
+		ok &= check(response.getHeader(http::field::CONTENT_LENGTH) == "5", "keep-alive : HEAD length");
+		ioc.quit();
+	});
+	run(ioc);
+	ok &= check(client.connections() == 1, "keep-alive : still one connection");
+	return ok;
+}
+
+static bool test_bounds(asio::IOContext& ioc, uint16_t port) {
+	bool ok = true;
+
+	{
+		http::Client client(ioc);
+		client.setMaxConnectionsPerHost(4);
+		client.setMaxInFlightPerHost(2);
+
+		size_t done = 0;
+		for ( size_t i = 0; i < 10; ++i ) {
+			std::string uri = "/b" + std::to_string(i);
+			client.request(loopback(port), get(uri), [&, uri](asio::errcode_type ec, http::Response& response){
+				ok &= check(!ec && response.body() == uri, "bounds : body");
+				ok &= check(client.inFlight() <= 2, "bounds : in flight");
+				if ( ++done == 10 ) {
+					ioc.quit();
+				}
+			});
+		}
+		ok &= check(client.inFlight() == 2 && client.queued() == 8, "bounds : queued beyond the bound");
+		run(ioc);
+		ok &= check(done == 10, "bounds : all answered");
+		ok &= check(client.connections() <= 2, "bounds : no more connections than in flight");
+	}
+
+	{
+		http::Client client(ioc);
+		client.setMaxConnectionsPerHost(1);
+		client.setMaxQueuedPerHost(1);
+
+		std::vector<asio::errcode_type> errors;
+		for ( size_t i = 0; i < 3; ++i ) {
+			client.request(loopback(port), get("/q"), [&](asio::errcode_type ec, http::Response&){
+				errors.push_back(ec);
+				if ( errors.size() == 3 ) {
+					ioc.quit();
+				}
+			});
+		}
+		run(ioc);
+		ok &= check(errors.size() == 3, "queue : all answered");
+		ok &= check(errors.size() == 3 && errors[0] == EAGAIN, "queue : full");
+		ok &= check(errors.size() == 3 && !errors[1] && !errors[2], "queue : the others");
+	}
+	return ok;
+}
+
+static bool test_pipelining(asio::IOContext& ioc, uint16_t port) {
+	http::Client client(ioc);
+	client.setMaxConnectionsPerHost(1);
+	client.setPipelining(4);
+
+	bool ok = true;
+	std::vector<std::string> order;
+	for ( size_t i = 0; i < 8; ++i ) {
+		std::string uri = "/p" + std::to_string(i);
+		client.request(loopback(port), get(uri), [&](asio::errcode_type ec, http::Response& response){
+			ok &= check(!ec, "pipelining : no error");
+			order.push_back(response.body());
+			if ( order.size() == 8 ) {
+				ioc.quit();
+			}
+		});
+	}
+	ok &= check(client.inFlight() == 4 && client.queued() == 4, "pipelining : depth");
+
+	// not pipelined : waits for the connection to be idle
+	bool posted = false;
+	client.request(loopback(port), get("/post", http::method::POST), [&](asio::errcode_type ec, http::Response& response){
+		ok &= check(!ec && response.body() == "/post", "pipelining : POST");
+		ok &= check(order.size() == 8, "pipelining : POST after the others");
+		posted = true;
+		ioc.quit();
+	});
+
+	run(ioc);
+	ok &= check(order.size() == 8, "pipelining : all answered");
+	for ( size_t i = 0; i < order.size(); ++i ) {
+		ok &= check(order[i] == "/p" + std::to_string(i), "pipelining : in order");
+	}
+	if ( !posted ) {
+		run(ioc);
+	}
+	ok &= check(posted, "pipelining : POST answered");
+	ok &= check(client.connections() == 1, "pipelining : one connection");
+	return ok;
+}
+
+static bool test_streaming(asio::IOContext& ioc, uint16_t port) {
+	http::Client client(ioc);
+
+	bool ok = true;
+	size_t received = 0, pieces = 0;
+	bool done = false;
+	client.request(loopback(port), get("/stream"), [&](StringView piece){
+		received += piece.size();
+		++pieces;
+	}, [&](asio::errcode_type ec, http::Response& response){
+		ok &= check(!ec && response.state() == http::state::OK, "streaming : 200");
+		ok &= check(response.body().empty(), "streaming : no collected body");
+		done = true;
+		ioc.quit();
+	});
+	run(ioc);
+
+	ok &= check(done, "streaming : answered");
+	ok &= check(received == 64 * 4096, "streaming : every byte");
+	ok &= check(pieces > 1, "streaming : in pieces");
+
+	// the same body collected, and refused above the limit
+	client.setMaxBodyBytes(4096);
+	client.request(loopback(port), get("/stream"), [&](asio::errcode_type ec, http::Response&){
+		ok &= check(ec == EMSGSIZE, "streaming : body limit");
+		ioc.quit();
+	});
+	run(ioc);
+	return ok;
+}
+
+static bool test_decompression(asio::IOContext& ioc, uint16_t port) {
+	http::Client client(ioc);
+	client.setDecompression(true);
+
+	bool ok = true;
+	bool done = false;
+	client.request(loopback(port), get("/text"), [&](asio::errcode_type ec, http::Response& response){
+		ok &= check(!ec, "decompression : no error");
+		ok &= check(response.body() == std::string(8192, 'z'), "decompression : body");
+		ok &= check(!response.hasHeader(http::field::CONTENT_ENCODING), "decompression : coding removed");
+		done = true;
+		ioc.quit();
+	});
+	run(ioc);
+	return ok && check(done, "decompression : answered");
+}
+
+static bool test_timeouts(asio::IOContext& ioc, uint16_t port) {
+	bool ok = true;
+
+	http::Client client(ioc);
+	client.setRequestTimeout(100);
+	client.setIdleTimeout(100);
+
+	time_t start = asio::details::now_ms();
+	asio::errcode_type error = 0;
+	client.request(loopback(port), get("/hang"), [&](asio::errcode_type ec, http::Response&){
+		error = ec;
+		ioc.quit();
+	});
+	run(ioc);
+	time_t took = asio::details::now_ms() - start;
+	ok &= check(error == ETIMEDOUT, "timeout : request");
+	ok &= check(took >= 100 && took < 1000, "timeout : in time");
+	ok &= check(client.connections() == 0, "timeout : connection dropped");
+
+	// the next request gets a new connection, which is dropped once idle
+	client.request(loopback(port), get("/after"), [&](asio::errcode_type ec, http::Response& response){
+		ok &= check(!ec && response.body() == "/after", "timeout : next request");
+		ioc.quit();
+	});
+	run(ioc);
+	ok &= check(client.idleConnections() == 1, "timeout : pooled");
+	run(ioc, 400);
+	ok &= check(client.connections() == 0, "timeout : idle connection closed");
+
+	// nobody listens
+	uint16_t closed_port = 0;
+	::close(listen_any(closed_port));
+	client.request(loopback(closed_port), get("/"), [&](asio::errcode_type ec, http::Response&){
+		error = ec;
+		ioc.quit();
+	});
+	run(ioc);
+	ok &= check(error == ECONNREFUSED, "connect : refused");
+
+	// close() cancels what is left
+	client.request(loopback(port), get("/hang"), [&](asio::errcode_type ec, http::Response&){
+		error = ec;
+	});
+	client.request(loopback(port), get("/hang"), [&](asio::errcode_type, http::Response&){});
+	client.close();
+	ok &= check(error == ECANCELED, "close : canceled");
+	ok &= check(client.connections() == 0 && client.inFlight() == 0, "close : nothing left");
+	return ok;
+}
+
+/*
+* Answers http::Server does not give : a keep-alive connection closed under the
+* next request, a body up to the close.
+*/
+static bool test_peer(asio::IOContext& ioc) {
+	uint16_t port = 0;
+	int listen_fd = listen_any(port);
+	int accepted = 0;
+
+	std::thread peer([listen_fd, &accepted](){
+		// 1 : answers, then closes without reading the next request
+		int fd = ::accept(listen_fd, nullptr, nullptr);
+		++accepted;
+		recv_head(fd);
+		send_all(fd, "HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\na");
+		::usleep(50 * 1000);
+		::close(fd);
+
+		// 2 : the GET sent again, then a body that ends with the connection
+		fd = ::accept(listen_fd, nullptr, nullptr);
+		++accepted;
+		recv_head(fd);
+		send_all(fd, "HTTP/1.1 100 Continue\r\n\r\nHTTP/1.1 200 OK\r\n\r\nuntil close");
+		::close(fd);
+
+		// 3 : answers, then closes : a POST is not sent again
+		fd = ::accept(listen_fd, nullptr, nullptr);
+		++accepted;
+		recv_head(fd);
+		send_all(fd, "HTTP/1.1 200 OK\r\nContent-Length: 1\r\n\r\nc");
+		::usleep(50 * 1000);
+		::close(fd);
+	});
+
+	bool ok = true;
+	http::Client client(ioc);
+
+	std::vector<std::string> bodies;
+	asio::errcode_type post_error = 0;
+	std::function<void ()> first = [&](){
+		client.request(loopback(port), get("/1"), [&](asio::errcode_type ec, http::Response& response){
+			ok &= check(!ec && response.body() == "a", "peer : first");
+			bodies.push_back(response.body());
+
+			// still pooled : the peer closes it while this one is on the way
+			::usleep(100 * 1000);
+			client.request(loopback(port), get("/2"), [&](asio::errcode_type ec, http::Response& response){
+				ok &= check(!ec, "peer : sent again");
+				ok &= check(response.body() == "until close", "peer : body up to the close");
+				bodies.push_back(response.body());
+
+				client.request(loopback(port), get("/3"), [&](asio::errcode_type ec, http::Response& response){
+					ok &= check(!ec && response.body() == "c", "peer : third");
+					::usleep(100 * 1000);
+					client.request(loopback(port), get("/4", http::method::POST), [&](asio::errcode_type ec, http::Response&){
+						post_error = ec;
+						ioc.quit();
+					});
+				});
+			});
+		});
+	};
+	first();
+	run(ioc);
+	peer.join();
+	::close(listen_fd);
+
+	ok &= check(bodies.size() == 2, "peer : answered");
+	ok &= check(accepted == 3, "peer : connections");
+	ok &= check(post_error != 0, "peer : POST not sent again");
+	return ok;
+}
+
+int main() {
+	asio::IOContext ioc;
+	asio::ip::Endpoint any("127.0.0.1", 0);
+
+	http::Server server(ioc, 0);		// on the loop of the client
+	server.setHandler([](const http::RequestView& request, http::Response& response){
+		if ( request.uri() == "/text" ) {
+			response.setHeader(http::field::CONTENT_TYPE, "text/plain");
+			response.setBody(std::string(8192, 'z'));
+			return;
+		}
+		if ( request.uri() == "/head" ) {
+			response.setBody("12345");
+			return;
+		}
+		echo_uri(request, response);
+	});
+	server.setStreamHandler([](const http::RequestView& request, const http::Server::stream_ptr& stream){
+		if ( request.uri() == "/hang" ) {
+			return true;		// never answered
+		}
+		if ( request.uri() != "/stream" ) {
+			return false;
+		}
+		std::string block(4096, 's');
+		for ( size_t i = 0; i < 64; ++i ) {
+			stream->write(block);
+		}
+		stream->end();
+		return true;
+	});
+	server.setCompression(6);
+	server.start(any);
+
+	uint16_t port = port_of(server);
+	bool ok = true;
+	ok &= test_keep_alive(ioc, port);
+	ok &= test_bounds(ioc, port);
+	ok &= test_pipelining(ioc, port);
+	ok &= test_streaming(ioc, port);
+	ok &= test_decompression(ioc, port);
+	ok &= test_timeouts(ioc, port);
+	ok &= test_peer(ioc);
+
+	server.stop();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,273 @@
+#include "protocol/protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+#include "loopback.h"
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+// compressible, but not trivially
+static std::string make_text(size_t size) {
+	std::string text;
+	for ( size_t i = 0; text.size() < size; ++i ) {
+		text += "{\"id\":" + std::to_string(i * 7919 % 1000) + ",\"name\":\"item\"},";
+	}
+	text.resize(size);
+	return text;
+}
+
+static http::Response make_response(const std::string& type, const std::string& body) {
+	http::Response response;
+	response.setVersion(http::version::HTTP_1_1);
+	response.setState(http::state::OK);
+	response.setHeader(http::field::CONTENT_TYPE, type);
+	response.setBody(body);
+	return response;
+}
+
+bool test_negotiate() {
+	bool ok = true;
+	ok &= check(http::NegotiateCoding("") == http::coding::IDENTITY, "empty");
+	ok &= check(http::NegotiateCoding("gzip, deflate, br") == http::coding::GZIP, "gzip first on a tie");
+	ok &= check(http::NegotiateCoding("deflate, gzip;q=0.5") == http::coding::DEFLATE, "q-value");
+	ok &= check(http::NegotiateCoding("br") == http::coding::IDENTITY, "nothing zlib knows");
+	ok &= check(http::NegotiateCoding("*") == http::coding::GZIP, "any");
+	ok &= check(http::NegotiateCoding("*;q=0.1, gzip;q=0") == http::coding::DEFLATE, "any but gzip");
+	ok &= check(http::NegotiateCoding("GZIP;Q=1.000") == http::coding::GZIP, "case insensitive");
+	ok &= check(http::NegotiateCoding("x-gzip") == http::coding::GZIP, "x-gzip");
+	ok &= check(http::NegotiateCoding("gzip;q=0.0, deflate;q=0") == http::coding::IDENTITY, "all refused");
+	ok &= check(http::NegotiateCoding("gzip;q=2") == http::coding::IDENTITY, "bad q-value");
+
+	ok &= check(http::AcceptsCoding("gzip;q=0.001", "gzip"), "accepts");
+	ok &= check(!http::AcceptsCoding("deflate", "gzip"), "does not accept");
+
+	ok &= check(http::Compressible("text/html; charset=utf-8"), "text");
+	ok &= check(http::Compressible("application/json"), "json");
+	ok &= check(http::Compressible("application/problem+json"), "+json");
+	ok &= check(http::Compressible("image/svg+xml"), "svg");
+	ok &= check(!http::Compressible("image/png"), "png");
+	ok &= check(!http::Compressible(""), "no type");
+	return ok;
+}
+
+bool test_round_trip() {
+	bool ok = true;
+	std::string text = make_text(100 * 1024);
+
+	for ( http::coding_type c : { http::coding::GZIP, http::coding::DEFLATE } ) {
+		std::string packed, unpacked;
+		ok &= check(http::Compress(c, text, 6, packed) && packed.size() < text.size() / 4, "compressed");
+		ok &= check(http::Decompress(c, packed, unpacked) && unpacked == text, "round trip");
+
+		// the deflate stream of a thread is reused
+		std::string again;
+		ok &= check(http::Compress(c, text, 1, again) && http::Decompress(c, again, unpacked = "") &&
+					unpacked == text, "reused at another level");
+
+		ok &= check(!http::Decompress(c, packed.substr(0, packed.size() / 2), unpacked = ""), "truncated");
+		ok &= check(!http::Decompress(c, packed, unpacked = "", 1000) && unpacked.empty(), "above max_bytes");
+	}
+
+	std::string packed;
+	http::Compress(http::coding::GZIP, "abc", 6, packed);
+	ok &= check(packed[0] == '\x1f' && packed[1] == '\x8b', "gzip magic");
+	ok &= check(!http::Decompress(http::coding::GZIP, "not compressed", packed), "corrupt");
+	ok &= check(!http::Compress(http::coding::IDENTITY, "abc", 6, packed), "identity");
+	return ok;
+}
+
+bool test_streaming() {
+	bool ok = true;
+	std::string text = make_text(64 * 1024);
+
+	http::Compressor compressor(http::coding::GZIP, 6);
+	ok &= check(compressor.ok(), "set up");
+
+	std::string out, seen;
+	for ( size_t pos = 0; pos < text.size(); pos += 5000 ) {
+		size_t before = out.size();
+		ok &= check(compressor.write(StringView(text).substr(pos, 5000), out, true), "write");
+		ok &= check(out.size() > before, "flushed piece");
+	}
+	ok &= check(compressor.finish(out), "finish");
+	ok &= check(!compressor.write("more", out), "finished");
+	ok &= check(http::Decompress(http::coding::GZIP, out, seen) && seen == text, "streamed round trip");
+
+	http::Compressor deflate(http::coding::DEFLATE, 9);
+	std::string packed, unpacked;
+	deflate.write(text, packed);
+	deflate.finish(packed);
+	ok &= check(http::Decompress(http::coding::DEFLATE, packed, unpacked) && unpacked == text, "deflate stream");
+	return ok;
+}
+
+bool test_compress_response() {
+	bool ok = true;
+	std::string text = make_text(4096);
+
+	http::Response response = make_response("application/json", text);
+	response.setHeader(http::field::CONTENT_LENGTH, "4096");
+	response.setHeader(http::field::ETAG, "\"v1\"");
+	ok &= check(http::CompressResponse(response, http::coding::GZIP, 6, 1024), "compressed");
+	ok &= check(response.getHeader(http::field::CONTENT_ENCODING) == "gzip", "content encoding");
+	ok &= check(!response.hasHeader(http::field::CONTENT_LENGTH), "content length dropped");
+	ok &= check(response.getHeader(http::field::ETAG) == "W/\"v1\"", "etag weakened");
+	ok &= check(response.getHeader(http::field::VARY) == "Accept-Encoding", "vary");
+	std::string body;
+	ok &= check(http::Decompress(http::coding::GZIP, response.body(), body) && body == text, "body");
+
+	response = make_response("application/json", text);
+	response.setHeader(http::field::VARY, "Origin");
+	ok &= check(!http::CompressResponse(response, http::coding::IDENTITY, 6, 1024) &&
+				response.body() == text, "identity");
+	ok &= check(response.getHeader(http::field::VARY) == "Origin, Accept-Encoding", "vary even when not compressed");
+
+	response = make_response("application/json", text.substr(0, 1000));
+	ok &= check(!http::CompressResponse(response, http::coding::GZIP, 6, 1024) &&
+				!response.hasHeader(http::field::VARY), "below min_bytes");
+	response = make_response("image/png", text);
+	ok &= check(!http::CompressResponse(response, http::coding::GZIP, 6, 1024), "type");
+	response = make_response("text/plain", text);
+	response.setHeader(http::field::CONTENT_ENCODING, "br");
+	ok &= check(!http::CompressResponse(response, http::coding::GZIP, 6, 1024), "already encoded");
+	response = make_response("text/plain", text);
+	response.setState(http::state::PARTIAL_CONTENT);
+	ok &= check(!http::CompressResponse(response, http::coding::GZIP, 6, 1024), "206");
+	response = make_response("text/plain", text);
+	ok &= check(!http::CompressResponse(response, http::coding::GZIP, 0, 1024), "level 0");
+
+	// random bytes grow : kept as they are
+	std::string noise(4096, '\0');
+	uint32_t x = 12345;
+	for ( char& c : noise ) {
+		x = x * 1103515245 + 12345;
+		c = (char)(x >> 16);
+	}
+	response = make_response("text/plain", noise);
+	ok &= check(!http::CompressResponse(response, http::coding::GZIP, 6, 1024) && response.body() == noise,
+				"incompressible kept");
+	return ok;
+}
+
+static std::string get(const std::string& uri, const std::string& accept) {
+	std::string request = "GET " + uri + " HTTP/1.1\r\nHost: test\r\n";
+	if ( !accept.empty() ) {
+		request += "Accept-Encoding: " + accept + "\r\n";
+	}
+	return request + "\r\n";
+}
+
+bool test_server(uint16_t port, const std::string& text) {
+	bool ok = true;
+	int fd = connect_to(port);
+	http::Response response;
+	std::string body;
+
+	ok &= check(exchange(fd, get("/text", "gzip, deflate"), response), "gzip exchange");
+	ok &= check(response.getHeader(http::field::CONTENT_ENCODING) == "gzip" &&
+				response.body().size() < text.size() &&
+				http::Decompress(http::coding::GZIP, response.body(), body) && body == text, "gzip body");
+	ok &= check(response.getHeader(http::field::CONTENT_LENGTH) == std::to_string(response.body().size()),
+				"length of the coded body");
+
+	ok &= check(exchange(fd, get("/text", "deflate"), response) &&
+				response.getHeader(http::field::CONTENT_ENCODING) == "deflate" &&
+				http::Decompress(http::coding::DEFLATE, response.body(), body = "") && body == text, "deflate body");
+
+	ok &= check(exchange(fd, get("/text", ""), response) && response.body() == text &&
+				!response.hasHeader(http::field::CONTENT_ENCODING) &&
+				response.getHeader(http::field::VARY) == "Accept-Encoding", "identity body");
+
+	ok &= check(exchange(fd, get("/small", "gzip"), response) && response.body() == "tiny" &&
+				!response.hasHeader(http::field::CONTENT_ENCODING), "below the threshold");
+
+	// per route : turned off, or a level of its own
+	ok &= check(exchange(fd, get("/off", "gzip"), response) && response.body() == text, "route turned off");
+	ok &= check(exchange(fd, get("/fast", "gzip"), response) &&
+				response.getHeader(http::field::CONTENT_ENCODING) == "gzip", "route level");
+
+	// streamed : chunked, each write flushed
+	ok &= check(exchange(fd, get("/stream", "gzip"), response), "stream exchange");
+	ok &= check(response.getHeader(http::field::TRANSFER_ENCODING) == "chunked" &&
+				response.getHeader(http::field::CONTENT_ENCODING) == "gzip" &&
+				http::Decompress(http::coding::GZIP, response.body(), body = "") && body == text + text,
+				"streamed gzip body");
+	ok &= check(exchange(fd, get("/stream", ""), response) && response.body() == text + text &&
+				!response.hasHeader(http::field::CONTENT_ENCODING), "streamed identity body");
+
+	// cached per coding
+	ok &= check(exchange(fd, get("/cached", "gzip"), response) &&
+				response.getHeader(http::field::CONTENT_ENCODING) == "gzip", "cached gzip");
+	http::Response again;
+	ok &= check(exchange(fd, get("/cached", "gzip"), again) && again.body() == response.body(), "gzip hit");
+	ok &= check(exchange(fd, get("/cached", ""), again) && again.body() == text, "identity is its own entry");
+	::close(fd);
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_negotiate();
+	ok &= test_round_trip();
+	ok &= test_streaming();
+	ok &= test_compress_response();
+
+	std::string text = make_text(8192);
+	asio::IOContext ioc;
+	http::Server server(ioc, 1);
+	server.setCompression(6);
+	server.setCache(1024 * 1024);
+	server.setHandler([&text](const http::RequestView& request, http::Response& response){
+		StringView path = request.uri();
+		response.setHeader(http::field::CONTENT_TYPE, "application/json");
+		if ( path == "/small" ) {
+			response.setBody("tiny");
+			return;
+		}
+		if ( path == "/off" ) {
+			response.setCompression(http::Response::COMPRESSION_OFF);
+		} else if ( path == "/fast" ) {
+			response.setCompression(1);
+		} else if ( path == "/cached" ) {
+			response.setHeader(http::field::CACHE_CONTROL, "max-age=60");
+		}
+		response.setBody(text);
+	});
+	server.setStreamHandler([&text](const http::RequestView& request, const http::Server::stream_ptr& stream){
+		if ( request.uri() != "/stream" ) {
+			return false;
+		}
+		stream->response().setHeader(http::field::CONTENT_TYPE, "text/plain");
+		stream->onEnd([stream, &text](){
+			stream->write(text);
+			stream->write(text);
+			stream->end();
+		});
+		return true;
+	});
+	server.start(asio::ip::Endpoint("127.0.0.1", 0));
+
+	asio::ip::Endpoint endpoint;
+	server.localAddr(endpoint);
+	std::thread client([&](){
+		ok &= test_server(endpoint.port(), text);
+		asio::post(ioc, [&ioc](){ ioc.quit(); });
+	});
+
+	ioc.loop_wait();
+	client.join();
+	server.stop();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
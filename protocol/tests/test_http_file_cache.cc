@@ -0,0 +1,176 @@
+#include "protocol/protocol.hpp"
+#include "check.h"
+
+#include <iostream>
+#include <string>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+static void write_file(const std::string& path, const std::string& data) {
+	FILE* f = ::fopen(path.c_str(), "wb");
+	::fwrite(data.data(), 1, data.size(), f);
+	::fclose(f);
+}
+
+// the test directories are flat
+static void remove_dir(const std::string& dir) {
+	DIR* d = ::opendir(dir.c_str());
+	if ( d ) {
+		while ( struct dirent* entry = ::readdir(d) ) {
+			std::string name = entry->d_name;
+			if ( name != "." && name != ".." ) {
+				::unlink((dir + "/" + name).c_str());
+			}
+		}
+		::closedir(d);
+	}
+	::rmdir(dir.c_str());
+}
+
+static void set_mtime(const std::string& path, time_t mtime) {
+	struct timespec times[2];
+	times[0].tv_sec = mtime;
+	times[0].tv_nsec = 0;
+	times[1] = times[0];
+	::utimensat(AT_FDCWD, path.c_str(), times, 0);
+}
+
+bool test_open_file(const std::string& dir) {
+	bool ok = true;
+	std::string path = dir + "/a.txt";
+	write_file(path, "hello, file");
+	set_mtime(path, 784111777);
+
+	asio::errcode_type ec = 0;
+	http::open_file_ptr file = http::OpenFile::Open(path, ec);
+	ok &= check(file && !ec, "open");
+	if ( !file ) {
+		return false;
+	}
+
+	ok &= check(file->size() == 11, "size");
+	ok &= check(file->mtime() == 784111777, "mtime");
+	ok &= check(file->etag() == "\"2ebc98a1-b\"", "etag");
+	ok &= check(file->lastModified() == "Sun, 06 Nov 1994 08:49:37 GMT", "last modified");
+
+	std::string out = "x";
+	ok &= check(file->read(7, 4, out) && out == "xfile", "pread region");
+	ok &= check(!file->read(8, 10, out) && out == "xfile", "short file");
+
+	ok &= check(!http::OpenFile::Open(dir + "/missing", ec) && ec == ENOENT, "missing");
+	ok &= check(!http::OpenFile::Open(dir, ec) && ec == EISDIR, "directory");
+	return ok;
+}
+
+bool test_cache_hits(const std::string& dir) {
+	bool ok = true;
+	std::string path = dir + "/hot.txt";
+	write_file(path, "v1");
+
+	http::FileCache cache(4, 60 * 1000);
+	asio::errcode_type ec = 0;
+	http::open_file_ptr first = cache.open(path, ec);
+	http::open_file_ptr second = cache.open(path, ec);
+	ok &= check(first && first == second, "same open file");
+	ok &= check(cache.misses() == 1 && cache.hits() == 1, "second lookup is a hit");
+
+	// trusted within the revalidation period, even when the file changed
+	write_file(path, "version 2");
+	ok &= check(cache.open(path, ec) == first, "not revalidated yet");
+
+	cache.erase(path);
+	http::open_file_ptr fresh = cache.open(path, ec);
+	ok &= check(fresh && fresh->size() == 9, "reopened after erase");
+	ok &= check(first->size() == 2, "old reference still valid");
+
+	ok &= check(!cache.open(dir + "/none", ec) && ec == ENOENT, "miss not cached");
+	ok &= check(cache.size() == 1, "failures not stored");
+	return ok;
+}
+
+bool test_cache_revalidate(const std::string& dir) {
+	bool ok = true;
+	std::string path = dir + "/changing.txt";
+	write_file(path, "one");
+	set_mtime(path, 1000);
+
+	http::FileCache cache(4, 0);		// stat on every lookup
+	asio::errcode_type ec = 0;
+	http::open_file_ptr first = cache.open(path, ec);
+	ok &= check(cache.open(path, ec) == first, "unchanged file kept");
+	ok &= check(cache.hits() == 1, "stat only");
+
+	write_file(path, "three");
+	set_mtime(path, 2000);
+	http::open_file_ptr second = cache.open(path, ec);
+	ok &= check(second && second != first && second->size() == 5, "modified file reopened");
+
+	// replaced under the same name ( new inode )
+	std::string tmp = dir + "/changing.tmp";
+	write_file(tmp, "three");
+	set_mtime(tmp, 2000);
+	::rename(tmp.c_str(), path.c_str());
+	http::open_file_ptr third = cache.open(path, ec);
+	ok &= check(third && third != second, "replaced file reopened");
+
+	::unlink(path.c_str());
+	ok &= check(!cache.open(path, ec) && ec == ENOENT, "removed file");
+	ok &= check(cache.size() == 0, "removed file dropped");
+	return ok;
+}
+
+bool test_cache_lru(const std::string& dir) {
+	bool ok = true;
+	http::FileCache cache(2, 60 * 1000);
+	asio::errcode_type ec = 0;
+
+	write_file(dir + "/1", "1");
+	write_file(dir + "/2", "2");
+	write_file(dir + "/3", "3");
+
+	http::open_file_ptr one = cache.open(dir + "/1", ec);
+	cache.open(dir + "/2", ec);
+	cache.open(dir + "/1", ec);		// 2 is now the least recently used
+	cache.open(dir + "/3", ec);
+	ok &= check(cache.size() == 2, "capacity");
+
+	size_t misses = cache.misses();
+	cache.open(dir + "/1", ec);
+	ok &= check(cache.misses() == misses, "recently used kept");
+	cache.open(dir + "/2", ec);
+	ok &= check(cache.misses() == misses + 1, "least recently used evicted");
+
+	cache.clear();
+	ok &= check(cache.size() == 0 && ::fcntl(one->fd(), F_GETFD) != -1, "dropped file stays open while referenced");
+
+	http::FileCache none(0);
+	ok &= check(none.open(dir + "/1", ec) && none.size() == 0, "capacity 0 only opens");
+	return ok;
+}
+
+int main() {
+	char dir[] = "/tmp/lcy_file_cache_XXXXXX";
+	if ( !::mkdtemp(dir) ) {
+		std::cout << "mkdtemp failed" << std::endl;
+		return 1;
+	}
+
+	bool ok = true;
+	ok &= test_open_file(dir);
+	ok &= test_cache_hits(dir);
+	ok &= test_cache_revalidate(dir);
+	ok &= test_cache_lru(dir);
+
+	remove_dir(dir);
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
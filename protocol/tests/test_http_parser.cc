@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <string>
+#include <algorithm>
 
 void test_parse_http_request_line() {
     lcy::protocol::http::Parser parser;
@@ -80,9 +81,9 @@ void test_parse_http_request_line() {
         std::cout << "uri : " << request.uri() << std::endl;
         std::cout << "version : " << lcy::protocol::http::VersionToString(request.version()) << std::endl;
 
-        for (auto& kv : request.getHeadersRef()) {
-            std::cout << kv.first << "--" << kv.second << std::endl;
-        }
+        request.visitHeaders([](lcy::protocol::StringView key, const std::string& value) {
+            std::cout << key << "--" << value << std::endl;
+        });
 
         std::cout << "body : " << request.body() << std::endl;
         std::cout << "nparse : " << parser.nparse() << std::endl;
@@ -109,9 +110,353 @@ void test_parse_http_response_line() {
 	}
 }
 
+bool test_parse_http_response_reason_phrase() {
+	lcy::protocol::http::Parser parser;
+	lcy::protocol::http::Response response;
+	std::string line = "HTTP/1.1 404 Not Found\r\n"
+					   "Content-Length: 0\r\n"
+					   "\r\n";
+
+	auto retcode = parser.parse(&line[0], line.length(), response);
+	if ( retcode != lcy::protocol::http::Parser::RetCode::READY ) {
+		std::cout << "reason phrase with spaces : error" << std::endl;
+		return false;
+	}
+
+	std::cout << "state : " << (int)response.state() << std::endl;
+	return response.state() == lcy::protocol::http::state::NOT_FOUND &&
+		   parser.nparse() == line.length();
+}
+
+bool test_parse_http_request_line_validation() {
+	struct Case {
+		const char* line;
+		bool ok;
+		lcy::protocol::http::version_type version;
+	} cases[] = {
+		{ "GET /a/b?c=d%20e HTTP/1.1\r\n\r\n", true, lcy::protocol::http::version::HTTP_1_1 },
+		{ "GET / HTTP/1.0\r\n\r\n", true, lcy::protocol::http::version::HTTP_1_0 },
+		{ "GET /\xe4\xb8\xad HTTP/1.1\r\n\r\n", true, lcy::protocol::http::version::HTTP_1_1 },
+		{ "GET / HTTP/2.0\r\n\r\n", true, lcy::protocol::http::version::HTTP_1_1 },
+		{ "GET a HTTP/1.1\r\n\r\n", false, lcy::protocol::http::version::HTTP_ERR },
+		{ "GET /a\x01 HTTP/1.1\r\n\r\n", false, lcy::protocol::http::version::HTTP_ERR },
+		{ "GET / HTTP/1\r\n\r\n", false, lcy::protocol::http::version::HTTP_ERR },
+		{ "GET / HTTP/1.x\r\n\r\n", false, lcy::protocol::http::version::HTTP_ERR },
+		{ "GET / HTTP/1.1x\r\n\r\n", false, lcy::protocol::http::version::HTTP_ERR },
+		{ "GET / http/1.1\r\n\r\n", false, lcy::protocol::http::version::HTTP_ERR },
+	};
+
+	bool ok = true;
+	for ( auto& c : cases ) {
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::Request request;
+		std::string line = c.line;
+
+		auto retcode = parser.parse(&line[0], line.length(), request);
+		bool ready = retcode == lcy::protocol::http::Parser::RetCode::READY;
+		if ( ready != c.ok || (ready && request.version() != c.version) ) {
+			std::cout << "request line validation failed : " << line.substr(0, line.find('\r')) << std::endl;
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+/*
+* One byte per call, the trailer of the chunked body is cut as well.
+*/
+bool test_parse_http_trickle() {
+	lcy::protocol::http::Parser parser;
+	lcy::protocol::http::Request request;
+	std::string data = "POST /upload HTTP/1.1\r\n"
+					   "Host: 127.0.0.1\r\n"
+					   "Transfer-Encoding: chunked\r\n"
+					   "\r\n"
+					   "5\r\nhello\r\n"
+					   "0\r\n"
+					   "Checksum: 1234\r\n"
+					   "\r\n";
+
+	auto retcode = lcy::protocol::http::Parser::RetCode::WAITING_DATA;
+	size_t len = 0;
+	while ( retcode == lcy::protocol::http::Parser::RetCode::WAITING_DATA && len < data.length() ) {
+		retcode = parser.parse(&data[0], ++len, request);
+	}
+
+	bool ok = retcode == lcy::protocol::http::Parser::RetCode::READY &&
+			  len == data.length() &&
+			  parser.nparse() == data.length() &&
+			  request.getHeader("Host") == "127.0.0.1" &&
+			  request.body() == "hello";
+	if ( !ok ) {
+		std::cout << "trickle failed at " << len << std::endl;
+	}
+	return ok;
+}
+
+bool test_parse_http_limits() {
+	bool ok = true;
+
+	// too many fields
+	{
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::Request request;
+		lcy::protocol::http::RequestView view;
+		parser.setMaxHeaders(4);
+
+		std::string data = "GET / HTTP/1.1\r\nA: 1\r\nB: 2\r\nC: 3\r\nD: 4\r\nE: 5\r\n\r\n";
+		ok &= parser.parse(&data[0], data.length(), request) == lcy::protocol::http::Parser::RetCode::ERROR &&
+			  parser.errcode() == lcy::protocol::http::Parser::ErrCode::TOO_MANY_HEADERS;
+
+		parser.reset();
+		ok &= parser.maxHeaders() == 4;
+		ok &= parser.parse(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::ERROR &&
+			  parser.errcode() == lcy::protocol::http::Parser::ErrCode::TOO_MANY_HEADERS;
+	}
+
+	// an unterminated header is refused as soon as it crosses the limit
+	{
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::Request request;
+		lcy::protocol::http::RequestView view;
+		parser.setMaxHeaderBytes(256);
+
+		std::string data = "GET / HTTP/1.1\r\nCookie: " + std::string(200, 'x');
+		ok &= parser.parse(&data[0], data.length(), request) == lcy::protocol::http::Parser::RetCode::WAITING_DATA;
+		data += std::string(100, 'x');
+		ok &= parser.parse(&data[0], data.length(), request) == lcy::protocol::http::Parser::RetCode::ERROR &&
+			  parser.errcode() == lcy::protocol::http::Parser::ErrCode::HEADER_TOO_LARGE;
+
+		parser.reset();
+		ok &= parser.errcode() == lcy::protocol::http::Parser::ErrCode::NONE;
+		ok &= parser.parse(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::ERROR &&
+			  parser.errcode() == lcy::protocol::http::Parser::ErrCode::HEADER_TOO_LARGE;
+	}
+
+	if ( !ok ) {
+		std::cout << "limits failed" << std::endl;
+	}
+	return ok;
+}
+
+bool test_parse_http_body_limits() {
+	bool ok = true;
+
+	// a declared length above the limit fails before any of the body arrives
+	{
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::Request request;
+		lcy::protocol::http::RequestView view;
+		parser.setMaxBodyBytes(16);
+
+		std::string data = "POST / HTTP/1.1\r\nContent-Length: 4294967296\r\n\r\n";
+		ok &= parser.parse(&data[0], data.length(), request) == lcy::protocol::http::Parser::RetCode::ERROR &&
+			  parser.errcode() == lcy::protocol::http::Parser::ErrCode::BODY_TOO_LARGE;
+
+		parser.reset();
+		ok &= parser.parse(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::ERROR &&
+			  parser.errcode() == lcy::protocol::http::Parser::ErrCode::BODY_TOO_LARGE;
+	}
+
+	// chunked bodies are counted as they are decoded
+	{
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::RequestView view;
+		parser.setMaxBodyBytes(16);
+
+		std::string data = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+						   "a\r\n0123456789\r\n";
+		ok &= parser.parse(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::WAITING_DATA;
+		data += "a\r\n";
+		ok &= parser.parse(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::ERROR &&
+			  parser.errcode() == lcy::protocol::http::Parser::ErrCode::BODY_TOO_LARGE;
+	}
+
+	// lengths that do not fit or are not numbers
+	{
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::Request request;
+		std::string data = "POST / HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n";
+		ok &= parser.parse(&data[0], data.length(), request) == lcy::protocol::http::Parser::RetCode::ERROR &&
+			  parser.errcode() == lcy::protocol::http::Parser::ErrCode::BAD_MESSAGE;
+
+		parser.reset();
+		request.clear();
+		data = "POST / HTTP/1.1\r\nContent-Length: 12abc\r\n\r\n";
+		ok &= parser.parse(&data[0], data.length(), request) == lcy::protocol::http::Parser::RetCode::ERROR;
+	}
+
+	if ( !ok ) {
+		std::cout << "body limits failed" << std::endl;
+	}
+	return ok;
+}
+
+// chunk sizes near SIZE_MAX, without a body limit : refused, nothing wraps or throws
+bool test_parse_http_chunk_size_overflow() {
+	bool ok = true;
+	const std::string head = "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+	const std::string response_head = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n";
+
+	for ( const char* size : { "ffffffffffffffff", "fffffffffffffffe", "8000000000000000" } ) {
+		std::string chunk = std::string(size) + "\r\nX";
+
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::Request request;
+		std::string data = head + chunk;
+		ok &= parser.parse(&data[0], data.length(), request) == lcy::protocol::http::Parser::RetCode::ERROR;
+
+		parser.reset();
+		lcy::protocol::http::RequestView view;
+		ok &= parser.parse(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::ERROR;
+
+		parser.reset();
+		lcy::protocol::http::Response response;
+		data = response_head + chunk;
+		ok &= parser.parse(&data[0], data.length(), response) == lcy::protocol::http::Parser::RetCode::ERROR;
+	}
+
+	// the largest size taken only waits for its data
+	{
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::Request request;
+		std::string data = head + std::string(sizeof(size_t) * 2 - 1, 'f').insert(0, "7") + "\r\nX";
+		ok &= parser.parse(&data[0], data.length(), request) == lcy::protocol::http::Parser::RetCode::WAITING_DATA;
+	}
+
+	if ( !ok ) {
+		std::cout << "chunk size overflow failed" << std::endl;
+	}
+	return ok;
+}
+
+// Feeds `body` to parseBody() `step` bytes at a time, as a connection would
+static bool stream_body(lcy::protocol::http::Parser& parser, const std::string& body,
+						size_t step, std::string& decoded) {
+	std::string in;
+	size_t fed = 0;
+	while ( true ) {
+		lcy::protocol::StringView piece;
+		size_t nparse = 0;
+		lcy::protocol::http::Parser::RetCode retcode = parser.parseBody(in.data(), in.size(), piece, nparse);
+		if ( retcode == lcy::protocol::http::Parser::RetCode::ERROR ) {
+			return false;
+		}
+		decoded.append(piece.data(), piece.size());
+		in.erase(0, nparse);
+
+		if ( retcode == lcy::protocol::http::Parser::RetCode::READY ) {
+			return true;
+		}
+		if ( piece.empty() ) {
+			if ( fed == body.size() ) {
+				return false;
+			}
+			size_t n = std::min(step, body.size() - fed);
+			in.append(body, fed, n);
+			fed += n;
+		}
+	}
+}
+
+bool test_parse_http_stream_body() {
+	bool ok = true;
+
+	const std::string head_cl = "POST /up HTTP/1.1\r\nContent-Length: 26\r\n\r\n";
+	const std::string head_te = "POST /up HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n";
+	const std::string identity = "abcdefghijklmnopqrstuvwxyz";
+	const std::string chunked = "5\r\nabcde\r\n"
+								"14;ext=1\r\nfghijklmnopqrstuvwxy\r\n"
+								"1\r\nz\r\n"
+								"0\r\nX-Trailer: 1\r\n\r\n";
+
+	for ( size_t step = 1; step <= 64; step *= 2 ) {
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::RequestView view;
+		parser.setMaxBodyBytes(4);		// only for collected bodies
+
+		// the head alone, then the body in pieces
+		std::string data = head_cl + identity.substr(0, 3);
+		ok &= parser.parseHead(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::READY;
+		ok &= parser.nparse() == head_cl.size() && view.uri() == "/up" && view.body().empty();
+
+		std::string decoded;
+		ok &= stream_body(parser, identity, step, decoded) && decoded == identity;
+
+		parser.reset();
+		data = head_te;
+		ok &= parser.parseHead(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::READY;
+		decoded.clear();
+		ok &= stream_body(parser, chunked, step, decoded) && decoded == identity;
+		if ( !ok ) {
+			std::cout << "stream body failed at step " << step << std::endl;
+			return false;
+		}
+	}
+
+	// a declined head : parse() collects the body as usual
+	{
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::RequestView view;
+		std::string data = head_te;
+		ok &= parser.parseHead(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::READY;
+		ok &= parser.parse(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::WAITING_DATA;
+		data += chunked;
+		ok &= parser.parse(&data[0], data.length(), view) == lcy::protocol::http::Parser::RetCode::READY;
+		ok &= view.body() == identity && parser.nparse() == data.size();
+	}
+
+	// a broken chunk
+	{
+		lcy::protocol::http::Parser parser;
+		lcy::protocol::http::RequestView view;
+		std::string data = head_te;
+		parser.parseHead(&data[0], data.length(), view);
+
+		std::string body = "3\r\nabcX\r\n";
+		lcy::protocol::StringView piece;
+		size_t nparse = 0;
+		ok &= parser.parseBody(body.data(), body.size(), piece, nparse) == lcy::protocol::http::Parser::RetCode::WAITING_DATA;
+		ok &= piece == "abc";
+		ok &= parser.parseBody(body.data() + nparse, body.size() - nparse, piece, nparse) == lcy::protocol::http::Parser::RetCode::ERROR;
+	}
+
+	if ( !ok ) {
+		std::cout << "stream body failed" << std::endl;
+	}
+	return ok;
+}
+
+// clients that lower case their fields still get their body read
+bool test_parse_http_lowercase_fields() {
+	lcy::protocol::http::Parser parser;
+	lcy::protocol::http::Request request;
+	std::string data = "POST /a HTTP/1.1\r\n"
+					   "host: 127.0.0.1\r\n"
+					   "content-length: 4\r\n"
+					   "\r\n"
+					   "ping";
+
+	bool ok = parser.parse(&data[0], data.length(), request) == lcy::protocol::http::Parser::RetCode::READY &&
+			  request.body() == "ping" &&
+			  request.getHeader(lcy::protocol::http::field::HOST) == "127.0.0.1";
+	if ( !ok ) {
+		std::cout << "lowercase fields failed" << std::endl;
+	}
+	return ok;
+}
+
 int main() {
 	 test_parse_http_request_line();
 	// test_parse_http_response_line();
 
-	return 0;
+	bool ok = test_parse_http_response_reason_phrase();
+	ok &= test_parse_http_request_line_validation();
+	ok &= test_parse_http_trickle();
+	ok &= test_parse_http_limits();
+	ok &= test_parse_http_lowercase_fields();
+	ok &= test_parse_http_body_limits();
+	ok &= test_parse_http_chunk_size_overflow();
+	ok &= test_parse_http_stream_body();
+	return ok ? 0 : 1;
 }
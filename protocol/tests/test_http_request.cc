@@ -1,5 +1,66 @@
 #include "protocol/protocol.hpp"
 #include <iostream>
+#include <cctype>
+
+using namespace lcy::protocol;
+
+static bool test_method_lookup() {
+	bool ok = true;
+
+#define XX(_code, _method, _desc)													\
+	ok &= http::StringToMethod(#_desc) == http::method::_method;					\
+	ok &= http::MethodToString(http::method::_method) == #_desc;
+	HTTP_METHOD_MAP(XX)
+#undef XX
+
+	const char* invalid[] = { "", "get", "GETS", "GE", "MSEARCH", "UNLINKED", "X" };
+	for ( const char* m : invalid ) {
+		ok &= http::StringToMethod(m) == http::method::INVALID;
+	}
+
+	if ( !ok ) {
+		std::cout << "method lookup failed" << std::endl;
+	}
+	return ok;
+}
+
+static bool test_field_lookup() {
+	bool ok = true;
+
+	for ( size_t i = 0; i < http::FIELD_COUNT; ++i ) {
+		http::field_type f = (http::field_type)i;
+		std::string name = http::FieldToString(f);
+		std::string lower = name, upper = name;
+		for ( auto& c : lower ) c = (char)::tolower(c);
+		for ( auto& c : upper ) c = (char)::toupper(c);
+
+		ok &= http::StringToField(name) == f;
+		ok &= http::StringToField(lower) == f;
+		ok &= http::StringToField(upper) == f;
+	}
+
+	const char* unknown[] = { "", "X-Request-Id", "Content-Lengt", "Hosts", "Content_Length", "-" };
+	for ( const char* name : unknown ) {
+		ok &= http::StringToField(name) == http::field::UNKNOWN;
+	}
+
+	// slots are shared by every spelling of a well known field
+	http::Request request;
+	request.setHeader("content-length", "12");
+	request.setHeader("X-Trace", "abc");
+	ok &= request.getHeader(http::field::CONTENT_LENGTH) == "12";
+	ok &= request.getHeader("Content-Length") == "12";
+	ok &= request.getHeadersRef().size() == 1;
+
+	request.removeHeader("CONTENT-LENGTH");
+	ok &= !request.hasHeader(http::field::CONTENT_LENGTH);
+	ok &= request.getHeader("X-Trace") == "abc";
+
+	if ( !ok ) {
+		std::cout << "field lookup failed" << std::endl;
+	}
+	return ok;
+}
 
 int main() {
 
@@ -14,5 +75,9 @@ int main() {
 
 	std::cout << request.dump() << std::endl;
 
-	return 0;
+	bool ok = test_method_lookup();
+	ok &= test_field_lookup();
+	ok &= request.dump().find("User-Agent: MyHttpClient/1.0\r\n") != std::string::npos;
+
+	return ok ? 0 : 1;
 }
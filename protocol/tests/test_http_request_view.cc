@@ -0,0 +1,161 @@
+#include "protocol/protocol.hpp"
+#include "check.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace lcy::protocol;
+
+bool test_view_fields() {
+	http::Parser parser;
+	http::RequestView view;
+
+	std::string data = "POST /api/login?next=%2F HTTP/1.1\r\n"
+					   "Host: 127.0.0.1:8080\r\n"
+					   "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+					   "content-length:  5 \r\n"
+					   "\r\n"
+					   "hello";
+
+	if ( !check(parser.parse(&data[0], data.length(), view) == http::Parser::RetCode::READY, "ready") ) {
+		return false;
+	}
+
+	std::cout << "method : " << http::MethodToString(view.method()) << std::endl;
+	std::cout << "uri : " << view.uri() << std::endl;
+	for ( size_t i = 0; i < view.headerCount(); ++i ) {
+		std::cout << view.header(i).first << "--" << view.header(i).second << std::endl;
+	}
+	std::cout << "body : " << view.body() << std::endl;
+
+	bool ok = true;
+	ok &= check(view.method() == http::method::POST, "method");
+	ok &= check(view.uri() == "/api/login?next=%2F", "uri");
+	ok &= check(view.version() == http::version::HTTP_1_1, "version");
+	ok &= check(view.headerCount() == 3, "header count");
+	ok &= check(view.getHeader("HOST") == "127.0.0.1:8080", "case insensitive lookup");
+	ok &= check(view.getHeader("User-Agent") == "Mozilla/5.0 (X11; Linux x86_64)", "inner spaces kept");
+	ok &= check(view.getHeader("Accept", "*/*") == "*/*", "default");
+	ok &= check(view.body() == "hello", "body");
+	ok &= check(parser.nparse() == data.length(), "nparse");
+
+	// zero copy : every slice points into the receive buffer
+	ok &= check(view.uri().data() >= data.data() &&
+				view.uri().data() < data.data() + data.length(), "uri in buffer");
+	ok &= check(view.body().data() == data.data() + data.length() - 5, "body in buffer");
+
+	// owning copy on demand
+	http::Request request = view.toRequest();
+	ok &= check(request.uri() == "/api/login?next=%2F", "toRequest uri");
+	ok &= check(request.getHeader("Host") == "127.0.0.1:8080", "toRequest header");
+	ok &= check(request.body() == "hello", "toRequest body");
+
+	return ok;
+}
+
+/*
+* Data arrives byte by byte and the receive buffer moves on every call,
+* the view must resolve against the buffer of the final call.
+*/
+bool test_view_partial_relocated() {
+	http::Parser parser;
+	http::RequestView view;
+
+	std::string data = "GET /index.html HTTP/1.0\r\n"
+					   "Connection: keep-alive\r\n"
+					   "Content-Length: 3\r\n"
+					   "\r\n"
+					   "abc";
+
+	http::Parser::RetCode retcode = http::Parser::RetCode::WAITING_DATA;
+	std::vector<char> buffer;
+	for ( size_t i = 1; i <= data.length(); ++i ) {
+		std::vector<char> moved(data.begin(), data.begin() + i);
+		buffer.swap(moved);
+
+		retcode = parser.parse(buffer.data(), buffer.size(), view);
+		if ( retcode != http::Parser::RetCode::WAITING_DATA ) {
+			break;
+		}
+	}
+
+	bool ok = true;
+	ok &= check(retcode == http::Parser::RetCode::READY, "partial ready");
+	ok &= check(view.uri() == "/index.html", "partial uri");
+	ok &= check(view.version() == http::version::HTTP_1_0, "partial version");
+	ok &= check(view.getHeader("connection") == "keep-alive", "partial header");
+	ok &= check(view.body() == "abc", "partial body");
+	return ok;
+}
+
+bool test_view_pipelined() {
+	http::Parser parser;
+	http::RequestView view;
+
+	std::string data = "GET /a HTTP/1.1\r\nHost: x\r\n\r\n"
+					   "GET /b HTTP/1.1\r\nHost: y\r\n\r\n";
+
+	size_t offset = 0;
+	std::string uris;
+	while ( offset < data.length() ) {
+		if ( parser.parse(&data[offset], data.length() - offset, view) != http::Parser::RetCode::READY ) {
+			return check(false, "pipelined ready");
+		}
+
+		uris += view.uri().toString() + view.getHeader("Host").toString();
+		offset += parser.nparse();
+		parser.reset();
+	}
+
+	return check(uris == "/ax/by", "pipelined order");
+}
+
+bool test_view_chunked() {
+	http::Parser parser;
+	http::RequestView view;
+
+	std::string data = "PUT /upload HTTP/1.1\r\n"
+					   "Transfer-Encoding: chunked\r\n"
+					   "\r\n"
+					   "5\r\nhello\r\n"
+					   "6\r\n world\r\n"
+					   "0\r\n\r\n";
+
+	bool ok = true;
+	ok &= check(parser.parse(&data[0], data.length(), view) == http::Parser::RetCode::READY, "chunked ready");
+	ok &= check(view.body() == "hello world", "chunked body");
+	ok &= check(parser.nparse() == data.length(), "chunked nparse");
+	return ok;
+}
+
+bool test_view_invalid() {
+	const char* cases[] = {
+		"GET /a\r\n\r\n",
+		"FETCH /a HTTP/1.1\r\n\r\n",
+		"GET a HTTP/1.1\r\n\r\n",
+		"GET /a HTTP/1.1\r\nNo colon\r\n\r\n",
+		"GET /a HTTP/1.1\r\nContent-Length: 1x\r\n\r\n",
+	};
+
+	bool ok = true;
+	for ( const char* c : cases ) {
+		http::Parser parser;
+		http::RequestView view;
+		std::string data(c);
+		ok &= check(parser.parse(&data[0], data.length(), view) == http::Parser::RetCode::ERROR, c);
+	}
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_view_fields();
+	ok &= test_view_partial_relocated();
+	ok &= test_view_pipelined();
+	ok &= test_view_chunked();
+	ok &= test_view_invalid();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
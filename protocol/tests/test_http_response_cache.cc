@@ -0,0 +1,298 @@
+#include "protocol/protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+#include "loopback.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+// `raw` must outlive the view
+static bool parse(const std::string& raw, http::RequestView& view) {
+	http::Parser parser;
+	view.clear();
+	return parser.parse(raw.data(), raw.size(), view) == http::Parser::RetCode::READY;
+}
+
+static http::Response make_response(const std::string& cache_control, const std::string& body) {
+	http::Response response;
+	response.setVersion(http::version::HTTP_1_1);
+	response.setState(http::state::OK);
+	if ( !cache_control.empty() ) {
+		response.setHeader(http::field::CACHE_CONTROL, cache_control);
+	}
+	response.setBody(body);
+	return response;
+}
+
+static std::string written(const http::ResponseCache::Entry& entry, time_t now, bool head_only, bool close) {
+	asio::DynamicBuffer buffer;
+	http::ResponseCache::Write(entry, "Sun, 06 Nov 1994 08:49:37 GMT", now, head_only, close, buffer);
+	return std::string(buffer.readBegin(), buffer.dataBytes());
+}
+
+bool test_key() {
+	bool ok = true;
+	http::ResponseCache cache(1024 * 1024, { http::field::ACCEPT_ENCODING });
+	http::RequestView view;
+	std::string a, b;
+
+	std::string get = "GET /a?x=1 HTTP/1.1\r\nHost: h\r\nAccept-Encoding: gzip\r\n\r\n";
+	ok &= check(parse(get, view) && cache.makeKey(view, a), "GET key");
+	std::string head = "HEAD /a?x=1 HTTP/1.1\r\nHost: h\r\nAccept-Encoding: gzip\r\n\r\n";
+	ok &= check(parse(head, view) && cache.makeKey(view, b) && a == b, "HEAD shares the GET key");
+
+	std::string other = "GET /a?x=1 HTTP/1.1\r\nHost: h\r\nAccept-Encoding: br\r\n\r\n";
+	ok &= check(parse(other, view) && cache.makeKey(view, b) && a != b, "key field in the key");
+	std::string host = "GET /a?x=1 HTTP/1.1\r\nHost: g\r\nAccept-Encoding: gzip\r\n\r\n";
+	ok &= check(parse(host, view) && cache.makeKey(view, b) && a != b, "host in the key");
+	std::string agent = "GET /a?x=1 HTTP/1.1\r\nHost: h\r\nAccept-Encoding: gzip\r\nUser-Agent: x\r\n\r\n";
+	ok &= check(parse(agent, view) && cache.makeKey(view, b) && a == b, "other fields ignored");
+
+	std::string post = "POST /a HTTP/1.1\r\nHost: h\r\nContent-Length: 0\r\n\r\n";
+	ok &= check(parse(post, view) && !cache.makeKey(view, b), "POST bypasses");
+	std::string auth = "GET /a HTTP/1.1\r\nHost: h\r\nAuthorization: Basic eA==\r\n\r\n";
+	ok &= check(parse(auth, view) && !cache.makeKey(view, b), "Authorization bypasses");
+	std::string range = "GET /a HTTP/1.1\r\nHost: h\r\nRange: bytes=0-1\r\n\r\n";
+	ok &= check(parse(range, view) && !cache.makeKey(view, b), "Range bypasses");
+	std::string reload = "GET /a HTTP/1.1\r\nHost: h\r\nCache-Control: max-age=0, no-cache\r\n\r\n";
+	ok &= check(parse(reload, view) && !cache.makeKey(view, b), "no-cache bypasses");
+	return ok;
+}
+
+bool test_lifetime() {
+	bool ok = true;
+	http::ResponseCache cache(1024 * 1024, { http::field::ACCEPT_ENCODING });
+	time_t max_age = 0, stale = 0;
+
+	ok &= check(cache.lifetime(make_response("public, max-age=10", ""), max_age, stale) &&
+				max_age == 10000 && stale == 0, "max-age");
+	ok &= check(cache.lifetime(make_response("max-age=10, s-maxage=\"20\"", ""), max_age, stale) &&
+				max_age == 20000, "s-maxage first");
+	ok &= check(cache.lifetime(make_response("max-age=1,stale-while-revalidate=30", ""), max_age, stale) &&
+				max_age == 1000 && stale == 30000, "stale-while-revalidate");
+	ok &= check(cache.lifetime(make_response("max-age=1, stale-while-revalidate=30, must-revalidate", ""), max_age, stale) &&
+				stale == 0, "must-revalidate");
+	ok &= check(cache.lifetime(make_response("max-age=0, stale-while-revalidate=5", ""), max_age, stale), "stale only");
+
+	ok &= check(!cache.lifetime(make_response("", ""), max_age, stale), "no Cache-Control");
+	ok &= check(!cache.lifetime(make_response("max-age=0", ""), max_age, stale), "max-age=0");
+	ok &= check(!cache.lifetime(make_response("max-age=x", ""), max_age, stale), "bad seconds");
+	ok &= check(!cache.lifetime(make_response("max-age=10, no-store", ""), max_age, stale), "no-store");
+	ok &= check(!cache.lifetime(make_response("private, max-age=10", ""), max_age, stale), "private");
+	ok &= check(!cache.lifetime(make_response("no-cache=\"a, b\", max-age=10", ""), max_age, stale), "no-cache with fields");
+
+	http::Response response = make_response("max-age=10", "");
+	response.setHeader(http::field::VARY, "Accept-Encoding, Host");
+	ok &= check(cache.lifetime(response, max_age, stale), "Vary on the key");
+	response.setHeader(http::field::VARY, "Accept-Encoding, Accept-Language");
+	ok &= check(!cache.lifetime(response, max_age, stale), "Vary outside the key");
+	response.setHeader(http::field::VARY, "*");
+	ok &= check(!cache.lifetime(response, max_age, stale), "Vary *");
+
+	response = make_response("max-age=10", "");
+	response.setHeader(http::field::SET_COOKIE, "a=b");
+	ok &= check(!cache.lifetime(response, max_age, stale), "Set-Cookie");
+
+	response = make_response("max-age=10", "");
+	response.setState(http::state::NOT_FOUND);
+	ok &= check(cache.lifetime(response, max_age, stale), "404");
+	response.setState(http::state::INTERNAL_SERVER_ERROR);
+	ok &= check(!cache.lifetime(response, max_age, stale), "500");
+	return ok;
+}
+
+bool test_find_store() {
+	bool ok = true;
+	http::ResponseCache cache(1024 * 1024);
+	const http::ResponseCache::Entry* entry = nullptr;
+
+	ok &= check(cache.find("k", 1000, entry) == http::ResponseCache::Lookup::MISS, "empty");
+	ok &= check(cache.store("k", make_response("max-age=10, stale-while-revalidate=5", "hello"), 1000), "store");
+	ok &= check(!cache.store("n", make_response("no-store", "x"), 1000) && cache.size() == 1, "no-store not stored");
+
+	ok &= check(cache.find("k", 10999, entry) == http::ResponseCache::Lookup::HIT, "fresh");
+	std::string expected =
+		"HTTP/1.1 200 OK\r\n"
+		"Cache-Control: max-age=10, stale-while-revalidate=5\r\n"
+		"Content-Length: 5\r\n"
+		"Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+		"Age: 9\r\n"
+		"\r\n"
+		"hello";
+	ok &= check(written(*entry, 10999, false, false) == expected, "written with Date and Age");
+	ok &= check(written(*entry, 1500, true, true) ==
+				"HTTP/1.1 200 OK\r\n"
+				"Cache-Control: max-age=10, stale-while-revalidate=5\r\n"
+				"Content-Length: 5\r\n"
+				"Date: Sun, 06 Nov 1994 08:49:37 GMT\r\n"
+				"Connection: close\r\n"
+				"\r\n", "head only, closing, no Age under a second");
+
+	// stale : handed to one caller for revalidation, a hit for the others
+	ok &= check(cache.find("k", 11000, entry) == http::ResponseCache::Lookup::REVALIDATE, "stale");
+	ok &= check(cache.find("k", 11001, entry) == http::ResponseCache::Lookup::HIT, "revalidation under way");
+	ok &= check(cache.store("k", make_response("max-age=10", "fresh"), 11002) && cache.size() == 1, "refreshed");
+	ok &= check(cache.find("k", 12000, entry) == http::ResponseCache::Lookup::HIT &&
+				entry->bytes->find("fresh") != std::string::npos, "refreshed entry");
+
+	ok &= check(cache.find("k", 21002, entry) == http::ResponseCache::Lookup::MISS && cache.size() == 0, "expired dropped");
+	ok &= check(cache.bytes() == 0, "bytes accounted");
+	ok &= check(cache.hits() == 4 && cache.misses() == 2, "stats");
+	return ok;
+}
+
+bool test_lru() {
+	bool ok = true;
+	http::ResponseCache cache(8 * 1024);		// 1 KiB per entry at most
+	const http::ResponseCache::Entry* entry = nullptr;
+	std::string body(400, 'x');
+
+	ok &= check(!cache.store("big", make_response("max-age=10", std::string(2000, 'x')), 0), "entry above max_bytes / 8");
+
+	for ( int i = 0; i < 40; ++i ) {
+		cache.store(std::to_string(i), make_response("max-age=10", body), 0);
+		cache.find("0", 0, entry);		// kept in use
+	}
+	ok &= check(cache.bytes() <= cache.maxBytes(), "bounded by bytes");
+	ok &= check(cache.size() > 10 && cache.size() < 40, "some evicted");
+	ok &= check(cache.find("0", 0, entry) == http::ResponseCache::Lookup::HIT, "recently used kept");
+	ok &= check(cache.find("1", 0, entry) == http::ResponseCache::Lookup::MISS, "least recently used evicted");
+	ok &= check(cache.find("39", 0, entry) == http::ResponseCache::Lookup::HIT, "newest kept");
+
+	size_t bytes = cache.bytes();
+	cache.store("39", make_response("max-age=10", "short"), 0);
+	ok &= check(cache.bytes() < bytes && cache.size() <= 40, "replaced in place");
+	cache.erase("39");
+	cache.clear();
+	ok &= check(cache.size() == 0 && cache.bytes() == 0, "clear");
+	return ok;
+}
+
+// The response to a HEAD request : the parser would wait for its body
+static bool exchange_head(int fd, const std::string& request, std::string& head) {
+	if ( ::send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size() ) {
+		return false;
+	}
+
+	head.clear();
+	char buf[4096];
+	while ( head.find("\r\n\r\n") == std::string::npos ) {
+		ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+		if ( n <= 0 ) {
+			return false;
+		}
+		head.append(buf, n);
+	}
+	return head.find("\r\n\r\n") + 4 == head.size();
+}
+
+static std::string get(const std::string& uri, const std::string& extra = "") {
+	return "GET " + uri + " HTTP/1.1\r\nHost: test\r\n" + extra + "\r\n";
+}
+
+bool test_server(uint16_t port, std::atomic<int>& calls) {
+	bool ok = true;
+	int fd = connect_to(port);
+	http::Response r1, r2;
+
+	ok &= check(exchange(fd, get("/cached"), r1) && exchange(fd, get("/cached"), r2), "cached exchanges");
+	ok &= check(r1.body() == "cached 1" && r2.body() == "cached 1", "second from the cache");
+	ok &= check(r2.hasHeader(http::field::DATE) && r2.getHeader(http::field::CONTENT_LENGTH) == "8", "head of a hit");
+
+	ok &= check(exchange(fd, get("/cached?x"), r1) && r1.body() == "cached 2", "query in the key");
+
+	ok &= check(exchange(fd, get("/nostore"), r1) && exchange(fd, get("/nostore"), r2) &&
+				r1.body() != r2.body(), "no-store");
+
+	ok &= check(exchange(fd, get("/vary", "Accept-Encoding: gzip\r\n"), r1) &&
+				exchange(fd, get("/vary", "Accept-Encoding: br\r\n"), r2) &&
+				r1.body() != r2.body(), "key field selects the entry");
+	ok &= check(exchange(fd, get("/vary", "Accept-Encoding: gzip\r\n"), r2) &&
+				r1.body() == r2.body(), "same key field hits");
+
+	// HTTP/1.0 and POST go to the handler
+	int before = calls.load();
+	ok &= check(exchange(fd, "GET /cached HTTP/1.0\r\nConnection: keep-alive\r\n\r\n", r1), "HTTP/1.0 exchange");
+	ok &= check(exchange(fd, "POST /cached HTTP/1.1\r\nHost: test\r\nContent-Length: 0\r\n\r\n", r1), "POST exchange");
+	ok &= check(calls.load() == before + 2, "not answered from the cache");
+
+	// stale-while-revalidate : the stale body goes out, the next request sees the refresh
+	ok &= check(exchange(fd, get("/stale"), r1) && exchange(fd, get("/stale"), r2), "stale exchanges");
+	ok &= check(r2.body() == r1.body(), "stale served");
+	http::Response r3;
+	ok &= check(exchange(fd, get("/stale"), r3) && r3.body() != r2.body(), "refreshed after the stale hit");
+
+	// HEAD from a GET entry
+	std::string head;
+	ok &= check(exchange_head(fd, "HEAD /cached HTTP/1.1\r\nHost: test\r\n\r\n", head) &&
+				head.find("Content-Length: 8\r\n") != std::string::npos, "HEAD hit");
+	ok &= check(exchange(fd, get("/cached"), r2) && r2.body() == "cached 1", "no body after the HEAD hit");
+
+	// Connection: close on a hit
+	ok &= check(exchange(fd, get("/cached", "Connection: close\r\n"), r1) &&
+				r1.getHeader(http::field::CONNECTION) == "close" && r1.body() == "cached 1", "closing hit");
+	char c;
+	ok &= check(::recv(fd, &c, 1, 0) == 0, "closed after the closing hit");
+	::close(fd);
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_key();
+	ok &= test_lifetime();
+	ok &= test_find_store();
+	ok &= test_lru();
+
+	std::atomic<int> calls(0);
+	asio::IOContext ioc;
+	http::Server server(ioc, 1);
+	server.setCache(1024 * 1024, { http::field::ACCEPT_ENCODING });
+	server.setHandler([&calls](const http::RequestView& request, http::Response& response){
+		int n = ++calls;
+		std::string path = request.uri().toString();
+		if ( path.compare(0, 7, "/cached") == 0 ) {
+			response.setHeader(http::field::CACHE_CONTROL, "max-age=60");
+			response.setBody("cached " + std::to_string(n));
+		} else if ( path == "/nostore" ) {
+			response.setHeader(http::field::CACHE_CONTROL, "no-store, max-age=60");
+			response.setBody(std::to_string(n));
+		} else if ( path == "/vary" ) {
+			response.setHeader(http::field::CACHE_CONTROL, "max-age=60");
+			response.setHeader(http::field::VARY, "Accept-Encoding");
+			response.setBody(request.getHeader(http::field::ACCEPT_ENCODING).toString() + std::to_string(n));
+		} else if ( path == "/stale" ) {
+			response.setHeader(http::field::CACHE_CONTROL, "max-age=0, stale-while-revalidate=60");
+			response.setBody(std::to_string(n));
+		} else {
+			response.setState(http::state::NOT_FOUND);
+		}
+	});
+	server.start(asio::ip::Endpoint("127.0.0.1", 0));
+
+	asio::ip::Endpoint endpoint;
+	server.localAddr(endpoint);
+	std::thread client([&](){
+		ok &= test_server(endpoint.port(), calls);
+		asio::post(ioc, [&ioc](){ ioc.quit(); });
+	});
+
+	ioc.loop_wait();
+	client.join();
+	server.stop();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
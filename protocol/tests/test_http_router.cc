@@ -0,0 +1,203 @@
+#include "protocol/protocol.hpp"
+#include "check.h"
+
+#include <iostream>
+#include <string>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+enum RouteId : size_t {
+	USERS,
+	USER,
+	USER_NEW,
+	USER_POSTS,
+	POST,
+	FILES,
+	ROOT,
+	CREATE_USER,
+};
+
+bool test_static_and_params() {
+	bool ok = true;
+
+	http::Router router;
+	router.add(http::method::INVALID, "/", ROOT);
+	router.add(http::method::INVALID, "/users", USERS);
+	router.add(http::method::INVALID, "/users/:id", USER);
+	router.add(http::method::INVALID, "/users/new", USER_NEW);
+	router.add(http::method::INVALID, "/users/:id/posts/:post", USER_POSTS);
+
+	http::RouteParams params;
+	ok &= check(router.match(http::method::GET, "/", params) == ROOT, "root");
+	ok &= check(router.match(http::method::GET, "/users", params) == USERS, "static");
+	ok &= check(params.empty(), "static has no params");
+
+	// static wins over a parameter
+	ok &= check(router.match(http::method::GET, "/users/new", params) == USER_NEW, "static first");
+	ok &= check(params.empty(), "static first no params");
+
+	std::string uri = "/users/42";
+	ok &= check(router.match(http::method::GET, uri, params) == USER, "param");
+	ok &= check(params.size() == 1 && params.get("id") == "42", "param value");
+	ok &= check(params.get("id").data() == uri.data() + 7, "value points into the uri");
+
+	// "/users/new" is static but has no "/posts" below it : back to the parameter
+	ok &= check(router.match(http::method::GET, "/users/new/posts/7", params) == USER_POSTS, "backtrack");
+	ok &= check(params.size() == 2, "backtrack params");
+	ok &= check(params.get("id") == "new" && params.get("post") == "7", "backtrack values");
+
+	// an empty segment is not a parameter, a longer path is not a prefix match
+	ok &= check(router.match(http::method::GET, "/users/", params) == http::Router::NO_ROUTE, "empty segment");
+	ok &= check(router.match(http::method::GET, "/users/1/x", params) == http::Router::NO_ROUTE, "too long");
+	ok &= check(router.match(http::method::GET, "/user", params) == http::Router::NO_ROUTE, "too short");
+	ok &= check(router.match(http::method::GET, "", params) == http::Router::NO_ROUTE, "empty uri");
+	ok &= check(params.empty(), "params cleared on miss");
+
+	return ok;
+}
+
+bool test_wildcard() {
+	bool ok = true;
+
+	http::Router router;
+	router.add(http::method::INVALID, "/files/*path", FILES);
+	router.add(http::method::INVALID, "/files/readme", ROOT);
+
+	http::RouteParams params;
+	ok &= check(router.match(http::method::GET, "/files/a/b/c.txt", params) == FILES, "wildcard");
+	ok &= check(params.get("path") == "a/b/c.txt", "wildcard value");
+	ok &= check(router.match(http::method::GET, "/files/", params) == FILES, "wildcard empty");
+	ok &= check(params.size() == 1 && params.get("path", "x").empty(), "wildcard empty value");
+	ok &= check(router.match(http::method::GET, "/files/readme", params) == ROOT, "static over wildcard");
+	ok &= check(router.match(http::method::GET, "/files/readme.md", params) == FILES, "static miss falls back");
+	ok &= check(router.match(http::method::GET, "/files", params) == http::Router::NO_ROUTE, "no slash");
+
+	return ok;
+}
+
+bool test_query() {
+	bool ok = true;
+
+	http::Router router;
+	router.add(http::method::INVALID, "/search", USERS);
+	router.add(http::method::INVALID, "/users/:id", USER);
+
+	http::RouteParams params;
+	ok &= check(router.match(http::method::GET, "/search?q=lcy&page=2", params) == USERS, "query");
+	ok &= check(router.match(http::method::GET, "/search#top", params) == USERS, "fragment");
+	ok &= check(router.match(http::method::GET, "/users/7?full=1", params) == USER, "query after param");
+	ok &= check(params.get("id") == "7", "param without query");
+	ok &= check(http::Router::Path("/a?b?c") == "/a", "path");
+
+	return ok;
+}
+
+bool test_methods() {
+	bool ok = true;
+
+	http::Router router;
+	router.add(http::method::GET, "/users", USERS);
+	router.add(http::method::POST, "/users", CREATE_USER);
+	router.add(http::method::INVALID, "/posts/:id", POST);
+	router.add(http::method::DELETE, "/posts/:id", USER);
+
+	http::RouteParams params;
+	ok &= check(router.match(http::method::GET, "/users", params) == USERS, "get");
+	ok &= check(router.match(http::method::POST, "/users", params) == CREATE_USER, "post");
+	ok &= check(router.match(http::method::PUT, "/users", params) == http::Router::NO_ROUTE, "put");
+	ok &= check(router.match(http::method::PUT, "/posts/1", params) == POST, "any method");
+	ok &= check(router.match(http::method::DELETE, "/posts/1", params) == USER, "own table first");
+
+	return ok;
+}
+
+bool test_add_remove() {
+	bool ok = true;
+
+	http::Router router;
+	ok &= check(router.add(http::method::GET, "/users/:id", USER) == USER, "new id");
+	ok &= check(router.add(http::method::GET, "/users/:id", POST) == USER, "known id");
+	ok &= check(router.add(http::method::GET, "/users/:name", POST) == http::Router::NO_ROUTE, "name conflict");
+	ok &= check(router.add(http::method::GET, "users", POST) == http::Router::NO_ROUTE, "no slash");
+	ok &= check(router.add(http::method::GET, "/a/*rest/b", POST) == http::Router::NO_ROUTE, "wildcard not last");
+	ok &= check(router.add(http::method::GET, "/a/:", POST) == http::Router::NO_ROUTE, "no name");
+	ok &= check(router.add(http::method::GET, "/a:b", POST) == POST, "colon inside a segment");
+
+	http::RouteParams params;
+	ok &= check(router.match(http::method::GET, "/a:b", params) == POST, "colon is static");
+
+	ok &= check(router.remove(http::method::POST, "/users/:id") == http::Router::NO_ROUTE, "remove other method");
+	ok &= check(router.remove(http::method::GET, "/users/:id") == USER, "remove");
+	ok &= check(router.match(http::method::GET, "/users/1", params) == http::Router::NO_ROUTE, "removed");
+	ok &= check(router.remove(http::method::GET, "/nothing") == http::Router::NO_ROUTE, "remove unknown");
+
+	return ok;
+}
+
+bool test_servlet() {
+	bool ok = true;
+
+	std::string called;
+	http::Servlet servlet;
+	servlet.setFunction("/hello", [&](const http::Request&, http::Response&){ called = "hello"; });
+	servlet.setFunction(http::method::GET, "/users/:id",
+						[&](const http::Request&, http::Response&){ called = "user"; });
+
+	http::Request request;
+	http::Response response;
+	http::RouteParams params;
+
+	const http::Servlet::function_type* func = servlet.findFunction(http::method::POST, "/hello?x=1", params);
+	ok &= check(func != nullptr, "any method function");
+	if ( func ) {
+		(*func)(request, response);
+		ok &= check(called == "hello", "hello called");
+	}
+
+	func = servlet.findFunction(http::method::GET, "/users/9", params);
+	ok &= check(func != nullptr && params.get("id") == "9", "param function");
+	if ( func ) {
+		(*func)(request, response);
+		ok &= check(called == "user", "user called");
+	}
+
+	ok &= check(servlet.findFunction(http::method::POST, "/users/9", params) == nullptr, "method miss");
+	ok &= check((bool)servlet.getFunction("/hello"), "get function");
+	const http::Servlet::function_type* hello = servlet.findFunction(http::method::GET, "/hello", params);
+
+	servlet.removeFunction("/hello");
+	ok &= check(!servlet.getFunction("/hello"), "removed function");
+	ok &= check(servlet.findFunction(http::method::GET, "/hello", params) == nullptr, "removed find");
+
+	// the removed slot is reused instead of growing the table
+	servlet.setFunction("/bye", [&](const http::Request&, http::Response&){ called = "bye"; });
+	func = servlet.findFunction(http::method::GET, "/bye", params);
+	ok &= check(func != nullptr && func == hello, "removed id reused");
+	servlet.setFunction("/hello", [&](const http::Request&, http::Response&){ called = "again"; });
+	func = servlet.findFunction(http::method::GET, "/hello", params);
+	if ( func ) {
+		(*func)(request, response);
+	}
+	ok &= check(called == "again", "added again");
+	func = servlet.findFunction(http::method::GET, "/bye", params);
+	if ( func ) {
+		(*func)(request, response);
+	}
+	ok &= check(called == "bye", "reused id kept");
+
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_static_and_params();
+	ok &= test_wildcard();
+	ok &= test_query();
+	ok &= test_methods();
+	ok &= test_add_remove();
+	ok &= test_servlet();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+#include "protocol/protocol.hpp"
+
+#include <iostream>
+#include <string>
+#include <random>
+
+using namespace lcy::protocol;
+
+static const char* RefCRLF(const char* begin, const char* end) {
+	for ( const char* p = begin; p + 1 < end; ++p ) {
+		if ( p[0] == '\r' && p[1] == '\n' ) {
+			return p;
+		}
+	}
+	return nullptr;
+}
+
+static const char* RefChar(const char* begin, const char* end, char c) {
+	for ( const char* p = begin; p < end; ++p ) {
+		if ( *p == c ) {
+			return p;
+		}
+	}
+	return nullptr;
+}
+
+/*
+* Every kernel must agree with the byte loop for every start offset and length,
+* buffers are drawn from a tiny alphabet so delimiters land on block boundaries,
+* including a '\r' as the last byte of a block or of the input.
+*/
+static bool check_level(http::scan_level_type want) {
+	http::scan_level_type level = http::SetScanLevel(want);
+	if ( level != want ) {
+		std::cout << http::ScanLevelToString(want) << " : not supported, skipped" << std::endl;
+		return true;
+	}
+
+	std::mt19937 rng(12345);
+	const char alphabet[] = { 'a', 'b', ' ', ':', '\r', '\n' };
+
+	size_t cases = 0;
+	for ( int round = 0; round < 200; ++round ) {
+		std::string buf(100, 'a');
+		int density = 1 + round % 6;
+		for ( auto& c : buf ) {
+			c = (int)(rng() % 16) < density ? alphabet[2 + rng() % 4] : alphabet[rng() % 2];
+		}
+
+		const char* base = buf.data();
+		for ( size_t start = 0; start < 40; ++start ) {
+			for ( size_t len = 0; start + len <= buf.size(); ++len ) {
+				const char* b = base + start;
+				const char* e = b + len;
+				++cases;
+
+				if ( http::FindCRLF(b, e) != RefCRLF(b, e) ) {
+					std::cout << http::ScanLevelToString(level) << " : crlf mismatch start "
+							  << start << " len " << len << std::endl;
+					return false;
+				}
+				if ( http::FindChar(b, e, ':') != RefChar(b, e, ':') ||
+					 http::FindChar(b, e, ' ') != RefChar(b, e, ' ') ) {
+					std::cout << http::ScanLevelToString(level) << " : char mismatch start "
+							  << start << " len " << len << std::endl;
+					return false;
+				}
+			}
+		}
+	}
+
+	// the parser gives the same answer on top of this level
+	http::Parser parser;
+	http::Request request;
+	std::string data = "GET /kernel/check HTTP/1.1\r\n"
+					   "Host: 127.0.0.1\r\n"
+					   "Accept-Language: en-US,en;q=0.9,zh-CN;q=0.8\r\n"
+					   "Content-Length: 4\r\n"
+					   "\r\n"
+					   "body";
+	bool ok = parser.parse(&data[0], data.length(), request) == http::Parser::RetCode::READY &&
+			  request.uri() == "/kernel/check" &&
+			  request.getHeader("Accept-Language") == "en-US,en;q=0.9,zh-CN;q=0.8" &&
+			  request.body() == "body";
+
+	std::cout << http::ScanLevelToString(level) << " : " << cases << " cases, parser "
+			  << (ok ? "ok" : "failed") << std::endl;
+	return ok;
+}
+
+int main() {
+	http::scan_level_type detected = http::ScanLevel();
+	std::cout << "detected : " << http::ScanLevelToString(detected) << std::endl;
+
+	bool ok = true;
+	ok &= check_level(http::scan_level::SCALAR);
+	ok &= check_level(http::scan_level::SSE2);
+	ok &= check_level(http::scan_level::AVX2);
+
+	http::SetScanLevel(detected);
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,188 @@
+#include "protocol/protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+
+#include <iostream>
+#include <string>
+#include <time.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+bool test_serialize_response() {
+	const char date[] = "Sun, 06 Nov 1994 08:49:37 GMT";
+
+	http::Response response;
+	response.setVersion(http::version::HTTP_1_1);
+	response.setState(http::state::OK);
+	response.setHeader(http::field::SERVER, "lcy");
+	response.setHeader("X-Request-Id", "42");
+	response.setBody("hello");
+
+	asio::DynamicBuffer buffer;
+	size_t n = http::SerializeResponse(response, buffer, date);
+	std::string wire(buffer.readBegin(), buffer.dataBytes());
+	std::cout << wire << std::endl;
+
+	bool ok = true;
+	ok &= check(n == wire.size(), "size");
+	ok &= check(wire.compare(0, 17, "HTTP/1.1 200 OK\r\n") == 0, "status line");
+
+	http::Parser parser;
+	http::Response parsed;
+	ok &= check(parser.parse(wire.data(), wire.size(), parsed) == http::Parser::RetCode::READY, "parse back");
+	ok &= check(parser.nparse() == wire.size(), "parse back length");
+	ok &= check(parsed.state() == http::state::OK, "state");
+	ok &= check(parsed.getHeader(http::field::CONTENT_LENGTH) == "5", "content length");
+	ok &= check(parsed.getHeader(http::field::DATE) == date, "date");
+	ok &= check(parsed.getHeader("X-Request-Id") == "42", "custom field");
+	ok &= check(parsed.body() == "hello", "body");
+
+	// a second message is appended behind the first
+	response.setState(http::state::NO_CONTENT);
+	response.setBody("");
+	response.setHeader(http::field::DATE, "set by handler");
+	http::SerializeResponse(response, buffer, date);
+	std::string second(buffer.readBegin() + n, buffer.dataBytes() - n);
+	ok &= check(second.find("HTTP/1.1 204 No Content\r\n") == 0, "appended");
+	ok &= check(second.find("Content-Length") == std::string::npos, "204 has no length");
+	ok &= check(second.find("Date: set by handler\r\n") != std::string::npos, "own date kept");
+
+	// head only, the body goes out from its own storage
+	http::Response chunked;
+	chunked.setState(http::state::OK);
+	chunked.setHeader(http::field::TRANSFER_ENCODING, "chunked");
+	chunked.setBody("ignored");
+	asio::DynamicBuffer head;
+	http::SerializeResponseHead(chunked, head);
+	std::string head_wire(head.readBegin(), head.dataBytes());
+	ok &= check(head_wire.find("Content-Length") == std::string::npos, "chunked has no length");
+	ok &= check(head_wire.size() >= 4 && head_wire.compare(head_wire.size() - 4, 4, "\r\n\r\n") == 0, "head ends");
+
+	return ok;
+}
+
+bool test_serialize_request() {
+	http::Request request;
+	request.setMethod(http::method::POST);
+	request.setUri("/login");
+	request.setVersion(http::version::HTTP_1_0);
+	request.setHeader(http::field::HOST, "127.0.0.1");
+	request.setBody("user=lcy");
+
+	asio::DynamicBuffer buffer;
+	http::SerializeRequest(request, buffer);
+	std::string wire(buffer.readBegin(), buffer.dataBytes());
+
+	http::Parser parser;
+	http::Request parsed;
+	bool ok = true;
+	ok &= check(wire.compare(0, 22, "POST /login HTTP/1.0\r\n") == 0, "request line");
+	ok &= check(parser.parse(wire.data(), wire.size(), parsed) == http::Parser::RetCode::READY, "request parse back");
+	ok &= check(parsed.version() == http::version::HTTP_1_0, "request version");
+	ok &= check(parsed.body() == "user=lcy", "request body");
+	return ok;
+}
+
+bool test_serialize_chunks() {
+	bool ok = true;
+
+	http::Response response;
+	response.setVersion(http::version::HTTP_1_1);
+	response.setState(http::state::OK);
+	response.setHeader(http::field::TRANSFER_ENCODING, "chunked");
+
+	asio::DynamicBuffer buffer;
+	http::SerializeStreamHead(response, buffer);
+	http::SerializeChunk("hello ", buffer);
+	ok &= check(http::SerializeChunk("", buffer) == 0, "empty chunk skipped");
+	http::SerializeChunk(std::string(300, 'x'), buffer);
+	http::SerializeLastChunk(buffer);
+	std::string wire(buffer.readBegin(), buffer.dataBytes());
+
+	ok &= check(wire.find("Content-Length") == std::string::npos, "stream head has no length");
+	ok &= check(wire.find("\r\n\r\n6\r\nhello \r\n12c\r\nxxx") != std::string::npos, "chunk framing");
+	ok &= check(wire.compare(wire.size() - 7, 7, "\r\n0\r\n\r\n") == 0, "last chunk");
+
+	http::Parser parser;
+	http::Response parsed;
+	ok &= check(parser.parse(wire.data(), wire.size(), parsed) == http::Parser::RetCode::READY, "chunks parse back");
+	ok &= check(parsed.body() == "hello " + std::string(300, 'x'), "chunked body");
+
+	// a close delimited body : no length either, even with an empty body so far
+	http::Response old;
+	old.setVersion(http::version::HTTP_1_0);
+	old.setState(http::state::OK);
+	asio::DynamicBuffer head;
+	http::SerializeStreamHead(old, head);
+	std::string head_wire(head.readBegin(), head.dataBytes());
+	ok &= check(head_wire == "HTTP/1.0 200 OK\r\n\r\n", "close delimited head");
+
+	return ok;
+}
+
+bool test_helpers() {
+	bool ok = true;
+	ok &= check(http::StatusLine(http::state::NOT_FOUND, http::version::HTTP_1_0) == "HTTP/1.0 404 Not Found\r\n", "status 1.0");
+	ok &= check(http::StatusLine(http::state::INVALID).empty(), "invalid status");
+
+	http::Response h2;
+	h2.setVersion(http::version::HTTP_2);
+	h2.setState(http::state::OK);
+	ok &= check(h2.dump() == "HTTP/2 200 OK\r\n\r\n", "dump keeps HTTP/2");
+	h2.setVersion(http::version::HTTP_1_0);
+	ok &= check(h2.dump() == "HTTP/1.0 200 OK\r\n\r\n", "dump HTTP/1.0");
+
+	char digits[20];
+	ok &= check(http::FormatDecimal(0, digits) == 1 && digits[0] == '0', "decimal 0");
+	size_t n = http::FormatDecimal(18446744073709551615ULL, digits);
+	ok &= check(std::string(digits, n) == "18446744073709551615", "decimal max");
+
+	char date[http::DateClock::DATE_LENGTH];
+	http::DateClock::format(784111777, date);
+	ok &= check(StringView(date, sizeof(date)) == "Sun, 06 Nov 1994 08:49:37 GMT", "imf fixdate");
+
+	time_t t = 0;
+	ok &= check(http::DateClock::parse(StringView(date, sizeof(date)), t) && t == 784111777, "parse imf fixdate");
+	ok &= check(!http::DateClock::parse("Sunday, 06-Nov-94 08:49:37 GMT", t), "rfc 850 refused");
+	ok &= check(!http::DateClock::parse("Sun Nov  6 08:49:37 1994", t), "asctime refused");
+	ok &= check(!http::DateClock::parse("Sun, 06 Nox 1994 08:49:37 GMT", t), "bad month");
+	ok &= check(!http::DateClock::parse("Sun, 06 Nov 1994 08:4x:37 GMT", t), "bad digit");
+	return ok;
+}
+
+// the clock ticks on its own IOContext
+bool test_date_clock() {
+	asio::IOContext ioc;
+	bool ok = true;
+	std::string first, later;
+	{
+		http::DateClock clock(ioc);
+		first = clock.date().toString();
+
+		asio::SteadyTimer stop(ioc, 1100);
+		stop.async_wait([&](asio::errcode_type, asio::SteadyTimer::timeout_type){
+			later = clock.date().toString();
+			ioc.quit();
+		});
+		ioc.loop_wait();
+	}
+
+	std::cout << "date : " << first << " -> " << later << std::endl;
+	ok &= check(first.size() == http::DateClock::DATE_LENGTH, "date length");
+	ok &= check(first.compare(first.size() - 4, 4, " GMT") == 0, "date zone");
+	ok &= check(later != first, "date refreshed");
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_helpers();
+	ok &= test_serialize_chunks();
+	ok &= test_serialize_response();
+	ok &= test_serialize_request();
+	ok &= test_date_clock();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
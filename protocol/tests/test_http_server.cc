@@ -0,0 +1,514 @@
+#include "protocol/protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+#include "loopback.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+// true when the server closes the connection ( and sends nothing more ) in time
+static bool wait_closed(int fd) {
+	char buf[256];
+	ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+	return n == 0 || (n < 0 && errno == ECONNRESET);
+}
+
+static void echo_uri(const http::RequestView& request, http::Response& response) {
+	response.setHeader(http::field::CONTENT_TYPE, "text/plain");
+	response.setBody(request.uri().toString());
+}
+
+// Reads until the peer closes, or up to `limit` bytes
+static std::string recv_all(int fd, size_t limit = (size_t)-1) {
+	std::string raw;
+	char buf[65536];
+	while ( raw.size() < limit ) {
+		ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+		if ( n <= 0 ) {
+			break;
+		}
+		raw.append(buf, n);
+	}
+	return raw;
+}
+
+static uint16_t port_of(http::Server& server) {
+	asio::ip::Endpoint endpoint;
+	server.localAddr(endpoint);
+	return endpoint.port();
+}
+
+///////////////////////////////////////////////////////////////
+
+bool test_pipelining(uint16_t port) {
+	bool ok = true;
+	int fd = connect_to(port);
+
+	// three requests in one segment, answered in order
+	send_all(fd, "GET /a HTTP/1.1\r\nHost: x\r\n\r\n"
+				 "GET /b HTTP/1.1\r\nHost: x\r\n\r\n"
+				 "POST /c HTTP/1.1\r\nHost: x\r\nContent-Length: 3\r\n\r\nabc");
+	std::vector<http::Response> responses = recv_responses(fd, 3);
+	ok &= check(responses.size() == 3, "three responses");
+	if ( responses.size() == 3 ) {
+		ok &= check(responses[0].body() == "/a", "first in order");
+		ok &= check(responses[1].body() == "/b", "second in order");
+		ok &= check(responses[2].body() == "/c", "third in order");
+		ok &= check(responses[0].getHeader(http::field::DATE).size() == http::DateClock::DATE_LENGTH, "date");
+		ok &= check(!responses[0].hasHeader(http::field::CONNECTION), "persistent by default");
+	}
+
+	// a request split over several segments
+	send_all(fd, "GET /sp");
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	send_all(fd, "lit HTTP/1.1\r\nHo");
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	send_all(fd, "st: x\r\n\r\n");
+	responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].body() == "/split", "split request");
+
+	// HEAD : length of the body, no body, the next response follows the blank line
+	send_all(fd, "HEAD /head HTTP/1.1\r\nHost: x\r\n\r\nGET /after HTTP/1.1\r\nHost: x\r\n\r\n");
+	std::string raw;
+	char buf[4096];
+	while ( raw.find("/after") == std::string::npos ) {
+		ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+		if ( n <= 0 ) {
+			break;
+		}
+		raw.append(buf, n);
+	}
+	ok &= check(raw.find("Content-Length: 5\r\n") != std::string::npos, "head length");
+	ok &= check(raw.find("\r\n\r\nHTTP/1.1 200 OK\r\n") != std::string::npos, "head has no body");
+
+	::close(fd);
+	return ok;
+}
+
+bool test_connection_close(uint16_t port) {
+	bool ok = true;
+
+	// HTTP/1.1 asking to close
+	int fd = connect_to(port);
+	send_all(fd, "GET /bye HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n"
+				 "GET /ignored HTTP/1.1\r\nHost: x\r\n\r\n");
+	std::vector<http::Response> responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].body() == "/bye", "close answered");
+	ok &= check(responses.size() == 1 && responses[0].getHeader(http::field::CONNECTION) == "close", "close echoed");
+	ok &= check(wait_closed(fd), "closed after close");
+	::close(fd);
+
+	// HTTP/1.0 is closed unless it asks for keep-alive
+	fd = connect_to(port);
+	send_all(fd, "GET /old HTTP/1.0\r\n\r\n");
+	responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].version() == http::version::HTTP_1_0, "1.0 answered");
+	ok &= check(wait_closed(fd), "1.0 closed");
+	::close(fd);
+
+	fd = connect_to(port);
+	send_all(fd, "GET /one HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n");
+	responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].getHeader(http::field::CONNECTION) == "keep-alive", "1.0 keep-alive");
+	send_all(fd, "GET /two HTTP/1.0\r\nConnection: keep-alive\r\n\r\n");
+	responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].body() == "/two", "1.0 reused");
+	::close(fd);
+
+	return ok;
+}
+
+bool test_bad_requests(uint16_t port) {
+	bool ok = true;
+
+	// the good request before the bad one is still answered
+	int fd = connect_to(port);
+	send_all(fd, "GET /ok HTTP/1.1\r\nHost: x\r\n\r\nGET / HTTP/1.1\r\nno colon\r\n\r\n");
+	std::vector<http::Response> responses = recv_responses(fd, 2);
+	ok &= check(responses.size() == 2, "ok + bad");
+	if ( responses.size() == 2 ) {
+		ok &= check(responses[0].state() == http::state::OK, "ok first");
+		ok &= check(responses[1].state() == http::state::BAD_REQUEST, "400");
+	}
+	ok &= check(wait_closed(fd), "closed after 400");
+	::close(fd);
+
+	fd = connect_to(port);
+	send_all(fd, "GET / HTTP/1.1\r\nX-Big: " + std::string(2048, 'a') + "\r\n\r\n");
+	responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].state() == http::state::REQUEST_HEADER_FIELDS_TOO_LARGE, "431");
+	ok &= check(wait_closed(fd), "closed after 431");
+	::close(fd);
+
+	return ok;
+}
+
+bool test_idle_timeout(uint16_t port) {
+	bool ok = true;
+	int fd = connect_to(port);
+
+	send_all(fd, "GET /x HTTP/1.1\r\nHost: x\r\n\r\n");
+	ok &= check(recv_responses(fd, 1).size() == 1, "served before idle");
+
+	auto start = std::chrono::steady_clock::now();
+	ok &= check(wait_closed(fd), "idle connection closed");
+	auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	std::cout << "idle close after " << waited << " ms" << std::endl;
+	ok &= check(waited >= 100 && waited < 1500, "idle timeout");
+
+	::close(fd);
+	return ok;
+}
+
+// idle timeout is long, only the header timeout can close it
+bool test_header_timeout(uint16_t port) {
+	bool ok = true;
+	int fd = connect_to(port);
+
+	send_all(fd, "GET /slow HTTP/1.1\r\n");
+	auto start = std::chrono::steady_clock::now();
+	for ( int i = 0; i < 4; ++i ) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		send_all(fd, "X-Drip: 1\r\n");		// progress does not extend the header timeout
+	}
+	ok &= check(wait_closed(fd), "slow head closed");
+	auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - start).count();
+	std::cout << "header close after " << waited << " ms" << std::endl;
+	ok &= check(waited >= 150 && waited < 1500, "header timeout");
+
+	::close(fd);
+	return ok;
+}
+
+bool test_connection_limit(http::Server& server, uint16_t port) {
+	bool ok = true;
+
+	int first = connect_to(port);
+	send_all(first, "GET /1 HTTP/1.1\r\nHost: x\r\n\r\n");
+	ok &= check(recv_responses(first, 1).size() == 1, "first served");
+
+	int second = connect_to(port);
+	ok &= check(wait_closed(second), "over the limit closed");
+	::close(second);
+
+	::close(first);
+	for ( int i = 0; i < 100 && server.connections() != 0; ++i ) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	ok &= check(server.connections() == 0, "count released");
+
+	int third = connect_to(port);
+	send_all(third, "GET /3 HTTP/1.1\r\nHost: x\r\n\r\n");
+	ok &= check(recv_responses(third, 1).size() == 1, "served again");
+	::close(third);
+
+	return ok;
+}
+
+///////////////////////////////////////////////////////////////
+
+/*
+* Stream handler of the tests :
+*	PUT /upload		counts the body, pausing after every piece for a while
+*	GET /download	DOWNLOAD_BYTES in 64 KiB writes, waiting for onDrain when told to
+*	GET /old		a body of unknown length
+*	anything else	left to the buffered handler
+*/
+enum {
+	DOWNLOAD_BYTES = 8 * 1024 * 1024,
+	PAUSE_MS = 20,
+};
+
+struct StreamStats {
+	size_t pieces = 0;
+	size_t paused_pieces = 0;		// delivered while paused, must stay 0
+	size_t drains = 0;
+};
+
+class Producer :
+	public std::enable_shared_from_this<Producer>
+{
+public:
+	Producer(const http::Server::stream_ptr& stream, StreamStats& stats) :
+		stream_(stream),
+		left_(DOWNLOAD_BYTES),
+		block_(64 * 1024, 'd'),
+		stats_(stats)
+	{
+	}
+
+	void run() {
+		while ( left_ > 0 ) {
+			size_t n = std::min(left_, block_.size());
+			left_ -= n;
+			if ( !stream_->write(StringView(block_.data(), n)) ) {
+				if ( stream_->closed() ) {
+					return;
+				}
+				auto self = shared_from_this();
+				stream_->onDrain([self](){
+					++self->stats_.drains;
+					self->run();
+				});
+				return;
+			}
+		}
+		stream_->end();
+	}
+
+private:
+	http::Server::stream_ptr stream_;
+	size_t left_;
+	std::string block_;
+	StreamStats& stats_;
+};
+
+static bool stream_handler(const http::RequestView& request, const http::Server::stream_ptr& stream,
+						   StreamStats& stats) {
+	if ( request.uri() == "/upload" ) {
+		auto received = std::make_shared<size_t>(0);
+		auto paused = std::make_shared<bool>(false);
+		auto timer = std::make_shared<asio::SteadyTimer>(stream->context(), PAUSE_MS);
+
+		stream->onData([&stats, stream, received, paused, timer](StringView piece){
+			++stats.pieces;
+			if ( *paused ) {
+				++stats.paused_pieces;
+			}
+			*received += piece.size();
+
+			// every 64th piece waits a little, the client has to hold its data meanwhile
+			if ( stats.pieces % 64 == 0 ) {
+				*paused = true;
+				stream->pause();
+				timer->async_wait([stream, paused](asio::errcode_type, asio::SteadyTimer::timeout_type){
+					*paused = false;
+					stream->resume();
+				});
+			}
+		});
+		stream->onEnd([stream, received](){
+			stream->response().setHeader(http::field::CONTENT_TYPE, "text/plain");
+			stream->write(std::to_string(*received));
+			stream->end();
+		});
+		return true;
+	}
+
+	if ( request.uri() == "/download" ) {
+		std::make_shared<Producer>(stream, stats)->run();
+		return true;
+	}
+
+	if ( request.uri() == "/old" ) {
+		stream->write("first ");
+		stream->write("second");
+		stream->end();
+		return true;
+	}
+
+	return false;
+}
+
+bool test_stream_upload(uint16_t port, StreamStats& stats) {
+	bool ok = true;
+	int fd = connect_to(port);
+
+	// a chunked upload of 4 MiB, sent from its own thread : the server pauses on it
+	std::string chunk(8192, 'u');
+	std::string body;
+	for ( int i = 0; i < 512; ++i ) {
+		body += "2000\r\n" + chunk + "\r\n";
+	}
+	body += "0\r\n\r\n";
+
+	send_all(fd, "PUT /upload HTTP/1.1\r\nHost: x\r\nTransfer-Encoding: chunked\r\n\r\n");
+	std::thread sender([fd, &body](){ send_all(fd, body); });
+	std::vector<http::Response> responses = recv_responses(fd, 1);
+	sender.join();
+
+	ok &= check(responses.size() == 1 && responses[0].body() == std::to_string(512 * 8192), "upload counted");
+	ok &= check(stats.pieces > 64, "upload in pieces");
+	ok &= check(stats.paused_pieces == 0, "nothing while paused");
+	std::cout << "upload pieces " << stats.pieces << std::endl;
+
+	// the connection goes on with a buffered request
+	send_all(fd, "GET /next HTTP/1.1\r\nHost: x\r\n\r\n");
+	responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].body() == "/next", "after upload");
+
+	::close(fd);
+	return ok;
+}
+
+bool test_stream_download(uint16_t port, StreamStats& stats) {
+	bool ok = true;
+	int fd = connect_to(port);
+	int small = 64 * 1024;
+	::setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+
+	// pipelined : the buffered request waits for the end of the stream
+	send_all(fd, "GET /download HTTP/1.1\r\nHost: x\r\n\r\nGET /after HTTP/1.1\r\nHost: x\r\n\r\n");
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));		// a slow reader
+
+	std::vector<http::Response> responses = recv_responses(fd, 2);
+	ok &= check(responses.size() == 2, "download + after");
+	if ( responses.size() == 2 ) {
+		ok &= check(responses[0].getHeader(http::field::TRANSFER_ENCODING) == "chunked", "download chunked");
+		ok &= check(responses[0].body().size() == DOWNLOAD_BYTES, "download size");
+		ok &= check(responses[1].body() == "/after", "after download");
+	}
+	ok &= check(stats.drains > 0, "producer waited for the socket");
+	std::cout << "download drains " << stats.drains << std::endl;
+
+	::close(fd);
+	return ok;
+}
+
+bool test_stream_misc(uint16_t port) {
+	bool ok = true;
+
+	// HTTP/1.0 without a length : the body ends with the connection
+	int fd = connect_to(port);
+	send_all(fd, "GET /old HTTP/1.0\r\n\r\n");
+	std::string raw = recv_all(fd);
+	ok &= check(raw.find("Content-Length") == std::string::npos, "1.0 stream has no length");
+	ok &= check(raw.size() > 12 && raw.compare(raw.size() - 12, 12, "first second") == 0, "1.0 stream body");
+	::close(fd);
+
+	// HEAD of a streamed resource : head only
+	fd = connect_to(port);
+	send_all(fd, "HEAD /old HTTP/1.1\r\nHost: x\r\n\r\nGET /x HTTP/1.1\r\nHost: x\r\n\r\n");
+	raw.clear();
+	char buf[4096];
+	while ( raw.find("/x") == std::string::npos ) {
+		ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+		if ( n <= 0 ) {
+			break;
+		}
+		raw.append(buf, n);
+	}
+	ok &= check(raw.find("first") == std::string::npos, "stream head has no body");
+	ok &= check(raw.find("\r\n\r\nHTTP/1.1 200 OK\r\n") != std::string::npos, "stream head then next");
+	::close(fd);
+
+	return ok;
+}
+
+bool test_expect_continue(uint16_t port) {
+	bool ok = true;
+	int fd = connect_to(port);
+
+	send_all(fd, "PUT /upload HTTP/1.1\r\nHost: x\r\nContent-Length: 5\r\nExpect: 100-continue\r\n\r\n");
+	std::string interim = recv_all(fd, 25);
+	ok &= check(interim == "HTTP/1.1 100 Continue\r\n\r\n", "stream 100 continue");
+	send_all(fd, "hello");
+	std::vector<http::Response> responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].body() == "5", "stream after continue");
+
+	// a buffered request too
+	send_all(fd, "POST /buffered HTTP/1.1\r\nHost: x\r\nContent-Length: 3\r\nExpect: 100-continue\r\n\r\n");
+	interim = recv_all(fd, 25);
+	ok &= check(interim == "HTTP/1.1 100 Continue\r\n\r\n", "buffered 100 continue");
+	send_all(fd, "abc");
+	responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].body() == "/buffered", "buffered after continue");
+
+	::close(fd);
+	return ok;
+}
+
+bool test_body_limit(uint16_t port) {
+	bool ok = true;
+	int fd = connect_to(port);
+
+	// refused on its head, before the client sends a byte of the body
+	send_all(fd, "POST /big HTTP/1.1\r\nHost: x\r\nContent-Length: 4294967296\r\nExpect: 100-continue\r\n\r\n");
+	std::vector<http::Response> responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].state() == http::state::PAYLOAD_TOO_LARGE, "413");
+	ok &= check(wait_closed(fd), "closed after 413");
+	::close(fd);
+
+	return ok;
+}
+
+int main() {
+	asio::IOContext ioc;
+	asio::ip::Endpoint any("127.0.0.1", 0);
+
+	http::Server server(ioc, 1);		// connections on a pool thread
+	server.setHandler(echo_uri);
+	server.setMaxHeaderBytes(1024);
+	server.start(any);
+
+	http::Server idle(ioc, 0);
+	idle.setHandler(echo_uri);
+	idle.setIdleTimeout(200);
+	idle.start(any);
+
+	http::Server slow(ioc, 0);
+	slow.setHandler(echo_uri);
+	slow.setIdleTimeout(10000);
+	slow.setHeaderTimeout(200);
+	slow.start(any);
+
+	http::Server limited(ioc, 0);
+	limited.setHandler(echo_uri);
+	limited.setMaxConnections(1);
+	limited.start(any);
+
+	StreamStats stats;
+	http::Server streaming(ioc, 1);
+	streaming.setHandler(echo_uri);
+	streaming.setStreamHandler([&stats](const http::RequestView& request, const http::Server::stream_ptr& stream){
+		return stream_handler(request, stream, stats);
+	});
+	streaming.setMaxBodyBytes(1024);
+	streaming.start(any);
+
+	bool ok = true;
+	std::thread client([&](){
+		ok &= test_pipelining(port_of(server));
+		ok &= test_connection_close(port_of(server));
+		ok &= test_bad_requests(port_of(server));
+		ok &= test_idle_timeout(port_of(idle));
+		ok &= test_header_timeout(port_of(slow));
+		ok &= test_connection_limit(limited, port_of(limited));
+		ok &= test_stream_upload(port_of(streaming), stats);
+		ok &= test_stream_download(port_of(streaming), stats);
+		ok &= test_stream_misc(port_of(streaming));
+		ok &= test_expect_continue(port_of(streaming));
+		ok &= test_body_limit(port_of(streaming));
+
+		asio::post(ioc, [&ioc](){ ioc.quit(); });
+	});
+
+	ioc.loop_wait();
+	client.join();
+
+	server.stop();
+	idle.stop();
+	slow.stop();
+	limited.stop();
+	streaming.stop();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
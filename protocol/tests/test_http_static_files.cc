@@ -0,0 +1,355 @@
+#include "protocol/protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+#include "loopback.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+static void write_file(const std::string& path, const std::string& data) {
+	FILE* f = ::fopen(path.c_str(), "wb");
+	::fwrite(data.data(), 1, data.size(), f);
+	::fclose(f);
+}
+
+static void remove_tree(const std::string& dir) {
+	DIR* d = ::opendir(dir.c_str());
+	if ( d ) {
+		while ( struct dirent* entry = ::readdir(d) ) {
+			std::string name = entry->d_name;
+			if ( name == "." || name == ".." ) {
+				continue;
+			}
+			std::string path = dir + "/" + name;
+			if ( entry->d_type == DT_DIR ) {
+				remove_tree(path);
+			} else {
+				::unlink(path.c_str());
+			}
+		}
+		::closedir(d);
+	}
+	::rmdir(dir.c_str());
+}
+
+static http::Request make_request(http::method_type method, const std::string& uri) {
+	http::Request request;
+	request.setMethod(method);
+	request.setUri(uri);
+	request.setVersion(http::version::HTTP_1_1);
+	return request;
+}
+
+// the body a server would send
+static std::string body_of(const http::Response& response) {
+	std::string out;
+	if ( response.file() ) {
+		response.file()->read(response.fileOffset(), response.fileLength(), out);
+	}
+	return out;
+}
+
+///////////////////////////////////////////////////////////////
+
+bool test_parse_range() {
+	bool ok = true;
+	typedef http::StaticFiles::RangeResult result;
+	size_t first = 0, last = 0;
+
+	ok &= check(http::StaticFiles::ParseRange("bytes=0-9", 100, first, last) == result::OK &&
+				first == 0 && last == 9, "closed range");
+	ok &= check(http::StaticFiles::ParseRange("bytes=90-", 100, first, last) == result::OK &&
+				first == 90 && last == 99, "open range");
+	ok &= check(http::StaticFiles::ParseRange("bytes=90-500", 100, first, last) == result::OK &&
+				last == 99, "range clamped");
+	ok &= check(http::StaticFiles::ParseRange("bytes=-10", 100, first, last) == result::OK &&
+				first == 90 && last == 99, "suffix range");
+	ok &= check(http::StaticFiles::ParseRange("Bytes=-500", 100, first, last) == result::OK &&
+				first == 0, "suffix longer than the file");
+
+	ok &= check(http::StaticFiles::ParseRange("bytes=100-", 100, first, last) == result::UNSATISFIABLE, "past the end");
+	ok &= check(http::StaticFiles::ParseRange("bytes=-0", 100, first, last) == result::UNSATISFIABLE, "empty suffix");
+	ok &= check(http::StaticFiles::ParseRange("bytes=0-", 0, first, last) == result::UNSATISFIABLE, "empty file");
+
+	ok &= check(http::StaticFiles::ParseRange("bytes=9-0", 100, first, last) == result::NONE, "reversed");
+	ok &= check(http::StaticFiles::ParseRange("bytes=0-1,5-6", 100, first, last) == result::NONE, "several ranges");
+	ok &= check(http::StaticFiles::ParseRange("items=0-1", 100, first, last) == result::NONE, "other unit");
+	ok &= check(http::StaticFiles::ParseRange("bytes=a-1", 100, first, last) == result::NONE, "not a number");
+	ok &= check(http::StaticFiles::ParseRange("bytes=99999999999999999999-", 100, first, last) == result::NONE, "overflow");
+	return ok;
+}
+
+bool test_mime_type() {
+	bool ok = true;
+	ok &= check(http::StaticFiles::MimeType("/a/index.html") == "text/html; charset=utf-8", "html");
+	ok &= check(http::StaticFiles::MimeType("app.min.JS") == "text/javascript; charset=utf-8", "case insensitive");
+	ok &= check(http::StaticFiles::MimeType("/a.d/README") == "application/octet-stream", "dot in a directory");
+	ok &= check(http::StaticFiles::MimeType("/a/b.unknown") == "application/octet-stream", "unknown");
+	return ok;
+}
+
+bool test_serve(const std::string& root) {
+	bool ok = true;
+	http::StaticFiles files(root);
+	http::Servlet servlet;
+	servlet.setFunction(http::method::INVALID, "/static/" "*path", files.function("/static/"));
+
+	auto run = [&](const http::Request& request, http::Response& response){
+		http::RouteParams params;
+		response.clear();
+		response.setState(http::state::OK);
+		const http::Servlet::function_type* func = servlet.findFunction(request.method(), request.uri(), params);
+		if ( func ) {
+			(*func)(request, response);
+		}
+	};
+
+	http::Response response;
+	http::Request get = make_request(http::method::GET, "/static/hello.txt?v=1");
+	run(get, response);
+	ok &= check(response.state() == http::state::OK, "found");
+	ok &= check(body_of(response) == "hello, static", "file body");
+	ok &= check(response.body().empty(), "nothing copied into the body");
+	ok &= check(response.getHeader(http::field::CONTENT_TYPE) == "text/plain; charset=utf-8", "content type");
+	ok &= check(response.getHeader(http::field::ACCEPT_RANGES) == "bytes", "accept ranges");
+	std::string etag = response.getHeader(http::field::ETAG);
+	std::string last_modified = response.getHeader(http::field::LAST_MODIFIED);
+	ok &= check(!etag.empty() && last_modified.size() == http::DateClock::DATE_LENGTH, "validators");
+	ok &= check(response.dump().find("\r\n\r\nhello, static") != std::string::npos, "dump reads the file");
+
+	run(make_request(http::method::GET, "/static/"), response);
+	ok &= check(body_of(response) == "<h1>index</h1>", "index");
+	run(make_request(http::method::GET, "/static/sub"), response);
+	ok &= check(body_of(response) == "sub index", "directory without slash");
+	run(make_request(http::method::GET, "/static/sub/%64ata.json"), response);
+	ok &= check(body_of(response) == "{}" && response.getHeader(http::field::CONTENT_TYPE) == "application/json",
+				"percent decoded");
+
+	run(make_request(http::method::GET, "/static/missing.txt"), response);
+	ok &= check(response.state() == http::state::NOT_FOUND && !response.file(), "missing");
+	run(make_request(http::method::GET, "/static/../secret.txt"), response);
+	ok &= check(response.state() == http::state::FORBIDDEN, "dot dot");
+	run(make_request(http::method::GET, "/static/sub/%2e%2e/%2e%2e/secret.txt"), response);
+	ok &= check(response.state() == http::state::FORBIDDEN, "encoded dot dot");
+	run(make_request(http::method::GET, "/static/sub%2f..%2f..%2fsecret.txt"), response);
+	ok &= check(response.state() == http::state::BAD_REQUEST, "encoded slash");
+	run(make_request(http::method::GET, "/static/a%2"), response);
+	ok &= check(response.state() == http::state::BAD_REQUEST, "truncated escape");
+	run(make_request(http::method::POST, "/static/hello.txt"), response);
+	ok &= check(response.state() == http::state::METHOD_NOT_ALLOWED && response.getHeader("Allow") == "GET, HEAD",
+				"method not allowed");
+
+	// conditional requests
+	http::Request cond = get;
+	cond.setHeader(http::field::IF_NONE_MATCH, "\"other\", W/" + etag);
+	run(cond, response);
+	ok &= check(response.state() == http::state::NOT_MODIFIED && !response.file(), "if-none-match");
+	ok &= check(response.getHeader(http::field::ETAG) == etag, "304 keeps the etag");
+
+	cond = get;
+	cond.setHeader(http::field::IF_NONE_MATCH, "\"other\"");
+	cond.setHeader(http::field::IF_MODIFIED_SINCE, last_modified);
+	run(cond, response);
+	ok &= check(response.state() == http::state::OK, "if-none-match wins over if-modified-since");
+
+	cond = get;
+	cond.setHeader(http::field::IF_MODIFIED_SINCE, last_modified);
+	run(cond, response);
+	ok &= check(response.state() == http::state::NOT_MODIFIED, "if-modified-since");
+	cond.setHeader(http::field::IF_MODIFIED_SINCE, "Sun, 06 Nov 1994 08:49:37 GMT");
+	run(cond, response);
+	ok &= check(response.state() == http::state::OK, "modified since");
+
+	// ranges
+	http::Request ranged = get;
+	ranged.setHeader(http::field::RANGE, "bytes=7-");
+	run(ranged, response);
+	ok &= check(response.state() == http::state::PARTIAL_CONTENT && body_of(response) == "static", "range");
+	ok &= check(response.getHeader(http::field::CONTENT_RANGE) == "bytes 7-12/13", "content range");
+
+	ranged.setHeader(http::field::IF_RANGE, etag);
+	run(ranged, response);
+	ok &= check(response.state() == http::state::PARTIAL_CONTENT, "if-range matches");
+	ranged.setHeader(http::field::IF_RANGE, "\"old\"");
+	run(ranged, response);
+	ok &= check(response.state() == http::state::OK && body_of(response) == "hello, static", "if-range outdated");
+
+	ranged = get;
+	ranged.setHeader(http::field::RANGE, "bytes=13-");
+	run(ranged, response);
+	ok &= check(response.state() == http::state::RANGE_NOT_SATISFIABLE && !response.file(), "unsatisfiable");
+	ok &= check(response.getHeader(http::field::CONTENT_RANGE) == "bytes */13", "416 content range");
+
+	ranged = make_request(http::method::HEAD, "/static/hello.txt");
+	ranged.setHeader(http::field::RANGE, "bytes=0-1");
+	run(ranged, response);
+	ok &= check(response.state() == http::state::OK && response.fileLength() == 13, "range ignored for HEAD");
+
+	ok &= check(files.cache().size() >= 3 && files.cache().hits() > 0, "served from the cache");
+	return ok;
+}
+
+bool test_precompressed(const std::string& root) {
+	bool ok = true;
+	std::string css(4000, 'a');
+	write_file(root + "/site.css", css);
+	std::string gz;
+	http::Compress(http::coding::GZIP, css, 9, gz);
+	write_file(root + "/site.css.gz", gz);
+	write_file(root + "/old.txt.gz", "not gzip");
+	struct timespec times[2] = { { 1000, 0 }, { 1000, 0 } };
+	write_file(root + "/old.txt", "plain");
+	::utimensat(AT_FDCWD, (root + "/old.txt.gz").c_str(), times, 0);
+
+	http::StaticFiles files(root);
+	files.setPrecompressed(true);
+	http::Response response;
+	http::Request get = make_request(http::method::GET, "/site.css");
+	get.setHeader(http::field::ACCEPT_ENCODING, "gzip, deflate");
+
+	files.serve(get, "/site.css", response);
+	ok &= check(response.getHeader(http::field::CONTENT_ENCODING) == "gzip" && body_of(response) == gz,
+				"sidecar served");
+	ok &= check(response.getHeader(http::field::CONTENT_TYPE) == "text/css; charset=utf-8", "type of the file");
+	ok &= check(response.getHeader(http::field::VARY) == "Accept-Encoding", "vary");
+
+	std::string etag = response.getHeader(http::field::ETAG);
+	response.clear();
+	get.setHeader(http::field::ACCEPT_ENCODING, "gzip;q=0, identity");
+	files.serve(get, "/site.css", response);
+	ok &= check(!response.hasHeader(http::field::CONTENT_ENCODING) && body_of(response) == css, "gzip refused");
+	ok &= check(response.getHeader(http::field::ETAG) != etag, "etag per representation");
+	ok &= check(response.getHeader(http::field::VARY) == "Accept-Encoding", "vary on identity");
+
+	response.clear();
+	get.setHeader(http::field::ACCEPT_ENCODING, "gzip");
+	files.serve(get, "/old.txt", response);
+	ok &= check(!response.hasHeader(http::field::CONTENT_ENCODING) && body_of(response) == "plain", "stale sidecar ignored");
+
+	response.clear();
+	files.setPrecompressed(false);
+	files.serve(get, "/site.css", response);
+	ok &= check(!response.hasHeader(http::field::CONTENT_ENCODING) && !response.hasHeader(http::field::VARY), "off");
+	return ok;
+}
+
+bool test_server(uint16_t port, const std::string& big) {
+	bool ok = true;
+	int fd = connect_to(port);
+
+	// files between requests : the ones behind wait until each file is out
+	send_all(fd, "GET /hello.txt HTTP/1.1\r\nHost: x\r\n\r\n"
+				 "GET /big.bin HTTP/1.1\r\nHost: x\r\n\r\n"
+				 "GET /big.bin HTTP/1.1\r\nHost: x\r\nRange: bytes=1000-1999\r\n\r\n"
+				 "GET /missing HTTP/1.1\r\nHost: x\r\n\r\n");
+	std::vector<http::Response> responses = recv_responses(fd, 4, true);
+	ok &= check(responses.size() == 4, "four responses");
+	if ( responses.size() == 4 ) {
+		ok &= check(responses[0].body() == "hello, static", "small file");
+		ok &= check(responses[0].getHeader(http::field::CONTENT_LENGTH) == "13", "content length");
+		ok &= check(responses[1].body() == big, "big file through sendfile");
+		ok &= check(responses[2].state() == http::state::PARTIAL_CONTENT &&
+					responses[2].body() == big.substr(1000, 1000), "range through sendfile");
+		ok &= check(responses[3].state() == http::state::NOT_FOUND, "in order after the files");
+	}
+
+	// the parser of the client does not know a HEAD response has no body
+	send_all(fd, "HEAD /big.bin HTTP/1.1\r\nHost: x\r\n\r\n"
+				 "GET /hello.txt HTTP/1.1\r\nHost: x\r\n\r\n");
+	std::string raw;
+	char buf[4096];
+	while ( raw.find("hello, static") == std::string::npos ) {
+		ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+		if ( n <= 0 ) {
+			break;
+		}
+		raw.append(buf, n);
+	}
+	ok &= check(raw.find("Content-Length: " + std::to_string(big.size()) + "\r\n") != std::string::npos,
+				"HEAD length");
+	ok &= check(raw.find("\r\n\r\nHTTP/1.1 200 OK") != std::string::npos, "HEAD without a body");
+	::close(fd);
+
+	// the connection closes once the file is sent
+	fd = connect_to(port);
+	send_all(fd, "GET /big.bin HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n");
+	responses = recv_responses(fd, 1);
+	ok &= check(responses.size() == 1 && responses[0].body() == big, "file then close");
+	char c;
+	ok &= check(::recv(fd, &c, 1, 0) == 0, "closed after the file");
+	::close(fd);
+	return ok;
+}
+
+int main() {
+	char dir[] = "/tmp/lcy_static_files_XXXXXX";
+	if ( !::mkdtemp(dir) ) {
+		std::cout << "mkdtemp failed" << std::endl;
+		return 1;
+	}
+	std::string base = dir;
+	std::string root = base + "/www";
+	::mkdir(root.c_str(), 0755);
+	::mkdir((root + "/sub").c_str(), 0755);
+	write_file(base + "/secret.txt", "secret");
+	write_file(root + "/hello.txt", "hello, static");
+	write_file(root + "/index.html", "<h1>index</h1>");
+	write_file(root + "/sub/index.html", "sub index");
+	write_file(root + "/sub/data.json", "{}");
+
+	// larger than the socket buffers ( up to 4 MiB on loopback ) and several FILE_CHUNK_BYTES
+	std::string big(6 * 1024 * 1024 + 123, '\0');
+	for ( size_t i = 0; i < big.size(); ++i ) {
+		big[i] = (char)(i * 131 + (i >> 12));
+	}
+	write_file(root + "/big.bin", big);
+
+	bool ok = true;
+	ok &= test_parse_range();
+	ok &= test_mime_type();
+	ok &= test_serve(root);
+	ok &= test_precompressed(root);
+
+	asio::IOContext ioc;
+	http::StaticFiles files(root);
+	http::Server server(ioc, 1);
+	server.setHandler([&files](const http::RequestView& request, http::Response& response){
+		files.serve(request, http::Router::Path(request.uri()), response);
+	});
+	server.start(asio::ip::Endpoint("127.0.0.1", 0));
+
+	asio::ip::Endpoint endpoint;
+	server.localAddr(endpoint);
+	std::thread client([&](){
+		ok &= test_server(endpoint.port(), big);
+		asio::post(ioc, [&ioc](){ ioc.quit(); });
+	});
+
+	ioc.loop_wait();
+	client.join();
+	server.stop();
+
+	remove_tree(base);
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
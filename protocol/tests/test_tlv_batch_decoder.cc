@@ -0,0 +1,173 @@
+#include "../protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+static std::vector<std::string> make_values(size_t count) {
+	std::vector<std::string> values;
+	for ( size_t i = 0; i < count; ++i ) {
+		values.push_back(std::string(i % 7 == 0 ? 0 : i % 200, (char)('a' + i % 26)));
+	}
+	return values;
+}
+
+static std::string make_wire(const std::vector<std::string>& values) {
+	asio::DynamicBuffer buffer;
+	for ( size_t i = 0; i < values.size(); ++i ) {
+		tlv::SerializeMessage((uint16_t)i, values[i], buffer);
+	}
+	return std::string(buffer.readBegin(), buffer.dataBytes());
+}
+
+bool test_whole_buffer() {
+	bool ok = true;
+	std::vector<std::string> values = make_values(500);
+	std::string wire = make_wire(values);
+
+	std::vector<tlv::FrameDesc> frames;
+	tlv::DecodeResult result = tlv::DecodeFrames(wire.data(), wire.size(), frames);
+	ok &= check(result.frames == values.size() && frames.size() == values.size(), "every frame");
+	ok &= check(result.consumed == wire.size() && result.needed == 0, "nothing left");
+
+	bool same = true;
+	for ( size_t i = 0; i < frames.size(); ++i ) {
+		same &= frames[i].type == i && frames[i].length == values[i].size();
+		same &= tlv::FrameValue(wire.data(), frames[i]) == StringView(values[i]);
+	}
+	ok &= check(same, "descriptors");
+
+	result = tlv::DecodeFrames(wire.data(), 0, frames);
+	ok &= check(result.frames == 0 && result.consumed == 0 && result.needed == 0 && frames.empty(), "empty");
+	return ok;
+}
+
+// cut anywhere : the whole frames before the cut, and what the next one lacks
+bool test_partial() {
+	bool ok = true;
+	std::vector<std::string> values = make_values(20);
+	std::string wire = make_wire(values);
+
+	std::vector<size_t> ends;
+	size_t end = 0;
+	for ( const std::string& v : values ) {
+		end += tlv::HEAD_BYTES + v.size();
+		ends.push_back(end);
+	}
+
+	tlv::FrameDesc frames[32];
+	bool all = true;
+	for ( size_t cut = 0; cut <= wire.size(); ++cut ) {
+		tlv::DecodeResult result = tlv::DecodeFrames(wire.data(), cut, frames, 32);
+		size_t whole = 0;
+		while ( whole < ends.size() && ends[whole] <= cut ) {
+			++whole;
+		}
+		size_t consumed = whole == 0 ? 0 : ends[whole - 1];
+		size_t left = cut - consumed;
+		size_t needed = 0;
+		if ( left > 0 ) {
+			needed = left < tlv::HEAD_BYTES ? tlv::HEAD_BYTES - left : ends[whole] - cut;
+		}
+		all &= result.frames == whole && result.consumed == consumed && result.needed == needed;
+	}
+	ok &= check(all, "every cut");
+
+	// fed in pieces, the tail kept for the next round
+	asio::DynamicBuffer in;
+	size_t got = 0;
+	for ( size_t at = 0; at < wire.size(); at += 97 ) {
+		size_t n = wire.size() - at < 97 ? wire.size() - at : 97;
+		in.reserve(n);
+		::memcpy(in.writeBegin(), wire.data() + at, n);
+		in.write(n);
+
+		tlv::DecodeResult result = tlv::DecodeFrames(in.readBegin(), in.dataBytes(), frames, 32);
+		for ( size_t i = 0; i < result.frames; ++i ) {
+			all &= frames[i].type == got && tlv::FrameValue(in.readBegin(), frames[i]) == StringView(values[got]);
+			++got;
+		}
+		in.read(result.consumed);
+	}
+	ok &= check(all && got == values.size() && in.dataBytes() == 0, "pieces");
+	return ok;
+}
+
+// at most `max_frames` at a time, the rest on the next call
+bool test_max_frames() {
+	bool ok = true;
+	std::vector<std::string> values = make_values(100);
+	std::string wire = make_wire(values);
+
+	tlv::FrameDesc frames[8];
+	size_t at = 0, got = 0, calls = 0;
+	tlv::DecodeResult result;
+	do {
+		result = tlv::DecodeFrames(wire.data() + at, wire.size() - at, frames, 8);
+		ok &= check(result.needed == 0, "whole frame left");
+		got += result.frames;
+		at += result.consumed;
+		++calls;
+	} while ( result.frames == 8 );
+	ok &= check(got == values.size() && at == wire.size() && calls == 13, "in rounds of eight");
+
+	// a head announcing a huge value
+	std::string head(tlv::HEAD_BYTES, 0);
+	tlv::SerializeHead(1, 0xFFFFFFF0u, &head[0]);
+	result = tlv::DecodeFrames(head.data(), head.size(), frames, 8);
+	ok &= check(result.frames == 0 && result.needed == 0xFFFFFFF0u, "huge length");
+	return ok;
+}
+
+// compact heads with over-long varints : accepted and rejected as by ParseHead()
+bool test_overlong_heads() {
+	bool ok = true;
+	std::vector<std::string> heads = {
+		std::string("\x81\x80\x00\x00", 4),				// type 1 in 3 bytes, still allowed
+		std::string("\x81\x80\x80\x00\x00", 5),			// type 1 in 4 bytes
+		std::string("\x81\x80\x80\x80\x00\x00", 6),		// type 1 in 5 bytes
+		std::string("\x01\x80\x80\x80\x80\x00", 6),		// length 0 in 5 bytes, still allowed
+		std::string("\x01\x80\x80\x80\x80\x80\x00", 7),	// length 0 in 6 bytes
+		std::string("\x01\xFF\xFF\xFF\xFF\x7F", 6),		// length above 32 bits
+	};
+
+	tlv::FrameDesc frames[4];
+	for ( const std::string& head : heads ) {
+		// at the end of the buffer, and with room for a whole head read after it
+		for ( size_t pad : { 0, 16 } ) {
+			std::string wire = head + std::string(pad, '\0');
+			uint16_t type = 0;
+			uint32_t length = 0;
+			size_t head_bytes = 0;
+			tlv::Parser::RetCode retcode = tlv::ParseHead(wire.data(), wire.size(), tlv::framing::COMPACT,
+														  type, length, head_bytes);
+			tlv::DecodeResult result = tlv::DecodeFrames(wire.data(), wire.size(), frames, 1,
+														  tlv::framing::COMPACT);
+			if ( retcode == tlv::Parser::ERROR ) {
+				ok &= check(result.error && result.frames == 0, "rejected as by ParseHead()");
+			} else {
+				ok &= check(!result.error && result.frames == 1 && frames[0].type == type &&
+							frames[0].length == length && frames[0].offset == head_bytes,
+							"accepted as by ParseHead()");
+			}
+		}
+	}
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_whole_buffer();
+	ok &= test_partial();
+	ok &= test_max_frames();
+	ok &= test_overlong_heads();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+#include "../protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+struct Frame {
+	uint16_t type;
+	std::string value;
+};
+
+static std::vector<Frame> make_frames() {
+	std::vector<Frame> frames;
+	const uint16_t types[] = { 0, 1, 127, 128, 300, 16383, 16384, 0xFFFF };
+	const size_t sizes[] = { 0, 1, 100, 127, 128, 200, 16384, 70000 };
+	for ( size_t i = 0; i < 8; ++i ) {
+		for ( size_t j = 0; j < 8; ++j ) {
+			Frame f;
+			f.type = types[i];
+			f.value = std::string(sizes[(i + j) % 8], (char)('a' + j));
+			frames.push_back(f);
+		}
+	}
+	return frames;
+}
+
+bool test_head() {
+	bool ok = true;
+	ok &= check(tlv::HeadBytes(1, 5) == tlv::HEAD_BYTES, "fixed");
+	ok &= check(tlv::HeadBytes(1, 5, tlv::framing::COMPACT) == 2, "two bytes");
+	ok &= check(tlv::HeadBytes(128, 127, tlv::framing::COMPACT) == 3, "type of two bytes");
+	ok &= check(tlv::HeadBytes(127, 128, tlv::framing::COMPACT) == 3, "length of two bytes");
+	ok &= check(tlv::HeadBytes(0xFFFF, 0xFFFFFFFF, tlv::framing::COMPACT) == tlv::COMPACT_MAX_HEAD_BYTES, "largest");
+
+	char head[tlv::MAX_HEAD_BYTES];
+	ok &= check(tlv::SerializeHead(5, 100, head, tlv::framing::COMPACT) == 2 && head[0] == 5 && head[1] == 100,
+				"bytes");
+	ok &= check(tlv::SerializeHead(300, 0, head, tlv::framing::COMPACT) == 3 &&
+				(uint8_t)head[0] == 0xAC && head[1] == 0x02 && head[2] == 0, "varint type");
+
+	uint16_t type;
+	uint32_t length;
+	size_t head_bytes;
+	size_t n = tlv::SerializeHead(0xFFFF, 0xFFFFFFFF, head, tlv::framing::COMPACT);
+	ok &= check(tlv::ParseHead(head, n, tlv::framing::COMPACT, type, length, head_bytes) == tlv::Parser::READY &&
+				type == 0xFFFF && length == 0xFFFFFFFF && head_bytes == n, "largest parsed");
+	for ( size_t cut = 0; cut < n; ++cut ) {
+		ok &= check(tlv::ParseHead(head, cut, tlv::framing::COMPACT, type, length, head_bytes) ==
+					tlv::Parser::WAITING_DATA, "cut short");
+	}
+
+	// too long or out of range
+	std::vector<std::string> malformed = {
+		std::string("\x80\x80\x80\x01\x00", 5),				// type of 4 bytes
+		std::string("\xff\xff\x7f\x00", 4),					// type above 0xFFFF
+		std::string("\x01\x80\x80\x80\x80\x80\x01", 7),		// length of 6 bytes
+		std::string("\x01\xff\xff\xff\xff\x7f", 6),			// length above 0xFFFFFFFF
+	};
+	for ( const std::string& m : malformed ) {
+		ok &= check(tlv::ParseHead(m.data(), m.size(), tlv::framing::COMPACT, type, length, head_bytes) ==
+					tlv::Parser::ERROR, "malformed head");
+
+		tlv::Parser parser(tlv::framing::COMPACT);
+		tlv::MessageView view;
+		ok &= check(parser.parse(m.data(), m.size(), view) == tlv::Parser::ERROR, "malformed message");
+
+		tlv::FrameDesc frames[4];
+		tlv::DecodeResult result = tlv::DecodeFrames(m.data(), m.size(), frames, 4, tlv::framing::COMPACT);
+		ok &= check(result.error && result.frames == 0 && result.consumed == 0, "malformed batch");
+	}
+	return ok;
+}
+
+bool test_messages() {
+	bool ok = true;
+	std::vector<Frame> frames = make_frames();
+
+	asio::DynamicBuffer buffer;
+	size_t fixed_bytes = 0;
+	for ( const Frame& f : frames ) {
+		tlv::Message msg;
+		msg.setType(f.type);
+		msg.setLength((uint32_t)f.value.size());
+		msg.setValue(f.value);
+		std::string dumped = msg.dump(tlv::framing::COMPACT);
+		size_t n = tlv::SerializeMessage(f.type, f.value, buffer, tlv::framing::COMPACT);
+		ok &= check(dumped.size() == n && dumped == std::string(buffer.readBegin() + buffer.dataBytes() - n, n),
+					"dump() and SerializeMessage agree");
+		fixed_bytes += tlv::HEAD_BYTES + f.value.size();
+	}
+	std::string wire(buffer.readBegin(), buffer.dataBytes());
+	ok &= check(wire.size() < fixed_bytes, "shorter");
+
+	// a few bytes at a time
+	tlv::Parser parser;
+	parser.setFraming(tlv::framing::COMPACT);
+	ok &= check(parser.framing() == tlv::framing::COMPACT, "framing()");
+	asio::DynamicBuffer in;
+	tlv::MessageView view;
+	size_t got = 0;
+	bool same = true;
+	for ( size_t at = 0; at < wire.size(); at += 5 ) {
+		size_t n = wire.size() - at < 5 ? wire.size() - at : 5;
+		in.reserve(n);
+		::memcpy(in.writeBegin(), wire.data() + at, n);
+		in.write(n);
+
+		while ( parser.parse(in.readBegin(), in.dataBytes(), view) == tlv::Parser::READY ) {
+			same &= view.type() == frames[got].type && view.value() == StringView(frames[got].value);
+			same &= parser.nparse() == tlv::HeadBytes(view.type(), view.length(), tlv::framing::COMPACT) +
+									   view.length();
+			in.read(parser.nparse());
+			parser.reset();
+			++got;
+		}
+	}
+	ok &= check(same && got == frames.size() && in.dataBytes() == 0, "parsed");
+
+	tlv::Message msg;
+	ok &= check(parser.parse(wire.data(), wire.size(), msg) == tlv::Parser::READY &&
+				msg.type() == frames[0].type && msg.value() == frames[0].value, "into a Message");
+
+	// every cut of the batch decoder
+	std::vector<size_t> ends;
+	size_t end = 0;
+	for ( const Frame& f : frames ) {
+		end += tlv::HeadBytes(f.type, (uint32_t)f.value.size(), tlv::framing::COMPACT) + f.value.size();
+		ends.push_back(end);
+	}
+	std::vector<tlv::FrameDesc> descs;
+	bool all = true;
+	for ( size_t cut = 0; cut <= wire.size(); cut += (cut < 2000 ? 1 : 499) ) {
+		tlv::DecodeResult result = tlv::DecodeFrames(wire.data(), cut, descs, tlv::framing::COMPACT);
+		size_t whole = 0;
+		while ( whole < ends.size() && ends[whole] <= cut ) {
+			++whole;
+		}
+		all &= result.frames == whole && descs.size() == whole && !result.error;
+		all &= result.consumed == (whole == 0 ? 0 : ends[whole - 1]);
+		all &= (result.needed > 0) == (cut != result.consumed);
+		for ( size_t i = 0; i < descs.size(); ++i ) {
+			all &= descs[i].type == frames[i].type && tlv::FrameValue(wire.data(), descs[i]) == StringView(frames[i].value);
+		}
+	}
+	ok &= check(all, "batch");
+	return ok;
+}
+
+// the small frames of a message bus : 2 bytes of head instead of 6
+bool test_small_frames() {
+	asio::DynamicBuffer fixed, compact;
+	for ( uint16_t type = 0; type < 100; ++type ) {
+		std::string value(4, 'v');
+		tlv::SerializeMessage(type, value, fixed);
+		tlv::SerializeMessage(type, value, compact, tlv::framing::COMPACT);
+	}
+	return check(fixed.dataBytes() == 100 * 10 && compact.dataBytes() == 100 * 6, "small frames");
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_head();
+	ok &= test_messages();
+	ok &= test_small_frames();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+#include "../protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <string.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/socket.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+static tlv::Message make_message(uint16_t type, const std::string& value) {
+	tlv::Message msg;
+	msg.setType(type);
+	msg.setLength((uint32_t)value.size());
+	msg.setValue(value);
+	return msg;
+}
+
+bool test_serialize() {
+	bool ok = true;
+	tlv::Message msg = make_message(20, "hello world");
+
+	asio::DynamicBuffer buffer;
+	size_t n = tlv::SerializeMessage(msg, buffer);
+	std::string dumped = msg.dump();
+	ok &= check(n == tlv::HEAD_BYTES + 11 && dumped.size() == n, "size");
+	ok &= check(std::string(buffer.readBegin(), buffer.dataBytes()) == dumped, "same bytes as dump()");
+	ok &= check(dumped.compare(0, tlv::HEAD_BYTES, std::string("\x00\x14\x00\x00\x00\x0b", 6)) == 0,
+				"network order");
+
+	// only the first length() bytes go out, none if the value is short
+	msg.setLength(5);
+	ok &= check(tlv::SerializeMessage(msg, buffer) == tlv::HEAD_BYTES + 5, "length below the value");
+	msg.setLength(50);
+	ok &= check(tlv::SerializeMessage(msg, buffer) == 0 && msg.dump().empty(), "value too short");
+	ok &= check(buffer.dataBytes() == dumped.size() + tlv::HEAD_BYTES + 5, "nothing written");
+
+	ok &= check(tlv::SerializeMessage(7, StringView(), buffer) == tlv::HEAD_BYTES, "empty value");
+	return ok;
+}
+
+bool test_parse_view() {
+	bool ok = true;
+	asio::DynamicBuffer buffer(8);
+	std::vector<std::string> values = { "first", "", std::string(5000, 'x'), "last" };
+	for ( size_t i = 0; i < values.size(); ++i ) {
+		tlv::SerializeMessage((uint16_t)(100 + i), values[i], buffer);
+	}
+	std::string wire(buffer.readBegin(), buffer.dataBytes());
+
+	// fed a few bytes at a time, the buffer moves as it grows
+	asio::DynamicBuffer in(16);
+	tlv::Parser parser;
+	tlv::MessageView view;
+	size_t got = 0;
+	for ( size_t at = 0; at < wire.size(); at += 3 ) {
+		size_t n = wire.size() - at < 3 ? wire.size() - at : 3;
+		in.reserve(n);
+		::memcpy(in.writeBegin(), wire.data() + at, n);
+		in.write(n);
+
+		while ( parser.parse(in.readBegin(), in.dataBytes(), view) == tlv::Parser::READY ) {
+			ok &= check(view.type() == 100 + got && view.length() == values[got].size(), "head");
+			ok &= check(view.value() == StringView(values[got]), "value");
+			ok &= check(view.value().empty() ||
+						view.value().data() == in.readBegin() + tlv::HEAD_BYTES, "points into the buffer");
+			in.read(parser.nparse());
+			parser.reset();
+			++got;
+		}
+	}
+	ok &= check(got == values.size() && in.dataBytes() == 0, "every message");
+
+	// the same bytes into an owning Message
+	tlv::Message msg;
+	ok &= check(parser.parse(wire.data(), wire.size(), msg) == tlv::Parser::READY, "message");
+	ok &= check(msg.type() == 100 && msg.value() == "first" && parser.nparse() == tlv::HEAD_BYTES + 5,
+				"message fields");
+
+	parser.reset();
+	ok &= check(parser.parse(wire.data(), 4, view) == tlv::Parser::WAITING_DATA, "waiting");
+	ok &= check(parser.parse(wire.data(), 10, view) == tlv::Parser::WAITING_DATA, "waiting value");
+	ok &= check(parser.parse(wire.data(), 11, view) == tlv::Parser::READY, "ready");
+
+	tlv::Message copy = view.toMessage();
+	ok &= check(copy.type() == 100 && copy.length() == 5 && copy.value() == "first", "toMessage()");
+	view.clear();
+	ok &= check(view.type() == 0 && view.value().empty(), "clear()");
+	return ok;
+}
+
+bool test_iovec() {
+	bool ok = true;
+	std::string value(3000, 'v');
+	char head[tlv::HEAD_BYTES];
+	struct iovec iov[2];
+	size_t n = tlv::SerializeMessage(9, value, head, iov);
+	ok &= check(n == tlv::HEAD_BYTES + value.size(), "size");
+	ok &= check(iov[1].iov_base == (void*)value.data(), "value not copied");
+
+	int fds[2];
+	::socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	ok &= check(::writev(fds[0], iov, 2) == (ssize_t)n, "writev");
+
+	std::string wire(n, 0);
+	size_t got = 0;
+	while ( got < n ) {
+		ssize_t r = ::read(fds[1], &wire[got], n - got);
+		if ( r <= 0 ) {
+			break;
+		}
+		got += r;
+	}
+	::close(fds[0]);
+	::close(fds[1]);
+
+	ok &= check(wire == make_message(9, value).dump(), "same bytes as dump()");
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_serialize();
+	ok &= test_parse_view();
+	ok &= test_iovec();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
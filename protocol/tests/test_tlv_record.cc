@@ -0,0 +1,252 @@
+#include "../protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+
+#include <iostream>
+#include <string>
+#include <array>
+#include <limits>
+#include <string.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+enum class side : uint8_t {
+	BUY = 1,
+	SELL = 2,
+};
+
+struct Point {
+	int32_t x;
+	int32_t y;
+
+	typedef tlv::Schema<
+		LCY_TLV_FIELD(1, Point, x),
+		LCY_TLV_FIELD(2, Point, y)
+	> schema_type;
+};
+
+struct Order {
+	uint64_t id;
+	int16_t delta;
+	side dir;
+	bool urgent;
+	double price;
+	float ratio;
+	StringView symbol;
+	std::string note;
+	Point at;
+	std::array<uint32_t, 5> levels;
+
+	typedef tlv::Schema<
+		LCY_TLV_FIELD(1, Order, id),
+		LCY_TLV_FIELD(2, Order, delta),
+		LCY_TLV_FIELD(3, Order, dir),
+		LCY_TLV_FIELD(4, Order, urgent),
+		LCY_TLV_FIELD(5, Order, price),
+		LCY_TLV_FIELD(6, Order, ratio),
+		LCY_TLV_FIELD(7, Order, symbol),
+		LCY_TLV_FIELD(8, Order, note),
+		LCY_TLV_FIELD(300, Order, at),
+		LCY_TLV_FIELD(9, Order, levels)
+	> schema_type;
+};
+
+// Order as an older peer knows it : fewer fields, one of them under another tag
+struct OrderV1 {
+	uint64_t id;
+	uint32_t other;
+	StringView symbol;
+
+	typedef tlv::Schema<
+		LCY_TLV_FIELD(1, OrderV1, id),
+		LCY_TLV_FIELD(60, OrderV1, other),
+		LCY_TLV_FIELD(7, OrderV1, symbol)
+	> schema_type;
+};
+
+struct Small {
+	uint8_t u8;
+	int8_t i8;
+	uint16_t u16;
+	int64_t i64;
+
+	typedef tlv::Schema<
+		LCY_TLV_FIELD(1, Small, u8),
+		LCY_TLV_FIELD(2, Small, i8),
+		LCY_TLV_FIELD(3, Small, u16),
+		LCY_TLV_FIELD(4, Small, i64)
+	> schema_type;
+};
+
+static Order make_order() {
+	Order order;
+	order.id = 0x0102030405060708ull;
+	order.delta = -300;
+	order.dir = side::SELL;
+	order.urgent = true;
+	order.price = 101.25;
+	order.ratio = -0.5f;
+	order.symbol = "LCY";
+	order.note = std::string(200, 'n');
+	order.at.x = -1;
+	order.at.y = 1 << 20;
+	order.levels = {{ 1, 200, 70000, 0, 0xFFFFFFFF }};
+	return order;
+}
+
+static bool same(const Order& a, const Order& b) {
+	return a.id == b.id && a.delta == b.delta && a.dir == b.dir && a.urgent == b.urgent &&
+		   a.price == b.price && a.ratio == b.ratio && a.symbol == b.symbol && a.note == b.note &&
+		   a.at.x == b.at.x && a.at.y == b.at.y && a.levels == b.levels;
+}
+
+bool test_fixed_bytes() {
+	bool ok = true;
+	Point p;
+	p.x = 1;
+	p.y = -2;
+	char out[64];
+	size_t n = tlv::EncodeRecord(p, out);
+	ok &= check(n == tlv::RecordBytes(p) && n == 2 * (tlv::HEAD_BYTES + 4), "size");
+	ok &= check(std::string(out, n) ==
+				std::string("\x00\x01\x00\x00\x00\x04\x00\x00\x00\x01"
+							"\x00\x02\x00\x00\x00\x04\xFF\xFF\xFF\xFE", 20), "fixed bytes");
+
+	// the same bytes as the fields written one by one
+	asio::DynamicBuffer buffer;
+	tlv::SerializeMessage(1, StringView("\x00\x00\x00\x01", 4), buffer);
+	tlv::SerializeMessage(2, StringView("\xFF\xFF\xFF\xFE", 4), buffer);
+	ok &= check(std::string(buffer.readBegin(), buffer.dataBytes()) == std::string(out, n), "hand written");
+
+	// compact : zigzag varints, -2 is 3
+	n = tlv::EncodeRecord(p, out, tlv::framing::COMPACT);
+	ok &= check(std::string(out, n) == std::string("\x01\x01\x02\x02\x01\x03", 6), "compact bytes");
+	return ok;
+}
+
+bool test_round_trip() {
+	bool ok = true;
+	Order order = make_order();
+
+	for ( tlv::framing_type f : { tlv::framing::FIXED, tlv::framing::COMPACT } ) {
+		asio::DynamicBuffer buffer(8);
+		size_t n = tlv::SerializeRecord(42, order, buffer, f);
+		ok &= check(n == buffer.dataBytes() && n == tlv::HeadBytes(42, (uint32_t)tlv::RecordBytes(order, f), f) +
+					tlv::RecordBytes(order, f), "serialized size");
+
+		// through the parser, as it comes off the wire
+		tlv::Parser parser(f);
+		tlv::MessageView view;
+		ok &= check(parser.parse(buffer.readBegin(), buffer.dataBytes(), view) == tlv::Parser::READY &&
+					view.type() == 42 && parser.nparse() == n, "parsed");
+
+		Order got;
+		got.symbol = StringView();
+		ok &= check(tlv::DecodeRecord(view.value(), got, f), "decoded");
+		ok &= check(same(order, got), "same fields");
+		ok &= check(got.symbol.data() >= view.value().data() &&
+					got.symbol.data() < view.value().data() + view.value().size(), "symbol points into the value");
+	}
+
+	// limits of every integer width, both framings
+	Small limits[] = {
+		{ 0, 0, 0, 0 },
+		{ 255, -128, 65535, std::numeric_limits<int64_t>::min() },
+		{ 127, 127, 128, std::numeric_limits<int64_t>::max() },
+		{ 128, -1, 16384, -1 },
+	};
+	for ( const Small& s : limits ) {
+		for ( tlv::framing_type f : { tlv::framing::FIXED, tlv::framing::COMPACT } ) {
+			char out[128];
+			size_t n = tlv::EncodeRecord(s, out, f);
+			Small got = { 1, 1, 1, 1 };
+			ok &= check(n == tlv::RecordBytes(s, f) && tlv::DecodeRecord(StringView(out, n), got, f), "limits");
+			ok &= check(got.u8 == s.u8 && got.i8 == s.i8 && got.u16 == s.u16 && got.i64 == s.i64, "limits values");
+		}
+	}
+	return ok;
+}
+
+bool test_versions() {
+	bool ok = true;
+	Order order = make_order();
+	asio::DynamicBuffer buffer;
+	tlv::SerializeRecord(1, order, buffer);
+	StringView value(buffer.readBegin() + tlv::HEAD_BYTES, buffer.dataBytes() - tlv::HEAD_BYTES);
+
+	// unknown tags are skipped, missing fields left as they were
+	OrderV1 old;
+	old.other = 77;
+	ok &= check(tlv::DecodeRecord(value, old), "older reader");
+	ok &= check(old.id == order.id && old.symbol == StringView("LCY") && old.other == 77, "older fields");
+
+	char out[64];
+	size_t n = tlv::EncodeRecord(old, out);
+	Order fresh = make_order();
+	fresh.symbol = "XYZ";
+	ok &= check(tlv::DecodeRecord(StringView(out, n), fresh), "newer reader");
+	ok &= check(fresh.symbol == StringView("LCY") && fresh.note == order.note, "newer fields");
+
+	// fields in any order, the last one wins
+	asio::DynamicBuffer reordered;
+	tlv::SerializeMessage(2, StringView("\x00\x00\x00\x07", 4), reordered);
+	tlv::SerializeMessage(1, StringView("\x00\x00\x00\x05", 4), reordered);
+	tlv::SerializeMessage(2, StringView("\x00\x00\x00\x09", 4), reordered);
+	Point p = { 0, 0 };
+	ok &= check(tlv::DecodeRecord(StringView(reordered.readBegin(), reordered.dataBytes()), p) &&
+				p.x == 5 && p.y == 9, "any order");
+
+	Point empty = { 3, 4 };
+	ok &= check(tlv::DecodeRecord(StringView(), empty) && empty.x == 3 && empty.y == 4, "empty value");
+	return ok;
+}
+
+bool test_malformed() {
+	bool ok = true;
+	Point p;
+	p.x = 1;
+	p.y = 2;
+	char out[64];
+	size_t n = tlv::EncodeRecord(p, out);
+
+	for ( size_t cut = 1; cut < n; ++cut ) {
+		if ( cut == tlv::HEAD_BYTES + 4 ) {
+			continue;		// a whole field
+		}
+		ok &= check(!tlv::DecodeRecord(StringView(out, cut), p), "truncated");
+	}
+
+	// an int32 field of 2 bytes
+	std::string wrong("\x00\x01\x00\x00\x00\x02\x00\x01", 8);
+	ok &= check(!tlv::DecodeRecord(wrong, p), "wrong width");
+
+	// compact : bytes past the varint, out of range, none
+	ok &= check(!tlv::DecodeRecord(StringView("\x01\x02\x02\x00", 4), p, tlv::framing::COMPACT), "bytes after the varint");
+	ok &= check(!tlv::DecodeRecord(StringView("\x01\x05\xFF\xFF\xFF\xFF\x7F", 7), p, tlv::framing::COMPACT),
+				"above int32");
+	ok &= check(!tlv::DecodeRecord(StringView("\x01\x00", 2), p, tlv::framing::COMPACT), "empty varint");
+
+	Small s;
+	ok &= check(!tlv::DecodeRecord(StringView("\x01\x02\x80\x02", 4), s, tlv::framing::COMPACT), "above uint8");
+
+	Order order = make_order();
+	ok &= check(!tlv::DecodeRecord(StringView("\x04\x01\x02", 3), order, tlv::framing::COMPACT), "bool of 2");
+	ok &= check(!tlv::DecodeRecord(StringView("\x09\x04\x00\x00\x00\x01", 6), order, tlv::framing::COMPACT),
+				"array of the wrong size");
+
+	// a nested record that is not one
+	ok &= check(!tlv::DecodeRecord(StringView("\xAC\x02\x01\x01", 4), order, tlv::framing::COMPACT), "nested");
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_fixed_bytes();
+	ok &= test_round_trip();
+	ok &= test_versions();
+	ok &= test_malformed();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,217 @@
+#include "../protocol.hpp"
+#include "check.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <string.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+// the byte at a time references
+static size_t ref_length(uint64_t v) {
+	size_t n = 1;
+	while ( v >= 0x80 ) {
+		v >>= 7;
+		++n;
+	}
+	return n;
+}
+
+static size_t ref_encode(uint64_t v, uint8_t* out) {
+	size_t n = 0;
+	while ( v >= 0x80 ) {
+		out[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	out[n++] = (uint8_t)v;
+	return n;
+}
+
+static std::vector<uint64_t> boundaries() {
+	std::vector<uint64_t> values = { 0, 1, 0xFFFFFFFFFFFFFFFFull };
+	for ( int bits = 7; bits < 64; bits += 7 ) {
+		values.push_back((1ull << bits) - 1);
+		values.push_back(1ull << bits);
+		values.push_back((1ull << bits) + 1);
+	}
+	values.push_back(0xFFFFFFFFull);
+	values.push_back(0x100000000ull);
+	values.push_back(0x8000000000000000ull);
+	return values;
+}
+
+bool test_length() {
+	bool ok = true;
+	for ( uint64_t v : boundaries() ) {
+		ok &= check(tlv::VariantLengthUint64(v) == ref_length(v), "length 64");
+		if ( v <= 0xFFFFFFFF ) {
+			ok &= check(tlv::VariantLengthUint32((uint32_t)v) == ref_length(v), "length 32");
+		}
+	}
+	return ok;
+}
+
+bool test_round_trip() {
+	bool ok = true;
+	std::vector<uint64_t> values = boundaries();
+	std::mt19937_64 rng(49);
+	for ( int i = 0; i < 2000; ++i ) {
+		values.push_back(rng() >> (rng() % 64));
+	}
+
+	for ( uint64_t v : values ) {
+		uint8_t ref[tlv::BUFLEN_UINT64];
+		size_t n = ref_encode(v, ref);
+
+		// exact size buffers take the byte loop, spacious ones the word store
+		for ( size_t room : { n, n + 16 } ) {
+			std::vector<uint8_t> buf(room + 8, 0xEE);
+			ok &= check(tlv::VariantWriteUint64(v, buf.data(), room) == n, "write 64 size");
+			ok &= check(::memcmp(buf.data(), ref, n) == 0, "write 64 bytes");
+			ok &= check(buf[room] == 0xEE, "write 64 past len");
+
+			uint64_t got = 0;
+			ok &= check(tlv::VariantReadUint64(buf.data(), room, got) == n && got == v, "read 64");
+
+			if ( v > 0xFFFFFFFF ) {
+				uint32_t small = 0;
+				ok &= check(tlv::VariantReadUint32(buf.data(), room, small) == 0, "read 32 out of range");
+				continue;
+			}
+			ok &= check(tlv::VariantWriteUint32((uint32_t)v, buf.data(), room) == n, "write 32 size");
+			ok &= check(::memcmp(buf.data(), ref, n) == 0, "write 32 bytes");
+
+			uint32_t got32 = 0;
+			ok &= check(tlv::VariantReadUint32(buf.data(), room, got32) == n && got32 == v, "read 32");
+
+			// the same bytes as the macro based encoder
+			uint8_t old[tlv::BUFLEN_UINT32];
+			ok &= check(tlv::VariantEncodeUint32((uint32_t)v, old, sizeof(old)) == n &&
+						::memcmp(old, ref, n) == 0, "same bytes as VariantEncodeUint32");
+		}
+
+		// one byte short
+		uint8_t buf[32];
+		ok &= check(tlv::VariantWriteUint64(v, buf, n - 1) == 0, "write 64 no room");
+		uint64_t got = 0;
+		ok &= check(tlv::VariantReadUint64(ref, n - 1, got) == 0, "read 64 truncated");
+	}
+	return ok;
+}
+
+bool test_malformed() {
+	bool ok = true;
+	uint32_t v32 = 0;
+	uint64_t v64 = 0;
+
+	// 6 bytes for a 32 bit value, with and without room for a word read
+	uint8_t six[16] = { 0x80, 0x80, 0x80, 0x80, 0x80, 0x00 };
+	ok &= check(tlv::VariantReadUint32(six, 6, v32) == 0, "32 too long");
+	ok &= check(tlv::VariantReadUint32(six, sizeof(six), v32) == 0, "32 too long, word");
+	ok &= check(tlv::VariantReadUint64(six, sizeof(six), v64) == 6 && v64 == 0, "64 padded");
+
+	// 5 bytes above 0xFFFFFFFF
+	uint8_t big[16] = { 0xFF, 0xFF, 0xFF, 0xFF, 0x1F };
+	ok &= check(tlv::VariantReadUint32(big, 5, v32) == 0, "32 out of range");
+	ok &= check(tlv::VariantReadUint32(big, sizeof(big), v32) == 0, "32 out of range, word");
+	big[4] = 0x0F;
+	ok &= check(tlv::VariantReadUint32(big, sizeof(big), v32) == 5 && v32 == 0xFFFFFFFF, "32 max");
+
+	// 11 bytes, and a 10th byte above 1
+	uint8_t eleven[16];
+	::memset(eleven, 0x80, sizeof(eleven));
+	eleven[10] = 0x00;
+	ok &= check(tlv::VariantReadUint64(eleven, sizeof(eleven), v64) == 0, "64 too long");
+	eleven[9] = 0x02;
+	ok &= check(tlv::VariantReadUint64(eleven, sizeof(eleven), v64) == 0, "64 out of range");
+	eleven[9] = 0x01;
+	ok &= check(tlv::VariantReadUint64(eleven, sizeof(eleven), v64) == 10 && v64 == 1ull << 63, "64 top bit");
+
+	ok &= check(tlv::VariantReadUint32(six, 0, v32) == 0, "empty");
+	return ok;
+}
+
+// the stream of `values` as varints, then `tail`
+static std::string make_stream(const std::vector<uint32_t>& values, const std::string& tail = std::string()) {
+	std::string wire;
+	for ( uint32_t v : values ) {
+		uint8_t buf[tlv::BUFLEN_UINT32];
+		wire.append((const char*)buf, ref_encode(v, buf));
+	}
+	return wire + tail;
+}
+
+static bool same_at_every_level(const std::string& wire, size_t count, size_t want_n, size_t want_read,
+								const std::vector<uint32_t>& want, const char* what) {
+	bool ok = true;
+	http::scan_level_type detected = tlv::VariantLevel();
+	for ( int l = (int)http::scan_level::SCALAR; l <= (int)http::scan_level::AVX2; ++l ) {
+		if ( tlv::SetVariantLevel((http::scan_level_type)l) != (http::scan_level_type)l ) {
+			continue;
+		}
+		std::vector<uint32_t> out(count + 1, 0xDEADBEEF);
+		size_t nread = 12345;
+		size_t n = tlv::VariantDecodeStreamUint32(wire.data(), wire.size(), out.data(), count, nread);
+		bool same = n == want_n && nread == want_read && out[count] == 0xDEADBEEF;
+		for ( size_t i = 0; same && i < n; ++i ) {
+			same = out[i] == want[i];
+		}
+		if ( !same ) {
+			std::cout << http::ScanLevelToString((http::scan_level_type)l) << " : ";
+		}
+		ok &= check(same, what);
+	}
+	tlv::SetVariantLevel(detected);
+	return ok;
+}
+
+bool test_stream() {
+	bool ok = true;
+	std::mt19937 rng(50);
+
+	// all small, mostly small, and mixed, across block edges
+	for ( int shape = 0; shape < 3; ++shape ) {
+		for ( size_t size : { 0, 1, 7, 8, 15, 16, 17, 31, 32, 33, 100, 1000 } ) {
+			std::vector<uint32_t> values;
+			for ( size_t i = 0; i < size; ++i ) {
+				uint32_t r = rng();
+				if ( shape == 0 || (shape == 1 && r % 16 != 0) ) {
+					values.push_back(r % 128);
+				} else {
+					values.push_back(r >> (r % 32));
+				}
+			}
+			std::string wire = make_stream(values);
+			ok &= same_at_every_level(wire, values.size(), values.size(), wire.size(), values, "whole stream");
+
+			// a count below the values stops right after the last one taken
+			if ( size > 3 ) {
+				size_t count = size / 2 + 1;
+				size_t bytes = make_stream(std::vector<uint32_t>(values.begin(), values.begin() + count)).size();
+				ok &= same_at_every_level(wire, count, count, bytes, values, "count limit");
+			}
+
+			// truncated, and malformed, tails
+			ok &= same_at_every_level(wire + "\x81\x81", values.size() + 5, values.size(), wire.size(),
+										values, "truncated tail");
+			ok &= same_at_every_level(wire + std::string("\x80\x80\x80\x80\x80\x00\x01", 7), values.size() + 5,
+										values.size(), wire.size(), values, "malformed tail");
+		}
+	}
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+	std::cout << "detected : " << http::ScanLevelToString(tlv::VariantLevel()) << std::endl;
+	ok &= test_length();
+	ok &= test_round_trip();
+	ok &= test_malformed();
+	ok &= test_stream();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
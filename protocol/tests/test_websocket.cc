@@ -0,0 +1,573 @@
+#include "protocol/protocol.hpp"
+#include "asio/asio.hpp"
+#include "check.h"
+#include "loopback.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+using namespace lcy;
+using namespace lcy::protocol;
+
+static const uint8_t kKey[4] = { 0x37, 0xFA, 0x21, 0x3D };
+
+///////////////////////////////////////////////////////////////
+
+bool test_accept_key() {
+	bool ok = true;
+	// RFC 6455 1.3
+	ok &= check(websocket::AcceptKey("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=", "accept key");
+
+	http::Request request;
+	request.setMethod(http::method::GET);
+	request.setVersion(http::version::HTTP_1_1);
+	request.setUri("/chat");
+	request.setHeader(http::field::UPGRADE, "websocket");
+	request.setHeader(http::field::CONNECTION, "keep-alive, Upgrade");
+	request.setHeader("sec-websocket-key", "dGhlIHNhbXBsZSBub25jZQ==");
+	request.setHeader("Sec-WebSocket-Version", "13");
+	request.setHeader("Sec-WebSocket-Extensions", "permessage-deflate; client_max_window_bits");
+	ok &= check(websocket::IsUpgrade(request), "upgrade request");
+
+	http::Response response;
+	websocket::DeflateParams params;
+	bool deflated = false;
+	ok &= check(websocket::Accept(request, response, &params, &deflated), "accepted");
+	ok &= check(response.state() == http::state::SWITCHING_PROTOCOLS, "101");
+	ok &= check(response.getHeader("Sec-WebSocket-Accept") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=", "accept field");
+	ok &= check(deflated && response.getHeader("Sec-WebSocket-Extensions") == "permessage-deflate", "deflate taken");
+
+	request.setHeader("Sec-WebSocket-Version", "8");
+	ok &= check(!websocket::IsUpgrade(request), "version 13 only");
+	request.setHeader("Sec-WebSocket-Version", "13");
+	request.setMethod(http::method::POST);
+	ok &= check(!websocket::IsUpgrade(request), "GET only");
+	return ok;
+}
+
+bool test_negotiate_deflate() {
+	bool ok = true;
+	websocket::DeflateParams params;
+
+	ok &= check(!websocket::NegotiateDeflate("", params), "no offer");
+	ok &= check(!websocket::NegotiateDeflate("x-webkit-deflate-frame", params), "other extension");
+	ok &= check(!websocket::NegotiateDeflate("permessage-deflate; server_max_window_bits=8", params), "8 bit window");
+	ok &= check(!websocket::NegotiateDeflate("permessage-deflate; foo", params), "unknown parameter");
+
+	ok &= check(websocket::NegotiateDeflate("permessage-deflate; server_max_window_bits=8, "
+											"permessage-deflate; server_no_context_takeover; "
+											"server_max_window_bits=\"10\"", params), "second offer");
+	ok &= check(params.server_no_context_takeover && params.server_max_window_bits == 10, "parameters");
+	ok &= check(params.toString() == "permessage-deflate; server_no_context_takeover; server_max_window_bits=10",
+				"answer");
+
+	// both ends of a stream, with and without context takeover
+	for ( int takeover = 0; takeover < 2; ++takeover ) {
+		websocket::DeflateParams p;
+		p.server_no_context_takeover = takeover == 0;
+		p.client_no_context_takeover = takeover == 0;
+		websocket::Deflate sender(p, 6), receiver(p, 6);
+		ok &= check(sender.ok() && receiver.ok(), "zlib ready");
+
+		std::string text;
+		for ( int i = 0; i < 200; ++i ) {
+			text += "a message that compresses rather well ";
+		}
+		for ( int round = 0; round < 3; ++round ) {
+			std::string wire, out;
+			ok &= check(sender.compress(text.substr(0, 1000), false, wire), "first piece");
+			ok &= check(sender.compress(text.substr(1000), true, wire), "last piece");
+			ok &= check(wire.size() < text.size() / 4, "compressed");
+			ok &= check(receiver.decompress(wire, out), "decompressed");
+			ok &= check(out == text, "round trip");
+		}
+
+		std::string wire, out;
+		sender.compress(text, true, wire);
+		ok &= check(!receiver.decompress(wire, out, 100), "inflate limit");
+	}
+	return ok;
+}
+
+bool test_mask() {
+	bool ok = true;
+	std::string plain;
+	for ( int i = 0; i < 300; ++i ) {
+		plain.push_back((char)(i * 7));
+	}
+
+	http::scan_level_type original = websocket::MaskLevel();
+	std::vector<std::string> results;
+	for ( int level = 0; level <= 2; ++level ) {
+		websocket::SetMaskLevel((http::scan_level_type)level);
+		for ( size_t len = 0; len < 100; ++len ) {
+			for ( size_t offset = 0; offset < 4; ++offset ) {
+				std::string data = plain.substr(0, len);
+				websocket::Mask(&data[0], len, kKey, offset);
+				bool same = true;
+				for ( size_t i = 0; i < len; ++i ) {
+					same &= data[i] == (char)(plain[i] ^ kKey[(offset + i) & 3]);
+				}
+				ok &= check(same, "mask of every length and offset");
+			}
+		}
+
+		// a payload masked piece by piece equals the one masked at once
+		std::string whole = plain, pieces = plain;
+		websocket::Mask(&whole[0], whole.size(), kKey);
+		websocket::Mask(&pieces[0], 13, kKey, 0);
+		websocket::Mask(&pieces[13], 150, kKey, 13);
+		websocket::Mask(&pieces[163], pieces.size() - 163, kKey, 163);
+		ok &= check(whole == pieces, "masked in pieces");
+		results.push_back(whole);
+	}
+	websocket::SetMaskLevel(original);
+
+	ok &= check(results[0] == results[1] && results[1] == results[2], "every level agrees");
+	return ok;
+}
+
+bool test_frames() {
+	bool ok = true;
+	websocket::FrameParser parser;
+	websocket::Frame frame;
+
+	size_t sizes[] = { 0, 5, 125, 126, 65535, 65536, 70000 };
+	for ( size_t size : sizes ) {
+		std::string payload(size, 'x');
+		for ( size_t i = 0; i < size; ++i ) {
+			payload[i] = (char)('a' + i % 26);
+		}
+
+		asio::DynamicBuffer buffer;
+		size_t bytes = websocket::SerializeFrame(buffer, websocket::opcode::BINARY, payload, true, false, kKey);
+		ok &= check(buffer.dataBytes() == bytes, "bytes appended");
+
+		// every prefix waits for more
+		std::string wire(buffer.readBegin(), buffer.dataBytes());
+		for ( size_t cut = 0; cut < wire.size(); cut += (cut < 20 ? 1 : 4093) ) {
+			std::string part = wire.substr(0, cut);
+			ok &= check(parser.parse(&part[0], part.size(), frame) == websocket::FrameParser::WAITING_DATA, "prefix");
+		}
+
+		ok &= check(parser.parse(buffer, frame) == websocket::FrameParser::READY, "frame ready");
+		ok &= check(frame.fin && frame.opcode == websocket::opcode::BINARY && frame.masked, "head");
+		ok &= check(frame.payload == StringView(payload), "payload unmasked");
+		ok &= check(buffer.dataBytes() == 0 && parser.nparse() == bytes, "frame consumed");
+	}
+
+	// two frames in one buffer, a server frame is not masked
+	asio::DynamicBuffer buffer;
+	websocket::SerializeFrame(buffer, websocket::opcode::TEXT, "hel", false);
+	websocket::SerializeFrame(buffer, websocket::opcode::CONTINUATION, "lo", true);
+	websocket::FrameParser client;
+	client.setRequireMask(false);
+	ok &= check(client.parse(buffer, frame) == websocket::FrameParser::READY &&
+				!frame.fin && frame.opcode == websocket::opcode::TEXT && frame.payload == "hel", "first fragment");
+	ok &= check(client.parse(buffer, frame) == websocket::FrameParser::READY &&
+				frame.fin && frame.opcode == websocket::opcode::CONTINUATION && frame.payload == "lo", "last fragment");
+
+	// protocol errors
+	struct { const char* wire; size_t len; const char* what; } bad[] = {
+		{ "\xA1\x80\0\0\0\0", 6, "RSV2" },
+		{ "\x83\x80\0\0\0\0", 6, "reserved opcode" },
+		{ "\x81\x00", 2, "unmasked" },
+		{ "\x09\x80\0\0\0\0", 6, "fragmented ping" },
+		{ "\x89\xFE\x00\x7E", 4, "ping above 125 bytes" },
+		{ "\x82\xFF\x80\0\0\0\0\0\0\0", 10, "64 bit length top bit" },
+	};
+	for ( auto& b : bad ) {
+		std::string wire(b.wire, b.len);
+		ok &= check(parser.parse(&wire[0], wire.size(), frame) == websocket::FrameParser::ERROR &&
+					parser.errcode() == websocket::FrameParser::ErrCode::PROTOCOL_ERROR, b.what);
+	}
+
+	parser.setMaxPayloadBytes(1000);
+	std::string big("\x82\xFE\x03\xE9", 4);
+	ok &= check(parser.parse(&big[0], big.size(), frame) == websocket::FrameParser::ERROR &&
+				parser.errcode() == websocket::FrameParser::ErrCode::TOO_LARGE, "above the limit");
+	return ok;
+}
+
+bool test_utf8() {
+	bool ok = true;
+	ok &= check(websocket::IsUtf8(""), "empty");
+	ok &= check(websocket::IsUtf8("plain ascii text, long enough for words"), "ascii");
+	ok &= check(websocket::IsUtf8("\xCE\xBA\xE1\xBD\xB9\xCF\x83\xCE\xBC\xCE\xB5"), "greek");
+	ok &= check(websocket::IsUtf8("\xF0\x9F\x98\x80 emoji"), "four bytes");
+	ok &= check(!websocket::IsUtf8("\xC0\xAF"), "overlong");
+	ok &= check(!websocket::IsUtf8("\xED\xA0\x80"), "surrogate");
+	ok &= check(!websocket::IsUtf8("\xF4\x90\x80\x80"), "above U+10FFFF");
+	ok &= check(!websocket::IsUtf8("abcdefgh\xE2\x82"), "cut short");
+	ok &= check(!websocket::IsUtf8("\x80"), "lone continuation");
+	return ok;
+}
+
+///////////////////////////////////////////////////////////////
+
+static void send_frame(int fd, websocket::opcode_type op, StringView payload, bool fin = true, bool rsv1 = false) {
+	asio::DynamicBuffer buffer;
+	websocket::SerializeFrame(buffer, op, payload, fin, rsv1, kKey);
+	send_all(fd, StringView(buffer.readBegin(), buffer.dataBytes()));
+}
+
+// the head of the answer to an upgrade, what follows it stays in `in`
+static std::string upgrade(int fd, asio::DynamicBuffer& in, const char* extensions = nullptr) {
+	std::string request = "GET /ws HTTP/1.1\r\nHost: x\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+						  "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n";
+	if ( extensions ) {
+		request += std::string("Sec-WebSocket-Extensions: ") + extensions + "\r\n";
+	}
+	send_all(fd, request + "\r\n");
+
+	std::string head;
+	while ( true ) {
+		std::string data(in.readBegin(), in.dataBytes());
+		size_t end = data.find("\r\n\r\n");
+		if ( end != std::string::npos ) {
+			in.read(end + 4);
+			return data.substr(0, end + 4);
+		}
+
+		in.reserve(4096);
+		ssize_t n = ::recv(fd, in.writeBegin(), in.availableBytes(), 0);
+		if ( n <= 0 ) {
+			return std::string();
+		}
+		in.write(n);
+	}
+}
+
+// the next frame from the server, false on close or timeout
+static bool recv_frame(int fd, asio::DynamicBuffer& in, websocket::opcode_type& op, std::string& payload,
+					   bool* rsv1 = nullptr) {
+	websocket::FrameParser parser;
+	parser.setRequireMask(false);
+	parser.setMaxPayloadBytes(0);
+
+	websocket::Frame frame;
+	while ( parser.parse(in, frame) != websocket::FrameParser::READY ) {
+		in.reserve(65536);
+		ssize_t n = ::recv(fd, in.writeBegin(), in.availableBytes(), 0);
+		if ( n <= 0 ) {
+			return false;
+		}
+		in.write(n);
+	}
+
+	op = frame.opcode;
+	payload = frame.payload.toString();
+	if ( rsv1 ) {
+		*rsv1 = frame.rsv1;
+	}
+	return true;
+}
+
+static uint16_t close_code(const std::string& payload) {
+	return payload.size() >= 2 ? (uint16_t)(((uint8_t)payload[0] << 8) | (uint8_t)payload[1]) : 0;
+}
+
+static bool wait_closed(int fd, asio::DynamicBuffer& in) {
+	if ( in.dataBytes() > 0 ) {
+		return false;
+	}
+	char buf[256];
+	ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+	return n == 0 || (n < 0 && errno == ECONNRESET);
+}
+
+struct Stats {
+	std::atomic<int> closes;
+	std::atomic<int> last_code;
+
+	Stats() : closes(0), last_code(0) {}
+};
+
+static bool echo_handler(const http::RequestView& request, const http::Server::stream_ptr& stream, Stats& stats) {
+	websocket::Connection::Options options;
+	options.deflate = true;
+	options.max_message_bytes = 256 * 1024;
+
+	websocket::Connection::pointer ws = websocket::Connection::Accept(request, stream, options);
+	if ( !ws ) {
+		return false;
+	}
+
+	ws->onMessage([ws](websocket::opcode_type op, StringView message){
+		if ( message == "bye" ) {
+			ws->close(websocket::CLOSE_GOING_AWAY, "bye");
+		} else if ( message == "long bye" ) {
+			// 124 bytes of reason, the last code point straddles the 123 that fit
+			ws->close(websocket::CLOSE_GOING_AWAY, std::string(122, 'x') + "\xC3\xA9");
+		} else if ( message == "ping me" ) {
+			ws->ping("server ping");
+		} else if ( message == "in pieces" ) {
+			ws->send(websocket::opcode::TEXT, "in ", false);
+			ws->send(websocket::opcode::TEXT, "pie", false);
+			ws->send(websocket::opcode::TEXT, "ces", true);
+		} else {
+			ws->send(op, message);
+		}
+	});
+	ws->onPong([ws](StringView payload){
+		ws->sendText("pong: " + payload.toString());
+	});
+	ws->onClose([&stats](uint16_t code, StringView){
+		stats.last_code = code;
+		++stats.closes;
+	});
+	return true;
+}
+
+bool test_echo(uint16_t port, Stats& stats) {
+	bool ok = true;
+	int fd = connect_to(port);
+	asio::DynamicBuffer in;
+
+	std::string head = upgrade(fd, in);
+	ok &= check(head.find("HTTP/1.1 101 Switching Protocols\r\n") == 0, "switching protocols");
+	ok &= check(head.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") != std::string::npos, "accept");
+	ok &= check(head.find("Sec-WebSocket-Extensions") == std::string::npos, "no deflate unless offered");
+	ok &= check(head.find("Transfer-Encoding") == std::string::npos, "no chunking");
+
+	websocket::opcode_type op;
+	std::string payload;
+	send_frame(fd, websocket::opcode::TEXT, "hello");
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::TEXT && payload == "hello", "echo");
+
+	// fragments with a ping in between : the pong comes first
+	send_frame(fd, websocket::opcode::TEXT, "frag", false);
+	send_frame(fd, websocket::opcode::PING, "are you there");
+	send_frame(fd, websocket::opcode::CONTINUATION, "ment", false);
+	send_frame(fd, websocket::opcode::CONTINUATION, "ed", true);
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::PONG && payload == "are you there", "pong");
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::TEXT && payload == "fragmented", "joined");
+
+	// a large binary message, sent in odd pieces
+	std::string blob(100000, 0);
+	for ( size_t i = 0; i < blob.size(); ++i ) {
+		blob[i] = (char)(i * 31);
+	}
+	asio::DynamicBuffer wire;
+	websocket::SerializeFrame(wire, websocket::opcode::BINARY, blob, true, false, kKey);
+	for ( size_t at = 0; at < wire.dataBytes(); at += 7777 ) {
+		size_t n = std::min((size_t)7777, wire.dataBytes() - at);
+		send_all(fd, StringView(wire.readBegin() + at, n));
+	}
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::BINARY && payload == blob, "large echo");
+
+	// server side fragments and pings
+	send_frame(fd, websocket::opcode::TEXT, "in pieces");
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::TEXT && payload == "in ", "sent fragment");
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::CONTINUATION && payload == "pie", "continued");
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::CONTINUATION && payload == "ces", "last");
+
+	send_frame(fd, websocket::opcode::TEXT, "ping me");
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::PING && payload == "server ping", "server ping");
+	send_frame(fd, websocket::opcode::PONG, payload);
+	ok &= check(recv_frame(fd, in, op, payload) && payload == "pong: server ping", "pong handled");
+
+	// closing handshake started by the client
+	int closes = stats.closes;
+	std::string bye("\x03\xE8" "done", 6);
+	send_frame(fd, websocket::opcode::CLOSE, bye);
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::CLOSE &&
+				close_code(payload) == websocket::CLOSE_NORMAL, "close echoed");
+	ok &= check(wait_closed(fd, in), "closed after the close frame");
+	::usleep(20 * 1000);
+	ok &= check(stats.closes == closes + 1 && stats.last_code == websocket::CLOSE_NORMAL, "close reported");
+	::close(fd);
+	return ok;
+}
+
+bool test_long_close_reason(uint16_t port) {
+	bool ok = true;
+	int fd = connect_to(port);
+	asio::DynamicBuffer in;
+	upgrade(fd, in);
+
+	websocket::opcode_type op;
+	std::string payload;
+	send_frame(fd, websocket::opcode::TEXT, "long bye");
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::CLOSE &&
+				close_code(payload) == websocket::CLOSE_GOING_AWAY, "long close");
+	ok &= check(payload.size() > 2 && payload.substr(2) == std::string(122, 'x') &&
+				websocket::IsUtf8(StringView(payload).substr(2)), "reason cut on a code point");
+
+	send_frame(fd, websocket::opcode::CLOSE, std::string("\x03\xE9", 2));
+	ok &= check(wait_closed(fd, in), "long close answered");
+	::close(fd);
+	return ok;
+}
+
+bool test_server_close(uint16_t port, Stats& stats) {
+	bool ok = true;
+	int fd = connect_to(port);
+	asio::DynamicBuffer in;
+	upgrade(fd, in);
+
+	int closes = stats.closes;
+	websocket::opcode_type op;
+	std::string payload;
+	send_frame(fd, websocket::opcode::TEXT, "bye");
+	ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::CLOSE &&
+				close_code(payload) == websocket::CLOSE_GOING_AWAY && payload.substr(2) == "bye", "server close");
+
+	// data after the close frame is dropped, the answer ends it
+	send_frame(fd, websocket::opcode::TEXT, "late");
+	send_frame(fd, websocket::opcode::CLOSE, std::string("\x03\xE9", 2));
+	ok &= check(wait_closed(fd, in), "closed once answered");
+	::usleep(20 * 1000);
+	ok &= check(stats.closes == closes + 1 && stats.last_code == websocket::CLOSE_GOING_AWAY, "reported");
+	::close(fd);
+	return ok;
+}
+
+bool test_violations(uint16_t port, Stats& stats) {
+	bool ok = true;
+	websocket::opcode_type op;
+	std::string payload;
+
+	struct { const char* what; uint16_t code; } cases[] = {
+		{ "unmasked frame", websocket::CLOSE_PROTOCOL_ERROR },
+		{ "invalid UTF-8", websocket::CLOSE_INVALID_PAYLOAD },
+		{ "continuation first", websocket::CLOSE_PROTOCOL_ERROR },
+		{ "too big", websocket::CLOSE_TOO_BIG },
+		{ "compressed without deflate", websocket::CLOSE_PROTOCOL_ERROR },
+		{ "bad close code", websocket::CLOSE_PROTOCOL_ERROR },
+	};
+
+	for ( size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); ++i ) {
+		int fd = connect_to(port);
+		asio::DynamicBuffer in;
+		upgrade(fd, in);
+
+		int closes = stats.closes;
+		switch ( i ) {
+			case 0 : send_all(fd, StringView("\x81\x02hi", 4)); break;
+			case 1 : send_frame(fd, websocket::opcode::TEXT, "\xC0\xAF"); break;
+			case 2 : send_frame(fd, websocket::opcode::CONTINUATION, "x"); break;
+			case 3 : send_all(fd, StringView("\x82\xFF\0\0\0\0\0\x04\xB0\0" "mask", 14)); break;		// 300 KiB announced
+			case 4 : send_frame(fd, websocket::opcode::TEXT, "x", true, true); break;
+			case 5 : send_frame(fd, websocket::opcode::CLOSE, std::string("\x03\xED", 2)); break;
+		}
+		ok &= check(recv_frame(fd, in, op, payload) && op == websocket::opcode::CLOSE &&
+					close_code(payload) == cases[i].code, cases[i].what);
+		ok &= check(wait_closed(fd, in), "closed after a violation");
+		::usleep(20 * 1000);
+		ok &= check(stats.closes == closes + 1 && stats.last_code == cases[i].code, "violation reported");
+		::close(fd);
+	}
+
+	// the peer going away without a close frame
+	int fd = connect_to(port);
+	asio::DynamicBuffer in;
+	upgrade(fd, in);
+	int closes = stats.closes;
+	::close(fd);
+	::usleep(50 * 1000);
+	ok &= check(stats.closes == closes + 1 && stats.last_code == websocket::CLOSE_ABNORMAL, "abnormal close");
+	return ok;
+}
+
+bool test_deflate(uint16_t port) {
+	bool ok = true;
+	int fd = connect_to(port);
+	asio::DynamicBuffer in;
+
+	std::string head = upgrade(fd, in, "permessage-deflate; client_max_window_bits");
+	ok &= check(head.find("Sec-WebSocket-Extensions: permessage-deflate\r\n") != std::string::npos, "deflate agreed");
+
+	websocket::DeflateParams params;
+	websocket::Deflate codec(params, 6);
+
+	std::string text;
+	for ( int i = 0; i < 100; ++i ) {
+		text += "{\"price\": 101.25, \"symbol\": \"LCY\"} ";
+	}
+
+	websocket::opcode_type op;
+	std::string payload;
+	bool rsv1 = false;
+	for ( int round = 0; round < 3; ++round ) {
+		std::string compressed;
+		codec.compress(text, true, compressed);
+		send_frame(fd, websocket::opcode::TEXT, compressed, true, true);
+
+		ok &= check(recv_frame(fd, in, op, payload, &rsv1) && op == websocket::opcode::TEXT && rsv1, "compressed echo");
+		ok &= check(payload.size() < text.size() / 4, "smaller on the wire");
+		std::string inflated;
+		ok &= check(codec.decompress(payload, inflated) && inflated == text, "same text");
+	}
+
+	// short messages go as they are, uncompressed ones are taken too
+	send_frame(fd, websocket::opcode::TEXT, "tiny");
+	ok &= check(recv_frame(fd, in, op, payload, &rsv1) && !rsv1 && payload == "tiny", "small not compressed");
+	::close(fd);
+	return ok;
+}
+
+bool test_plain_request(uint16_t port) {
+	int fd = connect_to(port);
+	send_all(fd, "GET /plain HTTP/1.1\r\nHost: x\r\nConnection: close\r\n\r\n");
+	std::string raw;
+	char buf[4096];
+	ssize_t n;
+	while ( (n = ::recv(fd, buf, sizeof(buf), 0)) > 0 ) {
+		raw.append(buf, n);
+	}
+	::close(fd);
+	return check(raw.find("HTTP/1.1 200 OK") == 0 && raw.find("plain") != std::string::npos, "plain request");
+}
+
+int main() {
+	bool ok = true;
+	ok &= test_accept_key();
+	ok &= test_negotiate_deflate();
+	ok &= test_mask();
+	ok &= test_frames();
+	ok &= test_utf8();
+
+	asio::IOContext ioc;
+	Stats stats;
+	http::Server server(ioc, 1);
+	server.setHandler([](const http::RequestView&, http::Response& response){
+		response.setBody("plain");
+	});
+	server.setStreamHandler([&stats](const http::RequestView& request, const http::Server::stream_ptr& stream){
+		return echo_handler(request, stream, stats);
+	});
+	server.start(asio::ip::Endpoint("127.0.0.1", 0));
+
+	asio::ip::Endpoint endpoint;
+	server.localAddr(endpoint);
+	uint16_t port = endpoint.port();
+
+	std::thread client([&](){
+		ok &= test_echo(port, stats);
+		ok &= test_server_close(port, stats);
+		ok &= test_long_close_reason(port);
+		ok &= test_violations(port, stats);
+		ok &= test_deflate(port);
+		ok &= test_plain_request(port);
+
+		asio::post(ioc, [&ioc](){ ioc.quit(); });
+	});
+
+	ioc.loop_wait();
+	client.join();
+	server.stop();
+
+	std::cout << (ok ? "all passed" : "failed") << std::endl;
+	return ok ? 0 : 1;
+}
@@ -37,8 +37,11 @@ Channel::Channel(lcy::asio::IOContext& ioc,
 	is_connected_(false),
 	id_allocator_(0),
 	conn_(new details::Connection(ioc)),
-	id_method_umap_()
+	id_method_umap_(),
+	lifetime_(new Lifetime())
 {
+	lifetime_->channel_ = this;
+
 	conn_->setConnectOp(std::bind(&Channel::onConnectOp,
 			this, std::placeholders::_1));
 	conn_->setMessageOp(std::bind(&Channel::onMessageOp,
@@ -49,6 +52,10 @@ Channel::Channel(lcy::asio::IOContext& ioc,
 
 Channel::~Channel()
 {
+	{
+		std::lock_guard<std::mutex> locker(lifetime_->mutex_);
+		lifetime_->channel_ = nullptr;
+	}
 	shutdown();
 }
 
@@ -62,9 +69,8 @@ void Channel::CallMethod(const ::google::protobuf::MethodDescriptor* method,
  	* FIXME : Ignore the controller here
  	*/ 
 
-	uint64_t id = id_allocator_++;
+	uint64_t id = id_allocator_.fetch_add(1, std::memory_order_relaxed);
 	MethodInfo method_info(controller, request, response, done);
-	id_method_umap_[id] = method_info;
 	
 	const google::protobuf::ServiceDescriptor *sd = method->service();
     std::string service_name = sd->name();
@@ -83,7 +89,35 @@ void Channel::CallMethod(const ::google::protobuf::MethodDescriptor* method,
 	uint32_t len = rpc_request_str.length();
 	len = htonl(len);
 
-	conn_->send(std::string((char*)&len, sizeof(uint32_t)) + rpc_request_str);
+	std::string data = std::string((char*)&len, sizeof(uint32_t)) + rpc_request_str;
+
+	/*
+	* notify :
+	*	The request is serialized on the calling thread, only the bookkeeping and
+	*	the send go through the connection's strand, inline on the IO thread.
+	*/
+	if ( conn_->strand().running_in_this_thread() ) {
+		sendRequest(id, method_info, data);
+		return;
+	}
+
+	conn_->strand().post(std::bind(&Channel::postedRequest,
+			lifetime_, id, method_info, std::move(data)));
+}
+
+void Channel::postedRequest(const std::shared_ptr<Lifetime>& lifetime, uint64_t id,
+							const MethodInfo& method_info, std::string& data)
+{
+	std::lock_guard<std::mutex> locker(lifetime->mutex_);
+	if ( lifetime->channel_ ) {
+		lifetime->channel_->sendRequest(id, method_info, data);
+	}
+}
+
+void Channel::sendRequest(uint64_t id, const MethodInfo& method_info, std::string& data)
+{
+	id_method_umap_[id] = method_info;
+	conn_->send(std::move(data));
 }
 
 void Channel::shutdown()
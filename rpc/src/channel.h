@@ -2,6 +2,9 @@
 #define __LCY_RPC_CHANNEL_H__
 
 #include <string>
+#include <mutex>
+#include <memory>
+#include <atomic>
 #include <functional>
 #include <unordered_map>
 #include <google/protobuf/service.h>
@@ -37,6 +40,7 @@ public:
 			uint16_t port);
 	~Channel();
 
+	// May be called from any thread, see Connection::strand()
   	void CallMethod(const ::google::protobuf::MethodDescriptor* method,
                     ::google::protobuf::RpcController* controller,
 					const ::google::protobuf::Message* request,
@@ -50,6 +54,20 @@ public:
 private:
 	void onConnectOp(lcy::asio::errcode_type ec);
 	void onMessageOp(details::Connection& conn, const std::string& msg);
+	void sendRequest(uint64_t id, const MethodInfo& method_info, std::string& data);
+
+	/*
+	* notify :
+	*	Requests posted to the strand may run after the channel is gone, they reach
+	*	it through this, cleared by ~Channel() under the mutex.
+	*/
+	struct Lifetime {
+		std::mutex mutex_;
+		Channel* channel_;
+	};
+
+	static void postedRequest(const std::shared_ptr<Lifetime>& lifetime, uint64_t id,
+							  const MethodInfo& method_info, std::string& data);
 
 private:
 	typedef std::unordered_map<
@@ -58,9 +76,10 @@ private:
 			> id_method_umap_type;
 
 	bool is_connected_;
-	uint64_t id_allocator_;
+	std::atomic<uint64_t> id_allocator_;
 	std::shared_ptr<details::Connection> conn_;
 	id_method_umap_type id_method_umap_;
+	std::shared_ptr<Lifetime> lifetime_;
 };
 
 }	// namespace rpc
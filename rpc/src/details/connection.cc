@@ -8,7 +8,8 @@ namespace rpc {
 namespace details {
 
 Connection::Connection(lcy::asio::IOContext& ioc) :
-	socket_(ioc)
+	socket_(ioc),
+	strand_(ioc)
 {
 }
 
@@ -33,6 +34,18 @@ void Connection::start_recv()
 }
 
 void Connection::send(std::string data)
+{
+	if ( strand_.running_in_this_thread() ) {
+		do_send(data);
+		return;
+	}
+
+	// The bound shared_ptr keeps the connection alive until the strand runs it
+	strand_.post(std::bind(&Connection::do_send,
+			shared_from_this(), std::move(data)));
+}
+
+void Connection::do_send(std::string& data)
 {
 	bool need_start_deque_send = send_buf_deque_.empty();
 	send_buf_deque_.push_back(std::move(data));
@@ -72,6 +85,11 @@ lcy::asio::IOContext& Connection::context()
 	return socket_.context();
 }
 
+lcy::asio::Strand& Connection::strand()
+{
+	return strand_;
+}
+
 lcy::asio::ip::TCP::Socket& Connection::get_socket()
 {
 	return socket_;
@@ -23,6 +23,8 @@ public:
 
 	void shutdown();
 	void start_recv();
+
+	// Safe from any thread, the data is queued through the connection's strand
 	void send(std::string data);
 	void connect(const std::string& ip, uint16_t port);
 
@@ -30,18 +32,21 @@ public:
 	void setMessageOp(message_op_type message_op);
 
 	lcy::asio::IOContext& context();
+	lcy::asio::Strand& strand();
 	lcy::asio::ip::TCP::Socket& get_socket();
 
 private:
 	typedef std::shared_ptr<Connection> ConnPtr;
 
 	void onRecvMessage(ConnPtr conn, lcy::asio::errcode_type ec, size_t nbytes);
+	void do_send(std::string& data);
 	void start_deque_send();
 	void onSendCompleted(ConnPtr conn, lcy::asio::errcode_type ec, size_t nbytes);
 	void onConnect(ConnPtr conn, lcy::asio::errcode_type ec);
 	
 private:
 	lcy::asio::ip::TCP::Socket socket_;
+	lcy::asio::Strand strand_;
 	lcy::asio::DynamicBuffer read_buf_;
 	std::deque<std::string> send_buf_deque_;
 